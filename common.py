@@ -70,11 +70,14 @@ def get_sources(env, is_editor_build, include_tests):
         "util/memory/*.cpp",
         "util/noise/fast_noise_lite/*.cpp",
         "util/noise/gd_noise_range.cpp",
+        "util/noise/noise_range_table.cpp",
+        "util/noise/spot_noise.cpp",
         "util/noise/spot_noise_gd.cpp",
         "util/string/*.cpp",
         "util/thread/thread.cpp",
         "util/thread/spatial_lock_2d.cpp",
         "util/thread/spatial_lock_3d.cpp",
+        "util/thread/epoch_reclaimer.cpp",
         "util/tasks/*.cpp",
         "util/tasks/godot/*.cpp",
 
@@ -102,6 +105,7 @@ def get_sources(env, is_editor_build, include_tests):
         "util/godot/direct_multimesh_instance.cpp",
         "util/godot/direct_static_body.cpp",
         "util/godot/file_utils.cpp",
+        "util/godot/image_sampler.cpp",
         "util/godot/shader_material_pool.cpp",
 
         "util/io/*.cpp",
@@ -82,7 +82,10 @@ VoxelStringNames::VoxelStringNames() {
 #endif
 
 	_rpc_receive_blocks = StringName("_rpc_receive_blocks");
-	_rpc_receive_area = StringName("_rpc_receive_area");
+	_rpc_request_blocks = StringName("_rpc_request_blocks");
+	_rpc_report_cached_blocks = StringName("_rpc_report_cached_blocks");
+	peer_disconnected = StringName("peer_disconnected");
+	script_changed = StringName("script_changed");
 
 	unnamed = StringName("unnamed");
 	air = StringName("air");
@@ -116,6 +119,8 @@ VoxelStringNames::VoxelStringNames() {
 
 	_on_async_search_completed = StringName("_on_async_search_completed");
 	async_search_completed = StringName("async_search_completed");
+	_on_async_paths_completed = StringName("_on_async_paths_completed");
+	async_paths_completed = StringName("async_paths_completed");
 
 	file_selected = StringName("file_selected");
 }
@@ -78,7 +78,10 @@ public:
 #endif
 
 	StringName _rpc_receive_blocks;
-	StringName _rpc_receive_area;
+	StringName _rpc_request_blocks;
+	StringName _rpc_report_cached_blocks;
+	StringName peer_disconnected;
+	StringName script_changed;
 
 	StringName unnamed;
 	StringName air;
@@ -104,6 +107,8 @@ public:
 
 	StringName _on_async_search_completed;
 	StringName async_search_completed;
+	StringName _on_async_paths_completed;
+	StringName async_paths_completed;
 
 	StringName file_selected;
 };
@@ -0,0 +1,108 @@
+#ifndef VOXEL_FLOATING_CHUNKS_H
+#define VOXEL_FLOATING_CHUNKS_H
+
+#include "../meshers/voxel_mesher.h"
+#include "../storage/voxel_buffer.h"
+#include "../util/containers/std_vector.h"
+#include "../util/godot/core/array.h"
+#include "../util/godot/object_weak_ref.h"
+#include "../util/island_finder.h"
+#include "../util/math/box3i.h"
+#include "../util/tasks/threaded_task.h"
+#include <memory>
+
+ZN_GODOT_FORWARD_DECLARE(class Node);
+
+namespace zylann {
+class AsyncDependencyTracker;
+}
+
+namespace zylann::voxel {
+
+class VoxelTool;
+class VoxelData;
+
+// Propagates non-zero cells towards zero cells in a 3x3x3 pattern.
+// Used on a grid produced by Connected-Component-Labelling.
+void box_propagate_ccl(Span<uint8_t> cells, const Vector3i size);
+
+// Turns floating chunks of voxels into rigidbodies, synchronously.
+// Returns created nodes.
+Array separate_floating_chunks(
+		VoxelTool &voxel_tool,
+		Box3i world_box,
+		Node *parent_node,
+		Transform3D transform,
+		Ref<VoxelMesher> mesher,
+		Array materials
+);
+
+// State shared between the tasks of an asynchronous floating chunks separation.
+struct FloatingChunksAsyncContext {
+	struct Island {
+		VoxelBuffer voxels;
+		Vector3i world_pos;
+		// Size of the island without padding
+		Vector3i inner_size;
+		VoxelMesher::Output surfaces;
+		// Only set if the mesh resource was built in a thread
+		Ref<Mesh> mesh;
+		StdVector<uint16_t> mesh_material_indices;
+
+		Island() : voxels(VoxelBuffer::ALLOCATOR_POOL) {}
+	};
+
+	// Inputs, set before scheduling
+
+	std::shared_ptr<VoxelData> data;
+	Box3i world_box;
+	Ref<VoxelMesher> mesher;
+	// If true, voxels of islands are erased from the terrain before the edit is reported as complete.
+	bool erase_islands = true;
+	// Completed once voxels are erased. Only used if `erase_islands` is true.
+	std::shared_ptr<AsyncDependencyTracker> edit_tracker;
+
+	// Only accessed on the main thread
+	zylann::godot::ObjectWeakRef<Node> parent_node;
+	Transform3D transform;
+	Array materials;
+	uint32_t materials_to_instance_mask = 0;
+	Callable callback;
+
+	// Working data
+
+	VoxelBuffer source_voxels;
+	StdVector<uint8_t> ccl_output;
+	StdVector<IslandSlabMerger::Slab> slabs;
+	StdVector<Island> islands;
+	// Set by the extraction task before it schedules meshing tasks, then only accessed on the main thread
+	unsigned int pending_mesh_count = 0;
+
+	FloatingChunksAsyncContext() : source_voxels(VoxelBuffer::ALLOCATOR_POOL) {}
+};
+
+// Asynchronous version of `separate_floating_chunks`.
+// Copy, labelling and meshing of islands run on worker threads. Labelling is split in slabs running in parallel, and
+// each island gets meshed in its own task. Nodes are created on the main thread once all islands are meshed, and
+// are then passed to the callback of the context.
+class SeparateFloatingChunksTask : public IThreadedTask {
+public:
+	SeparateFloatingChunksTask(std::shared_ptr<FloatingChunksAsyncContext> context);
+
+	const char *get_debug_name() const override {
+		return "SeparateFloatingChunks";
+	}
+
+	void run(ThreadedTaskContext &ctx) override;
+
+private:
+	std::shared_ptr<FloatingChunksAsyncContext> _context;
+};
+
+// Gets which materials have parameters requiring to be duplicated per chunk instance, as a bitmask.
+// Returns false if there are too many materials.
+bool get_materials_to_instance_mask(const Array &materials, uint32_t &out_mask);
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_FLOATING_CHUNKS_H
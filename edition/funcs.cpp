@@ -4,6 +4,7 @@
 #include "../util/containers/dynamic_bitset.h"
 #include "../util/containers/span.h"
 #include "../util/containers/std_vector.h"
+#include "../util/godot/core/packed_arrays.h"
 #include "../util/godot/core/random_pcg.h"
 #include "../util/profiling.h"
 #include "../util/string/format.h"
@@ -126,20 +127,43 @@ AABB get_path_aabb(Span<const Vector3> positions, Span<const float> radii) {
 	return aabb;
 }
 
-void run_blocky_random_tick(
+namespace {
+
+template <typename T>
+void pick_random_tickable_voxels(
+		Span<const T> channel,
+		const Vector3i block_size,
+		Span<const Vector3i> rpositions,
+		const Vector3i block_origin,
+		const VoxelBlockyLibraryBase::BakedData &lib_data,
+		StdVector<Vector3i> &out_positions,
+		StdVector<uint16_t> &out_values
+) {
+	for (const Vector3i rpos : rpositions) {
+		const T v = channel[VoxelBuffer::get_index(rpos, block_size)];
+		if (lib_data.is_random_tickable(v)) {
+			out_positions.push_back(rpos + block_origin);
+			out_values.push_back(v);
+		}
+	}
+}
+
+} // namespace
+
+void pick_blocky_random_tick_voxels(
 		VoxelData &data,
 		Box3i voxel_box,
 		const VoxelBlockyLibraryBase &lib,
 		RandomPCG &random,
 		int voxel_count,
 		int batch_count,
-		void *callback_data,
-		bool (*callback)(void *, Vector3i, int64_t)
+		StdVector<Vector3i> &out_positions,
+		StdVector<uint16_t> &out_values
 ) {
+	ZN_PROFILE_SCOPE();
 	ERR_FAIL_COND(batch_count <= 0);
 	ERR_FAIL_COND(voxel_count < 0);
 	ERR_FAIL_COND(!math::is_valid_size(voxel_box.size));
-	ERR_FAIL_COND(callback == nullptr);
 
 	constexpr unsigned int lod_index = 0;
 
@@ -147,15 +171,11 @@ void run_blocky_random_tick(
 	const Box3i block_box = voxel_box.downscaled(block_size);
 
 	const int block_count = voxel_count / batch_count;
-	// const int bs_mask = map.get_block_size_mask();
 	const VoxelBuffer::ChannelId channel = VoxelBuffer::CHANNEL_TYPE;
 
-	struct Pick {
-		uint64_t value;
-		Vector3i rpos;
-	};
-	static thread_local StdVector<Pick> picks;
-	picks.reserve(batch_count);
+	static thread_local StdVector<Vector3i> tls_rpositions;
+	StdVector<Vector3i> &rpositions = tls_rpositions;
+	rpositions.reserve(batch_count);
 
 	const float block_volume = math::cubed(block_size);
 	CRASH_COND(block_volume < 0.1f);
@@ -173,67 +193,116 @@ void run_blocky_random_tick(
 	};
 
 	const VoxelBlockyLibraryBase::BakedData &lib_data = lib.get_baked_data();
+	if (lib_data.random_tickable_models.size() == 0) {
+		// Nothing can tick
+		return;
+	}
+
+	SpatialLock3D &spatial_lock = data.get_spatial_lock(lod_index);
 
 	// Choose blocks at random
 	for (int bi = 0; bi < block_count; ++bi) {
 		const Vector3i block_pos = block_box.position + L::urand_vec3i(random, block_box.size);
-
 		const Vector3i block_origin = data.block_to_voxel(block_pos);
 
-		picks.clear();
-
-		{
-			SpatialLock3D &spatial_lock = data.get_spatial_lock(lod_index);
-			SpatialLock3D::Read srlock(spatial_lock, BoxBounds3i::from_position(block_pos));
-
-			std::shared_ptr<VoxelBuffer> voxels_ptr = data.try_get_block_voxels(block_pos);
-
-			if (voxels_ptr != nullptr) {
-				// Doing ONLY reads here.
-				const VoxelBuffer &voxels = *voxels_ptr;
-
-				if (voxels.get_channel_compression(channel) == VoxelBuffer::COMPRESSION_UNIFORM) {
-					const uint64_t v = voxels.get_voxel(0, 0, 0, channel);
-					if (lib_data.has_model(v)) {
-						const VoxelBlockyModel::BakedData &vt = lib_data.models[v];
-						if (vt.is_random_tickable) {
-							// Skip whole block
-							continue;
-						}
-					}
-				}
-
-				const Box3i block_voxel_box(block_origin, Vector3iUtil::create(block_size));
-				Box3i local_voxel_box = voxel_box.clipped(block_voxel_box);
-				local_voxel_box.position -= block_origin;
-				const float volume_ratio = Vector3iUtil::get_volume(local_voxel_box.size) / block_volume;
-				const int local_batch_count = Math::ceil(batch_count * volume_ratio);
+		// Choose a bunch of voxels at random within the block before reading it, so the lock is held briefly and
+		// voxels are read in one go.
+		const Box3i block_voxel_box(block_origin, Vector3iUtil::create(block_size));
+		Box3i local_voxel_box = voxel_box.clipped(block_voxel_box);
+		local_voxel_box.position -= block_origin;
+		const float volume_ratio = Vector3iUtil::get_volume(local_voxel_box.size) / block_volume;
+		const int local_batch_count = Math::ceil(batch_count * volume_ratio);
+
+		rpositions.clear();
+		for (int vi = 0; vi < local_batch_count; ++vi) {
+			rpositions.push_back(local_voxel_box.position + L::urand_vec3i(random, local_voxel_box.size));
+		}
 
-				// Choose a bunch of voxels at random within the block.
-				// Batching this way improves performance a little by reducing block lookups.
-				for (int vi = 0; vi < local_batch_count; ++vi) {
-					const Vector3i rpos = local_voxel_box.position + L::urand_vec3i(random, local_voxel_box.size);
+		SpatialLock3D::Read srlock(spatial_lock, BoxBounds3i::from_position(block_pos));
 
-					const uint64_t v = voxels.get_voxel(rpos, channel);
-					picks.push_back(Pick{ v, rpos });
-				}
+		std::shared_ptr<VoxelBuffer> voxels_ptr = data.try_get_block_voxels(block_pos);
+		if (voxels_ptr == nullptr) {
+			continue;
+		}
+		// Doing ONLY reads here.
+		const VoxelBuffer &voxels = *voxels_ptr;
+
+		if (voxels.get_channel_compression(channel) == VoxelBuffer::COMPRESSION_UNIFORM) {
+			const uint64_t v = voxels.get_voxel(0, 0, 0, channel);
+			if (!lib_data.is_random_tickable(v)) {
+				// Skip whole block
+				continue;
+			}
+			for (const Vector3i rpos : rpositions) {
+				out_positions.push_back(rpos + block_origin);
+				out_values.push_back(v);
 			}
+			continue;
 		}
 
-		// The following may or may not read AND write voxels randomly due to its exposition to scripts.
-		// However, we don't send the buffer directly, so it will go through an API taking care of locking.
-		// So we don't (and shouldn't) lock anything here.
-		for (size_t i = 0; i < picks.size(); ++i) {
-			const Pick pick = picks[i];
+		switch (voxels.get_channel_depth(channel)) {
+			case VoxelBuffer::DEPTH_8_BIT: {
+				Span<const uint8_t> values;
+				ZN_ASSERT_CONTINUE(voxels.get_channel_data_read_only(channel, values));
+				pick_random_tickable_voxels(
+						values,
+						voxels.get_size(),
+						to_span(rpositions),
+						block_origin,
+						lib_data,
+						out_positions,
+						out_values
+				);
+			} break;
+
+			case VoxelBuffer::DEPTH_16_BIT: {
+				Span<const uint16_t> values;
+				ZN_ASSERT_CONTINUE(voxels.get_channel_data_read_only(channel, values));
+				pick_random_tickable_voxels(
+						values,
+						voxels.get_size(),
+						to_span(rpositions),
+						block_origin,
+						lib_data,
+						out_positions,
+						out_values
+				);
+			} break;
+
+			default:
+				// Blocky models can't have more than 65536 IDs
+				ZN_PRINT_ERROR("Unhandled channel depth");
+				break;
+		}
+	}
+}
 
-			if (lib_data.has_model(pick.value)) {
-				const VoxelBlockyModel::BakedData &vt = lib_data.models[pick.value];
+void run_blocky_random_tick(
+		VoxelData &data,
+		Box3i voxel_box,
+		const VoxelBlockyLibraryBase &lib,
+		RandomPCG &random,
+		int voxel_count,
+		int batch_count,
+		void *callback_data,
+		bool (*callback)(void *, Vector3i, int64_t)
+) {
+	ERR_FAIL_COND(callback == nullptr);
 
-				if (vt.is_random_tickable) {
-					ERR_FAIL_COND(!callback(callback_data, pick.rpos + block_origin, pick.value));
-				}
-			}
-		}
+	static thread_local StdVector<Vector3i> tls_positions;
+	static thread_local StdVector<uint16_t> tls_values;
+	StdVector<Vector3i> &positions = tls_positions;
+	StdVector<uint16_t> &values = tls_values;
+	positions.clear();
+	values.clear();
+
+	pick_blocky_random_tick_voxels(data, voxel_box, lib, random, voxel_count, batch_count, positions, values);
+
+	// The following may or may not read AND write voxels randomly due to its exposition to scripts.
+	// However, we don't send the buffer directly, so it will go through an API taking care of locking.
+	// So we don't (and shouldn't) lock anything here.
+	for (unsigned int i = 0; i < positions.size(); ++i) {
+		ERR_FAIL_COND(!callback(callback_data, positions[i], values[i]));
 	}
 }
 
@@ -285,6 +354,50 @@ void run_blocky_random_tick(
 	);
 }
 
+void run_blocky_random_tick_batched(
+		VoxelData &data,
+		AABB voxel_box_f,
+		const VoxelBlockyLibraryBase &lib,
+		RandomPCG &random,
+		int voxel_count,
+		int batch_count,
+		const Callable &callback
+) {
+	ZN_PROFILE_SCOPE();
+
+	static thread_local StdVector<Vector3i> tls_positions;
+	static thread_local StdVector<uint16_t> tls_values;
+	StdVector<Vector3i> &positions = tls_positions;
+	StdVector<uint16_t> &values = tls_values;
+	positions.clear();
+	values.clear();
+
+	const Box3i voxel_box(math::floor_to_int(voxel_box_f.position), math::floor_to_int(voxel_box_f.size));
+
+	pick_blocky_random_tick_voxels(data, voxel_box, lib, random, voxel_count, batch_count, positions, values);
+
+	if (positions.size() == 0) {
+		return;
+	}
+
+	PackedVector3Array positions_array;
+	PackedInt32Array values_array;
+	{
+		ZN_PROFILE_SCOPE_NAMED("Convert");
+		positions_array.resize(positions.size());
+		values_array.resize(values.size());
+		Span<Vector3> positions_dst(positions_array.ptrw(), positions_array.size());
+		Span<int32_t> values_dst(values_array.ptrw(), values_array.size());
+		for (unsigned int i = 0; i < positions.size(); ++i) {
+			positions_dst[i] = to_vec3(positions[i]);
+			values_dst[i] = values[i];
+		}
+	}
+
+	// Same as the non-batched version, no locking here since the script can edit voxels
+	callback.call(positions_array, values_array);
+}
+
 bool indices_to_bitarray_u16(Span<const int32_t> indices, DynamicBitset &bitarray) {
 #ifdef DEBUG_ENABLED
 	const int32_t max_supported_value = 65535;
@@ -6,6 +6,7 @@
 #include "../storage/voxel_data_grid.h"
 #include "../util/containers/dynamic_bitset.h"
 #include "../util/containers/fixed_array.h"
+#include "../util/containers/std_vector.h"
 #include "../util/godot/macros.h"
 #include "../util/math/box3f.h"
 #include "../util/math/conv.h"
@@ -221,6 +222,19 @@ AABB get_path_aabb(Span<const Vector3> positions, Span<const float> radii);
 class VoxelData;
 class VoxelBlockyLibraryBase;
 
+// Picks random voxels in the given box and outputs those having a random-tickable model.
+// Voxels are picked in batches of `batch_count` per block, so each block is locked and looked up only once.
+void pick_blocky_random_tick_voxels(
+		VoxelData &data,
+		Box3i voxel_box,
+		const VoxelBlockyLibraryBase &lib,
+		RandomPCG &random,
+		int voxel_count,
+		int batch_count,
+		StdVector<Vector3i> &out_positions,
+		StdVector<uint16_t> &out_values
+);
+
 // For easier unit testing (the regular one needs a terrain setup etc, harder to test atm)
 // The `_static` suffix is because it otherwise conflicts with the non-static method when registering the class
 void run_blocky_random_tick(
@@ -244,6 +258,18 @@ void run_blocky_random_tick(
 		const Callable &callback
 );
 
+// Same as `run_blocky_random_tick`, but calls `callback` only once with all picked voxels, as a
+// `PackedVector3Array` of positions and a `PackedInt32Array` of values. Much cheaper with script callbacks.
+void run_blocky_random_tick_batched(
+		VoxelData &data,
+		AABB voxel_box_f,
+		const VoxelBlockyLibraryBase &lib,
+		RandomPCG &random,
+		int voxel_count,
+		int batch_count,
+		const Callable &callback
+);
+
 } // namespace zylann::voxel
 
 // Library of templates for executing per-voxel operations.
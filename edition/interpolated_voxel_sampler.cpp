@@ -0,0 +1,162 @@
+#include "interpolated_voxel_sampler.h"
+#include "../storage/voxel_data.h"
+#include "../util/math/conv.h"
+#include "../util/math/funcs.h"
+#include "../util/profiling.h"
+
+namespace zylann::voxel {
+
+namespace {
+// Batches spanning more blocks than this will pin blocks around each position instead of the whole area at once,
+// to avoid locking large regions of the terrain.
+const int MAX_BATCH_PINNED_BLOCKS = 64;
+} // namespace
+
+InterpolatedVoxelSampler::InterpolatedVoxelSampler(const VoxelData &data, unsigned int channel, float default_value) :
+		_data(data), _bounds(data.get_bounds()), _channel(channel), _default_value(default_value) {
+	ZN_ASSERT(channel < VoxelBuffer::MAX_CHANNELS);
+}
+
+InterpolatedVoxelSampler::~InterpolatedVoxelSampler() {
+	release();
+}
+
+void InterpolatedVoxelSampler::release() {
+	unlock();
+	_grid.clear();
+	_pinned_box = Box3i();
+}
+
+void InterpolatedVoxelSampler::unlock() {
+	if (_locked) {
+		_grid.unlock_read();
+		_locked = false;
+	}
+}
+
+void InterpolatedVoxelSampler::pin(Box3i voxel_box) {
+	unlock();
+	_data.get_blocks_grid(_grid, voxel_box, 0);
+	const unsigned int bs = _data.get_block_size();
+	_pinned_box = voxel_box.downscaled(bs).scaled(bs);
+}
+
+void InterpolatedVoxelSampler::get_corners(const Vector3i c, Corners &corners) {
+	const Box3i cell_box(c, Vector3i(2, 2, 2));
+
+	if (_bounds.contains(cell_box)) {
+		if (!_pinned_box.contains(cell_box)) {
+			pin(cell_box);
+		}
+		if (!_locked) {
+			_grid.lock_read();
+			_locked = true;
+		}
+		const VoxelBuffer::ChannelId channel = static_cast<VoxelBuffer::ChannelId>(_channel);
+		if (_grid.try_get_voxel_f(Vector3i(c.x, c.y, c.z), corners.s000, channel) &&
+			_grid.try_get_voxel_f(Vector3i(c.x + 1, c.y, c.z), corners.s100, channel) &&
+			_grid.try_get_voxel_f(Vector3i(c.x + 1, c.y, c.z + 1), corners.s101, channel) &&
+			_grid.try_get_voxel_f(Vector3i(c.x, c.y, c.z + 1), corners.s001, channel) &&
+			_grid.try_get_voxel_f(Vector3i(c.x, c.y + 1, c.z), corners.s010, channel) &&
+			_grid.try_get_voxel_f(Vector3i(c.x + 1, c.y + 1, c.z), corners.s110, channel) &&
+			_grid.try_get_voxel_f(Vector3i(c.x + 1, c.y + 1, c.z + 1), corners.s111, channel) &&
+			_grid.try_get_voxel_f(Vector3i(c.x, c.y + 1, c.z + 1), corners.s011, channel)) {
+			return;
+		}
+	}
+
+	// Voxels are not loaded, or the cell touches the edge of the volume. Use the generic path, which handles these
+	// cases. It locks on its own, so we have to unlock first.
+	unlock();
+
+	VoxelSingleValue defval;
+	defval.f = _default_value;
+	corners.s000 = _data.get_voxel(Vector3i(c.x, c.y, c.z), _channel, defval).f;
+	corners.s100 = _data.get_voxel(Vector3i(c.x + 1, c.y, c.z), _channel, defval).f;
+	corners.s101 = _data.get_voxel(Vector3i(c.x + 1, c.y, c.z + 1), _channel, defval).f;
+	corners.s001 = _data.get_voxel(Vector3i(c.x, c.y, c.z + 1), _channel, defval).f;
+	corners.s010 = _data.get_voxel(Vector3i(c.x, c.y + 1, c.z), _channel, defval).f;
+	corners.s110 = _data.get_voxel(Vector3i(c.x + 1, c.y + 1, c.z), _channel, defval).f;
+	corners.s111 = _data.get_voxel(Vector3i(c.x + 1, c.y + 1, c.z + 1), _channel, defval).f;
+	corners.s011 = _data.get_voxel(Vector3i(c.x, c.y + 1, c.z + 1), _channel, defval).f;
+}
+
+float InterpolatedVoxelSampler::sample(Vector3 position) {
+	Corners k;
+	get_corners(math::floor_to_int(position), k);
+	return math::interpolate_trilinear(
+			k.s000, k.s100, k.s101, k.s001, k.s010, k.s110, k.s111, k.s011, to_vec3f(math::fract(position))
+	);
+}
+
+float InterpolatedVoxelSampler::sample(Vector3 position, Vector3 &out_gradient) {
+	Corners k;
+	get_corners(math::floor_to_int(position), k);
+	const Vector3f p = to_vec3f(math::fract(position));
+
+	// Derivatives of the trilinear interpolation along each axis
+	const float dx00 = k.s100 - k.s000;
+	const float dx10 = k.s110 - k.s010;
+	const float dx01 = k.s101 - k.s001;
+	const float dx11 = k.s111 - k.s011;
+	const float dx0 = dx00 + p.y * (dx10 - dx00);
+	const float dx1 = dx01 + p.y * (dx11 - dx01);
+
+	const float dy00 = k.s010 - k.s000;
+	const float dy10 = k.s110 - k.s100;
+	const float dy01 = k.s011 - k.s001;
+	const float dy11 = k.s111 - k.s101;
+	const float dy0 = dy00 + p.x * (dy10 - dy00);
+	const float dy1 = dy01 + p.x * (dy11 - dy01);
+
+	const float dz00 = k.s001 - k.s000;
+	const float dz10 = k.s101 - k.s100;
+	const float dz01 = k.s011 - k.s010;
+	const float dz11 = k.s111 - k.s110;
+	const float dz0 = dz00 + p.x * (dz10 - dz00);
+	const float dz1 = dz01 + p.x * (dz11 - dz01);
+
+	out_gradient = Vector3(dx0 + p.z * (dx1 - dx0), dy0 + p.z * (dy1 - dy0), dz0 + p.y * (dz1 - dz0));
+
+	return math::interpolate_trilinear(k.s000, k.s100, k.s101, k.s001, k.s010, k.s110, k.s111, k.s011, p);
+}
+
+void InterpolatedVoxelSampler::sample_batch(
+		Span<const Vector3> positions,
+		Span<float> out_values,
+		Span<Vector3> out_gradients
+) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(out_values.size() == positions.size());
+	ZN_ASSERT_RETURN(out_gradients.size() == 0 || out_gradients.size() == positions.size());
+
+	if (positions.size() == 0) {
+		return;
+	}
+
+	// Pin the whole area up-front if it is small enough
+	Vector3i minp = math::floor_to_int(positions[0]);
+	Vector3i maxp = minp;
+	for (const Vector3 &position : positions) {
+		const Vector3i c = math::floor_to_int(position);
+		minp = math::min(minp, c);
+		maxp = math::max(maxp, c);
+	}
+	const Box3i area = Box3i::from_min_max(minp, maxp + Vector3i(2, 2, 2)).clipped(_bounds);
+	if (!area.is_empty() && !_pinned_box.contains(area) &&
+		Vector3iUtil::get_volume(area.downscaled(_data.get_block_size()).size) <= MAX_BATCH_PINNED_BLOCKS) {
+		pin(area);
+	}
+
+	if (out_gradients.size() == 0) {
+		for (unsigned int i = 0; i < positions.size(); ++i) {
+			out_values[i] = sample(positions[i]);
+		}
+	} else {
+		for (unsigned int i = 0; i < positions.size(); ++i) {
+			out_values[i] = sample(positions[i], out_gradients[i]);
+		}
+	}
+}
+
+} // namespace zylann::voxel
@@ -0,0 +1,65 @@
+#ifndef VOXEL_INTERPOLATED_VOXEL_SAMPLER_H
+#define VOXEL_INTERPOLATED_VOXEL_SAMPLER_H
+
+#include "../storage/voxel_data_grid.h"
+#include "../util/containers/span.h"
+#include "../util/math/box3i.h"
+#include "../util/math/vector3.h"
+
+namespace zylann::voxel {
+
+class VoxelData;
+
+// Samples a channel of VoxelData at LOD0 with trilinear interpolation, at arbitrary positions.
+// Instead of looking up and locking blocks once per voxel, it pins the blocks around queried positions and keeps them
+// read-locked, so consecutive queries close to each other only cost a few direct voxel reads. Gradients are obtained
+// from the same 8 corners, without extra fetches.
+// Areas without loaded voxels fall back on `VoxelData::get_voxel`, which can use the generator or lower LODs.
+//
+// Blocks stay pinned and read-locked until `release` is called or the sampler is destroyed, so it is meant to be
+// short-lived: don't edit voxels from the same thread while it is alive. It is not thread-safe, use one per thread.
+class InterpolatedVoxelSampler {
+public:
+	InterpolatedVoxelSampler(const VoxelData &data, unsigned int channel, float default_value);
+	~InterpolatedVoxelSampler();
+
+	float sample(Vector3 position);
+	float sample(Vector3 position, Vector3 &out_gradient);
+
+	// Samples many positions at once. `out_gradients` may be empty if not needed.
+	// If the positions are close enough, blocks are pinned and locked only once for the whole batch.
+	void sample_batch(Span<const Vector3> positions, Span<float> out_values, Span<Vector3> out_gradients);
+
+	// Unlocks and unreferences pinned blocks.
+	void release();
+
+private:
+	// Values at the corners of a cell, in the order expected by `math::interpolate_trilinear`
+	struct Corners {
+		float s000;
+		float s100;
+		float s101;
+		float s001;
+		float s010;
+		float s110;
+		float s111;
+		float s011;
+	};
+
+	void get_corners(Vector3i cell_pos, Corners &corners);
+	void pin(Box3i voxel_box);
+	void unlock();
+
+	const VoxelData &_data;
+	const Box3i _bounds;
+	const uint8_t _channel;
+	const float _default_value;
+	VoxelDataGrid _grid;
+	// Area covered by pinned blocks, in voxels
+	Box3i _pinned_box;
+	bool _locked = false;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_INTERPOLATED_VOXEL_SAMPLER_H
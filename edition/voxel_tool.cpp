@@ -279,6 +279,21 @@ void VoxelTool::paste(Vector3i p_pos, Ref<godot::VoxelBuffer> p_voxels, uint8_t
 	paste(p_pos, p_voxels->get_buffer(), channels_mask);
 }
 
+void VoxelTool::copy_schematic(Vector3i pos, ChunkedVoxelBuffer &dst, uint8_t channels_mask) const {
+	ERR_PRINT("Not implemented");
+	// Implemented in derived classes
+}
+
+void VoxelTool::paste_schematic(
+		Vector3i pos,
+		const ChunkedVoxelBuffer &src,
+		const OrthoGridTransform &transform,
+		uint8_t channels_mask
+) {
+	ERR_PRINT("Not implemented");
+	// Implemented in derived classes
+}
+
 void VoxelTool::paste_masked(
 		Vector3i p_pos,
 		Ref<godot::VoxelBuffer> p_voxels,
@@ -440,6 +455,22 @@ void VoxelTool::_b_paste(Vector3i pos, Ref<godot::VoxelBuffer> voxels, int chann
 	paste(pos, voxels, channels_mask);
 }
 
+void VoxelTool::_b_copy_schematic(Vector3i pos, Ref<godot::VoxelSchematic> schematic, int channels_mask) {
+	ERR_FAIL_COND(schematic.is_null());
+	if (Vector3iUtil::is_empty_size(schematic->get_size())) {
+		ZN_PRINT_WARNING("The passed schematic has an empty size, nothing will be copied.");
+		return;
+	}
+	copy_schematic(pos, schematic->get_buffer_for_write(), channels_mask);
+}
+
+void VoxelTool::_b_paste_schematic(Vector3i pos, Ref<godot::VoxelSchematic> schematic, int channels_mask, Basis basis) {
+	ERR_FAIL_COND(schematic.is_null());
+	OrthoGridTransform transform;
+	ERR_FAIL_COND(!godot::VoxelSchematic::try_get_grid_transform(schematic->get_size(), basis, transform));
+	paste_schematic(pos, schematic->get_buffer(), transform, channels_mask);
+}
+
 void VoxelTool::_b_paste_masked(
 		Vector3i pos,
 		Ref<godot::VoxelBuffer> voxels,
@@ -552,6 +583,14 @@ void VoxelTool::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("copy", "src_pos", "dst_buffer", "channels_mask"), &VoxelTool::_b_copy);
 	ClassDB::bind_method(D_METHOD("paste", "dst_pos", "src_buffer", "channels_mask"), &VoxelTool::_b_paste);
+	ClassDB::bind_method(
+			D_METHOD("copy_schematic", "src_pos", "dst_schematic", "channels_mask"), &VoxelTool::_b_copy_schematic
+	);
+	ClassDB::bind_method(
+			D_METHOD("paste_schematic", "dst_pos", "src_schematic", "channels_mask", "basis"),
+			&VoxelTool::_b_paste_schematic,
+			DEFVAL(Basis())
+	);
 	ClassDB::bind_method(
 			D_METHOD("paste_masked", "dst_pos", "src_buffer", "channels_mask", "mask_channel", "mask_value"),
 			&VoxelTool::_b_paste_masked
@@ -3,6 +3,7 @@
 
 #include "../storage/funcs.h"
 #include "../storage/voxel_buffer_gd.h"
+#include "../storage/voxel_schematic_gd.h"
 #include "../util/math/box3i.h"
 #include "../util/math/sdf.h"
 #include "funcs.h"
@@ -79,6 +80,16 @@ public:
 	virtual void paste(Vector3i pos, const VoxelBuffer &src, uint8_t channels_mask);
 	void paste(Vector3i pos, Ref<godot::VoxelBuffer> p_voxels, uint8_t channels_mask);
 
+	// Chunked versions of `copy` and `paste`, working one block at a time so large areas can be copied without
+	// allocating everything in a single buffer.
+	virtual void copy_schematic(Vector3i pos, ChunkedVoxelBuffer &dst, uint8_t channels_mask) const;
+	virtual void paste_schematic(
+			Vector3i pos,
+			const ChunkedVoxelBuffer &src,
+			const OrthoGridTransform &transform,
+			uint8_t channels_mask
+	);
+
 	virtual void paste_masked(
 			Vector3i pos,
 			Ref<godot::VoxelBuffer> p_voxels,
@@ -134,6 +145,8 @@ private:
 	void _b_do_path(PackedVector3Array positions, PackedFloat32Array radii);
 	void _b_copy(Vector3i pos, Ref<godot::VoxelBuffer> voxels, int channel_mask);
 	void _b_paste(Vector3i pos, Ref<godot::VoxelBuffer> voxels, int channels_mask);
+	void _b_copy_schematic(Vector3i pos, Ref<godot::VoxelSchematic> schematic, int channels_mask);
+	void _b_paste_schematic(Vector3i pos, Ref<godot::VoxelSchematic> schematic, int channels_mask, Basis basis);
 	void _b_paste_masked(
 			Vector3i pos,
 			Ref<godot::VoxelBuffer> voxels,
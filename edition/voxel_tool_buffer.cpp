@@ -162,6 +162,20 @@ void VoxelToolBuffer::paste(Vector3i p_pos, const VoxelBuffer &src, uint8_t chan
 	dst.copy_voxel_metadata_in_area(src, Box3i(Vector3i(), src.get_size()), p_pos);
 }
 
+void VoxelToolBuffer::paste_schematic(
+		Vector3i pos,
+		const ChunkedVoxelBuffer &src,
+		const OrthoGridTransform &transform,
+		uint8_t channels_mask
+) {
+	ERR_FAIL_COND(_buffer.is_null());
+	if (channels_mask == 0) {
+		channels_mask = (1 << get_channel());
+	}
+	const SmallVector<uint8_t, VoxelBuffer::MAX_CHANNELS> channels = VoxelBuffer::mask_to_channels_list(channels_mask);
+	src.paste_to(to_span(channels), transform, _buffer->get_buffer(), pos);
+}
+
 void VoxelToolBuffer::paste_masked(
 		Vector3i p_pos,
 		Ref<godot::VoxelBuffer> p_voxels,
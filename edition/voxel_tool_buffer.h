@@ -13,6 +13,12 @@ public:
 
 	bool is_area_editable(const Box3i &box) const override;
 	void paste(Vector3i p_pos, const VoxelBuffer &src, uint8_t channels_mask) override;
+	void paste_schematic(
+			Vector3i pos,
+			const ChunkedVoxelBuffer &src,
+			const OrthoGridTransform &transform,
+			uint8_t channels_mask
+	) override;
 	void paste_masked(
 			Vector3i p_pos,
 			Ref<godot::VoxelBuffer> p_voxels,
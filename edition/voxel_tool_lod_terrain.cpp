@@ -1,5 +1,5 @@
 #include "voxel_tool_lod_terrain.h"
-#include "../constants/voxel_string_names.h"
+#include "../engine/voxel_engine.h"
 #include "../generators/graph/voxel_generator_graph.h"
 #include "../meshers/blocky/voxel_mesher_blocky.h"
 #include "../storage/voxel_buffer_gd.h"
@@ -7,18 +7,14 @@
 #include "../terrain/variable_lod/voxel_lod_terrain.h"
 #include "../util/containers/std_vector.h"
 #include "../util/dstack.h"
-#include "../util/godot/classes/collision_shape_3d.h"
-#include "../util/godot/classes/convex_polygon_shape_3d.h"
 #include "../util/godot/classes/mesh.h"
-#include "../util/godot/classes/mesh_instance_3d.h"
-#include "../util/godot/classes/rigid_body_3d.h"
-#include "../util/godot/classes/timer.h"
-#include "../util/island_finder.h"
 #include "../util/math/conv.h"
 #include "../util/string/format.h"
 #include "../util/tasks/async_dependency_tracker.h"
 #include "../util/voxel_raycast.h"
+#include "floating_chunks.h"
 #include "funcs.h"
+#include "interpolated_voxel_sampler.h"
 #include "voxel_mesh_sdf_gd.h"
 
 namespace zylann::voxel {
@@ -38,34 +34,35 @@ bool VoxelToolLodTerrain::is_area_editable(const Box3i &box) const {
 // An alternative would be to polygonize a tiny area around the middle-phase hit position.
 // `d1` is how far from `pos0` along `dir` the binary search will take place.
 // The segment may be adjusted internally if it does not contain a zero-crossing of the
-template <typename Volume_F>
+// `sdf_f` returns the interpolated SDF at a given position.
+template <typename InterpolatedSDF_F>
 float approximate_distance_to_isosurface_binary_search(
-		const Volume_F &f,
+		InterpolatedSDF_F &sdf_f,
 		Vector3 pos0,
 		Vector3 dir,
 		float d1,
 		int iterations
 ) {
 	float d0 = 0.f;
-	float sdf0 = get_sdf_interpolated(f, pos0);
+	float sdf0 = sdf_f(pos0);
 	// The position given as argument may be a rough approximation coming from the middle-phase,
 	// so it can be slightly below the surface. We can adjust it a little so it is above.
 	for (int i = 0; i < 4 && sdf0 < 0.f; ++i) {
 		d0 -= 0.5f;
-		sdf0 = get_sdf_interpolated(f, pos0 + dir * d0);
+		sdf0 = sdf_f(pos0 + dir * d0);
 	}
 
-	float sdf1 = get_sdf_interpolated(f, pos0 + dir * d1);
+	float sdf1 = sdf_f(pos0 + dir * d1);
 	for (int i = 0; i < 4 && sdf1 > 0.f; ++i) {
 		d1 += 0.5f;
-		sdf1 = get_sdf_interpolated(f, pos0 + dir * d1);
+		sdf1 = sdf_f(pos0 + dir * d1);
 	}
 
 	if ((sdf0 > 0) != (sdf1 > 0)) {
 		// Binary search
 		for (int i = 0; i < iterations; ++i) {
 			const float dm = 0.5f * (d0 + d1);
-			const float sdf_mid = get_sdf_interpolated(f, pos0 + dir * dm);
+			const float sdf_mid = sdf_f(pos0 + dir * dm);
 
 			if ((sdf_mid > 0) != (sdf0 > 0)) {
 				sdf1 = sdf_mid;
@@ -142,22 +139,14 @@ Ref<VoxelRaycastResult> VoxelToolLodTerrain::raycast(
 		float d = hit_distance;
 
 		if (_raycast_binary_search_iterations > 0) {
-			// This is not particularly optimized, but runs fast enough for player raycasts
-			struct VolumeSampler {
-				VoxelData &data;
-
-				inline float operator()(const Vector3i &pos) const {
-					VoxelSingleValue defval;
-					defval.f = constants::SDF_FAR_OUTSIDE;
-					const VoxelSingleValue value = data.get_voxel(pos, VoxelBuffer::CHANNEL_SDF, defval);
-					return value.f;
-				}
-			};
-
-			VolumeSampler sampler{ _terrain->get_storage() };
+			// Samples are all taken along a short segment, so they mostly hit the same pinned blocks
+			InterpolatedVoxelSampler sampler(
+					_terrain->get_storage(), VoxelBuffer::CHANNEL_SDF, constants::SDF_FAR_OUTSIDE
+			);
+			auto sdf_f = [&sampler](Vector3 p) { return sampler.sample(p); };
 			d = hit_distance_prev +
 					approximate_distance_to_isosurface_binary_search(
-							sampler,
+							sdf_f,
 							pos + dir * hit_distance_prev,
 							dir,
 							hit_distance - hit_distance_prev,
@@ -344,6 +333,113 @@ void VoxelToolLodTerrain::do_sphere_async(Vector3 center, float radius) {
 	_terrain->push_async_edit(task, op.box, task->get_tracker());
 }
 
+// Pastes a chunked buffer over a group of destination blocks. A paste is split in several of these tasks so it runs in
+// parallel. Only the first one is scheduled as an async edit, and schedules the others when it runs, so the terrain
+// sees the whole paste as a single edit.
+class PasteSchematicAsyncTask : public IThreadedTask {
+public:
+	struct Params {
+		std::shared_ptr<VoxelData> data;
+		std::shared_ptr<const ChunkedVoxelBuffer> src;
+		OrthoGridTransform transform;
+		Vector3i min_pos;
+		uint8_t channels_mask;
+		std::shared_ptr<AsyncDependencyTracker> tracker;
+	};
+
+	PasteSchematicAsyncTask(std::shared_ptr<const Params> params, StdVector<Vector3i> &&block_positions) :
+			_params(params), _block_positions(std::move(block_positions)) {}
+
+	const char *get_debug_name() const override {
+		return "PasteSchematicAsync";
+	}
+
+	void run(ThreadedTaskContext &ctx) override {
+		ZN_PROFILE_SCOPE();
+
+		if (_tasks_to_schedule.size() > 0) {
+			VoxelEngine::get_singleton().push_async_tasks(to_span(_tasks_to_schedule));
+			_tasks_to_schedule.clear();
+		}
+
+		const Params &params = *_params;
+		VoxelData &data = *params.data;
+		const Vector3i block_size_v = Vector3iUtil::create(data.get_block_size());
+
+		for (const Vector3i bpos : _block_positions) {
+			// TODO Need to apply modifiers
+			data.pre_generate_box(Box3i(data.block_to_voxel(bpos), block_size_v));
+			data.paste_block(bpos, params.min_pos, *params.src, params.transform, params.channels_mask, false);
+		}
+
+		params.tracker->post_complete();
+	}
+
+	StdVector<IThreadedTask *> &get_tasks_to_schedule() {
+		return _tasks_to_schedule;
+	}
+
+private:
+	std::shared_ptr<const Params> _params;
+	StdVector<Vector3i> _block_positions;
+	StdVector<IThreadedTask *> _tasks_to_schedule;
+};
+
+void VoxelToolLodTerrain::paste_schematic_async(
+		Vector3i pos,
+		Ref<godot::VoxelSchematic> schematic,
+		int channels_mask,
+		Basis basis
+) {
+	ERR_FAIL_COND(_terrain == nullptr);
+	ERR_FAIL_COND(schematic.is_null());
+	if (Vector3iUtil::is_empty_size(schematic->get_size())) {
+		ZN_PRINT_WARNING("The passed schematic has an empty size, nothing will be pasted.");
+		return;
+	}
+	if (channels_mask == 0) {
+		channels_mask = (1 << _channel);
+	}
+
+	std::shared_ptr<PasteSchematicAsyncTask::Params> params = make_shared_instance<PasteSchematicAsyncTask::Params>();
+	ERR_FAIL_COND(!godot::VoxelSchematic::try_get_grid_transform(schematic->get_size(), basis, params->transform));
+
+	const Box3i box = Box3i(pos, params->transform.dst_size).clipped(_terrain->get_voxel_bounds());
+	if (box.is_empty()) {
+		return;
+	}
+	if (!is_area_editable(box)) {
+		ZN_PRINT_WARNING("Area not editable");
+		return;
+	}
+
+	params->data = _terrain->get_storage_shared();
+	params->src = schematic->get_buffer_shared();
+	params->min_pos = pos;
+	params->channels_mask = channels_mask;
+
+	// Group destination blocks so each task has enough work to be worth scheduling
+	static const unsigned int BLOCKS_PER_TASK = 64;
+	StdVector<StdVector<Vector3i>> groups;
+	const Box3i blocks_box = box.downscaled(params->data->get_block_size());
+	blocks_box.for_each_cell_zxy([&groups](Vector3i bpos) {
+		if (groups.size() == 0 || groups.back().size() == BLOCKS_PER_TASK) {
+			groups.push_back(StdVector<Vector3i>());
+			groups.back().reserve(BLOCKS_PER_TASK);
+		}
+		groups.back().push_back(bpos);
+	});
+
+	params->tracker = make_shared_instance<AsyncDependencyTracker>(groups.size());
+
+	PasteSchematicAsyncTask *first_task = ZN_NEW(PasteSchematicAsyncTask(params, std::move(groups[0])));
+	for (unsigned int i = 1; i < groups.size(); ++i) {
+		first_task->get_tasks_to_schedule().push_back(ZN_NEW(PasteSchematicAsyncTask(params, std::move(groups[i]))));
+	}
+
+	_terrain->push_async_edit(first_task, box, params->tracker);
+}
+
 void VoxelToolLodTerrain::copy(Vector3i pos, VoxelBuffer &dst, uint8_t channels_mask) const {
 	ERR_FAIL_COND(_terrain == nullptr);
 	if (channels_mask == 0) {
@@ -371,21 +467,77 @@ void VoxelToolLodTerrain::paste(Vector3i pos, const VoxelBuffer &src, uint8_t ch
 	_post_edit(box);
 }
 
+void VoxelToolLodTerrain::copy_schematic(Vector3i pos, ChunkedVoxelBuffer &dst, uint8_t channels_mask) const {
+	ERR_FAIL_COND(_terrain == nullptr);
+	if (channels_mask == 0) {
+		channels_mask = (1 << _channel);
+	}
+	_terrain->get_storage().copy(pos, dst, channels_mask);
+}
+
+void VoxelToolLodTerrain::paste_schematic(
+		Vector3i pos,
+		const ChunkedVoxelBuffer &src,
+		const OrthoGridTransform &transform,
+		uint8_t channels_mask
+) {
+	ERR_FAIL_COND(_terrain == nullptr);
+	if (channels_mask == 0) {
+		channels_mask = (1 << _channel);
+	}
+	const Box3i box = Box3i(pos, transform.dst_size).clipped(_terrain->get_voxel_bounds());
+	if (box.is_empty()) {
+		return;
+	}
+	if (!is_area_editable(box)) {
+		ZN_PRINT_WARNING("Area not editable");
+		return;
+	}
+
+	VoxelData &data = _terrain->get_storage();
+
+	data.pre_generate_box(box);
+	// Blocks outside of bounds don't exist, so they are skipped
+	data.paste(pos, src, transform, channels_mask, false);
+
+	_post_edit(box);
+}
+
 float VoxelToolLodTerrain::get_voxel_f_interpolated(Vector3 position) const {
 	ZN_PROFILE_SCOPE();
 	ERR_FAIL_COND_V(_terrain == nullptr, 0);
-	const int channel = get_channel();
-	VoxelData &data = _terrain->get_storage();
-	// TODO Optimization: is it worth making a fast-path for this?
-	return get_sdf_interpolated(
-			[&data, channel](Vector3i ipos) {
-				VoxelSingleValue defval;
-				defval.f = constants::SDF_FAR_OUTSIDE;
-				VoxelSingleValue value = data.get_voxel(ipos, channel, defval);
-				return value.f;
-			},
-			position
+	InterpolatedVoxelSampler sampler(_terrain->get_storage(), get_channel(), constants::SDF_FAR_OUTSIDE);
+	return sampler.sample(position);
+}
+
+PackedFloat32Array VoxelToolLodTerrain::get_voxel_f_interpolated_batch(const PackedVector3Array &positions) const {
+	ZN_PROFILE_SCOPE();
+	PackedFloat32Array values;
+	ERR_FAIL_COND_V(_terrain == nullptr, values);
+	values.resize(positions.size());
+	InterpolatedVoxelSampler sampler(_terrain->get_storage(), get_channel(), constants::SDF_FAR_OUTSIDE);
+	sampler.sample_batch(
+			Span<const Vector3>(positions.ptr(), positions.size()),
+			Span<float>(values.ptrw(), values.size()),
+			Span<Vector3>()
 	);
+	return values;
+}
+
+PackedVector3Array VoxelToolLodTerrain::get_voxel_f_gradient_batch(const PackedVector3Array &positions) const {
+	ZN_PROFILE_SCOPE();
+	PackedVector3Array gradients;
+	ERR_FAIL_COND_V(_terrain == nullptr, gradients);
+	gradients.resize(positions.size());
+	StdVector<float> values;
+	values.resize(positions.size());
+	InterpolatedVoxelSampler sampler(_terrain->get_storage(), get_channel(), constants::SDF_FAR_OUTSIDE);
+	sampler.sample_batch(
+			Span<const Vector3>(positions.ptr(), positions.size()),
+			to_span(values),
+			Span<Vector3>(gradients.ptrw(), gradients.size())
+	);
+	return gradients;
 }
 
 uint64_t VoxelToolLodTerrain::_get_voxel(Vector3i pos) const {
@@ -428,489 +580,6 @@ void VoxelToolLodTerrain::set_raycast_binary_search_iterations(int iterations) {
 	_raycast_binary_search_iterations = math::clamp(iterations, 0, 16);
 }
 
-void box_propagate_ccl(Span<uint8_t> cells, const Vector3i size) {
-	ZN_PROFILE_SCOPE();
-
-	// Propagate non-zero cells towards zero cells in a 3x3x3 pattern.
-	// Used on a grid produced by Connected-Component-Labelling.
-
-	// Z
-	{
-		ZN_PROFILE_SCOPE_NAMED("Z");
-		Vector3i pos;
-		const int dz = size.x * size.y;
-		unsigned int i = 0;
-		for (pos.x = 0; pos.x < size.x; ++pos.x) {
-			for (pos.y = 0; pos.y < size.y; ++pos.y) {
-				// Note, border cells are not handled. Not just because it's more work, but also because that could
-				// make the label touch the edge, which is later interpreted as NOT being an island.
-				pos.z = 2;
-				i = Vector3iUtil::get_zxy_index(pos, size);
-				for (; pos.z < size.z - 2; ++pos.z, i += dz) {
-					const uint8_t c = cells[i];
-					if (c != 0) {
-						if (cells[i - dz] == 0) {
-							cells[i - dz] = c;
-						}
-						if (cells[i + dz] == 0) {
-							cells[i + dz] = c;
-							// Skip next cell, otherwise it would cause endless propagation
-							i += dz;
-							++pos.z;
-						}
-					}
-				}
-			}
-		}
-	}
-
-	// X
-	{
-		ZN_PROFILE_SCOPE_NAMED("X");
-		Vector3i pos;
-		const int dx = size.y;
-		unsigned int i = 0;
-		for (pos.z = 0; pos.z < size.z; ++pos.z) {
-			for (pos.y = 0; pos.y < size.y; ++pos.y) {
-				pos.x = 2;
-				i = Vector3iUtil::get_zxy_index(pos, size);
-				for (; pos.x < size.x - 2; ++pos.x, i += dx) {
-					const uint8_t c = cells[i];
-					if (c != 0) {
-						if (cells[i - dx] == 0) {
-							cells[i - dx] = c;
-						}
-						if (cells[i + dx] == 0) {
-							cells[i + dx] = c;
-							i += dx;
-							++pos.x;
-						}
-					}
-				}
-			}
-		}
-	}
-
-	// Y
-	{
-		ZN_PROFILE_SCOPE_NAMED("Y");
-		Vector3i pos;
-		const int dy = 1;
-		unsigned int i = 0;
-		for (pos.z = 0; pos.z < size.z; ++pos.z) {
-			for (pos.x = 0; pos.x < size.x; ++pos.x) {
-				pos.y = 2;
-				i = Vector3iUtil::get_zxy_index(pos, size);
-				for (; pos.y < size.y - 2; ++pos.y, i += dy) {
-					const uint8_t c = cells[i];
-					if (c != 0) {
-						if (cells[i - dy] == 0) {
-							cells[i - dy] = c;
-						}
-						if (cells[i + dy] == 0) {
-							cells[i + dy] = c;
-							i += dy;
-							++pos.y;
-						}
-					}
-				}
-			}
-		}
-	}
-}
-
-// Turns floating chunks of voxels into rigidbodies:
-// Detects separate groups of connected voxels within a box. Each group fully contained in the box is removed from
-// the source volume, and turned into a rigidbody.
-// This is one way of doing it, I don't know if it's the best way (there is rarely a best way)
-// so there are probably other approaches that could be explored in the future, if they have better performance
-Array separate_floating_chunks(
-		VoxelTool &voxel_tool,
-		Box3i world_box,
-		Node *parent_node,
-		Transform3D transform,
-		Ref<VoxelMesher> mesher,
-		Array materials
-) {
-	ZN_PROFILE_SCOPE();
-
-	// Checks
-	ERR_FAIL_COND_V(mesher.is_null(), Array());
-	ERR_FAIL_COND_V(parent_node == nullptr, Array());
-
-	// Copy source data
-
-	// TODO Do not assume channel, at the moment it's hardcoded for smooth terrain
-	static const int channels_mask = (1 << VoxelBuffer::CHANNEL_SDF);
-	static const VoxelBuffer::ChannelId main_channel = VoxelBuffer::CHANNEL_SDF;
-
-	VoxelBuffer source_copy_buffer(VoxelBuffer::ALLOCATOR_POOL);
-	{
-		ZN_PROFILE_SCOPE_NAMED("Copy");
-		source_copy_buffer.create(world_box.size);
-		voxel_tool.copy(world_box.position, source_copy_buffer, channels_mask);
-	}
-
-	// Label distinct voxel groups
-
-	static thread_local StdVector<uint8_t> ccl_output;
-	ccl_output.resize(Vector3iUtil::get_volume(world_box.size));
-
-	unsigned int label_count = 0;
-
-	{
-		// TODO Allow to run the algorithm at a different LOD, to trade precision for speed
-		ZN_PROFILE_SCOPE_NAMED("CCL scan");
-		IslandFinder island_finder;
-		island_finder.scan_3d(
-				Box3i(Vector3i(), world_box.size),
-				[&source_copy_buffer](Vector3i pos) {
-					// TODO Can be optimized further with direct access
-					return source_copy_buffer.get_voxel_f(pos.x, pos.y, pos.z, main_channel) < 0.f;
-				},
-				to_span(ccl_output),
-				&label_count
-		);
-	}
-
-	struct Bounds {
-		Vector3i min_pos;
-		Vector3i max_pos; // inclusive
-		bool valid = false;
-	};
-
-	if (main_channel == VoxelBuffer::CHANNEL_SDF) {
-		// Propagate labels to improve SDF quality, otherwise gradients of separated chunks would cut off abruptly.
-		// Limitation: if two islands are too close to each other, one will win over the other.
-		// An alternative could be to do this on individual chunks?
-		box_propagate_ccl(to_span(ccl_output), world_box.size);
-	}
-
-	// Compute bounds of each group
-
-	StdVector<Bounds> bounds_per_label;
-	{
-		ZN_PROFILE_SCOPE_NAMED("Bounds calculation");
-
-		// Adding 1 because label 0 is the index for "no label"
-		bounds_per_label.resize(label_count + 1);
-
-		unsigned int ccl_index = 0;
-		for (int z = 0; z < world_box.size.z; ++z) {
-			for (int x = 0; x < world_box.size.x; ++x) {
-				for (int y = 0; y < world_box.size.y; ++y) {
-					CRASH_COND(ccl_index >= ccl_output.size());
-					const uint8_t label = ccl_output[ccl_index];
-					++ccl_index;
-
-					if (label == 0) {
-						continue;
-					}
-
-					CRASH_COND(label >= bounds_per_label.size());
-					Bounds &bounds = bounds_per_label[label];
-
-					if (bounds.valid == false) {
-						bounds.min_pos = Vector3i(x, y, z);
-						bounds.max_pos = bounds.min_pos;
-						bounds.valid = true;
-
-					} else {
-						if (x < bounds.min_pos.x) {
-							bounds.min_pos.x = x;
-						} else if (x > bounds.max_pos.x) {
-							bounds.max_pos.x = x;
-						}
-
-						if (y < bounds.min_pos.y) {
-							bounds.min_pos.y = y;
-						} else if (y > bounds.max_pos.y) {
-							bounds.max_pos.y = y;
-						}
-
-						if (z < bounds.min_pos.z) {
-							bounds.min_pos.z = z;
-						} else if (z > bounds.max_pos.z) {
-							bounds.max_pos.z = z;
-						}
-					}
-				}
-			}
-		}
-	}
-
-	// Eliminate groups that touch the box border,
-	// because that means we can't tell if they are truly hanging in the air or attached to land further away
-
-	const Vector3i lbmax = world_box.size - Vector3i(1, 1, 1);
-	for (unsigned int label = 1; label < bounds_per_label.size(); ++label) {
-		CRASH_COND(label >= bounds_per_label.size());
-		Bounds &local_bounds = bounds_per_label[label];
-		ERR_CONTINUE(!local_bounds.valid);
-
-		if ( //
-				local_bounds.min_pos.x == 0 //
-				|| local_bounds.min_pos.y == 0 //
-				|| local_bounds.min_pos.z == 0 //
-				|| local_bounds.max_pos.x == lbmax.x //
-				|| local_bounds.max_pos.y == lbmax.y //
-				|| local_bounds.max_pos.z == lbmax.z) {
-			//
-			local_bounds.valid = false;
-		}
-	}
-
-	// Create voxel buffer for each group
-
-	struct InstanceInfo {
-		VoxelBuffer voxels;
-		Vector3i world_pos;
-		unsigned int label;
-	};
-	StdVector<InstanceInfo> instances_info;
-
-	const int min_padding = 2; // mesher->get_minimum_padding();
-	const int max_padding = 2; // mesher->get_maximum_padding();
-
-	{
-		ZN_PROFILE_SCOPE_NAMED("Extraction");
-
-		for (unsigned int label = 1; label < bounds_per_label.size(); ++label) {
-			CRASH_COND(label >= bounds_per_label.size());
-			const Bounds local_bounds = bounds_per_label[label];
-
-			if (!local_bounds.valid) {
-				continue;
-			}
-
-			const Vector3i world_pos = world_box.position + local_bounds.min_pos - Vector3iUtil::create(min_padding);
-			const Vector3i size =
-					local_bounds.max_pos - local_bounds.min_pos + Vector3iUtil::create(1 + max_padding + min_padding);
-
-			instances_info.push_back(InstanceInfo{ VoxelBuffer(VoxelBuffer::ALLOCATOR_POOL), world_pos, label });
-
-			VoxelBuffer &buffer = instances_info.back().voxels;
-			buffer.create(size.x, size.y, size.z);
-
-			// Read voxels from the source volume
-			voxel_tool.copy(world_pos, buffer, channels_mask);
-
-			// Cleanup padding borders
-			const Box3i inner_box(
-					Vector3iUtil::create(min_padding),
-					buffer.get_size() - Vector3iUtil::create(min_padding + max_padding)
-			);
-			Box3i(Vector3i(), buffer.get_size()).difference(inner_box, [&buffer](Box3i box) {
-				buffer.fill_area_f(constants::SDF_FAR_OUTSIDE, box.position, box.position + box.size, main_channel);
-			});
-
-			// Filter out voxels that don't belong to this label
-			for (int z = local_bounds.min_pos.z; z <= local_bounds.max_pos.z; ++z) {
-				for (int x = local_bounds.min_pos.x; x <= local_bounds.max_pos.x; ++x) {
-					for (int y = local_bounds.min_pos.y; y <= local_bounds.max_pos.y; ++y) {
-						const unsigned int ccl_index = Vector3iUtil::get_zxy_index(Vector3i(x, y, z), world_box.size);
-						CRASH_COND(ccl_index >= ccl_output.size());
-						const uint8_t label2 = ccl_output[ccl_index];
-
-						if (label2 != 0 && label != label2) {
-							buffer.set_voxel_f(
-									constants::SDF_FAR_OUTSIDE,
-									min_padding + x - local_bounds.min_pos.x,
-									min_padding + y - local_bounds.min_pos.y,
-									min_padding + z - local_bounds.min_pos.z,
-									main_channel
-							);
-						}
-					}
-				}
-			}
-		}
-	}
-
-	// Erase voxels from source volume.
-	// Must be done after we copied voxels from it.
-
-	{
-		ZN_PROFILE_SCOPE_NAMED("Erasing");
-
-		voxel_tool.set_channel(main_channel);
-
-		for (unsigned int instance_index = 0; instance_index < instances_info.size(); ++instance_index) {
-			CRASH_COND(instance_index >= instances_info.size());
-			const InstanceInfo &info = instances_info[instance_index];
-			voxel_tool.sdf_stamp_erase(info.voxels, info.world_pos);
-		}
-	}
-
-	// Find out which materials contain parameters that require instancing.
-	//
-	// Since 7dbc458bb4f3e0cc94e5070bd33bde41d214c98d it's no longer possible to quickly check if a
-	// shader has a uniform by name using Shader's parameter cache. Now it seems the only way is to get the whole list
-	// of parameters and find into it, which is slow, tedious to write and different between modules and GDExtension.
-
-	uint32_t materials_to_instance_mask = 0;
-	{
-		StdVector<zylann::godot::ShaderParameterInfo> params;
-		const String u_block_local_transform = VoxelStringNames::get_singleton().u_block_local_transform;
-
-		ZN_ASSERT_RETURN_V_MSG(
-				materials.size() < 32,
-				Array(),
-				"Too many materials. If you need more, make a request or change the code."
-		);
-
-		for (int material_index = 0; material_index < materials.size(); ++material_index) {
-			Ref<ShaderMaterial> sm = materials[material_index];
-			if (sm.is_null()) {
-				continue;
-			}
-
-			Ref<Shader> shader = sm->get_shader();
-			if (shader.is_null()) {
-				continue;
-			}
-
-			params.clear();
-			zylann::godot::get_shader_parameter_list(shader->get_rid(), params);
-
-			for (const zylann::godot::ShaderParameterInfo &param_info : params) {
-				if (param_info.name == u_block_local_transform) {
-					materials_to_instance_mask |= (1 << material_index);
-					break;
-				}
-			}
-		}
-	}
-
-	// Create instances
-
-	Array nodes;
-
-	{
-		ZN_PROFILE_SCOPE_NAMED("Remeshing and instancing");
-
-		for (unsigned int instance_index = 0; instance_index < instances_info.size(); ++instance_index) {
-			CRASH_COND(instance_index >= instances_info.size());
-			const InstanceInfo &info = instances_info[instance_index];
-
-			CRASH_COND(info.label >= bounds_per_label.size());
-			const Bounds local_bounds = bounds_per_label[info.label];
-			ERR_CONTINUE(!local_bounds.valid);
-
-			// DEBUG
-			// print_line(String("--- Instance {0}").format(varray(instance_index)));
-			// for (int z = 0; z < info.voxels->get_size().z; ++z) {
-			// 	for (int x = 0; x < info.voxels->get_size().x; ++x) {
-			// 		String s;
-			// 		for (int y = 0; y < info.voxels->get_size().y; ++y) {
-			// 			float sdf = info.voxels->get_voxel_f(x, y, z, VoxelBuffer::CHANNEL_SDF);
-			// 			if (sdf < -0.1f) {
-			// 				s += "X ";
-			// 			} else if (sdf < 0.f) {
-			// 				s += "x ";
-			// 			} else {
-			// 				s += "- ";
-			// 			}
-			// 		}
-			// 		print_line(s);
-			// 	}
-			// 	print_line("//");
-			// }
-
-			const Transform3D local_transform(
-					Basis(),
-					info.world_pos
-							// Undo min padding
-							+ Vector3i(1, 1, 1)
-			);
-
-			for (int i = 0; i < materials.size(); ++i) {
-				if ((materials_to_instance_mask & (1 << i)) != 0) {
-					Ref<ShaderMaterial> sm = materials[i];
-					ZN_ASSERT_CONTINUE(sm.is_valid());
-					sm = sm->duplicate(false);
-					// That parameter should have a valid default value matching the local transform relative to the
-					// volume, which is usually per-instance, but in Godot 3 we have no such feature, so we have to
-					// duplicate.
-					// TODO Try using per-instance parameters for scalar uniforms (Godot 4 doesn't support textures)
-					sm->set_shader_parameter(
-							VoxelStringNames::get_singleton().u_block_local_transform, local_transform
-					);
-					materials[i] = sm;
-				}
-			}
-
-			// TODO If normalmapping is used here with the Transvoxel mesher, we need to either turn it off just for
-			// this call, or to pass the right options
-			Ref<ArrayMesh> mesh = mesher->build_mesh(info.voxels, materials, Dictionary());
-			// The mesh is not supposed to be null,
-			// because we build these buffers from connected groups that had negative SDF.
-			ERR_CONTINUE(mesh.is_null());
-
-			if (zylann::godot::is_mesh_empty(**mesh)) {
-				continue;
-			}
-
-			// DEBUG
-			// {
-			// 	Ref<VoxelBlockSerializer> serializer;
-			// 	serializer.instance();
-			// 	Ref<StreamPeerBuffer> peer;
-			// 	peer.instance();
-			// 	serializer->serialize(peer, info.voxels, false);
-			// 	String fpath = String("debug_data/split_dump_{0}.bin").format(varray(instance_index));
-			// 	FileAccess *f = FileAccess::open(fpath, FileAccess::WRITE);
-			// 	PoolByteArray bytes = peer->get_data_array();
-			// 	PoolByteArray::Read bytes_read = bytes.read();
-			// 	f->store_buffer(bytes_read.ptr(), bytes.size());
-			// 	f->close();
-			// 	memdelete(f);
-			// }
-
-			// TODO Option to make multiple convex shapes
-			// TODO Use the fast way. This is slow because of the internal TriangleMesh thing and mesh data query.
-			// TODO Don't create a body if the mesh has no triangles
-			Ref<Shape3D> shape = mesh->create_convex_shape();
-			ERR_CONTINUE(shape.is_null());
-			CollisionShape3D *collision_shape = memnew(CollisionShape3D);
-			collision_shape->set_shape(shape);
-			// Center the shape somewhat, because Godot is confusing node origin with center of mass
-			const Vector3i size =
-					local_bounds.max_pos - local_bounds.min_pos + Vector3iUtil::create(1 + max_padding + min_padding);
-			const Vector3 offset = -Vector3(size) * 0.5f;
-			collision_shape->set_position(offset);
-
-			RigidBody3D *rigid_body = memnew(RigidBody3D);
-			rigid_body->set_transform(transform * local_transform.translated_local(-offset));
-			rigid_body->add_child(collision_shape);
-			rigid_body->set_freeze_mode(RigidBody3D::FREEZE_MODE_KINEMATIC);
-			rigid_body->set_freeze_enabled(true);
-
-			// Switch to rigid after a short time to workaround clipping with terrain,
-			// because colliders are updated asynchronously
-			Timer *timer = memnew(Timer);
-			timer->set_wait_time(0.2);
-			timer->set_one_shot(true);
-			timer->connect("timeout", callable_mp(rigid_body, &RigidBody3D::set_freeze_enabled).bind(false));
-			// Cannot use start() here because it requires to be inside the SceneTree,
-			// and we don't know if it will be after we add to the parent.
-			timer->set_autostart(true);
-			rigid_body->add_child(timer);
-
-			MeshInstance3D *mesh_instance = memnew(MeshInstance3D);
-			mesh_instance->set_mesh(mesh);
-			mesh_instance->set_position(offset);
-			rigid_body->add_child(mesh_instance);
-
-			parent_node->add_child(rigid_body);
-
-			nodes.append(rigid_body);
-		}
-	}
-
-	return nodes;
-}
-
 #if defined(ZN_GODOT)
 Array VoxelToolLodTerrain::separate_floating_chunks(AABB world_box, Node *parent_node) {
 #elif defined(ZN_GODOT_EXTENSION)
@@ -928,6 +597,59 @@ Array VoxelToolLodTerrain::separate_floating_chunks(AABB world_box, Object *pare
 	);
 }
 
+#if defined(ZN_GODOT)
+void VoxelToolLodTerrain::separate_floating_chunks_async(
+		AABB world_box,
+		Node *parent_node,
+		Callable callback,
+		bool erase_islands
+) {
+#elif defined(ZN_GODOT_EXTENSION)
+void VoxelToolLodTerrain::separate_floating_chunks_async(
+		AABB world_box,
+		Object *parent_node_o,
+		Callable callback,
+		bool erase_islands
+) {
+	Node *parent_node = Object::cast_to<Node>(parent_node_o);
+#endif
+	ZN_PROFILE_SCOPE();
+	ERR_FAIL_COND(_terrain == nullptr);
+	ERR_FAIL_COND(!math::is_valid_size(world_box.size));
+	ERR_FAIL_COND(parent_node == nullptr);
+	Ref<VoxelMesher> mesher = _terrain->get_mesher();
+	ERR_FAIL_COND(mesher.is_null());
+
+	const Box3i int_world_box(math::floor_to_int(world_box.position), math::ceil_to_int(world_box.size));
+
+	if (!is_area_editable(int_world_box)) {
+		ZN_PRINT_WARNING("Area not editable");
+		return;
+	}
+
+	std::shared_ptr<FloatingChunksAsyncContext> context = make_shared_instance<FloatingChunksAsyncContext>();
+	context->data = _terrain->get_storage_shared();
+	context->world_box = int_world_box;
+	context->mesher = mesher;
+	context->erase_islands = erase_islands;
+	context->parent_node.set(parent_node);
+	context->transform = _terrain->get_global_transform();
+	context->materials.append(_terrain->get_material());
+	ZN_ASSERT_RETURN(get_materials_to_instance_mask(context->materials, context->materials_to_instance_mask));
+	context->callback = callback;
+
+	SeparateFloatingChunksTask *task = ZN_NEW(SeparateFloatingChunksTask(context));
+
+	if (erase_islands) {
+		// Running as an edit, so islands are erased in the same batch as other asynchronous edits, and the area gets
+		// updated once they are erased
+		context->edit_tracker = make_shared_instance<AsyncDependencyTracker>(1);
+		_terrain->push_async_edit(task, int_world_box, context->edit_tracker);
+	} else {
+		VoxelEngine::get_singleton().push_async_task(task);
+	}
+}
+
 // Combines a precalculated SDF with the terrain at a specific position, rotation and scale.
 //
 // `transform` is where the buffer should be applied on the terrain.
@@ -1129,6 +851,25 @@ void VoxelToolLodTerrain::run_blocky_random_tick(
 		const int voxel_count,
 		const Callable &callback,
 		const int block_batch_count
+) {
+	run_blocky_random_tick_internal(voxel_area, voxel_count, callback, block_batch_count, false);
+}
+
+void VoxelToolLodTerrain::run_blocky_random_tick_batched(
+		const AABB voxel_area,
+		const int voxel_count,
+		const Callable &callback,
+		const int block_batch_count
+) {
+	run_blocky_random_tick_internal(voxel_area, voxel_count, callback, block_batch_count, true);
+}
+
+void VoxelToolLodTerrain::run_blocky_random_tick_internal(
+		const AABB voxel_area,
+		const int voxel_count,
+		const Callable &callback,
+		const int block_batch_count,
+		const bool batched
 ) {
 	ZN_PROFILE_SCOPE();
 
@@ -1153,9 +894,15 @@ void VoxelToolLodTerrain::run_blocky_random_tick(
 
 	VoxelData &data = _terrain->get_storage();
 
-	zylann::voxel::run_blocky_random_tick(
-			data, voxel_area, **library, _random, voxel_count, block_batch_count, callback
-	);
+	if (batched) {
+		zylann::voxel::run_blocky_random_tick_batched(
+				data, voxel_area, **library, _random, voxel_count, block_batch_count, callback
+		);
+	} else {
+		zylann::voxel::run_blocky_random_tick(
+				data, voxel_area, **library, _random, voxel_count, block_batch_count, callback
+		);
+	}
 }
 
 void VoxelToolLodTerrain::_bind_methods() {
@@ -1166,8 +913,22 @@ void VoxelToolLodTerrain::_bind_methods() {
 	);
 	ClassDB::bind_method(D_METHOD("get_raycast_binary_search_iterations"), &Self::get_raycast_binary_search_iterations);
 	ClassDB::bind_method(D_METHOD("get_voxel_f_interpolated", "position"), &Self::get_voxel_f_interpolated);
+	ClassDB::bind_method(
+			D_METHOD("get_voxel_f_interpolated_batch", "positions"), &Self::get_voxel_f_interpolated_batch
+	);
+	ClassDB::bind_method(D_METHOD("get_voxel_f_gradient_batch", "positions"), &Self::get_voxel_f_gradient_batch);
 	ClassDB::bind_method(D_METHOD("separate_floating_chunks", "box", "parent_node"), &Self::separate_floating_chunks);
+	ClassDB::bind_method(
+			D_METHOD("separate_floating_chunks_async", "box", "parent_node", "callback", "erase_islands"),
+			&Self::separate_floating_chunks_async,
+			DEFVAL(true)
+	);
 	ClassDB::bind_method(D_METHOD("do_sphere_async", "center", "radius"), &Self::do_sphere_async);
+	ClassDB::bind_method(
+			D_METHOD("paste_schematic_async", "dst_pos", "src_schematic", "channels_mask", "basis"),
+			&Self::paste_schematic_async,
+			DEFVAL(Basis())
+	);
 	ClassDB::bind_method(D_METHOD("stamp_sdf", "mesh_sdf", "transform", "isolevel", "sdf_scale"), &Self::stamp_sdf);
 	ClassDB::bind_method(D_METHOD("do_graph", "graph", "transform", "area_size"), &Self::do_graph);
 	ClassDB::bind_method(
@@ -1180,6 +941,11 @@ void VoxelToolLodTerrain::_bind_methods() {
 			&Self::run_blocky_random_tick,
 			DEFVAL(16)
 	);
+	ClassDB::bind_method(
+			D_METHOD("run_blocky_random_tick_batched", "area", "voxel_count", "callback", "batch_count"),
+			&Self::run_blocky_random_tick_batched,
+			DEFVAL(16)
+	);
 }
 
 } // namespace zylann::voxel
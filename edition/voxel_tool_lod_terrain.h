@@ -26,20 +26,32 @@ public:
 	void do_sphere(Vector3 center, float radius) override;
 	void copy(Vector3i pos, VoxelBuffer &dst, uint8_t channels_mask) const override;
 	void paste(Vector3i pos, const VoxelBuffer &src, uint8_t channels_mask) override;
+	void copy_schematic(Vector3i pos, ChunkedVoxelBuffer &dst, uint8_t channels_mask) const override;
+	void paste_schematic(
+			Vector3i pos,
+			const ChunkedVoxelBuffer &src,
+			const OrthoGridTransform &transform,
+			uint8_t channels_mask
+	) override;
 
 	// Specialized API
 
 	int get_raycast_binary_search_iterations() const;
 	void set_raycast_binary_search_iterations(int iterations);
 	void do_sphere_async(Vector3 center, float radius);
+	void paste_schematic_async(Vector3i pos, Ref<godot::VoxelSchematic> schematic, int channels_mask, Basis basis);
 	void do_hemisphere(Vector3 center, float radius, Vector3 flat_direction, float smoothness);
 	float get_voxel_f_interpolated(Vector3 position) const;
+	PackedFloat32Array get_voxel_f_interpolated_batch(const PackedVector3Array &positions) const;
+	PackedVector3Array get_voxel_f_gradient_batch(const PackedVector3Array &positions) const;
 
 	// TODO GDX: it seems binding a method taking a `Node*` fails to compile. It is supposed to be working.
 #if defined(ZN_GODOT)
 	Array separate_floating_chunks(AABB world_box, Node *parent_node);
+	void separate_floating_chunks_async(AABB world_box, Node *parent_node, Callable callback, bool erase_islands);
 #elif defined(ZN_GODOT_EXTENSION)
 	Array separate_floating_chunks(AABB world_box, Object *parent_node_o);
+	void separate_floating_chunks_async(AABB world_box, Object *parent_node_o, Callable callback, bool erase_islands);
 #endif
 
 	void stamp_sdf(Ref<VoxelMeshSDF> mesh_sdf, Transform3D transform, float isolevel, float sdf_scale);
@@ -51,6 +63,12 @@ public:
 			const Callable &callback,
 			const int block_batch_count
 	);
+	void run_blocky_random_tick_batched(
+			const AABB voxel_area,
+			const int voxel_count,
+			const Callable &callback,
+			const int block_batch_count
+	);
 
 protected:
 	uint64_t _get_voxel(Vector3i pos) const override;
@@ -60,6 +78,14 @@ protected:
 	void _post_edit(const Box3i &box) override;
 
 private:
+	void run_blocky_random_tick_internal(
+			const AABB voxel_area,
+			const int voxel_count,
+			const Callable &callback,
+			const int block_batch_count,
+			const bool batched
+	);
+
 	static void _bind_methods();
 
 	VoxelLodTerrain *_terrain = nullptr;
@@ -176,6 +176,28 @@ void VoxelToolTerrain::paste(Vector3i pos, const VoxelBuffer &src, uint8_t chann
 	_post_edit(Box3i(pos, src.get_size()));
 }
 
+void VoxelToolTerrain::copy_schematic(Vector3i pos, ChunkedVoxelBuffer &dst, uint8_t channels_mask) const {
+	ERR_FAIL_COND(_terrain == nullptr);
+	if (channels_mask == 0) {
+		channels_mask = (1 << _channel);
+	}
+	_terrain->get_storage().copy(pos, dst, channels_mask);
+}
+
+void VoxelToolTerrain::paste_schematic(
+		Vector3i pos,
+		const ChunkedVoxelBuffer &src,
+		const OrthoGridTransform &transform,
+		uint8_t channels_mask
+) {
+	ERR_FAIL_COND(_terrain == nullptr);
+	if (channels_mask == 0) {
+		channels_mask = (1 << _channel);
+	}
+	_terrain->get_storage().paste(pos, src, transform, channels_mask, false);
+	_post_edit(Box3i(pos, transform.dst_size));
+}
+
 void VoxelToolTerrain::paste_masked(
 		Vector3i pos,
 		Ref<godot::VoxelBuffer> p_voxels,
@@ -384,6 +406,25 @@ void VoxelToolTerrain::run_blocky_random_tick(
 		int voxel_count,
 		const Callable &callback,
 		int batch_count
+) {
+	run_blocky_random_tick_internal(voxel_area, voxel_count, callback, batch_count, false);
+}
+
+void VoxelToolTerrain::run_blocky_random_tick_batched(
+		AABB voxel_area,
+		int voxel_count,
+		const Callable &callback,
+		int batch_count
+) {
+	run_blocky_random_tick_internal(voxel_area, voxel_count, callback, batch_count, true);
+}
+
+void VoxelToolTerrain::run_blocky_random_tick_internal(
+		AABB voxel_area,
+		int voxel_count,
+		const Callable &callback,
+		int batch_count,
+		bool batched
 ) {
 	ZN_PROFILE_SCOPE();
 
@@ -405,7 +446,13 @@ void VoxelToolTerrain::run_blocky_random_tick(
 	const VoxelBlockyLibraryBase &lib = **get_voxel_library(*_terrain);
 	VoxelData &data = _terrain->get_storage();
 
-	zylann::voxel::run_blocky_random_tick(data, voxel_area, lib, _random, voxel_count, batch_count, callback);
+	if (batched) {
+		zylann::voxel::run_blocky_random_tick_batched(
+				data, voxel_area, lib, _random, voxel_count, batch_count, callback
+		);
+	} else {
+		zylann::voxel::run_blocky_random_tick(data, voxel_area, lib, _random, voxel_count, batch_count, callback);
+	}
 }
 
 void VoxelToolTerrain::for_each_voxel_metadata_in_area(AABB voxel_area, const Callable &callback) {
@@ -540,6 +587,11 @@ void VoxelToolTerrain::_bind_methods() {
 			&VoxelToolTerrain::run_blocky_random_tick,
 			DEFVAL(16)
 	);
+	ClassDB::bind_method(
+			D_METHOD("run_blocky_random_tick_batched", "area", "voxel_count", "callback", "batch_count"),
+			&VoxelToolTerrain::run_blocky_random_tick_batched,
+			DEFVAL(16)
+	);
 	ClassDB::bind_method(
 			D_METHOD("for_each_voxel_metadata_in_area", "voxel_area", "callback"),
 			&VoxelToolTerrain::for_each_voxel_metadata_in_area
@@ -25,6 +25,13 @@ public:
 
 	void copy(Vector3i pos, VoxelBuffer &dst, uint8_t channels_mask) const override;
 	void paste(Vector3i pos, const VoxelBuffer &src, uint8_t channels_mask) override;
+	void copy_schematic(Vector3i pos, ChunkedVoxelBuffer &dst, uint8_t channels_mask) const override;
+	void paste_schematic(
+			Vector3i pos,
+			const ChunkedVoxelBuffer &src,
+			const OrthoGridTransform &transform,
+			uint8_t channels_mask
+	) override;
 	void paste_masked(
 			Vector3i pos,
 			Ref<godot::VoxelBuffer> p_voxels,
@@ -52,6 +59,12 @@ public:
 	void do_hemisphere(Vector3 center, float radius, Vector3 flat_direction, float smoothness);
 
 	void run_blocky_random_tick(AABB voxel_area, int voxel_count, const Callable &callback, int block_batch_count);
+	void run_blocky_random_tick_batched(
+			AABB voxel_area,
+			int voxel_count,
+			const Callable &callback,
+			int block_batch_count
+	);
 
 	void for_each_voxel_metadata_in_area(AABB voxel_area, const Callable &callback);
 
@@ -63,6 +76,14 @@ protected:
 	void _post_edit(const Box3i &box) override;
 
 private:
+	void run_blocky_random_tick_internal(
+			AABB voxel_area,
+			int voxel_count,
+			const Callable &callback,
+			int block_batch_count,
+			bool batched
+	);
+
 	static void _bind_methods();
 
 	VoxelTerrain *_terrain = nullptr;
@@ -23,10 +23,10 @@ static const Node g_data[COUNT] = {
     {"Distance3D", "Vector", "Returns the distance between two 3D points [code](x0, y0, z0)[/code] and [code](x1, y1, z1)[/code]."},
     {"Divide", "Ops", "Returns the result of [code]a / b[/code].\nNote: dividing by zero outputs NaN. It should not cause crashes, but will likely mess up results. Consider using Multiply when possible."},
     {"Expression", "Math", "Evaluates a math expression. Variable names can be written as inputs of the node. Some functions can be used, but they must be supported graph nodes in the first place, as the expression will be converted to nodes internally.\nAvailable functions:\n[code]\nsin(x)\nfloor(x)\nabs(x)\nsqrt(x)\nfract(x)\nstepify(x, step)\nwrap(x, length)\nmin(a, b)\nmax(a, b)\nclamp(x, min, max)\nlerp(a, b, ratio)\n[/code]"},
-    {"FastNoise2D", "Noise", "Returns computation of 2D noise at coordinates [code](x, y)[/code] using the FastNoiseLite library. The [code]noise[/code] parameter is specified with an instance of the [url=ZN_FastNoiseLite]ZN_FastNoiseLite[/url] resource.\nNote: this node might be a little faster than [code]Noise2D[/code]."},
+    {"FastNoise2D", "Noise", "Returns computation of 2D noise at coordinates [code](x, y)[/code] using the FastNoiseLite library. The [code]noise[/code] parameter is specified with an instance of the [url=ZN_FastNoiseLite]ZN_FastNoiseLite[/url] resource.\nNote: this node might be a little faster than [code]Noise2D[/code].\nIf [code]measured_bounds[/code] is enabled, range analysis also uses bounds measured by sampling the noise when the graph is compiled. They are often much tighter, so more blocks can be skipped as fully air or fully solid, but they are approximate: rare extremes of the noise may fall outside of them, and be missing from the terrain. Measuring samples the noise about 73,000 times per node, which slows down compilation."},
     {"FastNoise2_2D", "Noise", "Returns computation of 2D SIMD noise at coordinates [code](x, y)[/code] using the FastNoise2 library. The `noise` parameter is specified with an instance of the [url=FastNoise2]FastNoise2[/url] resource. This is the fastest noise currently supported."},
     {"FastNoise2_3D", "Noise", "Returns computation of 3D SIMD noise at coordinates [code](x, y, z)[/code] using the FastNoise2 library. The [code]noise[/code] parameter is specified with an instance of the [url=FastNoise2]FastNoise2[/url] resource. This is the fastest noise currently supported."},
-    {"FastNoise3D", "Noise", "Returns computation of 3D noise at coordinates [code](x, y, z)[/code] using the FastNoiseLite library. The [code]noise[/code] parameter is specified with an instance of the [url=ZN_FastNoiseLite]ZN_FastNoiseLite[/url] resource.\nNote: this node might be a little faster than [code]Noise3D[/code]."},
+    {"FastNoise3D", "Noise", "Returns computation of 3D noise at coordinates [code](x, y, z)[/code] using the FastNoiseLite library. The [code]noise[/code] parameter is specified with an instance of the [url=ZN_FastNoiseLite]ZN_FastNoiseLite[/url] resource.\nNote: this node might be a little faster than [code]Noise3D[/code].\nIf [code]measured_bounds[/code] is enabled, range analysis also uses bounds measured by sampling the noise when the graph is compiled. They are often much tighter, so more blocks can be skipped as fully air or fully solid, but they are approximate: rare extremes of the noise may fall outside of them, and be missing from the terrain. Measuring samples the noise about 113,000 times per node, which slows down compilation."},
     {"FastNoiseGradient2D", "Noise", "Warps 2D coordinates [code](x, y)[/code] using a noise gradient from the FastNoiseLite library. The [code]noise[/code] parameter is specified with an instance of the [url=FastNoiseLiteGradient]FastNoiseLiteGradient[/url] resource."},
     {"FastNoiseGradient3D", "Noise", "Warps 3D coordinates [code](x, y, z)[/code] using a noise gradient from the FastNoiseLite library. The [code]noise[/code] parameter is specified with an instance of the [url=FastNoiseLiteGradient]FastNoiseLiteGradient[/url] resource."},
     {"Floor", "Math", "Returns the result of [code]floor(x)[/code], the nearest integer that is equal or lower to [code]x[/code]."},
@@ -41,8 +41,8 @@ static const Node g_data[COUNT] = {
     {"Min", "Math", "Returns the lowest value between [code]a[/code] and [code]b[/code]."},
     {"Mix", "Math", "Interpolates between [code]a[/code] and [code]b[/code], using parameter value [code]t[/code]. If [code]t[/code] is [code]0[/code], [code]a[/code] will be returned. If [code]t[/code] is [code]1[/code], [code]b[/code] will be returned. If [code]t[/code] is beyond the [code][0..1][/code] range, the returned value will be an extrapolation."},
     {"Multiply", "Ops", "Returns the result of [code]a * b[/code]."},
-    {"Noise2D", "Noise", "Returns 2D noise at coordinates `(x, y)` using one of the [url=Noise]Noise[/url] subclasses provided by Godot."},
-    {"Noise3D", "Noise", "Returns 3D noise at coordinates `(x, y, z)` using one of the [url=Noise]Noise[/url] subclasses provided by Godot."},
+    {"Noise2D", "Noise", "Returns 2D noise at coordinates `(x, y)` using one of the [url=Noise]Noise[/url] subclasses provided by Godot.\nIf [code]measured_bounds[/code] is enabled, range analysis also uses bounds measured by sampling the noise when the graph is compiled. They are often much tighter, so more blocks can be skipped as fully air or fully solid, but they are approximate: rare extremes of the noise may fall outside of them, and be missing from the terrain. Measuring samples the noise about 73,000 times per node, which slows down compilation."},
+    {"Noise3D", "Noise", "Returns 3D noise at coordinates `(x, y, z)` using one of the [url=Noise]Noise[/url] subclasses provided by Godot.\nIf [code]measured_bounds[/code] is enabled, range analysis also uses bounds measured by sampling the noise when the graph is compiled. They are often much tighter, so more blocks can be skipped as fully air or fully solid, but they are approximate: rare extremes of the noise may fall outside of them, and be missing from the terrain. Measuring samples the noise about 113,000 times per node, which slows down compilation."},
     {"Normalize", "Vector", "Returns the normalized coordinates of the given [code](x, y, z)[/code] 3D vector, such that the length of the output vector is 1."},
     {"OutputSDF", "Output", "Sets the Signed Distance Field value of the current voxel."},
     {"OutputSingleTexture", "Output", "Sets the texture index of the current voxel. This is an alternative to using [code]OutputWeight[/code] nodes, if your voxels only have one texture. This is easier to use but does not allow for long gradients. Using this node in combination with [code]OutputWeight[/code] is not supported."},
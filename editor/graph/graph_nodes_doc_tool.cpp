@@ -297,6 +297,9 @@ void run_graph_nodes_doc_tool(String src_xml_fpath, String dst_xml_fpath) {
 	// First populate with all known node types
 	for (int node_type_id = 0; node_type_id < type_db.get_type_count(); ++node_type_id) {
 		const pg::NodeType &type = type_db.get_type(node_type_id);
+		if (type.is_internal) {
+			continue;
+		}
 
 		GraphNodeDocumentation doc;
 		doc.name = type.name;
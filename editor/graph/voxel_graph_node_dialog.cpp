@@ -187,6 +187,9 @@ VoxelGraphNodeDialog::VoxelGraphNodeDialog() {
 	const pg::NodeTypeDB &type_db = pg::NodeTypeDB::get_singleton();
 	for (int type_index = 0; type_index < type_db.get_type_count(); ++type_index) {
 		const pg::NodeType &type = type_db.get_type(type_index);
+		if (type.is_internal) {
+			continue;
+		}
 
 		int category_index = -1;
 		String description;
@@ -1,10 +1,12 @@
 #include "vox_mesh_importer.h"
 #include "../../constants/voxel_string_names.h"
 #include "../../meshers/cubes/voxel_mesher_cubes.h"
+#include "../../storage/funcs.h"
 #include "../../storage/voxel_buffer.h"
 #include "../../storage/voxel_memory_pool.h"
 #include "../../streams/vox/vox_data.h"
 #include "../../util/dstack.h"
+#include "../../util/godot/classes/file_access.h"
 #include "../../util/godot/classes/image_texture.h"
 #include "../../util/godot/classes/resource_saver.h"
 #include "../../util/godot/classes/standard_material_3d.h"
@@ -13,6 +15,8 @@
 #include "../../util/math/conv.h"
 #include "../../util/memory/memory.h"
 #include "../../util/profiling.h"
+#include "../../util/tasks/threaded_task_runner.h"
+#include "../../util/thread/thread.h"
 #include "vox_import_funcs.h"
 
 using namespace zylann::godot;
@@ -76,7 +80,7 @@ bool VoxelVoxMeshImporter::_zn_get_option_visibility(
 }
 
 struct ForEachModelInstanceArgs {
-	const Model *model;
+	unsigned int model_index;
 	// Pivot position, which turns out to be at the center in MagicaVoxel
 	Vector3i position;
 	Basis basis;
@@ -109,7 +113,7 @@ Error for_each_model_instance_in_scene_graph(const Data &data, int node_id, Tran
 		case Node::TYPE_SHAPE: {
 			const ShapeNode *vox_shape_node = reinterpret_cast<const ShapeNode *>(vox_node);
 			ForEachModelInstanceArgs args;
-			args.model = &data.get_model(vox_shape_node->model_id);
+			args.model_index = vox_shape_node->model_id;
 			args.position = math::round_to_int(transform.origin);
 			args.basis = transform.basis;
 			f(args);
@@ -131,9 +135,9 @@ void for_each_model_instance(const Data &vox_data, F f) {
 	if (vox_data.get_root_node_id() == -1) {
 		// No scene graph
 		ForEachModelInstanceArgs args;
-		args.model = &vox_data.get_model(0);
+		args.model_index = 0;
 		// Put at center to match what MagicaVoxel would do
-		args.position = args.model->size / 2;
+		args.position = vox_data.get_model(0).size / 2;
 		args.basis = Basis();
 		f(args);
 		return;
@@ -144,66 +148,75 @@ void for_each_model_instance(const Data &vox_data, F f) {
 // Find intersecting or touching models, merge their voxels into the same grid, mesh the result, then combine meshes.
 
 struct ModelInstance {
-	// Model with baked rotation
-	UniquePtr<VoxelBuffer> voxels;
-	// Lowest corner position
-	Vector3i position;
+	unsigned int model_index;
+	IntBasis basis;
+	// Lowest corner position and size with rotation applied
+	Box3i box;
+	// Set if the instance overlaps another one, in which case it can't be decoded in parallel with it
+	bool overlaps = false;
 };
 
-void extract_model_instances(const Data &vox_data, StdVector<ModelInstance> &out_instances) {
+void gather_model_instances(const Data &vox_data, StdVector<ModelInstance> &out_instances) {
 	ZN_DSTACK();
-	// Gather all models and bake their rotations
-	for_each_model_instance(vox_data, [&out_instances](ForEachModelInstanceArgs args) {
-		ERR_FAIL_COND(args.model == nullptr);
-		const Model &model = *args.model;
-
-		Span<const uint8_t> src_color_indices;
-		Vector3i dst_size = model.size;
-
-		// Using temporary copy to rotate the data
-		StdVector<uint8_t> temp_voxels;
-
-		if (args.basis == Basis()) {
-			// No transformation
-			src_color_indices = to_span_const(model.color_indexes);
-		} else {
-			IntBasis basis;
-			basis.x = to_vec3i(args.basis.get_column(Vector3::AXIS_X));
-			basis.y = to_vec3i(args.basis.get_column(Vector3::AXIS_Y));
-			basis.z = to_vec3i(args.basis.get_column(Vector3::AXIS_Z));
-			temp_voxels.resize(model.color_indexes.size());
-			dst_size =
-					transform_3d_array_zxy(to_span_const(model.color_indexes), to_span(temp_voxels), model.size, basis);
-			src_color_indices = to_span_const(temp_voxels);
-		}
-
-		// TODO Optimization: implement transformation for VoxelBuffers so we can avoid using a temporary copy.
-		// Didn't do it yet because VoxelBuffers also have metadata and the `transform_3d_array_zxy` function only works
-		// on arrays.
-		UniquePtr<VoxelBuffer> voxels = make_unique_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
-		voxels->create(dst_size);
-		voxels->decompress_channel(VoxelBuffer::CHANNEL_COLOR);
-
-		Span<uint8_t> dst_color_indices;
-		ERR_FAIL_COND(!voxels->get_channel_as_bytes(VoxelBuffer::CHANNEL_COLOR, dst_color_indices));
-
-		CRASH_COND(src_color_indices.size() != dst_color_indices.size());
-		memcpy(dst_color_indices.data(), src_color_indices.data(), dst_color_indices.size() * sizeof(uint8_t));
+	// Only gathers transforms, voxels are decoded later directly into their final destination
+	for_each_model_instance(vox_data, [&out_instances, &vox_data](ForEachModelInstanceArgs args) {
+		const Model &model = vox_data.get_model(args.model_index);
 
 		ModelInstance mi;
-		mi.voxels = std::move(voxels);
-		mi.position = args.position - mi.voxels->get_size() / 2;
-		out_instances.push_back(std::move(mi));
+		mi.model_index = args.model_index;
+		mi.basis.x = to_vec3i(args.basis.get_column(Vector3::AXIS_X));
+		mi.basis.y = to_vec3i(args.basis.get_column(Vector3::AXIS_Y));
+		mi.basis.z = to_vec3i(args.basis.get_column(Vector3::AXIS_Z));
+
+		const Vector3i size = get_transformed_size(model.size, mi.basis);
+		mi.box = Box3i(args.position - size / 2, size);
+		out_instances.push_back(mi);
 	});
+
+	// Instances whose boxes don't intersect write to different voxels of the grid
+	for (unsigned int i = 0; i < out_instances.size(); ++i) {
+		ModelInstance &a = out_instances[i];
+		for (unsigned int j = i + 1; j < out_instances.size(); ++j) {
+			ModelInstance &b = out_instances[j];
+			if (a.box.intersects(b.box)) {
+				a.overlaps = true;
+				b.overlaps = true;
+			}
+		}
+	}
 }
 
-bool make_single_voxel_grid(Span<const ModelInstance> instances, Vector3i &out_origin, VoxelBuffer &out_voxels) {
+class DecodeModelInstanceTask : public IThreadedTask {
+public:
+	const Data *vox_data = nullptr;
+	const ModelInstance *instance = nullptr;
+	Span<const uint8_t> xyzi_bytes;
+	VoxelBuffer *dst = nullptr;
+	Vector3i dst_origin;
+	Error error = OK;
+
+	void run(ThreadedTaskContext &ctx) override {
+		error = vox_data->decode_model(instance->model_index, xyzi_bytes, instance->basis, *dst, dst_origin);
+	}
+
+	const char *get_debug_name() const override {
+		return "DecodeVoxModelInstance";
+	}
+};
+
+bool make_single_voxel_grid(
+		const Data &vox_data,
+		FileAccess &vox_file,
+		Span<const ModelInstance> instances,
+		Vector3i &out_origin,
+		VoxelBuffer &out_voxels
+) {
+	ZN_PROFILE_SCOPE();
+
 	// Determine total size
-	const ModelInstance &first_instance = instances[0];
-	Box3i bounding_box(first_instance.position, first_instance.voxels->get_size());
+	Box3i bounding_box = instances[0].box;
 	for (unsigned int instance_index = 1; instance_index < instances.size(); ++instance_index) {
-		const ModelInstance &mi = instances[instance_index];
-		bounding_box.merge_with(Box3i(mi.position, mi.voxels->get_size()));
+		bounding_box.merge_with(instances[instance_index].box);
 	}
 
 	// Extra sanity check
@@ -221,20 +234,52 @@ bool make_single_voxel_grid(Span<const ModelInstance> instances, Vector3i &out_o
 	out_voxels.set_channel_depth(VoxelBuffer::CHANNEL_COLOR, VoxelBuffer::DEPTH_8_BIT);
 	out_voxels.decompress_channel(VoxelBuffer::CHANNEL_COLOR);
 
+	// Reading is done with a single file handle, once per model even if it has several instances
+	StdVector<StdVector<uint8_t>> models_xyzi_bytes;
+	models_xyzi_bytes.resize(vox_data.get_model_count());
+	StdVector<bool> models_read;
+	models_read.resize(vox_data.get_model_count(), false);
+	for (const ModelInstance &mi : instances) {
+		if (models_read[mi.model_index]) {
+			continue;
+		}
+		const Error read_err = vox_data.read_model_voxels(vox_file, mi.model_index, models_xyzi_bytes[mi.model_index]);
+		ERR_FAIL_COND_V(read_err != OK, false);
+		models_read[mi.model_index] = true;
+	}
+
+	// Models are decoded in parallel, straight into the grid. Overlapping ones write to the same voxels, so they are
+	// decoded one after the other.
+	ThreadedTaskRunner runner;
+	runner.set_name("VoxImport");
+	runner.set_thread_count(
+			math::clamp(Thread::get_hardware_concurrency(), 1u, static_cast<unsigned int>(instances.size()))
+	);
+
 	for (unsigned int instance_index = 0; instance_index < instances.size(); ++instance_index) {
 		const ModelInstance &mi = instances[instance_index];
-		ERR_FAIL_COND_V(mi.voxels == nullptr, false);
-		out_voxels.copy_channel_from(
-				*mi.voxels,
-				Vector3i(),
-				mi.voxels->get_size(),
-				mi.position - bounding_box.position + Vector3iUtil::create(VoxelMesherCubes::PADDING),
-				VoxelBuffer::CHANNEL_COLOR
-		);
+		DecodeModelInstanceTask *task = ZN_NEW(DecodeModelInstanceTask);
+		task->vox_data = &vox_data;
+		task->instance = &mi;
+		task->xyzi_bytes = to_span_const(models_xyzi_bytes[mi.model_index]);
+		task->dst = &out_voxels;
+		task->dst_origin = mi.box.position - bounding_box.position + Vector3iUtil::create(VoxelMesherCubes::PADDING);
+		runner.enqueue(task, mi.overlaps);
 	}
 
+	runner.wait_for_all_tasks();
+
+	bool success = true;
+	runner.dequeue_completed_tasks([&success](IThreadedTask *task) {
+		DecodeModelInstanceTask *decode_task = static_cast<DecodeModelInstanceTask *>(task);
+		if (decode_task->error != OK) {
+			success = false;
+		}
+		ZN_DELETE(decode_task);
+	});
+
 	out_origin = bounding_box.position;
-	return true;
+	return success;
 }
 
 Error VoxelVoxMeshImporter::_zn_import(
@@ -252,7 +297,8 @@ Error VoxelVoxMeshImporter::_zn_import(
 	ERR_FAIL_INDEX_V(p_pivot_mode, PIVOT_MODES_COUNT, ERR_INVALID_PARAMETER);
 
 	Data vox_data;
-	const Error load_err = vox_data.load_from_file(p_source_file);
+	// Models are decoded later directly into the grid to mesh, instead of being loaded in intermediate arrays
+	const Error load_err = vox_data.load_from_file(p_source_file, false);
 	ERR_FAIL_COND_V(load_err != OK, load_err);
 
 	// Get color palette
@@ -273,21 +319,25 @@ Error VoxelVoxMeshImporter::_zn_import(
 	StdVector<unsigned int> surface_index_to_material;
 	{
 		StdVector<ModelInstance> model_instances;
-		extract_model_instances(vox_data, model_instances);
+		gather_model_instances(vox_data, model_instances);
+		ERR_FAIL_COND_V(model_instances.size() == 0, ERR_CANT_CREATE);
 
-		// From this point we no longer need vox data so we can free some memory
-		vox_data.clear();
+		Error open_err;
+		Ref<FileAccess> vox_file = godot::open_file(p_source_file, FileAccess::READ, open_err);
+		ERR_FAIL_COND_V(vox_file.is_null(), open_err);
 
 		// TODO Optimization: this approach uses a lot of memory, might fail on scenes with a large bounding box.
 		// One workaround would be to mesh the scene incrementally in chunks, giving up greedy meshing beyond 256 or so.
 		Vector3i bounding_box_origin;
 		VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
-		const bool single_grid_succeeded =
-				make_single_voxel_grid(to_span_const(model_instances), bounding_box_origin, voxels);
+		const bool single_grid_succeeded = make_single_voxel_grid(
+				vox_data, **vox_file, to_span_const(model_instances), bounding_box_origin, voxels
+		);
 		ERR_FAIL_COND_V(!single_grid_succeeded, ERR_CANT_CREATE);
 
 		// We no longer need these
 		model_instances.clear();
+		vox_data.clear();
 
 		Ref<VoxelMesherCubes> mesher;
 		mesher.instantiate();
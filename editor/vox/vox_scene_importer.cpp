@@ -1,8 +1,10 @@
 #include "vox_scene_importer.h"
 #include "../../constants/voxel_string_names.h"
 #include "../../meshers/cubes/voxel_mesher_cubes.h"
+#include "../../storage/funcs.h"
 #include "../../storage/voxel_buffer_gd.h"
 #include "../../streams/vox/vox_data.h"
+#include "../../util/godot/classes/file_access.h"
 #include "../../util/godot/classes/image_texture.h"
 #include "../../util/godot/classes/mesh_instance_3d.h"
 #include "../../util/godot/classes/packed_scene.h"
@@ -287,7 +289,8 @@ Error VoxelVoxSceneImporter::_zn_import(
 	const bool p_enable_baked_lighting = p_options.get("enable_baked_lighting");
 
 	magica::Data data;
-	const Error load_err = data.load_from_file(p_source_file);
+	// Models are decoded one by one when meshing them, so they don't all have to be in memory at once
+	const Error load_err = data.load_from_file(p_source_file, false);
 	ERR_FAIL_COND_V(load_err != OK, load_err);
 
 	StdVector<VoxMesh> meshes;
@@ -320,26 +323,33 @@ Error VoxelVoxSceneImporter::_zn_import(
 	}
 	materials[1]->set_transparency(StandardMaterial3D::TRANSPARENCY_ALPHA);
 
+	// All models are read with the same file handle
+	Error open_err;
+	Ref<FileAccess> vox_file = godot::open_file(p_source_file, FileAccess::READ, open_err);
+	ERR_FAIL_COND_V(vox_file.is_null(), open_err);
+	StdVector<uint8_t> xyzi_bytes;
+
 	// Build meshes from voxel models
 	for (unsigned int model_index = 0; model_index < data.get_model_count(); ++model_index) {
 		const magica::Model &model = data.get_model(model_index);
 
 		VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
 		voxels.create(model.size + Vector3iUtil::create(VoxelMesherCubes::PADDING * 2));
+		voxels.set_channel_depth(VoxelBuffer::CHANNEL_COLOR, VoxelBuffer::DEPTH_8_BIT);
 		voxels.decompress_channel(VoxelBuffer::CHANNEL_COLOR);
 
-		Span<uint8_t> dst_color_indices;
-		ERR_FAIL_COND_V(!voxels.get_channel_as_bytes(VoxelBuffer::CHANNEL_COLOR, dst_color_indices), ERR_BUG);
-		Span<const uint8_t> src_color_indices = to_span_const(model.color_indexes);
-		copy_3d_region_zxy(
-				dst_color_indices,
-				voxels.get_size(),
-				Vector3iUtil::create(VoxelMesherCubes::PADDING),
-				src_color_indices,
-				model.size,
-				Vector3i(),
-				model.size
+		const Error read_err = data.read_model_voxels(**vox_file, model_index, xyzi_bytes);
+		ERR_FAIL_COND_V(read_err != OK, read_err);
+
+		const IntBasis identity{ Vector3i(1, 0, 0), Vector3i(0, 1, 0), Vector3i(0, 0, 1) };
+		const Error decode_err = data.decode_model(
+				model_index,
+				to_span_const(xyzi_bytes),
+				identity,
+				voxels,
+				Vector3iUtil::create(VoxelMesherCubes::PADDING)
 		);
+		ERR_FAIL_COND_V(decode_err != OK, decode_err);
 
 		StdVector<unsigned int> surface_index_to_material;
 		Ref<Image> atlas;
@@ -127,6 +127,8 @@ void GenerateBlockTask::run_cpu_generation() {
 
 	Ref<VoxelGenerator> generator = _stream_dependency->generator;
 
+	// Each task is one block prioritized by distance, so this doesn't go through `generate_blocks`. Batching would
+	// have to group blocks by priority too (see LoadBlockDataTask).
 	VoxelGenerator::VoxelQueryData query_data{ *_voxels, origin_in_voxels, _lod_index };
 	const VoxelGenerator::Result result = generator->generate_block(query_data);
 	_max_lod_hint = result.max_lod_hint;
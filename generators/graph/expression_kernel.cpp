@@ -0,0 +1,429 @@
+#include "expression_kernel.h"
+#include "../../util/errors.h"
+#include "../../util/math/funcs.h"
+#include "voxel_graph_function.h"
+#include <limits>
+
+namespace zylann::voxel::pg {
+
+namespace {
+
+template <typename F>
+inline void run_unary(float *dst, const float *a, unsigned int count, F f) {
+	for (unsigned int i = 0; i < count; ++i) {
+		dst[i] = f(a[i]);
+	}
+}
+
+template <typename F>
+inline void run_binary(float *dst, const float *a, const float *b, unsigned int count, F f) {
+	for (unsigned int i = 0; i < count; ++i) {
+		dst[i] = f(a[i], b[i]);
+	}
+}
+
+template <typename F>
+inline void run_ternary(float *dst, const float *a, const float *b, const float *c, unsigned int count, F f) {
+	for (unsigned int i = 0; i < count; ++i) {
+		dst[i] = f(a[i], b[i], c[i]);
+	}
+}
+
+} // namespace
+
+void ExpressionKernel::clear() {
+	_instructions.clear();
+	_constants.clear();
+	_constant_chunks.clear();
+	_input_count = 0;
+}
+
+bool ExpressionKernel::compile(const ExpressionParser::Node &root, Span<const std::string_view> variables) {
+	clear();
+
+	if (root.type != ExpressionParser::Node::OPERATOR && root.type != ExpressionParser::Node::FUNCTION) {
+		return false;
+	}
+	if (variables.size() > MAX_INPUTS) {
+		return false;
+	}
+	_input_count = variables.size();
+
+	unsigned int temporary_count = 0;
+	uint8_t result_slot;
+	if (!compile_node(root, variables, temporary_count, result_slot)) {
+		clear();
+		return false;
+	}
+
+	// The last instruction computes the root of the expression, make it write to the output directly
+	ZN_ASSERT_RETURN_V(_instructions.size() > 0, false);
+	_instructions.back().dst = OUTPUT_SLOT;
+
+	_constant_chunks.resize(_constants.size() * CHUNK_SIZE);
+	for (unsigned int constant_index = 0; constant_index < _constants.size(); ++constant_index) {
+		const float v = _constants[constant_index];
+		for (unsigned int i = 0; i < CHUNK_SIZE; ++i) {
+			_constant_chunks[constant_index * CHUNK_SIZE + i] = v;
+		}
+	}
+
+	return true;
+}
+
+bool ExpressionKernel::compile_node(
+		const ExpressionParser::Node &node,
+		Span<const std::string_view> variables,
+		unsigned int &temporary_count,
+		uint8_t &out_slot
+) {
+	using namespace ExpressionParser;
+
+	FixedArray<const Node *, 3> args;
+	unsigned int arg_count = 0;
+	Instruction instruction;
+	instruction.power = 0;
+
+	switch (node.type) {
+		case Node::NUMBER: {
+			const float value = static_cast<const NumberNode &>(node).value;
+			for (unsigned int i = 0; i < _constants.size(); ++i) {
+				if (_constants[i] == value) {
+					out_slot = CONSTANT_SLOTS_BEGIN + i;
+					return true;
+				}
+			}
+			if (_constants.size() == MAX_CONSTANTS) {
+				return false;
+			}
+			out_slot = CONSTANT_SLOTS_BEGIN + _constants.size();
+			_constants.push_back(value);
+			return true;
+		}
+
+		case Node::VARIABLE: {
+			const std::string_view name = static_cast<const VariableNode &>(node).name;
+			for (unsigned int i = 0; i < variables.size(); ++i) {
+				if (variables[i] == name) {
+					out_slot = i;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		case Node::OPERATOR: {
+			const OperatorNode &onode = static_cast<const OperatorNode &>(node);
+			ZN_ASSERT_RETURN_V(onode.n0 != nullptr && onode.n1 != nullptr, false);
+			args[0] = onode.n0.get();
+			args[1] = onode.n1.get();
+			arg_count = 2;
+
+			switch (onode.op) {
+				case OperatorNode::ADD:
+					instruction.opcode = OP_ADD;
+					break;
+				case OperatorNode::SUBTRACT:
+					instruction.opcode = OP_SUBTRACT;
+					break;
+				case OperatorNode::MULTIPLY:
+					instruction.opcode = OP_MULTIPLY;
+					break;
+				case OperatorNode::DIVIDE:
+					instruction.opcode = OP_DIVIDE;
+					break;
+				case OperatorNode::POWER: {
+					instruction.opcode = OP_POW;
+					// Same as when expanding into graph nodes, constant positive integer powers are faster to compute
+					if (onode.n1->type == Node::NUMBER) {
+						const float p = static_cast<const NumberNode &>(*onode.n1).value;
+						const int pi = int(p);
+						if (Math::is_equal_approx(p, pi) && pi >= 0 && pi <= std::numeric_limits<uint16_t>::max()) {
+							instruction.opcode = OP_POWI;
+							instruction.power = pi;
+							arg_count = 1;
+						}
+					}
+				} break;
+				default:
+					return false;
+			}
+		} break;
+
+		case Node::FUNCTION: {
+			const FunctionNode &fnode = static_cast<const FunctionNode &>(node);
+			// Function IDs are the node types implementing them
+			switch (fnode.function_id) {
+				case VoxelGraphFunction::NODE_SIN:
+					instruction.opcode = OP_SIN;
+					arg_count = 1;
+					break;
+				case VoxelGraphFunction::NODE_FLOOR:
+					instruction.opcode = OP_FLOOR;
+					arg_count = 1;
+					break;
+				case VoxelGraphFunction::NODE_ABS:
+					instruction.opcode = OP_ABS;
+					arg_count = 1;
+					break;
+				case VoxelGraphFunction::NODE_SQRT:
+					instruction.opcode = OP_SQRT;
+					arg_count = 1;
+					break;
+				case VoxelGraphFunction::NODE_FRACT:
+					instruction.opcode = OP_FRACT;
+					arg_count = 1;
+					break;
+				case VoxelGraphFunction::NODE_STEPIFY:
+					instruction.opcode = OP_STEPIFY;
+					arg_count = 2;
+					break;
+				case VoxelGraphFunction::NODE_WRAP:
+					instruction.opcode = OP_WRAP;
+					arg_count = 2;
+					break;
+				case VoxelGraphFunction::NODE_MIN:
+					instruction.opcode = OP_MIN;
+					arg_count = 2;
+					break;
+				case VoxelGraphFunction::NODE_MAX:
+					instruction.opcode = OP_MAX;
+					arg_count = 2;
+					break;
+				case VoxelGraphFunction::NODE_CLAMP:
+					instruction.opcode = OP_CLAMP;
+					arg_count = 3;
+					break;
+				case VoxelGraphFunction::NODE_MIX:
+					instruction.opcode = OP_LERP;
+					arg_count = 3;
+					break;
+				default:
+					// Not supported by kernels
+					return false;
+			}
+			for (unsigned int i = 0; i < arg_count; ++i) {
+				ZN_ASSERT_RETURN_V(fnode.args[i] != nullptr, false);
+				args[i] = fnode.args[i].get();
+			}
+		} break;
+
+		default:
+			return false;
+	}
+
+	// Arguments are computed in temporaries above those already in use. Each of them keeps one temporary alive for
+	// its result, until this instruction consumes them. Its own result can then reuse the first one.
+	const unsigned int base_temporary = temporary_count;
+	for (unsigned int i = 0; i < instruction.args.size(); ++i) {
+		instruction.args[i] = 0;
+	}
+	for (unsigned int i = 0; i < arg_count; ++i) {
+		if (!compile_node(*args[i], variables, temporary_count, instruction.args[i])) {
+			return false;
+		}
+	}
+	if (base_temporary == MAX_TEMPORARIES) {
+		return false;
+	}
+	temporary_count = base_temporary + 1;
+	instruction.dst = TEMPORARY_SLOTS_BEGIN + base_temporary;
+	_instructions.push_back(instruction);
+
+	out_slot = instruction.dst;
+	return true;
+}
+
+void ExpressionKernel::process(Span<const Input> inputs, Span<float> out) const {
+	ZN_ASSERT_RETURN(inputs.size() >= _input_count);
+	ZN_ASSERT_RETURN(_instructions.size() > 0);
+
+	FixedArray<FixedArray<float, CHUNK_SIZE>, MAX_TEMPORARIES> temporaries;
+	// Inputs having the same value everywhere are read from chunks too
+	FixedArray<FixedArray<float, CHUNK_SIZE>, MAX_INPUTS> constant_inputs;
+
+	FixedArray<const float *, SLOT_COUNT> sources;
+	fill(sources, static_cast<const float *>(nullptr));
+	for (unsigned int i = 0; i < _input_count; ++i) {
+		if (inputs[i].data == nullptr) {
+			fill(constant_inputs[i], inputs[i].constant_value);
+			sources[i] = constant_inputs[i].data();
+		}
+	}
+	for (unsigned int i = 0; i < _constants.size(); ++i) {
+		sources[CONSTANT_SLOTS_BEGIN + i] = &_constant_chunks[i * CHUNK_SIZE];
+	}
+	for (unsigned int i = 0; i < MAX_TEMPORARIES; ++i) {
+		sources[TEMPORARY_SLOTS_BEGIN + i] = temporaries[i].data();
+	}
+
+	for (unsigned int chunk_begin = 0; chunk_begin < out.size(); chunk_begin += CHUNK_SIZE) {
+		const unsigned int count = math::min(CHUNK_SIZE, static_cast<unsigned int>(out.size() - chunk_begin));
+
+		for (unsigned int i = 0; i < _input_count; ++i) {
+			if (inputs[i].data != nullptr) {
+				sources[i] = inputs[i].data + chunk_begin;
+			}
+		}
+
+		for (const Instruction &instruction : _instructions) {
+			float *dst = instruction.dst == OUTPUT_SLOT ? out.data() + chunk_begin
+														: temporaries[instruction.dst - TEMPORARY_SLOTS_BEGIN].data();
+			const float *a = sources[instruction.args[0]];
+			const float *b = sources[instruction.args[1]];
+			const float *c = sources[instruction.args[2]];
+
+			// Same implementations as the corresponding graph nodes
+			switch (instruction.opcode) {
+				case OP_ADD:
+					run_binary(dst, a, b, count, [](float x, float y) { return x + y; });
+					break;
+				case OP_SUBTRACT:
+					run_binary(dst, a, b, count, [](float x, float y) { return x - y; });
+					break;
+				case OP_MULTIPLY:
+					run_binary(dst, a, b, count, [](float x, float y) { return x * y; });
+					break;
+				case OP_DIVIDE:
+					// Avoid NaNs caused by zeros
+					run_binary(dst, a, b, count, [](float x, float y) { return y == 0.f ? 0.f : x / y; });
+					break;
+				case OP_POW:
+					run_binary(dst, a, b, count, [](float x, float y) { return Math::pow(x, y); });
+					break;
+				case OP_POWI: {
+					const unsigned int power = instruction.power;
+					run_unary(dst, a, count, [power](float x) {
+						float v = 1.f;
+						for (unsigned int p = 0; p < power; ++p) {
+							v *= x;
+						}
+						return v;
+					});
+				} break;
+				case OP_SIN:
+					run_unary(dst, a, count, [](float x) { return Math::sin(x); });
+					break;
+				case OP_FLOOR:
+					run_unary(dst, a, count, [](float x) { return Math::floor(x); });
+					break;
+				case OP_ABS:
+					run_unary(dst, a, count, [](float x) { return Math::abs(x); });
+					break;
+				case OP_SQRT:
+					run_unary(dst, a, count, [](float x) { return Math::sqrt(math::max(x, 0.f)); });
+					break;
+				case OP_FRACT:
+					run_unary(dst, a, count, [](float x) { return x - Math::floor(x); });
+					break;
+				case OP_STEPIFY:
+					run_binary(dst, a, b, count, [](float x, float y) { return math::snappedf(x, y); });
+					break;
+				case OP_WRAP:
+					run_binary(dst, a, b, count, [](float x, float y) { return math::wrapf(x, y); });
+					break;
+				case OP_MIN:
+					run_binary(dst, a, b, count, [](float x, float y) { return math::min(x, y); });
+					break;
+				case OP_MAX:
+					run_binary(dst, a, b, count, [](float x, float y) { return math::max(x, y); });
+					break;
+				case OP_CLAMP:
+					run_ternary(dst, a, b, c, count, [](float x, float y, float z) { return math::clamp(x, y, z); });
+					break;
+				case OP_LERP:
+					run_ternary(dst, a, b, c, count, [](float x, float y, float z) { return Math::lerp(x, y, z); });
+					break;
+				default:
+					ZN_CRASH();
+					break;
+			}
+		}
+	}
+}
+
+math::Interval ExpressionKernel::analyze_range(Span<const math::Interval> inputs) const {
+	ZN_ASSERT_RETURN_V(inputs.size() >= _input_count, math::Interval());
+	ZN_ASSERT_RETURN_V(_instructions.size() > 0, math::Interval());
+
+	FixedArray<math::Interval, SLOT_COUNT> ranges;
+	for (unsigned int i = 0; i < _input_count; ++i) {
+		ranges[i] = inputs[i];
+	}
+	for (unsigned int i = 0; i < _constants.size(); ++i) {
+		ranges[CONSTANT_SLOTS_BEGIN + i] = math::Interval::from_single_value(_constants[i]);
+	}
+
+	for (const Instruction &instruction : _instructions) {
+		const math::Interval a = ranges[instruction.args[0]];
+		const math::Interval b = ranges[instruction.args[1]];
+		const math::Interval c = ranges[instruction.args[2]];
+		math::Interval &dst = ranges[instruction.dst];
+
+		switch (instruction.opcode) {
+			case OP_ADD:
+				dst = a + b;
+				break;
+			case OP_SUBTRACT:
+				dst = a - b;
+				break;
+			case OP_MULTIPLY:
+				if (instruction.args[0] == instruction.args[1]) {
+					// The two operands have the same source, so it is a square function
+					dst = math::squared(a);
+				} else {
+					dst = a * b;
+				}
+				break;
+			case OP_DIVIDE:
+				dst = a / b;
+				break;
+			case OP_POW:
+				dst = math::pow(a, b);
+				break;
+			case OP_POWI:
+				dst = math::powi(a, instruction.power);
+				break;
+			case OP_SIN:
+				dst = math::sin(a);
+				break;
+			case OP_FLOOR:
+				dst = math::floor(a);
+				break;
+			case OP_ABS:
+				dst = math::abs(a);
+				break;
+			case OP_SQRT:
+				dst = math::sqrt(a);
+				break;
+			case OP_FRACT:
+				dst = a - math::floor(a);
+				break;
+			case OP_STEPIFY:
+				dst = math::snapped(a, b);
+				break;
+			case OP_WRAP:
+				dst = math::wrapf(a, b);
+				break;
+			case OP_MIN:
+				dst = math::min_interval(a, b);
+				break;
+			case OP_MAX:
+				dst = math::max_interval(a, b);
+				break;
+			case OP_CLAMP:
+				dst = math::clamp(a, b, c);
+				break;
+			case OP_LERP:
+				dst = math::lerp(a, b, c);
+				break;
+			default:
+				ZN_CRASH();
+				break;
+		}
+	}
+
+	return ranges[OUTPUT_SLOT];
+}
+
+} // namespace zylann::voxel::pg
@@ -0,0 +1,95 @@
+#ifndef VOXEL_GRAPH_EXPRESSION_KERNEL_H
+#define VOXEL_GRAPH_EXPRESSION_KERNEL_H
+
+#include "../../util/containers/fixed_array.h"
+#include "../../util/containers/span.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/math/interval.h"
+#include "../../util/string/expression_parser.h"
+
+namespace zylann::voxel::pg {
+
+// Evaluates an expression over buffers in a single pass, instead of running one graph operation per operator or
+// function. Buffers are processed in chunks small enough to stay in cache, running every instruction of the expression
+// on each chunk in turn. Intermediate results then don't need buffers as large as those of the graph, and don't go
+// through main memory.
+class ExpressionKernel {
+public:
+	static const unsigned int MAX_INPUTS = 8;
+	static const unsigned int MAX_CONSTANTS = 32;
+	static const unsigned int MAX_TEMPORARIES = 16;
+	static const unsigned int CHUNK_SIZE = 64;
+
+	struct Input {
+		// If null, the input has the same value everywhere
+		const float *data;
+		float constant_value;
+	};
+
+	// Variables of the expression are bound to inputs in the order they are listed.
+	// Returns false if the expression can't be evaluated with a kernel. It then has to be expanded into graph nodes.
+	// This is also the case of expressions that are only a number or a variable.
+	bool compile(const ExpressionParser::Node &root, Span<const std::string_view> variables);
+
+	inline unsigned int get_input_count() const {
+		return _input_count;
+	}
+
+	// Input buffers must contain at least as many values as the output.
+	void process(Span<const Input> inputs, Span<float> out) const;
+
+	math::Interval analyze_range(Span<const math::Interval> inputs) const;
+
+private:
+	enum Opcode : uint8_t {
+		OP_ADD,
+		OP_SUBTRACT,
+		OP_MULTIPLY,
+		OP_DIVIDE,
+		OP_POW,
+		OP_POWI,
+		OP_SIN,
+		OP_FLOOR,
+		OP_ABS,
+		OP_SQRT,
+		OP_FRACT,
+		OP_STEPIFY,
+		OP_WRAP,
+		OP_MIN,
+		OP_MAX,
+		OP_CLAMP,
+		OP_LERP
+	};
+
+	// Instructions read from and write to slots, which are either inputs, constants, temporary results or the output.
+	static const unsigned int CONSTANT_SLOTS_BEGIN = MAX_INPUTS;
+	static const unsigned int TEMPORARY_SLOTS_BEGIN = CONSTANT_SLOTS_BEGIN + MAX_CONSTANTS;
+	static const unsigned int OUTPUT_SLOT = TEMPORARY_SLOTS_BEGIN + MAX_TEMPORARIES;
+	static const unsigned int SLOT_COUNT = OUTPUT_SLOT + 1;
+
+	struct Instruction {
+		Opcode opcode;
+		uint8_t dst;
+		FixedArray<uint8_t, 3> args;
+		// Exponent of OP_POWI
+		uint16_t power;
+	};
+
+	void clear();
+	bool compile_node(
+			const ExpressionParser::Node &node,
+			Span<const std::string_view> variables,
+			unsigned int &temporary_count,
+			uint8_t &out_slot
+	);
+
+	StdVector<Instruction> _instructions;
+	StdVector<float> _constants;
+	// Constants repeated to fill a chunk each, so they can be read like other slots
+	StdVector<float> _constant_chunks;
+	unsigned int _input_count = 0;
+};
+
+} // namespace zylann::voxel::pg
+
+#endif // VOXEL_GRAPH_EXPRESSION_KERNEL_H
@@ -81,6 +81,8 @@ struct NodeType {
 	bool debug_only = false;
 	// Pseudo nodes are replaced during compilation with one or multiple real nodes, they have no logic on their own
 	bool is_pseudo_node = false;
+	// Internal nodes are only created during compilation, they can't be added to graphs by users
+	bool is_internal = false;
 	Category category;
 	StdVector<Port> inputs;
 	StdVector<Port> outputs;
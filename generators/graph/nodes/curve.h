@@ -10,9 +10,8 @@ void register_curve_node(Span<NodeType> types) {
 
 	{
 		struct Params {
-			// TODO Should be `const` but isn't because it auto-bakes, and it's a concern for multithreading
-			Curve *curve;
-			const CurveRangeData *curve_range_data;
+			// Sampling the curve directly is slower, and it isn't thread-safe because it can auto-bake
+			const CurveLUT *lut;
 		};
 		NodeType &t = types[VoxelGraphFunction::NODE_CURVE];
 		t.name = "Curve";
@@ -36,35 +35,28 @@ void register_curve_node(Span<NodeType> types) {
 				ctx.make_error(String(ZN_TTR("{0} instance is null")).format(varray(Curve::get_class_static())));
 				return;
 			}
-			// Make sure it is baked. We don't want multithreading to bail out because of a write operation
-			// happening in `interpolate_baked`...
-			curve->bake();
-			CurveRangeData *curve_range_data = ZN_NEW(CurveRangeData);
-			get_curve_monotonic_sections(**curve, curve_range_data->sections);
+			CurveLUT *lut = ZN_NEW(CurveLUT);
+			bake_curve_lut(**curve, *lut);
 			Params p;
-			p.curve_range_data = curve_range_data;
-			p.curve = *curve;
+			p.lut = lut;
 			ctx.set_params(p);
-			ctx.add_delete_cleanup(curve_range_data);
+			ctx.add_delete_cleanup(lut);
 		};
 		t.process_buffer_func = [](Runtime::ProcessBufferContext &ctx) {
 			ZN_PROFILE_SCOPE_NAMED("NODE_CURVE");
 			const Runtime::Buffer &a = ctx.get_input(0);
 			Runtime::Buffer &out = ctx.get_output(0);
 			const Params p = ctx.get_params<Params>();
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = p.curve->sample_baked(a.data[i]);
-			}
+			p.lut->sample(Span<const float>(a.data, out.size), Span<float>(out.data, out.size));
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
 			const Params p = ctx.get_params<Params>();
 			if (a.is_single_value()) {
-				const float v = p.curve->sample_baked(a.min);
+				const float v = p.lut->sample(a.min);
 				ctx.set_output(0, Interval::from_single_value(v));
 			} else {
-				const Interval r = get_curve_range(*p.curve, p.curve_range_data->sections, a);
-				ctx.set_output(0, r);
+				ctx.set_output(0, p.lut->get_range(a));
 			}
 		};
 		t.shader_gen_func = [](ShaderGenContext &ctx) {
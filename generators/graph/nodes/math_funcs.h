@@ -526,9 +526,10 @@ void register_math_func_nodes(Span<NodeType> types) {
 					break;
 				default:
 					for (unsigned int i = 0; i < out.size; ++i) {
-						float v = x.data[i];
+						const float b = x.data[i];
+						float v = b;
 						for (unsigned int p = 1; p < power; ++p) {
-							v *= v;
+							v *= b;
 						}
 						out.data[i] = v;
 					}
@@ -1,3 +1,4 @@
+#include "../expression_kernel.h"
 #include "../node_type_db.h"
 
 namespace zylann::voxel::pg {
@@ -144,6 +145,69 @@ void register_misc_nodes(Span<NodeType> types) {
 		};
 		t.is_pseudo_node = true;
 	}
+	{
+		struct Params {
+			const ExpressionKernel *kernel;
+		};
+		NodeType &t = types[VoxelGraphFunction::NODE_EXPRESSION_KERNEL];
+		t.name = "ExpressionKernel";
+		t.category = CATEGORY_MATH;
+		t.is_internal = true;
+		NodeType::Param expression_param("expression", Variant::STRING, "0");
+		expression_param.hidden = true;
+		t.params.push_back(expression_param);
+		// Inputs are bound to variables in the order they appear in the expression
+		for (unsigned int i = 0; i < ExpressionKernel::MAX_INPUTS; ++i) {
+			t.inputs.push_back(NodeType::Port(
+					String("in") + String::num_int64(i), 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false
+			));
+		}
+		t.outputs.push_back(NodeType::Port("out"));
+		t.compile_func = [](CompileContext &ctx) {
+			const String code = ctx.get_param(0);
+			const CharString code_utf8 = code.utf8();
+			Span<const ExpressionParser::Function> functions =
+					NodeTypeDB::get_singleton().get_expression_parser_functions();
+			// Parsing again gives the same tree and variables as when the kernel node was created
+			const ExpressionParser::Result parse_result = ExpressionParser::parse(code_utf8.get_data(), functions);
+			StdVector<std::string_view> variables;
+			ExpressionKernel *kernel = nullptr;
+			if (parse_result.error.id == ExpressionParser::ERROR_NONE && parse_result.root != nullptr) {
+				ExpressionParser::find_variables(*parse_result.root, variables);
+				kernel = ZN_NEW(ExpressionKernel);
+				if (!kernel->compile(*parse_result.root, to_span_const(variables))) {
+					ZN_DELETE(kernel);
+					kernel = nullptr;
+				}
+			}
+			if (kernel == nullptr) {
+				ctx.make_error(ZN_TTR("Internal error, expression could not be compiled into a kernel"));
+				return;
+			}
+			Params p;
+			p.kernel = kernel;
+			ctx.set_params(p);
+			ctx.add_delete_cleanup(kernel);
+		};
+		t.process_buffer_func = [](Runtime::ProcessBufferContext &ctx) {
+			const ExpressionKernel &kernel = *ctx.get_params<Params>().kernel;
+			FixedArray<ExpressionKernel::Input, ExpressionKernel::MAX_INPUTS> inputs;
+			for (unsigned int i = 0; i < kernel.get_input_count(); ++i) {
+				const Runtime::Buffer &b = ctx.get_input(i);
+				inputs[i] = ExpressionKernel::Input{ b.is_constant ? nullptr : b.data, b.constant_value };
+			}
+			Runtime::Buffer &out = ctx.get_output(0);
+			kernel.process(to_span_const(inputs, kernel.get_input_count()), Span<float>(out.data, out.size));
+		};
+		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
+			const ExpressionKernel &kernel = *ctx.get_params<Params>().kernel;
+			FixedArray<Interval, ExpressionKernel::MAX_INPUTS> inputs;
+			for (unsigned int i = 0; i < kernel.get_input_count(); ++i) {
+				inputs[i] = ctx.get_input(i);
+			}
+			ctx.set_output(0, kernel.analyze_range(to_span_const(inputs, kernel.get_input_count())));
+		};
+	}
 }
 
 } // namespace zylann::voxel::pg
@@ -3,6 +3,7 @@
 #include "../../../util/noise/fast_noise_lite/fast_noise_lite.h"
 #include "../../../util/noise/fast_noise_lite/fast_noise_lite_range.h"
 #include "../../../util/noise/gd_noise_range.h"
+#include "../../../util/noise/noise_range_table.h"
 #include "../../../util/noise/spot_noise.h"
 #include "../../../util/profiling.h"
 #include "../node_type_db.h"
@@ -67,6 +68,54 @@ void add_fast_noise_lite_gradient_state_config(ShaderGenContext &ctx, const ZN_F
 			fnl.get_fractal_octaves(), fnl.get_fractal_gain(), 1.0 / fnl.get_period(), fnl.get_fractal_lacunarity());
 }
 
+// Measured bounds are approximate, and only used when the node opts in. They can only narrow down the analyzed bounds,
+// which remain authoritative.
+inline math::Interval intersect_noise_ranges(const math::Interval analyzed, const math::Interval measured) {
+	const real_t min_value = math::max(analyzed.min, measured.min);
+	const real_t max_value = math::min(analyzed.max, measured.max);
+	if (min_value > max_value) {
+		// Measures are wrong for this area
+		return analyzed;
+	}
+	return math::Interval(min_value, max_value);
+}
+
+NoiseRangeTable *create_noise_range_table_2d(Noise &noise) {
+	NoiseRangeTable *table = ZN_NEW(NoiseRangeTable);
+	table->generate_2d([&noise](Span<const float> x, Span<const float> y, Span<const float> z, Span<float> out) {
+		for (unsigned int i = 0; i < out.size(); ++i) {
+			out[i] = noise.get_noise_2d(x[i], y[i]);
+		}
+	});
+	return table;
+}
+
+NoiseRangeTable *create_noise_range_table_3d(Noise &noise) {
+	NoiseRangeTable *table = ZN_NEW(NoiseRangeTable);
+	table->generate_3d([&noise](Span<const float> x, Span<const float> y, Span<const float> z, Span<float> out) {
+		for (unsigned int i = 0; i < out.size(); ++i) {
+			out[i] = noise.get_noise_3d(x[i], y[i], z[i]);
+		}
+	});
+	return table;
+}
+
+NoiseRangeTable *create_noise_range_table_2d(const ZN_FastNoiseLite &noise) {
+	NoiseRangeTable *table = ZN_NEW(NoiseRangeTable);
+	table->generate_2d([&noise](Span<const float> x, Span<const float> y, Span<const float> z, Span<float> out) {
+		noise.get_noise_2d_series(x, y, out);
+	});
+	return table;
+}
+
+NoiseRangeTable *create_noise_range_table_3d(const ZN_FastNoiseLite &noise) {
+	NoiseRangeTable *table = ZN_NEW(NoiseRangeTable);
+	table->generate_3d([&noise](Span<const float> x, Span<const float> y, Span<const float> z, Span<float> out) {
+		noise.get_noise_3d_series(x, y, z, out);
+	});
+	return table;
+}
+
 void register_noise_nodes(Span<NodeType> types) {
 	using namespace math;
 
@@ -75,6 +124,7 @@ void register_noise_nodes(Span<NodeType> types) {
 			// TODO Cannot be `const` because of an oversight in Godot, but the devs are not sure to do it
 			// TODO We therefore have no guarantee it is thread-safe to use...
 			Noise *noise;
+			const NoiseRangeTable *range_table;
 		};
 
 		NodeType &t = types[VoxelGraphFunction::NODE_NOISE_2D];
@@ -85,6 +135,7 @@ void register_noise_nodes(Span<NodeType> types) {
 		t.outputs.push_back(NodeType::Port("out"));
 		t.params.push_back(
 				NodeType::Param("noise", Noise::get_class_static(), &create_resource_to_variant<FastNoiseLite>));
+		t.params.push_back(NodeType::Param("measured_bounds", Variant::BOOL, false));
 
 		t.compile_func = [](CompileContext &ctx) {
 			Ref<Noise> noise = ctx.get_param(0);
@@ -92,8 +143,15 @@ void register_noise_nodes(Span<NodeType> types) {
 				ctx.make_error(String(ZN_TTR("{0} instance is null")).format(varray(Noise::get_class_static())));
 				return;
 			}
+			Noise *noise_ptr = *noise;
 			Params p;
-			p.noise = *noise;
+			p.noise = noise_ptr;
+			p.range_table = nullptr;
+			if (static_cast<bool>(ctx.get_param(1))) {
+				NoiseRangeTable *range_table = create_noise_range_table_2d(*noise_ptr);
+				p.range_table = range_table;
+				ctx.add_delete_cleanup(range_table);
+			}
 			ctx.set_params(p);
 		};
 
@@ -113,7 +171,15 @@ void register_noise_nodes(Span<NodeType> types) {
 			const Interval y = ctx.get_input(1);
 			const Params p = ctx.get_params<Params>();
 			// Shouldn't be null, it is checked when the graph is compiled
-			ctx.set_output(0, get_range_2d(*p.noise, x, y));
+			const Interval analyzed = get_range_2d(*p.noise, x, y);
+			if (p.range_table == nullptr) {
+				ctx.set_output(0, analyzed);
+				return;
+			}
+			const Interval measured = p.range_table->get_range_2d(
+					[&p](real_t px, real_t py) { return p.noise->get_noise_2d(px, py); }, x, y
+			);
+			ctx.set_output(0, intersect_noise_ranges(analyzed, measured));
 		};
 
 		t.shader_gen_func = [](ShaderGenContext &ctx) {
@@ -146,6 +212,7 @@ void register_noise_nodes(Span<NodeType> types) {
 			// TODO Cannot be `const` because of an oversight in Godot, but the devs are not sure to do it
 			// TODO We therefore have no guarantee it is thread-safe to use...
 			Noise *noise;
+			const NoiseRangeTable *range_table;
 		};
 
 		NodeType &t = types[VoxelGraphFunction::NODE_NOISE_3D];
@@ -157,6 +224,7 @@ void register_noise_nodes(Span<NodeType> types) {
 		t.outputs.push_back(NodeType::Port("out"));
 		t.params.push_back(
 				NodeType::Param("noise", Noise::get_class_static(), &create_resource_to_variant<FastNoiseLite>));
+		t.params.push_back(NodeType::Param("measured_bounds", Variant::BOOL, false));
 
 		t.compile_func = [](CompileContext &ctx) {
 			Ref<Noise> noise = ctx.get_param(0);
@@ -164,8 +232,15 @@ void register_noise_nodes(Span<NodeType> types) {
 				ctx.make_error(String(ZN_TTR("{0} instance is null")).format(varray(Noise::get_class_static())));
 				return;
 			}
+			Noise *noise_ptr = *noise;
 			Params p;
-			p.noise = *noise;
+			p.noise = noise_ptr;
+			p.range_table = nullptr;
+			if (static_cast<bool>(ctx.get_param(1))) {
+				NoiseRangeTable *range_table = create_noise_range_table_3d(*noise_ptr);
+				p.range_table = range_table;
+				ctx.add_delete_cleanup(range_table);
+			}
 			ctx.set_params(p);
 		};
 
@@ -187,7 +262,15 @@ void register_noise_nodes(Span<NodeType> types) {
 			const Interval z = ctx.get_input(2);
 			const Params p = ctx.get_params<Params>();
 			// Shouldn't be null, it is checked when the graph is compiled
-			ctx.set_output(0, get_range_3d(*p.noise, x, y, z));
+			const Interval analyzed = get_range_3d(*p.noise, x, y, z);
+			if (p.range_table == nullptr) {
+				ctx.set_output(0, analyzed);
+				return;
+			}
+			const Interval measured = p.range_table->get_range_3d(
+					[&p](real_t px, real_t py, real_t pz) { return p.noise->get_noise_3d(px, py, pz); }, x, y, z
+			);
+			ctx.set_output(0, intersect_noise_ranges(analyzed, measured));
 		};
 
 		t.shader_gen_func = [](ShaderGenContext &ctx) {
@@ -219,6 +302,7 @@ void register_noise_nodes(Span<NodeType> types) {
 	{
 		struct Params {
 			const ZN_FastNoiseLite *noise;
+			const NoiseRangeTable *range_table;
 		};
 
 		NodeType &t = types[VoxelGraphFunction::NODE_FAST_NOISE_2D];
@@ -229,6 +313,7 @@ void register_noise_nodes(Span<NodeType> types) {
 		t.outputs.push_back(NodeType::Port("out"));
 		t.params.push_back(NodeType::Param(
 				"noise", ZN_FastNoiseLite::get_class_static(), &create_resource_to_variant<ZN_FastNoiseLite>));
+		t.params.push_back(NodeType::Param("measured_bounds", Variant::BOOL, false));
 
 		t.compile_func = [](CompileContext &ctx) {
 			Ref<ZN_FastNoiseLite> noise = ctx.get_param(0);
@@ -237,8 +322,15 @@ void register_noise_nodes(Span<NodeType> types) {
 						String(ZN_TTR("{0} instance is null")).format(varray(ZN_FastNoiseLite::get_class_static())));
 				return;
 			}
+			const ZN_FastNoiseLite *noise_ptr = *noise;
 			Params p;
-			p.noise = *noise;
+			p.noise = noise_ptr;
+			p.range_table = nullptr;
+			if (static_cast<bool>(ctx.get_param(1))) {
+				NoiseRangeTable *range_table = create_noise_range_table_2d(*noise_ptr);
+				p.range_table = range_table;
+				ctx.add_delete_cleanup(range_table);
+			}
 			ctx.set_params(p);
 		};
 
@@ -248,9 +340,11 @@ void register_noise_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &y = ctx.get_input(1);
 			Runtime::Buffer &out = ctx.get_output(0);
 			const Params p = ctx.get_params<Params>();
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = p.noise->get_noise_2d(x.data[i], y.data[i]);
-			}
+			p.noise->get_noise_2d_series(
+					Span<const float>(x.data, out.size),
+					Span<const float>(y.data, out.size),
+					Span<float>(out.data, out.size)
+			);
 		};
 
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
@@ -258,7 +352,15 @@ void register_noise_nodes(Span<NodeType> types) {
 			const Interval y = ctx.get_input(1);
 			const Params p = ctx.get_params<Params>();
 			// Shouldn't be null, it is checked when the graph is compiled
-			ctx.set_output(0, get_fnl_range_2d(*p.noise, x, y));
+			const Interval analyzed = get_fnl_range_2d(*p.noise, x, y);
+			if (p.range_table == nullptr) {
+				ctx.set_output(0, analyzed);
+				return;
+			}
+			const Interval measured = p.range_table->get_range_2d(
+					[&p](real_t px, real_t py) { return p.noise->get_noise_2d(px, py); }, x, y
+			);
+			ctx.set_output(0, intersect_noise_ranges(analyzed, measured));
 		};
 
 		t.shader_gen_func = [](ShaderGenContext &ctx) {
@@ -277,6 +379,7 @@ void register_noise_nodes(Span<NodeType> types) {
 	{
 		struct Params {
 			const ZN_FastNoiseLite *noise;
+			const NoiseRangeTable *range_table;
 		};
 
 		NodeType &t = types[VoxelGraphFunction::NODE_FAST_NOISE_3D];
@@ -288,6 +391,7 @@ void register_noise_nodes(Span<NodeType> types) {
 		t.outputs.push_back(NodeType::Port("out"));
 		t.params.push_back(NodeType::Param(
 				"noise", ZN_FastNoiseLite::get_class_static(), &create_resource_to_variant<ZN_FastNoiseLite>));
+		t.params.push_back(NodeType::Param("measured_bounds", Variant::BOOL, false));
 
 		t.compile_func = [](CompileContext &ctx) {
 			Ref<ZN_FastNoiseLite> noise = ctx.get_param(0);
@@ -296,8 +400,15 @@ void register_noise_nodes(Span<NodeType> types) {
 						String(ZN_TTR("{0} instance is null")).format(varray(ZN_FastNoiseLite::get_class_static())));
 				return;
 			}
+			const ZN_FastNoiseLite *noise_ptr = *noise;
 			Params p;
-			p.noise = *noise;
+			p.noise = noise_ptr;
+			p.range_table = nullptr;
+			if (static_cast<bool>(ctx.get_param(1))) {
+				NoiseRangeTable *range_table = create_noise_range_table_3d(*noise_ptr);
+				p.range_table = range_table;
+				ctx.add_delete_cleanup(range_table);
+			}
 			ctx.set_params(p);
 		};
 
@@ -308,9 +419,12 @@ void register_noise_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &z = ctx.get_input(2);
 			Runtime::Buffer &out = ctx.get_output(0);
 			const Params p = ctx.get_params<Params>();
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = p.noise->get_noise_3d(x.data[i], y.data[i], z.data[i]);
-			}
+			p.noise->get_noise_3d_series(
+					Span<const float>(x.data, out.size),
+					Span<const float>(y.data, out.size),
+					Span<const float>(z.data, out.size),
+					Span<float>(out.data, out.size)
+			);
 		};
 
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
@@ -319,7 +433,15 @@ void register_noise_nodes(Span<NodeType> types) {
 			const Interval z = ctx.get_input(2);
 			const Params p = ctx.get_params<Params>();
 			// Shouldn't be null, it is checked when the graph is compiled
-			ctx.set_output(0, get_fnl_range_3d(*p.noise, x, y, z));
+			const Interval analyzed = get_fnl_range_3d(*p.noise, x, y, z);
+			if (p.range_table == nullptr) {
+				ctx.set_output(0, analyzed);
+				return;
+			}
+			const Interval measured = p.range_table->get_range_3d(
+					[&p](real_t px, real_t py, real_t pz) { return p.noise->get_noise_3d(px, py, pz); }, x, y, z
+			);
+			ctx.set_output(0, intersect_noise_ranges(analyzed, measured));
 		};
 
 		t.shader_gen_func = [](ShaderGenContext &ctx) {
@@ -652,10 +774,15 @@ void register_noise_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &spot_size = ctx.get_input(2);
 			Runtime::Buffer &out = ctx.get_output(0);
 			const Params params = ctx.get_params<Params>();
-			for (unsigned int i = 0; i < out.size; ++i) {
-				out.data[i] = SpotNoise::spot_noise_2d(Vector2f(x.data[i], y.data[i]), params.cell_size,
-						spot_size.data[i], params.jitter, params.seed);
-			}
+			SpotNoise::spot_noise_2d_series(
+					Span<const float>(x.data, out.size),
+					Span<const float>(y.data, out.size),
+					Span<const float>(spot_size.data, out.size),
+					params.cell_size,
+					params.jitter,
+					params.seed,
+					Span<float>(out.data, out.size)
+			);
 		};
 
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
@@ -738,10 +865,16 @@ void register_noise_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &spot_size = ctx.get_input(3);
 			Runtime::Buffer &out = ctx.get_output(0);
 			const Params params = ctx.get_params<Params>();
-			for (unsigned int i = 0; i < out.size; ++i) {
-				out.data[i] = SpotNoise::spot_noise_3d(Vector3f(x.data[i], y.data[i], z.data[i]), params.cell_size,
-						spot_size.data[i], params.jitter, params.seed);
-			}
+			SpotNoise::spot_noise_3d_series(
+					Span<const float>(x.data, out.size),
+					Span<const float>(y.data, out.size),
+					Span<const float>(z.data, out.size),
+					Span<const float>(spot_size.data, out.size),
+					params.cell_size,
+					params.jitter,
+					params.seed,
+					Span<float>(out.data, out.size)
+			);
 		};
 
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
@@ -1716,6 +1716,67 @@ VoxelSingleValue VoxelGeneratorGraph::generate_single(Vector3i position, unsigne
 	}
 }
 
+void VoxelGeneratorGraph::generate_single_batch(
+		Span<const Vector3i> positions,
+		unsigned int channel,
+		Span<VoxelSingleValue> out_values
+) {
+	ZN_ASSERT_RETURN(positions.size() == out_values.size());
+
+	if (channel != VoxelBuffer::CHANNEL_SDF || positions.size() <= 1) {
+		// Other channels need decoding per voxel, which `generate_single` already does
+		VoxelGenerator::generate_single_batch(positions, channel, out_values);
+		return;
+	}
+
+	std::shared_ptr<const Runtime> runtime_ptr;
+	{
+		RWLockRead rlock(_runtime_lock);
+		runtime_ptr = _runtime;
+	}
+	ERR_FAIL_COND(runtime_ptr == nullptr);
+
+	if (runtime_ptr->sdf_output_buffer_index == -1) {
+		VoxelSingleValue v;
+		v.i = 0;
+		out_values.fill(v);
+		return;
+	}
+
+	// Run all positions as one series, which is much cheaper than running the graph for each of them
+	Cache &cache = get_tls_cache();
+	const unsigned int count = positions.size();
+	cache.x_cache.resize(count);
+	cache.y_cache.resize(count);
+	cache.z_cache.resize(count);
+	for (unsigned int i = 0; i < count; ++i) {
+		const Vector3i pos = positions[i];
+		cache.x_cache[i] = pos.x;
+		cache.y_cache[i] = pos.y;
+		cache.z_cache[i] = pos.z;
+	}
+
+	Span<float> in_sdf;
+	if (runtime_ptr->sdf_input_index != -1) {
+		cache.input_sdf_full_cache.resize(count);
+		in_sdf = to_span(cache.input_sdf_full_cache);
+		in_sdf.fill(0.f);
+	}
+
+	QueryInputs inputs(*runtime_ptr, to_span(cache.x_cache), to_span(cache.y_cache), to_span(cache.z_cache), in_sdf);
+
+	const pg::Runtime &runtime = runtime_ptr->runtime;
+	runtime.prepare_state(cache.state, count, false);
+	runtime.generate_set(cache.state, inputs.get(), false, nullptr);
+
+	const pg::Runtime::Buffer &buffer = cache.state.get_buffer(runtime_ptr->sdf_output_buffer_index);
+	ERR_FAIL_COND(buffer.size < count);
+	ERR_FAIL_COND(buffer.data == nullptr);
+	for (unsigned int i = 0; i < count; ++i) {
+		out_values[i].f = buffer.data[i];
+	}
+}
+
 // Note, this wrapper may not be used for main generation tasks.
 // It is mostly used as a debug tool.
 math::Interval VoxelGeneratorGraph::debug_analyze_range(Vector3i min_pos, Vector3i max_pos, bool optimize_execution_map)
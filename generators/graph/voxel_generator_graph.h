@@ -72,6 +72,11 @@ public:
 		return true;
 	}
 	VoxelSingleValue generate_single(Vector3i position, unsigned int channel) override;
+	void generate_single_batch(
+			Span<const Vector3i> positions,
+			unsigned int channel,
+			Span<VoxelSingleValue> out_values
+	) override;
 
 	void generate_series(
 			Span<const float> positions_x,
@@ -7,6 +7,7 @@
 #include "../../util/profiling.h"
 #include "../../util/string/expression_parser.h"
 #include "../../util/string/format.h"
+#include "expression_kernel.h"
 #include "node_type_db.h"
 #include "voxel_graph_function.h"
 
@@ -302,12 +303,51 @@ uint32_t expand_node(
 	}
 }
 
+// Creates a single node evaluating the whole expression, if it is supported by kernels.
+// Returns the ID of that node, or NULL_ID if the expression has to be expanded into multiple nodes.
+uint32_t create_expression_kernel_node(
+		ProgramGraph &graph,
+		const ProgramGraph::Node &original_node,
+		const ExpressionParser::Node &root,
+		const NodeTypeDB &db,
+		StdVector<ToConnect> &to_connect
+) {
+	StdVector<std::string_view> variables;
+	ExpressionParser::find_variables(root, variables);
+
+	ExpressionKernel kernel;
+	if (!kernel.compile(root, to_span_const(variables))) {
+		return ProgramGraph::NULL_ID;
+	}
+
+	ProgramGraph::Node &pg_node = create_node(graph, db, VoxelGraphFunction::NODE_EXPRESSION_KERNEL);
+	ZN_ASSERT(pg_node.params.size() == 1);
+	// The kernel is compiled again from the expression in the compilation stage
+	pg_node.params[0] = original_node.params[0];
+
+	for (unsigned int var_index = 0; var_index < variables.size(); ++var_index) {
+		const std::string_view var_name = variables[var_index];
+		to_connect.push_back({ var_name, { pg_node.id, var_index } });
+
+		// Unconnected variables use the default value of their port
+		unsigned int original_port_index;
+		if (original_node.find_input_port_by_name(var_name, original_port_index) &&
+			original_port_index < original_node.default_inputs.size()) {
+			ZN_ASSERT(var_index < pg_node.default_inputs.size());
+			pg_node.default_inputs[var_index] = original_node.default_inputs[original_port_index];
+		}
+	}
+
+	return pg_node.id;
+}
+
 CompilationResult expand_expression_node(
 		ProgramGraph &graph,
 		uint32_t original_node_id,
 		ProgramGraph::PortLocation &expanded_output_port,
 		StdVector<uint32_t> &expanded_nodes,
-		const NodeTypeDB &type_db
+		const NodeTypeDB &type_db,
+		bool use_kernels
 ) {
 	ZN_PROFILE_SCOPE();
 	const ProgramGraph::Node &original_node = graph.get_node(original_node_id);
@@ -342,9 +382,21 @@ CompilationResult expand_expression_node(
 
 	StdVector<ToConnect> to_connect;
 
-	// Create nodes from the expression's AST and connect them together
-	const uint32_t expanded_root_node_id =
-			expand_node(graph, *parse_result.root, type_db, to_connect, expanded_nodes, functions);
+	uint32_t expanded_root_node_id = ProgramGraph::NULL_ID;
+
+	if (use_kernels) {
+		// Evaluating the expression in one node is faster than running one node per operation
+		expanded_root_node_id =
+				create_expression_kernel_node(graph, original_node, *parse_result.root, type_db, to_connect);
+		if (expanded_root_node_id != ProgramGraph::NULL_ID) {
+			expanded_nodes.push_back(expanded_root_node_id);
+		}
+	}
+
+	if (expanded_root_node_id == ProgramGraph::NULL_ID) {
+		// Create nodes from the expression's AST and connect them together
+		expanded_root_node_id = expand_node(graph, *parse_result.root, type_db, to_connect, expanded_nodes, functions);
+	}
 	if (expanded_root_node_id == ProgramGraph::NULL_ID) {
 		CompilationResult result;
 		result.success = false;
@@ -393,7 +445,8 @@ CompilationResult expand_expression_node(
 CompilationResult expand_expression_nodes(
 		ProgramGraph &graph,
 		const NodeTypeDB &type_db,
-		GraphRemappingInfo *remap_info
+		GraphRemappingInfo *remap_info,
+		bool use_kernels
 ) {
 	ZN_PROFILE_SCOPE();
 	const unsigned int initial_node_count = graph.get_nodes_count();
@@ -412,7 +465,7 @@ CompilationResult expand_expression_nodes(
 		ProgramGraph::PortLocation expanded_output_port;
 		expanded_node_ids.clear();
 		const CompilationResult result =
-				expand_expression_node(graph, node_id, expanded_output_port, expanded_node_ids, type_db);
+				expand_expression_node(graph, node_id, expanded_output_port, expanded_node_ids, type_db, use_kernels);
 		if (!result.success) {
 			return result;
 		}
@@ -1183,7 +1236,8 @@ CompilationResult expand_graph(
 		Span<const VoxelGraphFunction::Port> input_defs,
 		StdVector<uint32_t> *input_node_ids,
 		const NodeTypeDB &type_db,
-		GraphRemappingInfo *remap_info
+		GraphRemappingInfo *remap_info,
+		bool use_expression_kernels
 ) {
 	ZN_PROFILE_SCOPE();
 	// First make a copy of the graph which we'll modify
@@ -1198,7 +1252,8 @@ CompilationResult expand_graph(
 
 	remove_relays(expanded_graph, remap_info);
 
-	const CompilationResult expr_expand_result = expand_expression_nodes(expanded_graph, type_db, remap_info);
+	const CompilationResult expr_expand_result =
+			expand_expression_nodes(expanded_graph, type_db, remap_info, use_expression_kernels);
 	if (!expr_expand_result.success) {
 		return expr_expand_result;
 	}
@@ -1214,7 +1269,7 @@ CompilationResult expand_graph(
 	return expr_expand_result;
 }
 
-CompilationResult Runtime::compile(const VoxelGraphFunction &function, bool debug) {
+CompilationResult Runtime::compile(const VoxelGraphFunction &function, bool debug, bool use_expression_kernels) {
 	ZN_PROFILE_SCOPE();
 
 	const NodeTypeDB &type_db = NodeTypeDB::get_singleton();
@@ -1223,8 +1278,15 @@ CompilationResult Runtime::compile(const VoxelGraphFunction &function, bool debu
 	ProgramGraph expanded_graph;
 	StdVector<uint32_t> input_node_ids;
 	Span<const VoxelGraphFunction::Port> input_defs = function.get_input_definitions();
-	CompilationResult expand_result =
-			expand_graph(function.get_graph(), expanded_graph, input_defs, &input_node_ids, type_db, &remap_info);
+	CompilationResult expand_result = expand_graph(
+			function.get_graph(),
+			expanded_graph,
+			input_defs,
+			&input_node_ids,
+			type_db,
+			&remap_info,
+			use_expression_kernels
+	);
 	if (!expand_result.success) {
 		expand_result.node_id = get_original_node_id(remap_info, expand_result.node_id);
 		return expand_result;
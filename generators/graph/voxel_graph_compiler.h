@@ -28,13 +28,16 @@ struct GraphRemappingInfo {
 
 // Pre-processes the graph and applies some optimizations before doing the main compilation pass.
 // This can involve some nodes getting removed or replaced with new ones.
+// If `use_expression_kernels` is true, expressions are replaced with kernel nodes evaluating them in one pass when
+// possible, instead of being expanded into one node per operation. Only the CPU runtime supports these nodes.
 CompilationResult expand_graph(
 		const ProgramGraph &graph,
 		ProgramGraph &expanded_graph,
 		Span<const VoxelGraphFunction::Port> input_defs,
 		StdVector<uint32_t> *input_node_ids,
 		const NodeTypeDB &type_db,
-		GraphRemappingInfo *remap_info
+		GraphRemappingInfo *remap_info,
+		bool use_expression_kernels
 );
 
 // Functions usable by node implementations during the compilation stage
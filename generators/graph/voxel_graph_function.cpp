@@ -304,6 +304,7 @@ ProgramGraph::Node *duplicate_node(
 
 uint32_t VoxelGraphFunction::create_node(NodeTypeID type_id, Vector2 position, uint32_t id) {
 	ERR_FAIL_COND_V(!NodeTypeDB::get_singleton().is_valid_type_id(type_id), ProgramGraph::NULL_ID);
+	ERR_FAIL_COND_V(NodeTypeDB::get_singleton().get_type(type_id).is_internal, ProgramGraph::NULL_ID);
 	ProgramGraph::Node *node = create_node_internal(_graph, type_id, position, id, true);
 	ERR_FAIL_COND_V(node == nullptr, ProgramGraph::NULL_ID);
 	// Register resources if any were created by default
@@ -973,6 +974,7 @@ bool load_graph_from_variant_data(ProgramGraph &graph, Dictionary data, String r
 		const Vector2 gui_position = node_data["gui_position"];
 		VoxelGraphFunction::NodeTypeID type_id;
 		ERR_FAIL_COND_V(!type_db.try_get_type_id_from_name(type_name, type_id), false);
+		ERR_FAIL_COND_V(type_db.get_type(type_id).is_internal, false);
 		// Don't create default param values, they will be assigned from serialized data
 		ProgramGraph::Node *node = create_node_internal(graph, type_id, gui_position, id, false);
 		ERR_FAIL_COND_V(node == nullptr, false);
@@ -1379,14 +1381,14 @@ void VoxelGraphFunction::update_function_nodes(StdVector<ProgramGraph::Connectio
 	});
 }
 
-pg::CompilationResult VoxelGraphFunction::compile(bool debug) {
+pg::CompilationResult VoxelGraphFunction::compile(bool debug, bool use_expression_kernels) {
 	std::shared_ptr<CompiledGraph> compiled_graph = make_shared_instance<CompiledGraph>();
 
 	if (_automatic_io_setup_enabled) {
 		auto_pick_inputs_and_outputs();
 	}
 
-	pg::CompilationResult result = compiled_graph->runtime.compile(*this, debug);
+	pg::CompilationResult result = compiled_graph->runtime.compile(*this, debug, use_expression_kernels);
 	_last_compiling_result = result;
 
 	if (!result.success) {
@@ -1864,6 +1866,7 @@ void VoxelGraphFunction::_bind_methods() {
 	BIND_ENUM_CONSTANT(NODE_RELAY);
 	BIND_ENUM_CONSTANT(NODE_SPOTS_2D);
 	BIND_ENUM_CONSTANT(NODE_SPOTS_3D);
+	BIND_ENUM_CONSTANT(NODE_EXPRESSION_KERNEL);
 	BIND_ENUM_CONSTANT(NODE_TYPE_COUNT);
 #ifdef VOXEL_ENABLE_FAST_NOISE_2
 	BIND_ENUM_CONSTANT(NODE_FAST_NOISE_2_2D);
@@ -83,6 +83,7 @@ public:
 		NODE_RELAY,
 		NODE_SPOTS_2D,
 		NODE_SPOTS_3D,
+		NODE_EXPRESSION_KERNEL, // Internal, created when compiling expressions
 
 	// Optional features down (to avoid diffs in docs when building both versions)
 	// Keep in mind this enum's values should not be used in persistent context (saves)
@@ -260,7 +261,8 @@ public:
 
 	// Compiling and running
 
-	pg::CompilationResult compile(bool debug);
+	// `use_expression_kernels` can be turned off to compare kernels with expanded expressions
+	pg::CompilationResult compile(bool debug, bool use_expression_kernels = true);
 	void execute(Span<Span<float>> inputs, Span<Span<float>> outputs);
 
 	bool is_compiled() const;
@@ -205,7 +205,9 @@ public:
 	~Runtime();
 
 	void clear();
-	CompilationResult compile(const VoxelGraphFunction &function, bool debug);
+	// Expressions are evaluated with kernels when possible. Turning them off expands all expressions into nodes,
+	// which is only useful to compare results.
+	CompilationResult compile(const VoxelGraphFunction &function, bool debug, bool use_expression_kernels = true);
 
 	// Call this before you use a state with generation functions.
 	// You need to call it once, until you want to use a different graph, buffer size or buffer count.
@@ -41,7 +41,7 @@ CompilationResult generate_shader(const ProgramGraph &p_graph, Span<const VoxelG
 
 	ProgramGraph expanded_graph;
 	const CompilationResult expand_result =
-			expand_graph(p_graph, expanded_graph, input_defs, nullptr, type_db, nullptr);
+			expand_graph(p_graph, expanded_graph, input_defs, nullptr, type_db, nullptr, false);
 	if (!expand_result.success) {
 		return expand_result;
 	}
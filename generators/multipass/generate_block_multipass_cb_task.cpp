@@ -64,17 +64,7 @@ void GenerateBlockMultipassCBTask::run(zylann::ThreadedTaskContext &ctx) {
 		const Vector2i column_position(_block_position.x, _block_position.z);
 		// TODO Candidate for postponing? Lots of them, might cause contention
 		SpatialLock2D::Read srlock(map.spatial_lock, BoxBounds2i::from_position(column_position));
-		VoxelGeneratorMultipassCBStructs::Column *column = nullptr;
-		{
-			MutexLock mlock(map.mutex);
-			auto column_it = map.columns.find(column_position);
-			if (column_it == map.columns.end()) {
-				// Drop, for some reason it wasn't available
-				return;
-			}
-
-			column = &column_it->second;
-		}
+		VoxelGeneratorMultipassCBStructs::Column *column = map.find_column(column_position);
 
 		if (column == nullptr) {
 			// Drop.
@@ -6,6 +6,7 @@
 #include "../../util/dstack.h"
 #include "../../util/godot/classes/time.h"
 #include "../../util/string/format.h"
+#include "load_column_multipass_task.h"
 
 namespace zylann::voxel {
 
@@ -98,12 +99,13 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 					map.spatial_lock, BoxBounds2i::from_position(_column_position)
 			);
 
-			MutexLock mlock(map.mutex);
-			auto column_it = map.columns.find(_column_position);
-			if (column_it != map.columns.end()) {
+			Column *column_ptr = map.find_column(_column_position);
+			if (column_ptr != nullptr) {
 				// Unregister task from the column
-				Column &column = column_it->second;
+				Column &column = *column_ptr;
 				column.pending_subpass_tasks_mask &= ~(1 << _subpass_index);
+				// Tasks waiting for us must look for another way to get their dependency
+				schedule_waiting_tasks(column, task_scheduler);
 
 				if (_subpass_index == final_subpass_index) {
 					// Schedule pending block requests to make them handle cancellation
@@ -119,6 +121,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 
 	const int pass_index = VoxelGeneratorMultipassCB::get_pass_index_from_subpass(_subpass_index);
 	const Pass &pass = _generator_internal->passes[pass_index];
+	PassStatistics &pass_statistics = _generator_internal->pass_statistics[pass_index];
 
 	if (_subpass_index == 0) {
 		// The first subpass can't depend on another subpass
@@ -149,6 +152,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 		if (!map.spatial_lock.try_lock_write(neighbors_box)) {
 			// Try later
 			ctx.status = ThreadedTaskContext::STATUS_POSTPONED;
+			++pass_statistics.postpone_count;
 			return;
 		}
 		// Sometimes I wish `defer` was a thing in C++
@@ -158,18 +162,9 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 		{
 			ZN_PROFILE_SCOPE_NAMED("Fetch columns");
 
-			// TODO We don't create new columns from here, could use a shared lock?
-			MutexLock mlock(map.mutex);
-
-			Vector2i bpos;
 			// Coordinate order matters (note, Y in Vector2i corresponds to Z in 3D here).
-			neighbors_box.for_each_cell_yx([&columns, &map](Vector2i cpos) {
-				auto it = map.columns.find(cpos);
-				Column *column = nullptr;
-				if (it != map.columns.end()) {
-					column = &it->second;
-				}
-				columns.push_back(column);
+			neighbors_box.for_each_cell_yx([&columns, &map](Vector2i cpos) { //
+				columns.push_back(map.find_column(cpos));
 			});
 		}
 
@@ -180,6 +175,8 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 
 		bool spawned_subtasks = false;
 		bool postpone = false;
+		// Column on which another task is processing a dependency we need
+		Column *waited_column = nullptr;
 
 		// Check loading levels
 		{
@@ -198,6 +195,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 
 					if (main_column != nullptr) {
 						main_column->pending_subpass_tasks_mask &= ~(1 << _subpass_index);
+						schedule_waiting_tasks(*main_column, task_scheduler);
 
 						if (_subpass_index == final_subpass_index) {
 							// Schedule pending block requests to make them handle cancellation
@@ -232,12 +230,12 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 							postpone = true;
 
 						} else if ((column->pending_subpass_tasks_mask & (1 << prev_subpass_index)) != 0) {
-							// A task is pending to work on the dependency, so we wait.
-							// TODO Ideally we should subscribe to the completion of that task.
-							// We can do that
+							// A task is pending to work on the dependency, so we wait for it to finish.
 							// println(format("O {} {} {} {} {}", int(_subpass_index), _column_position.x, 0,
 							// 		_column_position.y, Time::get_singleton()->get_ticks_usec()));
-							postpone = true;
+							if (waited_column == nullptr) {
+								waited_column = column;
+							}
 
 						} else {
 							// No task is pending to work on the dependency, spawn one.
@@ -283,8 +281,19 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 
 		} else if (postpone) {
 			ctx.status = ThreadedTaskContext::STATUS_POSTPONED;
+			++pass_statistics.postpone_count;
 			return;
 
+		} else if (waited_column != nullptr) {
+			// Instead of polling until the dependency is ready, get scheduled again when the task working on it
+			// finishes. We only register to one column, otherwise we could be scheduled more than once. If other
+			// dependencies are still pending when we come back, we will wait again.
+			// The task working on the column can't finish before we registered, because it needs to lock the same
+			// column.
+			waited_column->waiting_tasks.push_back(this);
+			ctx.status = ThreadedTaskContext::STATUS_TAKEN_OUT;
+			++pass_statistics.wait_count;
+
 		} else {
 			ZN_PROFILE_SCOPE_NAMED("Run pass");
 			// We can run the pass
@@ -294,11 +303,40 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 			if (main_column->subpass_index == prev_subpass_index) {
 				const int column_height_blocks = _generator_internal->column_height_blocks;
 
+				// Set if the column was saved earlier and could be loaded instead of being generated
+				bool loaded = false;
+
 				if (_subpass_index == 0) {
-					// First pass creates blocks
-					// main_column->blocks.resize(column_height_blocks);
-					for (Block &block : main_column->blocks) {
-						block.voxels.create(Vector3iUtil::create(_block_size));
+					if (!_column_looked_up && _generator_internal->column_stream.is_valid()) {
+						// Look up the column on the IO thread, we will be scheduled again when it's done. Meanwhile,
+						// tasks needing this column wait for us, because our subpass is still marked as pending.
+						_column_looked_up = true;
+
+						LoadColumnMultipassTask *load_task = ZN_NEW(LoadColumnMultipassTask);
+						load_task->column_position = _column_position;
+						load_task->block_size = _block_size;
+						load_task->generator_internal = _generator_internal;
+						load_task->out_blocks = &_loaded_blocks;
+						load_task->caller_task = this;
+						VoxelEngine::get_singleton().push_async_io_task(load_task);
+
+						ctx.status = ThreadedTaskContext::STATUS_TAKEN_OUT;
+						return;
+					}
+
+					if (_loaded_blocks.size() > 0 && _loaded_blocks.size() == main_column->blocks.size()) {
+						for (unsigned int i = 0; i < _loaded_blocks.size(); ++i) {
+							main_column->blocks[i].voxels = std::move(_loaded_blocks[i]);
+						}
+						_loaded_blocks.clear();
+						loaded = true;
+
+					} else {
+						// First pass creates blocks
+						// main_column->blocks.resize(column_height_blocks);
+						for (Block &block : main_column->blocks) {
+							block.voxels.create(Vector3iUtil::create(_block_size));
+						}
 					}
 				}
 
@@ -312,7 +350,11 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 				// further?
 				const int prev_pass_index = VoxelGeneratorMultipassCB::get_pass_index_from_subpass(prev_subpass_index);
 
-				if (pass_index == 0 || prev_pass_index != pass_index) {
+				if (loaded) {
+					// Only fully generated columns are saved
+					main_column->subpass_index = final_subpass_index;
+
+				} else if (pass_index == 0 || prev_pass_index != pass_index) {
 					const int column_base_y_blocks = _generator_internal->column_base_y_blocks;
 
 					// TODO Cache memory
@@ -336,12 +378,19 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 					input.pass_index = pass_index;
 					input.block_size = _block_size;
 
+					const uint64_t time_before = Time::get_singleton()->get_ticks_usec();
+
 					// This should be the ONLY place where `_generator` is used.
 					_generator->generate_pass(input);
+
+					++pass_statistics.run_count;
+					pass_statistics.run_time_usec += Time::get_singleton()->get_ticks_usec() - time_before;
 				}
 
 				// Update levels
-				main_column->subpass_index = _subpass_index;
+				if (!loaded) {
+					main_column->subpass_index = _subpass_index;
+				}
 
 				// for (Column *column : columns) {
 				// 	column->subpass_iterations[_subpass_index]++;
@@ -353,6 +402,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 			}
 
 			main_column->pending_subpass_tasks_mask &= ~(1 << _subpass_index);
+			schedule_waiting_tasks(*main_column, task_scheduler);
 
 			if (main_column->subpass_index == final_subpass_index) {
 				// All tasks that were waiting for this column to be complete (and did not spawn column subtasks
@@ -379,6 +429,14 @@ void GenerateColumnMultipassTask::schedule_final_block_tasks(Column &column, Buf
 	}
 }
 
+void GenerateColumnMultipassTask::schedule_waiting_tasks(Column &column, BufferedTaskScheduler &task_scheduler) {
+	for (IThreadedTask *task : column.waiting_tasks) {
+		ZN_ASSERT(task != this);
+		task_scheduler.push_main_task(task);
+	}
+	column.waiting_tasks.clear();
+}
+
 void GenerateColumnMultipassTask::return_to_caller(bool success) {
 	ZN_ASSERT(_caller_task != nullptr);
 	ZN_ASSERT(_caller_task_dependency_counter != nullptr);
@@ -13,7 +13,8 @@ class BufferedTaskScheduler;
 // If at least one column isn't found in the map, the task is cancelled, and so should be all its callers.
 // Otherwise:
 // If a column doesn't fulfills dependency requirements:
-//     - If another task is working on that column, the current task is postponed to run later.
+//     - If another task is working on that column, the current task registers to that column, and gets scheduled
+//       again when the other task finishes.
 //     - Otherwise, a subtask is spawned to work on the dependency.
 //       The current task is queued after every subtask spawned this way.
 // Otherwise, the task runs the pass, re-schedules its caller, and returns.
@@ -57,6 +58,10 @@ private:
 			VoxelGeneratorMultipassCBStructs::Column &column,
 			BufferedTaskScheduler &task_scheduler
 	);
+	void schedule_waiting_tasks(
+			VoxelGeneratorMultipassCBStructs::Column &column,
+			BufferedTaskScheduler &task_scheduler
+	);
 	void return_to_caller(bool success);
 
 	Vector2i _column_position;
@@ -73,6 +78,10 @@ private:
 	// processed".
 	std::shared_ptr<std::atomic_int> _caller_task_dependency_counter;
 	GenerateColumnMultipassTask *_caller_mp_task = nullptr;
+	// Set when the first subpass has looked up the column in the generator's column stream
+	bool _column_looked_up = false;
+	// Blocks of the column if the lookup found it, to be moved into the map instead of generating them
+	StdVector<VoxelBuffer> _loaded_blocks;
 };
 
 } // namespace zylann::voxel
@@ -0,0 +1,127 @@
+#include "load_column_multipass_task.h"
+#include "../../engine/voxel_engine.h"
+#include "../../storage/metadata/voxel_metadata.h"
+#include "../../util/profiling.h"
+#include "voxel_generator_multipass_cb.h"
+
+namespace zylann::voxel {
+
+using namespace VoxelGeneratorMultipassCBStructs;
+
+namespace {
+
+bool try_load_from_pending_saves(PendingColumnSaves &pending_saves, Vector2i cpos, StdVector<VoxelBuffer> &buffers) {
+	std::shared_ptr<SavedColumn> saved_column;
+	{
+		MutexLock mlock(pending_saves.mutex);
+		auto it = pending_saves.columns.find(cpos);
+		if (it == pending_saves.columns.end()) {
+			return false;
+		}
+		saved_column = it->second;
+	}
+
+	// Saved columns are not modified after being registered, and save tasks run serially with this one, so it is
+	// safe to read them without locking
+	if (saved_column->blocks.size() != buffers.size()) {
+		return false;
+	}
+	for (unsigned int i = 0; i < buffers.size(); ++i) {
+		saved_column->blocks[i].voxels.copy_to(buffers[i], true);
+	}
+	return true;
+}
+
+bool try_load_from_stream(
+		VoxelStream &stream,
+		Vector2i cpos,
+		int column_base_y_blocks,
+		StdVector<VoxelBuffer> &buffers
+) {
+	StdVector<VoxelStream::VoxelQueryData> queries;
+	queries.reserve(buffers.size());
+
+	for (unsigned int i = 0; i < buffers.size(); ++i) {
+		const Vector3i bpos(cpos.x, column_base_y_blocks + i, cpos.y);
+		queries.push_back(VoxelStream::VoxelQueryData{ buffers[i], bpos, 0, VoxelStream::RESULT_ERROR });
+	}
+
+	stream.load_voxel_blocks(to_span(queries));
+
+	for (const VoxelStream::VoxelQueryData &query : queries) {
+		if (query.result != VoxelStream::RESULT_BLOCK_FOUND) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Checks blocks were saved as a fully generated column, with the same params
+bool is_column_valid(Span<const VoxelBuffer> buffers, int block_size, uint64_t params_hash, int final_subpass_index) {
+	for (const VoxelBuffer &buffer : buffers) {
+		if (buffer.get_size() != Vector3iUtil::create(block_size)) {
+			return false;
+		}
+		const VoxelMetadata &metadata = buffer.get_block_metadata();
+		if (metadata.get_type() != VoxelMetadata::TYPE_U64) {
+			return false;
+		}
+		int subpass_index;
+		if (!parse_saved_column_metadata(metadata.get_u64(), params_hash, subpass_index)) {
+			// Saved with different generator settings
+			return false;
+		}
+		if (subpass_index != final_subpass_index) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+void LoadColumnMultipassTask::run(ThreadedTaskContext &ctx) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT(generator_internal != nullptr);
+	ZN_ASSERT(out_blocks != nullptr);
+	ZN_ASSERT(caller_task != nullptr);
+
+	const Internal &internal = *generator_internal;
+
+	if (!internal.expired && internal.column_stream.is_valid()) {
+		StdVector<VoxelBuffer> buffers;
+		buffers.reserve(internal.column_height_blocks);
+		for (int i = 0; i < internal.column_height_blocks; ++i) {
+			buffers.emplace_back(VoxelBuffer::ALLOCATOR_POOL);
+			buffers.back().create(Vector3iUtil::create(block_size));
+		}
+
+		bool found = try_load_from_pending_saves(*internal.pending_column_saves, column_position, buffers);
+		if (!found) {
+			found = try_load_from_stream(
+					**internal.column_stream, column_position, internal.column_base_y_blocks, buffers
+			);
+		}
+
+		const int final_subpass_index =
+				VoxelGeneratorMultipassCB::get_subpass_count_from_pass_count(internal.passes.size()) - 1;
+
+		if (found) {
+			found = is_column_valid(
+					to_span_const(buffers), block_size, internal.column_params_hash, final_subpass_index
+			);
+		}
+
+		if (found) {
+			for (VoxelBuffer &buffer : buffers) {
+				buffer.get_block_metadata().clear();
+			}
+			*out_blocks = std::move(buffers);
+		}
+	}
+
+	VoxelEngine::get_singleton().push_async_task(caller_task);
+	caller_task = nullptr;
+}
+
+} // namespace zylann::voxel
@@ -0,0 +1,31 @@
+#ifndef VOXEL_LOAD_COLUMN_MULTIPASS_TASK_H
+#define VOXEL_LOAD_COLUMN_MULTIPASS_TASK_H
+
+#include "../../util/tasks/threaded_task.h"
+#include "voxel_generator_multipass_cb_structs.h"
+
+namespace zylann::voxel {
+
+// Looks up a fully generated column of `VoxelGeneratorMultipassCB` in columns waiting to be saved, then in the column
+// stream. This runs on the IO thread without locking the generator's map, so the column task requesting it has to
+// apply the result when it gets scheduled again.
+class LoadColumnMultipassTask : public IThreadedTask {
+public:
+	Vector2i column_position;
+	uint8_t block_size = 0;
+	std::shared_ptr<VoxelGeneratorMultipassCBStructs::Internal> generator_internal;
+	// Filled with the blocks of the column if it was found, left empty otherwise. Owned by `caller_task`.
+	StdVector<VoxelBuffer> *out_blocks = nullptr;
+	// Scheduled again when the lookup is done. The task is owned by this one until then.
+	IThreadedTask *caller_task = nullptr;
+
+	const char *get_debug_name() const override {
+		return "LoadColumnMultipass";
+	}
+
+	void run(ThreadedTaskContext &ctx) override;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_LOAD_COLUMN_MULTIPASS_TASK_H
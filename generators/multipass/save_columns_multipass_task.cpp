@@ -0,0 +1,40 @@
+#include "save_columns_multipass_task.h"
+#include "../../util/profiling.h"
+
+namespace zylann::voxel {
+
+using namespace VoxelGeneratorMultipassCBStructs;
+
+void SaveColumnsMultipassTask::run(ThreadedTaskContext &ctx) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(stream.is_valid());
+	ZN_ASSERT_RETURN(pending_saves != nullptr);
+
+	StdVector<VoxelStream::VoxelQueryData> queries;
+
+	for (std::shared_ptr<SavedColumn> &column : columns) {
+		for (unsigned int i = 0; i < column->blocks.size(); ++i) {
+			VoxelBuffer &voxels = column->blocks[i].voxels;
+			const Vector3i bpos(column->position.x, column_base_y_blocks + i, column->position.y);
+			queries.push_back(VoxelStream::VoxelQueryData{ voxels, bpos, 0, VoxelStream::RESULT_ERROR });
+		}
+	}
+
+	stream->save_voxel_blocks(to_span(queries));
+
+	if (flush_stream) {
+		stream->flush();
+	}
+
+	// Columns can now be loaded from the stream
+	MutexLock mlock(pending_saves->mutex);
+	for (const std::shared_ptr<SavedColumn> &column : columns) {
+		auto it = pending_saves->columns.find(column->position);
+		// The column may have been unloaded and saved again in the meantime, by another task
+		if (it != pending_saves->columns.end() && it->second == column) {
+			pending_saves->columns.erase(it);
+		}
+	}
+}
+
+} // namespace zylann::voxel
@@ -0,0 +1,29 @@
+#ifndef VOXEL_SAVE_COLUMNS_MULTIPASS_TASK_H
+#define VOXEL_SAVE_COLUMNS_MULTIPASS_TASK_H
+
+#include "../../util/tasks/threaded_task.h"
+#include "voxel_generator_multipass_cb_structs.h"
+
+namespace zylann::voxel {
+
+// Saves fully generated columns of `VoxelGeneratorMultipassCB` to a stream, so they don't have to be generated again.
+// Columns must be registered in `pending_saves` beforehand, with their block metadata already set. They are removed
+// from it once saved.
+class SaveColumnsMultipassTask : public IThreadedTask {
+public:
+	StdVector<std::shared_ptr<VoxelGeneratorMultipassCBStructs::SavedColumn>> columns;
+	std::shared_ptr<VoxelGeneratorMultipassCBStructs::PendingColumnSaves> pending_saves;
+	Ref<VoxelStream> stream;
+	int column_base_y_blocks = 0;
+	bool flush_stream = false;
+
+	const char *get_debug_name() const override {
+		return "SaveColumnsMultipass";
+	}
+
+	void run(ThreadedTaskContext &ctx) override;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_SAVE_COLUMNS_MULTIPASS_TASK_H
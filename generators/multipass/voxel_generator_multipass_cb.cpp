@@ -1,13 +1,20 @@
 #include "voxel_generator_multipass_cb.h"
+#include "../../constants/voxel_string_names.h"
 #include "../../engine/buffered_task_scheduler.h"
+#include "../../engine/voxel_engine.h"
+#include "../../storage/metadata/voxel_metadata.h"
 #include "../../util/containers/container_funcs.h"
 #include "../../util/dstack.h"
 #include "../../util/godot/check_ref_ownership.h"
+#include "../../util/godot/classes/object.h"
+#include "../../util/godot/classes/script.h"
 #include "../../util/godot/classes/time.h"
 #include "../../util/godot/core/array.h"
+#include "../../util/godot/core/dictionary.h"
 #include "../../util/profiling.h"
 #include "../../util/string/format.h"
 #include "generate_block_multipass_cb_task.h"
+#include "save_columns_multipass_task.h"
 
 namespace zylann::voxel {
 
@@ -17,6 +24,10 @@ VoxelGeneratorMultipassCB::VoxelGeneratorMultipassCB() {
 	std::shared_ptr<Internal> internal = make_shared_instance<Internal>();
 	// MutexLock mlock(_internal_mutex);
 	_internal = internal;
+
+	const VoxelStringNames &sn = VoxelStringNames::get_singleton();
+	connect(sn.changed, callable_mp(this, &VoxelGeneratorMultipassCB::_on_column_params_changed));
+	connect(sn.script_changed, callable_mp(this, &VoxelGeneratorMultipassCB::_on_column_params_changed));
 }
 
 VoxelGeneratorMultipassCB::~VoxelGeneratorMultipassCB() {}
@@ -156,6 +167,35 @@ void VoxelGeneratorMultipassCB::set_pass_extent_blocks(int pass_index, int new_e
 	re_initialize_column_refcounts();
 }
 
+int VoxelGeneratorMultipassCB::get_column_cache_max_columns() const {
+	return get_internal()->column_cache_max_columns;
+}
+
+void VoxelGeneratorMultipassCB::set_column_cache_max_columns(int count) {
+	count = math::clamp(count, 0, MAX_CACHED_COLUMNS);
+	if (get_column_cache_max_columns() == count) {
+		return;
+	}
+	reset_internal([count](Internal &internal) { //
+		internal.column_cache_max_columns = count;
+	});
+	re_initialize_column_refcounts();
+}
+
+Ref<VoxelStream> VoxelGeneratorMultipassCB::get_column_cache_stream() const {
+	return get_internal()->column_stream;
+}
+
+void VoxelGeneratorMultipassCB::set_column_cache_stream(Ref<VoxelStream> stream) {
+	if (get_column_cache_stream() == stream) {
+		return;
+	}
+	reset_internal([stream](Internal &internal) { //
+		internal.column_stream = stream;
+	});
+	re_initialize_column_refcounts();
+}
+
 // Internal
 
 std::shared_ptr<Internal> VoxelGeneratorMultipassCB::get_internal() const {
@@ -190,6 +230,124 @@ Box2i to_box2i_in_height_range(Box3i box3, int min_y, int height) {
 	return Box2i(to_vec2i_xz(box3.position), to_vec2i_xz(box3.size));
 }
 
+bool take_cached_column(ColumnCache &cache, Vector2i cpos, Column &out_column) {
+	auto it = cache.columns.find(cpos);
+	if (it == cache.columns.end()) {
+		return false;
+	}
+	ColumnCache::Entry &entry = it->second;
+	out_column.blocks = std::move(entry.blocks);
+	out_column.subpass_index = entry.subpass_index;
+	// Its item in `order` becomes outdated
+	cache.columns.erase(it);
+	return true;
+}
+
+void compact_column_cache_order(ColumnCache &cache) {
+	const unsigned int count = cache.order.size();
+	for (unsigned int i = 0; i < count; ++i) {
+		const std::pair<Vector2i, uint32_t> item = cache.order.front();
+		cache.order.pop();
+		auto it = cache.columns.find(item.first);
+		if (it != cache.columns.end() && it->second.stamp == item.second) {
+			cache.order.push(item);
+		}
+	}
+}
+
+inline int get_final_subpass_index(const Internal &internal) {
+	return VoxelGeneratorMultipassCB::get_subpass_count_from_pass_count(internal.passes.size()) - 1;
+}
+
+// Adds a column to `out_columns` if it can be saved. Partially generated columns are not saved, because passes
+// running on their neighbors may still modify them.
+void add_column_to_save(
+		const Internal &internal,
+		Vector2i cpos,
+		int subpass_index,
+		StdVector<Block> &&blocks,
+		StdVector<std::shared_ptr<SavedColumn>> &out_columns
+) {
+	if (internal.column_stream.is_null() || subpass_index != get_final_subpass_index(internal)) {
+		return;
+	}
+	std::shared_ptr<SavedColumn> saved_column = make_shared_instance<SavedColumn>();
+	saved_column->position = cpos;
+	saved_column->blocks = std::move(blocks);
+	// Set now, so the column can be read from other threads without modification until it is saved
+	const uint64_t metadata = make_saved_column_metadata(internal.column_params_hash, subpass_index);
+	for (Block &block : saved_column->blocks) {
+		block.voxels.get_block_metadata().set_u64(metadata);
+	}
+	out_columns.push_back(saved_column);
+}
+
+// Keeps an unloaded column in memory. Columns that don't fit are added to `out_columns_to_save`, if they can be saved.
+void cache_column(
+		Internal &internal,
+		Vector2i cpos,
+		Column &column,
+		StdVector<std::shared_ptr<SavedColumn>> &out_columns_to_save
+) {
+	if (internal.column_cache_max_columns == 0) {
+		add_column_to_save(internal, cpos, column.subpass_index, std::move(column.blocks), out_columns_to_save);
+		return;
+	}
+
+	ColumnCache &cache = internal.column_cache;
+
+	ColumnCache::Entry &entry = cache.columns[cpos];
+	entry.blocks = std::move(column.blocks);
+	entry.subpass_index = column.subpass_index;
+	entry.stamp = cache.next_stamp;
+	++cache.next_stamp;
+	cache.order.push(std::make_pair(cpos, entry.stamp));
+
+	// Evict least recently unloaded columns
+	while (cache.columns.size() > internal.column_cache_max_columns && cache.order.size() > 0) {
+		const std::pair<Vector2i, uint32_t> item = cache.order.front();
+		cache.order.pop();
+
+		auto it = cache.columns.find(item.first);
+		if (it == cache.columns.end() || it->second.stamp != item.second) {
+			// Outdated
+			continue;
+		}
+		add_column_to_save(
+				internal, it->first, it->second.subpass_index, std::move(it->second.blocks), out_columns_to_save
+		);
+		cache.columns.erase(it);
+	}
+
+	// Columns loaded back leave outdated items behind
+	if (cache.order.size() > 2 * cache.columns.size() + 64) {
+		compact_column_cache_order(cache);
+	}
+}
+
+void schedule_saving_columns(
+		const Internal &internal,
+		StdVector<std::shared_ptr<SavedColumn>> &&columns,
+		bool flush_stream
+) {
+	// Columns remain available to load until they are saved
+	{
+		PendingColumnSaves &pending_saves = *internal.pending_column_saves;
+		MutexLock mlock(pending_saves.mutex);
+		for (const std::shared_ptr<SavedColumn> &column : columns) {
+			pending_saves.columns[column->position] = column;
+		}
+	}
+
+	SaveColumnsMultipassTask *task = ZN_NEW(SaveColumnsMultipassTask);
+	task->columns = std::move(columns);
+	task->pending_saves = internal.pending_column_saves;
+	task->stream = internal.column_stream;
+	task->column_base_y_blocks = internal.column_base_y_blocks;
+	task->flush_stream = flush_stream;
+	VoxelEngine::get_singleton().push_async_io_task(task);
+}
+
 } // namespace
 
 void VoxelGeneratorMultipassCB::generate_pass(PassInput input) {
@@ -221,7 +379,7 @@ void VoxelGeneratorMultipassCB::generate_pass(PassInput input) {
 
 void VoxelGeneratorMultipassCB::re_initialize_column_refcounts() {
 	// This should only be called following a map reset
-	ZN_ASSERT_RETURN_MSG(get_internal()->map.columns.size() == 0, "Bug!");
+	ZN_ASSERT_RETURN_MSG(get_internal()->map.get_column_count() == 0, "Bug!");
 
 	for (PairedViewer &pv : _paired_viewers) {
 		process_viewer_diff_internal(pv.request_box, Box3i());
@@ -258,6 +416,11 @@ void VoxelGeneratorMultipassCB::process_viewer_diff_internal(Box3i p_requested_b
 
 	std::shared_ptr<Internal> internal = get_internal();
 
+	// Hashing script variables can be expensive, so it's only done after something changed
+	if (internal->column_params_hash_dirty) {
+		update_column_params_hash(*internal);
+	}
+
 	const int total_extent = get_total_dependency_extent(*internal);
 
 	const Box2i requested_box_2d =
@@ -285,15 +448,21 @@ void VoxelGeneratorMultipassCB::process_viewer_diff_internal(Box3i p_requested_b
 
 	// Blocks to view
 	const int column_height = internal->column_height_blocks;
-	load_requested_box.difference(prev_load_requested_box, [&map, column_height](Box2i new_box) {
+	ColumnCache &column_cache = internal->column_cache;
+	load_requested_box.difference(prev_load_requested_box, [&map, &column_cache, column_height](Box2i new_box) {
 		{
 			SpatialLock2D::Write swlock(map.spatial_lock, new_box);
-			MutexLock mlock(map.mutex);
 
-			new_box.for_each_cell_yx([&map, column_height](Vector2i bpos) {
-				Column &column = map.columns[bpos];
+			new_box.for_each_cell_yx([&map, &column_cache, column_height](Vector2i bpos) {
+				Map::Shard &shard = map.get_shard(bpos);
+				MutexLock mlock(shard.mutex);
+				Column &column = shard.columns[bpos];
 				if (column.blocks.size() == 0) {
-					column.blocks.resize(column_height);
+					// Resume where generation was when the column got unloaded, if we still have it. Otherwise
+					// the first subpass will look it up in columns being saved, then in the column stream.
+					if (!take_cached_column(column_cache, bpos, column)) {
+						column.blocks.resize(column_height);
+					}
 				}
 				// if (block == nullptr) {
 				// 	block = make_unique_instance<Block>();
@@ -306,17 +475,23 @@ void VoxelGeneratorMultipassCB::process_viewer_diff_internal(Box3i p_requested_b
 		}
 	});
 
+	StdVector<std::shared_ptr<SavedColumn>> columns_to_save;
+	Internal &internal_ref = *internal;
+
 	// Blocks to unview
-	prev_load_requested_box.difference(load_requested_box, [&map, &task_scheduler](Box2i old_box) {
+	prev_load_requested_box.difference(
+			load_requested_box,
+			[&map, &task_scheduler, &internal_ref, &columns_to_save](Box2i old_box) {
 		{
 			SpatialLock2D::Write swlock(map.spatial_lock, old_box);
-			MutexLock mlock(map.mutex);
 
-			old_box.for_each_cell_yx([&map, &task_scheduler](Vector2i cpos) {
-				auto it = map.columns.find(cpos);
+			old_box.for_each_cell_yx([&map, &task_scheduler, &internal_ref, &columns_to_save](Vector2i cpos) {
+				Map::Shard &shard = map.get_shard(cpos);
+				MutexLock mlock(shard.mutex);
+				auto it = shard.columns.find(cpos);
 
 				// The block must be found because last time the block was in the loading area of the viewer.
-				ZN_ASSERT(it != map.columns.end());
+				ZN_ASSERT(it != shard.columns.end());
 				Column &column = it->second;
 
 				column.viewers.remove();
@@ -331,9 +506,17 @@ void VoxelGeneratorMultipassCB::process_viewer_diff_internal(Box3i p_requested_b
 						}
 					}
 
-					// TODO Implement saving tasks
-					// We remove immediately for now
-					map.columns.erase(it);
+					// Tasks waiting on the column will cancel when they find it missing
+					for (IThreadedTask *task : column.waiting_tasks) {
+						task_scheduler.push_main_task(task);
+					}
+					column.waiting_tasks.clear();
+
+					if (column.subpass_index >= 0) {
+						cache_column(internal_ref, cpos, column, columns_to_save);
+					}
+
+					shard.columns.erase(it);
 					// println(format("U {} {} {} {} {}", 0, cpos.x, 0, cpos.y,
 					// Time::get_singleton()->get_ticks_usec()));
 				}
@@ -341,10 +524,115 @@ void VoxelGeneratorMultipassCB::process_viewer_diff_internal(Box3i p_requested_b
 		}
 	});
 
+	if (columns_to_save.size() > 0) {
+		schedule_saving_columns(*internal, std::move(columns_to_save), false);
+	}
+
 	task_scheduler.flush();
 }
 
+void VoxelGeneratorMultipassCB::save_all_columns() {
+	ZN_PROFILE_SCOPE();
+
+	std::shared_ptr<Internal> internal = get_internal();
+	if (internal->column_stream.is_null()) {
+		return;
+	}
+
+	update_column_params_hash(*internal);
+
+	StdVector<std::shared_ptr<SavedColumn>> columns;
+
+	ColumnCache &cache = internal->column_cache;
+	for (auto it = cache.columns.begin(); it != cache.columns.end(); ++it) {
+		add_column_to_save(*internal, it->first, it->second.subpass_index, std::move(it->second.blocks), columns);
+	}
+	cache.columns.clear();
+	cache.order = StdQueue<std::pair<Vector2i, uint32_t>>();
+
+	// Loaded columns are copied, because tasks may still be using them
+	Map &map = internal->map;
+	if (map.spatial_lock.try_lock_write(BoxBounds2i::from_everywhere())) {
+		SpatialLock2D::UnlockWriteOnScopeExit swlock(map.spatial_lock, BoxBounds2i::from_everywhere());
+
+		const int final_subpass_index = get_final_subpass_index(*internal);
+
+		for (unsigned int shard_index = 0; shard_index < Map::SHARD_COUNT; ++shard_index) {
+			Map::Shard &shard = map.shards[shard_index];
+			MutexLock mlock(shard.mutex);
+
+			for (auto it = shard.columns.begin(); it != shard.columns.end(); ++it) {
+				const Column &column = it->second;
+				if (column.subpass_index != final_subpass_index) {
+					continue;
+				}
+				StdVector<Block> blocks;
+				blocks.resize(column.blocks.size());
+				for (unsigned int i = 0; i < column.blocks.size(); ++i) {
+					column.blocks[i].voxels.copy_to(blocks[i].voxels, true);
+				}
+				add_column_to_save(*internal, it->first, column.subpass_index, std::move(blocks), columns);
+			}
+		}
+
+	} else {
+		// Don't hang the main thread, generation is still busy
+		ZN_PRINT_VERBOSE("Could not save loaded columns of multipass generator, they are locked");
+	}
+
+	if (columns.size() > 0) {
+		schedule_saving_columns(*internal, std::move(columns), true);
+	}
+}
+
+void VoxelGeneratorMultipassCB::update_column_params_hash(Internal &internal) const {
+	ZN_PROFILE_SCOPE();
+
+	uint64_t h = internal.get_params_hash();
+	h = hash_djb2_one_64(get_used_channels_mask(), h);
+
+	Ref<Script> script = get_script();
+	if (script.is_valid()) {
+		h = hash_djb2_one_64(script->get_path().hash(), h);
+		h = hash_djb2_one_64(script->get_source_code().hash(), h);
+
+		// Script variables, including resources they reference such as noise
+		StdVector<godot::PropertyInfoWrapper> properties;
+		godot::get_property_list(*this, properties);
+
+		for (const godot::PropertyInfoWrapper &property : properties) {
+			if ((property.usage & PROPERTY_USAGE_SCRIPT_VARIABLE) == 0) {
+				continue;
+			}
+			const Variant value = get(property.name);
+			uint64_t value_hash = 0;
+
+			if (value.get_type() == Variant::OBJECT) {
+				const Object *obj_value = value.operator Object *();
+				if (obj_value != nullptr) {
+					value_hash = godot::get_deep_hash(*obj_value);
+				}
+
+			} else {
+				value_hash = value.hash();
+			}
+
+			h = hash_djb2_one_64(value_hash, h);
+		}
+	}
+
+	internal.column_params_hash = h;
+	internal.column_params_hash_dirty = false;
+}
+
+void VoxelGeneratorMultipassCB::_on_column_params_changed() {
+	get_internal()->column_params_hash_dirty = true;
+}
+
 void VoxelGeneratorMultipassCB::clear_cache() {
+	// Columns are saved so generation can resume after a restart
+	save_all_columns();
+
 	reset_internal([](const Internal &) {});
 
 	// We dont reset viewer refcounts, we assume they will be re-paired later by the caller.
@@ -382,14 +670,7 @@ bool VoxelGeneratorMultipassCB::debug_try_get_column_states(StdVector<DebugColum
 	std::shared_ptr<Internal> internal = get_internal();
 	Map &map = internal->map;
 
-	{
-		unsigned int size = 0;
-		{
-			MutexLock mlock(map.mutex);
-			size = map.columns.size();
-		}
-		out_states.reserve(size);
-	}
+	out_states.reserve(map.get_column_count());
 
 	if (!map.spatial_lock.try_lock_read(BoxBounds2i::from_everywhere())) {
 		// Don't hang here on the main thread, while generating it's very likely the map is locked somewhere.
@@ -398,16 +679,35 @@ bool VoxelGeneratorMultipassCB::debug_try_get_column_states(StdVector<DebugColum
 	}
 	SpatialLock2D::UnlockReadOnScopeExit srlock(map.spatial_lock, BoxBounds2i::from_everywhere());
 
-	MutexLock mlock(map.mutex);
+	for (unsigned int shard_index = 0; shard_index < Map::SHARD_COUNT; ++shard_index) {
+		Map::Shard &shard = map.shards[shard_index];
+		MutexLock mlock(shard.mutex);
 
-	for (auto it = map.columns.begin(); it != map.columns.end(); ++it) {
-		Column &column = it->second;
-		out_states.push_back(DebugColumnState{ it->first, column.subpass_index, uint8_t(column.viewers.get()) });
+		for (auto it = shard.columns.begin(); it != shard.columns.end(); ++it) {
+			Column &column = it->second;
+			out_states.push_back(DebugColumnState{ it->first, column.subpass_index, uint8_t(column.viewers.get()) });
+		}
 	}
 
 	return true;
 }
 
+Array VoxelGeneratorMultipassCB::get_pass_statistics() const {
+	std::shared_ptr<Internal> internal = get_internal();
+
+	Array stats;
+	for (unsigned int pass_index = 0; pass_index < internal->passes.size(); ++pass_index) {
+		const PassStatistics &ps = internal->pass_statistics[pass_index];
+		Dictionary d;
+		d["run_count"] = static_cast<int64_t>(ps.run_count);
+		d["run_time_usec"] = static_cast<int64_t>(ps.run_time_usec);
+		d["postpone_count"] = static_cast<int64_t>(ps.postpone_count);
+		d["wait_count"] = static_cast<int64_t>(ps.wait_count);
+		stats.append(d);
+	}
+	return stats;
+}
+
 #ifdef TOOLS_ENABLED
 
 void VoxelGeneratorMultipassCB::get_configuration_warnings(PackedStringArray &out_warnings) const {
@@ -635,6 +935,20 @@ void VoxelGeneratorMultipassCB::_bind_methods() {
 			&VoxelGeneratorMultipassCB::debug_generate_test_column
 	);
 
+	ClassDB::bind_method(D_METHOD("get_pass_statistics"), &VoxelGeneratorMultipassCB::get_pass_statistics);
+
+	ClassDB::bind_method(
+			D_METHOD("get_column_cache_max_columns"), &VoxelGeneratorMultipassCB::get_column_cache_max_columns
+	);
+	ClassDB::bind_method(
+			D_METHOD("set_column_cache_max_columns", "count"), &VoxelGeneratorMultipassCB::set_column_cache_max_columns
+	);
+
+	ClassDB::bind_method(D_METHOD("get_column_cache_stream"), &VoxelGeneratorMultipassCB::get_column_cache_stream);
+	ClassDB::bind_method(
+			D_METHOD("set_column_cache_stream", "stream"), &VoxelGeneratorMultipassCB::set_column_cache_stream
+	);
+
 #if defined(ZN_GODOT)
 	// TODO Test if GDVIRTUAL can print errors properly when GDScript fails inside a different thread.
 	GDVIRTUAL_BIND(_generate_pass, "voxel_tool", "pass_index");
@@ -658,6 +972,25 @@ void VoxelGeneratorMultipassCB::_bind_methods() {
 			"get_pass_count"
 	);
 
+	ADD_PROPERTY(
+			PropertyInfo(
+					Variant::INT,
+					"column_cache_max_columns",
+					PROPERTY_HINT_RANGE,
+					String("0,{0}").format(varray(MAX_CACHED_COLUMNS))
+			),
+			"set_column_cache_max_columns",
+			"get_column_cache_max_columns"
+	);
+
+	ADD_PROPERTY(
+			PropertyInfo(
+					Variant::OBJECT, "column_cache_stream", PROPERTY_HINT_RESOURCE_TYPE, VoxelStream::get_class_static()
+			),
+			"set_column_cache_stream",
+			"get_column_cache_stream"
+	);
+
 	BIND_CONSTANT(MAX_PASSES);
 	BIND_CONSTANT(MAX_PASS_EXTENT);
 }
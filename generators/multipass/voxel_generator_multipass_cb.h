@@ -39,6 +39,8 @@ public:
 	// For reference, Minecraft is 24 blocks high (384 voxels)
 	static constexpr int MAX_COLUMN_HEIGHT_BLOCKS = 32;
 
+	static constexpr int MAX_CACHED_COLUMNS = 65536;
+
 	static inline int get_subpass_count_from_pass_count(int pass_count) {
 		return pass_count * 2 - 1;
 	}
@@ -84,6 +86,12 @@ public:
 	int get_pass_extent_blocks(int pass_index) const;
 	void set_pass_extent_blocks(int pass_index, int new_extent);
 
+	int get_column_cache_max_columns() const;
+	void set_column_cache_max_columns(int count);
+
+	Ref<VoxelStream> get_column_cache_stream() const;
+	void set_column_cache_stream(Ref<VoxelStream> stream);
+
 	// Run the generator to get a particular column from scratch, using a single thread for better script debugging
 	// (since Godot 4 still doesn't support debugging scripts in different threads, at time of writing). This doesn't
 	// use the internal cache and can be extremely slow.
@@ -115,6 +123,9 @@ public:
 
 	bool debug_try_get_column_states(StdVector<DebugColumnState> &out_states);
 
+	// Returns one dictionary per pass, with counters accumulated since the cache was last reset
+	Array get_pass_statistics() const;
+
 protected:
 	bool _set(const StringName &p_name, const Variant &p_value);
 	bool _get(const StringName &p_name, Variant &r_ret) const;
@@ -129,6 +140,12 @@ protected:
 
 private:
 	void process_viewer_diff_internal(Box3i p_requested_box, Box3i p_prev_requested_box);
+	void save_all_columns();
+	// Identifies everything affecting the contents of columns, so columns saved earlier are only loaded if they would
+	// generate the same
+	void update_column_params_hash(VoxelGeneratorMultipassCBStructs::Internal &internal) const;
+	// Scripts are expected to call `emit_changed()` after modifying variables that affect generation
+	void _on_column_params_changed();
 	void re_initialize_column_refcounts();
 	void generate_block_fallback_script(VoxelQueryData &input);
 
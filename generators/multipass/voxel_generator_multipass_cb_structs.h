@@ -2,16 +2,22 @@
 #define VOXEL_GENERATOR_MULTIPASS_CB_STRUCTS_H
 
 #include "../../storage/voxel_buffer.h"
+#include "../../streams/voxel_stream.h"
+#include "../../util/containers/fixed_array.h"
 #include "../../util/containers/small_vector.h"
 #include "../../util/containers/span.h"
+#include "../../util/containers/std_queue.h"
 #include "../../util/containers/std_unordered_map.h"
 #include "../../util/containers/std_vector.h"
+#include "../../util/hash_funcs.h"
 #include "../../util/math/vector2i.h"
 #include "../../util/math/vector3i.h"
+#include "../../util/memory/memory.h"
 #include "../../util/ref_count.h"
 #include "../../util/thread/mutex.h"
 #include "../../util/thread/spatial_lock_2d.h"
 
+#include <atomic>
 #include <utility>
 
 // Data structures used internally in multipass generation.
@@ -77,6 +83,11 @@ struct Column {
 	// Each bit is set to 1 when a task is pending to process this block at a given subpass.
 	uint8_t pending_subpass_tasks_mask = 0;
 
+	// Tasks waiting for a pending task on this column to finish, because they need it as a dependency. They are
+	// scheduled again when that task completes or cancels, or when the column gets unloaded.
+	// Same ownership rules as `Block::final_pending_task`.
+	StdVector<IThreadedTask *> waiting_tasks;
+
 	// Currently unused, because if chunks get removed from the cache or don't get saved for any reason,
 	// it can become out of sync and we wouldn't know. It would be a nice optimization tho...
 	//
@@ -96,12 +107,45 @@ struct Column {
 };
 
 struct Map {
-	StdUnorderedMap<Vector2i, Column> columns;
-	// Protects the hashmap itself
-	Mutex mutex;
+	static constexpr unsigned int SHARD_COUNT = 16;
+
+	struct Shard {
+		StdUnorderedMap<Vector2i, Column> columns;
+		// Protects the hashmap itself
+		Mutex mutex;
+	};
+
+	// Columns are spread in several hashmaps, so threads looking up different columns rarely have to wait for each
+	// other
+	FixedArray<Shard, SHARD_COUNT> shards;
 	// Protects columns
 	mutable SpatialLock2D spatial_lock;
 
+	inline Shard &get_shard(Vector2i cpos) {
+		return shards[std::hash<Vector2i>{}(cpos) % SHARD_COUNT];
+	}
+
+	// Returns null if the column isn't loaded. The column must be locked with `spatial_lock` to access it.
+	Column *find_column(Vector2i cpos) {
+		Shard &shard = get_shard(cpos);
+		MutexLock mlock(shard.mutex);
+		auto it = shard.columns.find(cpos);
+		if (it == shard.columns.end()) {
+			return nullptr;
+		}
+		return &it->second;
+	}
+
+	unsigned int get_column_count() {
+		unsigned int count = 0;
+		for (unsigned int i = 0; i < SHARD_COUNT; ++i) {
+			Shard &shard = shards[i];
+			MutexLock mlock(shard.mutex);
+			count += shard.columns.size();
+		}
+		return count;
+	}
+
 	~Map() {
 		// If the map gets destroyed then we know the last reference to it was removed, which means only one thread had
 		// access to it, so we can get away not locking anything if cleanup is needed.
@@ -117,6 +161,34 @@ struct Map {
 	}
 };
 
+// Columns that were unloaded recently, kept in case they get loaded again. Only accessed from the main thread.
+struct ColumnCache {
+	struct Entry {
+		StdVector<Block> blocks;
+		int8_t subpass_index = -1;
+		uint32_t stamp = 0;
+	};
+
+	StdUnorderedMap<Vector2i, Entry> columns;
+	// Positions in the order they were added, oldest first. Items with a stamp different from their entry are
+	// outdated.
+	StdQueue<std::pair<Vector2i, uint32_t>> order;
+	uint32_t next_stamp = 0;
+};
+
+// Fully generated column handed over to a task saving it to the column stream.
+struct SavedColumn {
+	Vector2i position;
+	StdVector<Block> blocks;
+};
+
+// Columns handed over to save tasks, until they are saved. They can still be loaded from here in the meantime, so
+// columns loaded again shortly after being evicted are not generated again.
+struct PendingColumnSaves {
+	StdUnorderedMap<Vector2i, std::shared_ptr<SavedColumn>> columns;
+	Mutex mutex;
+};
+
 struct Pass {
 	// How many blocks to load using the previous pass around the generated area, so that neighbors can be accessed
 	// in case the pass has effects across blocks.
@@ -124,6 +196,18 @@ struct Pass {
 	int8_t dependency_extents = 0;
 };
 
+// Counters updated by column tasks, to find which passes are the most expensive.
+struct PassStatistics {
+	// How many columns were processed by the pass
+	std::atomic_uint64_t run_count = { 0 };
+	// Time spent running the pass, in microseconds
+	std::atomic_uint64_t run_time_usec = { 0 };
+	// How many times tasks had to be retried later because the region they needed was locked
+	std::atomic_uint64_t postpone_count = { 0 };
+	// How many times tasks had to wait for a dependency being processed by another task
+	std::atomic_uint64_t wait_count = { 0 };
+};
+
 // Internal state of the generator.
 struct Internal {
 	// Map used solely for generation purposes. It acts like a cache so we don't recompute the same passes many
@@ -138,6 +222,26 @@ struct Internal {
 	int column_base_y_blocks = -4;
 	int column_height_blocks = 8;
 
+	// Maximum number of unloaded columns to keep in `column_cache`. Columns going past that limit are saved to
+	// `column_stream` if any, and forgotten.
+	unsigned int column_cache_max_columns = 0;
+	// Where fully generated columns are saved, so they don't have to be generated again.
+	Ref<VoxelStream> column_stream;
+	// Shared with instances made when params change, because save tasks may still be running
+	std::shared_ptr<PendingColumnSaves> pending_column_saves;
+
+	// Hash of params and of the script, identifying the contents of saved columns. Updated on the main thread by the
+	// generator, since scripts can only be inspected there.
+	std::atomic_uint64_t column_params_hash = { 0 };
+	// Set when the script or its variables may have changed, so the hash is only recomputed when needed. New
+	// instances start dirty since they are made when params change.
+	std::atomic_bool column_params_hash_dirty = { true };
+
+	// Not copied when params change, statistics start over with the cache
+	FixedArray<PassStatistics, MAX_PASSES> pass_statistics;
+
+	ColumnCache column_cache;
+
 	// Set to `true` if the generator's configuration changed. Means a new instance of Internal has been made.
 	// Existing tasks may still finish their work using the old instance, but results will be thrown away. Such
 	// tasks can end faster if they check this boolean.
@@ -146,12 +250,27 @@ struct Internal {
 	Internal() {
 		// 1 pass minimum
 		passes.push_back(Pass());
+		pending_column_saves = make_shared_instance<PendingColumnSaves>();
 	}
 
 	inline void copy_params(const Internal &other) {
 		passes = other.passes;
 		column_base_y_blocks = other.column_base_y_blocks;
 		column_height_blocks = other.column_height_blocks;
+		column_cache_max_columns = other.column_cache_max_columns;
+		column_stream = other.column_stream;
+		pending_column_saves = other.pending_column_saves;
+	}
+
+	// Identifies params of the column structure. Columns saved with different params can't be loaded.
+	uint64_t get_params_hash() const {
+		uint64_t h = hash_djb2_one_64(passes.size());
+		for (const Pass &pass : passes) {
+			h = hash_djb2_one_64(pass.dependency_extents, h);
+		}
+		h = hash_djb2_one_64(column_base_y_blocks, h);
+		h = hash_djb2_one_64(column_height_blocks, h);
+		return h;
 	}
 };
 
@@ -167,6 +286,22 @@ struct PassInput {
 	int pass_index = 0;
 };
 
+// Columns saved in a stream store the index of the last subpass that ran on them in the metadata of each block,
+// along with a hash of the params they were generated with. Only fully generated columns are saved: partially generated
+// ones can still receive changes from passes running on their neighbors, which would be lost.
+
+inline uint64_t make_saved_column_metadata(uint64_t params_hash, int subpass_index) {
+	return (params_hash << 8) | uint8_t(subpass_index);
+}
+
+inline bool parse_saved_column_metadata(uint64_t metadata, uint64_t params_hash, int &out_subpass_index) {
+	if ((metadata >> 8) != (params_hash & 0x00ffffffffffffff)) {
+		return false;
+	}
+	out_subpass_index = metadata & 0xff;
+	return out_subpass_index < MAX_SUBPASSES;
+}
+
 } // namespace VoxelGeneratorMultipassCBStructs
 } // namespace voxel
 } // namespace zylann
@@ -115,6 +115,47 @@ VoxelGenerator::Result VoxelGeneratorFlat::generate_block(VoxelGenerator::VoxelQ
 	return result;
 }
 
+VoxelSingleValue VoxelGeneratorFlat::generate_single(Vector3i pos, unsigned int channel) {
+	VoxelSingleValue v;
+	generate_single_batch(Span<const Vector3i>(&pos, 1), channel, Span<VoxelSingleValue>(&v, 1));
+	return v;
+}
+
+void VoxelGeneratorFlat::generate_single_batch(
+		Span<const Vector3i> positions,
+		unsigned int channel,
+		Span<VoxelSingleValue> out_values
+) {
+	ZN_ASSERT_RETURN(positions.size() == out_values.size());
+
+	Parameters params;
+	{
+		RWLockRead rlock(_parameters_lock);
+		params = _parameters;
+	}
+
+	if (channel != static_cast<unsigned int>(params.channel)) {
+		out_values.fill(get_default_single_value(channel));
+		return;
+	}
+
+	if (channel == VoxelBuffer::CHANNEL_SDF) {
+		for (unsigned int i = 0; i < positions.size(); ++i) {
+			out_values[i].f = params.iso_scale * (positions[i].y - params.height);
+		}
+	} else {
+		const VoxelSingleValue air = get_default_single_value(channel);
+		for (unsigned int i = 0; i < positions.size(); ++i) {
+			// Same rounding as blocks
+			if (static_cast<int>(params.height - positions[i].y) > 0) {
+				out_values[i].i = params.voxel_type;
+			} else {
+				out_values[i] = air;
+			}
+		}
+	}
+}
+
 void VoxelGeneratorFlat::_b_set_channel(godot::VoxelBuffer::ChannelId p_channel) {
 	set_channel(VoxelBuffer::ChannelId(p_channel));
 }
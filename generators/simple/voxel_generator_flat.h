@@ -22,6 +22,17 @@ public:
 
 	Result generate_block(VoxelGenerator::VoxelQueryData &input) override;
 
+	bool supports_single_generation() const override {
+		return true;
+	}
+
+	VoxelSingleValue generate_single(Vector3i pos, unsigned int channel) override;
+	void generate_single_batch(
+			Span<const Vector3i> positions,
+			unsigned int channel,
+			Span<VoxelSingleValue> out_values
+	) override;
+
 	void set_voxel_type(int t);
 	int get_voxel_type() const;
 
@@ -63,6 +63,97 @@ float VoxelGeneratorHeightmap::get_iso_scale() const {
 	return _parameters.iso_scale;
 }
 
+void VoxelGeneratorHeightmap::generate_from_heights(
+		VoxelBuffer &out_buffer,
+		Span<const float> heights,
+		Vector3i origin,
+		int lod,
+		const Parameters &params
+) {
+	const Vector3i bs = out_buffer.get_size();
+	const int channel = params.channel;
+	const int stride = 1 << lod;
+
+	ZN_ASSERT_RETURN(heights.size() == static_cast<size_t>(bs.x * bs.z));
+
+	float min_height = heights[0];
+	float max_height = heights[0];
+	for (const float h : heights) {
+		min_height = math::min(min_height, h);
+		max_height = math::max(max_height, h);
+	}
+
+	if (channel == VoxelBuffer::CHANNEL_SDF) {
+		const VoxelBuffer::Depth depth = out_buffer.get_channel_depth(channel);
+
+		if (params.iso_scale > 0.f && (depth == VoxelBuffer::DEPTH_8_BIT || depth == VoxelBuffer::DEPTH_16_BIT)) {
+			// Quantized distances saturate beyond this, so if every voxel is further away from the ground, the whole
+			// block has the same value and can be left uniform
+			const float saturation_distance = 1.f / VoxelBuffer::get_sdf_quantization_scale(depth);
+			const float bottom_y = origin.y;
+			const float top_y = origin.y + ((bs.y - 1) << lod);
+
+			if (params.iso_scale * (bottom_y - max_height) >= saturation_distance) {
+				out_buffer.clear_channel_f(channel, saturation_distance);
+				return;
+			}
+			if (params.iso_scale * (top_y - min_height) <= -saturation_distance) {
+				out_buffer.clear_channel_f(channel, -saturation_distance);
+				return;
+			}
+		}
+
+		// Columns are contiguous in ZXY order, and each of them is a linear ramp, which compilers can vectorize
+		static thread_local StdVector<float> tls_sdf;
+		StdVector<float> &sdf = tls_sdf;
+		sdf.resize(Vector3iUtil::get_volume(bs));
+
+		const float step = params.iso_scale * stride;
+		float *column = sdf.data();
+
+		for (const float h : heights) {
+			const float start = params.iso_scale * (origin.y - h);
+			for (int y = 0; y < bs.y; ++y) {
+				column[y] = start + step * y;
+			}
+			column += bs.y;
+		}
+
+		out_buffer.copy_channel_from_floats(channel, to_span_const(sdf));
+
+	} else {
+		// Blocky. Output is blocky, so we can go for just one sample per column.
+		// Rounding heights is monotonic, so the lowest and highest columns tell if the whole block is air or ground.
+		const int min_ih = math::arithmetic_rshift(int(min_height - origin.y), lod);
+		const int max_ih = math::arithmetic_rshift(int(max_height - origin.y), lod);
+
+		if (max_ih <= 0) {
+			// All air
+			return;
+		}
+		if (min_ih >= bs.y) {
+			// All ground
+			out_buffer.clear_channel(channel, params.matter_type);
+			return;
+		}
+
+		unsigned int column_index = 0;
+
+		for (int z = 0; z < bs.z; ++z) {
+			for (int x = 0; x < bs.x; ++x) {
+				int ih = math::arithmetic_rshift(int(heights[column_index] - origin.y), lod);
+				++column_index;
+				if (ih > 0) {
+					if (ih > bs.y) {
+						ih = bs.y;
+					}
+					out_buffer.fill_area(params.matter_type, Vector3i(x, 0, z), Vector3i(x + 1, ih, z + 1), channel);
+				}
+			}
+		}
+	}
+}
+
 void VoxelGeneratorHeightmap::_b_set_channel(godot::VoxelBuffer::ChannelId p_channel) {
 	set_channel(VoxelBuffer::ChannelId(p_channel));
 }
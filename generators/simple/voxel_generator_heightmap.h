@@ -5,6 +5,7 @@
 #include "../../storage/voxel_buffer.h"
 #include "../../storage/voxel_buffer_gd.h"
 #include "../../util/containers/span.h"
+#include "../../util/containers/std_vector.h"
 #include "../../util/math/funcs.h"
 #include "../../util/math/vector3f.h"
 #include "../../util/math/vector3i.h"
@@ -47,17 +48,16 @@ protected:
 			params = _parameters;
 		}
 
-		const int channel = params.channel;
 		const Vector3i bs = out_buffer.get_size();
-		const bool use_sdf = channel == VoxelBuffer::CHANNEL_SDF;
+		const bool use_sdf = params.channel == VoxelBuffer::CHANNEL_SDF;
 
-		if (origin.y > get_height_start() + get_height_range()) {
+		if (origin.y > params.range.start + params.range.height) {
 			// The bottom of the block is above the highest ground can go (default is air)
 			Result result;
 			result.max_lod_hint = true;
 			return result;
 		}
-		if (origin.y + (bs.y << lod) < get_height_start()) {
+		if (origin.y + (bs.y << lod) < params.range.start) {
 			// The top of the block is below the lowest ground can go
 			out_buffer.clear_channel(params.channel, use_sdf ? 0 : params.matter_type);
 			Result result;
@@ -67,49 +67,23 @@ protected:
 
 		const int stride = 1 << lod;
 
-		if (use_sdf) {
-			int gz = origin.z;
-
-			for (int z = 0; z < bs.z; ++z, gz += stride) {
-				int gx = origin.x;
-
-				for (int x = 0; x < bs.x; ++x, gx += stride) {
-					float h = params.range.xform(height_func(gx, gz));
-					int gy = origin.y;
-					for (int y = 0; y < bs.y; ++y, gy += stride) {
-						const float sdf = params.iso_scale * (gy - h);
-						out_buffer.set_voxel_f(sdf, x, y, z, channel);
-					}
+		// Sample heights once per column
+		static thread_local StdVector<float> tls_heights;
+		StdVector<float> &heights = tls_heights;
+		heights.resize(bs.x * bs.z);
+		unsigned int column_index = 0;
+		int gz = origin.z;
 
-				} // for x
-			} // for z
+		for (int z = 0; z < bs.z; ++z, gz += stride) {
+			int gx = origin.x;
 
-		} else {
-			// Blocky
-
-			int gz = origin.z;
-
-			for (int z = 0; z < bs.z; ++z, gz += stride) {
-				int gx = origin.x;
-
-				for (int x = 0; x < bs.x; ++x, gx += stride) {
-					// Output is blocky, so we can go for just one sample
-					float h = params.range.xform(height_func(gx, gz));
-					h -= origin.y;
-					int ih = math::arithmetic_rshift(int(h), lod);
-					if (ih > 0) {
-						if (ih > bs.y) {
-							ih = bs.y;
-						}
-						out_buffer.fill_area(
-								params.matter_type, Vector3i(x, 0, z), Vector3i(x + 1, ih, z + 1), channel
-						);
-					}
-
-				} // for x
-			} // for z
-		} // use_sdf
+			for (int x = 0; x < bs.x; ++x, gx += stride) {
+				heights[column_index] = params.range.xform(height_func(gx, gz));
+				++column_index;
+			}
+		}
 
+		generate_from_heights(out_buffer, to_span_const(heights), origin, lod, params);
 		return Result();
 	}
 
@@ -150,6 +124,49 @@ protected:
 		}
 	}
 
+	// Gets voxel values the same way as `generate` does at LOD 0, without going through a buffer.
+	// float height_func(x, y)
+	template <typename Height_F>
+	void generate_single_batch_template(
+			Height_F height_func,
+			Span<const Vector3i> positions,
+			unsigned int channel,
+			Span<VoxelSingleValue> out_values
+	) {
+		ZN_ASSERT_RETURN(positions.size() == out_values.size());
+
+		Parameters params;
+		{
+			RWLockRead rlock(_parameters_lock);
+			params = _parameters;
+		}
+
+		if (channel != static_cast<unsigned int>(params.channel)) {
+			out_values.fill(get_default_single_value(channel));
+			return;
+		}
+
+		if (channel == VoxelBuffer::CHANNEL_SDF) {
+			for (unsigned int i = 0; i < positions.size(); ++i) {
+				const Vector3i pos = positions[i];
+				const float h = params.range.xform(height_func(pos.x, pos.z));
+				// Not quantized, since the return values are uncompressed floats
+				out_values[i].f = params.iso_scale * (pos.y - h);
+			}
+		} else {
+			const VoxelSingleValue air = get_default_single_value(channel);
+			for (unsigned int i = 0; i < positions.size(); ++i) {
+				const Vector3i pos = positions[i];
+				const float h = params.range.xform(height_func(pos.x, pos.z));
+				if (int(h - pos.y) > 0) {
+					out_values[i].i = params.matter_type;
+				} else {
+					out_values[i] = air;
+				}
+			}
+		}
+	}
+
 private:
 	static void _bind_methods();
 
@@ -169,6 +186,15 @@ private:
 		float iso_scale = 1.f;
 	};
 
+	// Fills the block from the height of each of its columns, given in ZX order.
+	static void generate_from_heights(
+			VoxelBuffer &out_buffer,
+			Span<const float> heights,
+			Vector3i origin,
+			int lod,
+			const Parameters &params
+	);
+
 	RWLock _parameters_lock;
 	Parameters _parameters;
 };
@@ -2,24 +2,43 @@
 #include "../../util/containers/fixed_array.h"
 #include "../../util/containers/span.h"
 #include "../../util/godot/classes/image.h"
+#include "../../util/memory/memory.h"
 
 namespace zylann::voxel {
 
+using zylann::godot::ImageSampler;
+
 namespace {
 
-inline float get_height_repeat(const Image &im, int x, int y) {
-	return im.get_pixel(math::wrap(x, im.get_width()), math::wrap(y, im.get_height())).r;
+inline float get_height_blurred(const ImageSampler &im, int x, int y, unsigned int mipmap) {
+	float h = im.get_pixel_repeat(x, y, mipmap);
+	h += im.get_pixel_repeat(x + 1, y, mipmap);
+	h += im.get_pixel_repeat(x - 1, y, mipmap);
+	h += im.get_pixel_repeat(x, y + 1, mipmap);
+	h += im.get_pixel_repeat(x, y - 1, mipmap);
+	return h * 0.2f;
 }
 
-inline float get_height_blurred(const Image &im, int x, int y) {
-	float h = get_height_repeat(im, x, y);
-	h += get_height_repeat(im, x + 1, y);
-	h += get_height_repeat(im, x - 1, y);
-	h += get_height_repeat(im, x, y + 1);
-	h += get_height_repeat(im, x, y - 1);
+inline float get_height_blurred_bilinear(const ImageSampler &im, float x, float y) {
+	float h = im.get_pixel_repeat_bilinear(x, y, 0);
+	h += im.get_pixel_repeat_bilinear(x + 1.f, y, 0);
+	h += im.get_pixel_repeat_bilinear(x - 1.f, y, 0);
+	h += im.get_pixel_repeat_bilinear(x, y + 1.f, 0);
+	h += im.get_pixel_repeat_bilinear(x, y - 1.f, 0);
 	return h * 0.2f;
 }
 
+// Mipmaps only line up with the full-size image when its size is a multiple of their scale. Otherwise each LOD would
+// repeat the image with a slightly different period, and seams would open between LODs far from the origin.
+unsigned int get_mipmap_for_lod(const ImageSampler &sampler, unsigned int lod) {
+	unsigned int mipmap = math::min(lod, sampler.get_mipmap_count() - 1);
+	const int size_bits = sampler.get_width(0) | sampler.get_height(0);
+	while (mipmap > 0 && (size_bits & ((1 << mipmap) - 1)) != 0) {
+		--mipmap;
+	}
+	return mipmap;
+}
+
 } // namespace
 
 VoxelGeneratorImage::VoxelGeneratorImage() {}
@@ -34,12 +53,18 @@ void VoxelGeneratorImage::set_image(Ref<Image> im) {
 		ERR_FAIL_COND(im->is_compressed());
 	}
 	_image = im;
-	Ref<Image> copy;
+	std::shared_ptr<ImageSampler> sampler;
 	if (im.is_valid()) {
-		copy = im->duplicate();
+		Ref<Image> copy = im->duplicate();
+		if (!copy->has_mipmaps()) {
+			// Used at lower LODs, where each voxel covers several pixels
+			copy->generate_mipmaps();
+		}
+		sampler = make_shared_instance<ImageSampler>();
+		sampler->set_image(copy);
 	}
 	RWLockWrite wlock(_parameters_lock);
-	_parameters.image = copy;
+	_parameters.sampler = sampler;
 }
 
 Ref<Image> VoxelGeneratorImage::get_image() const {
@@ -67,20 +92,32 @@ VoxelGenerator::Result VoxelGeneratorImage::generate_block(VoxelGenerator::Voxel
 
 	Result result;
 
-	ERR_FAIL_COND_V(params.image.is_null(), result);
-	const Image &image = **params.image;
+	ERR_FAIL_COND_V(params.sampler == nullptr, result);
+	const ImageSampler &sampler = *params.sampler;
+	ERR_FAIL_COND_V(!sampler.is_valid(), result);
+
+	// Each voxel covers `2^lod` pixels, which is what the pixels of the mipmap with the same index average.
+	const unsigned int mipmap = get_mipmap_for_lod(sampler, input.lod);
 
 	if (params.blur_enabled) {
 		result = VoxelGeneratorHeightmap::generate(
 				out_buffer,
-				[&image](int x, int z) { return get_height_blurred(image, x, z); },
+				[&sampler, mipmap](int x, int z) {
+					return get_height_blurred(
+							sampler, math::arithmetic_rshift(x, mipmap), math::arithmetic_rshift(z, mipmap), mipmap
+					);
+				},
 				input.origin_in_voxels,
 				input.lod
 		);
 	} else {
 		result = VoxelGeneratorHeightmap::generate(
 				out_buffer,
-				[&image](int x, int z) { return get_height_repeat(image, x, z); },
+				[&sampler, mipmap](int x, int z) {
+					return sampler.get_pixel_repeat(
+							math::arithmetic_rshift(x, mipmap), math::arithmetic_rshift(z, mipmap), mipmap
+					);
+				},
 				input.origin_in_voxels,
 				input.lod
 		);
@@ -90,6 +127,86 @@ VoxelGenerator::Result VoxelGeneratorImage::generate_block(VoxelGenerator::Voxel
 	return result;
 }
 
+VoxelSingleValue VoxelGeneratorImage::generate_single(Vector3i pos, unsigned int channel) {
+	VoxelSingleValue v;
+	generate_single_batch(Span<const Vector3i>(&pos, 1), channel, Span<VoxelSingleValue>(&v, 1));
+	return v;
+}
+
+void VoxelGeneratorImage::generate_single_batch(
+		Span<const Vector3i> positions,
+		unsigned int channel,
+		Span<VoxelSingleValue> out_values
+) {
+	Parameters params;
+	{
+		RWLockRead rlock(_parameters_lock);
+		params = _parameters;
+	}
+
+	ERR_FAIL_COND(params.sampler == nullptr);
+	const ImageSampler &sampler = *params.sampler;
+	ERR_FAIL_COND(!sampler.is_valid());
+
+	if (params.blur_enabled) {
+		generate_single_batch_template(
+				[&sampler](int x, int z) { return get_height_blurred(sampler, x, z, 0); },
+				positions,
+				channel,
+				out_values
+		);
+	} else {
+		generate_single_batch_template(
+				[&sampler](int x, int z) { return sampler.get_pixel_repeat(x, z, 0); }, positions, channel, out_values
+		);
+	}
+}
+
+void VoxelGeneratorImage::generate_series(
+		Span<const float> positions_x,
+		Span<const float> positions_y,
+		Span<const float> positions_z,
+		unsigned int channel,
+		Span<float> out_values,
+		Vector3f min_pos,
+		Vector3f max_pos
+) {
+	Parameters params;
+	{
+		RWLockRead rlock(_parameters_lock);
+		params = _parameters;
+	}
+
+	ERR_FAIL_COND(params.sampler == nullptr);
+	const ImageSampler &sampler = *params.sampler;
+	ERR_FAIL_COND(!sampler.is_valid());
+
+	// Positions are not necessarily on voxel corners, so heights are interpolated
+	if (params.blur_enabled) {
+		generate_series_template(
+				[&sampler](float x, float z) { return get_height_blurred_bilinear(sampler, x, z); },
+				positions_x,
+				positions_y,
+				positions_z,
+				channel,
+				out_values,
+				min_pos,
+				max_pos
+		);
+	} else {
+		generate_series_template(
+				[&sampler](float x, float z) { return sampler.get_pixel_repeat_bilinear(x, z, 0); },
+				positions_x,
+				positions_y,
+				positions_z,
+				channel,
+				out_values,
+				min_pos,
+				max_pos
+		);
+	}
+}
+
 void VoxelGeneratorImage::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_image", "image"), &VoxelGeneratorImage::set_image);
 	ClassDB::bind_method(D_METHOD("get_image"), &VoxelGeneratorImage::get_image);
@@ -1,9 +1,11 @@
 #ifndef HEADER_VOXEL_GENERATOR_IMAGE
 #define HEADER_VOXEL_GENERATOR_IMAGE
 
+#include "../../util/godot/image_sampler.h"
 #include "../../util/godot/macros.h"
 #include "../../util/thread/rw_lock.h"
 #include "voxel_generator_heightmap.h"
+#include <memory>
 
 ZN_GODOT_FORWARD_DECLARE(class Image)
 
@@ -25,6 +27,31 @@ public:
 
 	Result generate_block(VoxelGenerator::VoxelQueryData &input) override;
 
+	bool supports_single_generation() const override {
+		return true;
+	}
+
+	VoxelSingleValue generate_single(Vector3i pos, unsigned int channel) override;
+	void generate_single_batch(
+			Span<const Vector3i> positions,
+			unsigned int channel,
+			Span<VoxelSingleValue> out_values
+	) override;
+
+	bool supports_series_generation() const override {
+		return true;
+	}
+
+	void generate_series(
+			Span<const float> positions_x,
+			Span<const float> positions_y,
+			Span<const float> positions_z,
+			unsigned int channel,
+			Span<float> out_values,
+			Vector3f min_pos,
+			Vector3f max_pos
+	) override;
+
 private:
 	static void _bind_methods();
 
@@ -33,10 +60,10 @@ private:
 	Ref<Image> _image;
 
 	struct Parameters {
-		// This is a read-only copy of the image.
+		// Samples a read-only copy of the image, with mipmaps.
 		// It wastes memory for sure, but Godot does not offer any way to secure this better.
 		// If this is a problem one day, we could add an option to dereference the external image in game.
-		Ref<Image> image;
+		std::shared_ptr<const zylann::godot::ImageSampler> sampler;
 		// Mostly here as demo/tweak. It's better recommended to use an EXR/float image.
 		bool blur_enabled = false;
 	};
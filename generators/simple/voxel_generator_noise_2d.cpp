@@ -146,6 +146,41 @@ void VoxelGeneratorNoise2D::generate_series(
 	}
 }
 
+VoxelSingleValue VoxelGeneratorNoise2D::generate_single(Vector3i pos, unsigned int channel) {
+	VoxelSingleValue v;
+	generate_single_batch(Span<const Vector3i>(&pos, 1), channel, Span<VoxelSingleValue>(&v, 1));
+	return v;
+}
+
+void VoxelGeneratorNoise2D::generate_single_batch(
+		Span<const Vector3i> positions,
+		unsigned int channel,
+		Span<VoxelSingleValue> out_values
+) {
+	Parameters params;
+	{
+		RWLockRead rlock(_parameters_lock);
+		params = _parameters;
+	}
+
+	ERR_FAIL_COND(params.noise.is_null());
+	Noise &noise = **params.noise;
+
+	if (params.curve.is_null()) {
+		generate_single_batch_template(
+				[&noise](int x, int z) { return 0.5 + 0.5 * noise.get_noise_2d(x, z); }, positions, channel, out_values
+		);
+	} else {
+		Curve &curve = **params.curve;
+		generate_single_batch_template(
+				[&noise, &curve](int x, int z) { return curve.sample_baked(0.5 + 0.5 * noise.get_noise_2d(x, z)); },
+				positions,
+				channel,
+				out_values
+		);
+	}
+}
+
 void VoxelGeneratorNoise2D::_on_noise_changed() {
 	ERR_FAIL_COND(_noise.is_null());
 	RWLockWrite wlock(_parameters_lock);
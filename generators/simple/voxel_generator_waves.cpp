@@ -35,6 +35,38 @@ VoxelGenerator::Result VoxelGeneratorWaves::generate_block(VoxelGenerator::Voxel
 	);
 }
 
+VoxelSingleValue VoxelGeneratorWaves::generate_single(Vector3i pos, unsigned int channel) {
+	VoxelSingleValue v;
+	generate_single_batch(Span<const Vector3i>(&pos, 1), channel, Span<VoxelSingleValue>(&v, 1));
+	return v;
+}
+
+void VoxelGeneratorWaves::generate_single_batch(
+		Span<const Vector3i> positions,
+		unsigned int channel,
+		Span<VoxelSingleValue> out_values
+) {
+	Parameters params;
+	{
+		RWLockRead rlock(_parameters_lock);
+		params = _parameters;
+	}
+
+	const Vector2 freq(
+			Math_PI / static_cast<float>(params.pattern_size.x), Math_PI / static_cast<float>(params.pattern_size.y)
+	);
+	const Vector2 offset = params.pattern_offset;
+
+	generate_single_batch_template(
+			[freq, offset](int x, int z) {
+				return 0.5 + 0.25 * (Math::cos((x + offset.x) * freq.x) + Math::sin((z + offset.y) * freq.y));
+			},
+			positions,
+			channel,
+			out_values
+	);
+}
+
 Vector2 VoxelGeneratorWaves::get_pattern_size() const {
 	RWLockRead rlock(_parameters_lock);
 	return _parameters.pattern_size;
@@ -1,4 +1,5 @@
 #include "voxel_generator.h"
+#include "../constants/voxel_constants.h"
 #include "../constants/voxel_string_names.h"
 #include "../engine/gpu/compute_shader.h"
 #include "../engine/gpu/compute_shader_parameters.h"
@@ -16,6 +17,12 @@ VoxelGenerator::Result VoxelGenerator::generate_block(VoxelQueryData &input) {
 	return Result();
 }
 
+void VoxelGenerator::generate_blocks(Span<VoxelQueryData> blocks) {
+	for (VoxelQueryData &query : blocks) {
+		generate_block(query);
+	}
+}
+
 IThreadedTask *VoxelGenerator::create_block_task(const BlockTaskParams &params) const {
 	// Default generic task
 	return ZN_NEW(GenerateBlockTask(params));
@@ -25,22 +32,102 @@ int VoxelGenerator::get_used_channels_mask() const {
 	return 0;
 }
 
+namespace {
+
+// 1x1x1 buffer reused by the default implementation of `generate_single`, so it doesn't allocate on every call.
+// Channels keep their memory between queries, they only get reset to default values.
+struct SingleVoxelScratch {
+	VoxelBuffer buffer;
+	FixedArray<VoxelBuffer::Depth, VoxelBuffer::MAX_CHANNELS> default_depths;
+	// Generators may query other generators while generating, in which case they can't share the same buffer
+	bool in_use = false;
+
+	SingleVoxelScratch() : buffer(VoxelBuffer::ALLOCATOR_DEFAULT) {
+		buffer.create(1, 1, 1);
+		for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+			default_depths[channel_index] = buffer.get_channel_depth(channel_index);
+		}
+	}
+
+	void reset() {
+		bool format_changed = buffer.get_size() != Vector3i(1, 1, 1);
+		for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+			format_changed |= buffer.get_channel_depth(channel_index) != default_depths[channel_index];
+		}
+		if (format_changed) {
+			// Should be rare. Releases channels so their depth can be changed.
+			buffer.create(1, 1, 1);
+			for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+				buffer.set_channel_depth(channel_index, default_depths[channel_index]);
+			}
+		} else {
+			for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+				buffer.fill(VoxelBuffer::get_default_value_static(channel_index), channel_index);
+			}
+			buffer.clear_voxel_metadata();
+		}
+	}
+};
+
+thread_local SingleVoxelScratch tls_single_voxel_scratch;
+
+VoxelSingleValue get_single_value(const VoxelBuffer &buffer, unsigned int channel) {
+	VoxelSingleValue v;
+	if (channel == VoxelBuffer::CHANNEL_SDF) {
+		v.f = buffer.get_voxel_f(0, 0, 0, channel);
+	} else {
+		v.i = buffer.get_voxel(0, 0, 0, channel);
+	}
+	return v;
+}
+
+} // namespace
+
 VoxelSingleValue VoxelGenerator::generate_single(Vector3i pos, unsigned int channel) {
 	VoxelSingleValue v;
 	v.i = 0;
 	ZN_ASSERT_RETURN_V(channel < VoxelBuffer::MAX_CHANNELS, v);
-	// Default slow implementation
-	// TODO Optimize: a small part of the slowness is caused by the allocator.
-	// It is not a good use of `VoxelMemoryPool` for such a small size called so often.
-	// Instead it would be faster if it was using a temp allocator, or maybe stack-allocated.
-	VoxelBuffer buffer(VoxelBuffer::ALLOCATOR_POOL);
-	buffer.create(1, 1, 1);
-	VoxelQueryData q{ buffer, pos, 0 };
+	// Default slow implementation, generating a block of 1 voxel
+
+	SingleVoxelScratch &scratch = tls_single_voxel_scratch;
+	if (scratch.in_use) {
+		// Nested query, can't use the scratch buffer
+		VoxelBuffer buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer.create(1, 1, 1);
+		VoxelQueryData q{ buffer, pos, 0 };
+		generate_block(q);
+		return get_single_value(buffer, channel);
+	}
+
+	scratch.in_use = true;
+	scratch.reset();
+	VoxelQueryData q{ scratch.buffer, pos, 0 };
 	generate_block(q);
+	v = get_single_value(scratch.buffer, channel);
+	scratch.in_use = false;
+	return v;
+}
+
+void VoxelGenerator::generate_single_batch(
+		Span<const Vector3i> positions,
+		unsigned int channel,
+		Span<VoxelSingleValue> out_values
+) {
+	ZN_ASSERT_RETURN(positions.size() == out_values.size());
+	for (unsigned int i = 0; i < positions.size(); ++i) {
+		out_values[i] = generate_single(positions[i], channel);
+	}
+}
+
+VoxelSingleValue VoxelGenerator::get_default_single_value(unsigned int channel) {
+	VoxelSingleValue v;
 	if (channel == VoxelBuffer::CHANNEL_SDF) {
-		v.f = buffer.get_voxel_f(0, 0, 0, channel);
+		static_assert(VoxelBuffer::DEFAULT_SDF_CHANNEL_DEPTH == VoxelBuffer::DEPTH_16_BIT);
+		// Decoded the same way as in a new buffer
+		v.f = s16_to_snorm(static_cast<int16_t>(VoxelBuffer::get_default_value_static(channel))) *
+				constants::QUANTIZED_SDF_16_BITS_SCALE_INV;
 	} else {
-		v.i = buffer.get_voxel(0, 0, 0, channel);
+		v.i = VoxelBuffer::get_default_value_static(channel);
 	}
 	return v;
 }
@@ -61,6 +61,10 @@ public:
 
 	virtual Result generate_block(VoxelQueryData &input);
 
+	// Generates several blocks in one call. The default implementation calls `generate_block` for each of them.
+	// Generators having a high cost per call (like scripts) can override it to process all blocks at once.
+	virtual void generate_blocks(Span<VoxelQueryData> blocks);
+
 	struct BlockTaskParams {
 		Vector3i block_position;
 		VolumeID volume_id;
@@ -92,9 +96,21 @@ public:
 		return true;
 	}
 
-	// TODO Not sure if it's a good API regarding performance
+	// Gets the value of a single voxel at LOD 0. Prefer bulk queries if many voxels are needed.
+	// Generators computing it directly return SDF as uncompressed floats, which blocks would quantize and saturate.
+	// They also return actual distances where `generate_block` fills blocks far from the surface with placeholder
+	// values, so only the sign can be relied on there.
 	virtual VoxelSingleValue generate_single(Vector3i pos, unsigned int channel);
 
+	// Gets values of a few voxels at arbitrary positions, at LOD 0. Meant for sparse queries, like probing areas that
+	// haven't been generated yet, where generating whole blocks would be wasteful. The default implementation calls
+	// `generate_single` for each position.
+	virtual void generate_single_batch(
+			Span<const Vector3i> positions,
+			unsigned int channel,
+			Span<VoxelSingleValue> out_values
+	);
+
 	virtual void generate_series(
 			Span<const float> positions_x,
 			Span<const float> positions_y,
@@ -186,6 +202,9 @@ protected:
 
 	void _b_generate_block(Ref<godot::VoxelBuffer> out_buffer, Vector3 origin_in_voxels, int lod);
 
+	// Value voxels have in channels a generator doesn't write to, as returned by single queries
+	static VoxelSingleValue get_default_single_value(unsigned int channel);
+
 	std::shared_ptr<ComputeShader> _detail_rendering_shader;
 	std::shared_ptr<ComputeShaderParameters> _detail_rendering_shader_parameters;
 	std::shared_ptr<ComputeShader> _block_rendering_shader;
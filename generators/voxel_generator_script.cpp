@@ -5,18 +5,26 @@
 
 namespace zylann::voxel {
 
+namespace {
+
+// Creates a temporary wrapper so Godot can pass it to scripts
+Ref<godot::VoxelBuffer> create_buffer_wrapper(const VoxelBuffer &voxels) {
+	Ref<godot::VoxelBuffer> buffer_wrapper(
+			memnew(godot::VoxelBuffer(static_cast<godot::VoxelBuffer::Allocator>(voxels.get_allocator())))
+	);
+	buffer_wrapper->get_buffer().copy_format(voxels);
+	buffer_wrapper->get_buffer().create(voxels.get_size());
+	return buffer_wrapper;
+}
+
+} // namespace
+
 VoxelGeneratorScript::VoxelGeneratorScript() {}
 
 VoxelGenerator::Result VoxelGeneratorScript::generate_block(VoxelGenerator::VoxelQueryData &input) {
 	Result result;
 
-	// Create a temporary wrapper so Godot can pass it to scripts
-	Ref<godot::VoxelBuffer> buffer_wrapper(
-			memnew(godot::VoxelBuffer(static_cast<godot::VoxelBuffer::Allocator>(input.voxel_buffer.get_allocator())))
-	);
-	buffer_wrapper.instantiate();
-	buffer_wrapper->get_buffer().copy_format(input.voxel_buffer);
-	buffer_wrapper->get_buffer().create(input.voxel_buffer.get_size());
+	Ref<godot::VoxelBuffer> buffer_wrapper = create_buffer_wrapper(input.voxel_buffer);
 
 	{
 		ZN_GODOT_CHECK_REF_COUNT_DOES_NOT_CHANGE(buffer_wrapper);
@@ -37,6 +45,46 @@ VoxelGenerator::Result VoxelGeneratorScript::generate_block(VoxelGenerator::Voxe
 	return result;
 }
 
+void VoxelGeneratorScript::generate_blocks(Span<VoxelGenerator::VoxelQueryData> blocks) {
+	if (blocks.size() == 0) {
+		return;
+	}
+
+	TypedArray<godot::VoxelBuffer> buffer_wrappers;
+	TypedArray<Vector3i> origins;
+	PackedInt32Array lods;
+	buffer_wrappers.resize(blocks.size());
+	origins.resize(blocks.size());
+	lods.resize(blocks.size());
+
+	for (unsigned int i = 0; i < blocks.size(); ++i) {
+		const VoxelGenerator::VoxelQueryData &query = blocks[i];
+		buffer_wrappers[i] = create_buffer_wrapper(query.voxel_buffer);
+		origins[i] = query.origin_in_voxels;
+		lods.set(i, query.lod);
+	}
+
+	// All blocks are passed in a single call, because calling into scripts has a significant cost
+	if (!GDVIRTUAL_CALL(_generate_blocks, buffer_wrappers, origins, lods)) {
+		// Not implemented, fallback on generating blocks one by one
+		for (unsigned int i = 0; i < blocks.size(); ++i) {
+			const VoxelGenerator::VoxelQueryData &query = blocks[i];
+			Ref<godot::VoxelBuffer> buffer_wrapper = buffer_wrappers[i];
+			if (!GDVIRTUAL_CALL(_generate_block, buffer_wrapper, query.origin_in_voxels, query.lod)) {
+				WARN_PRINT_ONCE("VoxelGeneratorScript::_generate_block is unimplemented!");
+				break;
+			}
+		}
+	}
+
+	// Wrappers are discarded
+	for (unsigned int i = 0; i < blocks.size(); ++i) {
+		Ref<godot::VoxelBuffer> buffer_wrapper = buffer_wrappers[i];
+		ZN_ASSERT_CONTINUE(buffer_wrapper.is_valid());
+		buffer_wrapper->get_buffer().move_to(blocks[i].voxel_buffer);
+	}
+}
+
 int VoxelGeneratorScript::get_used_channels_mask() const {
 	int mask = 0;
 	if (!GDVIRTUAL_CALL(_get_used_channels_mask, mask)) {
@@ -47,6 +95,7 @@ int VoxelGeneratorScript::get_used_channels_mask() const {
 
 void VoxelGeneratorScript::_bind_methods() {
 	GDVIRTUAL_BIND(_generate_block, "out_buffer", "origin_in_voxels", "lod");
+	GDVIRTUAL_BIND(_generate_blocks, "out_buffers", "origins_in_voxels", "lods");
 	GDVIRTUAL_BIND(_get_used_channels_mask);
 }
 
@@ -1,14 +1,12 @@
 #ifndef VOXEL_GENERATOR_SCRIPT_H
 #define VOXEL_GENERATOR_SCRIPT_H
 
+#include "../storage/voxel_buffer_gd.h" // GDVIRTUAL wants the full definition of the class with TypedArray
 #include "../util/godot/core/gdvirtual.h"
+#include "../util/godot/core/packed_arrays.h"
+#include "../util/godot/core/typed_array.h"
 #include "voxel_generator.h"
 
-#ifdef ZN_GODOT_EXTENSION
-// GodotCpp wants the full definition of the class in GDVIRTUAL
-#include "../storage/voxel_buffer_gd.h"
-#endif
-
 namespace zylann::voxel {
 
 // Generator based on a script, like GDScript, C# or NativeScript.
@@ -19,10 +17,12 @@ public:
 	VoxelGeneratorScript();
 
 	Result generate_block(VoxelGenerator::VoxelQueryData &input) override;
+	void generate_blocks(Span<VoxelGenerator::VoxelQueryData> blocks) override;
 	int get_used_channels_mask() const override;
 
 protected:
 	GDVIRTUAL3(_generate_block, Ref<godot::VoxelBuffer>, Vector3i, int)
+	GDVIRTUAL3(_generate_blocks, TypedArray<godot::VoxelBuffer>, TypedArray<Vector3i>, PackedInt32Array)
 	GDVIRTUAL0RC(int, _get_used_channels_mask) // I think `C` means `const`?
 
 private:
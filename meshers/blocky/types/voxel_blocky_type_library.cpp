@@ -10,6 +10,7 @@
 #include "../../../util/profiling.h"
 #include "../../../util/string/format.h"
 #include "../voxel_blocky_model_cube.h"
+#include <algorithm>
 
 namespace zylann::voxel {
 
@@ -54,44 +55,107 @@ void VoxelBlockyTypeLibrary::bake() {
 	StdVector<VoxelBlockyType::VariantKey> keys;
 	VoxelBlockyModel::MaterialIndexer material_indexer{ _indexed_materials };
 
-	_baked_data.models.resize(_id_map.size());
+	_baked_data.models.resize(_id_map.ids.size());
 
 	for (size_t i = 0; i < _types.size(); ++i) {
 		Ref<VoxelBlockyType> type = _types[i];
 		ZN_ASSERT_CONTINUE_MSG(type.is_valid(), format("{} at index {} is null", ZN_CLASS_NAME_C(VoxelBlockyType), i));
 
-		type->bake(baked_models, keys, material_indexer, nullptr, get_bake_tangents());
+		bake_type(**type, material_indexer, baked_models, keys, nullptr);
+	}
 
-		VoxelID id;
-		id.type_name = type->get_unique_name();
+	finalize_baked_data();
 
-		unsigned int rel_key_index = 0;
-		for (VoxelBlockyModel::BakedData &baked_model : baked_models) {
-			// _baked_data.models.push_back(std::move(baked_model));
-			id.variant_key = keys[rel_key_index];
-
-			size_t model_index;
-			// TODO Optimize this (when needed)
-			// Find existing slot in the ID map. If found, use pre-allocated index.
-			if (!find(to_span_const(_id_map), id, model_index)) {
-				// If not found, pick an empty slot if any
-				if (!find(to_span_const(_id_map), VoxelID(), model_index)) {
-					// If not found, allocate a new index at the end
-					model_index = _baked_data.models.size();
-					_baked_data.models.push_back(VoxelBlockyModel::BakedData());
-					_id_map.push_back(id);
-				}
-			}
+	const uint64_t time_spent = Time::get_singleton()->get_ticks_usec() - time_before;
+	ZN_PRINT_VERBOSE(
+			format("Took {} us to bake VoxelLibrary, indexed {} materials", time_spent, _indexed_materials.size())
+	);
+}
 
-			_baked_data.models[model_index] = std::move(baked_model);
+void VoxelBlockyTypeLibrary::bake_types(Span<const StringName> type_names, StdVector<uint16_t> &out_model_ids) {
+	ZN_PROFILE_SCOPE();
 
-			++rel_key_index;
+	if (_baked_data.models.size() == 0) {
+		// Never baked, other types need to be baked too
+		bake();
+		RWLockRead lock(_baked_data_rw_lock);
+		for (unsigned int model_index = 0; model_index < _baked_data.models.size(); ++model_index) {
+			out_model_ids.push_back(model_index);
 		}
+		return;
+	}
 
-		baked_models.clear();
-		keys.clear();
+	RWLockWrite lock(_baked_data_rw_lock);
+
+	const size_t model_ids_begin = out_model_ids.size();
+
+	// Clear models of these types first, because variants they had before might no longer exist. Materials are kept,
+	// models of other types may still be using them.
+	for (unsigned int model_index = 0; model_index < _baked_data.models.size(); ++model_index) {
+		const StringName &type_name = _id_map.ids[model_index].type_name;
+		if (type_name != StringName() && contains(type_names, type_name)) {
+			VoxelBlockyModel::BakedData &model = _baked_data.models[model_index];
+			model = VoxelBlockyModel::BakedData();
+			model.clear();
+			out_model_ids.push_back(model_index);
+		}
+	}
+
+	StdVector<VoxelBlockyModel::BakedData> baked_models;
+	StdVector<VoxelBlockyType::VariantKey> keys;
+	VoxelBlockyModel::MaterialIndexer material_indexer{ _indexed_materials };
+
+	for (const StringName &type_name : type_names) {
+		Ref<VoxelBlockyType> type = get_type_from_name(type_name);
+		if (type.is_valid()) {
+			bake_type(**type, material_indexer, baked_models, keys, &out_model_ids);
+		}
 	}
 
+	finalize_baked_data();
+
+	// Models that were both cleared and baked are listed twice
+	const auto model_ids_it = out_model_ids.begin() + model_ids_begin;
+	std::sort(model_ids_it, out_model_ids.end());
+	out_model_ids.erase(std::unique(model_ids_it, out_model_ids.end()), out_model_ids.end());
+}
+
+void VoxelBlockyTypeLibrary::bake_type(
+		const VoxelBlockyType &type,
+		VoxelBlockyModel::MaterialIndexer &material_indexer,
+		StdVector<VoxelBlockyModel::BakedData> &baked_models,
+		StdVector<VoxelBlockyType::VariantKey> &keys,
+		StdVector<uint16_t> *out_model_ids
+) {
+	type.bake(baked_models, keys, material_indexer, nullptr, get_bake_tangents());
+
+	VoxelID id;
+	id.type_name = type.get_unique_name();
+
+	unsigned int rel_key_index = 0;
+	for (VoxelBlockyModel::BakedData &baked_model : baked_models) {
+		id.variant_key = keys[rel_key_index];
+
+		// Uses the pre-allocated index if the ID was already in the map
+		const uint32_t model_index = _id_map.get_or_create(id);
+		if (model_index >= _baked_data.models.size()) {
+			_baked_data.models.resize(model_index + 1);
+		}
+
+		_baked_data.models[model_index] = std::move(baked_model);
+
+		if (out_model_ids != nullptr && model_index < MAX_MODELS) {
+			out_model_ids->push_back(model_index);
+		}
+
+		++rel_key_index;
+	}
+
+	baked_models.clear();
+	keys.clear();
+}
+
+void VoxelBlockyTypeLibrary::finalize_baked_data() {
 	if (_baked_data.models.size() > MAX_MODELS) {
 		const int extra = _baked_data.models.size() - MAX_MODELS;
 		ZN_PRINT_ERROR(
@@ -103,18 +167,64 @@ void VoxelBlockyTypeLibrary::bake() {
 	_baked_data.indexed_materials_count = _indexed_materials.size();
 
 	generate_side_culling_matrix(_baked_data);
+	generate_random_tickable_bitset(_baked_data);
+	generate_flat_models(_baked_data);
+	++_baked_data.bake_count;
+}
 
-	const uint64_t time_spent = Time::get_singleton()->get_ticks_usec() - time_before;
-	ZN_PRINT_VERBOSE(
-			format("Took {} us to bake VoxelLibrary, indexed {} materials", time_spent, _indexed_materials.size())
-	);
+void VoxelBlockyTypeLibrary::IDMap::set_ids(StdVector<VoxelID> &&p_ids) {
+	ids = std::move(p_ids);
+	indices.clear();
+	free_indices.clear();
+
+	for (unsigned int i = 0; i < ids.size(); ++i) {
+		const VoxelID &id = ids[i];
+		if (id == VoxelID()) {
+			free_indices.push_back(i);
+		} else {
+			// If the same ID is present more than once, the first one is used
+			indices.insert({ id, i });
+		}
+	}
+
+	std::reverse(free_indices.begin(), free_indices.end());
+}
+
+int VoxelBlockyTypeLibrary::IDMap::find(const VoxelID &id) const {
+	auto it = indices.find(id);
+	if (it == indices.end()) {
+		return -1;
+	}
+	return it->second;
+}
+
+uint32_t VoxelBlockyTypeLibrary::IDMap::get_or_create(const VoxelID &id) {
+	auto it = indices.find(id);
+	if (it != indices.end()) {
+		return it->second;
+	}
+
+	uint32_t index;
+	if (free_indices.size() > 0) {
+		// Pick an empty slot if any
+		index = free_indices.back();
+		free_indices.pop_back();
+		ids[index] = id;
+	} else {
+		// Otherwise allocate a new index at the end
+		index = ids.size();
+		ids.push_back(id);
+	}
+
+	indices.insert({ id, index });
+	return index;
 }
 
 void VoxelBlockyTypeLibrary::update_id_map() {
 	update_id_map(_id_map, nullptr);
 }
 
-void VoxelBlockyTypeLibrary::update_id_map(StdVector<VoxelID> &id_map, StdVector<uint16_t> *used_ids) const {
+void VoxelBlockyTypeLibrary::update_id_map(IDMap &id_map, StdVector<uint16_t> *used_ids) const {
 	StdVector<VoxelBlockyType::VariantKey> keys;
 
 	for (size_t i = 0; i < _types.size(); ++i) {
@@ -132,17 +242,7 @@ void VoxelBlockyTypeLibrary::update_id_map(StdVector<VoxelID> &id_map, StdVector
 		for (const VoxelBlockyType::VariantKey &key : keys) {
 			id.variant_key = key;
 
-			size_t model_index;
-			// TODO Optimize this (when needed)
-			// Find existing slot in the ID map. If found, use pre-allocated index.
-			if (!find(to_span_const(id_map), id, model_index)) {
-				// If not found, pick an empty slot if any
-				if (!find(to_span_const(id_map), VoxelID(), model_index)) {
-					// If not found, allocate a new index at the end
-					model_index = id_map.size();
-					id_map.push_back(id);
-				}
-			}
+			const uint32_t model_index = id_map.get_or_create(id);
 
 			if (used_ids != nullptr) {
 				used_ids->push_back(model_index);
@@ -384,14 +484,7 @@ int VoxelBlockyTypeLibrary::get_model_index_with_attributes(StringName type_name
 }
 
 int VoxelBlockyTypeLibrary::get_model_index(const VoxelID queried_id) const {
-	// Not optimized, we'll see if it needs to be a HashMap or other
-	for (unsigned int i = 0; i < _id_map.size(); ++i) {
-		const VoxelID &id = _id_map[i];
-		if (id == queried_id) {
-			return i;
-		}
-	}
-	return -1;
+	return _id_map.find(queried_id);
 }
 
 Ref<VoxelBlockyType> VoxelBlockyTypeLibrary::get_type_from_name(StringName p_name) const {
@@ -405,8 +498,8 @@ Ref<VoxelBlockyType> VoxelBlockyTypeLibrary::get_type_from_name(StringName p_nam
 }
 
 Array VoxelBlockyTypeLibrary::get_type_name_and_attributes_from_model_index(int model_index) const {
-	ZN_ASSERT_RETURN_V(model_index >= 0 && model_index < int(_id_map.size()), Array());
-	const VoxelID &id = _id_map[model_index];
+	ZN_ASSERT_RETURN_V(model_index >= 0 && model_index < int(_id_map.ids.size()), Array());
+	const VoxelID &id = _id_map.ids[model_index];
 
 	Array ret;
 	ret.resize(2);
@@ -652,7 +745,7 @@ bool VoxelBlockyTypeLibrary::load_id_map_from_string_array(PackedStringArray map
 	ZN_PROFILE_SCOPE();
 
 	ZN_ASSERT_RETURN_V_MSG(
-			_id_map.size() == 0,
+			_id_map.ids.size() == 0,
 			false,
 			"The current ID map isn't empty. Make sure you're not accidentally overwriting data, or clear the library "
 			"first."
@@ -669,7 +762,7 @@ bool VoxelBlockyTypeLibrary::load_id_map_from_string_array(PackedStringArray map
 		ZN_ASSERT_RETURN_V(parse_voxel_id(model_str, id_map[model_index]), false);
 	}
 
-	_id_map = std::move(id_map);
+	_id_map.set_ids(std::move(id_map));
 	return true;
 }
 
@@ -677,7 +770,7 @@ bool VoxelBlockyTypeLibrary::load_id_map_from_json(String json_string) {
 	ZN_PROFILE_SCOPE();
 
 	ZN_ASSERT_RETURN_V_MSG(
-			_id_map.size() == 0,
+			_id_map.ids.size() == 0,
 			false,
 			"The current ID map isn't empty. Make sure you're not accidentally overwriting data, or clear the library "
 			"first."
@@ -749,13 +842,13 @@ PackedStringArray VoxelBlockyTypeLibrary::serialize_id_map_to_string_array(const
 }
 
 PackedStringArray VoxelBlockyTypeLibrary::serialize_id_map_to_string_array() const {
-	return serialize_id_map_to_string_array(_id_map);
+	return serialize_id_map_to_string_array(_id_map.ids);
 }
 
 void VoxelBlockyTypeLibrary::get_id_map_preview(PackedStringArray &out_ids, StdVector<uint16_t> &used_ids) const {
-	StdVector<VoxelID> id_map = _id_map;
+	IDMap id_map = _id_map;
 	update_id_map(id_map, &used_ids);
-	out_ids = serialize_id_map_to_string_array(id_map);
+	out_ids = serialize_id_map_to_string_array(id_map.ids);
 }
 
 String VoxelBlockyTypeLibrary::serialize_id_map_to_json() const {
@@ -789,6 +882,25 @@ PackedStringArray VoxelBlockyTypeLibrary::_b_serialize_id_map_to_string_array()
 	return serialize_id_map_to_string_array();
 }
 
+PackedInt32Array VoxelBlockyTypeLibrary::_b_bake_types(PackedStringArray type_names) {
+	StdVector<StringName> names;
+	names.reserve(type_names.size());
+	for (int i = 0; i < type_names.size(); ++i) {
+		names.push_back(type_names[i]);
+	}
+
+	StdVector<uint16_t> model_ids;
+	bake_types(to_span(names), model_ids);
+
+	PackedInt32Array ret;
+	ret.resize(model_ids.size());
+	Span<int32_t> ret_w(ret.ptrw(), ret.size());
+	for (unsigned int i = 0; i < model_ids.size(); ++i) {
+		ret_w[i] = model_ids[i];
+	}
+	return ret;
+}
+
 PackedStringArray VoxelBlockyTypeLibrary::_b_get_id_map() {
 	// This is a hack so that when we save a library, its internal ID map is updated and saved.
 	update_id_map();
@@ -805,6 +917,8 @@ void VoxelBlockyTypeLibrary::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_types"), &Self::_b_get_types);
 	ClassDB::bind_method(D_METHOD("set_types"), &Self::_b_set_types);
 
+	ClassDB::bind_method(D_METHOD("bake_types", "type_names"), &Self::_b_bake_types);
+
 	ClassDB::bind_method(D_METHOD("get_model_index_default", "type_name"), &Self::get_model_index_default);
 	ClassDB::bind_method(
 			D_METHOD("get_model_index_single_attribute", "type_name", "attrib_value"),
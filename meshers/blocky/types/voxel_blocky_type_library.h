@@ -1,7 +1,9 @@
 #ifndef VOXEL_BLOCKY_TYPE_LIBRARY_H
 #define VOXEL_BLOCKY_TYPE_LIBRARY_H
 
+#include "../../../util/containers/std_unordered_map.h"
 #include "../../../util/containers/std_vector.h"
+#include "../../../util/hash_funcs.h"
 #include "../voxel_blocky_library_base.h"
 #include "voxel_blocky_type.h"
 
@@ -18,6 +20,13 @@ public:
 	void clear() override;
 	void load_default() override;
 	void bake() override;
+
+	// Re-bakes only the types having one of the given names, keeping models of other types as they are. Names of types
+	// that no longer exist can be given too, their models will be cleared. Does a full bake if the library was never
+	// baked before. Other settings of the library are assumed to be the same as the last bake.
+	// Outputs the IDs of models that were re-baked, so only meshes containing them need to be rebuilt.
+	void bake_types(Span<const StringName> type_names, StdVector<uint16_t> &out_model_ids);
+
 #ifdef TOOLS_ENABLED
 	void get_configuration_warnings(PackedStringArray &out_warnings) const override;
 #endif
@@ -77,8 +86,50 @@ private:
 		}
 	};
 
+	struct VoxelIDHasher {
+		size_t operator()(const VoxelID &id) const {
+			uint32_t h = hash_murmur3_one_32(static_cast<uint32_t>(id.type_name.hash()));
+			for (unsigned int i = 0; i < id.variant_key.attribute_names.size(); ++i) {
+				const StringName &attrib_name = id.variant_key.attribute_names[i];
+				// Attributes are packed at the beginning
+				if (attrib_name == StringName()) {
+					break;
+				}
+				h = hash_murmur3_one_32(static_cast<uint32_t>(attrib_name.hash()), h);
+				h = hash_murmur3_one_32(id.variant_key.attribute_values[i], h);
+			}
+			return hash_fmix32(h);
+		}
+	};
+
+	// Maps voxel data indices to fully-qualified model names. This is used to make sure model IDs remain the same, as
+	// long as their type has the same name and attribute values are the same.
+	struct IDMap {
+		// Can refer to types that no longer exist. Empty IDs are free slots.
+		StdVector<VoxelID> ids;
+		// Index of each non-empty ID in `ids`, so they can be found without searching
+		StdUnorderedMap<VoxelID, uint32_t, VoxelIDHasher> indices;
+		// Free slots sorted in decreasing order, so the lowest one gets used first
+		StdVector<uint32_t> free_indices;
+
+		void set_ids(StdVector<VoxelID> &&p_ids);
+		int find(const VoxelID &id) const;
+		// Gets the index of an ID, assigning a slot to it if it isn't in the map yet.
+		uint32_t get_or_create(const VoxelID &id);
+	};
+
 	void update_id_map();
-	void update_id_map(StdVector<VoxelID> &id_map, StdVector<uint16_t> *used_ids) const;
+	void update_id_map(IDMap &id_map, StdVector<uint16_t> *used_ids) const;
+
+	void bake_type(
+			const VoxelBlockyType &type,
+			VoxelBlockyModel::MaterialIndexer &material_indexer,
+			StdVector<VoxelBlockyModel::BakedData> &baked_models,
+			StdVector<VoxelBlockyType::VariantKey> &keys,
+			StdVector<uint16_t> *out_model_ids
+	);
+	void finalize_baked_data();
+
 	static PackedStringArray serialize_id_map_to_string_array(const StdVector<VoxelID> &id_map);
 
 	static bool parse_voxel_id(const String &str, VoxelID &out_id);
@@ -86,6 +137,7 @@ private:
 
 	int get_model_index(const VoxelID queried_id) const;
 
+	PackedInt32Array _b_bake_types(PackedStringArray type_names);
 	PackedStringArray _b_get_id_map();
 	void _b_set_id_map(PackedStringArray sarray);
 	TypedArray<VoxelBlockyType> _b_get_types() const;
@@ -97,11 +149,8 @@ private:
 	// Unordered. Can contain nulls.
 	StdVector<Ref<VoxelBlockyType>> _types;
 
-	// Maps voxel data indices to fully-qualified model names. This is used to make sure model IDs remain the same, as
-	// long as their type has the same name and attribute values are the same.
-	// Can refer to types that no longer exist.
 	// Indices and size match `_baked_data.models`.
-	StdVector<VoxelID> _id_map;
+	IDMap _id_map;
 };
 
 } // namespace zylann::voxel
@@ -69,6 +69,9 @@ void VoxelBlockyLibrary::bake() {
 	_baked_data.indexed_materials_count = _indexed_materials.size();
 
 	generate_side_culling_matrix(_baked_data);
+	generate_random_tickable_bitset(_baked_data);
+	generate_flat_models(_baked_data);
+	++_baked_data.bake_count;
 
 	uint64_t time_spent = Time::get_singleton()->get_ticks_usec() - time_before;
 	ZN_PRINT_VERBOSE(
@@ -1,4 +1,5 @@
 #include "voxel_blocky_library_base.h"
+#include "../../util/math/conv.h"
 #include "../../util/math/triangle.h"
 #include "../../util/profiling.h"
 #include <bitset>
@@ -174,6 +175,16 @@ void rasterize_side_all_surfaces( //
 	}
 }
 
+void generate_random_tickable_bitset(VoxelBlockyLibraryBase::BakedData &baked_data) {
+	baked_data.random_tickable_models.resize_no_init(baked_data.models.size());
+	baked_data.random_tickable_models.fill(false);
+	for (unsigned int i = 0; i < baked_data.models.size(); ++i) {
+		if (baked_data.models[i].is_random_tickable) {
+			baked_data.random_tickable_models.set(i);
+		}
+	}
+}
+
 void generate_side_culling_matrix(VoxelBlockyLibraryBase::BakedData &baked_data) {
 	ZN_PROFILE_SCOPE();
 	// When two blocky voxels are next to each other, they share a side.
@@ -337,4 +348,127 @@ void generate_side_culling_matrix(VoxelBlockyLibraryBase::BakedData &baked_data)
 	print_line("");*/
 }
 
+namespace {
+
+template <typename T>
+void append_to(StdVector<T> &dst, const StdVector<T> &src) {
+	dst.insert(dst.end(), src.begin(), src.end());
+}
+
+void append_flat_part(
+		VoxelBlockyLibraryBase::FlatModels &flat,
+		VoxelBlockyLibraryBase::FlatModels::Surface &flat_surface,
+		const unsigned int part_index,
+		const StdVector<Vector3f> &positions,
+		const StdVector<Vector2f> &uvs,
+		const StdVector<int> &indices,
+		const StdVector<float> &tangents
+) {
+	VoxelBlockyLibraryBase::FlatModels::Part &part = flat_surface.parts[part_index];
+	part.vertex_begin = flat.positions.size();
+	part.vertex_count = positions.size();
+	part.index_begin = flat.indices.size();
+	part.index_count = indices.size();
+
+	append_to(flat.positions, positions);
+	append_to(flat.uvs, uvs);
+	append_to(flat.indices, indices);
+	// Keep pools parallel even if the model has inconsistent arrays
+	flat.uvs.resize(flat.positions.size());
+
+	if (tangents.size() > 0) {
+		flat_surface.tangent_parts_mask |= (1 << part_index);
+		// Tangents are allocated lazily, parallel to vertices
+		flat.tangents.resize(flat.positions.size() * 4, 0.f);
+		const unsigned int count = math::min<size_t>(tangents.size(), part.vertex_count * 4);
+		for (unsigned int i = 0; i < count; ++i) {
+			flat.tangents[part.vertex_begin * 4 + i] = tangents[i];
+		}
+	}
+}
+
+} // namespace
+
+void generate_flat_models(VoxelBlockyLibraryBase::BakedData &baked_data) {
+	ZN_PROFILE_SCOPE();
+
+	using FlatModels = VoxelBlockyLibraryBase::FlatModels;
+	FlatModels &flat = baked_data.flat_models;
+	const unsigned int model_count = baked_data.models.size();
+
+	flat.flags.resize(model_count);
+	flat.transparency_indices.resize(model_count);
+	flat.empty_sides_masks.resize(model_count);
+	flat.side_pattern_indices.resize(model_count * Cube::SIDE_COUNT);
+	flat.models.clear();
+	flat.models.resize(model_count);
+	flat.positions.clear();
+	flat.normals.clear();
+	flat.uvs.clear();
+	flat.tangents.clear();
+	flat.indices.clear();
+
+	for (unsigned int model_index = 0; model_index < model_count; ++model_index) {
+		const VoxelBlockyModel::BakedData &baked_model = baked_data.models[model_index];
+		const VoxelBlockyModel::BakedData::Model &model = baked_model.model;
+
+		uint8_t flags = 0;
+		// Empty models don't cull anything
+		if (!baked_model.empty && baked_model.culls_neighbors) {
+			flags |= FlatModels::FLAG_CULLS_NEIGHBORS;
+		}
+		if (baked_model.contributes_to_ao) {
+			flags |= FlatModels::FLAG_CONTRIBUTES_TO_AO;
+		}
+		flat.flags[model_index] = flags;
+		flat.transparency_indices[model_index] = baked_model.transparency_index;
+		flat.empty_sides_masks[model_index] = model.empty_sides_mask;
+		for (unsigned int side = 0; side < Cube::SIDE_COUNT; ++side) {
+			flat.side_pattern_indices[model_index * Cube::SIDE_COUNT + side] = model.side_pattern_indices[side];
+		}
+
+		FlatModels::Model &flat_model = flat.models[model_index];
+		flat_model.color = baked_model.color;
+		flat_model.surface_count = model.surface_count;
+
+		for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
+			const VoxelBlockyModel::BakedData::Surface &surface = model.surfaces[surface_index];
+			FlatModels::Surface &flat_surface = flat_model.surfaces[surface_index];
+			flat_surface.material_id = surface.material_id;
+			flat_surface.collision_enabled = surface.collision_enabled;
+
+			for (unsigned int side = 0; side < Cube::SIDE_COUNT; ++side) {
+				const VoxelBlockyModel::BakedData::SideSurface &side_surface = surface.sides[side];
+				append_flat_part(
+						flat,
+						flat_surface,
+						side,
+						side_surface.positions,
+						side_surface.uvs,
+						side_surface.indices,
+						side_surface.tangents
+				);
+				// Normals aren't stored in baked sides, they are the same for the whole side
+				flat.normals.resize(flat.positions.size(), to_vec3f(Cube::g_side_normals[side]));
+			}
+
+			append_flat_part(
+					flat,
+					flat_surface,
+					FlatModels::INSIDE_PART_INDEX,
+					surface.positions,
+					surface.uvs,
+					surface.indices,
+					surface.tangents
+			);
+			append_to(flat.normals, surface.normals);
+			flat.normals.resize(flat.positions.size());
+		}
+	}
+
+	if (flat.tangents.size() > 0) {
+		flat.tangents.resize(flat.positions.size() * 4, 0.f);
+	}
+}
+
 } // namespace zylann::voxel
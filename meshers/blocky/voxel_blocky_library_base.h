@@ -29,6 +29,70 @@ public:
 
 	static constexpr uint32_t NULL_INDEX = 0xFFFFFFFF;
 
+	// Baked models flattened into a few contiguous arrays, which is how the mesher reads them. Per-model baked data
+	// owns many small vectors, which would otherwise be scattered in memory and cause cache misses when meshing.
+	struct FlatModels {
+		// Geometry of either a side or the inside of a surface, as ranges in vertex and index pools.
+		// Indices are relative to the first vertex of the part.
+		struct Part {
+			uint32_t vertex_begin = 0;
+			uint32_t vertex_count = 0;
+			uint32_t index_begin = 0;
+			uint32_t index_count = 0;
+		};
+
+		// Parts are indexed with the Cube::Side enum, and the last one is the inside
+		static constexpr unsigned int INSIDE_PART_INDEX = Cube::SIDE_COUNT;
+		static constexpr unsigned int PART_COUNT = Cube::SIDE_COUNT + 1;
+
+		struct Surface {
+			FixedArray<Part, PART_COUNT> parts;
+			uint32_t material_id = 0;
+			// Bits are indexed by part
+			uint8_t tangent_parts_mask = 0;
+			bool collision_enabled = true;
+
+			inline bool has_tangents(unsigned int part_index) const {
+				return (tangent_parts_mask & (1 << part_index)) != 0;
+			}
+		};
+
+		struct Model {
+			FixedArray<Surface, VoxelBlockyModel::BakedData::Model::MAX_SURFACES> surfaces;
+			Color color;
+			uint32_t surface_count = 0;
+		};
+
+		enum Flags : uint8_t {
+			// Faces of neighbors can be culled by this model
+			FLAG_CULLS_NEIGHBORS = 1,
+			FLAG_CONTRIBUTES_TO_AO = 2
+		};
+
+		// Culling data, one item per model. It is read for every voxel and its neighbors when meshing, while geometry
+		// is only read for visible faces, so it is kept apart.
+		StdVector<uint8_t> flags;
+		StdVector<uint8_t> transparency_indices;
+		StdVector<uint8_t> empty_sides_masks;
+		// Indexed with `model_index * Cube::SIDE_COUNT + side`
+		StdVector<uint32_t> side_pattern_indices;
+
+		// One item per model
+		StdVector<Model> models;
+
+		// Geometry pools, addressed by parts
+		StdVector<Vector3f> positions;
+		StdVector<Vector3f> normals;
+		StdVector<Vector2f> uvs;
+		// 4 values per vertex, or empty if no part has tangents
+		StdVector<float> tangents;
+		StdVector<int> indices;
+
+		inline uint32_t get_side_pattern_index(uint32_t model_index, unsigned int side) const {
+			return side_pattern_indices[model_index * Cube::SIDE_COUNT + side];
+		}
+	};
+
 	struct BakedData {
 		// 2D array: { X : pattern A, Y : pattern B } => Does A occlude B
 		// Where index is X + Y * pattern count
@@ -36,6 +100,10 @@ public:
 		unsigned int side_pattern_count = 0;
 		// Lots of data can get moved but it's only on load.
 		StdVector<VoxelBlockyModel::BakedData> models;
+		// Same models, in the layout used by the mesher
+		FlatModels flat_models;
+		// Which models are random-tickable, for quick filtering without touching model data
+		DynamicBitset random_tickable_models;
 
 		// struct VariantInfo {
 		// 	uint16_t type_index;
@@ -46,10 +114,17 @@ public:
 
 		unsigned int indexed_materials_count = 0;
 
+		// Incremented every time models are baked, so data derived from them can tell when it is outdated
+		uint32_t bake_count = 0;
+
 		inline bool has_model(uint32_t i) const {
 			return i < models.size();
 		}
 
+		inline bool is_random_tickable(uint32_t i) const {
+			return i < random_tickable_models.size() && random_tickable_models.get(i);
+		}
+
 		inline bool get_side_pattern_occlusion(unsigned int pattern_a, unsigned int pattern_b) const {
 #ifdef DEBUG_ENABLED
 			CRASH_COND(pattern_a >= side_pattern_count);
@@ -110,6 +185,9 @@ protected:
 };
 
 void generate_side_culling_matrix(VoxelBlockyLibraryBase::BakedData &baked_data);
+void generate_random_tickable_bitset(VoxelBlockyLibraryBase::BakedData &baked_data);
+// Must be called after `generate_side_culling_matrix`
+void generate_flat_models(VoxelBlockyLibraryBase::BakedData &baked_data);
 
 } // namespace zylann::voxel
 
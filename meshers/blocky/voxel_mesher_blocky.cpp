@@ -27,18 +27,18 @@ const int g_opposite_side[6] = {
 
 inline bool is_face_visible(
 		const VoxelBlockyLibraryBase::BakedData &lib,
-		const VoxelBlockyModel::BakedData &vt,
+		uint32_t voxel_id,
 		uint32_t other_voxel_id,
 		int side
 ) {
-	if (other_voxel_id < lib.models.size()) {
-		const VoxelBlockyModel::BakedData &other_vt = lib.models[other_voxel_id];
-		// TODO Maybe we could get rid of `empty` here and instead set `culls_neighbors` to false during baking
-		if (other_vt.empty || (other_vt.transparency_index > vt.transparency_index) || !other_vt.culls_neighbors) {
+	const VoxelBlockyLibraryBase::FlatModels &models = lib.flat_models;
+	if (other_voxel_id < models.flags.size()) {
+		if ((models.flags[other_voxel_id] & VoxelBlockyLibraryBase::FlatModels::FLAG_CULLS_NEIGHBORS) == 0 ||
+			(models.transparency_indices[other_voxel_id] > models.transparency_indices[voxel_id])) {
 			return true;
 		} else {
-			const unsigned int ai = vt.model.side_pattern_indices[side];
-			const unsigned int bi = other_vt.model.side_pattern_indices[g_opposite_side[side]];
+			const unsigned int ai = models.get_side_pattern_index(voxel_id, side);
+			const unsigned int bi = models.get_side_pattern_index(other_voxel_id, g_opposite_side[side]);
 			// Patterns are not the same, and B does not occlude A
 			return (ai != bi) && !lib.get_side_pattern_occlusion(bi, ai);
 		}
@@ -46,14 +46,100 @@ inline bool is_face_visible(
 	return true;
 }
 
-inline bool contributes_to_ao(const VoxelBlockyLibraryBase::BakedData &lib, uint32_t voxel_id) {
-	if (voxel_id < lib.models.size()) {
-		const VoxelBlockyModel::BakedData &t = lib.models[voxel_id];
-		return t.contributes_to_ao;
+inline bool contributes_to_ao(const VoxelBlockyLibraryBase::FlatModels &models, uint32_t voxel_id) {
+	if (voxel_id < models.flags.size()) {
+		return (models.flags[voxel_id] & VoxelBlockyLibraryBase::FlatModels::FLAG_CONTRIBUTES_TO_AO) != 0;
 	}
 	return true;
 }
 
+// Appends vertices and indices of a part of a baked model, except colors
+void append_part_geometry(
+		VoxelMesherBlocky::Arrays &arrays,
+		const VoxelBlockyLibraryBase::FlatModels &models,
+		const VoxelBlockyLibraryBase::FlatModels::Part &part,
+		const bool tangents_enabled,
+		const Vector3f pos,
+		const int index_offset
+) {
+	const unsigned int vertex_count = part.vertex_count;
+
+	{
+		const unsigned int append_index = arrays.positions.size();
+		arrays.positions.resize(append_index + vertex_count);
+		Vector3f *w = arrays.positions.data() + append_index;
+		const Vector3f *src = models.positions.data() + part.vertex_begin;
+		for (unsigned int i = 0; i < vertex_count; ++i) {
+			w[i] = src[i] + pos;
+		}
+	}
+
+	{
+		const unsigned int append_index = arrays.normals.size();
+		arrays.normals.resize(append_index + vertex_count);
+		memcpy(arrays.normals.data() + append_index,
+			   models.normals.data() + part.vertex_begin,
+			   vertex_count * sizeof(Vector3f));
+	}
+
+	{
+		const unsigned int append_index = arrays.uvs.size();
+		arrays.uvs.resize(append_index + vertex_count);
+		memcpy(arrays.uvs.data() + append_index,
+			   models.uvs.data() + part.vertex_begin,
+			   vertex_count * sizeof(Vector2f));
+	}
+
+	if (tangents_enabled) {
+		const unsigned int append_index = arrays.tangents.size();
+		arrays.tangents.resize(append_index + vertex_count * 4);
+		memcpy(arrays.tangents.data() + append_index,
+			   models.tangents.data() + part.vertex_begin * 4,
+			   (vertex_count * 4) * sizeof(float));
+	}
+
+	{
+		const unsigned int index_count = part.index_count;
+		const unsigned int append_index = arrays.indices.size();
+		arrays.indices.resize(append_index + index_count);
+		int *w = arrays.indices.data() + append_index;
+		const int *src = models.indices.data() + part.index_begin;
+		for (unsigned int i = 0; i < index_count; ++i) {
+			w[i] = index_offset + src[i];
+		}
+	}
+}
+
+void append_part_collision(
+		VoxelMesher::Output::CollisionSurface &collision_surface,
+		const VoxelBlockyLibraryBase::FlatModels &models,
+		const VoxelBlockyLibraryBase::FlatModels::Part &part,
+		const Vector3f pos,
+		int &index_offset
+) {
+	{
+		const unsigned int append_index = collision_surface.positions.size();
+		collision_surface.positions.resize(append_index + part.vertex_count);
+		Vector3f *w = collision_surface.positions.data() + append_index;
+		const Vector3f *src = models.positions.data() + part.vertex_begin;
+		for (unsigned int i = 0; i < part.vertex_count; ++i) {
+			w[i] = src[i] + pos;
+		}
+	}
+
+	{
+		const unsigned int append_index = collision_surface.indices.size();
+		collision_surface.indices.resize(append_index + part.index_count);
+		int *w = collision_surface.indices.data() + append_index;
+		const int *src = models.indices.data() + part.index_begin;
+		for (unsigned int i = 0; i < part.index_count; ++i) {
+			w[i] = index_offset + src[i];
+		}
+	}
+
+	index_offset += part.vertex_count;
+}
+
 StdVector<int> &get_tls_index_offsets() {
 	static thread_local StdVector<int> tls_index_offsets;
 	return tls_index_offsets;
@@ -91,6 +177,9 @@ void generate_blocky_mesh( //
 	const Vector3i min = Vector3iUtil::create(VoxelMesherBlocky::PADDING);
 	const Vector3i max = block_size - Vector3iUtil::create(VoxelMesherBlocky::PADDING);
 
+	// Models are read from their flat layout, which is more cache-friendly
+	const VoxelBlockyLibraryBase::FlatModels &models = library.flat_models;
+
 	StdVector<int> &index_offsets = get_tls_index_offsets();
 	index_offsets.clear();
 	index_offsets.resize(out_arrays_per_material.size(), 0);
@@ -166,22 +255,26 @@ void generate_blocky_mesh( //
 					continue;
 				}
 
-				const VoxelBlockyModel::BakedData &voxel = library.models[voxel_id];
-				const VoxelBlockyModel::BakedData::Model &model = voxel.model;
+				const VoxelBlockyLibraryBase::FlatModels::Model &model = models.models[voxel_id];
+				const uint8_t empty_sides_mask = models.empty_sides_masks[voxel_id];
+				const Color modulate_color = model.color;
+
+				// Subtracting 1 because the data is padded
+				const Vector3f pos(x - 1, y - 1, z - 1);
 
 				// Hybrid approach: extract cube faces and decimate those that aren't visible,
 				// and still allow voxels to have geometry that is not a cube.
 
 				// Sides
 				for (unsigned int side = 0; side < Cube::SIDE_COUNT; ++side) {
-					if ((model.empty_sides_mask & (1 << side)) != 0) {
+					if ((empty_sides_mask & (1 << side)) != 0) {
 						// This side is empty
 						continue;
 					}
 
 					const uint32_t neighbor_voxel_id = type_buffer[voxel_index + side_neighbor_lut[side]];
 
-					if (!is_face_visible(library, voxel, neighbor_voxel_id, side)) {
+					if (!is_face_visible(library, voxel_id, neighbor_voxel_id, side)) {
 						continue;
 					}
 
@@ -202,7 +295,7 @@ void generate_blocky_mesh( //
 						for (unsigned int j = 0; j < 4; ++j) {
 							const unsigned int edge = Cube::g_side_edges[side][j];
 							const int edge_neighbor_id = type_buffer[voxel_index + edge_neighbor_lut[edge]];
-							if (contributes_to_ao(library, edge_neighbor_id)) {
+							if (contributes_to_ao(models, edge_neighbor_id)) {
 								++shaded_corner[Cube::g_edge_corners[edge][0]];
 								++shaded_corner[Cube::g_edge_corners[edge][1]];
 							}
@@ -213,73 +306,33 @@ void generate_blocky_mesh( //
 								shaded_corner[corner] = 3;
 							} else {
 								const int corner_neigbor_id = type_buffer[voxel_index + corner_neighbor_lut[corner]];
-								if (contributes_to_ao(library, corner_neigbor_id)) {
+								if (contributes_to_ao(models, corner_neigbor_id)) {
 									++shaded_corner[corner];
 								}
 							}
 						}
 					}
 
-					// Subtracting 1 because the data is padded
-					const Vector3f pos(x - 1, y - 1, z - 1);
-
 					for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
-						const VoxelBlockyModel::BakedData::Surface &surface = model.surfaces[surface_index];
+						const VoxelBlockyLibraryBase::FlatModels::Surface &surface = model.surfaces[surface_index];
+						const VoxelBlockyLibraryBase::FlatModels::Part &part = surface.parts[side];
 
 						VoxelMesherBlocky::Arrays &arrays = out_arrays_per_material[surface.material_id];
 
 						ZN_ASSERT(surface.material_id >= 0 && surface.material_id < index_offsets.size());
 						int &index_offset = index_offsets[surface.material_id];
 
-						const VoxelBlockyModel::BakedData::SideSurface &side_surface = surface.sides[side];
-
-						const StdVector<Vector3f> &side_positions = side_surface.positions;
-						const unsigned int vertex_count = side_surface.positions.size();
-
-						const StdVector<Vector2f> &side_uvs = side_surface.uvs;
-						const StdVector<float> &side_tangents = side_surface.tangents;
-
-						// Append vertices of the faces in one go, don't use push_back
-
-						{
-							const int append_index = arrays.positions.size();
-							arrays.positions.resize(arrays.positions.size() + vertex_count);
-							Vector3f *w = arrays.positions.data() + append_index;
-							for (unsigned int i = 0; i < vertex_count; ++i) {
-								w[i] = side_positions[i] + pos;
-							}
-						}
-
-						{
-							const int append_index = arrays.uvs.size();
-							arrays.uvs.resize(arrays.uvs.size() + vertex_count);
-							memcpy(arrays.uvs.data() + append_index, side_uvs.data(), vertex_count * sizeof(Vector2f));
-						}
-
-						if (side_tangents.size() > 0) {
-							const int append_index = arrays.tangents.size();
-							arrays.tangents.resize(arrays.tangents.size() + vertex_count * 4);
-							memcpy(arrays.tangents.data() + append_index,
-								   side_tangents.data(),
-								   (vertex_count * 4) * sizeof(float));
-						}
-
-						{
-							const int append_index = arrays.normals.size();
-							arrays.normals.resize(arrays.normals.size() + vertex_count);
-							Vector3f *w = arrays.normals.data() + append_index;
-							for (unsigned int i = 0; i < vertex_count; ++i) {
-								w[i] = to_vec3f(Cube::g_side_normals[side]);
-							}
-						}
+						append_part_geometry(arrays, models, part, surface.has_tangents(side), pos, index_offset);
 
 						{
+							const unsigned int vertex_count = part.vertex_count;
 							const int append_index = arrays.colors.size();
 							arrays.colors.resize(arrays.colors.size() + vertex_count);
 							Color *w = arrays.colors.data() + append_index;
-							const Color modulate_color = voxel.color;
 
 							if (bake_occlusion) {
+								const Vector3f *side_positions = models.positions.data() + part.vertex_begin;
+
 								for (unsigned int i = 0; i < vertex_count; ++i) {
 									const Vector3f vertex_pos = side_positions[i];
 
@@ -316,108 +369,47 @@ void generate_blocky_mesh( //
 							}
 						}
 
-						const StdVector<int> &side_indices = side_surface.indices;
-						const unsigned int index_count = side_indices.size();
-
-						{
-							int i = arrays.indices.size();
-							arrays.indices.resize(arrays.indices.size() + index_count);
-							int *w = arrays.indices.data();
-							for (unsigned int j = 0; j < index_count; ++j) {
-								w[i++] = index_offset + side_indices[j];
-							}
-						}
-
 						if (collision_surface != nullptr && surface.collision_enabled) {
-							StdVector<Vector3f> &dst_positions = collision_surface->positions;
-							StdVector<int> &dst_indices = collision_surface->indices;
-
-							{
-								const unsigned int append_index = dst_positions.size();
-								dst_positions.resize(dst_positions.size() + vertex_count);
-								Vector3f *w = dst_positions.data() + append_index;
-								for (unsigned int i = 0; i < vertex_count; ++i) {
-									w[i] = side_positions[i] + pos;
-								}
-							}
-
-							{
-								int i = dst_indices.size();
-								dst_indices.resize(dst_indices.size() + index_count);
-								int *w = dst_indices.data();
-								for (unsigned int j = 0; j < index_count; ++j) {
-									w[i++] = collision_surface_index_offset + side_indices[j];
-								}
-							}
-
-							collision_surface_index_offset += vertex_count;
+							append_part_collision(
+									*collision_surface, models, part, pos, collision_surface_index_offset
+							);
 						}
 
-						index_offset += vertex_count;
+						index_offset += part.vertex_count;
 					}
 				}
 
 				// Inside
 				for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
-					const VoxelBlockyModel::BakedData::Surface &surface = model.surfaces[surface_index];
-					if (surface.positions.size() == 0) {
+					const VoxelBlockyLibraryBase::FlatModels::Surface &surface = model.surfaces[surface_index];
+					const VoxelBlockyLibraryBase::FlatModels::Part &part =
+							surface.parts[VoxelBlockyLibraryBase::FlatModels::INSIDE_PART_INDEX];
+					if (part.vertex_count == 0) {
 						continue;
 					}
-					// TODO Get rid of push_backs
 
 					VoxelMesherBlocky::Arrays &arrays = out_arrays_per_material[surface.material_id];
 
 					ZN_ASSERT(surface.material_id >= 0 && surface.material_id < index_offsets.size());
 					int &index_offset = index_offsets[surface.material_id];
 
-					const StdVector<Vector3f> &positions = surface.positions;
-					const unsigned int vertex_count = positions.size();
-					const Color modulate_color = voxel.color;
-
-					const StdVector<Vector3f> &normals = surface.normals;
-					const StdVector<Vector2f> &uvs = surface.uvs;
-					const StdVector<float> &tangents = surface.tangents;
+					append_part_geometry(
+							arrays,
+							models,
+							part,
+							surface.has_tangents(VoxelBlockyLibraryBase::FlatModels::INSIDE_PART_INDEX),
+							pos,
+							index_offset
+					);
 
-					const Vector3f pos(x - 1, y - 1, z - 1);
-
-					if (tangents.size() > 0) {
-						const int append_index = arrays.tangents.size();
-						arrays.tangents.resize(arrays.tangents.size() + vertex_count * 4);
-						memcpy(arrays.tangents.data() + append_index,
-							   tangents.data(),
-							   (vertex_count * 4) * sizeof(float));
-					}
-
-					for (unsigned int i = 0; i < vertex_count; ++i) {
-						arrays.normals.push_back(normals[i]);
-						arrays.uvs.push_back(uvs[i]);
-						arrays.positions.push_back(positions[i] + pos);
-						// TODO handle ambient occlusion on inner parts
-						arrays.colors.push_back(modulate_color);
-					}
-
-					const StdVector<int> &indices = surface.indices;
-					const unsigned int index_count = indices.size();
-
-					for (unsigned int i = 0; i < index_count; ++i) {
-						arrays.indices.push_back(index_offset + indices[i]);
-					}
+					// TODO handle ambient occlusion on inner parts
+					arrays.colors.resize(arrays.colors.size() + part.vertex_count, modulate_color);
 
 					if (collision_surface != nullptr && surface.collision_enabled) {
-						StdVector<Vector3f> &dst_positions = collision_surface->positions;
-						StdVector<int> &dst_indices = collision_surface->indices;
-
-						for (unsigned int i = 0; i < vertex_count; ++i) {
-							dst_positions.push_back(positions[i] + pos);
-						}
-						for (unsigned int i = 0; i < index_count; ++i) {
-							dst_indices.push_back(collision_surface_index_offset + indices[i]);
-						}
-
-						collision_surface_index_offset += vertex_count;
+						append_part_collision(*collision_surface, models, part, pos, collision_surface_index_offset);
 					}
 
-					index_offset += vertex_count;
+					index_offset += part.vertex_count;
 				}
 			}
 		}
@@ -39,6 +39,7 @@
 #include "storage/metadata/voxel_metadata_variant.h"
 #include "storage/voxel_buffer_gd.h"
 #include "storage/voxel_memory_pool.h"
+#include "storage/voxel_schematic_gd.h"
 #include "streams/region/voxel_stream_region_files.h"
 #include "streams/sqlite/voxel_stream_sqlite.h"
 #include "streams/vox/vox_loader.h"
@@ -242,6 +243,7 @@ void initialize_voxel_module(ModuleInitializationLevel p_level) {
 
 		// Storage
 		ClassDB::register_class<zylann::voxel::godot::VoxelBuffer>();
+		ClassDB::register_class<zylann::voxel::godot::VoxelSchematic>();
 
 		// Nodes
 		ClassDB::register_abstract_class<VoxelNode>();
@@ -0,0 +1,292 @@
+#include "chunked_voxel_buffer.h"
+#include "../constants/voxel_constants.h"
+#include "../util/profiling.h"
+
+namespace zylann::voxel {
+
+OrthoGridTransform OrthoGridTransform::create(Vector3i src_size, IntBasis basis) {
+	ZN_ASSERT(Vector3iUtil::is_unit_vector(basis.x));
+	ZN_ASSERT(Vector3iUtil::is_unit_vector(basis.y));
+	ZN_ASSERT(Vector3iUtil::is_unit_vector(basis.z));
+
+	OrthoGridTransform t;
+	t.basis = basis;
+	// The inverse of an orthogonal matrix is its transpose
+	t.inverse_basis.x = Vector3i(basis.x.x, basis.y.x, basis.z.x);
+	t.inverse_basis.y = Vector3i(basis.x.y, basis.y.y, basis.z.y);
+	t.inverse_basis.z = Vector3i(basis.x.z, basis.y.z, basis.z.z);
+	t.src_size = src_size;
+
+	// Axes pointing in negative directions make the transformed box start below zero, so it has to be offset
+	const Vector3i transformed_size = src_size.x * basis.x + src_size.y * basis.y + src_size.z * basis.z;
+	const Vector3i max_t = (src_size.x - 1) * basis.x + (src_size.y - 1) * basis.y + (src_size.z - 1) * basis.z;
+	t.dst_size = math::abs(transformed_size);
+	t.offset = Vector3i(max_t.x < 0 ? -max_t.x : 0, max_t.y < 0 ? -max_t.y : 0, max_t.z < 0 ? -max_t.z : 0);
+
+	t.identity = basis.x == Vector3i(1, 0, 0) && basis.y == Vector3i(0, 1, 0) && basis.z == Vector3i(0, 0, 1);
+	return t;
+}
+
+Box3i OrthoGridTransform::src_to_dst(const Box3i box) const {
+	const Vector3i a = src_to_dst(box.position);
+	const Vector3i b = src_to_dst(box.position + box.size - Vector3i(1, 1, 1));
+	return Box3i::from_min_max(math::min(a, b), math::max(a, b) + Vector3i(1, 1, 1));
+}
+
+Box3i OrthoGridTransform::dst_to_src(const Box3i box) const {
+	const Vector3i a = dst_to_src(box.position);
+	const Vector3i b = dst_to_src(box.position + box.size - Vector3i(1, 1, 1));
+	return Box3i::from_min_max(math::min(a, b), math::max(a, b) + Vector3i(1, 1, 1));
+}
+
+ChunkedVoxelBuffer::ChunkedVoxelBuffer() : _block_size_po2(constants::DEFAULT_BLOCK_SIZE_PO2) {}
+
+void ChunkedVoxelBuffer::create(Vector3i size, unsigned int block_size_po2) {
+	ZN_ASSERT_RETURN(Vector3iUtil::is_valid_size(size));
+	ZN_ASSERT_RETURN(block_size_po2 > 0 && block_size_po2 <= 8);
+
+	clear();
+
+	_size = size;
+	_block_size_po2 = block_size_po2;
+	_size_in_blocks = Box3i(Vector3i(), size).downscaled(get_block_size()).size;
+	_blocks.resize(Vector3iUtil::get_volume(_size_in_blocks));
+}
+
+void ChunkedVoxelBuffer::clear() {
+	_blocks.clear();
+	_size = Vector3i();
+	_size_in_blocks = Vector3i();
+}
+
+Box3i ChunkedVoxelBuffer::get_block_box(Vector3i bpos) const {
+	return Box3i(bpos << _block_size_po2, Vector3iUtil::create(get_block_size())).clipped(_size);
+}
+
+void ChunkedVoxelBuffer::set_block(Vector3i bpos, std::shared_ptr<VoxelBuffer> voxels) {
+	ZN_ASSERT_RETURN(Box3i(Vector3i(), _size_in_blocks).contains(bpos));
+	const unsigned int i = Vector3iUtil::get_zxy_index(bpos, _size_in_blocks);
+
+	if (voxels == nullptr) {
+		_blocks[i] = nullptr;
+		return;
+	}
+
+	ZN_ASSERT_RETURN(voxels->get_size() == get_block_box(bpos).size);
+
+	voxels->compress_uniform_channels();
+
+	bool all_defaults = true;
+	for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+		if (voxels->get_channel_compression(channel_index) != VoxelBuffer::COMPRESSION_UNIFORM ||
+			voxels->get_voxel(0, 0, 0, channel_index) != VoxelBuffer::get_default_value_static(channel_index)) {
+			all_defaults = false;
+			break;
+		}
+	}
+
+	if (all_defaults) {
+		// Missing blocks are treated as default values, no need to store them
+		_blocks[i] = nullptr;
+	} else {
+		_blocks[i] = voxels;
+	}
+}
+
+uint64_t ChunkedVoxelBuffer::get_voxel(Vector3i pos, unsigned int channel_index) const {
+	ZN_ASSERT_RETURN_V(Box3i(Vector3i(), _size).contains(pos), 0);
+	ZN_ASSERT_RETURN_V(channel_index < VoxelBuffer::MAX_CHANNELS, 0);
+	const Vector3i bpos = pos >> _block_size_po2;
+	const VoxelBuffer *block = get_block(bpos);
+	if (block == nullptr) {
+		return VoxelBuffer::get_default_value_static(channel_index);
+	}
+	return block->get_voxel(pos - (bpos << _block_size_po2), channel_index);
+}
+
+float ChunkedVoxelBuffer::get_voxel_f(Vector3i pos, unsigned int channel_index) const {
+	ZN_ASSERT_RETURN_V(Box3i(Vector3i(), _size).contains(pos), 0);
+	ZN_ASSERT_RETURN_V(channel_index < VoxelBuffer::MAX_CHANNELS, 0);
+	const Vector3i bpos = pos >> _block_size_po2;
+	const VoxelBuffer *block = get_block(bpos);
+	if (block == nullptr) {
+		return VoxelBuffer::get_default_value_f_static(channel_index);
+	}
+	return block->get_voxel_f(pos - (bpos << _block_size_po2), channel_index);
+}
+
+unsigned int ChunkedVoxelBuffer::get_allocated_block_count() const {
+	unsigned int count = 0;
+	for (const std::shared_ptr<VoxelBuffer> &block : _blocks) {
+		if (block != nullptr) {
+			++count;
+		}
+	}
+	return count;
+}
+
+namespace {
+
+// Copies a box of voxels from a source grid into a destination grid, applying a transform to positions.
+template <typename T>
+void copy_3d_region_transformed_zxy(
+		Span<const T> src,
+		const Vector3i src_size,
+		const Box3i src_box,
+		// Position of the source grid within the transformed source space
+		const Vector3i src_origin,
+		Span<T> dst,
+		const Vector3i dst_size,
+		// Position of the transformed space within the destination grid
+		const Vector3i dst_origin,
+		const OrthoGridTransform &transform
+) {
+	// Each step along a source axis corresponds to a constant step in the destination array
+	const int dst_stride_y = 1;
+	const int dst_stride_x = dst_size.y;
+	const int dst_stride_z = dst_size.y * dst_size.x;
+	const int dst_step_x = transform.basis.x.x * dst_stride_x + transform.basis.x.y * dst_stride_y +
+			transform.basis.x.z * dst_stride_z;
+	const int dst_step_y = transform.basis.y.x * dst_stride_x + transform.basis.y.y * dst_stride_y +
+			transform.basis.y.z * dst_stride_z;
+	const int dst_step_z = transform.basis.z.x * dst_stride_x + transform.basis.z.y * dst_stride_y +
+			transform.basis.z.z * dst_stride_z;
+
+	const Vector3i src_min = src_box.position;
+	const Vector3i src_max = src_box.position + src_box.size;
+
+	const int dst_start_i =
+			Vector3iUtil::get_zxy_index(transform.src_to_dst(src_origin + src_min) + dst_origin, dst_size);
+
+	int dst_iz = dst_start_i;
+	for (int z = src_min.z; z < src_max.z; ++z) {
+		int dst_ix = dst_iz;
+		for (int x = src_min.x; x < src_max.x; ++x) {
+			unsigned int src_i = Vector3iUtil::get_zxy_index(Vector3i(x, src_min.y, z), src_size);
+			int dst_i = dst_ix;
+			for (int y = src_min.y; y < src_max.y; ++y) {
+#ifdef DEBUG_ENABLED
+				ZN_ASSERT(dst_i >= 0 && static_cast<unsigned int>(dst_i) < dst.size());
+#endif
+				dst[dst_i] = src[src_i];
+				++src_i;
+				dst_i += dst_step_y;
+			}
+			dst_ix += dst_step_x;
+		}
+		dst_iz += dst_step_z;
+	}
+}
+
+template <typename T>
+void paste_channel_transformed(
+		const VoxelBuffer &src,
+		const Box3i src_box,
+		const Vector3i src_origin,
+		VoxelBuffer &dst,
+		const Vector3i dst_origin,
+		const OrthoGridTransform &transform,
+		const unsigned int channel_index
+) {
+	Span<const T> src_data;
+	ZN_ASSERT_RETURN(src.get_channel_data_read_only(channel_index, src_data));
+	dst.decompress_channel(channel_index);
+	Span<T> dst_data;
+	ZN_ASSERT_RETURN(dst.get_channel_data(channel_index, dst_data));
+	copy_3d_region_transformed_zxy(
+			src_data, src.get_size(), src_box, src_origin, dst_data, dst.get_size(), dst_origin, transform
+	);
+}
+
+} // namespace
+
+void ChunkedVoxelBuffer::paste_to(
+		Span<const uint8_t> channels,
+		const OrthoGridTransform &transform,
+		VoxelBuffer &dst,
+		Vector3i dst_base_pos
+) const {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(transform.src_size == _size);
+
+	const Box3i dst_box = Box3i(dst_base_pos, transform.dst_size).clipped(dst.get_size());
+	if (dst_box.is_empty()) {
+		return;
+	}
+
+	// Find which part of the source we need, then go through it one source block at a time
+	const Box3i src_box = transform.dst_to_src(Box3i(dst_box.position - dst_base_pos, dst_box.size));
+	const Box3i src_blocks_box = src_box.downscaled(get_block_size());
+
+	src_blocks_box.for_each_cell_zxy([this, channels, &transform, &dst, dst_base_pos, &src_box](Vector3i bpos) {
+		const Box3i block_box = get_block_box(bpos);
+		const Box3i local_src_box = block_box.clipped(src_box);
+		if (local_src_box.is_empty()) {
+			return;
+		}
+		const Box3i local_dst_box = transform.src_to_dst(local_src_box);
+		const Vector3i dst_min = local_dst_box.position + dst_base_pos;
+		const Vector3i dst_max = dst_min + local_dst_box.size;
+
+		const VoxelBuffer *block = get_block(bpos);
+
+		for (const uint8_t channel_index : channels) {
+			if (block == nullptr) {
+				dst.fill_area(VoxelBuffer::get_default_value_static(channel_index), dst_min, dst_max, channel_index);
+				continue;
+			}
+
+			if (block->get_channel_compression(channel_index) == VoxelBuffer::COMPRESSION_UNIFORM) {
+				// Same value everywhere, no need to care about the transform
+				dst.fill_area(block->get_voxel(0, 0, 0, channel_index), dst_min, dst_max, channel_index);
+				continue;
+			}
+
+			ZN_ASSERT_CONTINUE_MSG(
+					block->get_channel_depth(channel_index) == dst.get_channel_depth(channel_index),
+					"Source and destination channels have different depths"
+			);
+
+			if (transform.identity) {
+				dst.copy_channel_from(
+						*block,
+						local_src_box.position - block_box.position,
+						local_src_box.position + local_src_box.size - block_box.position,
+						dst_min,
+						channel_index
+				);
+				continue;
+			}
+
+			const Box3i block_local_src_box(local_src_box.position - block_box.position, local_src_box.size);
+
+			switch (block->get_channel_depth(channel_index)) {
+				case VoxelBuffer::DEPTH_8_BIT:
+					paste_channel_transformed<uint8_t>(
+							*block, block_local_src_box, block_box.position, dst, dst_base_pos, transform, channel_index
+					);
+					break;
+				case VoxelBuffer::DEPTH_16_BIT:
+					paste_channel_transformed<uint16_t>(
+							*block, block_local_src_box, block_box.position, dst, dst_base_pos, transform, channel_index
+					);
+					break;
+				case VoxelBuffer::DEPTH_32_BIT:
+					paste_channel_transformed<uint32_t>(
+							*block, block_local_src_box, block_box.position, dst, dst_base_pos, transform, channel_index
+					);
+					break;
+				case VoxelBuffer::DEPTH_64_BIT:
+					paste_channel_transformed<uint64_t>(
+							*block, block_local_src_box, block_box.position, dst, dst_base_pos, transform, channel_index
+					);
+					break;
+				default:
+					ZN_PRINT_ERROR("Unhandled depth");
+					break;
+			}
+		}
+	});
+}
+
+} // namespace zylann::voxel
@@ -0,0 +1,113 @@
+#ifndef VOXEL_CHUNKED_VOXEL_BUFFER_H
+#define VOXEL_CHUNKED_VOXEL_BUFFER_H
+
+#include "../util/containers/span.h"
+#include "../util/containers/std_vector.h"
+#include "../util/math/box3i.h"
+#include "funcs.h"
+#include "voxel_buffer.h"
+#include <memory>
+
+namespace zylann::voxel {
+
+// Maps positions of a box of voxels into the same box rotated and/or mirrored by an orthogonal basis, such that the
+// transformed box still starts at (0,0,0).
+struct OrthoGridTransform {
+	// Columns of the basis: where source axes point in the destination
+	IntBasis basis;
+	IntBasis inverse_basis;
+	Vector3i offset;
+	Vector3i src_size;
+	Vector3i dst_size;
+	bool identity = true;
+
+	// `basis` axes must be unit vectors, perpendicular to each other. They may be negative, which mirrors the box.
+	static OrthoGridTransform create(Vector3i src_size, IntBasis basis);
+
+	inline Vector3i src_to_dst(const Vector3i p) const {
+		return p.x * basis.x + p.y * basis.y + p.z * basis.z + offset;
+	}
+
+	inline Vector3i dst_to_src(const Vector3i p) const {
+		const Vector3i d = p - offset;
+		return d.x * inverse_basis.x + d.y * inverse_basis.y + d.z * inverse_basis.z;
+	}
+
+	Box3i src_to_dst(const Box3i box) const;
+	Box3i dst_to_src(const Box3i box) const;
+};
+
+// Stores voxels of a potentially large area as a grid of blocks, for example to copy and paste structures.
+// Unlike a single VoxelBuffer, it is not limited by `VoxelBuffer::MAX_SIZE`, and can be filled or read one block at a
+// time. Blocks are stored sparsely: channels that have the same value everywhere in a block are kept compressed, and
+// blocks containing only default values are not stored at all.
+// Blocks on the positive edges are smaller if the size is not a multiple of the block size.
+class ChunkedVoxelBuffer {
+public:
+	ChunkedVoxelBuffer();
+
+	// Resets the buffer to default values with a new size.
+	void create(Vector3i size, unsigned int block_size_po2);
+	void clear();
+
+	inline Vector3i get_size() const {
+		return _size;
+	}
+
+	inline Vector3i get_size_in_blocks() const {
+		return _size_in_blocks;
+	}
+
+	inline unsigned int get_block_size_po2() const {
+		return _block_size_po2;
+	}
+
+	inline unsigned int get_block_size() const {
+		return 1 << _block_size_po2;
+	}
+
+	// Box covered by a block, in voxels, relative to the origin of the buffer.
+	Box3i get_block_box(Vector3i bpos) const;
+
+	// Sets voxels of a block. The buffer must have the size of the box returned by `get_block_box`.
+	// Uniform channels get compressed, and the block is not stored if it only contains default values.
+	void set_block(Vector3i bpos, std::shared_ptr<VoxelBuffer> voxels);
+
+	// Returns nullptr if the block only contains default values.
+	inline const VoxelBuffer *get_block(Vector3i bpos) const {
+		const unsigned int i = Vector3iUtil::get_zxy_index(bpos, _size_in_blocks);
+#ifdef DEBUG_ENABLED
+		ZN_ASSERT(i < _blocks.size());
+#endif
+		return _blocks[i].get();
+	}
+
+	// Gets a raw voxel value. This is a convenience for random access, prefer working per block when possible.
+	uint64_t get_voxel(Vector3i pos, unsigned int channel_index) const;
+	float get_voxel_f(Vector3i pos, unsigned int channel_index) const;
+
+	// Number of blocks actually holding data
+	unsigned int get_allocated_block_count() const;
+
+	// Pastes the contents of the buffer transformed by `transform` into `dst`.
+	// `dst_base_pos` is where the transformed box starts, relative to the origin of `dst`. Voxels falling outside of
+	// `dst` are ignored.
+	// Channels must have the same depth in source blocks and in the destination. Metadata is not copied.
+	void paste_to(
+			Span<const uint8_t> channels,
+			const OrthoGridTransform &transform,
+			VoxelBuffer &dst,
+			Vector3i dst_base_pos
+	) const;
+
+private:
+	Vector3i _size;
+	Vector3i _size_in_blocks;
+	uint8_t _block_size_po2;
+	// Blocks in ZXY order
+	StdVector<std::shared_ptr<VoxelBuffer>> _blocks;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_CHUNKED_VOXEL_BUFFER_H
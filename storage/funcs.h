@@ -212,10 +212,11 @@ Vector3i transform_3d_array_zxy(Span<const T> src_grid, Span<T> dst_grid, Vector
 	dst_size[ya] = src_size.y;
 	dst_size[za] = src_size.z;
 
-	// If an axis is negative, it means iteration starts from the end
-	const int ox = basis.get_axis(xa).x < 0 ? dst_size.x - 1 : 0;
-	const int oy = basis.get_axis(ya).y < 0 ? dst_size.y - 1 : 0;
-	const int oz = basis.get_axis(za).z < 0 ? dst_size.z - 1 : 0;
+	// If an axis is negative, it means iteration starts from the end. Only one of the basis vectors has a non-zero
+	// component along each destination axis.
+	const int ox = basis.x.x + basis.y.x + basis.z.x < 0 ? dst_size.x - 1 : 0;
+	const int oy = basis.x.y + basis.y.y + basis.z.y < 0 ? dst_size.y - 1 : 0;
+	const int oz = basis.x.z + basis.y.z + basis.z.z < 0 ? dst_size.z - 1 : 0;
 
 	int src_i = 0;
 
@@ -146,6 +146,22 @@ uint64_t VoxelBuffer::get_default_value_static(unsigned int channel_index) {
 	return g_default_values[channel_index];
 }
 
+real_t VoxelBuffer::get_default_value_f_static(unsigned int channel_index) {
+	ZN_ASSERT(channel_index < MAX_CHANNELS);
+	// Depths channels have after `init_channel_defaults`
+	static const Depth default_depths[MAX_CHANNELS] = {
+		DEFAULT_TYPE_CHANNEL_DEPTH, //
+		DEFAULT_SDF_CHANNEL_DEPTH, //
+		DEFAULT_CHANNEL_DEPTH, //
+		DEFAULT_INDICES_CHANNEL_DEPTH, //
+		DEFAULT_WEIGHTS_CHANNEL_DEPTH, //
+		DEFAULT_CHANNEL_DEPTH, //
+		DEFAULT_CHANNEL_DEPTH, //
+		DEFAULT_CHANNEL_DEPTH //
+	};
+	return raw_voxel_to_real(g_default_values[channel_index], default_depths[channel_index]);
+}
+
 // VoxelBuffer::VoxelBuffer() {
 // 	init_channel_defaults();
 // }
@@ -878,6 +894,193 @@ bool VoxelBuffer::equals(const VoxelBuffer &p_other) const {
 	return true;
 }
 
+namespace {
+
+template <typename T>
+void xor_values(Span<T> dst, const T v) {
+	for (T &d : dst) {
+		d ^= v;
+	}
+}
+
+} // namespace
+
+void VoxelBuffer::xor_channels_from(const VoxelBuffer &other) {
+	ZN_ASSERT_RETURN(other._size == _size);
+
+	for (unsigned int channel_index = 0; channel_index < MAX_CHANNELS; ++channel_index) {
+		Channel &channel = _channels[channel_index];
+		const Channel &other_channel = other._channels[channel_index];
+		ZN_ASSERT_CONTINUE(channel.depth == other_channel.depth);
+
+		if (other_channel.compression == COMPRESSION_UNIFORM) {
+			if (other_channel.defval == 0) {
+				continue;
+			}
+			if (channel.compression == COMPRESSION_UNIFORM) {
+				channel.defval ^= other_channel.defval;
+				continue;
+			}
+			Span<uint8_t> data(channel.data, channel.size_in_bytes);
+			switch (channel.depth) {
+				case DEPTH_8_BIT:
+					xor_values(data, static_cast<uint8_t>(other_channel.defval));
+					break;
+				case DEPTH_16_BIT:
+					xor_values(data.reinterpret_cast_to<uint16_t>(), static_cast<uint16_t>(other_channel.defval));
+					break;
+				case DEPTH_32_BIT:
+					xor_values(data.reinterpret_cast_to<uint32_t>(), static_cast<uint32_t>(other_channel.defval));
+					break;
+				case DEPTH_64_BIT:
+					xor_values(data.reinterpret_cast_to<uint64_t>(), other_channel.defval);
+					break;
+				default:
+					CRASH_NOW();
+					break;
+			}
+
+		} else {
+			decompress_channel(channel_index);
+			ZN_ASSERT_CONTINUE(channel.size_in_bytes == other_channel.size_in_bytes);
+			for (size_t i = 0; i < channel.size_in_bytes; ++i) {
+				channel.data[i] ^= other_channel.data[i];
+			}
+		}
+	}
+}
+
+void VoxelBuffer::copy_channel_to_bytes(unsigned int channel_index, Span<uint8_t> dst) const {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(channel_index < MAX_CHANNELS);
+	const Channel &channel = _channels[channel_index];
+	ZN_ASSERT_RETURN(dst.size() == get_size_in_bytes_for_volume(_size, channel.depth));
+
+	if (channel.compression != COMPRESSION_UNIFORM) {
+		memcpy(dst.data(), channel.data, dst.size());
+		return;
+	}
+
+	switch (channel.depth) {
+		case DEPTH_8_BIT:
+			dst.fill(static_cast<uint8_t>(channel.defval));
+			break;
+		case DEPTH_16_BIT:
+			dst.reinterpret_cast_to<uint16_t>().fill(static_cast<uint16_t>(channel.defval));
+			break;
+		case DEPTH_32_BIT:
+			dst.reinterpret_cast_to<uint32_t>().fill(static_cast<uint32_t>(channel.defval));
+			break;
+		case DEPTH_64_BIT:
+			dst.reinterpret_cast_to<uint64_t>().fill(channel.defval);
+			break;
+		default:
+			CRASH_NOW();
+			break;
+	}
+}
+
+void VoxelBuffer::copy_channel_from_bytes(unsigned int channel_index, Span<const uint8_t> src) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(channel_index < MAX_CHANNELS);
+	Channel &channel = _channels[channel_index];
+	ZN_ASSERT_RETURN(src.size() == get_size_in_bytes_for_volume(_size, channel.depth));
+	if (src.size() == 0) {
+		return;
+	}
+
+	if (channel.compression == COMPRESSION_UNIFORM) {
+		// No need to fill the channel, everything gets overwritten
+		ZN_ASSERT_RETURN(create_channel_noinit(channel_index, _size));
+	}
+	memcpy(channel.data, src.data(), src.size());
+}
+
+void VoxelBuffer::copy_channel_to_floats(unsigned int channel_index, Span<float> dst) const {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(channel_index < MAX_CHANNELS);
+	ZN_ASSERT_RETURN(dst.size() == get_volume());
+	const Channel &channel = _channels[channel_index];
+
+	if (channel.compression == COMPRESSION_UNIFORM) {
+		dst.fill(static_cast<float>(raw_voxel_to_real(channel.defval, channel.depth)));
+		return;
+	}
+
+	const Span<const uint8_t> data(channel.data, channel.size_in_bytes);
+
+	switch (channel.depth) {
+		case DEPTH_8_BIT: {
+			const Span<const int8_t> src = data.reinterpret_cast_to<const int8_t>();
+			for (size_t i = 0; i < src.size(); ++i) {
+				dst[i] = s8_to_snorm(src[i]) * constants::QUANTIZED_SDF_8_BITS_SCALE_INV;
+			}
+		} break;
+		case DEPTH_16_BIT: {
+			const Span<const int16_t> src = data.reinterpret_cast_to<const int16_t>();
+			for (size_t i = 0; i < src.size(); ++i) {
+				dst[i] = s16_to_snorm(src[i]) * constants::QUANTIZED_SDF_16_BITS_SCALE_INV;
+			}
+		} break;
+		case DEPTH_32_BIT:
+			memcpy(dst.data(), data.data(), data.size());
+			break;
+		case DEPTH_64_BIT: {
+			const Span<const double> src = data.reinterpret_cast_to<const double>();
+			for (size_t i = 0; i < src.size(); ++i) {
+				dst[i] = src[i];
+			}
+		} break;
+		default:
+			CRASH_NOW();
+			break;
+	}
+}
+
+void VoxelBuffer::copy_channel_from_floats(unsigned int channel_index, Span<const float> src) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(channel_index < MAX_CHANNELS);
+	ZN_ASSERT_RETURN(src.size() == get_volume());
+	if (src.size() == 0) {
+		return;
+	}
+	Channel &channel = _channels[channel_index];
+
+	if (channel.compression == COMPRESSION_UNIFORM) {
+		// No need to fill the channel, everything gets overwritten
+		ZN_ASSERT_RETURN(create_channel_noinit(channel_index, _size));
+	}
+
+	Span<uint8_t> data(channel.data, channel.size_in_bytes);
+
+	switch (channel.depth) {
+		case DEPTH_8_BIT: {
+			Span<int8_t> dst = data.reinterpret_cast_to<int8_t>();
+			for (size_t i = 0; i < src.size(); ++i) {
+				dst[i] = snorm_to_s8(src[i] * constants::QUANTIZED_SDF_8_BITS_SCALE);
+			}
+		} break;
+		case DEPTH_16_BIT: {
+			Span<int16_t> dst = data.reinterpret_cast_to<int16_t>();
+			for (size_t i = 0; i < src.size(); ++i) {
+				dst[i] = snorm_to_s16(src[i] * constants::QUANTIZED_SDF_16_BITS_SCALE);
+			}
+		} break;
+		case DEPTH_32_BIT:
+			memcpy(data.data(), src.data(), data.size());
+			break;
+		case DEPTH_64_BIT: {
+			Span<double> dst = data.reinterpret_cast_to<double>();
+			for (size_t i = 0; i < src.size(); ++i) {
+				dst[i] = src[i];
+			}
+		} break;
+		default:
+			CRASH_NOW();
+			break;
+	}
+}
+
 void VoxelBuffer::set_channel_depth(unsigned int channel_index, Depth new_depth) {
 	ZN_ASSERT_RETURN(channel_index < MAX_CHANNELS);
 	ZN_ASSERT_RETURN(new_depth >= 0 && new_depth < DEPTH_COUNT);
@@ -1482,4 +1685,54 @@ void paste_src_masked_dst_writable_bitarray(
 	);
 }
 
+namespace {
+
+template <typename T>
+bool has_any_value_in_bitarray(Span<const T> values, const DynamicBitset &bitarray) {
+	for (const T item : values) {
+		const uint64_t v = item;
+		if (v < bitarray.size() && bitarray.get(v)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace
+
+bool has_any_value_in_bitarray(const VoxelBuffer &buffer, unsigned int channel_index, const DynamicBitset &bitarray) {
+	ZN_ASSERT_RETURN_V(channel_index < VoxelBuffer::MAX_CHANNELS, false);
+
+	if (buffer.get_channel_compression(channel_index) == VoxelBuffer::COMPRESSION_UNIFORM) {
+		const uint64_t v = buffer.get_voxel(0, 0, 0, channel_index);
+		return v < bitarray.size() && bitarray.get(v);
+	}
+
+	switch (buffer.get_channel_depth(channel_index)) {
+		case VoxelBuffer::DEPTH_8_BIT: {
+			Span<const uint8_t> values;
+			ZN_ASSERT_RETURN_V(buffer.get_channel_data_read_only(channel_index, values), false);
+			return has_any_value_in_bitarray(values, bitarray);
+		}
+		case VoxelBuffer::DEPTH_16_BIT: {
+			Span<const uint16_t> values;
+			ZN_ASSERT_RETURN_V(buffer.get_channel_data_read_only(channel_index, values), false);
+			return has_any_value_in_bitarray(values, bitarray);
+		}
+		case VoxelBuffer::DEPTH_32_BIT: {
+			Span<const uint32_t> values;
+			ZN_ASSERT_RETURN_V(buffer.get_channel_data_read_only(channel_index, values), false);
+			return has_any_value_in_bitarray(values, bitarray);
+		}
+		case VoxelBuffer::DEPTH_64_BIT: {
+			Span<const uint64_t> values;
+			ZN_ASSERT_RETURN_V(buffer.get_channel_data_read_only(channel_index, values), false);
+			return has_any_value_in_bitarray(values, bitarray);
+		}
+		default:
+			ZN_CRASH();
+			return false;
+	}
+}
+
 } // namespace zylann::voxel
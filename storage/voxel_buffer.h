@@ -141,6 +141,8 @@ public:
 	void set_default_values(FixedArray<uint64_t, VoxelBuffer::MAX_CHANNELS> values);
 
 	static uint64_t get_default_value_static(unsigned int channel_index);
+	// Default value decoded the same way as `get_voxel_f`, assuming the channel has its default depth
+	static real_t get_default_value_f_static(unsigned int channel_index);
 
 	uint64_t get_voxel(int x, int y, int z, unsigned int channel_index) const;
 	void set_voxel(uint64_t value, int x, int y, int z, unsigned int channel_index);
@@ -458,6 +460,22 @@ public:
 
 	bool equals(const VoxelBuffer &p_other) const;
 
+	// Combines every channel with the same channel of `other` using bitwise XOR. Both buffers must have the same size
+	// and channel depths. Doing it again with the same `other` restores the original values, so it can be used to
+	// encode differences between two versions of a buffer: voxels that didn't change become zeroes, which compress
+	// very well. Metadata is not affected.
+	void xor_channels_from(const VoxelBuffer &other);
+
+	// Bulk access to a whole channel, in the same order as its internal storage (ZXY). Uniform channels are expanded.
+	// These are meant for bridging with APIs taking linear arrays, which is much faster than going voxel by voxel.
+	// Byte variants use the encoded values of the channel, so the size of `dst` or `src` must be
+	// `get_size_in_bytes_for_volume(get_size(), get_channel_depth(channel_index))`.
+	// Float variants decode values the same way as `get_voxel_f`, and their span must have `get_volume()` items.
+	void copy_channel_to_bytes(unsigned int channel_index, Span<uint8_t> dst) const;
+	void copy_channel_from_bytes(unsigned int channel_index, Span<const uint8_t> src);
+	void copy_channel_to_floats(unsigned int channel_index, Span<float> dst) const;
+	void copy_channel_from_floats(unsigned int channel_index, Span<const float> src);
+
 	void set_channel_depth(unsigned int channel_index, Depth new_depth);
 	Depth get_channel_depth(unsigned int channel_index) const;
 
@@ -594,6 +612,9 @@ void paste_src_masked_dst_writable_bitarray(
 		bool with_metadata
 );
 
+// Tests if a channel contains at least one of the values set in the bitset. Values beyond its size are not tested.
+bool has_any_value_in_bitarray(const VoxelBuffer &buffer, unsigned int channel_index, const DynamicBitset &bitarray);
+
 } // namespace voxel
 } // namespace zylann
 
@@ -213,6 +213,49 @@ void VoxelBuffer::fill_f(real_t value, int channel) {
 	_buffer->fill_f(value, channel);
 }
 
+PackedByteArray VoxelBuffer::get_channel_as_byte_array(int channel_index) const {
+	ZN_DSTACK();
+	PackedByteArray data;
+	ERR_FAIL_INDEX_V(channel_index, MAX_CHANNELS, data);
+	data.resize(zylann::voxel::VoxelBuffer::get_size_in_bytes_for_volume(
+			_buffer->get_size(), _buffer->get_channel_depth(channel_index)
+	));
+	_buffer->copy_channel_to_bytes(channel_index, Span<uint8_t>(data.ptrw(), data.size()));
+	return data;
+}
+
+void VoxelBuffer::set_channel_from_byte_array(int channel_index, PackedByteArray data) {
+	ZN_DSTACK();
+	ERR_FAIL_INDEX(channel_index, MAX_CHANNELS);
+	const size_t expected_size = zylann::voxel::VoxelBuffer::get_size_in_bytes_for_volume(
+			_buffer->get_size(), _buffer->get_channel_depth(channel_index)
+	);
+	ERR_FAIL_COND_MSG(
+			static_cast<size_t>(data.size()) != expected_size,
+			String("Expected {0} bytes, got {1}").format(varray(int64_t(expected_size), data.size()))
+	);
+	_buffer->copy_channel_from_bytes(channel_index, Span<const uint8_t>(data.ptr(), data.size()));
+}
+
+PackedFloat32Array VoxelBuffer::get_channel_as_float_array(int channel_index) const {
+	ZN_DSTACK();
+	PackedFloat32Array data;
+	ERR_FAIL_INDEX_V(channel_index, MAX_CHANNELS, data);
+	data.resize(_buffer->get_volume());
+	_buffer->copy_channel_to_floats(channel_index, Span<float>(data.ptrw(), data.size()));
+	return data;
+}
+
+void VoxelBuffer::set_channel_from_float_array(int channel_index, PackedFloat32Array data) {
+	ZN_DSTACK();
+	ERR_FAIL_INDEX(channel_index, MAX_CHANNELS);
+	ERR_FAIL_COND_MSG(
+			static_cast<uint64_t>(data.size()) != _buffer->get_volume(),
+			String("Expected {0} values, got {1}").format(varray(int64_t(_buffer->get_volume()), data.size()))
+	);
+	_buffer->copy_channel_from_floats(channel_index, Span<const float>(data.ptr(), data.size()));
+}
+
 bool VoxelBuffer::is_uniform(int channel_index) const {
 	ERR_FAIL_INDEX_V(channel_index, MAX_CHANNELS, true);
 	return _buffer->is_uniform(channel_index);
@@ -672,6 +715,19 @@ void VoxelBuffer::_bind_methods() {
 	);
 	ClassDB::bind_method(D_METHOD("downscale_to", "dst", "src_min", "src_max", "dst_min"), &VoxelBuffer::downscale_to);
 
+	ClassDB::bind_method(
+			D_METHOD("get_channel_as_byte_array", "channel"), &VoxelBuffer::get_channel_as_byte_array
+	);
+	ClassDB::bind_method(
+			D_METHOD("set_channel_from_byte_array", "channel", "data"), &VoxelBuffer::set_channel_from_byte_array
+	);
+	ClassDB::bind_method(
+			D_METHOD("get_channel_as_float_array", "channel"), &VoxelBuffer::get_channel_as_float_array
+	);
+	ClassDB::bind_method(
+			D_METHOD("set_channel_from_float_array", "channel", "data"), &VoxelBuffer::set_channel_from_float_array
+	);
+
 	ClassDB::bind_method(D_METHOD("is_uniform", "channel"), &VoxelBuffer::is_uniform);
 	ClassDB::bind_method(D_METHOD("compress_uniform_channels"), &VoxelBuffer::compress_uniform_channels);
 	ClassDB::bind_method(D_METHOD("get_channel_compression", "channel"), &VoxelBuffer::get_channel_compression);
@@ -136,6 +136,12 @@ public:
 		_buffer->fill_area_f(value, min, max, channel_index);
 	}
 
+	// Bulk access to whole channels, much faster than getting or setting voxels one by one from scripts
+	PackedByteArray get_channel_as_byte_array(int channel_index) const;
+	void set_channel_from_byte_array(int channel_index, PackedByteArray data);
+	PackedFloat32Array get_channel_as_float_array(int channel_index) const;
+	void set_channel_from_float_array(int channel_index, PackedFloat32Array data);
+
 	bool is_uniform(int channel_index) const;
 
 	void compress_uniform_channels();
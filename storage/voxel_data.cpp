@@ -299,7 +299,6 @@ void VoxelData::copy(Vector3i min_pos, VoxelBuffer &dst_buffer, unsigned int cha
 	SpatialLock3D::Read srlock(data_lod0.spatial_lock, BoxBounds3i(blocks_box));
 
 	if (generator.is_null()) {
-		RWLockRead rlock(data_lod0.map_lock);
 		// Only gets blocks we have voxel data of. Other blocks will be air.
 		// TODO Modifiers?
 		data_lod0.map.copy(min_pos, dst_buffer, channels_mask);
@@ -318,7 +317,6 @@ void VoxelData::copy(Vector3i min_pos, VoxelBuffer &dst_buffer, unsigned int cha
 		// edited. It may be useful for the caller to check first if the area is loaded. It would be better if all this
 		// could be done in a single transaction? Might need a proper transaction API eventually
 
-		RWLockRead rlock(data_lod0.map_lock);
 		data_lod0.map.copy(
 				min_pos,
 				dst_buffer,
@@ -342,6 +340,17 @@ void VoxelData::copy(Vector3i min_pos, VoxelBuffer &dst_buffer, unsigned int cha
 	}
 }
 
+void VoxelData::copy_loaded(Vector3i min_pos, VoxelBuffer &dst_buffer, unsigned int channels_mask) const {
+	ZN_PROFILE_SCOPE();
+
+	const Lod &data_lod0 = _lods[0];
+
+	const Box3i blocks_box = Box3i(min_pos, dst_buffer.get_size()).downscaled(data_lod0.map.get_block_size());
+	SpatialLock3D::Read srlock(data_lod0.spatial_lock, BoxBounds3i(blocks_box));
+
+	data_lod0.map.copy(min_pos, dst_buffer, channels_mask);
+}
+
 void VoxelData::paste(
 		Vector3i min_pos,
 		const VoxelBuffer &src_buffer,
@@ -356,12 +365,11 @@ void VoxelData::paste(
 	SpatialLock3D::Write swlock(data_lod0.spatial_lock, BoxBounds3i(blocks_box));
 
 	if (create_new_blocks) {
-		// We will modify the hashmap so no other threads can perform lookups while we do that
+		// We will modify the hashmap so no other threads can add or remove blocks while we do that
 		RWLockWrite wlock(data_lod0.map_lock);
 		data_lod0.map.paste(min_pos, src_buffer, channels_mask, create_new_blocks);
 	} else {
-		// We won't modify the hashmap so other threads can still perform lookups in different areas
-		RWLockRead rlock(data_lod0.map_lock);
+		// We won't modify the hashmap, and lookups don't need the map lock
 		data_lod0.map.paste(min_pos, src_buffer, channels_mask, create_new_blocks);
 	}
 }
@@ -382,7 +390,7 @@ void VoxelData::paste_masked(
 	SpatialLock3D::Write swlock(data_lod0.spatial_lock, BoxBounds3i(blocks_box));
 
 	if (create_new_blocks) {
-		// We will modify the hashmap so no other threads can perform lookups while we do that
+		// We will modify the hashmap so no other threads can add or remove blocks while we do that
 		RWLockWrite wlock(data_lod0.map_lock);
 		data_lod0.map.paste_masked( //
 				min_pos, //
@@ -397,8 +405,7 @@ void VoxelData::paste_masked(
 				create_new_blocks //
 		);
 	} else {
-		// We won't modify the hashmap so other threads can still perform lookups in different areas
-		RWLockRead rlock(data_lod0.map_lock);
+		// We won't modify the hashmap, and lookups don't need the map lock
 		data_lod0.map.paste_masked( //
 				min_pos, //
 				src_buffer, //
@@ -430,7 +437,7 @@ void VoxelData::paste_masked_writable_list( //
 	SpatialLock3D::Write swlock(data_lod0.spatial_lock, BoxBounds3i(blocks_box));
 
 	if (create_new_blocks) {
-		// We will modify the hashmap so no other threads can perform lookups while we do that
+		// We will modify the hashmap so no other threads can add or remove blocks while we do that
 		RWLockWrite wlock(data_lod0.map_lock);
 		data_lod0.map.paste_masked( //
 				min_pos, //
@@ -445,8 +452,7 @@ void VoxelData::paste_masked_writable_list( //
 				create_new_blocks //
 		);
 	} else {
-		// We won't modify the hashmap so other threads can still perform lookups in different areas
-		RWLockRead rlock(data_lod0.map_lock);
+		// We won't modify the hashmap, and lookups don't need the map lock
 		data_lod0.map.paste_masked( //
 				min_pos, //
 				src_buffer, //
@@ -462,6 +468,80 @@ void VoxelData::paste_masked_writable_list( //
 	}
 }
 
+void VoxelData::copy(Vector3i min_pos, ChunkedVoxelBuffer &dst, unsigned int channels_mask) const {
+	ZN_PROFILE_SCOPE();
+
+	// Going one block at a time, so memory usage stays proportional to the amount of non-uniform blocks.
+	// Each block locks only the area it reads.
+	const Box3i blocks_box(Vector3i(), dst.get_size_in_blocks());
+	blocks_box.for_each_cell_zxy([this, min_pos, &dst, channels_mask](Vector3i bpos) {
+		const Box3i box = dst.get_block_box(bpos);
+		std::shared_ptr<VoxelBuffer> voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
+		voxels->create(box.size);
+		copy(min_pos + box.position, *voxels, channels_mask);
+		dst.set_block(bpos, voxels);
+	});
+}
+
+void VoxelData::paste(
+		Vector3i min_pos,
+		const ChunkedVoxelBuffer &src,
+		const OrthoGridTransform &transform,
+		unsigned int channels_mask,
+		bool create_new_blocks
+) {
+	ZN_PROFILE_SCOPE();
+
+	const Box3i blocks_box = Box3i(min_pos, transform.dst_size).downscaled(get_block_size());
+	blocks_box.for_each_cell_zxy([this, min_pos, &src, &transform, channels_mask, create_new_blocks](Vector3i bpos) {
+		paste_block(bpos, min_pos, src, transform, channels_mask, create_new_blocks);
+	});
+}
+
+void VoxelData::paste_block(
+		Vector3i block_pos,
+		Vector3i min_pos,
+		const ChunkedVoxelBuffer &src,
+		const OrthoGridTransform &transform,
+		unsigned int channels_mask,
+		bool create_new_blocks
+) {
+	Lod &data_lod0 = _lods[0];
+
+	SpatialLock3D::Write swlock(data_lod0.spatial_lock, BoxBounds3i::from_position(block_pos));
+
+	std::shared_ptr<VoxelBuffer> voxels;
+	bool block_exists = false;
+	{
+		const VoxelDataBlock *block = data_lod0.map.get_block(block_pos);
+		if (block != nullptr) {
+			block_exists = true;
+			if (block->has_voxels()) {
+				voxels = block->get_voxels_shared();
+			}
+		}
+	}
+
+	if (block_exists) {
+		// TODO In this situation, the generator has to be invoked to fill the blanks
+		ZN_ASSERT_RETURN_MSG(voxels != nullptr, "Area not cached");
+
+	} else {
+		if (!create_new_blocks) {
+			return;
+		}
+		voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
+		voxels->create(Vector3iUtil::create(get_block_size()));
+		// We hold a spatial lock on the block, so no other thread can add it in the meantime
+		RWLockWrite wlock(data_lod0.map_lock);
+		data_lod0.map.set_block_buffer(block_pos, voxels, false);
+	}
+
+	// We keep a reference to the voxels and the spatial lock prevents other threads from accessing them.
+	const SmallVector<uint8_t, VoxelBuffer::MAX_CHANNELS> channels = VoxelBuffer::mask_to_channels_list(channels_mask);
+	src.paste_to(to_span(channels), transform, *voxels, min_pos - block_to_voxel(block_pos));
+}
+
 bool VoxelData::is_area_loaded(const Box3i p_voxels_box) const {
 	if (is_streaming_enabled() == false) {
 		return _full_load_completed;
@@ -472,8 +552,6 @@ bool VoxelData::is_area_loaded(const Box3i p_voxels_box) const {
 	{
 		SpatialLock3D::Read srlock(data_lod0.spatial_lock, block_box);
 
-		RWLockRead rlock(data_lod0.map_lock);
-
 		const bool all_blocks_present = block_box.all_cells_match([&data_lod0](Vector3i pos) { //
 			return data_lod0.map.has_block(pos);
 		});
@@ -528,8 +606,6 @@ void VoxelData::pre_generate_box(
 		{
 			SpatialLock3D::Read srlock(data_lod.spatial_lock, block_box);
 
-			RWLockRead rlock(data_lod.map_lock);
-
 			block_box.for_each_cell([&data_lod, lod_index, &todo, streaming](Vector3i block_pos) {
 				// We don't check "loading blocks", because this function wants to complete the task right now.
 				const VoxelDataBlock *block = data_lod.map.get_block(block_pos);
@@ -554,19 +630,21 @@ void VoxelData::pre_generate_box(
 	const Vector3i block_size = Vector3iUtil::create(data_block_size);
 
 	// Generate
+	StdVector<VoxelGenerator::VoxelQueryData> queries;
+	queries.reserve(todo.size());
 	for (unsigned int i = 0; i < todo.size(); ++i) {
 		Task &task = todo[i];
 		task.voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
 		task.voxels->create(block_size);
 		// TODO Format?
-		if (generator.is_valid()) {
-			ZN_PROFILE_SCOPE_NAMED("Generate");
-			VoxelGenerator::VoxelQueryData q{ //
-											  *task.voxels,
-											  task.block_pos * (data_block_size << task.lod_index),
-											  task.lod_index
-			};
-			generator->generate_block(q);
+		queries.push_back(VoxelGenerator::VoxelQueryData{
+				*task.voxels, task.block_pos * (data_block_size << task.lod_index), task.lod_index });
+	}
+	if (generator.is_valid() && queries.size() > 0) {
+		ZN_PROFILE_SCOPE_NAMED("Generate");
+		// All blocks are generated in one call, which is cheaper for generators with a high cost per call
+		generator->generate_blocks(to_span(queries));
+		for (const VoxelGenerator::VoxelQueryData &q : queries) {
 			modifiers.apply(q.voxel_buffer, AABB(q.origin_in_voxels, q.voxel_buffer.get_size() << q.lod));
 		}
 	}
@@ -620,8 +698,7 @@ void VoxelData::clear_cached_blocks_in_voxel_area(Box3i p_voxel_box) {
 		const Box3i blocks_box = p_voxel_box.downscaled(lod.map.get_block_size() << lod_index);
 		SpatialLock3D::Write swlock(lod.spatial_lock, blocks_box);
 
-		// Locking map for read because we won't add or remove blocks
-		RWLockRead rlock(lod.map_lock);
+		// Not locking the map because we won't add or remove blocks
 
 		blocks_box.for_each_cell_zxy([&lod](const Vector3i bpos) {
 			VoxelDataBlock *block = lod.map.get_block(bpos);
@@ -647,8 +724,7 @@ void VoxelData::mark_area_modified(
 	{
 		SpatialLock3D::Write swlock(data_lod0.spatial_lock, bbox);
 
-		// Locking map for read because we won't add or remove blocks
-		RWLockRead rlock(data_lod0.map_lock);
+		// Not locking the map because we won't add or remove blocks
 
 		bbox.for_each_cell([&data_lod0, lod0_new_blocks_to_lod, require_lod_updates](Vector3i block_pos_lod0) {
 			VoxelDataBlock *block = data_lod0.map.get_block(block_pos_lod0);
@@ -690,7 +766,6 @@ bool VoxelData::try_set_block(Vector3i block_position, const VoxelDataBlock &blo
 
 bool VoxelData::has_block(Vector3i bpos, unsigned int lod_index) const {
 	const Lod &data_lod = _lods[lod_index];
-	RWLockRead rlock(data_lod.map_lock);
 	return data_lod.map.has_block(bpos);
 }
 
@@ -707,7 +782,6 @@ bool VoxelData::has_all_blocks_in_area(Box3i data_blocks_box, unsigned int lod_i
 bool VoxelData::has_all_blocks_in_area_unbound(Box3i data_blocks_box, unsigned int lod_index) const {
 	// ZN_PROFILE_SCOPE();
 	const Lod &data_lod = _lods[lod_index];
-	RWLockRead rlock(data_lod.map_lock);
 
 	return data_blocks_box.all_cells_match([&data_lod](Vector3i bpos) { //
 		return data_lod.map.has_block(bpos);
@@ -752,7 +826,6 @@ void VoxelData::update_lods(Span<const Vector3i> modified_lod0_blocks, StdVector
 	}
 	{
 		Lod &data_lod0 = _lods[0];
-		RWLockRead rlock(data_lod0.map_lock);
 
 		StdVector<Vector3i> &blocks_pending_lodding_lod0 = tls_blocks_to_process_per_lod[0];
 
@@ -797,16 +870,8 @@ void VoxelData::update_lods(Span<const Vector3i> modified_lod0_blocks, StdVector
 			// Besides, in per-block streaming mode, it is not needed because blocks are supposed to be present
 			SpatialLock3D::Write swlock(dst_data_lod.spatial_lock, BoxBounds3i::from_position(dst_bpos));
 
-			VoxelDataBlock *src_block;
-			VoxelDataBlock *dst_block;
-			{
-				RWLockRead rlock(src_data_lod.map_lock);
-				src_block = src_data_lod.map.get_block(src_bpos);
-			}
-			{
-				RWLockRead rlock(dst_data_lod.map_lock);
-				dst_block = dst_data_lod.map.get_block(dst_bpos);
-			}
+			VoxelDataBlock *src_block = src_data_lod.map.get_block(src_bpos);
+			VoxelDataBlock *dst_block = dst_data_lod.map.get_block(dst_bpos);
 
 			ZN_ASSERT(src_block != nullptr);
 			src_block->set_needs_lodding(false);
@@ -955,8 +1020,7 @@ bool VoxelData::consume_block_modifications(Vector3i bpos, VoxelData::BlockToSav
 	// TODO Could use an atomic in this case, if it causes too much contention?
 	SpatialLock3D::Write swlock(lod.spatial_lock, BoxBounds3i::from_position(bpos));
 
-	// Locking for read because we won't add or remove blocks to the map
-	RWLockRead rlock(lod.map_lock);
+	// Not locking the map because we won't add or remove blocks
 
 	VoxelDataBlock *block = lod.map.get_block(bpos);
 	if (block == nullptr) {
@@ -997,7 +1061,6 @@ void VoxelData::get_missing_blocks(
 		StdVector<Vector3i> &out_missing
 ) const {
 	const Lod &lod = _lods[lod_index];
-	RWLockRead rlock(lod.map_lock);
 	for (const Vector3i &pos : block_positions) {
 		if (!lod.map.has_block(pos)) {
 			out_missing.push_back(pos);
@@ -1011,8 +1074,6 @@ void VoxelData::get_missing_blocks(Box3i p_blocks_box, unsigned int lod_index, S
 	const Box3i bounds_in_blocks = get_bounds().downscaled(get_block_size());
 	const Box3i blocks_box = p_blocks_box.clipped(bounds_in_blocks);
 
-	RWLockRead rlock(data_lod.map_lock);
-
 	blocks_box.for_each_cell_zxy([&data_lod, &out_missing](Vector3i bpos) {
 		if (!data_lod.map.has_block(bpos)) {
 			out_missing.push_back(bpos);
@@ -1034,8 +1095,6 @@ void VoxelData::get_blocks_with_voxel_data(
 	// changed by another thread (in theory)
 	SpatialLock3D::Read srlock(data_lod.spatial_lock, p_blocks_box);
 
-	RWLockRead rlock(data_lod.map_lock);
-
 	unsigned int index = 0;
 
 	p_blocks_box.for_each_cell_zxy([&index, &data_lod, &out_blocks](Vector3i data_block_pos) {
@@ -1054,7 +1113,7 @@ void VoxelData::get_blocks_grid(VoxelDataGrid &grid, Box3i box_in_voxels, unsign
 	const Lod &data_lod = _lods[lod_index];
 	const int bs = data_lod.map.get_block_size() << lod_index;
 	const Box3i box_in_blocks = box_in_voxels.downscaled(bs);
-	grid.reference_area_block_coords(data_lod.map, data_lod.map_lock, box_in_blocks, data_lod.spatial_lock);
+	grid.reference_area_block_coords(data_lod.map, box_in_blocks, data_lod.spatial_lock);
 }
 
 SpatialLock3D &VoxelData::get_spatial_lock(unsigned int lod_index) const {
@@ -1080,8 +1139,6 @@ bool VoxelData::has_blocks_with_voxels_in_area_broad_mip_test(Box3i box_in_voxel
 
 		SpatialLock3D::Read srlock(mip_data_lod.spatial_lock, mip_blocks_box);
 
-		RWLockRead rlock(mip_data_lod.map_lock);
-
 		const VoxelDataMap &map = mip_data_lod.map;
 		const bool no_blocks_found = mip_blocks_box.all_cells_match([&map](const Vector3i pos) {
 			const VoxelDataBlock *block = map.get_block(pos);
@@ -1117,8 +1174,7 @@ void VoxelData::view_area(
 	// TODO Could use atomics if contention is too much?
 	SpatialLock3D::Write swlock(lod.spatial_lock, blocks_box);
 
-	// Locking for read because we don't add or remove blocks.
-	RWLockRead rlock(lod.map_lock);
+	// Not locking the map because we don't add or remove blocks.
 
 	blocks_box.for_each_cell_zxy([&lod, found_blocks_positions, found_blocks, &missing_blocks](Vector3i bpos) {
 		VoxelDataBlock *block = lod.map.get_block(bpos);
@@ -1185,8 +1241,6 @@ std::shared_ptr<VoxelBuffer> VoxelData::try_get_block_voxels(Vector3i bpos) {
 	// The caller must lock the spatial lock and keep it locked until done accessing blocks
 	// SpatialLock3D::Read srlock(lod.spatial_lock, BoxBounds3i::from_position(bpos));
 
-	RWLockRead rlock(lod.map_lock);
-
 	VoxelDataBlock *block = lod.map.get_block(bpos);
 	if (block == nullptr) {
 		return nullptr;
@@ -1203,7 +1257,6 @@ void VoxelData::set_voxel_metadata(Vector3i pos, Variant meta) {
 	const Vector3i bpos = lod.map.voxel_to_block(pos);
 
 	SpatialLock3D::Write swlock(lod.spatial_lock, BoxBounds3i::from_position(bpos));
-	RWLockRead rlock(lod.map_lock);
 
 	VoxelDataBlock *block = lod.map.get_block(bpos);
 	ZN_ASSERT_RETURN_MSG(block != nullptr, "Area not editable");
@@ -1221,7 +1274,6 @@ Variant VoxelData::get_voxel_metadata(Vector3i pos) {
 	const Vector3i bpos = lod.map.voxel_to_block(pos);
 
 	SpatialLock3D::Read srlock(lod.spatial_lock, BoxBounds3i::from_position(bpos));
-	RWLockRead rlock(lod.map_lock);
 
 	VoxelDataBlock *block = lod.map.get_block(bpos);
 	ZN_ASSERT_RETURN_V_MSG(block != nullptr, Variant(), "Area not editable");
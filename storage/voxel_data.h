@@ -6,6 +6,7 @@
 #include "../streams/voxel_stream.h"
 #include "../util/thread/mutex.h"
 #include "../util/thread/spatial_lock_3d.h"
+#include "chunked_voxel_buffer.h"
 #include "voxel_data_map.h"
 
 namespace zylann::voxel {
@@ -107,6 +108,10 @@ public:
 	// `channels_mask` bits tell which channel is read.
 	void copy(Vector3i min_pos, VoxelBuffer &dst_buffer, unsigned int channels_mask) const;
 
+	// Same as `copy`, but only reads blocks that are loaded and have voxel data. Other areas are left untouched in
+	// `dst_buffer`, without falling back on the generator.
+	void copy_loaded(Vector3i min_pos, VoxelBuffer &dst_buffer, unsigned int channels_mask) const;
+
 	// Pastes voxel data in a box at LOD0.
 	// `channels_mask` bits tell which channel is pasted.
 	// If `use_mask` is used, will only write voxels of the source buffer that are not equal to `mask_value`.
@@ -133,6 +138,30 @@ public:
 			bool create_new_blocks //
 	);
 
+	// Copies voxel data in a box from LOD0 into a chunked buffer, one block at a time.
+	// The size of the box is the size of `dst`. This can copy areas larger than a single VoxelBuffer could hold.
+	void copy(Vector3i min_pos, ChunkedVoxelBuffer &dst, unsigned int channels_mask) const;
+
+	// Pastes a chunked buffer at LOD0, rotated and/or mirrored by `transform`.
+	void paste(
+			Vector3i min_pos,
+			const ChunkedVoxelBuffer &src,
+			const OrthoGridTransform &transform,
+			unsigned int channels_mask,
+			bool create_new_blocks
+	);
+
+	// Pastes the part of a chunked buffer that intersects a single block at LOD0. Only that block gets locked, so
+	// calls on different blocks can run in parallel.
+	void paste_block(
+			Vector3i block_pos,
+			Vector3i min_pos,
+			const ChunkedVoxelBuffer &src,
+			const OrthoGridTransform &transform,
+			unsigned int channels_mask,
+			bool create_new_blocks
+	);
+
 	// Tests if the given area is loaded at LOD0.
 	// This is necessary for editing destructively.
 	bool is_area_loaded(const Box3i p_voxels_box) const;
@@ -353,14 +382,15 @@ private:
 
 		// Multi-threaded access strategy:
 		// - Spatial lock first
-		// - Map lock second, while the spatial lock is acquired, just to lookup the map
-		// This should be safe assuming the address of hashmap's values remains stable when insertion or removal occurs.
+		// - Map lock second, only when adding or removing blocks, or iterating all of them
+		// Looking up blocks doesn't require the map lock, the map can be read without locking while another thread
+		// modifies it. This is safe because the address of hashmap's values remains stable when insertion or removal
+		// occurs, and blocks can't be removed while the spatial lock of their area is held.
 		// If two lods really need to be locked as well, lock the lower index first, and higher index next.
 
 		// Lock protecting the map itself, because it uses a hashmap.
-		// This lock should be locked in write mode only when the map gets modified (adding or removing blocks).
-		// Otherwise it may be locked in read mode.
-		// It is possible to unlock it after we are done querying the map.
+		// This lock should be locked in write mode when the map gets modified (adding or removing blocks), and in read
+		// mode when iterating blocks or counting them. It doesn't need to be locked for lookups.
 		mutable RWLock map_lock;
 		// This should be used when reading or writing voxels/metadata in blocks. It uses block coordinates as
 		// spatial unit.
@@ -382,7 +412,7 @@ private:
 			Vector3i block_pos,
 			bool &out_generate
 	) {
-		RWLockRead rlock(data_lod.map_lock);
+		// Lookups don't need the map lock
 		const VoxelDataBlock *block = data_lod.map.get_block(block_pos);
 		if (block == nullptr) {
 			// The block is not there, so unless streaming is not enabled, we don't know if it has edits or not.
@@ -24,7 +24,6 @@ public:
 	// TODO This API is a bit risky, it should just be encapsulated into VoxelData maybe
 	inline void reference_area_block_coords(
 			const VoxelDataMap &map,
-			RWLock &map_lock,
 			const Box3i blocks_box,
 			// Will be referenced for operations, assuming its lifetime is equal or greater than the grid
 			SpatialLock3D &spatial_lock
@@ -38,19 +37,17 @@ public:
 		// Locking is needed because we access `has_voxels`
 		spatial_lock.lock_read(blocks_box);
 
-		{
-			RWLockRead rlock(map_lock);
-			blocks_box.for_each_cell_zxy([&map, this](const Vector3i pos) {
-				const VoxelDataBlock *block = map.get_block(pos);
-				// TODO Might need to invoke the generator at some level for present blocks without voxels,
-				// or make sure all blocks contain voxel data
-				if (block != nullptr && block->has_voxels()) {
-					set_block(pos, block->get_voxels_shared());
-				} else {
-					set_block(pos, nullptr);
-				}
-			});
-		}
+		// Lookups don't need the map lock
+		blocks_box.for_each_cell_zxy([&map, this](const Vector3i pos) {
+			const VoxelDataBlock *block = map.get_block(pos);
+			// TODO Might need to invoke the generator at some level for present blocks without voxels,
+			// or make sure all blocks contain voxel data
+			if (block != nullptr && block->has_voxels()) {
+				set_block(pos, block->get_voxels_shared());
+			} else {
+				set_block(pos, nullptr);
+			}
+		});
 
 		spatial_lock.unlock_read(blocks_box);
 
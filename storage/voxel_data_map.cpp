@@ -3,14 +3,30 @@
 #include "../edition/funcs.h"
 #include "../generators/voxel_generator.h"
 #include "../util/containers/dynamic_bitset.h"
+#include "../util/hash_funcs.h"
 #include "../util/macros.h"
+#include "../util/math/funcs.h"
 #include "../util/memory/memory.h"
 #include "../util/string/format.h"
+#include "../util/thread/epoch_reclaimer.h"
 
 #include <limits>
 
 namespace zylann::voxel {
 
+namespace {
+
+// Put in index slots of removed blocks
+inline VoxelDataBlock *get_removed_block_marker() {
+	return reinterpret_cast<VoxelDataBlock *>(uintptr_t(1));
+}
+
+inline uint32_t get_block_index_hash(Vector3i bpos) {
+	return hash_fmix32(hash_murmur3_one_32(bpos.z, hash_murmur3_one_32(bpos.y, hash_murmur3_one_32(bpos.x))));
+}
+
+} // namespace
+
 VoxelDataMap::VoxelDataMap() {
 	// This is not planned to change at runtime at the moment.
 	// set_block_size_pow2(constants::DEFAULT_BLOCK_SIZE_PO2);
@@ -18,6 +34,8 @@ VoxelDataMap::VoxelDataMap() {
 
 VoxelDataMap::~VoxelDataMap() {
 	clear();
+	// Nothing should be reading the map while it gets destroyed
+	free_retired_indices(false);
 }
 
 void VoxelDataMap::create(unsigned int lod_index) {
@@ -65,6 +83,7 @@ VoxelDataBlock *VoxelDataMap::create_default_block(Vector3i bpos) {
 #endif
 	VoxelDataBlock &map_block = _blocks_map[bpos];
 	map_block = VoxelDataBlock(buffer, _lod_index);
+	index_block(bpos, &map_block);
 	return &map_block;
 }
 
@@ -106,19 +125,136 @@ void VoxelDataMap::set_voxel_f(real_t value, Vector3i pos, unsigned int c) {
 }
 
 VoxelDataBlock *VoxelDataMap::get_block(Vector3i bpos) {
-	auto it = _blocks_map.find(bpos);
-	if (it != _blocks_map.end()) {
-		return &it->second;
-	}
-	return nullptr;
+	return find_block(bpos);
 }
 
 const VoxelDataBlock *VoxelDataMap::get_block(Vector3i bpos) const {
-	auto it = _blocks_map.find(bpos);
-	if (it != _blocks_map.end()) {
-		return &it->second;
+	return find_block(bpos);
+}
+
+VoxelDataBlock *VoxelDataMap::find_block(Vector3i bpos) const {
+	epoch_reclaimer::ReadScope read_scope;
+
+	const BlockIndex *index = _index.load();
+	if (index == nullptr) {
+		return nullptr;
+	}
+
+	const unsigned int mask = index->slots.size() - 1;
+	unsigned int i = get_block_index_hash(bpos) & mask;
+
+	// The table is never full, so this always ends on a slot that was never used
+	while (true) {
+		const BlockIndex::Slot &slot = index->slots[i];
+		VoxelDataBlock *block = slot.block.load(std::memory_order_acquire);
+		if (block == nullptr) {
+			return nullptr;
+		}
+		if (slot.position == bpos) {
+			return block == get_removed_block_marker() ? nullptr : block;
+		}
+		i = (i + 1) & mask;
+	}
+}
+
+void VoxelDataMap::index_block(Vector3i bpos, VoxelDataBlock *block) {
+	BlockIndex *index = _index.load(std::memory_order_relaxed);
+
+	// Keep at most half of the slots used, so probing sequences remain short
+	if (index == nullptr || (index->used_count + 1) * 2 > index->slots.size()) {
+		// The block is already in `_blocks_map`, so it will be part of the new table
+		rebuild_index();
+		return;
+	}
+
+	const unsigned int mask = index->slots.size() - 1;
+	unsigned int i = get_block_index_hash(bpos) & mask;
+
+	while (true) {
+		BlockIndex::Slot &slot = index->slots[i];
+		VoxelDataBlock *existing_block = slot.block.load(std::memory_order_relaxed);
+
+		if (existing_block == nullptr) {
+			// The position must be visible to readers before the block is
+			slot.position = bpos;
+			slot.block.store(block, std::memory_order_release);
+			++index->used_count;
+			return;
+		}
+
+		if (slot.position == bpos) {
+			// A block was there before, or it is the same block
+			slot.block.store(block, std::memory_order_release);
+			return;
+		}
+
+		i = (i + 1) & mask;
+	}
+}
+
+void VoxelDataMap::unindex_block(Vector3i bpos) {
+	BlockIndex *index = _index.load(std::memory_order_relaxed);
+	ZN_ASSERT_RETURN(index != nullptr);
+
+	const unsigned int mask = index->slots.size() - 1;
+	unsigned int i = get_block_index_hash(bpos) & mask;
+
+	while (true) {
+		BlockIndex::Slot &slot = index->slots[i];
+		VoxelDataBlock *existing_block = slot.block.load(std::memory_order_relaxed);
+		ZN_ASSERT_RETURN_MSG(existing_block != nullptr, "Block was not indexed");
+
+		if (slot.position == bpos) {
+			slot.block.store(get_removed_block_marker(), std::memory_order_release);
+			return;
+		}
+
+		i = (i + 1) & mask;
+	}
+}
+
+void VoxelDataMap::rebuild_index() {
+	ZN_PROFILE_SCOPE();
+
+	BlockIndex *new_index = ZN_NEW(BlockIndex);
+	// Start with a third of the slots used at most, so it takes a while until it has to be rebuilt again
+	new_index->slots.resize(math::max(math::get_next_power_of_two_32(_blocks_map.size() * 3), 16u));
+	const unsigned int mask = new_index->slots.size() - 1;
+
+	for (auto it = _blocks_map.begin(); it != _blocks_map.end(); ++it) {
+		unsigned int i = get_block_index_hash(it->first) & mask;
+		while (new_index->slots[i].block.load(std::memory_order_relaxed) != nullptr) {
+			i = (i + 1) & mask;
+		}
+		BlockIndex::Slot &slot = new_index->slots[i];
+		slot.position = it->first;
+		slot.block.store(&it->second, std::memory_order_relaxed);
+	}
+	new_index->used_count = _blocks_map.size();
+
+	BlockIndex *old_index = _index.exchange(new_index);
+	if (old_index != nullptr) {
+		retire_index(old_index);
+	}
+	++_index_rebuild_count;
+}
+
+void VoxelDataMap::retire_index(BlockIndex *index) {
+	_retired_indices.push_back(RetiredBlockIndex{ index, epoch_reclaimer::retire() });
+	free_retired_indices(true);
+}
+
+void VoxelDataMap::free_retired_indices(bool wait_for_readers) {
+	for (unsigned int i = 0; i < _retired_indices.size();) {
+		const RetiredBlockIndex &retired = _retired_indices[i];
+		if (!wait_for_readers || epoch_reclaimer::can_reclaim(retired.tag)) {
+			ZN_DELETE(retired.index);
+			_retired_indices[i] = _retired_indices.back();
+			_retired_indices.pop_back();
+		} else {
+			++i;
+		}
 	}
-	return nullptr;
 }
 
 VoxelDataBlock *VoxelDataMap::set_block_buffer(Vector3i bpos, std::shared_ptr<VoxelBuffer> &buffer, bool overwrite) {
@@ -130,6 +266,7 @@ VoxelDataBlock *VoxelDataMap::set_block_buffer(Vector3i bpos, std::shared_ptr<Vo
 		VoxelDataBlock &map_block = _blocks_map[bpos];
 		map_block = VoxelDataBlock(buffer, _lod_index);
 		block = &map_block;
+		index_block(bpos, block);
 
 	} else if (overwrite) {
 		block->set_voxels(buffer);
@@ -148,7 +285,9 @@ void VoxelDataMap::set_block(Vector3i bpos, const VoxelDataBlock &block) {
 #ifdef DEBUG_ENABLED
 	ZN_ASSERT(block.get_lod_index() == _lod_index);
 #endif
-	_blocks_map[bpos] = block;
+	VoxelDataBlock &map_block = _blocks_map[bpos];
+	map_block = block;
+	index_block(bpos, &map_block);
 }
 
 VoxelDataBlock *VoxelDataMap::set_empty_block(Vector3i bpos, bool overwrite) {
@@ -158,6 +297,7 @@ VoxelDataBlock *VoxelDataMap::set_empty_block(Vector3i bpos, bool overwrite) {
 		VoxelDataBlock &map_block = _blocks_map[bpos];
 		map_block = VoxelDataBlock(_lod_index);
 		block = &map_block;
+		index_block(bpos, block);
 
 	} else if (overwrite) {
 		block->clear_voxels();
@@ -173,7 +313,7 @@ VoxelDataBlock *VoxelDataMap::set_empty_block(Vector3i bpos, bool overwrite) {
 }
 
 bool VoxelDataMap::has_block(Vector3i pos) const {
-	return _blocks_map.find(pos) != _blocks_map.end();
+	return find_block(pos) != nullptr;
 }
 
 bool VoxelDataMap::is_block_surrounded(Vector3i pos) const {
@@ -372,6 +512,10 @@ void VoxelDataMap::paste_masked( //
 }
 
 void VoxelDataMap::clear() {
+	BlockIndex *old_index = _index.exchange(nullptr);
+	if (old_index != nullptr) {
+		retire_index(old_index);
+	}
 	_blocks_map.clear();
 }
 
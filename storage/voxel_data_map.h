@@ -5,10 +5,12 @@
 #include "../util/containers/fixed_array.h"
 #include "../util/containers/span.h"
 #include "../util/containers/std_unordered_map.h"
+#include "../util/containers/std_vector.h"
 #include "../util/math/box3i.h"
 #include "../util/profiling.h"
 #include "voxel_buffer.h" // Used in template methods
 #include "voxel_data_block.h"
+#include <atomic>
 
 namespace zylann::voxel {
 
@@ -22,6 +24,11 @@ class VoxelGenerator;
 // When using "full load" of edits, it doesn't matter. If all edits are loaded, we know up-front that everything else
 // isn't edited (which also means we may not find blocks without data in them).
 //
+// Looking up blocks (`get_block`, `has_block`) doesn't lock anything, and can be done while another thread adds or
+// removes blocks. Methods adding or removing blocks must not run concurrently with each other, and neither with
+// iteration. Blocks found this way remain valid only as long as nothing removes them, so users still need to hold a
+// lock on the area of these blocks (such as a `SpatialLock3D`).
+//
 class VoxelDataMap {
 public:
 	// This is block size in VOXELS. To convert to space units, use `block_size << lod_index`.
@@ -114,6 +121,7 @@ public:
 		auto it = _blocks_map.find(bpos);
 		if (it != _blocks_map.end()) {
 			pre_delete(it->second);
+			unindex_block(bpos);
 			_blocks_map.erase(it);
 		}
 	}
@@ -128,6 +136,11 @@ public:
 
 	int get_block_count() const;
 
+	// How many times the lookup table had to be rebuilt. Only accessed by writers.
+	inline unsigned int get_index_rebuild_count() const {
+		return _index_rebuild_count;
+	}
+
 	// op(Vector3i bpos)
 	template <typename Op_T>
 	inline void for_each_block_position(Op_T op) const {
@@ -212,6 +225,40 @@ private:
 
 	// void set_block_size_pow2(unsigned int p);
 
+	// Open-addressing hashtable pointing at blocks of `_blocks_map`, which can be read without locking.
+	// Slots are only ever assigned a position once, so readers can compare positions without racing with writers.
+	// Removed blocks leave a marker in their slot, which is reused if a block is added again at the same position.
+	// When too many slots are used, a new table is built and published, and the old one is freed once no reader can
+	// be using it anymore.
+	struct BlockIndex {
+		struct Slot {
+			Vector3i position;
+			// Null if the slot was never used
+			std::atomic<VoxelDataBlock *> block = { nullptr };
+
+			Slot() {}
+			// Only used when building a table, before it gets published
+			Slot(const Slot &other) : position(other.position), block(other.block.load(std::memory_order_relaxed)) {}
+		};
+
+		StdVector<Slot> slots;
+		// Slots assigned a position, including those of removed blocks. Only accessed by writers.
+		unsigned int used_count = 0;
+	};
+
+	struct RetiredBlockIndex {
+		BlockIndex *index;
+		uint64_t tag;
+	};
+
+	VoxelDataBlock *find_block(Vector3i bpos) const;
+	// Must be called after the block is added to `_blocks_map`
+	void index_block(Vector3i bpos, VoxelDataBlock *block);
+	void unindex_block(Vector3i bpos);
+	void rebuild_index();
+	void retire_index(BlockIndex *index);
+	void free_retired_indices(bool wait_for_readers);
+
 private:
 	// Blocks stored with a spatial hash in all 3D directions.
 	// Before I used Godot 3's HashMap with RELATIONSHIP = 2 because that delivers better performance compared to
@@ -220,6 +267,11 @@ private:
 	// Note: pointers to elements remain valid when inserting or removing others (only iterators may be invalidated)
 	StdUnorderedMap<Vector3i, VoxelDataBlock> _blocks_map;
 
+	// Used to lookup blocks from any thread without locking. Can be null if there are no blocks.
+	std::atomic<BlockIndex *> _index = { nullptr };
+	StdVector<RetiredBlockIndex> _retired_indices;
+	unsigned int _index_rebuild_count = 0;
+
 	// This was a possible optimization in a single-threaded scenario, but it's not in multithread.
 	// We want to be able to do shared read-accesses but this is a mutable variable.
 	// If we want this back, it may be thread-local in some way.
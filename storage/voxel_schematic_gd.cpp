@@ -0,0 +1,104 @@
+#include "voxel_schematic_gd.h"
+#include "../constants/voxel_constants.h"
+#include "../util/math/conv.h"
+#include "../util/memory/memory.h"
+
+namespace zylann::voxel::godot {
+
+VoxelSchematic::VoxelSchematic() {
+	_buffer = make_shared_instance<ChunkedVoxelBuffer>();
+}
+
+void VoxelSchematic::create(Vector3i size) {
+	ERR_FAIL_COND(!Vector3iUtil::is_valid_size(size));
+	if (_buffer.use_count() > 1) {
+		// Async tasks may still be reading the previous data
+		_buffer = make_shared_instance<ChunkedVoxelBuffer>();
+	}
+	_buffer->create(size, constants::DEFAULT_BLOCK_SIZE_PO2);
+}
+
+void VoxelSchematic::clear() {
+	if (_buffer.use_count() > 1) {
+		_buffer = make_shared_instance<ChunkedVoxelBuffer>();
+	} else {
+		_buffer->clear();
+	}
+}
+
+ChunkedVoxelBuffer &VoxelSchematic::get_buffer_for_write() {
+	if (_buffer.use_count() > 1) {
+		_buffer = make_shared_instance<ChunkedVoxelBuffer>(*_buffer);
+	}
+	return *_buffer;
+}
+
+Vector3i VoxelSchematic::get_size() const {
+	return _buffer->get_size();
+}
+
+Vector3i VoxelSchematic::get_size_in_blocks() const {
+	return _buffer->get_size_in_blocks();
+}
+
+int VoxelSchematic::get_block_size() const {
+	return _buffer->get_block_size();
+}
+
+int VoxelSchematic::get_allocated_block_count() const {
+	return _buffer->get_allocated_block_count();
+}
+
+int64_t VoxelSchematic::get_voxel(Vector3i pos, int channel) const {
+	ERR_FAIL_INDEX_V(channel, zylann::voxel::VoxelBuffer::MAX_CHANNELS, 0);
+	ERR_FAIL_COND_V(!Box3i(Vector3i(), _buffer->get_size()).contains(pos), 0);
+	return _buffer->get_voxel(pos, channel);
+}
+
+float VoxelSchematic::get_voxel_f(Vector3i pos, int channel) const {
+	ERR_FAIL_INDEX_V(channel, zylann::voxel::VoxelBuffer::MAX_CHANNELS, 0);
+	ERR_FAIL_COND_V(!Box3i(Vector3i(), _buffer->get_size()).contains(pos), 0);
+	return _buffer->get_voxel_f(pos, channel);
+}
+
+Vector3i VoxelSchematic::get_transformed_size(Basis basis) const {
+	OrthoGridTransform transform;
+	ERR_FAIL_COND_V(!try_get_grid_transform(_buffer->get_size(), basis, transform), Vector3i());
+	return transform.dst_size;
+}
+
+bool VoxelSchematic::try_get_grid_transform(Vector3i size, const Basis &basis, OrthoGridTransform &out_transform) {
+	IntBasis ib;
+	ib.x = to_vec3i(math::round(basis.get_column(Vector3::AXIS_X)));
+	ib.y = to_vec3i(math::round(basis.get_column(Vector3::AXIS_Y)));
+	ib.z = to_vec3i(math::round(basis.get_column(Vector3::AXIS_Z)));
+
+	if (!Vector3iUtil::is_unit_vector(ib.x) || !Vector3iUtil::is_unit_vector(ib.y) ||
+		!Vector3iUtil::is_unit_vector(ib.z)) {
+		ZN_PRINT_ERROR("Basis must only contain 90-degree rotations or mirroring");
+		return false;
+	}
+	// Axes must be perpendicular, so they can't point in the same direction
+	if (math::abs(ib.x) == math::abs(ib.y) || math::abs(ib.y) == math::abs(ib.z) ||
+		math::abs(ib.x) == math::abs(ib.z)) {
+		ZN_PRINT_ERROR("Basis axes must be perpendicular");
+		return false;
+	}
+
+	out_transform = OrthoGridTransform::create(size, ib);
+	return true;
+}
+
+void VoxelSchematic::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("create", "size"), &VoxelSchematic::create);
+	ClassDB::bind_method(D_METHOD("clear"), &VoxelSchematic::clear);
+	ClassDB::bind_method(D_METHOD("get_size"), &VoxelSchematic::get_size);
+	ClassDB::bind_method(D_METHOD("get_size_in_blocks"), &VoxelSchematic::get_size_in_blocks);
+	ClassDB::bind_method(D_METHOD("get_block_size"), &VoxelSchematic::get_block_size);
+	ClassDB::bind_method(D_METHOD("get_allocated_block_count"), &VoxelSchematic::get_allocated_block_count);
+	ClassDB::bind_method(D_METHOD("get_voxel", "pos", "channel"), &VoxelSchematic::get_voxel);
+	ClassDB::bind_method(D_METHOD("get_voxel_f", "pos", "channel"), &VoxelSchematic::get_voxel_f);
+	ClassDB::bind_method(D_METHOD("get_transformed_size", "basis"), &VoxelSchematic::get_transformed_size);
+}
+
+} // namespace zylann::voxel::godot
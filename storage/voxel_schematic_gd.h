@@ -0,0 +1,56 @@
+#ifndef VOXEL_SCHEMATIC_GD_H
+#define VOXEL_SCHEMATIC_GD_H
+
+#include "../util/godot/classes/ref_counted.h"
+#include "chunked_voxel_buffer.h"
+#include <memory>
+
+namespace zylann::voxel::godot {
+
+// Scripts-facing wrapper around ChunkedVoxelBuffer.
+// Used to copy and paste large structures, which would not fit or would use too much memory as a single VoxelBuffer.
+class VoxelSchematic : public RefCounted {
+	GDCLASS(VoxelSchematic, RefCounted)
+public:
+	VoxelSchematic();
+
+	void create(Vector3i size);
+	void clear();
+
+	Vector3i get_size() const;
+	Vector3i get_size_in_blocks() const;
+	int get_block_size() const;
+	int get_allocated_block_count() const;
+
+	int64_t get_voxel(Vector3i pos, int channel) const;
+	float get_voxel_f(Vector3i pos, int channel) const;
+
+	// Size of the schematic once pasted with the given transform
+	Vector3i get_transformed_size(Basis basis) const;
+
+	inline const ChunkedVoxelBuffer &get_buffer() const {
+		return *_buffer;
+	}
+
+	// Gets the buffer in order to modify it. If async tasks still reference it, they keep reading the previous data and
+	// the schematic gets its own copy. Blocks are shared between both, since they are replaced rather than modified.
+	ChunkedVoxelBuffer &get_buffer_for_write();
+
+	// Tasks working asynchronously may keep a reference so the data remains valid
+	inline std::shared_ptr<const ChunkedVoxelBuffer> get_buffer_shared() const {
+		return _buffer;
+	}
+
+	// Gets a transform that can be used to paste the schematic rotated or mirrored.
+	// Fails if the basis is not orthogonal with axes of length 1.
+	static bool try_get_grid_transform(Vector3i size, const Basis &basis, OrthoGridTransform &out_transform);
+
+private:
+	static void _bind_methods();
+
+	std::shared_ptr<ChunkedVoxelBuffer> _buffer;
+};
+
+} // namespace zylann::voxel::godot
+
+#endif // VOXEL_SCHEMATIC_GD_H
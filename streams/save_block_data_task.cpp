@@ -88,6 +88,7 @@ void SaveBlockDataTask::run(zylann::ThreadedTaskContext &ctx) {
 		// request
 		_voxels->copy_to(voxels_copy, true);
 		_voxels = nullptr;
+		// One block per task, so this doesn't go through `save_voxel_blocks`
 		VoxelStream::VoxelQueryData q{ voxels_copy, _position, _lod, VoxelStream::RESULT_ERROR };
 		stream->save_voxel_block(q);
 	}
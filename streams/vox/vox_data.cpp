@@ -1,4 +1,6 @@
 #include "vox_data.h"
+#include "../../storage/funcs.h"
+#include "../../storage/voxel_buffer.h"
 #include "../../util/containers/std_unordered_set.h"
 #include "../../util/godot/classes/file_access.h"
 #include "../../util/godot/core/array.h"
@@ -9,6 +11,8 @@
 namespace zylann::voxel::magica {
 
 const uint32_t PALETTE_SIZE = 256;
+// Each voxel of an XYZI chunk is stored as 4 bytes: X, Y, Z, color index
+const uint32_t XYZI_VOXEL_SIZE = 4;
 
 // clang-format off
 uint32_t g_default_palette[PALETTE_SIZE] = {
@@ -162,6 +166,25 @@ Basis parse_basis(uint8_t data) {
 	return b;
 }
 
+Error read_xyzi_voxels(FileAccess &f, uint32_t voxel_count, StdVector<uint8_t> &bytes) {
+	bytes.resize(voxel_count * XYZI_VOXEL_SIZE);
+	ERR_FAIL_COND_V(godot::get_buffer(f, to_span(bytes)) != bytes.size(), ERR_PARSE_ERROR);
+	return OK;
+}
+
+// Calls `f(position, color_index)` for each voxel read from an XYZI chunk, with positions in OpenGL convention.
+template <typename F>
+Error for_each_xyzi_voxel(Span<const uint8_t> bytes, Vector3i model_size, F f) {
+	for (unsigned int i = 0; i < bytes.size(); i += XYZI_VOXEL_SIZE) {
+		const Vector3i pos = magica_to_opengl(Vector3i(bytes[i], bytes[i + 1], bytes[i + 2]));
+		ERR_FAIL_COND_V(pos.x >= model_size.x, ERR_PARSE_ERROR);
+		ERR_FAIL_COND_V(pos.y >= model_size.y, ERR_PARSE_ERROR);
+		ERR_FAIL_COND_V(pos.z >= model_size.z, ERR_PARSE_ERROR);
+		f(pos, bytes[i + 3]);
+	}
+	return OK;
+}
+
 Error parse_node_common_header(Node &node, FileAccess &f, const StdUnorderedMap<int, UniquePtr<Node>> &scene_graph) {
 	//
 	const int node_id = f.get_32();
@@ -186,15 +209,15 @@ void Data::clear() {
 	_root_node_id = -1;
 }
 
-Error Data::load_from_file(String fpath) {
-	const Error err = _load_from_file(fpath);
+Error Data::load_from_file(String fpath, bool decode_models) {
+	const Error err = _load_from_file(fpath, decode_models);
 	if (err != OK) {
 		clear();
 	}
 	return err;
 }
 
-Error Data::_load_from_file(String fpath) {
+Error Data::_load_from_file(String fpath, bool decode_models) {
 	ZN_PROFILE_SCOPE();
 	// https://github.com/ephtracy/voxel-model/blob/master/MagicaVoxel-file-format-vox.txt
 	// https://github.com/ephtracy/voxel-model/blob/master/MagicaVoxel-file-format-vox-extension.txt
@@ -221,6 +244,8 @@ Error Data::_load_from_file(String fpath) {
 
 	clear();
 
+	StdVector<uint8_t> xyzi_bytes;
+
 	while (f.get_position() < file_length) {
 		char chunk_id[5] = { 0 };
 		ERR_FAIL_COND_V(godot::get_buffer(f, Span<uint8_t>((uint8_t *)chunk_id, 4)) != 4, ERR_PARSE_ERROR);
@@ -242,22 +267,33 @@ Error Data::_load_from_file(String fpath) {
 
 		} else if (strcmp(chunk_id, "XYZI") == 0) {
 			UniquePtr<Model> model = make_unique_instance<Model>();
-			model->color_indexes.resize(last_size.x * last_size.y * last_size.z, 0);
 			model->size = last_size;
+			model->voxel_count = f.get_32();
+			model->voxels_file_offset = f.get_position();
+			ERR_FAIL_COND_V(
+					uint64_t(model->voxel_count) * XYZI_VOXEL_SIZE > chunk_size || chunk_size < 4, ERR_PARSE_ERROR
+			);
+
+			if (decode_models) {
+				model->color_indexes.resize(Vector3iUtil::get_volume(model->size), 0);
+
+				const Error read_err = read_xyzi_voxels(f, model->voxel_count, xyzi_bytes);
+				ERR_FAIL_COND_V(read_err != OK, read_err);
+
+				Span<uint8_t> color_indexes = to_span(model->color_indexes);
+				const Vector3i model_size = model->size;
+				const Error decode_err = for_each_xyzi_voxel(
+						to_span_const(xyzi_bytes),
+						model_size,
+						[color_indexes, model_size](Vector3i pos, uint8_t c) {
+							color_indexes[Vector3iUtil::get_zxy_index(pos, model_size)] = c;
+						}
+				);
+				ERR_FAIL_COND_V(decode_err != OK, decode_err);
 
-			const uint32_t num_voxels = f.get_32();
-
-			for (uint32_t i = 0; i < num_voxels; ++i) {
-				Vector3i pos;
-				pos.x = f.get_8();
-				pos.y = f.get_8();
-				pos.z = f.get_8();
-				const uint32_t c = f.get_8();
-				pos = magica_to_opengl(pos);
-				ERR_FAIL_COND_V(pos.x >= model->size.x || pos.x < 0, ERR_PARSE_ERROR);
-				ERR_FAIL_COND_V(pos.y >= model->size.y || pos.y < 0, ERR_PARSE_ERROR);
-				ERR_FAIL_COND_V(pos.z >= model->size.z || pos.z < 0, ERR_PARSE_ERROR);
-				model->color_indexes[Vector3iUtil::get_zxy_index(pos, model->size)] = c;
+			} else {
+				// Voxels will be read later, only remember where they are
+				f.seek(model->voxels_file_offset + uint64_t(model->voxel_count) * XYZI_VOXEL_SIZE);
 			}
 
 			_models.push_back(std::move(model));
@@ -556,6 +592,62 @@ Error Data::_load_from_file(String fpath) {
 	return OK;
 }
 
+Error Data::read_model_voxels(FileAccess &f, unsigned int model_index, StdVector<uint8_t> &out_xyzi_bytes) const {
+	ZN_PROFILE_SCOPE();
+	ERR_FAIL_COND_V(model_index >= _models.size(), ERR_INVALID_PARAMETER);
+	const Model &model = *_models[model_index];
+	f.seek(model.voxels_file_offset);
+	return read_xyzi_voxels(f, model.voxel_count, out_xyzi_bytes);
+}
+
+Error Data::decode_model(
+		unsigned int model_index,
+		Span<const uint8_t> xyzi_bytes,
+		const IntBasis &basis,
+		VoxelBuffer &dst,
+		Vector3i dst_origin
+) const {
+	ZN_PROFILE_SCOPE();
+	ERR_FAIL_COND_V(model_index >= _models.size(), ERR_INVALID_PARAMETER);
+	const Model &model = *_models[model_index];
+	ERR_FAIL_COND_V(xyzi_bytes.size() != model.voxel_count * XYZI_VOXEL_SIZE, ERR_INVALID_PARAMETER);
+
+	const Vector3i dst_size = get_transformed_size(model.size, basis);
+	ERR_FAIL_COND_V(!Box3i(Vector3i(), dst.get_size()).contains(Box3i(dst_origin, dst_size)), ERR_INVALID_PARAMETER);
+
+	// Decompressing here would not be thread-safe, if several models are decoded into the same buffer
+	const VoxelBuffer::ChannelId channel = VoxelBuffer::CHANNEL_COLOR;
+	ERR_FAIL_COND_V(dst.get_channel_depth(channel) != VoxelBuffer::DEPTH_8_BIT, ERR_INVALID_PARAMETER);
+	ERR_FAIL_COND_V(dst.get_channel_compression(channel) != VoxelBuffer::COMPRESSION_NONE, ERR_INVALID_PARAMETER);
+
+	Span<uint8_t> dst_color_indexes;
+	ERR_FAIL_COND_V(!dst.get_channel_as_bytes(channel, dst_color_indexes), ERR_BUG);
+	const Vector3i dst_buffer_size = dst.get_size();
+
+	// When an axis is negated, coordinates along it start from the end
+	Vector3i origin = dst_origin;
+	for (int axis_index = 0; axis_index < Vector3iUtil::AXIS_COUNT; ++axis_index) {
+		if (basis.x[axis_index] + basis.y[axis_index] + basis.z[axis_index] < 0) {
+			origin[axis_index] += dst_size[axis_index] - 1;
+		}
+	}
+
+	// Positions are transformed as they get decoded, so no intermediate copy of the model is needed
+	return for_each_xyzi_voxel(
+			xyzi_bytes,
+			model.size,
+			[dst_color_indexes, dst_buffer_size, origin, &basis](Vector3i pos, uint8_t c) {
+				const Vector3i dst_pos = origin + basis.x * pos.x + basis.y * pos.y + basis.z * pos.z;
+				dst_color_indexes[Vector3iUtil::get_zxy_index(dst_pos, dst_buffer_size)] = c;
+			}
+	);
+}
+
+Vector3i get_transformed_size(Vector3i size, const IntBasis &basis) {
+	// The transformed size is a permutation of the original size
+	return math::abs(basis.x * size.x + basis.y * size.y + basis.z * size.z);
+}
+
 unsigned int Data::get_model_count() const {
 	return _models.size();
 }
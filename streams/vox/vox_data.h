@@ -2,9 +2,11 @@
 #define VOX_DATA_H
 
 #include "../../util/containers/fixed_array.h"
+#include "../../util/containers/span.h"
 #include "../../util/containers/std_unordered_map.h"
 #include "../../util/containers/std_vector.h"
 #include "../../util/godot/core/string.h"
+#include "../../util/godot/macros.h"
 #include "../../util/math/basis.h"
 #include "../../util/math/color8.h"
 #include "../../util/math/vector3i.h"
@@ -14,14 +16,26 @@
 #include <godot_cpp/classes/global_constants.hpp> // For `Error`
 #endif
 
-namespace zylann::voxel::magica {
+ZN_GODOT_FORWARD_DECLARE(class FileAccess)
+#ifdef ZN_GODOT_EXTENSION
+using namespace godot;
+#endif
+
+namespace zylann::voxel {
+
+class VoxelBuffer;
+struct IntBasis;
+
+namespace magica {
 
 struct Model {
 	Vector3i size;
-	// TODO Optimization: implement lazy loading/streaming to reduce intermediary memory allocations?
-	// Loading a full 256^3 model needs 16 megabytes, but a lot of areas might actually be uniform,
-	// and we might not need the actual model immediately
+	// Only filled if models were decoded when loading the file. Loading a full 256^3 model needs 16 megabytes, so
+	// for big scenes it is better to decode models later with `Data::decode_model`, directly where they are needed.
 	StdVector<uint8_t> color_indexes;
+	// Location of the voxels of this model in the file, as a list of `voxel_count` XYZI entries
+	uint64_t voxels_file_offset = 0;
+	uint32_t voxel_count = 0;
 };
 
 struct Node {
@@ -100,7 +114,26 @@ struct Material {
 class Data {
 public:
 	void clear();
-	Error load_from_file(String fpath);
+	// If `decode_models` is false, only the location of voxel data is stored for each model, and the file must remain
+	// accessible until models are read with `read_model_voxels`.
+	Error load_from_file(String fpath, bool decode_models = true);
+
+	// Reads the XYZI entries of a model. `f` must be opened on the file the data was loaded from. The same file can be
+	// used to read every model, but only from one thread at a time.
+	Error read_model_voxels(FileAccess &f, unsigned int model_index, StdVector<uint8_t> &out_xyzi_bytes) const;
+
+	// Decodes XYZI entries obtained with `read_model_voxels` into the color channel of `dst`, as 8-bit palette indices.
+	// `basis` is applied to positions, and must only contain axis-aligned unit vectors.
+	// `dst` must have an uncompressed 8-bit color channel, large enough to contain the transformed model at
+	// `dst_origin`. Only voxels present in the model are written, others are left untouched.
+	// Can be called from multiple threads.
+	Error decode_model(
+			unsigned int model_index,
+			Span<const uint8_t> xyzi_bytes,
+			const IntBasis &basis,
+			VoxelBuffer &dst,
+			Vector3i dst_origin
+	) const;
 
 	unsigned int get_model_count() const;
 	const Model &get_model(unsigned int index) const;
@@ -120,7 +153,7 @@ public:
 	}
 
 private:
-	Error _load_from_file(String fpath);
+	Error _load_from_file(String fpath, bool decode_models);
 
 	StdVector<UniquePtr<Model>> _models;
 	StdVector<UniquePtr<Layer>> _layers;
@@ -131,6 +164,10 @@ private:
 	FixedArray<Color8, 256> _palette;
 };
 
-} // namespace zylann::voxel::magica
+// Gets the size of a model after applying an axis-aligned basis to it
+Vector3i get_transformed_size(Vector3i size, const IntBasis &basis);
+
+} // namespace magica
+} // namespace zylann::voxel
 
 #endif // VOX_DATA_H
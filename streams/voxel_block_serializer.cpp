@@ -3,6 +3,7 @@
 #include "../storage/voxel_memory_pool.h"
 #include "../util/dstack.h"
 #include "../util/godot/classes/file_access.h"
+#include "../util/hash_funcs.h"
 #include "../util/io/serialization.h"
 #include "../util/math/vector3i.h"
 #include "../util/profiling.h"
@@ -382,6 +383,38 @@ SerializeResult serialize(const VoxelBuffer &voxel_buffer) {
 	return SerializeResult(dst_data, true);
 }
 
+uint64_t compute_hash(const VoxelBuffer &voxel_buffer) {
+	ZN_PROFILE_SCOPE();
+
+	uint64_t h = hash_djb2_one_64(voxel_buffer.get_size().x);
+	h = hash_djb2_one_64(voxel_buffer.get_size().y, h);
+	h = hash_djb2_one_64(voxel_buffer.get_size().z, h);
+
+	for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+		h = hash_djb2_one_64(voxel_buffer.get_channel_depth(channel_index), h);
+
+		// Channels having the same value everywhere hash the same whether they are compressed or not
+		if (voxel_buffer.is_uniform(channel_index)) {
+			h = hash_djb2_one_64(voxel_buffer.get_voxel(Vector3i(), channel_index), h);
+		} else {
+			Span<const uint8_t> data;
+			ZN_ASSERT_CONTINUE(voxel_buffer.get_channel_as_bytes_read_only(channel_index, data));
+			h = hash_fnv1a_64(data, h);
+		}
+	}
+
+	const size_t metadata_size = get_metadata_size_in_bytes(voxel_buffer);
+	if (metadata_size > 0) {
+		StdVector<uint8_t> &metadata_tmp = get_tls_metadata_tmp();
+		metadata_tmp.resize(metadata_size);
+		serialize_metadata(to_span(metadata_tmp), voxel_buffer);
+		h = hash_fnv1a_64(to_span(metadata_tmp), h);
+		metadata_tmp.clear();
+	}
+
+	return h;
+}
+
 namespace legacy {
 
 bool migrate_v3_to_v4(Span<const uint8_t> p_data, StdVector<uint8_t> &dst) {
@@ -38,6 +38,11 @@ SerializeResult serialize_and_compress(const VoxelBuffer &voxel_buffer);
 bool decompress_and_deserialize(Span<const uint8_t> p_data, VoxelBuffer &out_voxel_buffer);
 bool decompress_and_deserialize(FileAccess &f, unsigned int size_to_read, VoxelBuffer &out_voxel_buffer);
 
+// Computes a hash of the voxels and metadata of a buffer. Unlike hashing serialized data, it doesn't depend on how
+// channels are compressed in memory, so the same voxels give the same hash after being saved and loaded. Channel
+// depths are taken into account.
+uint64_t compute_hash(const VoxelBuffer &voxel_buffer);
+
 // Temporary thread-local buffers for internal use
 StdVector<uint8_t> &get_tls_data();
 StdVector<uint8_t> &get_tls_compressed_data();
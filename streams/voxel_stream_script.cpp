@@ -2,14 +2,39 @@
 #include "../constants/voxel_string_names.h"
 #include "../storage/voxel_buffer_gd.h"
 #include "../util/godot/check_ref_ownership.h"
+#include "../util/io/log.h"
+#include "../util/string/format.h"
 
 namespace zylann::voxel {
 
+namespace {
+
+Ref<godot::VoxelBuffer> create_buffer_wrapper(const VoxelBuffer &voxels) {
+	return Ref<godot::VoxelBuffer>(
+			memnew(godot::VoxelBuffer(static_cast<godot::VoxelBuffer::Allocator>(voxels.get_allocator())))
+	);
+}
+
+// Gathers block positions and LODs in the form scripts receive them
+void get_block_locations(
+		Span<const VoxelStream::VoxelQueryData> blocks,
+		TypedArray<Vector3i> &out_positions,
+		PackedInt32Array &out_lods
+) {
+	out_positions.resize(blocks.size());
+	out_lods.resize(blocks.size());
+	for (unsigned int i = 0; i < blocks.size(); ++i) {
+		out_positions[i] = blocks[i].position_in_blocks;
+		out_lods.set(i, blocks[i].lod_index);
+	}
+}
+
+} // namespace
+
 void VoxelStreamScript::load_voxel_block(VoxelStream::VoxelQueryData &query_data) {
 	Variant output;
 	// Create a temporary wrapper so Godot can pass it to scripts
-	Ref<godot::VoxelBuffer> buffer_wrapper(memnew(
-			godot::VoxelBuffer(static_cast<godot::VoxelBuffer::Allocator>(query_data.voxel_buffer.get_allocator()))));
+	Ref<godot::VoxelBuffer> buffer_wrapper = create_buffer_wrapper(query_data.voxel_buffer);
 	buffer_wrapper->get_buffer().copy_format(query_data.voxel_buffer);
 	buffer_wrapper->get_buffer().create(query_data.voxel_buffer.get_size());
 
@@ -34,14 +59,99 @@ void VoxelStreamScript::load_voxel_block(VoxelStream::VoxelQueryData &query_data
 
 void VoxelStreamScript::save_voxel_block(VoxelStream::VoxelQueryData &query_data) {
 	// For now the callee can exceptionally take ownership of this wrapper, because we copy the data to it.
-	Ref<godot::VoxelBuffer> buffer_wrapper(memnew(
-			godot::VoxelBuffer(static_cast<godot::VoxelBuffer::Allocator>(query_data.voxel_buffer.get_allocator()))));
+	Ref<godot::VoxelBuffer> buffer_wrapper = create_buffer_wrapper(query_data.voxel_buffer);
 	query_data.voxel_buffer.copy_to(buffer_wrapper->get_buffer(), true);
 	if (!GDVIRTUAL_CALL(_save_voxel_block, buffer_wrapper, query_data.position_in_blocks, query_data.lod_index)) {
 		WARN_PRINT_ONCE("VoxelStreamScript::_save_voxel_block is unimplemented!");
 	}
 }
 
+void VoxelStreamScript::load_voxel_blocks(Span<VoxelStream::VoxelQueryData> p_blocks) {
+	if (p_blocks.size() == 0) {
+		return;
+	}
+
+	// All blocks are passed in a single call, because calling into scripts has a significant cost
+	TypedArray<godot::VoxelBuffer> buffer_wrappers;
+	buffer_wrappers.resize(p_blocks.size());
+	for (unsigned int i = 0; i < p_blocks.size(); ++i) {
+		const VoxelBuffer &voxels = p_blocks[i].voxel_buffer;
+		Ref<godot::VoxelBuffer> buffer_wrapper = create_buffer_wrapper(voxels);
+		buffer_wrapper->get_buffer().copy_format(voxels);
+		buffer_wrapper->get_buffer().create(voxels.get_size());
+		buffer_wrappers[i] = buffer_wrapper;
+	}
+
+	TypedArray<Vector3i> positions;
+	PackedInt32Array lods;
+	get_block_locations(to_span_const(p_blocks), positions, lods);
+
+	PackedInt32Array results;
+	if (!GDVIRTUAL_CALL(_load_voxel_blocks, buffer_wrappers, positions, lods, results)) {
+		// Not implemented, fallback on loading blocks one by one
+		VoxelStream::load_voxel_blocks(p_blocks);
+		return;
+	}
+
+	if (results.size() != static_cast<int>(p_blocks.size())) {
+		ZN_PRINT_ERROR(format("_load_voxel_blocks returned {} results, expected {}", results.size(), p_blocks.size()));
+	}
+
+	for (unsigned int i = 0; i < p_blocks.size(); ++i) {
+		VoxelStream::VoxelQueryData &query_data = p_blocks[i];
+		query_data.result = RESULT_ERROR;
+
+		if (i >= static_cast<unsigned int>(results.size())) {
+			continue;
+		}
+		const int res = results[i];
+		// Check if the return enum is valid
+		ZN_ASSERT_CONTINUE(res >= 0 && res < _RESULT_COUNT);
+
+		// If the block was found, grab its data from the script-facing object to our internal buffer
+		if (res == RESULT_BLOCK_FOUND) {
+			Ref<godot::VoxelBuffer> buffer_wrapper = buffer_wrappers[i];
+			ZN_ASSERT_CONTINUE(buffer_wrapper.is_valid());
+			buffer_wrapper->get_buffer().move_to(query_data.voxel_buffer);
+		}
+		query_data.result = ResultCode(res);
+	}
+}
+
+void VoxelStreamScript::save_voxel_blocks(Span<VoxelStream::VoxelQueryData> p_blocks) {
+	if (p_blocks.size() == 0) {
+		return;
+	}
+
+	// The callee can take ownership of these wrappers, because we copy the data to them.
+	TypedArray<godot::VoxelBuffer> buffer_wrappers;
+	buffer_wrappers.resize(p_blocks.size());
+	for (unsigned int i = 0; i < p_blocks.size(); ++i) {
+		const VoxelBuffer &voxels = p_blocks[i].voxel_buffer;
+		Ref<godot::VoxelBuffer> buffer_wrapper = create_buffer_wrapper(voxels);
+		voxels.copy_to(buffer_wrapper->get_buffer(), true);
+		buffer_wrappers[i] = buffer_wrapper;
+	}
+
+	TypedArray<Vector3i> positions;
+	PackedInt32Array lods;
+	get_block_locations(to_span_const(p_blocks), positions, lods);
+
+	if (!GDVIRTUAL_CALL(_save_voxel_blocks, buffer_wrappers, positions, lods)) {
+		// Not implemented, fallback on saving blocks one by one, reusing the copies we already made
+		for (unsigned int i = 0; i < p_blocks.size(); ++i) {
+			const VoxelStream::VoxelQueryData &query_data = p_blocks[i];
+			Ref<godot::VoxelBuffer> buffer_wrapper = buffer_wrappers[i];
+			if (!GDVIRTUAL_CALL(
+						_save_voxel_block, buffer_wrapper, query_data.position_in_blocks, query_data.lod_index
+				)) {
+				WARN_PRINT_ONCE("VoxelStreamScript::_save_voxel_block is unimplemented!");
+				break;
+			}
+		}
+	}
+}
+
 int VoxelStreamScript::get_used_channels_mask() const {
 	int mask = 0;
 	if (!GDVIRTUAL_CALL(_get_used_channels_mask, mask)) {
@@ -54,6 +164,8 @@ void VoxelStreamScript::_bind_methods() {
 	// TODO Test if GDVIRTUAL can print errors properly when GDScript fails inside a different thread.
 	GDVIRTUAL_BIND(_load_voxel_block, "out_buffer", "position_in_blocks", "lod");
 	GDVIRTUAL_BIND(_save_voxel_block, "buffer", "position_in_blocks", "lod");
+	GDVIRTUAL_BIND(_load_voxel_blocks, "out_buffers", "positions_in_blocks", "lods");
+	GDVIRTUAL_BIND(_save_voxel_blocks, "buffers", "positions_in_blocks", "lods");
 	GDVIRTUAL_BIND(_get_used_channels_mask);
 }
 
@@ -1,14 +1,12 @@
 #ifndef VOXEL_STREAM_SCRIPT_H
 #define VOXEL_STREAM_SCRIPT_H
 
+#include "../storage/voxel_buffer_gd.h" // GDVIRTUAL wants the full definition of the class with TypedArray
 #include "../util/godot/core/gdvirtual.h"
+#include "../util/godot/core/packed_arrays.h"
+#include "../util/godot/core/typed_array.h"
 #include "voxel_stream.h"
 
-#ifdef ZN_GODOT_EXTENSION
-// GodotCpp wants the full definition of the class in GDVIRTUAL
-#include "../storage/voxel_buffer_gd.h"
-#endif
-
 namespace zylann::voxel {
 
 // Provides access to a source of paged voxel data, which may load and save.
@@ -20,12 +18,23 @@ public:
 	void load_voxel_block(VoxelStream::VoxelQueryData &q) override;
 	void save_voxel_block(VoxelStream::VoxelQueryData &q) override;
 
+	void load_voxel_blocks(Span<VoxelStream::VoxelQueryData> p_blocks) override;
+	void save_voxel_blocks(Span<VoxelStream::VoxelQueryData> p_blocks) override;
+
 	int get_used_channels_mask() const override;
 
 protected:
 	// TODO Why is it unable to convert `Result` into `Variant` even though a cast is defined in voxel_stream.h???
 	GDVIRTUAL3R(int, _load_voxel_block, Ref<godot::VoxelBuffer>, Vector3i, int)
 	GDVIRTUAL3(_save_voxel_block, Ref<godot::VoxelBuffer>, Vector3i, int)
+	GDVIRTUAL3R(
+			PackedInt32Array,
+			_load_voxel_blocks,
+			TypedArray<godot::VoxelBuffer>,
+			TypedArray<Vector3i>,
+			PackedInt32Array
+	)
+	GDVIRTUAL3(_save_voxel_blocks, TypedArray<godot::VoxelBuffer>, TypedArray<Vector3i>, PackedInt32Array)
 	GDVIRTUAL0RC(int, _get_used_channels_mask) // I think `C` means `const`?
 
 	static void _bind_methods();
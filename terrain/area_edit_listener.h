@@ -0,0 +1,20 @@
+#ifndef VOXEL_AREA_EDIT_LISTENER_H
+#define VOXEL_AREA_EDIT_LISTENER_H
+
+#include "../util/math/box3i.h"
+
+namespace zylann::voxel {
+
+// Implemented by objects caching information derived from voxels of a terrain, which must be updated when voxels
+// change.
+class IAreaEditListener {
+public:
+	virtual ~IAreaEditListener() {}
+	// Called on the main thread after voxels changed in the given box. This happens after edits, and also when
+	// blocks are loaded, received from the network or unloaded, because that changes what reading voxels returns.
+	virtual void on_area_edited(Box3i box_in_voxels) = 0;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_AREA_EDIT_LISTENER_H
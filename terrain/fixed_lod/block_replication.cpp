@@ -0,0 +1,887 @@
+#include "block_replication.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../storage/voxel_data.h"
+#include "../../streams/voxel_block_serializer.h"
+#include "../../streams/voxel_stream.h"
+#include "../../util/containers/container_funcs.h"
+#include "../../util/io/log.h"
+#include "../../util/io/serialization.h"
+#include "../../util/math/conv.h"
+#include "../../util/math/funcs.h"
+#include "../../util/memory/memory.h"
+#include "../../util/profiling.h"
+#include "../../util/string/format.h"
+#include <algorithm>
+
+namespace zylann::voxel {
+
+namespace {
+
+enum BlockMessageType : uint8_t {
+	// Contains all voxels of the block
+	BLOCK_MESSAGE_FULL = 0,
+	// Contains voxels XORed with the previous version of the block
+	BLOCK_MESSAGE_DELTA = 1,
+	// No data, the block reported by the client from its cache is up to date
+	BLOCK_MESSAGE_CACHED = 2
+};
+
+// Position, type, version and data size
+const unsigned int BLOCK_MESSAGE_HEADER_SIZE =
+		3 * sizeof(int16_t) + sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint16_t);
+
+// Position and hash
+const unsigned int CACHE_REPORT_ENTRY_SIZE = 3 * sizeof(int16_t) + sizeof(uint64_t);
+
+// Limits how many blocks a client can ask or report in one message
+const unsigned int MAX_BLOCKS_PER_CLIENT_MESSAGE = 4096;
+
+// Limits how many hashes the server remembers per peer. Reports are consumed when blocks are sent, so this is only
+// reached if a client reports blocks it never enters.
+const unsigned int MAX_CACHED_HASHES_PER_PEER = 65536;
+
+// Limits how many blocks are loaded from the cache by one job, so a big area doesn't occupy the IO thread for long
+const unsigned int MAX_CACHE_LOOKUPS_PER_JOB = 256;
+
+bool have_same_channel_depths(const VoxelBuffer &a, const VoxelBuffer &b) {
+	for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+		if (a.get_channel_depth(channel_index) != b.get_channel_depth(channel_index)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void store_block_position(MemoryWriterExistingBuffer &mw, Vector3i bpos) {
+	// This effectively limits volume size to 1,048,576. If really required, we could double this data to cover more.
+	mw.store_16(bpos.x);
+	mw.store_16(bpos.y);
+	mw.store_16(bpos.z);
+}
+
+Vector3i get_block_position(MemoryReader &mr) {
+	Vector3i bpos;
+	bpos.x = int16_t(mr.get_16());
+	bpos.y = int16_t(mr.get_16());
+	bpos.z = int16_t(mr.get_16());
+	return bpos;
+}
+
+} // namespace
+
+// Server
+
+void BlockReplicationServer::send_block(int peer_id, Vector3i bpos) {
+	PeerQueue &queue = _peer_queues[peer_id];
+
+	QueuedBlock &qb = queue.loads[bpos];
+	if (qb.state == STATE_SERIALIZING) {
+		// Will be up to date already
+		return;
+	}
+	queue.queued_bytes -= qb.get_data_size();
+	qb.position = bpos;
+	qb.type = BLOCK_MESSAGE_FULL;
+	qb.version = 0;
+	qb.data.reset();
+
+	if (queue.waiting_cache_report && _cache_report_timeout > 0.f) {
+		// The peer may have the block in its cache. Its hash must be known before serializing, otherwise it would be
+		// sent in full.
+		qb.state = STATE_DEFERRED;
+		return;
+	}
+
+	if (_max_queued_bytes > 0 &&
+		queue.queued_bytes + queue.serializing_count * _average_payload_size >= _max_queued_bytes) {
+		// The peer can't receive blocks as fast as they enter its area. Don't serialize them now, they would only take
+		// memory until they get sent, and could get outdated in the meantime.
+		qb.state = STATE_DEFERRED;
+		return;
+	}
+
+	qb.state = STATE_SERIALIZING;
+	++queue.serializing_count;
+	request_serialization(peer_id, bpos);
+}
+
+void BlockReplicationServer::request_serialization(int peer_id, Vector3i bpos) {
+	SerializationRequest &request = _serialization_requests[bpos];
+
+	auto peer_hashes_it = _peer_cached_hashes.find(peer_id);
+	if (peer_hashes_it != _peer_cached_hashes.end()) {
+		const StdUnorderedMap<Vector3i, uint64_t> &hashes = peer_hashes_it->second;
+		if (hashes.find(bpos) != hashes.end()) {
+			request.compute_hash = true;
+		}
+	}
+}
+
+void BlockReplicationServer::mark_block_edited(Vector3i bpos) {
+	auto it = _replicated_blocks.find(bpos);
+	if (it == _replicated_blocks.end()) {
+		// No peer has this block
+		return;
+	}
+	ReplicatedBlock &rb = it->second;
+	if (!rb.edited) {
+		rb.edited = true;
+		_edited_blocks.push_back(bpos);
+	}
+}
+
+void BlockReplicationServer::send_edited_blocks() {
+	for (const Vector3i bpos : _edited_blocks) {
+		if (_replicated_blocks.find(bpos) != _replicated_blocks.end()) {
+			_serialization_requests[bpos].edited = true;
+		}
+	}
+	_edited_blocks.clear();
+}
+
+void BlockReplicationServer::take_serialization_jobs(StdVector<SerializationJob> &out_jobs) {
+	ZN_PROFILE_SCOPE();
+
+	for (auto it = _serialization_requests.begin(); it != _serialization_requests.end();) {
+		const Vector3i bpos = it->first;
+
+		if (_blocks_being_serialized.find(bpos) != _blocks_being_serialized.end()) {
+			// Results of the current job might be outdated, wait for it to finish
+			++it;
+			continue;
+		}
+
+		const SerializationRequest &request = it->second;
+		SerializationJob job;
+		job.position = bpos;
+		job.compute_hash = request.compute_hash;
+
+		if (request.edited) {
+			auto rb_it = _replicated_blocks.find(bpos);
+			if (rb_it != _replicated_blocks.end() && rb_it->second.baseline != nullptr) {
+				ReplicatedBlock &rb = rb_it->second;
+				job.baseline = rb.baseline;
+				// Edits done from now on will be replicated by the next job
+				rb.edited = false;
+			}
+		}
+
+		out_jobs.push_back(job);
+		_blocks_being_serialized.insert(bpos);
+		it = _serialization_requests.erase(it);
+	}
+}
+
+void BlockReplicationServer::SerializationJob::run(VoxelData &data, SerializationResult &out_result) const {
+	ZN_PROFILE_SCOPE();
+
+	out_result.position = position;
+	out_result.edited = baseline != nullptr;
+	out_result.success = false;
+
+	SpatialLock3D::Read srlock(data.get_spatial_lock(0), BoxBounds3i::from_position(position));
+
+	std::shared_ptr<VoxelBuffer> voxels = data.try_get_block_voxels(position);
+	if (voxels == nullptr) {
+		// Unloaded in the meantime
+		return;
+	}
+
+	BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(*voxels);
+	ZN_ASSERT_RETURN(result.success);
+	ZN_ASSERT_RETURN(result.data.size() <= 65535);
+
+	if (compute_hash) {
+		out_result.hash = BlockSerializer::compute_hash(*voxels);
+	}
+
+	if (baseline != nullptr && result.data != *baseline) {
+		// Peers having the previous version only need to know which voxels changed. Unchanged voxels become zeroes,
+		// which compress very well.
+		VoxelBuffer delta_voxels(VoxelBuffer::ALLOCATOR_POOL);
+		if (BlockSerializer::decompress_and_deserialize(to_span(*baseline), delta_voxels) &&
+			delta_voxels.get_size() == voxels->get_size() && have_same_channel_depths(delta_voxels, *voxels)) {
+			delta_voxels.xor_channels_from(*voxels);
+			delta_voxels.compress_uniform_channels();
+			delta_voxels.clear_voxel_metadata();
+			delta_voxels.copy_voxel_metadata(*voxels);
+
+			BlockSerializer::SerializeResult delta_result = BlockSerializer::serialize_and_compress(delta_voxels);
+			if (delta_result.success && delta_result.data.size() < result.data.size()) {
+				out_result.delta = make_shared_instance<StdVector<uint8_t>>(std::move(delta_result.data));
+			}
+		}
+	}
+
+	out_result.data = make_shared_instance<StdVector<uint8_t>>(std::move(result.data));
+	out_result.success = true;
+}
+
+void BlockReplicationServer::apply_serialization_result(
+		const SerializationResult &result,
+		Span<const int> edit_peer_ids
+) {
+	_blocks_being_serialized.erase(result.position);
+
+	if (result.success) {
+		if (_average_payload_size == 0) {
+			_average_payload_size = result.data->size();
+		} else {
+			_average_payload_size = (_average_payload_size * 7 + result.data->size()) / 8;
+		}
+	}
+
+	// Edits must be applied first, so peers getting the block for the first time get the new version
+	if (result.edited && result.success) {
+		apply_edit(result, edit_peer_ids);
+	}
+
+	for (auto it = _peer_queues.begin(); it != _peer_queues.end(); ++it) {
+		PeerQueue &queue = it->second;
+		auto load_it = queue.loads.find(result.position);
+		if (load_it == queue.loads.end() || load_it->second.state != STATE_SERIALIZING) {
+			continue;
+		}
+		--queue.serializing_count;
+		if (!result.success) {
+			queue.loads.erase(load_it);
+			continue;
+		}
+		apply_load(it->first, load_it->second, result);
+		queue.queued_bytes += load_it->second.get_data_size();
+	}
+}
+
+void BlockReplicationServer::apply_load(int peer_id, QueuedBlock &qb, const SerializationResult &result) {
+	ReplicatedBlock &rb = _replicated_blocks[result.position];
+	uint32_t peer_version;
+
+	if (rb.baseline == nullptr) {
+		// First time the block is sent
+		rb.baseline = result.data;
+		peer_version = rb.version;
+
+	} else if (!rb.edited && *rb.baseline == *result.data) {
+		peer_version = rb.version;
+
+	} else {
+		// The peer gets contents other peers don't have yet, so it can't use deltas until the next full update
+		peer_version = INVALID_VERSION;
+	}
+
+	bool found = false;
+	for (PeerVersion &pv : rb.peers) {
+		if (pv.peer_id == peer_id) {
+			pv.version = peer_version;
+			found = true;
+			break;
+		}
+	}
+	if (!found) {
+		rb.peers.push_back(PeerVersion{ peer_id, peer_version });
+	}
+
+	bool is_cached = false;
+	auto peer_hashes_it = _peer_cached_hashes.find(peer_id);
+	if (peer_hashes_it != _peer_cached_hashes.end()) {
+		StdUnorderedMap<Vector3i, uint64_t> &hashes = peer_hashes_it->second;
+		auto hash_it = hashes.find(result.position);
+		if (hash_it != hashes.end()) {
+			// If the hash was reported after the job started, it wasn't computed. The block will be sent in full.
+			is_cached = hash_it->second == result.hash;
+			hashes.erase(hash_it);
+		}
+	}
+
+	qb.version = peer_version;
+	qb.state = STATE_READY;
+	if (is_cached) {
+		qb.type = BLOCK_MESSAGE_CACHED;
+		qb.data.reset();
+	} else {
+		qb.type = BLOCK_MESSAGE_FULL;
+		qb.data = result.data;
+	}
+}
+
+void BlockReplicationServer::apply_edit(const SerializationResult &result, Span<const int> peer_ids) {
+	const Vector3i bpos = result.position;
+
+	auto it = _replicated_blocks.find(bpos);
+	if (it == _replicated_blocks.end()) {
+		// Unloaded in the meantime
+		return;
+	}
+	ReplicatedBlock &rb = it->second;
+
+	if (rb.baseline != nullptr && *result.data == *rb.baseline) {
+		// Edits didn't change anything
+		return;
+	}
+
+	const uint32_t prev_version = rb.version;
+	++rb.version;
+	if (rb.version == INVALID_VERSION) {
+		rb.version = 0;
+	}
+	rb.baseline = result.data;
+
+	for (const int peer_id : peer_ids) {
+		PeerVersion *peer_version = nullptr;
+		for (PeerVersion &pv : rb.peers) {
+			if (pv.peer_id == peer_id) {
+				peer_version = &pv;
+				break;
+			}
+		}
+		if (peer_version == nullptr) {
+			// The peer was not sent this block yet, it will get it when the block enters its area
+			continue;
+		}
+
+		PeerQueue &queue = _peer_queues[peer_id];
+
+		auto load_it = queue.loads.find(bpos);
+		if (load_it != queue.loads.end()) {
+			// The peer has not received the block yet
+			QueuedBlock &qb = load_it->second;
+			if (qb.state == STATE_READY) {
+				// Send the new version instead
+				queue.queued_bytes -= qb.get_data_size();
+				qb.type = BLOCK_MESSAGE_FULL;
+				qb.version = rb.version;
+				qb.data = rb.baseline;
+				queue.queued_bytes += qb.get_data_size();
+				peer_version->version = rb.version;
+			}
+			// Otherwise it will get serialized from up-to-date voxels
+			continue;
+		}
+
+		QueuedBlock qb;
+		qb.position = bpos;
+		qb.version = rb.version;
+		qb.state = STATE_READY;
+		if (result.delta != nullptr && peer_version->version == prev_version) {
+			qb.type = BLOCK_MESSAGE_DELTA;
+			qb.data = result.delta;
+		} else {
+			qb.type = BLOCK_MESSAGE_FULL;
+			qb.data = rb.baseline;
+		}
+		queue.queued_bytes += qb.get_data_size();
+		queue.edits.push_back(std::move(qb));
+		peer_version->version = rb.version;
+	}
+}
+
+bool BlockReplicationServer::prepare_sending(PeerQueue &queue, float delta_time) {
+	if (queue.waiting_cache_report) {
+		queue.cache_report_wait_time += delta_time;
+		if (queue.cache_report_wait_time < _cache_report_timeout) {
+			return false;
+		}
+		// The peer might not be reporting its cache. Deferred blocks get serialized from now on.
+		queue.waiting_cache_report = false;
+	}
+
+	if (_bandwidth_limit > 0) {
+		// Allows bursts of up to one second worth of data after being idle
+		queue.budget = math::min(queue.budget + double(_bandwidth_limit) * delta_time, double(_bandwidth_limit));
+		if (queue.budget <= 0.0) {
+			return false;
+		}
+	}
+
+	if (queue.edits.size() == 0 && queue.loads.size() == 0) {
+		return false;
+	}
+
+	queue.sorted_loads.clear();
+	for (auto it = queue.loads.begin(); it != queue.loads.end(); ++it) {
+		queue.sorted_loads.push_back(it->first);
+	}
+
+	// Closest last
+	const Vector3f viewer_pos = queue.position_in_blocks;
+	std::sort(queue.sorted_loads.begin(), queue.sorted_loads.end(), [viewer_pos](Vector3i a, Vector3i b) {
+		const Vector3f half(0.5f);
+		return math::distance_squared(to_vec3f(a) + half, viewer_pos) >
+				math::distance_squared(to_vec3f(b) + half, viewer_pos);
+	});
+	queue.next_sorted_load = queue.sorted_loads.size();
+
+	return true;
+}
+
+bool BlockReplicationServer::pop_message(PeerQueue &queue) {
+	ZN_PROFILE_SCOPE();
+
+	_message.clear();
+	// Reserve space for the block count
+	_message.resize(sizeof(uint32_t));
+	uint32_t block_count = 0;
+	unsigned int sent_edits_count = 0;
+
+	while (_bandwidth_limit == 0 || queue.budget > 0.0) {
+		const QueuedBlock *qb = nullptr;
+		bool is_edit = false;
+
+		if (sent_edits_count < queue.edits.size()) {
+			// Edits are sent first, they matter more to players than new blocks
+			qb = &queue.edits[sent_edits_count];
+			is_edit = true;
+
+		} else if (queue.next_sorted_load > 0) {
+			const Vector3i bpos = queue.sorted_loads[queue.next_sorted_load - 1];
+			auto load_it = queue.loads.find(bpos);
+			if (load_it == queue.loads.end() || load_it->second.state != STATE_READY) {
+				// Unloaded in the meantime, or not serialized yet
+				--queue.next_sorted_load;
+				continue;
+			}
+			qb = &load_it->second;
+
+		} else {
+			break;
+		}
+
+		const size_t entry_size = BLOCK_MESSAGE_HEADER_SIZE + qb->get_data_size();
+		if (_message_size_target > 0 && block_count > 0 && _message.size() + entry_size > _message_size_target) {
+			// Continue in another message
+			break;
+		}
+
+		const size_t pos = _message.size();
+		_message.resize(pos + entry_size);
+		ByteSpanWithPosition mw_span(to_span(_message), pos);
+		MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
+
+		store_block_position(mw, qb->position);
+		mw.store_8(qb->type);
+		mw.store_32(qb->version);
+		mw.store_16(qb->get_data_size());
+		if (qb->get_data_size() > 0) {
+			mw.store_buffer(to_span(*qb->data));
+		}
+
+		++block_count;
+		queue.budget -= entry_size;
+		queue.queued_bytes -= qb->get_data_size();
+
+		if (is_edit) {
+			++sent_edits_count;
+		} else {
+			const Vector3i bpos = qb->position;
+			queue.loads.erase(bpos);
+			--queue.next_sorted_load;
+		}
+	}
+
+	queue.edits.erase(queue.edits.begin(), queue.edits.begin() + sent_edits_count);
+
+	if (block_count == 0) {
+		return false;
+	}
+
+	ByteSpanWithPosition mw_span(to_span(_message), 0);
+	MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
+	mw.store_32(block_count);
+	return true;
+}
+
+void BlockReplicationServer::request_deferred_blocks(int peer_id, PeerQueue &queue) {
+	// Closest first
+	for (unsigned int i = queue.sorted_loads.size(); i > 0; --i) {
+		if (_max_queued_bytes > 0 &&
+			queue.queued_bytes + queue.serializing_count * _average_payload_size >= _max_queued_bytes) {
+			break;
+		}
+		auto it = queue.loads.find(queue.sorted_loads[i - 1]);
+		if (it == queue.loads.end() || it->second.state != STATE_DEFERRED) {
+			continue;
+		}
+		it->second.state = STATE_SERIALIZING;
+		++queue.serializing_count;
+		request_serialization(peer_id, it->first);
+	}
+}
+
+void BlockReplicationServer::set_peer_position(int peer_id, Vector3f position_in_blocks) {
+	auto it = _peer_queues.find(peer_id);
+	if (it == _peer_queues.end()) {
+		// Nothing to send to this peer. The queue is created when a block is sent.
+		return;
+	}
+	it->second.position_in_blocks = position_in_blocks;
+}
+
+void BlockReplicationServer::set_bandwidth_limit(unsigned int bytes_per_second) {
+	_bandwidth_limit = bytes_per_second;
+}
+
+void BlockReplicationServer::set_message_size_target(unsigned int bytes) {
+	_message_size_target = bytes;
+}
+
+void BlockReplicationServer::set_max_queued_bytes(unsigned int bytes) {
+	_max_queued_bytes = bytes;
+}
+
+void BlockReplicationServer::set_cache_report_timeout(float seconds) {
+	_cache_report_timeout = math::max(seconds, 0.f);
+}
+
+size_t BlockReplicationServer::get_queued_bytes(int peer_id) const {
+	auto it = _peer_queues.find(peer_id);
+	if (it == _peer_queues.end()) {
+		return 0;
+	}
+	return it->second.queued_bytes;
+}
+
+void BlockReplicationServer::on_block_unloaded(Vector3i bpos) {
+	// Blocks left in `_edited_blocks` are skipped when they are not found
+	_replicated_blocks.erase(bpos);
+	_serialization_requests.erase(bpos);
+
+	for (auto it = _peer_queues.begin(); it != _peer_queues.end(); ++it) {
+		PeerQueue &queue = it->second;
+		auto load_it = queue.loads.find(bpos);
+		if (load_it != queue.loads.end()) {
+			const QueuedBlock &qb = load_it->second;
+			queue.queued_bytes -= qb.get_data_size();
+			if (qb.state == STATE_SERIALIZING) {
+				--queue.serializing_count;
+			}
+			queue.loads.erase(load_it);
+		}
+	}
+}
+
+void BlockReplicationServer::clear() {
+	_replicated_blocks.clear();
+	_edited_blocks.clear();
+	_peer_queues.clear();
+	_peer_cached_hashes.clear();
+	_serialization_requests.clear();
+	_blocks_being_serialized.clear();
+}
+
+void BlockReplicationServer::remove_peer(int peer_id) {
+	_peer_queues.erase(peer_id);
+	_peer_cached_hashes.erase(peer_id);
+
+	for (auto it = _replicated_blocks.begin(); it != _replicated_blocks.end();) {
+		ReplicatedBlock &rb = it->second;
+		unordered_remove_if(rb.peers, [peer_id](const PeerVersion &pv) { return pv.peer_id == peer_id; });
+		if (rb.peers.size() == 0) {
+			// No peer has the block anymore. If it gets sent again, it will be with a new baseline.
+			it = _replicated_blocks.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void BlockReplicationServer::receive_cached_blocks_report(int peer_id, Span<const uint8_t> message_data) {
+	ZN_PROFILE_SCOPE();
+
+	MemoryReader mr(message_data, ENDIANNESS_LITTLE_ENDIAN);
+	ZN_ASSERT_RETURN(message_data.size() >= sizeof(uint32_t));
+
+	const unsigned int block_count = mr.get_32();
+	ZN_ASSERT_RETURN(block_count <= MAX_BLOCKS_PER_CLIENT_MESSAGE);
+	ZN_ASSERT_RETURN(message_data.size() >= sizeof(uint32_t) + block_count * CACHE_REPORT_ENTRY_SIZE);
+
+	// Blocks held until now get serialized the next time messages are popped, with the hashes they need
+	_peer_queues[peer_id].waiting_cache_report = false;
+
+	StdUnorderedMap<Vector3i, uint64_t> &hashes = _peer_cached_hashes[peer_id];
+	if (hashes.size() + block_count > MAX_CACHED_HASHES_PER_PEER) {
+		ZN_PRINT_VERBOSE(format("Too many cached blocks reported by peer {}, forgetting older reports", peer_id));
+		hashes.clear();
+	}
+
+	for (unsigned int i = 0; i < block_count; ++i) {
+		const Vector3i bpos = get_block_position(mr);
+		hashes[bpos] = mr.get_64();
+	}
+}
+
+bool BlockReplicationServer::read_blocks_request(
+		Span<const uint8_t> message_data,
+		StdVector<Vector3i> &out_positions
+) {
+	MemoryReader mr(message_data, ENDIANNESS_LITTLE_ENDIAN);
+	ZN_ASSERT_RETURN_V(message_data.size() >= sizeof(uint32_t), false);
+
+	const unsigned int block_count = mr.get_32();
+	ZN_ASSERT_RETURN_V(block_count <= MAX_BLOCKS_PER_CLIENT_MESSAGE, false);
+	ZN_ASSERT_RETURN_V(message_data.size() >= sizeof(uint32_t) + block_count * 3 * sizeof(int16_t), false);
+
+	for (unsigned int i = 0; i < block_count; ++i) {
+		out_positions.push_back(get_block_position(mr));
+	}
+	return true;
+}
+
+// Client
+
+void BlockReplicationClient::receive_blocks(Span<const uint8_t> message_data, VoxelData &data, ReceiveResult &result) {
+	ZN_PROFILE_SCOPE();
+
+	MemoryReader mr(message_data, ENDIANNESS_LITTLE_ENDIAN);
+	ZN_ASSERT_RETURN(message_data.size() >= sizeof(uint32_t));
+
+	const unsigned int block_count = mr.get_32();
+
+	for (unsigned int i = 0; i < block_count; ++i) {
+		ZN_ASSERT_RETURN(mr.pos + BLOCK_MESSAGE_HEADER_SIZE <= mr.data.size());
+
+		const Vector3i bpos = get_block_position(mr);
+		const uint8_t type = mr.get_8();
+		const uint32_t version = mr.get_32();
+		const unsigned int voxel_data_size = mr.get_16();
+
+		ZN_ASSERT_RETURN(mr.pos + voxel_data_size <= mr.data.size());
+		const Span<const uint8_t> voxel_data = mr.data.sub(mr.pos, voxel_data_size);
+		mr.pos += voxel_data_size;
+
+		switch (type) {
+			case BLOCK_MESSAGE_FULL: {
+				std::shared_ptr<VoxelBuffer> voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
+				ZN_ASSERT_CONTINUE(BlockSerializer::decompress_and_deserialize(voxel_data, *voxels));
+				result.blocks.push_back(ReceivedBlock{ bpos, voxels });
+				_versions[bpos] = version;
+				// The cached version is outdated
+				_cached_blocks.erase(bpos);
+			} break;
+
+			case BLOCK_MESSAGE_CACHED: {
+				auto it = _cached_blocks.find(bpos);
+				if (it == _cached_blocks.end()) {
+					// We reported it, but it was removed from the cache in the meantime
+					result.blocks_to_request.push_back(bpos);
+					continue;
+				}
+				result.blocks.push_back(ReceivedBlock{ bpos, it->second });
+				_cached_blocks.erase(it);
+				_versions[bpos] = version;
+			} break;
+
+			case BLOCK_MESSAGE_DELTA:
+				if (!apply_delta(data, bpos, version, voxel_data, result)) {
+					result.blocks_to_request.push_back(bpos);
+				}
+				break;
+
+			default:
+				ZN_PRINT_ERROR(format("Received block with unknown message type {}", type));
+				break;
+		}
+	}
+}
+
+bool BlockReplicationClient::apply_delta(
+		VoxelData &data,
+		Vector3i bpos,
+		uint32_t version,
+		Span<const uint8_t> voxel_data,
+		ReceiveResult &result
+) {
+	auto version_it = _versions.find(bpos);
+	if (version_it == _versions.end() || version_it->second + 1 != version) {
+		// We don't have the version the delta is based on
+		ZN_PRINT_VERBOSE(format("Received delta for block {} with unexpected version {}", bpos, version));
+		return false;
+	}
+
+	std::shared_ptr<VoxelBuffer> voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
+	ZN_ASSERT_RETURN_V(BlockSerializer::decompress_and_deserialize(voxel_data, *voxels), false);
+
+	// The previous version may have been received in the same message and not be applied yet
+	std::shared_ptr<VoxelBuffer> current_voxels;
+	for (auto it = result.blocks.rbegin(); it != result.blocks.rend(); ++it) {
+		if (it->position == bpos) {
+			current_voxels = it->voxels;
+			break;
+		}
+	}
+
+	{
+		SpatialLock3D::Read srlock(data.get_spatial_lock(0), BoxBounds3i::from_position(bpos));
+		if (current_voxels == nullptr) {
+			current_voxels = data.try_get_block_voxels(bpos);
+		}
+		if (current_voxels == nullptr || current_voxels->get_size() != voxels->get_size() ||
+			!have_same_channel_depths(*current_voxels, *voxels)) {
+			return false;
+		}
+		// Metadata is sent as-is in deltas
+		voxels->xor_channels_from(*current_voxels);
+	}
+	voxels->compress_uniform_channels();
+
+	result.blocks.push_back(ReceivedBlock{ bpos, voxels });
+	version_it->second = version;
+	return true;
+}
+
+void BlockReplicationClient::on_area_entered_view(Box3i blocks_box) {
+	blocks_box.for_each_cell_zxy([this](Vector3i bpos) { _blocks_to_look_up.push_back(bpos); });
+}
+
+void BlockReplicationClient::on_area_exited_view(Box3i blocks_box) {
+	unordered_remove_if(_blocks_to_look_up, [&blocks_box](Vector3i bpos) { return blocks_box.contains(bpos); });
+
+	blocks_box.for_each_cell_zxy([this](Vector3i bpos) {
+		_cached_blocks.erase(bpos);
+		_blocks_being_looked_up.erase(bpos);
+	});
+}
+
+bool BlockReplicationClient::take_cache_lookup_job(unsigned int block_size, CacheLookupJob &out_job) {
+	const unsigned int count = math::min<unsigned int>(_blocks_to_look_up.size(), MAX_CACHE_LOOKUPS_PER_JOB);
+	const unsigned int first = _blocks_to_look_up.size() - count;
+
+	out_job.positions.clear();
+	out_job.block_size = block_size;
+
+	for (unsigned int i = first; i < _blocks_to_look_up.size(); ++i) {
+		const Vector3i bpos = _blocks_to_look_up[i];
+		if (_versions.find(bpos) != _versions.end()) {
+			// Already received
+			continue;
+		}
+		out_job.positions.push_back(bpos);
+		_blocks_being_looked_up.insert(bpos);
+	}
+
+	_blocks_to_look_up.resize(first);
+
+	return out_job.positions.size() > 0;
+}
+
+void BlockReplicationClient::CacheLookupJob::run(VoxelStream &stream, CacheLookupResult &out_result) const {
+	ZN_PROFILE_SCOPE();
+
+	out_result.positions = positions;
+	out_result.blocks.clear();
+
+	StdVector<std::shared_ptr<VoxelBuffer>> buffers;
+	StdVector<VoxelStream::VoxelQueryData> queries;
+	buffers.reserve(positions.size());
+	queries.reserve(positions.size());
+
+	for (const Vector3i bpos : positions) {
+		std::shared_ptr<VoxelBuffer> voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
+		voxels->create(Vector3iUtil::create(block_size));
+		buffers.push_back(voxels);
+		queries.push_back(VoxelStream::VoxelQueryData{ *voxels, bpos, 0, VoxelStream::RESULT_ERROR });
+	}
+
+	if (queries.size() > 0) {
+		stream.load_voxel_blocks(to_span(queries));
+	}
+
+	for (unsigned int i = 0; i < queries.size(); ++i) {
+		const VoxelStream::VoxelQueryData &q = queries[i];
+		if (q.result != VoxelStream::RESULT_BLOCK_FOUND) {
+			continue;
+		}
+		std::shared_ptr<VoxelBuffer> &voxels = buffers[i];
+		const uint64_t hash = BlockSerializer::compute_hash(*voxels);
+		out_result.blocks.push_back(CachedBlock{ q.position_in_blocks, voxels, hash });
+	}
+}
+
+bool BlockReplicationClient::apply_cache_lookup_result(
+		const CacheLookupResult &result,
+		StdVector<uint8_t> &out_report
+) {
+	ZN_PROFILE_SCOPE();
+
+	// Reserve space for the block count
+	out_report.resize(sizeof(uint32_t) + result.blocks.size() * CACHE_REPORT_ENTRY_SIZE);
+	unsigned int found_count = 0;
+	{
+		ByteSpanWithPosition mw_span(to_span(out_report), sizeof(uint32_t));
+		MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
+
+		for (const CachedBlock &block : result.blocks) {
+			if (_blocks_being_looked_up.find(block.position) == _blocks_being_looked_up.end()) {
+				// Left the area in the meantime
+				continue;
+			}
+			if (_versions.find(block.position) != _versions.end()) {
+				// Received from the server in the meantime
+				continue;
+			}
+			_cached_blocks[block.position] = block.voxels;
+			store_block_position(mw, block.position);
+			mw.store_64(block.hash);
+			++found_count;
+		}
+	}
+
+	for (const Vector3i bpos : result.positions) {
+		_blocks_being_looked_up.erase(bpos);
+	}
+
+	if (found_count == 0 && _cache_report_sent) {
+		return false;
+	}
+
+	out_report.resize(sizeof(uint32_t) + found_count * CACHE_REPORT_ENTRY_SIZE);
+	ByteSpanWithPosition mw_span(to_span(out_report), 0);
+	MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
+	mw.store_32(found_count);
+
+	_cache_report_sent = true;
+	return true;
+}
+
+bool BlockReplicationClient::look_up_cache(
+		VoxelStream &stream,
+		unsigned int block_size,
+		StdVector<uint8_t> &out_report
+) {
+	CacheLookupJob job;
+	if (!take_cache_lookup_job(block_size, job)) {
+		return false;
+	}
+	CacheLookupResult result;
+	job.run(stream, result);
+	return apply_cache_lookup_result(result, out_report);
+}
+
+void BlockReplicationClient::on_block_unloaded(Vector3i bpos) {
+	_versions.erase(bpos);
+	_cached_blocks.erase(bpos);
+	_blocks_being_looked_up.erase(bpos);
+}
+
+void BlockReplicationClient::clear() {
+	_versions.clear();
+	_cached_blocks.clear();
+	_blocks_to_look_up.clear();
+	_blocks_being_looked_up.clear();
+	_cache_report_sent = false;
+}
+
+void BlockReplicationClient::write_blocks_request(Span<const Vector3i> positions, StdVector<uint8_t> &out_message) {
+	ZN_ASSERT_RETURN(positions.size() <= MAX_BLOCKS_PER_CLIENT_MESSAGE);
+
+	out_message.resize(sizeof(uint32_t) + positions.size() * 3 * sizeof(int16_t));
+
+	ByteSpanWithPosition mw_span(to_span(out_message), 0);
+	MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
+
+	mw.store_32(positions.size());
+	for (const Vector3i bpos : positions) {
+		store_block_position(mw, bpos);
+	}
+}
+
+} // namespace zylann::voxel
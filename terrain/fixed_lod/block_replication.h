@@ -0,0 +1,371 @@
+#ifndef VOXEL_BLOCK_REPLICATION_H
+#define VOXEL_BLOCK_REPLICATION_H
+
+#include "../../util/containers/span.h"
+#include "../../util/containers/std_unordered_map.h"
+#include "../../util/containers/std_unordered_set.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/math/box3i.h"
+#include "../../util/math/vector3f.h"
+#include <memory>
+
+namespace zylann::voxel {
+
+class VoxelBuffer;
+class VoxelData;
+class VoxelStream;
+
+// Network-independent parts of the replication of voxel blocks between a server and its clients. Messages are
+// produced and consumed as bytes, transport is left to the caller (see `VoxelTerrainMultiplayerSynchronizer`).
+// Messages must be delivered reliably and in order.
+
+// Server side
+class BlockReplicationServer {
+public:
+	// Serialized and compressed block contents, which can be shared between the queues of several peers
+	typedef std::shared_ptr<const StdVector<uint8_t>> Payload;
+
+	// Queues a block for a peer whose area it entered. If the peer reported having the same contents in its cache,
+	// only a confirmation is sent.
+	// The block is serialized later by a serialization job. If too much data is already queued for the peer, or if the
+	// peer is new and did not report its cache yet, serialization is postponed.
+	void send_block(int peer_id, Vector3i bpos);
+
+	// Marks a block as edited, so it gets sent again to peers having it after the next call to `send_edited_blocks`.
+	// Does nothing if the block was not sent to any peer.
+	void mark_block_edited(Vector3i bpos);
+
+	inline bool has_edited_blocks() const {
+		return _edited_blocks.size() > 0;
+	}
+
+	// Requests serialization of edited blocks, so they can be sent to peers viewing them, as differences with the
+	// version peers have if possible.
+	void send_edited_blocks();
+
+	void on_block_unloaded(Vector3i bpos);
+	void clear();
+
+	// Forgets everything about a peer. Must be called when it disconnects, otherwise its queue, reported hashes and
+	// versions of blocks it had stay in memory, and messages keep being produced for it.
+	void remove_peer(int peer_id);
+
+	// Reads a report of blocks a client has in its cache.
+	void receive_cached_blocks_report(int peer_id, Span<const uint8_t> message_data);
+
+	// Blocks entering the area of a new peer are held until it reports its cache, or until this amount of seconds
+	// passed, so they don't get sent in full before the server knows which ones the peer already has. 0 means blocks
+	// are not held.
+	void set_cache_report_timeout(float seconds);
+	inline float get_cache_report_timeout() const {
+		return _cache_report_timeout;
+	}
+
+	// Reads which blocks a client asked to receive in full.
+	static bool read_blocks_request(Span<const uint8_t> message_data, StdVector<Vector3i> &out_positions);
+
+	// Serialization. Blocks are serialized and compressed by jobs, which can run on other threads. A job is shared by
+	// all peers needing the same block, and there is at most one job in flight per block.
+
+	struct SerializationResult {
+		Vector3i position;
+		bool success = false;
+		// True if the job had a baseline
+		bool edited = false;
+		Payload data;
+		// Voxels XORed with the baseline, if it was smaller than `data`
+		Payload delta;
+		uint64_t hash = 0;
+	};
+
+	struct SerializationJob {
+		Vector3i position;
+		// Contents peers currently have, if the block was edited. The job also computes a delta against it.
+		Payload baseline;
+		bool compute_hash = false;
+
+		// Can be called from any thread. Locks the block in `data` while reading it.
+		void run(VoxelData &data, SerializationResult &out_result) const;
+	};
+
+	inline bool has_serialization_jobs() const {
+		return _serialization_requests.size() > 0;
+	}
+
+	// Gets jobs to run. Blocks already being serialized are left for later.
+	void take_serialization_jobs(StdVector<SerializationJob> &out_jobs);
+
+	// Queues the results of serialization jobs for peers.
+	// `get_viewer_peers(Vector3i bpos, StdVector<int> &out_peer_ids)` must return peers viewing a block.
+	template <typename F>
+	void apply_serialization_results(Span<const SerializationResult> results, F get_viewer_peers) {
+		StdVector<int> peer_ids;
+		for (const SerializationResult &result : results) {
+			peer_ids.clear();
+			if (result.edited) {
+				get_viewer_peers(result.position, peer_ids);
+			}
+			apply_serialization_result(result, to_span_const(peer_ids));
+		}
+	}
+
+	// Runs all pending serialization jobs on the calling thread.
+	template <typename F>
+	void serialize_blocks(VoxelData &data, F get_viewer_peers) {
+		StdVector<SerializationJob> jobs;
+		take_serialization_jobs(jobs);
+		StdVector<SerializationResult> results;
+		results.resize(jobs.size());
+		for (unsigned int i = 0; i < jobs.size(); ++i) {
+			jobs[i].run(data, results[i]);
+		}
+		apply_serialization_results(to_span_const(results), get_viewer_peers);
+	}
+
+	// Sending
+
+	// Position of the viewer of a peer, in blocks. Blocks closer to it are sent first.
+	// Only applies to peers that were sent blocks, so viewers of a removed peer don't bring back its queue.
+	void set_peer_position(int peer_id, Vector3f position_in_blocks);
+
+	// True if the peer has a send queue, which is created by the first block queued for it
+	inline bool has_peer(int peer_id) const {
+		return _peer_queues.find(peer_id) != _peer_queues.end();
+	}
+
+	// Maximum amount of bytes sent to each peer per second. 0 means no limit.
+	void set_bandwidth_limit(unsigned int bytes_per_second);
+	inline unsigned int get_bandwidth_limit() const {
+		return _bandwidth_limit;
+	}
+
+	// Blocks are packed into messages of up to this size when possible. A message only exceeds it if it contains a
+	// single block bigger than that. 0 means one message per peer per call to `pop_messages`.
+	void set_message_size_target(unsigned int bytes);
+	inline unsigned int get_message_size_target() const {
+		return _message_size_target;
+	}
+
+	// Blocks entering the area of a peer stop being serialized when more than this amount of bytes is waiting to be
+	// sent to it. 0 means no limit.
+	void set_max_queued_bytes(unsigned int bytes);
+	inline unsigned int get_max_queued_bytes() const {
+		return _max_queued_bytes;
+	}
+
+	size_t get_queued_bytes(int peer_id) const;
+
+	// Packs serialized blocks queued for each peer into messages, and removes them from the queues. Edits are sent
+	// first, then blocks closest to peers. Blocks are not sent past the bandwidth limit, they stay queued until budget
+	// is available again. Only peers that were not removed with `remove_peer` are scheduled.
+	// `f(int peer_id, Span<const uint8_t> message_data)`
+	template <typename F>
+	void pop_messages(float delta_time, F f) {
+		for (auto it = _peer_queues.begin(); it != _peer_queues.end(); ++it) {
+			const int peer_id = it->first;
+			PeerQueue &queue = it->second;
+			if (!prepare_sending(queue, delta_time)) {
+				continue;
+			}
+			while (pop_message(queue)) {
+				f(peer_id, to_span_const(_message));
+			}
+			request_deferred_blocks(peer_id, queue);
+		}
+	}
+
+private:
+	struct PeerQueue;
+	struct QueuedBlock;
+
+	void apply_serialization_result(const SerializationResult &result, Span<const int> edit_peer_ids);
+	void apply_edit(const SerializationResult &result, Span<const int> peer_ids);
+	void apply_load(int peer_id, QueuedBlock &qb, const SerializationResult &result);
+	bool prepare_sending(PeerQueue &queue, float delta_time);
+	bool pop_message(PeerQueue &queue);
+	void request_deferred_blocks(int peer_id, PeerQueue &queue);
+	void request_serialization(int peer_id, Vector3i bpos);
+
+	enum QueuedBlockState : uint8_t {
+		// Was queued while the queue was full or while waiting for the cache report of the peer, serialization was
+		// not requested yet
+		STATE_DEFERRED,
+		STATE_SERIALIZING,
+		STATE_READY
+	};
+
+	struct QueuedBlock {
+		Vector3i position;
+		uint8_t type = 0;
+		uint32_t version = 0;
+		Payload data;
+		QueuedBlockState state = STATE_DEFERRED;
+
+		inline size_t get_data_size() const {
+			return data != nullptr ? data->size() : 0;
+		}
+	};
+
+	struct PeerQueue {
+		// Edited blocks, in the order they must be received
+		StdVector<QueuedBlock> edits;
+		// Blocks that entered the area of the peer. There is at most one per position, and they can be sent in any
+		// order.
+		StdUnorderedMap<Vector3i, QueuedBlock> loads;
+		// Positions of `loads` sorted by distance, closest last, updated before sending
+		StdVector<Vector3i> sorted_loads;
+		// Positions of `sorted_loads` before this index were not sent yet
+		unsigned int next_sorted_load = 0;
+		// Size of serialized blocks in queues
+		size_t queued_bytes = 0;
+		// Number of loads waiting for serialization
+		unsigned int serializing_count = 0;
+		// Bytes that can be sent before reaching the bandwidth limit. Can go negative if a block was bigger.
+		double budget = 0.0;
+		Vector3f position_in_blocks;
+		// True until the peer reports its cache for the first time, or the timeout passes
+		bool waiting_cache_report = true;
+		float cache_report_wait_time = 0.f;
+	};
+
+	static const uint32_t INVALID_VERSION = 0xffffffff;
+
+	struct PeerVersion {
+		int peer_id;
+		// Version of the block the peer was last sent
+		uint32_t version;
+	};
+
+	// State of a block that was sent to at least one peer. Edits are sent as deltas against `baseline`, which peers
+	// having received `version` share. Messages are reliable and ordered, so being sent a version is enough to know
+	// that a peer will have it by the time it receives the next one.
+	struct ReplicatedBlock {
+		// Incremented every time edits of the block are replicated
+		uint32_t version = 0;
+		// Serialized and compressed contents of the block at `version`
+		Payload baseline;
+		StdVector<PeerVersion> peers;
+		bool edited = false;
+	};
+
+	struct SerializationRequest {
+		bool edited = false;
+		bool compute_hash = false;
+	};
+
+	StdUnorderedMap<Vector3i, ReplicatedBlock> _replicated_blocks;
+	// Edited blocks waiting to be sent, so that edits happening close together in time are sent in one go
+	StdVector<Vector3i> _edited_blocks;
+	StdUnorderedMap<int, PeerQueue> _peer_queues;
+	// Content hashes of blocks peers reported having in their cache, until the blocks enter their area
+	StdUnorderedMap<int, StdUnorderedMap<Vector3i, uint64_t>> _peer_cached_hashes;
+
+	StdUnorderedMap<Vector3i, SerializationRequest> _serialization_requests;
+	StdUnorderedSet<Vector3i> _blocks_being_serialized;
+
+	unsigned int _bandwidth_limit = 0;
+	unsigned int _message_size_target = 0;
+	unsigned int _max_queued_bytes = 4 * 1024 * 1024;
+	float _cache_report_timeout = 1.f;
+	// Used to estimate how much data blocks being serialized will take
+	size_t _average_payload_size = 0;
+
+	// Message being built in `pop_message`
+	StdVector<uint8_t> _message;
+};
+
+// Client side
+class BlockReplicationClient {
+public:
+	struct ReceivedBlock {
+		Vector3i position;
+		std::shared_ptr<VoxelBuffer> voxels;
+	};
+
+	struct ReceiveResult {
+		// Full contents of blocks, to apply in order. The same block can appear more than once.
+		StdVector<ReceivedBlock> blocks;
+		// Blocks that could not be updated, which should be requested in full to the server
+		StdVector<Vector3i> blocks_to_request;
+
+		void clear() {
+			blocks.clear();
+			blocks_to_request.clear();
+		}
+	};
+
+	// Decodes blocks sent by the server. `data` is used to get current voxels of blocks receiving deltas, it isn't
+	// modified.
+	void receive_blocks(Span<const uint8_t> message_data, VoxelData &data, ReceiveResult &result);
+
+	// Cache. Blocks entering the area of the client are looked up in a local stream, and reported to the server so
+	// it only sends them if they changed. The server waits for the first report before sending blocks, so it is sent
+	// even if nothing was found.
+
+	void on_area_entered_view(Box3i blocks_box);
+	void on_area_exited_view(Box3i blocks_box);
+
+	inline bool has_blocks_to_look_up() const {
+		return _blocks_to_look_up.size() > 0;
+	}
+
+	struct CachedBlock {
+		Vector3i position;
+		std::shared_ptr<VoxelBuffer> voxels;
+		uint64_t hash = 0;
+	};
+
+	struct CacheLookupResult {
+		// All positions that were looked up
+		StdVector<Vector3i> positions;
+		// Blocks found in the cache
+		StdVector<CachedBlock> blocks;
+	};
+
+	struct CacheLookupJob {
+		StdVector<Vector3i> positions;
+		unsigned int block_size = 0;
+
+		// Can be called from any thread. Loads blocks from the cache, so it is usually run on the IO thread.
+		void run(VoxelStream &stream, CacheLookupResult &out_result) const;
+	};
+
+	// Gets blocks that entered the area and were not received yet, to look up in the cache.
+	// Returns false if there is nothing to look up.
+	bool take_cache_lookup_job(unsigned int block_size, CacheLookupJob &out_job);
+
+	// Keeps found blocks that are still in the area until the server confirms them, and writes a report for the
+	// server. Returns false if there is nothing to report.
+	bool apply_cache_lookup_result(const CacheLookupResult &result, StdVector<uint8_t> &out_report);
+
+	// Runs a lookup job on the calling thread.
+	bool look_up_cache(VoxelStream &stream, unsigned int block_size, StdVector<uint8_t> &out_report);
+
+	void on_block_unloaded(Vector3i bpos);
+	void clear();
+
+	static void write_blocks_request(Span<const Vector3i> positions, StdVector<uint8_t> &out_message);
+
+private:
+	bool apply_delta(
+			VoxelData &data,
+			Vector3i bpos,
+			uint32_t version,
+			Span<const uint8_t> voxel_data,
+			ReceiveResult &result
+	);
+
+	// Versions of blocks received from the server
+	StdUnorderedMap<Vector3i, uint32_t> _versions;
+	// Blocks loaded from the cache, waiting for the server to confirm they are up to date
+	StdUnorderedMap<Vector3i, std::shared_ptr<VoxelBuffer>> _cached_blocks;
+	StdVector<Vector3i> _blocks_to_look_up;
+	// Blocks taken by lookup jobs that did not complete yet. Blocks leaving the area are removed, so results of the
+	// jobs are ignored for them.
+	StdUnorderedSet<Vector3i> _blocks_being_looked_up;
+	bool _cache_report_sent = false;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_BLOCK_REPLICATION_H
@@ -0,0 +1,26 @@
+#include "look_up_cached_blocks_task.h"
+#include "../../engine/streaming_dependency.h"
+#include "../../util/profiling.h"
+
+namespace zylann::voxel {
+
+void LookUpCachedBlocksTask::run(ThreadedTaskContext &ctx) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(stream_dependency != nullptr);
+	ZN_ASSERT_RETURN(output_queue != nullptr);
+
+	BlockReplicationClient::CacheLookupResult result;
+
+	Ref<VoxelStream> stream = stream_dependency->stream;
+	if (stream_dependency->valid && stream.is_valid()) {
+		job.run(**stream, result);
+	} else {
+		// The result has to be returned even if nothing was looked up, so the client stops waiting for it
+		result.positions = job.positions;
+	}
+
+	MutexLock mlock(output_queue->mutex);
+	output_queue->results.push_back(std::move(result));
+}
+
+} // namespace zylann::voxel
@@ -0,0 +1,35 @@
+#ifndef VOXEL_LOOK_UP_CACHED_BLOCKS_TASK_H
+#define VOXEL_LOOK_UP_CACHED_BLOCKS_TASK_H
+
+#include "../../util/containers/std_vector.h"
+#include "../../util/tasks/threaded_task.h"
+#include "../../util/thread/mutex.h"
+#include "block_replication.h"
+#include <memory>
+
+namespace zylann::voxel {
+
+struct StreamingDependency;
+
+struct CachedBlocksLookupOutputQueue {
+	StdVector<BlockReplicationClient::CacheLookupResult> results;
+	Mutex mutex;
+};
+
+// Loads blocks a client has in its cache, so the main thread only has to report them to the server
+class LookUpCachedBlocksTask : public IThreadedTask {
+public:
+	BlockReplicationClient::CacheLookupJob job;
+	std::shared_ptr<StreamingDependency> stream_dependency;
+	std::shared_ptr<CachedBlocksLookupOutputQueue> output_queue;
+
+	const char *get_debug_name() const override {
+		return "LookUpCachedBlocks";
+	}
+
+	void run(ThreadedTaskContext &ctx) override;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_LOOK_UP_CACHED_BLOCKS_TASK_H
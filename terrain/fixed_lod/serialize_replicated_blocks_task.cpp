@@ -0,0 +1,25 @@
+#include "serialize_replicated_blocks_task.h"
+#include "../../storage/voxel_data.h"
+#include "../../util/profiling.h"
+
+namespace zylann::voxel {
+
+void SerializeReplicatedBlocksTask::run(ThreadedTaskContext &ctx) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(data != nullptr);
+	ZN_ASSERT_RETURN(output_queue != nullptr);
+
+	StdVector<BlockReplicationServer::SerializationResult> results;
+	results.resize(jobs.size());
+	for (unsigned int i = 0; i < jobs.size(); ++i) {
+		jobs[i].run(*data, results[i]);
+	}
+
+	// Results have to be returned even if serialization failed, so the server stops waiting for them
+	MutexLock mlock(output_queue->mutex);
+	for (BlockReplicationServer::SerializationResult &result : results) {
+		output_queue->results.push_back(std::move(result));
+	}
+}
+
+} // namespace zylann::voxel
@@ -0,0 +1,33 @@
+#ifndef VOXEL_SERIALIZE_REPLICATED_BLOCKS_TASK_H
+#define VOXEL_SERIALIZE_REPLICATED_BLOCKS_TASK_H
+
+#include "../../util/containers/std_vector.h"
+#include "../../util/tasks/threaded_task.h"
+#include "../../util/thread/mutex.h"
+#include "block_replication.h"
+#include <memory>
+
+namespace zylann::voxel {
+
+struct ReplicatedBlocksSerializationOutputQueue {
+	StdVector<BlockReplicationServer::SerializationResult> results;
+	Mutex mutex;
+};
+
+// Serializes and compresses blocks to send to peers, so the main thread only has to pack them into messages
+class SerializeReplicatedBlocksTask : public IThreadedTask {
+public:
+	StdVector<BlockReplicationServer::SerializationJob> jobs;
+	std::shared_ptr<VoxelData> data;
+	std::shared_ptr<ReplicatedBlocksSerializationOutputQueue> output_queue;
+
+	const char *get_debug_name() const override {
+		return "SerializeReplicatedBlocks";
+	}
+
+	void run(ThreadedTaskContext &ctx) override;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_SERIALIZE_REPLICATED_BLOCKS_TASK_H
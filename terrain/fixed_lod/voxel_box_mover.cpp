@@ -4,6 +4,7 @@
 #include "../../storage/voxel_buffer.h"
 #include "../../storage/voxel_data.h"
 #include "../../util/containers/std_vector.h"
+#include "../../util/godot/core/packed_arrays.h"
 #include "../../util/profiling.h"
 #include "voxel_terrain.h"
 
@@ -186,68 +187,107 @@ bool intersects(Span<const AABB> aabbs, const AABB &box) {
 	return false;
 }
 
-void collect_boxes(VoxelTerrain &p_terrain, AABB query_box, uint32_t collision_nask, StdVector<AABB> &potential_boxes) {
+// Rebuilds the table if the library or the collision mask changed since it was built
+void update_blocky_collision_table(
+		BlockyCollisionTable &table,
+		const VoxelBlockyLibraryBase &library,
+		uint32_t collision_mask
+) {
+	RWLockRead rlock(library.get_baked_data_rw_lock());
+	const VoxelBlockyLibraryBase::BakedData &baked_data = library.get_baked_data();
+
+	if (table.library_id == library.get_instance_id() && table.bake_count == baked_data.bake_count &&
+		table.collision_mask == collision_mask) {
+		return;
+	}
+
 	ZN_PROFILE_SCOPE();
-	const VoxelData &voxels = p_terrain.get_storage();
+	table.offsets.clear();
+	table.boxes.clear();
+	table.offsets.reserve(baked_data.models.size() + 1);
+	for (const VoxelBlockyModel::BakedData &model : baked_data.models) {
+		table.offsets.push_back(table.boxes.size());
+		if ((model.box_collision_mask & collision_mask) != 0) {
+			for (const AABB &aabb : model.box_collision_aabbs) {
+				table.boxes.push_back(aabb);
+			}
+		}
+	}
+	table.offsets.push_back(table.boxes.size());
 
-	const int min_x = int(Math::floor(query_box.position.x));
-	const int min_y = int(Math::floor(query_box.position.y));
-	const int min_z = int(Math::floor(query_box.position.z));
+	table.library_id = library.get_instance_id();
+	table.bake_count = baked_data.bake_count;
+	table.collision_mask = collision_mask;
+}
 
+// What is needed to find collision boxes in a terrain, gathered once per call so it can be shared by many bodies
+struct CollisionContext {
+	const VoxelData *voxels = nullptr;
+	// Only one of these is set
+	const BlockyCollisionTable *blocky_table = nullptr;
+	bool cubes = false;
+};
+
+void collect_boxes(
+		const CollisionContext &ctx,
+		AABB query_box,
+		VoxelBuffer &voxels_buffer,
+		StdVector<AABB> &potential_boxes
+) {
+	ZN_PROFILE_SCOPE();
+
+	const Vector3i min_pos(
+			int(Math::floor(query_box.position.x)),
+			int(Math::floor(query_box.position.y)),
+			int(Math::floor(query_box.position.z))
+	);
 	const Vector3 query_box_end = query_box.position + query_box.size;
-	const int max_x = int(Math::ceil(query_box_end.x));
-	const int max_y = int(Math::ceil(query_box_end.y));
-	const int max_z = int(Math::ceil(query_box_end.z));
+	const Vector3i max_pos(
+			int(Math::ceil(query_box_end.x)), int(Math::ceil(query_box_end.y)), int(Math::ceil(query_box_end.z))
+	);
+	const Vector3i size = max_pos - min_pos;
 
-	Vector3i i(min_x, min_y, min_z);
+	if (Vector3iUtil::get_volume(size) == 0) {
+		return;
+	}
+	ZN_ASSERT_RETURN_MSG(
+			size.x <= VoxelBuffer::MAX_SIZE && size.y <= VoxelBuffer::MAX_SIZE && size.z <= VoxelBuffer::MAX_SIZE,
+			"Motion is too large"
+	);
+
+	const unsigned int channel = ctx.cubes ? VoxelBuffer::CHANNEL_COLOR : VoxelBuffer::CHANNEL_TYPE;
+
+	// Read the whole box at once, so the terrain is locked only once instead of for every voxel.
+	// Areas that aren't loaded are left empty, we don't know what they contain.
+	voxels_buffer.create(size);
+	ctx.voxels->copy_loaded(min_pos, voxels_buffer, 1 << channel);
+
+	if (voxels_buffer.is_uniform(channel)) {
+		const uint64_t v = voxels_buffer.get_voxel(Vector3i(), channel);
+		if (ctx.cubes ? v == 0 : ctx.blocky_table->get_model_boxes(v).size() == 0) {
+			// Common case of bodies moving in the air
+			return;
+		}
+	}
 
-	Ref<VoxelMesherBlocky> mesher_blocky;
-	Ref<VoxelMesherCubes> mesher_cubes;
+	Vector3i rpos;
+	for (rpos.z = 0; rpos.z < size.z; ++rpos.z) {
+		for (rpos.y = 0; rpos.y < size.y; ++rpos.y) {
+			for (rpos.x = 0; rpos.x < size.x; ++rpos.x) {
+				const uint64_t v = voxels_buffer.get_voxel(rpos, channel);
+				const Vector3i pos = min_pos + rpos;
 
-	if (zylann::godot::try_get_as(p_terrain.get_mesher(), mesher_blocky)) {
-		Ref<VoxelBlockyLibraryBase> library_ref = mesher_blocky->get_library();
-		ERR_FAIL_COND_MSG(library_ref.is_null(), "VoxelMesherBlocky has no library assigned");
-		const int channel = VoxelBuffer::CHANNEL_TYPE;
-		VoxelSingleValue defval;
-		defval.i = 0;
-
-		const VoxelBlockyLibraryBase::BakedData &baked_data = library_ref->get_baked_data();
-
-		// TODO Optimization: read the whole box of voxels at once, querying individually is slower
-		for (i.z = min_z; i.z < max_z; ++i.z) {
-			for (i.y = min_y; i.y < max_y; ++i.y) {
-				for (i.x = min_x; i.x < max_x; ++i.x) {
-					const int type_id = voxels.get_voxel(i, channel, defval).i;
-
-					if (baked_data.has_model(type_id)) {
-						const VoxelBlockyModel::BakedData &model = baked_data.models[type_id];
-
-						if ((model.box_collision_mask & collision_nask) == 0) {
-							continue;
-						}
-
-						for (const AABB &aabb : model.box_collision_aabbs) {
-							AABB world_box = aabb;
-							world_box.position += i;
-							potential_boxes.push_back(world_box);
-						}
+				if (ctx.cubes) {
+					if (v != 0) {
+						potential_boxes.push_back(AABB(pos, Vector3(1, 1, 1)));
 					}
-				}
-			}
-		}
 
-	} else if (zylann::godot::try_get_as(p_terrain.get_mesher(), mesher_cubes)) {
-		const int channel = VoxelBuffer::CHANNEL_COLOR;
-		VoxelSingleValue defval;
-		defval.i = 0;
-
-		// TODO Optimization: read the whole box of voxels at once, querying individually is slower
-		for (i.z = min_z; i.z < max_z; ++i.z) {
-			for (i.y = min_y; i.y < max_y; ++i.y) {
-				for (i.x = min_x; i.x < max_x; ++i.x) {
-					const int color_data = voxels.get_voxel(i, channel, defval).i;
-					if (color_data != 0) {
-						potential_boxes.push_back(AABB(i, Vector3(1, 1, 1)));
+				} else {
+					const Span<const AABB> model_boxes = ctx.blocky_table->get_model_boxes(v);
+					for (const AABB &aabb : model_boxes) {
+						AABB world_box = aabb;
+						world_box.position += pos;
+						potential_boxes.push_back(world_box);
 					}
 				}
 			}
@@ -255,38 +295,62 @@ void collect_boxes(VoxelTerrain &p_terrain, AABB query_box, uint32_t collision_n
 	}
 }
 
-} // namespace
+// Returns false if the terrain has no mesher we know how to collide with
+bool get_collision_context(
+		const VoxelData &voxels,
+		const Ref<VoxelMesher> &mesher,
+		uint32_t collision_mask,
+		BlockyCollisionTable &blocky_table,
+		CollisionContext &ctx
+) {
+	Ref<VoxelMesherBlocky> mesher_blocky;
+	Ref<VoxelMesherCubes> mesher_cubes;
 
-Vector3 VoxelBoxMover::get_motion(Vector3 p_pos, Vector3 p_motion, AABB p_aabb, VoxelTerrain &p_terrain) {
-	ZN_PROFILE_SCOPE();
-	// The mesher is required to know how collisions should be processed
-	ERR_FAIL_COND_V(p_terrain.get_mesher().is_null(), Vector3());
+	ctx.voxels = &voxels;
 
-	// Transform to local in case the volume is transformed
-	const Transform3D to_world = p_terrain.get_global_transform();
-	const Transform3D to_local = to_world.affine_inverse();
-	const Vector3 pos = to_local.xform(p_pos);
-	const Vector3 motion = to_local.basis.xform(p_motion);
-	const AABB aabb = Transform3D(to_local.basis, Vector3()).xform(p_aabb);
+	if (zylann::godot::try_get_as(mesher, mesher_blocky)) {
+		Ref<VoxelBlockyLibraryBase> library_ref = mesher_blocky->get_library();
+		ERR_FAIL_COND_V_MSG(library_ref.is_null(), false, "VoxelMesherBlocky has no library assigned");
+		// Flatten collision boxes, this is only done again when the library changes
+		update_blocky_collision_table(blocky_table, **library_ref, collision_mask);
+		ctx.blocky_table = &blocky_table;
+		return true;
+
+	} else if (zylann::godot::try_get_as(mesher, mesher_cubes)) {
+		ctx.cubes = true;
+		return true;
+	}
 
-	const AABB box(aabb.position + pos, aabb.size);
-	const AABB expanded_box = expand_with_vector(box, motion);
+	return false;
+}
 
+Vector3 get_terrain_motion(
+		const CollisionContext &ctx,
+		const AABB box,
+		const Vector3 motion,
+		bool step_climbing_enabled,
+		real_t max_step_height,
+		bool &out_stepped_up
+) {
 	static thread_local StdVector<AABB> s_colliding_boxes;
 	StdVector<AABB> &potential_boxes = s_colliding_boxes;
 	potential_boxes.clear();
 
+	VoxelBuffer voxels_buffer(VoxelBuffer::ALLOCATOR_POOL);
+
+	const AABB expanded_box = expand_with_vector(box, motion);
+
 	// Collect potential collisions with the terrain (broad phase)
 	// TODO If motion is really big, we may want something more optimal or reject it
-	collect_boxes(p_terrain, expanded_box, _collision_mask, potential_boxes);
+	collect_boxes(ctx, expanded_box, voxels_buffer, potential_boxes);
 
 	// Calculate collisions (narrow phase)
 	Vector3 slided_motion = zylann::voxel::get_motion(box, motion, to_span(potential_boxes));
 
 	// Minecraft-style stair climbing:
 	// If we were moving, changed horizontal direction due to collision, and resulting motion is about horizontal
-	_has_stepped_up = false;
-	if (_step_climbing_enabled &&
+	out_stepped_up = false;
+	if (step_climbing_enabled &&
 			// Movement is horizontal?
 			Math::abs(slided_motion.y) < 0.001 && Vector2(motion.x, motion.z).length_squared() > 0.0001 &&
 			// Motor movement isn't the same as resulting slided motion?
@@ -297,7 +361,7 @@ Vector3 VoxelBoxMover::get_motion(Vector3 p_pos, Vector3 p_motion, AABB p_aabb,
 		// Find out the height of the step
 		if (boxcast_down(to_span(potential_boxes), get_xz(expanded_box.position), get_xz(expanded_box.size), hit_y)) {
 			// If the step is up and not too high
-			if (hit_y > box.position.y && (hit_y - box.position.y) <= _max_step_height) {
+			if (hit_y > box.position.y && (hit_y - box.position.y) <= max_step_height) {
 				// Check if we would fit if we move the box above the step.
 				// Raise it slightly higher to avoid precision issues. Even if the final motion would move the box
 				// exactly on top of the stair, gameplay code could do some additional calculations with that motion
@@ -307,24 +371,122 @@ Vector3 VoxelBoxMover::get_motion(Vector3 p_pos, Vector3 p_motion, AABB p_aabb,
 						Vector3(box.position.x + motion.x, hit_y + epsilon, box.position.z + motion.z), box.size);
 
 				potential_boxes.clear();
-				collect_boxes(p_terrain, hyp_box, _collision_mask, potential_boxes);
+				collect_boxes(ctx, hyp_box, voxels_buffer, potential_boxes);
 
 				// If the box fits on top of the step
 				if (!intersects(to_span(potential_boxes), hyp_box)) {
 					// Change motion so that it brings the box on top of the step
 					slided_motion = hyp_box.position - box.position;
-					_has_stepped_up = true;
+					out_stepped_up = true;
 				}
 			}
 		}
 	}
 
+	return slided_motion;
+}
+
+} // namespace
+
+Vector3 VoxelBoxMover::get_motion(Vector3 p_pos, Vector3 p_motion, AABB p_aabb, VoxelTerrain &p_terrain) {
+	ZN_PROFILE_SCOPE();
+	// The mesher is required to know how collisions should be processed
+	ERR_FAIL_COND_V(p_terrain.get_mesher().is_null(), Vector3());
+
+	CollisionContext ctx;
+	const bool can_collide = get_collision_context(
+			p_terrain.get_storage(), p_terrain.get_mesher(), _collision_mask, _blocky_collision_table, ctx
+	);
+	if (!can_collide) {
+		_has_stepped_up = false;
+		return p_motion;
+	}
+
+	// Transform to local in case the volume is transformed
+	const Transform3D to_world = p_terrain.get_global_transform();
+	const Transform3D to_local = to_world.affine_inverse();
+	const Vector3 pos = to_local.xform(p_pos);
+	const Vector3 motion = to_local.basis.xform(p_motion);
+	const AABB aabb = Transform3D(to_local.basis, Vector3()).xform(p_aabb);
+
+	const AABB box(aabb.position + pos, aabb.size);
+
+	const Vector3 slided_motion =
+			get_terrain_motion(ctx, box, motion, _step_climbing_enabled, _max_step_height, _has_stepped_up);
+
 	// Switch back to world
 	const Vector3 world_slided_motion = to_world.basis.xform(slided_motion);
 
 	return world_slided_motion;
 }
 
+void VoxelBoxMover::get_motions(
+		Span<const Vector3> p_positions,
+		Span<const Vector3> p_motions,
+		AABB p_aabb,
+		VoxelTerrain &p_terrain,
+		Span<Vector3> out_motions
+) {
+	get_motions(
+			p_positions,
+			p_motions,
+			p_aabb,
+			p_terrain.get_storage(),
+			p_terrain.get_mesher(),
+			p_terrain.get_global_transform(),
+			out_motions
+	);
+}
+
+void VoxelBoxMover::get_motions(
+		Span<const Vector3> p_positions,
+		Span<const Vector3> p_motions,
+		AABB p_aabb,
+		const VoxelData &p_voxels,
+		const Ref<VoxelMesher> &p_mesher,
+		const Transform3D &p_terrain_transform,
+		Span<Vector3> out_motions
+) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(p_positions.size() == p_motions.size());
+	ZN_ASSERT_RETURN(out_motions.size() == p_motions.size());
+
+	_bodies_stepped_up.clear();
+	_bodies_stepped_up.resize(p_motions.size(), 0);
+
+	ERR_FAIL_COND(p_mesher.is_null());
+
+	CollisionContext ctx;
+	if (!get_collision_context(p_voxels, p_mesher, _collision_mask, _blocky_collision_table, ctx)) {
+		for (unsigned int i = 0; i < p_motions.size(); ++i) {
+			out_motions[i] = p_motions[i];
+		}
+		return;
+	}
+
+	const Transform3D &to_world = p_terrain_transform;
+	const Transform3D to_local = to_world.affine_inverse();
+	const AABB aabb = Transform3D(to_local.basis, Vector3()).xform(p_aabb);
+
+	for (unsigned int i = 0; i < p_motions.size(); ++i) {
+		const Vector3 pos = to_local.xform(p_positions[i]);
+		const Vector3 motion = to_local.basis.xform(p_motions[i]);
+		const AABB box(aabb.position + pos, aabb.size);
+
+		bool stepped_up;
+		const Vector3 slided_motion =
+				get_terrain_motion(ctx, box, motion, _step_climbing_enabled, _max_step_height, stepped_up);
+
+		out_motions[i] = to_world.basis.xform(slided_motion);
+		_bodies_stepped_up[i] = stepped_up;
+	}
+}
+
+bool VoxelBoxMover::has_body_stepped_up(int body_index) const {
+	ZN_ASSERT_RETURN_V(body_index >= 0 && body_index < static_cast<int>(_bodies_stepped_up.size()), false);
+	return _bodies_stepped_up[body_index] != 0;
+}
+
 void VoxelBoxMover::set_collision_mask(uint32_t mask) {
 	_collision_mask = mask;
 }
@@ -361,8 +523,39 @@ Vector3 VoxelBoxMover::_b_get_motion(Vector3 pos, Vector3 motion, AABB aabb, Obj
 	return get_motion(pos, motion, aabb, *terrain);
 }
 
+#if defined(ZN_GODOT)
+PackedVector3Array VoxelBoxMover::_b_get_motions(
+		PackedVector3Array positions,
+		PackedVector3Array motions,
+		AABB aabb,
+		Node *terrain_node
+) {
+#elif defined(ZN_GODOT_EXTENSION)
+PackedVector3Array VoxelBoxMover::_b_get_motions(
+		PackedVector3Array positions,
+		PackedVector3Array motions,
+		AABB aabb,
+		Object *terrain_node_o
+) {
+	Node *terrain_node = Object::cast_to<Node>(terrain_node_o);
+#endif
+	ERR_FAIL_COND_V(terrain_node == nullptr, PackedVector3Array());
+	VoxelTerrain *terrain = Object::cast_to<VoxelTerrain>(terrain_node);
+	ERR_FAIL_COND_V(terrain == nullptr, PackedVector3Array());
+	ERR_FAIL_COND_V(positions.size() != motions.size(), PackedVector3Array());
+	StdVector<Vector3> out_motions;
+	out_motions.resize(motions.size());
+	get_motions(to_span(positions), to_span(motions), aabb, *terrain, to_span(out_motions));
+	PackedVector3Array out_motions_array;
+	godot::copy_to(out_motions_array, out_motions);
+	return out_motions_array;
+}
+
 void VoxelBoxMover::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_motion", "pos", "motion", "aabb", "terrain"), &VoxelBoxMover::_b_get_motion);
+	ClassDB::bind_method(
+			D_METHOD("get_motions", "positions", "motions", "aabb", "terrain"), &VoxelBoxMover::_b_get_motions
+	);
 
 	ClassDB::bind_method(D_METHOD("set_collision_mask", "mask"), &VoxelBoxMover::set_collision_mask);
 	ClassDB::bind_method(D_METHOD("get_collision_mask"), &VoxelBoxMover::get_collision_mask);
@@ -374,6 +567,7 @@ void VoxelBoxMover::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_max_step_height"), &VoxelBoxMover::get_max_step_height);
 
 	ClassDB::bind_method(D_METHOD("has_stepped_up"), &VoxelBoxMover::has_stepped_up);
+	ClassDB::bind_method(D_METHOD("has_body_stepped_up", "body_index"), &VoxelBoxMover::has_body_stepped_up);
 }
 
 } // namespace zylann::voxel
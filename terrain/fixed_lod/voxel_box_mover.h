@@ -1,6 +1,8 @@
 #ifndef VOXEL_BOX_MOVER_H
 #define VOXEL_BOX_MOVER_H
 
+#include "../../util/containers/span.h"
+#include "../../util/containers/std_vector.h"
 #include "../../util/godot/classes/ref_counted.h"
 #include "../../util/godot/macros.h"
 
@@ -9,6 +11,28 @@ ZN_GODOT_FORWARD_DECLARE(class Node);
 namespace zylann::voxel {
 
 class VoxelTerrain;
+class VoxelData;
+class VoxelMesher;
+
+// Collision boxes of every blocky model matching a collision mask, laid out contiguously so they can be looked up
+// quickly when moving bodies
+struct BlockyCollisionTable {
+	// Boxes of model `i` are in the range [offsets[i], offsets[i + 1])
+	StdVector<uint32_t> offsets;
+	StdVector<AABB> boxes;
+
+	// What the table was built from, to tell when it needs to be rebuilt
+	ObjectID library_id;
+	uint32_t bake_count = 0;
+	uint32_t collision_mask = 0;
+
+	inline Span<const AABB> get_model_boxes(uint32_t type_id) const {
+		if (type_id + 1 >= offsets.size()) {
+			return Span<const AABB>();
+		}
+		return to_span(boxes).sub(offsets[type_id], offsets[type_id + 1] - offsets[type_id]);
+	}
+};
 
 // Helper to get simple AABB physics
 class VoxelBoxMover : public RefCounted {
@@ -16,6 +40,27 @@ class VoxelBoxMover : public RefCounted {
 public:
 	Vector3 get_motion(Vector3 pos, Vector3 motion, AABB aabb, VoxelTerrain &terrain);
 
+	// Moves many bodies sharing the same box and settings at once. Cheaper than calling `get_motion` for each of them.
+	void get_motions(
+			Span<const Vector3> positions,
+			Span<const Vector3> motions,
+			AABB aabb,
+			VoxelTerrain &terrain,
+			Span<Vector3> out_motions
+	);
+
+	// Same as above, with the parts of the terrain given separately. `terrain_transform` is the global transform of
+	// the terrain. Only voxels of loaded blocks are collided with, other areas are treated as empty.
+	void get_motions(
+			Span<const Vector3> positions,
+			Span<const Vector3> motions,
+			AABB aabb,
+			const VoxelData &voxels,
+			const Ref<VoxelMesher> &mesher,
+			const Transform3D &terrain_transform,
+			Span<Vector3> out_motions
+	);
+
 	void set_collision_mask(uint32_t mask);
 	inline uint32_t get_collision_mask() const {
 		return _collision_mask;
@@ -28,13 +73,27 @@ public:
 	float get_max_step_height() const;
 
 	bool has_stepped_up() const;
+	// Same as `has_stepped_up`, for a body of the last call to `get_motions`
+	bool has_body_stepped_up(int body_index) const;
 
 private:
 #if defined(ZN_GODOT)
 	Vector3 _b_get_motion(Vector3 p_pos, Vector3 p_motion, AABB p_aabb, Node *p_terrain_node);
+	PackedVector3Array _b_get_motions(
+			PackedVector3Array p_positions,
+			PackedVector3Array p_motions,
+			AABB p_aabb,
+			Node *p_terrain_node
+	);
 #elif defined(ZN_GODOT_EXTENSION)
 	// TODO GDX: it seems binding a method taking a `Node*` fails to compile. It is supposed to be working.
 	Vector3 _b_get_motion(Vector3 p_pos, Vector3 p_motion, AABB p_aabb, Object *p_terrain_node_o);
+	PackedVector3Array _b_get_motions(
+			PackedVector3Array p_positions,
+			PackedVector3Array p_motions,
+			AABB p_aabb,
+			Object *p_terrain_node_o
+	);
 #endif
 
 	static void _bind_methods();
@@ -46,6 +105,9 @@ private:
 
 	// States
 	bool _has_stepped_up = false;
+	StdVector<uint8_t> _bodies_stepped_up;
+	// Reused between calls while the library doesn't change
+	BlockyCollisionTable _blocky_collision_table;
 };
 
 } // namespace zylann::voxel
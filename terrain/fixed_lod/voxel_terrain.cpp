@@ -13,6 +13,7 @@
 #include "../../streams/load_block_data_task.h"
 #include "../../streams/save_block_data_task.h"
 #include "../../util/containers/container_funcs.h"
+#include "../../util/containers/dynamic_bitset.h"
 #include "../../util/godot/classes/base_material_3d.h" // For property hint in release mode in GDExtension...
 #include "../../util/godot/classes/concave_polygon_shape_3d.h"
 #include "../../util/godot/classes/engine.h"
@@ -649,6 +650,39 @@ void VoxelTerrain::remesh_all_blocks() {
 	});
 }
 
+void VoxelTerrain::remesh_blocks_with_models(Span<const uint16_t> model_ids) {
+	ZN_PROFILE_SCOPE();
+
+	if (model_ids.size() == 0) {
+		return;
+	}
+
+	DynamicBitset model_ids_bitset;
+	model_ids_bitset.resize_no_init(VoxelBlockyLibraryBase::MAX_MODELS);
+	model_ids_bitset.fill(false);
+	for (const uint16_t id : model_ids) {
+		model_ids_bitset.set(id);
+	}
+
+	// Find which blocks contain these models first, because scheduling mesh updates can't be done while the data map
+	// is locked
+	StdVector<Vector3i> data_block_positions;
+	_data->for_each_block_at_lod_r(
+			[&data_block_positions, &model_ids_bitset](const Vector3i bpos, const VoxelDataBlock &block) {
+				if (!block.has_voxels() ||
+					has_any_value_in_bitarray(block.get_voxels_const(), VoxelBuffer::CHANNEL_TYPE, model_ids_bitset)) {
+					data_block_positions.push_back(bpos);
+				}
+			},
+			0
+	);
+
+	const int data_block_size = get_data_block_size();
+	for (const Vector3i bpos : data_block_positions) {
+		try_schedule_mesh_update_from_data(Box3i(bpos * data_block_size, Vector3iUtil::create(data_block_size)));
+	}
+}
+
 // At the moment, this function is for client-side use case in multiplayer scenarios
 void VoxelTerrain::generate_block_async(Vector3i block_position) {
 	if (_data->has_block(block_position, 0)) {
@@ -726,6 +760,8 @@ void VoxelTerrain::reset_map() {
 		emit_data_block_unloaded(bpos);
 	});
 	_data->reset_maps();
+	// Searches running on other threads may have read blocks after they were notified individually
+	notify_area_edit_listeners(_data->get_bounds());
 
 	clear_mesh_map();
 
@@ -789,6 +825,26 @@ void VoxelTerrain::post_edit_area(Box3i box_in_voxels, bool update_mesh) {
 			_instancer->on_area_edited(box_in_voxels);
 		}
 	}
+
+	notify_area_edit_listeners(box_in_voxels);
+}
+
+void VoxelTerrain::notify_area_edit_listeners(Box3i box_in_voxels) {
+	for (unsigned int i = 0; i < _area_edit_listeners.size();) {
+		std::shared_ptr<IAreaEditListener> listener = _area_edit_listeners[i].lock();
+		if (listener == nullptr) {
+			// Was destroyed
+			_area_edit_listeners[i] = _area_edit_listeners.back();
+			_area_edit_listeners.pop_back();
+			continue;
+		}
+		listener->on_area_edited(box_in_voxels);
+		++i;
+	}
+}
+
+void VoxelTerrain::add_area_edit_listener(std::weak_ptr<IAreaEditListener> listener) {
+	_area_edit_listeners.push_back(listener);
 }
 
 void VoxelTerrain::_notification(int p_what) {
@@ -1078,6 +1134,11 @@ void VoxelTerrain::emit_data_block_loaded(Vector3i bpos) {
 }
 
 void VoxelTerrain::emit_data_block_unloaded(Vector3i bpos) {
+	if (_multiplayer_synchronizer != nullptr) {
+		_multiplayer_synchronizer->on_data_block_unloaded(bpos);
+	}
+	// Voxels of unloaded blocks may no longer be what they were when loaded
+	notify_area_edit_listeners(Box3i(_data->block_to_voxel(bpos), Vector3iUtil::create(get_data_block_size())));
 	emit_signal(VoxelStringNames::get_singleton().block_unloaded, bpos);
 }
 
@@ -1131,7 +1192,7 @@ void VoxelTerrain::notify_data_block_enter(const VoxelDataBlock &block, Vector3i
 
 	if (_multiplayer_synchronizer != nullptr && !Engine::get_singleton()->is_editor_hint() &&
 		network_peer_id != MultiplayerPeer::TARGET_PEER_SERVER && _multiplayer_synchronizer->is_server()) {
-		_multiplayer_synchronizer->send_block(network_peer_id, block, bpos);
+		_multiplayer_synchronizer->send_block(network_peer_id, bpos);
 	}
 }
 
@@ -1572,6 +1633,10 @@ void VoxelTerrain::process_viewer_data_box_change(
 
 		// TODO viewers with varying flags during the game is not supported at the moment.
 		// They have to be re-created, which may cause world re-load...
+
+	} else if (_multiplayer_synchronizer != nullptr && !_multiplayer_synchronizer->is_server()) {
+		// Blocks come from the server, but we may have them cached already
+		_multiplayer_synchronizer->on_viewer_data_box_changed(prev_data_box, new_data_box);
 	}
 }
 
@@ -1684,12 +1749,16 @@ void VoxelTerrain::apply_data_block_response(VoxelEngine::BlockDataOutput &ob) {
 		notify_data_block_enter(block, block_pos, viewer_id);
 	}
 
+	const Box3i block_box(_data->block_to_voxel(block_pos), Vector3iUtil::create(get_data_block_size()));
+
 	// The block itself might not be suitable for meshing yet, but blocks surrounding it might be now
 	// TODO Optimize: initial loading can hang for a while here.
 	// Because lots of blocks are loaded at once, which leads to many block queries.
-	try_schedule_mesh_update_from_data(
-			Box3i(_data->block_to_voxel(block_pos), Vector3iUtil::create(get_data_block_size()))
-	);
+	try_schedule_mesh_update_from_data(block_box);
+
+	// Voxels read in that area may have been different before the block was loaded (for example if it was edited
+	// in a previous session)
+	notify_area_edit_listeners(block_box);
 
 	// We might have requested some blocks again (if we got a dropped one while we still need them)
 	// if (stream_enabled) {
@@ -1740,18 +1809,24 @@ bool VoxelTerrain::try_set_block_data(Vector3i position, std::shared_ptr<VoxelBu
 	VoxelDataBlock block(voxel_data, 0);
 	// TODO How to set the `edited` flag? Does it matter in use cases for this function?
 	block.set_edited(true);
+	// The block didn't come from our stream, so it gets saved to it when unloaded. On multiplayer clients, this is
+	// what fills the cache of blocks received from the server.
+	block.set_modified(true);
 	block.viewers = refcount;
 
 	// Create or update block data
 	_data->try_set_block(position, block, [](VoxelDataBlock &existing_block, const VoxelDataBlock &incoming_block) {
 		existing_block.set_voxels(incoming_block.get_voxels_shared());
 		existing_block.set_edited(incoming_block.is_edited());
+		existing_block.set_modified(true);
 	});
 
+	const Box3i block_box(_data->block_to_voxel(position), Vector3iUtil::create(get_data_block_size()));
+
 	// The block itself might not be suitable for meshing yet, but blocks surrounding it might be now
-	try_schedule_mesh_update_from_data(
-			Box3i(_data->block_to_voxel(position), Vector3iUtil::create(get_data_block_size()))
-	);
+	try_schedule_mesh_update_from_data(block_box);
+
+	notify_area_edit_listeners(block_box);
 
 	return true;
 }
@@ -2252,6 +2327,17 @@ bool VoxelTerrain::_b_is_area_meshed(AABB aabb) const {
 	return is_area_meshed(Box3i(aabb.position, aabb.size));
 }
 
+void VoxelTerrain::_b_remesh_blocks_with_models(PackedInt32Array model_ids) {
+	StdVector<uint16_t> ids;
+	ids.reserve(model_ids.size());
+	for (int i = 0; i < model_ids.size(); ++i) {
+		const int id = model_ids[i];
+		ZN_ASSERT_CONTINUE(id >= 0 && id < static_cast<int>(VoxelBlockyLibraryBase::MAX_MODELS));
+		ids.push_back(id);
+	}
+	remesh_blocks_with_models(to_span(ids));
+}
+
 void VoxelTerrain::_bind_methods() {
 	using Self = VoxelTerrain;
 
@@ -2319,6 +2405,7 @@ void VoxelTerrain::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("has_data_block", "block_position"), &Self::has_data_block);
 	ClassDB::bind_method(D_METHOD("is_area_meshed", "area_in_voxels"), &Self::_b_is_area_meshed);
+	ClassDB::bind_method(D_METHOD("remesh_blocks_with_models", "model_ids"), &Self::_b_remesh_blocks_with_models);
 
 	ClassDB::bind_method(D_METHOD("debug_set_draw_enabled", "enabled"), &Self::debug_set_draw_enabled);
 	ClassDB::bind_method(D_METHOD("debug_is_draw_enabled"), &Self::debug_is_draw_enabled);
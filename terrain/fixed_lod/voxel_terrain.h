@@ -9,6 +9,7 @@
 #include "../../util/godot/core/gdvirtual.h"
 #include "../../util/godot/memory.h"
 #include "../../util/math/box3i.h"
+#include "../area_edit_listener.h"
 #include "../voxel_data_block_enter_info.h"
 #include "../voxel_mesh_map.h"
 #include "../voxel_node.h"
@@ -66,6 +67,10 @@ public:
 	void post_edit_voxel(Vector3i pos);
 	void post_edit_area(Box3i box_in_voxels, bool update_mesh);
 
+	// Registers an object to notify when voxels change, either from `post_edit_area` or when data blocks are loaded,
+	// set or unloaded. It is referenced weakly, so it doesn't need to be removed when it gets destroyed.
+	void add_area_edit_listener(std::weak_ptr<IAreaEditListener> listener);
+
 	void set_generate_collisions(bool enabled);
 	bool get_generate_collisions() const {
 		return _generate_collisions;
@@ -112,6 +117,7 @@ public:
 	// Creates or overrides whatever block data there is at the given position.
 	// The use case is multiplayer, client-side.
 	// If no local viewer is actually in range, the data will not be applied and the function returns `false`.
+	// The block is marked as modified, so it gets saved if the terrain has a stream.
 	bool try_set_block_data(Vector3i position, std::shared_ptr<VoxelBuffer> &voxel_data);
 
 	bool has_data_block(Vector3i position) const;
@@ -124,6 +130,10 @@ public:
 
 	void restart_stream() override;
 	void remesh_all_blocks() override;
+	// Only remeshes blocks containing at least one of the given voxel types, and their neighbors. Useful after only a
+	// few models of a blocky library were re-baked. Data blocks without voxels are remeshed too since their contents
+	// are unknown.
+	void remesh_blocks_with_models(Span<const uint16_t> model_ids);
 
 	// Asks to generate (or re-generate) a block at the given position asynchronously.
 	// If the block already exists once the block is generated, it will be cancelled.
@@ -239,6 +249,7 @@ private:
 
 	void emit_data_block_loaded(Vector3i bpos);
 	void emit_data_block_unloaded(Vector3i bpos);
+	void notify_area_edit_listeners(Box3i box_in_voxels);
 
 	void emit_mesh_block_entered(Vector3i bpos);
 	void emit_mesh_block_exited(Vector3i bpos);
@@ -277,6 +288,7 @@ private:
 	void _b_rpc_receive_block(PackedByteArray data);
 	void _b_rpc_receive_area(PackedByteArray data);
 	bool _b_is_area_meshed(AABB aabb) const;
+	void _b_remesh_blocks_with_models(PackedInt32Array model_ids);
 
 	VolumeID _volume_id;
 
@@ -364,6 +376,7 @@ private:
 	// References to external nodes.
 	VoxelInstancer *_instancer = nullptr;
 	VoxelTerrainMultiplayerSynchronizer *_multiplayer_synchronizer = nullptr;
+	StdVector<std::weak_ptr<IAreaEditListener>> _area_edit_listeners;
 
 	Stats _stats;
 
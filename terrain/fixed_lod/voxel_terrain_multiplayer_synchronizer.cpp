@@ -1,23 +1,44 @@
 #include "voxel_terrain_multiplayer_synchronizer.h"
 #include "../../constants/voxel_string_names.h"
+#include "../../engine/buffered_task_scheduler.h"
+#include "../../engine/streaming_dependency.h"
+#include "../../engine/voxel_engine.h"
 #include "../../storage/voxel_buffer.h"
-#include "../../streams/voxel_block_serializer.h"
+#include "../../storage/voxel_data.h"
+#include "../../streams/voxel_stream.h"
 #include "../../util/containers/container_funcs.h"
 #include "../../util/godot/classes/multiplayer_api.h"
 #include "../../util/godot/classes/multiplayer_peer.h"
 #include "../../util/godot/classes/scene_tree.h"
+#include "../../util/godot/classes/time.h"
 #include "../../util/godot/core/array.h"
-#include "../../util/io/serialization.h"
+#include "../../util/godot/core/packed_arrays.h"
+#include "../../util/math/conv.h"
+#include "../../util/memory/memory.h"
 #include "../../util/profiling.h"
 #include "../../util/string/format.h"
+#include "look_up_cached_blocks_task.h"
+#include "serialize_replicated_blocks_task.h"
 #include "voxel_terrain.h"
 
-#ifdef TOOLS_ENABLED
-#include "../../util/godot/core/packed_arrays.h"
-#endif
-
 namespace zylann::voxel {
 
+namespace {
+
+PackedByteArray to_packed_byte_array(Span<const uint8_t> data) {
+	PackedByteArray pba;
+	godot::copy_to(pba, data);
+	return pba;
+}
+
+// Same limit as the server, requests are split if larger
+const unsigned int MAX_REQUESTED_BLOCKS = 4096;
+
+// Blocks serialized by each task. Serializing one block is fast, so a few are grouped to reduce task overhead.
+const unsigned int SERIALIZATION_JOBS_PER_TASK = 8;
+
+} // namespace
+
 VoxelTerrainMultiplayerSynchronizer::VoxelTerrainMultiplayerSynchronizer() {
 	Dictionary config;
 	config["rpc_mode"] = MultiplayerAPI::RPC_MODE_AUTHORITY;
@@ -26,7 +47,14 @@ VoxelTerrainMultiplayerSynchronizer::VoxelTerrainMultiplayerSynchronizer() {
 	config["channel"] = _rpc_channel;
 
 	rpc_config(VoxelStringNames::get_singleton()._rpc_receive_blocks, config);
-	rpc_config(VoxelStringNames::get_singleton()._rpc_receive_area, config);
+
+	// Sent by clients
+	config["rpc_mode"] = MultiplayerAPI::RPC_MODE_ANY_PEER;
+	rpc_config(VoxelStringNames::get_singleton()._rpc_request_blocks, config);
+	rpc_config(VoxelStringNames::get_singleton()._rpc_report_cached_blocks, config);
+
+	_serialization_results = make_shared_instance<ReplicatedBlocksSerializationOutputQueue>();
+	_cache_lookup_results = make_shared_instance<CachedBlocksLookupOutputQueue>();
 
 	set_process(true);
 }
@@ -44,76 +72,138 @@ bool VoxelTerrainMultiplayerSynchronizer::is_server() const {
 	return mp->is_server();
 }
 
-void VoxelTerrainMultiplayerSynchronizer::send_block(
-		int viewer_peer_id,
-		const VoxelDataBlock &data_block,
-		Vector3i bpos
-) {
+void VoxelTerrainMultiplayerSynchronizer::send_block(int viewer_peer_id, Vector3i bpos) {
 	ZN_PROFILE_SCOPE();
+	// print_line(String("Server: send block {0}").format(varray(bpos)));
+	_server.send_block(viewer_peer_id, bpos);
+}
 
-	BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(data_block.get_voxels_const());
-	ZN_ASSERT_RETURN(result.success);
+// TODO Have a way to implement ghost edits?
+// The client would have to apply the edit locally, while having a way to revert it if the server isn't acknowledging
+// it for some time.
 
-	PackedByteArray message_data;
-	message_data.resize(4 * sizeof(int16_t) + result.data.size());
+void VoxelTerrainMultiplayerSynchronizer::send_area(Box3i voxel_box) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(_terrain != nullptr);
 
-	ByteSpanWithPosition mw_span(Span<uint8_t>(message_data.ptrw(), message_data.size()), 0);
-	MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
+	// Edited blocks are only marked here. They are sent later, so that many small edits in the same blocks only cost
+	// one message per block.
+	const Box3i blocks_box = voxel_box.downscaled(_terrain->get_data_block_size());
+	blocks_box.for_each_cell_zxy([this](Vector3i bpos) { _server.mark_block_edited(bpos); });
+}
 
-	mw.store_16(bpos.x);
-	mw.store_16(bpos.y);
-	mw.store_16(bpos.z);
-	ZN_ASSERT_RETURN(result.data.size() <= 65535);
-	mw.store_16(result.data.size());
-	mw.store_buffer(to_span(result.data));
+void VoxelTerrainMultiplayerSynchronizer::process_edits() {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(_terrain != nullptr);
 
-	// print_line(String("Server: send block {0}").format(varray(bpos)));
+	if (_edit_batch_interval_msec > 0) {
+		const uint64_t now = Time::get_singleton()->get_ticks_msec();
+		if (now < _next_edit_flush_time_msec) {
+			return;
+		}
+		_next_edit_flush_time_msec = now + _edit_batch_interval_msec;
+	}
 
-	// rpc_id(viewer_peer_id, VoxelStringNames::get_singleton().receive_block, data);
-	// Instead of sending it right away, defer it until the terrain finished processing. Sending individual blocks with
-	// the RPC system is too slow.
-	_deferred_block_messages_per_peer[viewer_peer_id].push_back(DeferredBlockMessage{ message_data });
+	_server.send_edited_blocks();
 }
 
-// TODO Have a way to implement ghost edits?
-// If someone wants to spam edits to appear smooth on clients, this would have terrible impact on networking
-// performance. So perhaps the server needs to cluster edits that are close together, and send the area in batch.
-// Conversely, the client would have to apply the edit locally, while having a way to revert it if the server
-// isn't acknowledging it for some time.
+void VoxelTerrainMultiplayerSynchronizer::schedule_serialization() {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(_terrain != nullptr);
 
-void VoxelTerrainMultiplayerSynchronizer::send_area(Box3i voxel_box) {
+	StdVector<BlockReplicationServer::SerializationJob> jobs;
+	_server.take_serialization_jobs(jobs);
+
+	std::shared_ptr<VoxelData> data = _terrain->get_storage_shared();
+	BufferedTaskScheduler &scheduler = BufferedTaskScheduler::get_for_current_thread();
+
+	for (unsigned int i = 0; i < jobs.size(); i += SERIALIZATION_JOBS_PER_TASK) {
+		const unsigned int count = math::min<unsigned int>(jobs.size() - i, SERIALIZATION_JOBS_PER_TASK);
+		SerializeReplicatedBlocksTask *task = ZN_NEW(SerializeReplicatedBlocksTask);
+		task->jobs.assign(jobs.begin() + i, jobs.begin() + i + count);
+		task->data = data;
+		task->output_queue = _serialization_results;
+		scheduler.push_main_task(task);
+	}
+
+	scheduler.flush();
+}
+
+void VoxelTerrainMultiplayerSynchronizer::apply_serialization_results() {
 	ZN_PROFILE_SCOPE();
 	ZN_ASSERT_RETURN(_terrain != nullptr);
 
+	StdVector<BlockReplicationServer::SerializationResult> &results = _serialization_results_temp;
+	{
+		MutexLock mlock(_serialization_results->mutex);
+		std::swap(results, _serialization_results->results);
+	}
+	if (results.size() == 0) {
+		return;
+	}
+
+	const int block_size = _terrain->get_data_block_size();
 	StdVector<ViewerID> viewers;
-	_terrain->get_viewers_in_area(viewers, voxel_box);
 
-	// Not particularly efficient for single-voxel edits, but should scale ok with bigger boxes
-	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_POOL);
-	voxels.create(voxel_box.size);
-	_terrain->get_storage().copy(voxel_box.position, voxels, 0xff);
+	_server.apply_serialization_results(
+			to_span_const(results),
+			[this, block_size, &viewers](Vector3i bpos, StdVector<int> &out_peer_ids) {
+				viewers.clear();
+				_terrain->get_viewers_in_area(viewers, Box3i(bpos * block_size, Vector3iUtil::create(block_size)));
+
+				for (const ViewerID viewer_id : viewers) {
+					const int peer_id = VoxelEngine::get_singleton().get_viewer_network_peer_id(viewer_id);
+					if (peer_id == -1 || peer_id == MultiplayerPeer::TARGET_PEER_SERVER) {
+						continue;
+					}
+					out_peer_ids.push_back(peer_id);
+				}
+			}
+	);
 
-	BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(voxels);
-	ZN_ASSERT_RETURN(result.success);
+	results.clear();
+}
 
-	PackedByteArray pba;
-	pba.resize(4 * sizeof(int32_t) + result.data.size());
-
-	ByteSpanWithPosition mw_span(Span<uint8_t>(pba.ptrw(), pba.size()), 0);
-	MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
-
-	mw.store_32(voxel_box.position.x);
-	mw.store_32(voxel_box.position.y);
-	mw.store_32(voxel_box.position.z);
-	mw.store_32(result.data.size());
-	mw.store_buffer(to_span(result.data));
-	for (const ViewerID viewer_id : viewers) {
-		const int peer_id = VoxelEngine::get_singleton().get_viewer_network_peer_id(viewer_id);
-		// TODO Don't bother copying and serializing if no networked viewers are around?
-		if (peer_id != -1 && peer_id != MultiplayerPeer::TARGET_PEER_SERVER) {
-			rpc_id(peer_id, VoxelStringNames::get_singleton()._rpc_receive_area, pba);
-		}
-	}
+void VoxelTerrainMultiplayerSynchronizer::on_data_block_unloaded(Vector3i bpos) {
+	_server.on_block_unloaded(bpos);
+	_client.on_block_unloaded(bpos);
+}
+
+void VoxelTerrainMultiplayerSynchronizer::on_viewer_data_box_changed(Box3i prev_data_box, Box3i new_data_box) {
+	new_data_box.difference(prev_data_box, [this](Box3i box) { _client.on_area_entered_view(box); });
+	prev_data_box.difference(new_data_box, [this](Box3i box) { _client.on_area_exited_view(box); });
+}
+
+int VoxelTerrainMultiplayerSynchronizer::get_edit_batch_interval_msec() const {
+	return _edit_batch_interval_msec;
+}
+
+void VoxelTerrainMultiplayerSynchronizer::set_edit_batch_interval_msec(int msec) {
+	_edit_batch_interval_msec = math::max(msec, 0);
+}
+
+int VoxelTerrainMultiplayerSynchronizer::get_max_bandwidth_per_peer() const {
+	return _server.get_bandwidth_limit();
+}
+
+void VoxelTerrainMultiplayerSynchronizer::set_max_bandwidth_per_peer(int bytes_per_second) {
+	_server.set_bandwidth_limit(math::max(bytes_per_second, 0));
+}
+
+int VoxelTerrainMultiplayerSynchronizer::get_message_size_target() const {
+	return _server.get_message_size_target();
+}
+
+void VoxelTerrainMultiplayerSynchronizer::set_message_size_target(int bytes) {
+	_server.set_message_size_target(math::max(bytes, 0));
+}
+
+int VoxelTerrainMultiplayerSynchronizer::get_max_queued_bytes_per_peer() const {
+	return _server.get_max_queued_bytes();
+}
+
+void VoxelTerrainMultiplayerSynchronizer::set_max_queued_bytes_per_peer(int bytes) {
+	_server.set_max_queued_bytes(math::max(bytes, 0));
 }
 
 void VoxelTerrainMultiplayerSynchronizer::_notification(int p_what) {
@@ -129,59 +219,169 @@ void VoxelTerrainMultiplayerSynchronizer::_notification(int p_what) {
 			_terrain->set_multiplayer_synchronizer(nullptr);
 		}
 		_terrain = nullptr;
+		_server.clear();
+		_client.clear();
+		// Serialization tasks still running would post results for blocks the server no longer expects
+		_serialization_results = make_shared_instance<ReplicatedBlocksSerializationOutputQueue>();
+		_cache_lookup_results = make_shared_instance<CachedBlocksLookupOutputQueue>();
+
+	} else if (p_what == NOTIFICATION_ENTER_TREE) {
+		connect_to_multiplayer();
+
+	} else if (p_what == NOTIFICATION_EXIT_TREE) {
+		disconnect_from_multiplayer();
 
 	} else if (p_what == NOTIFICATION_PROCESS) {
-		process();
+		process(get_process_delta_time());
 	}
 }
 
-// template <typename T, typename F>
-// inline void for_chunks(const StdVector<T> &vec, unsigned int chunk_size, F f) {
-// 	for (unsigned int i = 0; i < vec.size(); i += chunk_size) {
-// 		f(to_span_from_position_and_size(vec, i, i + chunk_size > vec.size() ? vec.size() - i : chunk_size));
-// 	}
-// }
+void VoxelTerrainMultiplayerSynchronizer::connect_to_multiplayer() {
+	disconnect_from_multiplayer();
+	_multiplayer = get_multiplayer();
+	if (_multiplayer.is_valid()) {
+		_multiplayer->connect(
+				VoxelStringNames::get_singleton().peer_disconnected,
+				callable_mp(this, &VoxelTerrainMultiplayerSynchronizer::_on_peer_disconnected)
+		);
+	}
+}
 
-void VoxelTerrainMultiplayerSynchronizer::process() {
+void VoxelTerrainMultiplayerSynchronizer::disconnect_from_multiplayer() {
+	if (_multiplayer.is_valid()) {
+		_multiplayer->disconnect(
+				VoxelStringNames::get_singleton().peer_disconnected,
+				callable_mp(this, &VoxelTerrainMultiplayerSynchronizer::_on_peer_disconnected)
+		);
+		_multiplayer.unref();
+	}
+}
+
+void VoxelTerrainMultiplayerSynchronizer::_on_peer_disconnected(int peer_id) {
+	ZN_PRINT_VERBOSE(format("Peer {} disconnected, forgetting its replication state", peer_id));
+	_server.remove_peer(peer_id);
+}
+
+void VoxelTerrainMultiplayerSynchronizer::process(float delta_time) {
 	ZN_PROFILE_SCOPE();
 
-	for (auto it = _deferred_block_messages_per_peer.begin(); it != _deferred_block_messages_per_peer.end(); ++it) {
-		StdVector<DeferredBlockMessage> &messages = it->second;
+	if (_server.has_edited_blocks()) {
+		process_edits();
+	}
 
-		if (messages.size() == 0) {
-			continue;
-		}
+	apply_cache_lookup_results();
+	if (_client.has_blocks_to_look_up()) {
+		look_up_cache();
+	}
 
-		PackedByteArray pba;
-		// Make one big fat message per frame per peer, because sending many is super-slow with Godot's ENet multiplayer
-		// integration. It calls flush() on every RPC and that takes a lot of time, and there is overhead caused by
-		// the high-level features...
+	if (_terrain == nullptr) {
+		return;
+	}
 
-		unsigned int size = 0;
-		for (const DeferredBlockMessage &message : messages) {
-			size += message.data.size();
-		}
+	// Serialization results from previous frames are applied before scheduling new jobs, because blocks can only be
+	// serialized again once their previous job completed
+	apply_serialization_results();
+	if (_server.has_serialization_jobs()) {
+		schedule_serialization();
+	}
+
+	update_peer_positions();
+
+	// Make few big messages per frame per peer, because sending many is super-slow with Godot's ENet multiplayer
+	// integration. It calls flush() on every RPC and that takes a lot of time, and there is overhead caused by the
+	// high-level features...
+	_server.pop_messages(
+			delta_time,
+			[this](int peer_id, Span<const uint8_t> message_data) {
+				ZN_PRINT_VERBOSE(format("Sending {} bytes of block data to peer {}", message_data.size(), peer_id));
+				// print_data_hex(message_data);
+				const PackedByteArray pba = to_packed_byte_array(message_data);
+				rpc_id(peer_id, VoxelStringNames::get_singleton()._rpc_receive_blocks, pba);
+			}
+	);
+}
+
+void VoxelTerrainMultiplayerSynchronizer::update_peer_positions() {
+	ZN_PROFILE_SCOPE();
 
-		pba.resize(1 * sizeof(uint32_t) + size);
+	// Blocks closest to viewers are sent first
+	const Transform3D world_to_local = _terrain->get_global_transform().affine_inverse();
+	const float block_size = _terrain->get_data_block_size();
+
+	VoxelEngine::get_singleton().for_each_viewer(
+			[this, &world_to_local, block_size](ViewerID id, const VoxelEngine::Viewer &viewer) {
+				if (viewer.network_peer_id == -1 || viewer.network_peer_id == MultiplayerPeer::TARGET_PEER_SERVER) {
+					return;
+				}
+				const Vector3f local_position = to_vec3f(world_to_local.xform(viewer.world_position));
+				_server.set_peer_position(viewer.network_peer_id, local_position / block_size);
+			}
+	);
+}
 
-		ByteSpanWithPosition mw_span(Span<uint8_t>(pba.ptrw(), pba.size()), 0);
-		MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
-		mw.store_32(messages.size());
+void VoxelTerrainMultiplayerSynchronizer::look_up_cache() {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(_terrain != nullptr);
+
+	if (is_server()) {
+		// Nothing to look up
+		_client.clear();
+		return;
+	}
+
+	BlockReplicationClient::CacheLookupJob job;
+	if (!_client.take_cache_lookup_job(_terrain->get_data_block_size(), job)) {
+		return;
+	}
 
-		for (const DeferredBlockMessage &message : messages) {
-			mw.store_buffer(Span<const uint8_t>(message.data.ptr(), message.data.size()));
+	std::shared_ptr<StreamingDependency> stream_dependency = _terrain->get_streaming_dependency();
+	ZN_ASSERT_RETURN(stream_dependency != nullptr);
+
+	if (stream_dependency->stream.is_null()) {
+		// No cache. The report is still sent, so the server doesn't wait for it before sending blocks.
+		BlockReplicationClient::CacheLookupResult result;
+		result.positions = std::move(job.positions);
+		StdVector<uint8_t> report;
+		if (_client.apply_cache_lookup_result(result, report)) {
+			report_cached_blocks(to_span_const(report));
 		}
-		ZN_ASSERT(mw.data.size() == mw.data.pos);
+		return;
+	}
+
+	// Loading from the stream can take a while, so it is done on the IO thread like other stream accesses
+	LookUpCachedBlocksTask *task = ZN_NEW(LookUpCachedBlocksTask);
+	task->job = std::move(job);
+	task->stream_dependency = stream_dependency;
+	task->output_queue = _cache_lookup_results;
+	VoxelEngine::get_singleton().push_async_io_task(task);
+}
 
-		messages.clear();
+void VoxelTerrainMultiplayerSynchronizer::apply_cache_lookup_results() {
+	ZN_PROFILE_SCOPE();
+
+	StdVector<BlockReplicationClient::CacheLookupResult> results;
+	{
+		MutexLock mlock(_cache_lookup_results->mutex);
+		std::swap(results, _cache_lookup_results->results);
+	}
 
-		const int peer_id = it->first;
-		ZN_PRINT_VERBOSE(format("Sending {} bytes of block data to peer {}", pba.size(), peer_id));
-		// print_data_hex(Span<const uint8_t>(pba.ptr(), pba.size()));
-		rpc_id(peer_id, VoxelStringNames::get_singleton()._rpc_receive_blocks, pba);
+	StdVector<uint8_t> report;
+	for (const BlockReplicationClient::CacheLookupResult &result : results) {
+		if (_client.apply_cache_lookup_result(result, report)) {
+			report_cached_blocks(to_span_const(report));
+		}
 	}
 }
 
+void VoxelTerrainMultiplayerSynchronizer::report_cached_blocks(Span<const uint8_t> report) {
+	ZN_PRINT_VERBOSE(format("Reporting {} bytes of cached blocks to the server", report.size()));
+	rpc_id(
+			MultiplayerPeer::TARGET_PEER_SERVER,
+			VoxelStringNames::get_singleton()._rpc_report_cached_blocks,
+			to_packed_byte_array(report)
+	);
+}
+
 void VoxelTerrainMultiplayerSynchronizer::_b_receive_blocks(PackedByteArray message_data) {
 	ZN_PROFILE_SCOPE();
 	ZN_ASSERT_RETURN(_terrain != nullptr);
@@ -189,55 +389,88 @@ void VoxelTerrainMultiplayerSynchronizer::_b_receive_blocks(PackedByteArray mess
 	// print_line(String("Client: receive blocks data {1}").format(varray(data.size())));
 	//  print_data_hex(Span<const uint8_t>(data.ptr(), data.size()));
 
-	MemoryReader mr(Span<const uint8_t>(message_data.ptr(), message_data.size()), ENDIANNESS_LITTLE_ENDIAN);
+	VoxelData &data = _terrain->get_storage();
 
-	const unsigned int block_count = mr.get_32();
+	_receive_result.clear();
+	_client.receive_blocks(to_span(message_data), data, _receive_result);
 
-	for (unsigned int i = 0; i < block_count; ++i) {
-		Vector3i bpos;
-		// This effectively limits volume size to 1,048,576. If really required, we could double this data to cover
-		// more.
-		bpos.x = int16_t(mr.get_16());
-		bpos.y = int16_t(mr.get_16());
-		bpos.z = int16_t(mr.get_16());
-		const int voxel_data_size = mr.get_16();
-		// print_line(String("Client: receive block {0} data {1}").format(varray(bpos, voxel_data_size)));
+	// Blocks are applied in the order they were received, because the same block can be updated more than once
+	for (BlockReplicationClient::ReceivedBlock &block : _receive_result.blocks) {
+		if (_terrain->has_data_block(block.position)) {
+			// The block was edited
+			const Box3i box(data.block_to_voxel(block.position), block.voxels->get_size());
+			data.paste(box.position, *block.voxels, 0xff, false);
+			_terrain->post_edit_area(box, true);
 
-		VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_POOL);
-		ZN_ASSERT_RETURN(BlockSerializer::decompress_and_deserialize(mr.data.sub(mr.pos, voxel_data_size), voxels));
+		} else if (!_terrain->try_set_block_data(block.position, block.voxels)) {
+			// Out of range, forget about it
+			_client.on_block_unloaded(block.position);
+		}
+	}
+
+	if (_receive_result.blocks_to_request.size() > 0) {
+		request_blocks_from_server(to_span_const(_receive_result.blocks_to_request));
+	}
+
+	_receive_result.clear();
+}
 
-		mr.pos += voxel_data_size;
+void VoxelTerrainMultiplayerSynchronizer::request_blocks_from_server(Span<const Vector3i> positions) {
+	ZN_PRINT_VERBOSE(format("Requesting {} blocks from the server", positions.size()));
 
-		std::shared_ptr<VoxelBuffer> voxels_p = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
-		*voxels_p = std::move(voxels);
+	StdVector<uint8_t> message_data;
 
-		ZN_ASSERT_RETURN(_terrain != nullptr);
-		_terrain->try_set_block_data(bpos, voxels_p);
+	for (unsigned int i = 0; i < positions.size(); i += MAX_REQUESTED_BLOCKS) {
+		const unsigned int count = math::min<unsigned int>(positions.size() - i, MAX_REQUESTED_BLOCKS);
+		BlockReplicationClient::write_blocks_request(positions.sub(i, count), message_data);
+		rpc_id(
+				MultiplayerPeer::TARGET_PEER_SERVER,
+				VoxelStringNames::get_singleton()._rpc_request_blocks,
+				to_packed_byte_array(to_span_const(message_data))
+		);
 	}
 }
 
-void VoxelTerrainMultiplayerSynchronizer::_b_receive_area(PackedByteArray message_data) {
+void VoxelTerrainMultiplayerSynchronizer::_b_request_blocks(PackedByteArray message_data) {
 	ZN_PROFILE_SCOPE();
 	ZN_ASSERT_RETURN(_terrain != nullptr);
+	ZN_ASSERT_RETURN(is_server());
 
-	MemoryReader mr(Span<const uint8_t>(message_data.ptr(), message_data.size()), ENDIANNESS_LITTLE_ENDIAN);
+	const int peer_id = get_multiplayer()->get_remote_sender_id();
 
-	Vector3i pos;
-	pos.x = int32_t(mr.get_32());
-	pos.y = int32_t(mr.get_32());
-	pos.z = int32_t(mr.get_32());
-	const int voxel_data_size = mr.get_32();
+	StdVector<Vector3i> positions;
+	ZN_ASSERT_RETURN(BlockReplicationServer::read_blocks_request(to_span(message_data), positions));
 
-	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_POOL);
-	ZN_ASSERT_RETURN(BlockSerializer::decompress_and_deserialize(mr.data.sub(mr.pos, voxel_data_size), voxels));
+	const int block_size = _terrain->get_data_block_size();
+	StdVector<ViewerID> viewers;
 
-	_terrain->get_storage().paste(pos, voxels, 0xff, false);
-	_terrain->post_edit_area(
-			Box3i(pos, voxels.get_size()),
-			// Don't bother for now, update mesh regardless. If necessary we would have to add a flag with the message
-			// to tell it's not actually changing voxels (if it's metadata changes), but might not be worth it
-			true
-	);
+	for (const Vector3i bpos : positions) {
+		// Only send blocks the peer is supposed to see
+		viewers.clear();
+		_terrain->get_viewers_in_area(viewers, Box3i(bpos * block_size, Vector3iUtil::create(block_size)));
+		bool is_viewer = false;
+		for (const ViewerID viewer_id : viewers) {
+			if (VoxelEngine::get_singleton().get_viewer_network_peer_id(viewer_id) == peer_id) {
+				is_viewer = true;
+				break;
+			}
+		}
+		if (!is_viewer) {
+			continue;
+		}
+
+		if (_terrain->has_data_block(bpos)) {
+			_server.send_block(peer_id, bpos);
+		}
+	}
+}
+
+void VoxelTerrainMultiplayerSynchronizer::_b_report_cached_blocks(PackedByteArray message_data) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(is_server());
+
+	const int peer_id = get_multiplayer()->get_remote_sender_id();
+	_server.receive_cached_blocks_report(peer_id, to_span(message_data));
 }
 
 #ifdef TOOLS_ENABLED
@@ -280,12 +513,48 @@ void VoxelTerrainMultiplayerSynchronizer::get_configuration_warnings(PackedStrin
 #endif
 
 void VoxelTerrainMultiplayerSynchronizer::_bind_methods() {
+	using Self = VoxelTerrainMultiplayerSynchronizer;
+
+	ClassDB::bind_method(D_METHOD("get_edit_batch_interval_msec"), &Self::get_edit_batch_interval_msec);
+	ClassDB::bind_method(D_METHOD("set_edit_batch_interval_msec", "msec"), &Self::set_edit_batch_interval_msec);
+
+	ClassDB::bind_method(D_METHOD("get_max_bandwidth_per_peer"), &Self::get_max_bandwidth_per_peer);
+	ClassDB::bind_method(
+			D_METHOD("set_max_bandwidth_per_peer", "bytes_per_second"), &Self::set_max_bandwidth_per_peer
+	);
+
+	ClassDB::bind_method(D_METHOD("get_message_size_target"), &Self::get_message_size_target);
+	ClassDB::bind_method(D_METHOD("set_message_size_target", "bytes"), &Self::set_message_size_target);
+
+	ClassDB::bind_method(D_METHOD("get_max_queued_bytes_per_peer"), &Self::get_max_queued_bytes_per_peer);
+	ClassDB::bind_method(D_METHOD("set_max_queued_bytes_per_peer", "bytes"), &Self::set_max_queued_bytes_per_peer);
+
 	// TODO These methods are not supposed to be exposed. They only exist for Godot's high-level multiplayer to find
 	// them.
-	ClassDB::bind_method(
-			D_METHOD("_rpc_receive_blocks", "data"), &VoxelTerrainMultiplayerSynchronizer::_b_receive_blocks
+	ClassDB::bind_method(D_METHOD("_rpc_receive_blocks", "data"), &Self::_b_receive_blocks);
+	ClassDB::bind_method(D_METHOD("_rpc_request_blocks", "data"), &Self::_b_request_blocks);
+	ClassDB::bind_method(D_METHOD("_rpc_report_cached_blocks", "data"), &Self::_b_report_cached_blocks);
+
+	ADD_PROPERTY(
+			PropertyInfo(Variant::INT, "edit_batch_interval_msec", PROPERTY_HINT_RANGE, "0,1000,1,or_greater"),
+			"set_edit_batch_interval_msec",
+			"get_edit_batch_interval_msec"
+	);
+	ADD_PROPERTY(
+			PropertyInfo(Variant::INT, "max_bandwidth_per_peer", PROPERTY_HINT_RANGE, "0,10000000,1,or_greater"),
+			"set_max_bandwidth_per_peer",
+			"get_max_bandwidth_per_peer"
+	);
+	ADD_PROPERTY(
+			PropertyInfo(Variant::INT, "message_size_target", PROPERTY_HINT_RANGE, "0,65536,1,or_greater"),
+			"set_message_size_target",
+			"get_message_size_target"
+	);
+	ADD_PROPERTY(
+			PropertyInfo(Variant::INT, "max_queued_bytes_per_peer", PROPERTY_HINT_RANGE, "0,67108864,1,or_greater"),
+			"set_max_queued_bytes_per_peer",
+			"get_max_queued_bytes_per_peer"
 	);
-	ClassDB::bind_method(D_METHOD("_rpc_receive_area", "data"), &VoxelTerrainMultiplayerSynchronizer::_b_receive_area);
 }
 
 } // namespace zylann::voxel
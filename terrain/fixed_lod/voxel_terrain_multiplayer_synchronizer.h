@@ -1,11 +1,12 @@
 #ifndef VOXEL_NETWORK_TERRAIN_SYNC_H
 #define VOXEL_NETWORK_TERRAIN_SYNC_H
 
-#include "../../storage/voxel_data_block.h"
-#include "../../util/containers/std_unordered_map.h"
 #include "../../util/containers/std_vector.h"
+#include "../../util/godot/classes/multiplayer_api.h"
 #include "../../util/godot/classes/node.h"
 #include "../../util/math/box3i.h"
+#include "block_replication.h"
+#include <memory>
 
 #ifdef TOOLS_ENABLED
 #include "../../util/godot/core/version.h"
@@ -14,6 +15,8 @@
 namespace zylann::voxel {
 
 class VoxelTerrain;
+struct ReplicatedBlocksSerializationOutputQueue;
+struct CachedBlocksLookupOutputQueue;
 
 // Implements multiplayer replication for `VoxelTerrain`
 class VoxelTerrainMultiplayerSynchronizer : public Node {
@@ -23,9 +26,25 @@ public:
 
 	bool is_server() const;
 
-	void send_block(int viewer_peer_id, const VoxelDataBlock &data_block, Vector3i bpos);
+	void send_block(int viewer_peer_id, Vector3i bpos);
 	void send_area(Box3i voxel_box);
 
+	void on_data_block_unloaded(Vector3i bpos);
+	// Called on clients when the area of a local viewer changes, in blocks
+	void on_viewer_data_box_changed(Box3i prev_data_box, Box3i new_data_box);
+
+	int get_edit_batch_interval_msec() const;
+	void set_edit_batch_interval_msec(int msec);
+
+	int get_max_bandwidth_per_peer() const;
+	void set_max_bandwidth_per_peer(int bytes_per_second);
+
+	int get_message_size_target() const;
+	void set_message_size_target(int bytes);
+
+	int get_max_queued_bytes_per_peer() const;
+	void set_max_queued_bytes_per_peer(int bytes);
+
 #ifdef TOOLS_ENABLED
 #if defined(ZN_GODOT)
 	PackedStringArray get_configuration_warnings() const override;
@@ -38,21 +57,42 @@ public:
 private:
 	void _notification(int p_what);
 
-	void process();
+	void process(float delta_time);
+	void process_edits();
+	void schedule_serialization();
+	void apply_serialization_results();
+	void update_peer_positions();
+	void look_up_cache();
+	void apply_cache_lookup_results();
+	void report_cached_blocks(Span<const uint8_t> report);
+	void connect_to_multiplayer();
+	void disconnect_from_multiplayer();
+	void _on_peer_disconnected(int peer_id);
 
 	void _b_receive_blocks(PackedByteArray message_data);
-	void _b_receive_area(PackedByteArray message_data);
+	void _b_request_blocks(PackedByteArray message_data);
+	void _b_report_cached_blocks(PackedByteArray message_data);
+
+	void request_blocks_from_server(Span<const Vector3i> positions);
 
 	static void _bind_methods();
 
 	VoxelTerrain *_terrain = nullptr;
 	int _rpc_channel = 0;
-
-	struct DeferredBlockMessage {
-		PackedByteArray data;
-	};
-
-	StdUnorderedMap<int, StdVector<DeferredBlockMessage>> _deferred_block_messages_per_peer;
+	// Multiplayer API we get peer notifications from
+	Ref<MultiplayerAPI> _multiplayer;
+
+	// Server-side
+	BlockReplicationServer _server;
+	int _edit_batch_interval_msec = 0;
+	uint64_t _next_edit_flush_time_msec = 0;
+	std::shared_ptr<ReplicatedBlocksSerializationOutputQueue> _serialization_results;
+	StdVector<BlockReplicationServer::SerializationResult> _serialization_results_temp;
+
+	// Client-side
+	BlockReplicationClient _client;
+	BlockReplicationClient::ReceiveResult _receive_result;
+	std::shared_ptr<CachedBlocksLookupOutputQueue> _cache_lookup_results;
 };
 
 } // namespace zylann::voxel
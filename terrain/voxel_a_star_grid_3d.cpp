@@ -2,100 +2,35 @@
 #include "../terrain/fixed_lod/voxel_terrain.h"
 // #include "../util/string/format.h"
 #include "../constants/voxel_string_names.h"
+#include "../engine/voxel_engine.h"
 #include "../util/math/conv.h"
 
 namespace zylann::voxel {
 
-VoxelAStarGrid3DInternal::VoxelAStarGrid3DInternal() : _voxel_buffer(VoxelBuffer::ALLOCATOR_POOL) {}
-
 void VoxelAStarGrid3DInternal::init_cache() {
-	_grid_cache_size = math::ceildiv(get_region().size, Chunk::SIZE);
-	_grid_cache.resize(_grid_cache_size.x * _grid_cache_size.y * _grid_cache_size.z);
-	_grid_chunk_states.resize_no_init(_grid_cache.size());
-	_grid_chunk_states.fill(false);
-	_voxel_buffer.create(Vector3iUtil::create(Chunk::SIZE));
-
-	// const Box3i region = get_region();
-	// for (int y = region.pos.y; y < region.pos.y + region.size.y; ++y) {
-	// 	println(format("Y={}", y));
-	// 	for (int z = region.pos.z; z < region.pos.z + region.size.z; ++z) {
-	// 		std::string s;
-	// 		for (int x = region.pos.x; x < region.pos.x + region.size.x; ++x) {
-	// 			if (is_solid(Vector3i(x, y, z))) {
-	// 				s += " O";
-	// 			} else {
-	// 				s += " -";
-	// 			}
-	// 		}
-	// 		println(s);
-	// 	}
-	// }
+	_context.clear();
 }
 
-bool VoxelAStarGrid3DInternal::is_solid(Vector3i pos) {
-	// TODO We could align the cache with the voxel chunk grid to avoid more expensive copies across chunk borders
-	const Vector3i gpos = pos - get_region().position;
-	const Vector3i cpos = gpos >> Chunk::SIZE_PO2;
-	const Vector3i rpos = gpos & Chunk::SIZE_MASK;
-
-	const unsigned int chunk_loc = Vector3iUtil::get_zxy_index(cpos, _grid_cache_size);
-	Chunk chunk;
-
-	if (_grid_chunk_states.get(chunk_loc)) {
-		chunk = _grid_cache[chunk_loc];
-
-	} else {
-		ZN_PROFILE_SCOPE_NAMED("Caching voxels");
-		ZN_ASSERT(data != nullptr);
-
-		const VoxelBuffer::ChannelId channel_index = VoxelBuffer::CHANNEL_TYPE;
-		const Vector3i copy_origin = (cpos << Chunk::SIZE_PO2) + get_region().position;
-		data->copy(copy_origin, _voxel_buffer, 1 << channel_index);
-
-		if (_voxel_buffer.get_channel_compression(channel_index) == VoxelBuffer::COMPRESSION_UNIFORM) {
-			if (_voxel_buffer.get_voxel(0, 0, 0, channel_index) != 0) {
-				chunk.solid_bits = 0xffffffffffffffff;
-			} else {
-				chunk.solid_bits = 0;
-			}
-
-		} else {
-			chunk.solid_bits = 0;
-
-			switch (_voxel_buffer.get_channel_depth(channel_index)) {
-				case VoxelBuffer::DEPTH_8_BIT: {
-					Span<const uint8_t> values;
-					ZN_ASSERT(_voxel_buffer.get_channel_data(channel_index, values));
-					uint64_t i = 0;
-					// Assuming ZXY loop order
-					for (const uint8_t v : values) {
-						chunk.solid_bits |= (v == 0 ? uint64_t(0) : (uint64_t(1) << i));
-						++i;
-					}
-				} break;
-
-				case VoxelBuffer::DEPTH_16_BIT: {
-					Span<const uint16_t> values;
-					ZN_ASSERT(_voxel_buffer.get_channel_data(channel_index, values));
-					uint64_t i = 0;
-					for (const uint16_t v : values) {
-						chunk.solid_bits |= (v == 0 ? uint64_t(0) : (uint64_t(1) << i));
-						++i;
-					}
-				} break;
-
-				default:
-					ZN_PRINT_ERROR("Unhandled channel depth");
-					break;
-			}
-
-			_grid_chunk_states.set(chunk_loc);
-		}
+bool VoxelAStarGrid3DInternal::find_path_hierarchical(
+		Vector3i from_position,
+		Vector3i to_position,
+		StdVector<Vector3i> &out_path
+) {
+	ZN_ASSERT(cache != nullptr);
+	return cache->find_path(*this, _context, from_position, to_position, out_path);
+}
 
-		_grid_cache[chunk_loc] = chunk;
-	}
+void VoxelAStarGrid3DInternal::copy_settings_to(VoxelAStarGrid3DInternal &dst) const {
+	dst.set_region(get_region());
+	dst.set_agent_size(get_agent_size());
+	dst.set_max_fall_height(get_max_fall_height());
+	dst.set_max_path_cost(get_max_path_cost());
+	dst.cache = cache;
+}
 
-	return chunk.get_solid_bit(rpos);
+bool VoxelAStarGrid3DInternal::is_solid(Vector3i pos) {
+	ZN_ASSERT(cache != nullptr);
+	return _context.is_solid(*cache, pos);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -104,7 +39,11 @@ void VoxelAStarGrid3D::set_terrain(VoxelTerrain *node) {
 	ZN_ASSERT_RETURN(node != nullptr);
 	// Can't modify the pathfinder while it is running in a different thread
 	ZN_ASSERT_RETURN(_is_running_async == false);
-	_path_finder.data = node->get_storage_shared();
+	_cache = make_shared_instance<VoxelNavigationCache>(node->get_storage_shared());
+	_cache->set_rules(_path_finder);
+	// The terrain only holds a weak reference, the cache goes away with the last pathfinder using it
+	node->add_area_edit_listener(_cache);
+	_path_finder.cache = _cache;
 }
 
 TypedArray<Vector3i> VoxelAStarGrid3D::find_path(Vector3i from_position, Vector3i to_position) {
@@ -142,20 +81,47 @@ TypedArray<Vector3i> to_typed_array(Span<const Vector3i> items) {
 } // namespace
 
 TypedArray<Vector3i> VoxelAStarGrid3D::find_path_internal(Vector3i from_position, Vector3i to_position) {
-	_path_finder.start(from_position, to_position);
-	_path_finder.init_cache();
+	StdVector<Vector3i> path;
+	find_path_internal(_path_finder, _hierarchical_search_enabled, from_position, to_position, path);
+	return to_typed_array(to_span(path));
+}
+
+void VoxelAStarGrid3D::find_path_internal(
+		VoxelAStarGrid3DInternal &path_finder,
+		bool hierarchical,
+		Vector3i from_position,
+		Vector3i to_position,
+		StdVector<Vector3i> &out_path
+) {
+	out_path.clear();
+	ZN_ASSERT_RETURN_MSG(path_finder.cache != nullptr, "No terrain was set");
+
+	path_finder.init_cache();
+
+	if (hierarchical) {
+		path_finder.find_path_hierarchical(from_position, to_position, out_path);
 
-	while (_path_finder.is_running()) {
-		_path_finder.step();
+	} else {
+		path_finder.start(from_position, to_position);
+
+		while (path_finder.is_running()) {
+			path_finder.step();
+		}
+
+		Span<const Vector3i> path = path_finder.get_path();
+		out_path.insert(out_path.end(), path.begin(), path.end());
 	}
 
-	Span<const Vector3i> path = _path_finder.get_path();
-	return to_typed_array(path);
+	// Don't hold on cached data longer than necessary
+	path_finder.init_cache();
 }
 
 void VoxelAStarGrid3D::set_region(Box3i region) {
 	ZN_ASSERT_RETURN(_is_running_async == false);
 	_path_finder.set_region(region);
+	if (_cache != nullptr) {
+		_cache->set_rules(_path_finder);
+	}
 }
 
 Box3i VoxelAStarGrid3D::get_region() {
@@ -196,10 +162,116 @@ void VoxelAStarGrid3D::find_path_async(Vector3i from_position, Vector3i to_posit
 	VoxelEngine::get_singleton().push_async_task(task);
 }
 
+namespace {
+
+struct PathBatch {
+	StdVector<Vector3i> from_positions;
+	StdVector<Vector3i> to_positions;
+	StdVector<StdVector<Vector3i>> paths;
+	std::atomic_uint32_t remaining_tasks = { 0 };
+};
+
+} // namespace
+
+void VoxelAStarGrid3D::find_paths_async(TypedArray<Vector3i> from_positions, TypedArray<Vector3i> to_positions) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(_is_running_async == false);
+	ZN_ASSERT_RETURN_MSG(
+			from_positions.size() == to_positions.size(), "Source and destination arrays must have the same size"
+	);
+
+	std::shared_ptr<PathBatch> batch = make_shared_instance<PathBatch>();
+	const unsigned int query_count = from_positions.size();
+	batch->from_positions.resize(query_count);
+	batch->to_positions.resize(query_count);
+	batch->paths.resize(query_count);
+
+	for (unsigned int i = 0; i < query_count; ++i) {
+		batch->from_positions[i] = from_positions[i];
+		batch->to_positions[i] = to_positions[i];
+#ifdef DEBUG_ENABLED
+		check_params(batch->from_positions[i], batch->to_positions[i]);
+#endif
+	}
+
+	_is_running_async = true;
+
+	if (query_count == 0) {
+		call_deferred(VoxelStringNames::get_singleton()._on_async_paths_completed, Array());
+		return;
+	}
+
+	class Task : public IThreadedTask {
+	public:
+		Ref<VoxelAStarGrid3D> astar;
+		std::shared_ptr<PathBatch> batch;
+		// Each task has its own, so they can run in parallel. Cached navigation data is still shared.
+		VoxelAStarGrid3DInternal path_finder;
+		bool hierarchical;
+		unsigned int begin_index;
+		unsigned int end_index;
+
+		void run(ThreadedTaskContext &ctx) override {
+			ZN_PROFILE_SCOPE();
+			ZN_ASSERT(astar.is_valid());
+
+			for (unsigned int i = begin_index; i < end_index; ++i) {
+				VoxelAStarGrid3D::find_path_internal(
+						path_finder, hierarchical, batch->from_positions[i], batch->to_positions[i], batch->paths[i]
+				);
+			}
+
+			if (--batch->remaining_tasks == 0) {
+				// Last task to finish gathers results
+				Array paths;
+				paths.resize(batch->paths.size());
+				for (unsigned int i = 0; i < batch->paths.size(); ++i) {
+					paths[i] = to_typed_array(to_span(batch->paths[i]));
+				}
+				astar->call_deferred(VoxelStringNames::get_singleton()._on_async_paths_completed, paths);
+			}
+		}
+
+		const char *get_debug_name() const override {
+			return "VoxelAStarGrid3DBatchTask";
+		}
+	};
+
+	// Paths are grouped to amortize task overhead, while still spreading work across threads
+	const unsigned int queries_per_task = 8;
+	const unsigned int task_count = math::ceildiv(query_count, queries_per_task);
+	batch->remaining_tasks = task_count;
+
+	StdVector<IThreadedTask *> tasks;
+	tasks.reserve(task_count);
+
+	for (unsigned int task_index = 0; task_index < task_count; ++task_index) {
+		Task *task = ZN_NEW(Task);
+		task->astar = Ref<VoxelAStarGrid3D>(this);
+		task->batch = batch;
+		_path_finder.copy_settings_to(task->path_finder);
+		task->hierarchical = _hierarchical_search_enabled;
+		task->begin_index = task_index * queries_per_task;
+		task->end_index = math::min(task->begin_index + queries_per_task, query_count);
+		tasks.push_back(task);
+	}
+
+	VoxelEngine::get_singleton().push_async_tasks(to_span(tasks));
+}
+
 bool VoxelAStarGrid3D::is_running_async() const {
 	return _is_running_async;
 }
 
+void VoxelAStarGrid3D::set_hierarchical_search_enabled(bool enabled) {
+	ZN_ASSERT_RETURN(_is_running_async == false);
+	_hierarchical_search_enabled = enabled;
+}
+
+bool VoxelAStarGrid3D::is_hierarchical_search_enabled() const {
+	return _hierarchical_search_enabled;
+}
+
 TypedArray<Vector3i> VoxelAStarGrid3D::debug_get_visited_positions() const {
 	ZN_ASSERT_RETURN_V(_is_running_async == false, TypedArray<Vector3i>());
 	StdVector<Vector3i> positions;
@@ -222,6 +294,11 @@ void VoxelAStarGrid3D::_b_on_async_search_completed(TypedArray<Vector3i> path) {
 	emit_signal(VoxelStringNames::get_singleton().async_search_completed, path);
 }
 
+void VoxelAStarGrid3D::_b_on_async_paths_completed(Array paths) {
+	_is_running_async = false;
+	emit_signal(VoxelStringNames::get_singleton().async_paths_completed, paths);
+}
+
 void VoxelAStarGrid3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_terrain", "terrain"), &VoxelAStarGrid3D::set_terrain);
 
@@ -231,16 +308,36 @@ void VoxelAStarGrid3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("find_path", "from_position", "to_position"), &VoxelAStarGrid3D::find_path);
 	ClassDB::bind_method(
 			D_METHOD("find_path_async", "from_position", "to_position"), &VoxelAStarGrid3D::find_path_async);
+	ClassDB::bind_method(
+			D_METHOD("find_paths_async", "from_positions", "to_positions"), &VoxelAStarGrid3D::find_paths_async
+	);
 	ClassDB::bind_method(D_METHOD("is_running_async"), &VoxelAStarGrid3D::is_running_async);
 
+	ClassDB::bind_method(
+			D_METHOD("set_hierarchical_search_enabled", "enabled"), &VoxelAStarGrid3D::set_hierarchical_search_enabled
+	);
+	ClassDB::bind_method(
+			D_METHOD("is_hierarchical_search_enabled"), &VoxelAStarGrid3D::is_hierarchical_search_enabled
+	);
+
 	ClassDB::bind_method(D_METHOD("debug_get_visited_positions"), &VoxelAStarGrid3D::debug_get_visited_positions);
 
 	// Internal
 	ClassDB::bind_method(
 			D_METHOD("_on_async_search_completed", "path"), &VoxelAStarGrid3D::_b_on_async_search_completed);
+	ClassDB::bind_method(
+			D_METHOD("_on_async_paths_completed", "paths"), &VoxelAStarGrid3D::_b_on_async_paths_completed
+	);
+
+	ADD_PROPERTY(
+			PropertyInfo(Variant::BOOL, "hierarchical_search_enabled"),
+			"set_hierarchical_search_enabled",
+			"is_hierarchical_search_enabled"
+	);
 
 	ADD_SIGNAL(MethodInfo(
 			"async_search_completed", PropertyInfo(Variant::ARRAY, "path", PROPERTY_HINT_ARRAY_TYPE, "Vector3i")));
+	ADD_SIGNAL(MethodInfo("async_paths_completed", PropertyInfo(Variant::ARRAY, "paths")));
 }
 
 } // namespace zylann::voxel
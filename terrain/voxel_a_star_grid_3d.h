@@ -1,11 +1,11 @@
 #ifndef VOXEL_A_STAR_GRID_3D_H
 #define VOXEL_A_STAR_GRID_3D_H
 
-#include "../storage/voxel_buffer.h"
-#include "../storage/voxel_data.h"
 #include "../util/a_star_grid_3d.h"
-#include "../util/containers/dynamic_bitset.h"
 #include "../util/containers/std_vector.h"
+#include "../util/godot/classes/ref_counted.h"
+#include "../util/godot/core/typed_array.h"
+#include "voxel_navigation_cache.h"
 #include <atomic>
 
 namespace zylann::voxel {
@@ -14,46 +14,23 @@ class VoxelTerrain;
 
 class VoxelAStarGrid3DInternal : public AStarGrid3D {
 public:
-	VoxelAStarGrid3DInternal();
-
-	// Referring to VoxelData instead of using a VoxelTool because it allows to run the search in a threaded task.
-	// VoxelTool can't be used yet in threads because it holds a pointer to a terrain node, which could get deleted at
-	// any time.
-	std::shared_ptr<VoxelData> data;
+	// Referring to a cache of VoxelData instead of using a VoxelTool because it allows to run the search in a threaded
+	// task. VoxelTool can't be used yet in threads because it holds a pointer to a terrain node, which could get
+	// deleted at any time. The cache can be shared by multiple searches having the same settings.
+	std::shared_ptr<VoxelNavigationCache> cache;
 
+	// Releases cached data referenced by the previous search, so the next one sees recent edits
 	void init_cache();
 
-protected:
-	bool is_solid(Vector3i pos) override;
-
-private:
-	// We store a cache of solid bits for the whole pathfindable region.
-	// To minimize multithreaded access to the main voxel data, we only load chunks of bits as they are needed.
-
-	struct Chunk {
-		static const int SIZE_PO2 = 2;
-		static const int SIZE = 1 << SIZE_PO2;
-		static const int SIZE_MASK = SIZE - 1;
+	bool find_path_hierarchical(Vector3i from_position, Vector3i to_position, StdVector<Vector3i> &out_path);
 
-		// 4x4x4 bits in ZXY order
-		uint64_t solid_bits = 0;
+	// Copies search settings, not the state of a search
+	void copy_settings_to(VoxelAStarGrid3DInternal &dst) const;
 
-		inline bool get_solid_bit(Vector3i rel) const {
-			const uint64_t i = Vector3iUtil::get_zxy_index(rel, Vector3i(SIZE, SIZE, SIZE));
-			// const unsigned int i = rel.y + (rel.x << 2) + (rel.z << 4);
-			return ((solid_bits >> i) & uint64_t(1)) != 0;
-		}
-	};
-
-	// Cached 3D bitmap
-	StdVector<Chunk> _grid_cache;
-	Vector3i _grid_cache_size;
-
-	// Tracks which chunks are loaded
-	DynamicBitset _grid_chunk_states;
+	bool is_solid(Vector3i pos) override;
 
-	// Temporary buffer used to read voxels from the main voxel storage
-	VoxelBuffer _voxel_buffer;
+private:
+	VoxelNavigationCache::Context _context;
 };
 
 // Godot-facing API for voxel grid A* pathfinding. Suitable for blocky terrains.
@@ -61,7 +38,7 @@ class VoxelAStarGrid3D : public RefCounted {
 	GDCLASS(VoxelAStarGrid3D, RefCounted)
 public:
 	// Bare bones at the moment. May need more configurations and customization.
-	// Also, it does not cache data between queries.
+	// Navigation data is cached between queries, and invalidated when the terrain is edited.
 
 	void set_terrain(VoxelTerrain *node);
 
@@ -71,12 +48,24 @@ public:
 	TypedArray<Vector3i> find_path(Vector3i from_position, Vector3i to_position);
 
 	void find_path_async(Vector3i from_position, Vector3i to_position);
+	// Runs many searches in parallel, emitting a single signal when all of them are done.
+	void find_paths_async(TypedArray<Vector3i> from_positions, TypedArray<Vector3i> to_positions);
 	bool is_running_async() const;
 
+	void set_hierarchical_search_enabled(bool enabled);
+	bool is_hierarchical_search_enabled() const;
+
 	TypedArray<Vector3i> debug_get_visited_positions() const;
 
 private:
 	TypedArray<Vector3i> find_path_internal(Vector3i from_position, Vector3i to_position);
+	static void find_path_internal(
+			VoxelAStarGrid3DInternal &path_finder,
+			bool hierarchical,
+			Vector3i from_position,
+			Vector3i to_position,
+			StdVector<Vector3i> &out_path
+	);
 #ifdef DEBUG_ENABLED
 	void check_params(Vector3i from_position, Vector3i to_position);
 #endif
@@ -84,10 +73,13 @@ private:
 	void _b_set_region(AABB aabb);
 	AABB _b_get_region();
 	void _b_on_async_search_completed(TypedArray<Vector3i> path);
+	void _b_on_async_paths_completed(Array paths);
 
 	static void _bind_methods();
 
 	VoxelAStarGrid3DInternal _path_finder;
+	std::shared_ptr<VoxelNavigationCache> _cache;
+	bool _hierarchical_search_enabled = false;
 	std::atomic_bool _is_running_async = { false };
 };
 
@@ -0,0 +1,752 @@
+#include "voxel_navigation_cache.h"
+#include "../storage/voxel_buffer.h"
+#include "../storage/voxel_data.h"
+#include "../util/math/conv.h"
+#include "../util/math/funcs.h"
+#include "../util/profiling.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+namespace zylann::voxel {
+
+namespace {
+
+// Offsets of neighbor clusters agents can move to in one step. Agents move either horizontally or vertically.
+// clang-format off
+const Vector3i g_cluster_neighbor_offsets[10] = {
+	Vector3i(-1, 0, -1),
+	Vector3i(0, 0, -1),
+	Vector3i(1, 0, -1),
+	Vector3i(-1, 0, 0),
+	Vector3i(1, 0, 0),
+	Vector3i(-1, 0, 1),
+	Vector3i(0, 0, 1),
+	Vector3i(1, 0, 1),
+	Vector3i(0, -1, 0),
+	Vector3i(0, 1, 0),
+};
+// clang-format on
+
+const float INFINITE_COST = std::numeric_limits<float>::max();
+
+inline int get_chebyshev_distance(Vector3i a, Vector3i b) {
+	const Vector3i d = math::abs(b - a);
+	return math::max(d.x, math::max(d.y, d.z));
+}
+
+// Dijkstra search limited to a box, finding the cost of travelling between an origin and every cell of the box.
+struct LocalSearch {
+	static const uint32_t NO_LINK = std::numeric_limits<uint32_t>::max();
+
+	Box3i box;
+	StdVector<float> costs;
+	// In forward searches, index of the previous cell along the path from the origin.
+	// In reverse searches, index of the next cell along the path to the origin.
+	StdVector<uint32_t> links;
+
+	StdVector<std::pair<float, uint32_t>> heap;
+	StdVector<Vector3i> neighbors;
+	// Reverse searches need to know from where cells can be reached. Cells of `reverse_links` from
+	// `reverse_link_offsets[i]` to `reverse_link_offsets[i + 1]` can move to cell `i`.
+	StdVector<uint32_t> reverse_link_offsets;
+	StdVector<uint32_t> reverse_links;
+
+	// If `reverse` is true, costs are those of travelling from cells to the origin
+	void run(AStarGrid3D &rules, Box3i p_box, Vector3i origin, bool reverse, float max_cost) {
+		ZN_PROFILE_SCOPE();
+
+		box = p_box;
+		const unsigned int volume = Vector3iUtil::get_volume(box.size);
+		costs.clear();
+		costs.resize(volume, INFINITE_COST);
+		links.clear();
+		links.resize(volume, NO_LINK);
+		heap.clear();
+
+		if (!box.contains(origin)) {
+			return;
+		}
+
+		if (reverse) {
+			build_reverse_links(rules);
+		}
+
+		const std::greater<std::pair<float, uint32_t>> compare;
+
+		const uint32_t origin_index = get_index(origin);
+		costs[origin_index] = 0.f;
+		heap.push_back(std::make_pair(0.f, origin_index));
+
+		while (heap.size() > 0) {
+			std::pop_heap(heap.begin(), heap.end(), compare);
+			const std::pair<float, uint32_t> item = heap.back();
+			heap.pop_back();
+
+			const float cost = item.first;
+			const uint32_t index = item.second;
+			if (cost > costs[index]) {
+				// Outdated
+				continue;
+			}
+
+			const Vector3i pos = box.position + Vector3iUtil::from_zxy_index(index, box.size);
+
+			neighbors.clear();
+			if (reverse) {
+				for (uint32_t i = reverse_link_offsets[index]; i < reverse_link_offsets[index + 1]; ++i) {
+					neighbors.push_back(box.position + Vector3iUtil::from_zxy_index(reverse_links[i], box.size));
+				}
+			} else {
+				rules.get_neighbor_positions(pos, neighbors);
+			}
+
+			for (const Vector3i npos : neighbors) {
+				if (!box.contains(npos)) {
+					continue;
+				}
+				const float ncost = cost + AStarGrid3D::get_step_cost(pos, npos);
+				const uint32_t nindex = get_index(npos);
+				if (ncost < costs[nindex] && ncost < max_cost) {
+					costs[nindex] = ncost;
+					links[nindex] = index;
+					heap.push_back(std::make_pair(ncost, nindex));
+					std::push_heap(heap.begin(), heap.end(), compare);
+				}
+			}
+		}
+	}
+
+	void build_reverse_links(AStarGrid3D &rules) {
+		ZN_PROFILE_SCOPE();
+
+		const unsigned int volume = Vector3iUtil::get_volume(box.size);
+		StdVector<std::pair<uint32_t, uint32_t>> moves;
+
+		for (unsigned int index = 0; index < volume; ++index) {
+			const Vector3i pos = box.position + Vector3iUtil::from_zxy_index(index, box.size);
+			if (rules.is_solid(pos)) {
+				continue;
+			}
+			neighbors.clear();
+			rules.get_neighbor_positions(pos, neighbors);
+			for (const Vector3i npos : neighbors) {
+				if (box.contains(npos)) {
+					moves.push_back(std::make_pair(get_index(npos), index));
+				}
+			}
+		}
+
+		reverse_link_offsets.clear();
+		reverse_link_offsets.resize(volume + 1, 0);
+		for (const std::pair<uint32_t, uint32_t> &move : moves) {
+			++reverse_link_offsets[move.first + 1];
+		}
+		for (unsigned int i = 0; i < volume; ++i) {
+			reverse_link_offsets[i + 1] += reverse_link_offsets[i];
+		}
+		reverse_links.resize(moves.size());
+		StdVector<uint32_t> fill_counts;
+		fill_counts.resize(volume, 0);
+		for (const std::pair<uint32_t, uint32_t> &move : moves) {
+			reverse_links[reverse_link_offsets[move.first] + fill_counts[move.first]] = move.second;
+			++fill_counts[move.first];
+		}
+	}
+
+	inline uint32_t get_index(Vector3i pos) const {
+		return Vector3iUtil::get_zxy_index(pos - box.position, box.size);
+	}
+
+	float get_cost(Vector3i pos) const {
+		if (!box.contains(pos)) {
+			return INFINITE_COST;
+		}
+		return costs[get_index(pos)];
+	}
+
+	// Forward search: appends cells from the origin to `pos`, excluding the origin and including `pos`
+	void get_path_to(Vector3i pos, StdVector<Vector3i> &out_path) const {
+		const size_t begin = out_path.size();
+		uint32_t index = get_index(pos);
+		while (links[index] != NO_LINK) {
+			out_path.push_back(box.position + Vector3iUtil::from_zxy_index(index, box.size));
+			index = links[index];
+		}
+		std::reverse(out_path.begin() + begin, out_path.end());
+	}
+
+	// Reverse search: appends cells from `pos` to the origin, excluding `pos` and including the origin
+	void get_path_from(Vector3i pos, StdVector<Vector3i> &out_path) const {
+		uint32_t index = links[get_index(pos)];
+		while (index != NO_LINK) {
+			out_path.push_back(box.position + Vector3iUtil::from_zxy_index(index, box.size));
+			index = links[index];
+		}
+	}
+};
+
+struct Transition {
+	Vector3i from_position;
+	Vector3i to_position;
+};
+
+// Finds moves going from a box to another
+void gather_transitions(AStarGrid3D &rules, Box3i src_box, Box3i dst_box, StdVector<Transition> &out_transitions) {
+	// Only cells close to the destination can reach it in one step
+	const Box3i sources_box = src_box.clipped(dst_box.padded(1));
+	StdVector<Vector3i> neighbors;
+
+	sources_box.for_each_cell_zxy([&rules, dst_box, &neighbors, &out_transitions](Vector3i pos) {
+		if (!rules.is_walkable(pos)) {
+			return;
+		}
+		neighbors.clear();
+		rules.get_neighbor_positions(pos, neighbors);
+		for (const Vector3i npos : neighbors) {
+			if (dst_box.contains(npos)) {
+				out_transitions.push_back(Transition{ pos, npos });
+			}
+		}
+	});
+}
+
+// Groups adjacent transitions and picks one in every group. The result only depends on the input, so clusters on
+// both sides of a border find the same portals.
+void pick_portals(Span<const Transition> transitions, StdVector<Transition> &out_portals) {
+	StdVector<uint8_t> grouped;
+	grouped.resize(transitions.size(), 0);
+	StdVector<uint32_t> group;
+	StdVector<uint32_t> stack;
+
+	for (unsigned int first = 0; first < transitions.size(); ++first) {
+		if (grouped[first] != 0) {
+			continue;
+		}
+
+		group.clear();
+		stack.clear();
+		stack.push_back(first);
+		grouped[first] = 1;
+
+		while (stack.size() > 0) {
+			const uint32_t i = stack.back();
+			stack.pop_back();
+			group.push_back(i);
+			const Transition &t = transitions[i];
+
+			for (unsigned int j = first + 1; j < transitions.size(); ++j) {
+				if (grouped[j] != 0) {
+					continue;
+				}
+				const Transition &other = transitions[j];
+				if (get_chebyshev_distance(t.from_position, other.from_position) <= 1 &&
+					get_chebyshev_distance(t.to_position, other.to_position) <= 1) {
+					grouped[j] = 1;
+					stack.push_back(j);
+				}
+			}
+		}
+
+		// Pick the transition closest to the middle of the group
+		Vector3f center;
+		for (const uint32_t i : group) {
+			center += to_vec3f(transitions[i].from_position);
+		}
+		center /= float(group.size());
+
+		uint32_t best_index = group[0];
+		float best_distance_squared = INFINITE_COST;
+		for (const uint32_t i : group) {
+			const float d = math::distance_squared(center, to_vec3f(transitions[i].from_position));
+			// Indices are compared too, because the order of the group depends on the traversal
+			if (d < best_distance_squared || (d == best_distance_squared && i < best_index)) {
+				best_distance_squared = d;
+				best_index = i;
+			}
+		}
+
+		out_portals.push_back(transitions[best_index]);
+	}
+}
+
+Box3i get_cluster_box(Vector3i cluster_position, unsigned int block_size_po2, const Box3i &region) {
+	return Box3i(cluster_position << block_size_po2, Vector3iUtil::create(1 << block_size_po2)).clipped(region);
+}
+
+template <typename TMap>
+void erase_in_box(TMap &map, Box3i box) {
+	if (Vector3iUtil::get_volume(box.size) > static_cast<int64_t>(map.size())) {
+		for (auto it = map.begin(); it != map.end();) {
+			if (box.contains(it->first)) {
+				it = map.erase(it);
+			} else {
+				++it;
+			}
+		}
+	} else {
+		box.for_each_cell([&map](Vector3i pos) { //
+			map.erase(pos);
+		});
+	}
+}
+
+} // namespace
+
+VoxelNavigationCache::VoxelNavigationCache(std::shared_ptr<VoxelData> data) : _data(data) {
+	ZN_ASSERT(_data != nullptr);
+	_block_size_po2 = _data->get_block_size_po2();
+}
+
+void VoxelNavigationCache::set_rules(const AStarGrid3D &rules) {
+	clear();
+
+	_region = rules.get_region();
+
+	const Vector3f agent_size = rules.get_agent_size();
+	const float agent_extent = math::max(agent_size.x, math::max(agent_size.y, agent_size.z));
+	_cluster_margin = static_cast<int>(Math::ceil(agent_extent)) + rules.get_max_fall_height() + 2;
+}
+
+std::shared_ptr<VoxelNavigationCache::SolidBlock> VoxelNavigationCache::load_solid_block(Vector3i block_position
+) const {
+	ZN_PROFILE_SCOPE();
+
+	const int block_size = 1 << _block_size_po2;
+	const VoxelBuffer::ChannelId channel_index = VoxelBuffer::CHANNEL_TYPE;
+
+	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_POOL);
+	voxels.create(Vector3iUtil::create(block_size));
+	_data->copy(block_position << _block_size_po2, voxels, 1 << channel_index);
+
+	std::shared_ptr<SolidBlock> block = make_shared_instance<SolidBlock>();
+	DynamicBitset &bits = block->bits;
+	bits.resize_no_init(Vector3iUtil::get_volume(voxels.get_size()));
+
+	if (voxels.get_channel_compression(channel_index) == VoxelBuffer::COMPRESSION_UNIFORM) {
+		bits.fill(voxels.get_voxel(0, 0, 0, channel_index) != 0);
+		return block;
+	}
+
+	switch (voxels.get_channel_depth(channel_index)) {
+		case VoxelBuffer::DEPTH_8_BIT: {
+			Span<const uint8_t> values;
+			ZN_ASSERT(voxels.get_channel_data(channel_index, values));
+			// Assuming ZXY order
+			for (unsigned int i = 0; i < values.size(); ++i) {
+				bits.set(i, values[i] != 0);
+			}
+		} break;
+
+		case VoxelBuffer::DEPTH_16_BIT: {
+			Span<const uint16_t> values;
+			ZN_ASSERT(voxels.get_channel_data(channel_index, values));
+			for (unsigned int i = 0; i < values.size(); ++i) {
+				bits.set(i, values[i] != 0);
+			}
+		} break;
+
+		default: {
+			const Vector3i size = voxels.get_size();
+			Vector3i pos;
+			for (pos.z = 0; pos.z < size.z; ++pos.z) {
+				for (pos.x = 0; pos.x < size.x; ++pos.x) {
+					for (pos.y = 0; pos.y < size.y; ++pos.y) {
+						bits.set(Vector3iUtil::get_zxy_index(pos, size), voxels.get_voxel(pos, channel_index) != 0);
+					}
+				}
+			}
+		} break;
+	}
+
+	return block;
+}
+
+std::shared_ptr<const VoxelNavigationCache::SolidBlock> VoxelNavigationCache::get_solid_block(Vector3i block_position
+) {
+	{
+		RWLockRead rlock(_rw_lock);
+		auto it = _solid_blocks.find(block_position);
+		if (it != _solid_blocks.end()) {
+			return it->second;
+		}
+	}
+
+	// Computed without locking, so other searches are not blocked meanwhile
+	const uint32_t edit_version = _edit_version;
+	std::shared_ptr<const SolidBlock> block = load_solid_block(block_position);
+
+	RWLockWrite wlock(_rw_lock);
+	if (edit_version != _edit_version) {
+		// Voxels might have changed while we were reading them
+		return block;
+	}
+	// Another thread might have inserted it first
+	auto p = _solid_blocks.insert({ block_position, block });
+	return p.first->second;
+}
+
+std::shared_ptr<VoxelNavigationCache::Cluster> VoxelNavigationCache::build_cluster(
+		Vector3i cluster_position,
+		AStarGrid3D &rules
+) const {
+	ZN_PROFILE_SCOPE();
+
+	std::shared_ptr<Cluster> cluster = make_shared_instance<Cluster>();
+
+	const Box3i box = get_cluster_box(cluster_position, _block_size_po2, _region);
+	if (box.is_empty()) {
+		return cluster;
+	}
+
+	// Portals
+
+	StdVector<Transition> inter_edges;
+	StdVector<Transition> transitions;
+	StdVector<Transition> portals;
+
+	auto add_node = [&cluster](Vector3i pos) {
+		if (cluster->node_indices.find(pos) == cluster->node_indices.end()) {
+			cluster->node_indices.insert({ pos, cluster->nodes.size() });
+			cluster->nodes.push_back(Cluster::Node{ pos, 0, 0 });
+		}
+	};
+
+	for (const Vector3i offset : g_cluster_neighbor_offsets) {
+		const Box3i neighbor_box = get_cluster_box(cluster_position + offset, _block_size_po2, _region);
+		if (neighbor_box.is_empty()) {
+			continue;
+		}
+
+		// Going out
+		transitions.clear();
+		portals.clear();
+		gather_transitions(rules, box, neighbor_box, transitions);
+		pick_portals(to_span(transitions), portals);
+		for (const Transition &portal : portals) {
+			add_node(portal.from_position);
+			inter_edges.push_back(portal);
+		}
+
+		// Coming in. The neighbor cluster finds the same portals when going out.
+		transitions.clear();
+		portals.clear();
+		gather_transitions(rules, neighbor_box, box, transitions);
+		pick_portals(to_span(transitions), portals);
+		for (const Transition &portal : portals) {
+			add_node(portal.to_position);
+		}
+	}
+
+	// Edges
+
+	StdVector<StdVector<Cluster::Edge>> node_edges;
+	node_edges.resize(cluster->nodes.size());
+
+	for (const Transition &t : inter_edges) {
+		const uint32_t node_index = cluster->node_indices[t.from_position];
+		const uint32_t path_begin = cluster->paths.size();
+		cluster->paths.push_back(t.to_position);
+		const float cost = AStarGrid3D::get_step_cost(t.from_position, t.to_position);
+		node_edges[node_index].push_back(Cluster::Edge{ t.to_position, cost, path_begin, 1 });
+	}
+
+	LocalSearch search;
+
+	for (unsigned int node_index = 0; node_index < cluster->nodes.size(); ++node_index) {
+		const Vector3i node_pos = cluster->nodes[node_index].position;
+		search.run(rules, box, node_pos, false, INFINITE_COST);
+
+		for (unsigned int other_index = 0; other_index < cluster->nodes.size(); ++other_index) {
+			if (other_index == node_index) {
+				continue;
+			}
+			const Vector3i other_pos = cluster->nodes[other_index].position;
+			const float cost = search.get_cost(other_pos);
+			if (cost == INFINITE_COST) {
+				continue;
+			}
+			const uint32_t path_begin = cluster->paths.size();
+			search.get_path_to(other_pos, cluster->paths);
+			const uint32_t path_size = cluster->paths.size() - path_begin;
+			node_edges[node_index].push_back(Cluster::Edge{ other_pos, cost, path_begin, path_size });
+		}
+	}
+
+	for (unsigned int node_index = 0; node_index < cluster->nodes.size(); ++node_index) {
+		Cluster::Node &node = cluster->nodes[node_index];
+		const StdVector<Cluster::Edge> &edges = node_edges[node_index];
+		node.edges_begin = cluster->edges.size();
+		node.edges_count = edges.size();
+		cluster->edges.insert(cluster->edges.end(), edges.begin(), edges.end());
+	}
+
+	return cluster;
+}
+
+std::shared_ptr<const VoxelNavigationCache::Cluster> VoxelNavigationCache::get_cluster(
+		Vector3i cluster_position,
+		AStarGrid3D &rules
+) {
+	{
+		RWLockRead rlock(_rw_lock);
+		auto it = _clusters.find(cluster_position);
+		if (it != _clusters.end()) {
+			return it->second;
+		}
+	}
+
+	const uint32_t edit_version = _edit_version;
+	std::shared_ptr<const Cluster> cluster = build_cluster(cluster_position, rules);
+
+	RWLockWrite wlock(_rw_lock);
+	if (edit_version != _edit_version) {
+		return cluster;
+	}
+	auto p = _clusters.insert({ cluster_position, cluster });
+	return p.first->second;
+}
+
+bool VoxelNavigationCache::find_path(
+		AStarGrid3D &rules,
+		Context &context,
+		Vector3i from_position,
+		Vector3i to_position,
+		StdVector<Vector3i> &out_path
+) {
+	ZN_PROFILE_SCOPE();
+
+	out_path.clear();
+
+	if (!_region.contains(from_position) || !_region.contains(to_position)) {
+		return false;
+	}
+
+	const Vector3i from_cluster_position = from_position >> _block_size_po2;
+	const Vector3i to_cluster_position = to_position >> _block_size_po2;
+
+	if (from_cluster_position == to_cluster_position) {
+		// Close enough for a regular search
+		rules.start(from_position, to_position);
+		while (rules.is_running()) {
+			rules.step();
+		}
+		Span<const Vector3i> path = rules.get_path();
+		out_path.insert(out_path.end(), path.begin(), path.end());
+		return path.size() > 0 || from_position == to_position;
+	}
+
+	const float max_cost = rules.get_max_path_cost();
+
+	// Connect the start and destination to portals of their clusters
+	LocalSearch start_search;
+	start_search.run(
+			rules,
+			get_cluster_box(from_cluster_position, _block_size_po2, _region),
+			from_position,
+			false,
+			max_cost
+	);
+	LocalSearch goal_search;
+	goal_search.run(
+			rules, get_cluster_box(to_cluster_position, _block_size_po2, _region), to_position, true, max_cost
+	);
+
+	// Search the graph of portals
+
+	enum LinkType : uint8_t { //
+		LINK_NONE,
+		LINK_START,
+		LINK_EDGE,
+		LINK_GOAL
+	};
+
+	struct Point {
+		Vector3i position;
+		float gscore;
+		uint32_t came_from;
+		LinkType link_type;
+		bool closed;
+		// Set if the point was reached with `LINK_EDGE`
+		const Cluster *cluster;
+		const Cluster::Edge *edge;
+	};
+
+	StdVector<Point> points;
+	StdUnorderedMap<Vector3i, uint32_t> point_indices;
+	StdVector<std::pair<float, uint32_t>> open_list;
+	const std::greater<std::pair<float, uint32_t>> compare;
+
+	auto visit = [&](uint32_t from_index,
+					 Vector3i pos,
+					 float edge_cost,
+					 LinkType link_type,
+					 const Cluster *cluster,
+					 const Cluster::Edge *edge) {
+		const float gscore = points[from_index].gscore + edge_cost;
+		if (gscore >= max_cost) {
+			return;
+		}
+		uint32_t index;
+		auto it = point_indices.find(pos);
+		if (it == point_indices.end()) {
+			index = points.size();
+			points.push_back(Point{ pos, INFINITE_COST, 0, LINK_NONE, false, nullptr, nullptr });
+			point_indices.insert({ pos, index });
+		} else {
+			index = it->second;
+		}
+		Point &point = points[index];
+		if (point.closed || gscore >= point.gscore) {
+			return;
+		}
+		point.gscore = gscore;
+		point.came_from = from_index;
+		point.link_type = link_type;
+		point.cluster = cluster;
+		point.edge = edge;
+		open_list.push_back(std::make_pair(gscore + rules.evaluate_heuristic(pos, to_position), index));
+		std::push_heap(open_list.begin(), open_list.end(), compare);
+	};
+
+	points.push_back(Point{ from_position, 0.f, 0, LINK_NONE, false, nullptr, nullptr });
+	point_indices.insert({ from_position, 0 });
+	open_list.push_back(std::make_pair(rules.evaluate_heuristic(from_position, to_position), 0));
+
+	while (open_list.size() > 0) {
+		std::pop_heap(open_list.begin(), open_list.end(), compare);
+		const uint32_t point_index = open_list.back().second;
+		open_list.pop_back();
+
+		if (points[point_index].closed) {
+			// Outdated
+			continue;
+		}
+		points[point_index].closed = true;
+		const Vector3i pos = points[point_index].position;
+
+		if (pos == to_position) {
+			// Found, collect cells along the path
+			StdVector<uint32_t> chain;
+			for (uint32_t i = point_index; i != 0; i = points[i].came_from) {
+				chain.push_back(i);
+			}
+			out_path.push_back(from_position);
+			for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+				const Point &point = points[*it];
+				switch (point.link_type) {
+					case LINK_START:
+						start_search.get_path_to(point.position, out_path);
+						break;
+					case LINK_EDGE: {
+						Span<const Vector3i> cells =
+								to_span(point.cluster->paths).sub(point.edge->path_begin, point.edge->path_size);
+						out_path.insert(out_path.end(), cells.begin(), cells.end());
+					} break;
+					case LINK_GOAL:
+						goal_search.get_path_from(points[point.came_from].position, out_path);
+						break;
+					default:
+						ZN_PRINT_ERROR("Unexpected link");
+						break;
+				}
+			}
+			// Same as `AStarGrid3D`, the destination is not included
+			out_path.pop_back();
+			return true;
+		}
+
+		const Vector3i cluster_position = pos >> _block_size_po2;
+
+		if (point_index == 0) {
+			const Cluster &start_cluster = context.get_cluster(*this, cluster_position, rules);
+			for (const Cluster::Node &node : start_cluster.nodes) {
+				const float cost = start_search.get_cost(node.position);
+				if (node.position != from_position && cost != INFINITE_COST) {
+					visit(point_index, node.position, cost, LINK_START, nullptr, nullptr);
+				}
+			}
+		}
+
+		const Cluster &cluster = context.get_cluster(*this, cluster_position, rules);
+		const Cluster::Node *node = cluster.find_node(pos);
+		if (node != nullptr) {
+			for (unsigned int i = 0; i < node->edges_count; ++i) {
+				const Cluster::Edge &edge = cluster.edges[node->edges_begin + i];
+				visit(point_index, edge.to_position, edge.cost, LINK_EDGE, &cluster, &edge);
+			}
+		}
+
+		if (cluster_position == to_cluster_position) {
+			const float cost = goal_search.get_cost(pos);
+			if (cost != INFINITE_COST) {
+				visit(point_index, to_position, cost, LINK_GOAL, nullptr, nullptr);
+			}
+		}
+	}
+
+	return false;
+}
+
+void VoxelNavigationCache::clear() {
+	RWLockWrite wlock(_rw_lock);
+	++_edit_version;
+	_solid_blocks.clear();
+	_clusters.clear();
+}
+
+void VoxelNavigationCache::on_area_edited(Box3i box_in_voxels) {
+	ZN_PROFILE_SCOPE();
+	const int block_size = 1 << _block_size_po2;
+	RWLockWrite wlock(_rw_lock);
+	++_edit_version;
+	erase_in_box(_solid_blocks, box_in_voxels.downscaled(block_size));
+	// Clusters also depend on voxels around them
+	erase_in_box(_clusters, box_in_voxels.padded(_cluster_margin).downscaled(block_size));
+}
+
+unsigned int VoxelNavigationCache::get_cluster_count() const {
+	RWLockRead rlock(_rw_lock);
+	return _clusters.size();
+}
+
+// Context
+
+bool VoxelNavigationCache::Context::is_solid(VoxelNavigationCache &cache, Vector3i pos) {
+	const unsigned int block_size_po2 = cache.get_block_size_po2();
+	const Vector3i block_position = pos >> block_size_po2;
+
+	if (_last_solid_block == nullptr || block_position != _last_solid_block_position) {
+		auto it = _solid_blocks.find(block_position);
+		if (it == _solid_blocks.end()) {
+			it = _solid_blocks.insert({ block_position, cache.get_solid_block(block_position) }).first;
+		}
+		_last_solid_block = it->second.get();
+		_last_solid_block_position = block_position;
+	}
+
+	const int block_size = 1 << block_size_po2;
+	const Vector3i rpos = pos - (block_position << block_size_po2);
+	return _last_solid_block->bits.get(Vector3iUtil::get_zxy_index(rpos, Vector3iUtil::create(block_size)));
+}
+
+const VoxelNavigationCache::Cluster &VoxelNavigationCache::Context::get_cluster(
+		VoxelNavigationCache &cache,
+		Vector3i cluster_position,
+		AStarGrid3D &rules
+) {
+	auto it = _clusters.find(cluster_position);
+	if (it == _clusters.end()) {
+		std::shared_ptr<const Cluster> cluster = cache.get_cluster(cluster_position, rules);
+		it = _clusters.insert({ cluster_position, cluster }).first;
+	}
+	return *it->second;
+}
+
+void VoxelNavigationCache::Context::clear() {
+	_solid_blocks.clear();
+	_clusters.clear();
+	_last_solid_block = nullptr;
+}
+
+} // namespace zylann::voxel
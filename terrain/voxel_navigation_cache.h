@@ -0,0 +1,130 @@
+#ifndef VOXEL_NAVIGATION_CACHE_H
+#define VOXEL_NAVIGATION_CACHE_H
+
+#include "../util/a_star_grid_3d.h"
+#include "../util/containers/dynamic_bitset.h"
+#include "../util/containers/span.h"
+#include "../util/containers/std_unordered_map.h"
+#include "../util/containers/std_vector.h"
+#include "../util/math/box3i.h"
+#include "../util/thread/rw_lock.h"
+#include "area_edit_listener.h"
+#include <atomic>
+#include <memory>
+
+namespace zylann::voxel {
+
+class VoxelData;
+
+// Navigation data derived from the voxels of a region, cached so it can be shared by path searches running on any
+// thread. Space is divided in clusters matching data blocks. For each of them, the cache stores which voxels are
+// solid, and a graph of portals connecting the cluster to its neighbors, allowing hierarchical searches (HPA*).
+// Data is computed lazily when searches need it, and dropped when the voxels it depends on are edited.
+class VoxelNavigationCache : public IAreaEditListener {
+public:
+	// Solid voxels of a block, in ZXY order
+	struct SolidBlock {
+		DynamicBitset bits;
+	};
+
+	struct Cluster {
+		struct Edge {
+			Vector3i to_position;
+			float cost;
+			// Cells travelled along the edge in `paths`, excluding the origin and including the destination
+			uint32_t path_begin;
+			uint32_t path_size;
+		};
+
+		struct Node {
+			Vector3i position;
+			uint32_t edges_begin;
+			uint32_t edges_count;
+		};
+
+		// Cells of the cluster from which agents can go to, or come from, a neighbor cluster
+		StdVector<Node> nodes;
+		StdVector<Edge> edges;
+		StdVector<Vector3i> paths;
+		StdUnorderedMap<Vector3i, uint32_t> node_indices;
+
+		const Node *find_node(Vector3i position) const {
+			auto it = node_indices.find(position);
+			if (it == node_indices.end()) {
+				return nullptr;
+			}
+			return &nodes[it->second];
+		}
+	};
+
+	// Caches references obtained during a search, so the cache is locked only once per block. It also keeps them
+	// valid if they get dropped by an edit in the meantime. Not thread-safe, each search must have its own.
+	class Context {
+	public:
+		bool is_solid(VoxelNavigationCache &cache, Vector3i pos);
+		const Cluster &get_cluster(VoxelNavigationCache &cache, Vector3i cluster_position, AStarGrid3D &rules);
+		void clear();
+
+	private:
+		StdUnorderedMap<Vector3i, std::shared_ptr<const SolidBlock>> _solid_blocks;
+		StdUnorderedMap<Vector3i, std::shared_ptr<const Cluster>> _clusters;
+		const SolidBlock *_last_solid_block = nullptr;
+		Vector3i _last_solid_block_position;
+	};
+
+	VoxelNavigationCache(std::shared_ptr<VoxelData> data);
+
+	// Takes the region and agent settings of `rules`, and clears the cache. Must not be called while searches are
+	// running.
+	void set_rules(const AStarGrid3D &rules);
+
+	std::shared_ptr<const SolidBlock> get_solid_block(Vector3i block_position);
+	// `rules` must have the same region as the cache, and use it to get solid voxels.
+	std::shared_ptr<const Cluster> get_cluster(Vector3i cluster_position, AStarGrid3D &rules);
+
+	// Finds a path going through portals of clusters. Paths can be longer than optimal paths, but searching is much
+	// cheaper over long distances, because clusters are only computed once. Paths start with `from_position` and
+	// end with the position preceding `to_position`, like `AStarGrid3D`.
+	// `rules` must have the same region as the cache, and use `context` to get solid voxels.
+	bool find_path(
+			AStarGrid3D &rules,
+			Context &context,
+			Vector3i from_position,
+			Vector3i to_position,
+			StdVector<Vector3i> &out_path
+	);
+
+	void clear();
+
+	void on_area_edited(Box3i box_in_voxels) override;
+
+	inline const Box3i &get_region() const {
+		return _region;
+	}
+
+	inline unsigned int get_block_size_po2() const {
+		return _block_size_po2;
+	}
+
+	unsigned int get_cluster_count() const;
+
+private:
+	std::shared_ptr<SolidBlock> load_solid_block(Vector3i block_position) const;
+	std::shared_ptr<Cluster> build_cluster(Vector3i cluster_position, AStarGrid3D &rules) const;
+
+	const std::shared_ptr<VoxelData> _data;
+	Box3i _region;
+	unsigned int _block_size_po2;
+
+	RWLock _rw_lock;
+	StdUnorderedMap<Vector3i, std::shared_ptr<const SolidBlock>> _solid_blocks;
+	StdUnorderedMap<Vector3i, std::shared_ptr<const Cluster>> _clusters;
+	// Incremented on every edit, so data computed from voxels that changed in the meantime doesn't get cached
+	std::atomic_uint32_t _edit_version = { 0 };
+	// Clusters depend on voxels of their neighbors up to this distance
+	int _cluster_margin = 0;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_NAVIGATION_CACHE_H
@@ -5,14 +5,17 @@
 #include "util/test_box3i.h"
 #include "util/test_container_funcs.h"
 #include "util/test_expression_parser.h"
+#include "util/test_fast_noise_lite.h"
 #include "util/test_flat_map.h"
 #include "util/test_island_finder.h"
 #include "util/test_math_funcs.h"
 #include "util/test_slot_map.h"
 #include "util/test_spatial_lock.h"
+#include "util/test_spot_noise.h"
 #include "util/test_string_funcs.h"
 #include "util/test_threaded_task_runner.h"
 
+#include "voxel/test_block_replication.h"
 #include "voxel/test_block_serializer.h"
 #include "voxel/test_curve_range.h"
 #include "voxel/test_detail_rendering_gpu.h"
@@ -20,13 +23,20 @@
 #include "voxel/test_mesh_sdf.h"
 #include "voxel/test_octree.h"
 #include "voxel/test_region_file.h"
+#include "voxel/test_simple_generators.h"
 #include "voxel/test_storage_funcs.h"
 #include "voxel/test_stream_sqlite.h"
+#include "voxel/test_vox_data.h"
+#include "voxel/test_voxel_box_mover.h"
 #include "voxel/test_voxel_buffer.h"
 #include "voxel/test_voxel_data_map.h"
+#include "voxel/test_voxel_generator_image.h"
+#include "voxel/test_voxel_generator_multipass.h"
 #include "voxel/test_voxel_graph.h"
 #include "voxel/test_voxel_instancer.h"
+#include "voxel/test_voxel_mesher_blocky.h"
 #include "voxel/test_voxel_mesher_cubes.h"
+#include "voxel/test_voxel_navigation_cache.h"
 
 #ifdef VOXEL_ENABLE_FAST_NOISE_2
 #include "fast_noise_2/test_fast_noise_2.h"
@@ -56,14 +66,19 @@ void run_voxel_tests() {
 	VOXEL_TEST(test_voxel_data_map_paste_fill);
 	VOXEL_TEST(test_voxel_data_map_paste_mask);
 	VOXEL_TEST(test_voxel_data_map_copy);
+	VOXEL_TEST(test_voxel_data_map_concurrent_lookups);
 	VOXEL_TEST(test_encode_weights_packed_u16);
 	VOXEL_TEST(test_copy_3d_region_zxy);
 	VOXEL_TEST(test_voxel_graph_invalid_connection);
 	VOXEL_TEST(test_voxel_graph_generator_default_graph_compilation);
 	VOXEL_TEST(test_voxel_graph_sphere_on_plane);
+	VOXEL_TEST(test_voxel_graph_generate_single_batch);
 	VOXEL_TEST(test_voxel_graph_clamp_simplification);
 	VOXEL_TEST(test_voxel_graph_generator_expressions);
 	VOXEL_TEST(test_voxel_graph_generator_expressions_2);
+	VOXEL_TEST(test_voxel_graph_expression_kernel_benchmark);
+	VOXEL_TEST(test_voxel_graph_expression_kernel_equivalence);
+	VOXEL_TEST(test_voxel_graph_powi_non_constant);
 	VOXEL_TEST(test_voxel_graph_generator_texturing);
 	VOXEL_TEST(test_voxel_graph_equivalence_merging);
 	VOXEL_TEST(test_voxel_graph_generate_block_with_input_sdf);
@@ -90,13 +105,26 @@ void run_voxel_tests() {
 	VOXEL_TEST(test_voxel_graph_many_subdivisions);
 	VOXEL_TEST(test_voxel_graph_non_square_image);
 	VOXEL_TEST(test_voxel_graph_4_default_weights);
+	VOXEL_TEST(test_image_sampler);
+	VOXEL_TEST(test_voxel_generator_image);
+	VOXEL_TEST(test_voxel_generator_image_non_power_of_two);
+	VOXEL_TEST(test_voxel_generator_multipass_column_persistence);
+	VOXEL_TEST(test_voxel_generator_multipass_column_cache_eviction);
+	VOXEL_TEST(test_voxel_generator_multipass_waiting_tasks);
+	VOXEL_TEST(test_voxel_generator_multipass_map_concurrent_lookups);
+	VOXEL_TEST(test_voxel_generator_flat_single);
+	VOXEL_TEST(test_voxel_generator_noise_single);
+	VOXEL_TEST(test_voxel_generator_noise_2d_single);
+	VOXEL_TEST(test_voxel_generator_image_single);
+	VOXEL_TEST(test_voxel_generator_waves_single);
 	VOXEL_TEST(test_island_finder);
+	VOXEL_TEST(test_island_finder_slabs);
 	VOXEL_TEST(test_unordered_remove_if);
 	VOXEL_TEST(test_instance_data_serialization);
 	VOXEL_TEST(test_transform_3d_array_zxy);
 	VOXEL_TEST(test_octree_update);
 	VOXEL_TEST(test_octree_find_in_box);
-	VOXEL_TEST(test_get_curve_monotonic_sections);
+	VOXEL_TEST(test_curve_lut);
 	VOXEL_TEST(test_voxel_buffer_create);
 	VOXEL_TEST(test_block_serializer);
 	VOXEL_TEST(test_block_serializer_stream_peer);
@@ -107,11 +135,25 @@ void run_voxel_tests() {
 	VOXEL_TEST(test_fast_noise_2_empty_encoded_node_tree);
 #endif
 	VOXEL_TEST(test_run_blocky_random_tick);
+	VOXEL_TEST(test_run_blocky_random_tick_uniform_blocks);
 	VOXEL_TEST(test_flat_map);
 	VOXEL_TEST(test_expression_parser);
 	VOXEL_TEST(test_voxel_buffer_metadata);
 	VOXEL_TEST(test_voxel_buffer_metadata_gd);
+	VOXEL_TEST(test_chunked_voxel_buffer_paste_transformed);
+	VOXEL_TEST(test_voxel_schematic_copy_on_write);
+	VOXEL_TEST(test_voxel_buffer_xor_delta);
+	VOXEL_TEST(test_voxel_buffer_channel_bulk_copy);
+	VOXEL_TEST(test_block_replication_cache);
+	VOXEL_TEST(test_block_replication_scheduling);
+	VOXEL_TEST(test_block_replication_remove_peer);
+	VOXEL_TEST(test_voxel_navigation_cache_hierarchical_path);
+	VOXEL_TEST(test_voxel_navigation_cache_block_changes);
 	VOXEL_TEST(test_voxel_mesher_cubes);
+	VOXEL_TEST(test_vox_data_decode_rotated_model);
+	VOXEL_TEST(test_voxel_mesher_blocky_flat_models);
+	VOXEL_TEST(test_voxel_box_mover_get_motions);
+	VOXEL_TEST(test_voxel_blocky_type_library_bake_types);
 	VOXEL_TEST(test_threaded_task_runner_misc);
 	VOXEL_TEST(test_threaded_task_runner_debug_names);
 	VOXEL_TEST(test_task_priority_values);
@@ -123,12 +165,19 @@ void run_voxel_tests() {
 	VOXEL_TEST(test_spatial_lock_misc);
 	VOXEL_TEST(test_spatial_lock_spam);
 	VOXEL_TEST(test_spatial_lock_dependent_map_chunks);
+	VOXEL_TEST(test_spatial_lock_throughput);
+	VOXEL_TEST(test_fast_noise_lite_series);
+	VOXEL_TEST(test_fast_noise_lite_fill_grid);
+	VOXEL_TEST(test_noise_range_table);
+	VOXEL_TEST(test_spot_noise_series);
+	VOXEL_TEST(test_spot_noise_range);
 	VOXEL_TEST(test_discord_soakil_copypaste);
 	VOXEL_TEST(test_voxel_stream_sqlite_key_string_csd_encoding);
 	VOXEL_TEST(test_voxel_stream_sqlite_key_blob80_encoding);
 	VOXEL_TEST(test_voxel_stream_sqlite_basic);
 	VOXEL_TEST(test_voxel_stream_sqlite_coordinate_format);
 	VOXEL_TEST(test_sdf_hemisphere);
+	VOXEL_TEST(test_interpolated_voxel_sampler);
 
 	print_line("------------ Voxel tests end -------------");
 }
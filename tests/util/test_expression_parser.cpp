@@ -272,6 +272,37 @@ void test_expression_parser() {
 		ZN_TEST_ASSERT(result.error.id == ERROR_EXPECTED_ARGUMENT);
 		ZN_TEST_ASSERT(result.root == nullptr);
 	}
+	{
+		// Constants of nested multiplications are merged
+		UniquePtr<NumberNode> node_six = make_unique_instance<NumberNode>(6);
+		UniquePtr<VariableNode> node_x = make_unique_instance<VariableNode>("x");
+		UniquePtr<OperatorNode> expected_root =
+				make_unique_instance<OperatorNode>(OperatorNode::MULTIPLY, std::move(node_six), std::move(node_x));
+
+		Result result = parse("2*x*3", Span<const Function>());
+		ZN_TEST_ASSERT(result.error.id == ERROR_NONE);
+		ZN_TEST_ASSERT(result.root != nullptr);
+		ZN_TEST_ASSERT(is_tree_equal(*result.root, *expected_root, Span<const Function>()));
+	}
+	{
+		// Operations with no effect are removed
+		Result result = parse("(x^1 + 0) * 1 / 1 - 0", Span<const Function>());
+		ZN_TEST_ASSERT(result.error.id == ERROR_NONE);
+		ZN_TEST_ASSERT(result.root != nullptr);
+		ZN_TEST_ASSERT(result.root->type == Node::VARIABLE);
+	}
+	{
+		// Merged constants can end up having no effect
+		Result result = parse("0.5*x*2 + y^0", Span<const Function>());
+		ZN_TEST_ASSERT(result.error.id == ERROR_NONE);
+		ZN_TEST_ASSERT(result.root != nullptr);
+		ZN_TEST_ASSERT(result.root->type == Node::OPERATOR);
+		const OperatorNode &on = static_cast<OperatorNode &>(*result.root);
+		ZN_TEST_ASSERT(on.op == OperatorNode::ADD);
+		ZN_TEST_ASSERT(on.n0->type == Node::VARIABLE);
+		ZN_TEST_ASSERT(on.n1->type == Node::NUMBER);
+		ZN_TEST_ASSERT(Math::is_equal_approx(static_cast<NumberNode &>(*on.n1).value, 1.f));
+	}
 }
 
 } // namespace zylann::tests
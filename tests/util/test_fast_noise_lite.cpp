@@ -0,0 +1,209 @@
+#include "test_fast_noise_lite.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/math/funcs.h"
+#include "../../util/noise/fast_noise_lite/fast_noise_lite.h"
+#include "../../util/noise/noise_range_table.h"
+#include "../testing.h"
+
+namespace zylann::tests {
+
+namespace {
+
+// Batched queries may use SIMD instructions, which can round slightly differently than scalar code
+const float NOISE_TOLERANCE = 0.0001f;
+
+bool is_close(float a, float b) {
+	return math::abs(a - b) <= NOISE_TOLERANCE;
+}
+
+} // namespace
+
+void test_fast_noise_lite_series() {
+	// Points spread over positive and negative coordinates, with a count that isn't a multiple of SIMD lanes
+	const unsigned int point_count = 1001;
+	StdVector<float> xs;
+	StdVector<float> ys;
+	StdVector<float> zs;
+	for (unsigned int i = 0; i < point_count; ++i) {
+		const float t = static_cast<float>(i);
+		xs.push_back(math::sin(t * 0.37f) * 300.f);
+		ys.push_back(math::cos(t * 0.71f) * 150.f - 20.f);
+		zs.push_back(t * 0.61f - 250.f);
+	}
+	StdVector<float> values;
+	values.resize(point_count);
+
+	const ZN_FastNoiseLite::NoiseType noise_types[] = {
+		ZN_FastNoiseLite::TYPE_OPEN_SIMPLEX_2, //
+		ZN_FastNoiseLite::TYPE_OPEN_SIMPLEX_2S, //
+		ZN_FastNoiseLite::TYPE_CELLULAR, //
+		ZN_FastNoiseLite::TYPE_PERLIN, //
+		ZN_FastNoiseLite::TYPE_VALUE_CUBIC, //
+		ZN_FastNoiseLite::TYPE_VALUE //
+	};
+	const ZN_FastNoiseLite::FractalType fractal_types[] = {
+		ZN_FastNoiseLite::FRACTAL_NONE, //
+		ZN_FastNoiseLite::FRACTAL_FBM, //
+		ZN_FastNoiseLite::FRACTAL_RIDGED, //
+		ZN_FastNoiseLite::FRACTAL_PING_PONG //
+	};
+	const ZN_FastNoiseLite::RotationType3D rotation_types[] = {
+		ZN_FastNoiseLite::ROTATION_3D_NONE, //
+		ZN_FastNoiseLite::ROTATION_3D_IMPROVE_XY_PLANES, //
+		ZN_FastNoiseLite::ROTATION_3D_IMPROVE_XZ_PLANES //
+	};
+
+	for (const ZN_FastNoiseLite::NoiseType noise_type : noise_types) {
+		for (const ZN_FastNoiseLite::FractalType fractal_type : fractal_types) {
+			for (const ZN_FastNoiseLite::RotationType3D rotation_type : rotation_types) {
+				Ref<ZN_FastNoiseLite> noise;
+				noise.instantiate();
+				noise->set_noise_type(noise_type);
+				noise->set_fractal_type(fractal_type);
+				noise->set_rotation_type_3d(rotation_type);
+				noise->set_seed(131183);
+				noise->set_period(37.f);
+				noise->set_fractal_octaves(4);
+				noise->set_fractal_weighted_strength(0.5f);
+
+				noise->get_noise_2d_series(to_span_const(xs), to_span_const(ys), to_span(values));
+				for (unsigned int i = 0; i < point_count; ++i) {
+					const float expected = noise->get_noise_2d(xs[i], ys[i]);
+					ZN_TEST_ASSERT(is_close(values[i], expected));
+				}
+
+				noise->get_noise_3d_series(to_span_const(xs), to_span_const(ys), to_span_const(zs), to_span(values));
+				for (unsigned int i = 0; i < point_count; ++i) {
+					const float expected = noise->get_noise_3d(xs[i], ys[i], zs[i]);
+					ZN_TEST_ASSERT(is_close(values[i], expected));
+				}
+			}
+		}
+	}
+
+	// With domain warp
+	{
+		Ref<ZN_FastNoiseLiteGradient> warp_noise;
+		warp_noise.instantiate();
+		warp_noise->set_amplitude(20.f);
+
+		Ref<ZN_FastNoiseLite> noise;
+		noise.instantiate();
+		noise->set_warp_noise(warp_noise);
+
+		noise->get_noise_2d_series(to_span_const(xs), to_span_const(ys), to_span(values));
+		for (unsigned int i = 0; i < point_count; ++i) {
+			const float expected = noise->get_noise_2d(xs[i], ys[i]);
+			ZN_TEST_ASSERT(is_close(values[i], expected));
+		}
+
+		noise->get_noise_3d_series(to_span_const(xs), to_span_const(ys), to_span_const(zs), to_span(values));
+		for (unsigned int i = 0; i < point_count; ++i) {
+			const float expected = noise->get_noise_3d(xs[i], ys[i], zs[i]);
+			ZN_TEST_ASSERT(is_close(values[i], expected));
+		}
+	}
+}
+
+void test_fast_noise_lite_fill_grid() {
+	Ref<ZN_FastNoiseLite> noise;
+	noise.instantiate();
+	noise->set_period(16.f);
+
+	const float step = 0.5f;
+
+	{
+		const Vector2f origin(-7.f, 3.5f);
+		const Vector2i size(13, 9);
+		StdVector<float> values;
+		values.resize(Vector2iUtil::get_area(size));
+
+		noise->fill_grid_2d(origin, step, size, to_span(values));
+
+		unsigned int i = 0;
+		for (int y = 0; y < size.y; ++y) {
+			for (int x = 0; x < size.x; ++x) {
+				const float expected = noise->get_noise_2d(origin.x + x * step, origin.y + y * step);
+				ZN_TEST_ASSERT(is_close(values[i], expected));
+				++i;
+			}
+		}
+	}
+	{
+		// Larger than the chunk size used internally
+		const Vector3f origin(-10.f, 2.f, 5.5f);
+		const Vector3i size(11, 17, 7);
+		StdVector<float> values;
+		values.resize(Vector3iUtil::get_volume(size));
+
+		noise->fill_grid_3d(origin, step, size, to_span(values));
+
+		unsigned int i = 0;
+		for (int z = 0; z < size.z; ++z) {
+			for (int x = 0; x < size.x; ++x) {
+				for (int y = 0; y < size.y; ++y) {
+					const float expected =
+							noise->get_noise_3d(origin.x + x * step, origin.y + y * step, origin.z + z * step);
+					ZN_TEST_ASSERT(is_close(values[i], expected));
+					++i;
+				}
+			}
+		}
+	}
+}
+
+void test_noise_range_table() {
+	Ref<ZN_FastNoiseLite> noise;
+	noise.instantiate();
+	noise->set_period(64.f);
+	noise->set_fractal_type(ZN_FastNoiseLite::FRACTAL_FBM);
+	noise->set_fractal_octaves(4);
+
+	NoiseRangeTable table;
+	table.generate_3d([&noise](Span<const float> x, Span<const float> y, Span<const float> z, Span<float> out) {
+		noise->get_noise_3d_series(x, y, z, out);
+	});
+
+	const math::Interval full_range = table.get_range();
+	ZN_TEST_ASSERT(full_range.min < full_range.max);
+
+	const auto noise_func = [&noise](float x, float y, float z) { //
+		return noise->get_noise_3d(x, y, z);
+	};
+
+	// Boxes placed away from those used when measuring
+	const unsigned int samples_per_axis = 8;
+	for (const float box_size : { 2.f, 16.f, 128.f }) {
+		for (unsigned int box_index = 0; box_index < 20; ++box_index) {
+			const float t = static_cast<float>(box_index);
+			const Vector3f min_pos(math::sin(t * 1.3f) * 3000.f, t * 37.f - 500.f, math::cos(t * 0.7f) * 2000.f);
+			const math::Interval x(min_pos.x, min_pos.x + box_size);
+			const math::Interval y(min_pos.y, min_pos.y + box_size);
+			const math::Interval z(min_pos.z, min_pos.z + box_size);
+
+			const math::Interval range = table.get_range_3d(noise_func, x, y, z);
+			ZN_TEST_ASSERT(range.min >= full_range.min && range.max <= full_range.max);
+			if (box_size <= 2.f) {
+				// Small boxes should give much tighter bounds than the whole range of the noise
+				ZN_TEST_ASSERT(range.length() < 0.5f * full_range.length());
+			}
+
+			const float step = box_size / static_cast<float>(samples_per_axis - 1);
+			for (unsigned int sz = 0; sz < samples_per_axis; ++sz) {
+				for (unsigned int sy = 0; sy < samples_per_axis; ++sy) {
+					for (unsigned int sx = 0; sx < samples_per_axis; ++sx) {
+						const float v = noise_func(x.min + sx * step, y.min + sy * step, z.min + sz * step);
+						ZN_TEST_ASSERT(range.contains(v));
+					}
+				}
+			}
+		}
+	}
+
+	// Boxes too large to be in the table get the whole range
+	const math::Interval huge(0.f, 2.f * NoiseRangeTable::get_max_box_size());
+	const math::Interval range = table.get_range_3d(noise_func, huge, huge, huge);
+	ZN_TEST_ASSERT(range.min == full_range.min && range.max == full_range.max);
+}
+
+} // namespace zylann::tests
@@ -0,0 +1,12 @@
+#ifndef ZN_TESTS_FAST_NOISE_LITE_H
+#define ZN_TESTS_FAST_NOISE_LITE_H
+
+namespace zylann::tests {
+
+void test_fast_noise_lite_series();
+void test_fast_noise_lite_fill_grid();
+void test_noise_range_table();
+
+} // namespace zylann::tests
+
+#endif // ZN_TESTS_FAST_NOISE_LITE_H
@@ -1,5 +1,6 @@
 #include "test_island_finder.h"
 #include "../../util/containers/std_vector.h"
+#include "../../util/godot/core/random_pcg.h"
 #include "../../util/island_finder.h"
 #include "../testing.h"
 
@@ -84,4 +85,74 @@ void test_island_finder() {
 	ZN_TEST_ASSERT(label_count == 3);
 }
 
+void test_island_finder_slabs() {
+	// Labelling a grid in separate slabs then merging them must give the same islands as labelling it in one go
+
+	const Vector3i grid_size(20, 20, 20);
+	StdVector<uint8_t> grid;
+	grid.resize(Vector3iUtil::get_volume(grid_size), 0);
+
+	// Random boxes, some of which overlap slab boundaries and each other
+	RandomPCG rng;
+	rng.seed(131183);
+	for (unsigned int i = 0; i < 12; ++i) {
+		const Vector3i pos(rng.rand() % 17, rng.rand() % 17, rng.rand() % 17);
+		const Vector3i size(1 + rng.rand() % 3, 1 + rng.rand() % 3, 1 + rng.rand() % 8);
+		Box3i(pos, size).clipped(Box3i(Vector3i(), grid_size)).for_each_cell([&grid, grid_size](Vector3i cpos) {
+			grid[Vector3iUtil::get_zxy_index(cpos, grid_size)] = 1;
+		});
+	}
+
+	auto predicate = [&grid, grid_size](Vector3i pos) {
+		return grid[Vector3iUtil::get_zxy_index(pos, grid_size)] == 1;
+	};
+
+	StdVector<uint8_t> expected_output;
+	expected_output.resize(grid.size());
+	unsigned int expected_label_count = 0;
+	IslandFinder island_finder;
+	island_finder.scan_3d(Box3i(Vector3i(), grid_size), predicate, to_span(expected_output), &expected_label_count);
+
+	StdVector<uint8_t> output;
+	output.resize(grid.size());
+	StdVector<IslandSlabMerger::Slab> slabs;
+	const int slab_begins[] = { 0, 5, 7, 13 };
+	for (const int begin_z : slab_begins) {
+		slabs.push_back(IslandSlabMerger::Slab{ begin_z, 0 });
+	}
+	const unsigned int deck_area = grid_size.x * grid_size.y;
+	for (unsigned int slab_index = 0; slab_index < slabs.size(); ++slab_index) {
+		IslandSlabMerger::Slab &slab = slabs[slab_index];
+		const int end_z = slab_index + 1 < slabs.size() ? slabs[slab_index + 1].begin_z : grid_size.z;
+		const Box3i slab_box(Vector3i(0, 0, slab.begin_z), Vector3i(grid_size.x, grid_size.y, end_z - slab.begin_z));
+		island_finder.scan_3d(
+				slab_box,
+				predicate,
+				to_span(output).sub(slab.begin_z * deck_area, Vector3iUtil::get_volume(slab_box.size)),
+				&slab.label_count
+		);
+	}
+
+	IslandSlabMerger merger;
+	bool overflow = true;
+	const unsigned int label_count = merger.merge(to_span(output), grid_size, to_span_const(slabs), &overflow);
+
+	ZN_TEST_ASSERT(overflow == false);
+	ZN_TEST_ASSERT(label_count == expected_label_count);
+
+	// Labels may not be numbered the same way, but they must describe the same partition
+	StdVector<int> label_mapping;
+	label_mapping.resize(IslandFinder::MAX_ISLANDS, -1);
+	for (unsigned int i = 0; i < output.size(); ++i) {
+		const uint8_t expected_label = expected_output[i];
+		const uint8_t label = output[i];
+		ZN_TEST_ASSERT((expected_label == 0) == (label == 0));
+		if (label_mapping[label] == -1) {
+			label_mapping[label] = expected_label;
+		} else {
+			ZN_TEST_ASSERT(label_mapping[label] == expected_label);
+		}
+	}
+}
+
 } // namespace zylann::tests
@@ -4,6 +4,7 @@
 namespace zylann::tests {
 
 void test_island_finder();
+void test_island_finder_slabs();
 
 } // namespace zylann::tests
 
@@ -1,7 +1,9 @@
 #include "test_spatial_lock.h"
 #include "../../util/containers/std_vector.h"
 #include "../../util/godot/classes/time.h"
+#include "../../util/io/log.h"
 #include "../../util/math/conv.h"
+#include "../../util/math/funcs.h"
 #include "../../util/memory/memory.h"
 #include "../../util/profiling.h"
 #include "../../util/string/format.h"
@@ -438,4 +440,75 @@ void test_spatial_lock_dependent_map_chunks() {
 #endif
 }
 
+void test_spatial_lock_throughput() {
+	// Spawns threads locking random small boxes as fast as they can, spread over a large area like terrain tasks
+	// would, and reports how many lock/unlock pairs per second could be done.
+
+	static const unsigned int OPERATIONS_PER_THREAD = 20000;
+	static const int AREA_SIZE = 64;
+
+	struct Context {
+		SpatialLock3D *spatial_lock;
+		unsigned int thread_index;
+	};
+
+	struct L {
+		static void thread_func(void *userdata) {
+			Context &ctx = *static_cast<Context *>(userdata);
+			SpatialLock3D &spatial_lock = *ctx.spatial_lock;
+
+			RandomPCG rng;
+			rng.seed(ctx.thread_index + 42);
+
+			for (unsigned int i = 0; i < OPERATIONS_PER_THREAD; ++i) {
+				const BoxBounds3i box = BoxBounds3i::from_position_size(
+						Vector3i(rng.rand(AREA_SIZE), rng.rand(AREA_SIZE), rng.rand(AREA_SIZE)),
+						Vector3i(1 + rng.rand(3), 1 + rng.rand(3), 1 + rng.rand(3))
+				);
+				if (rng.rand(100) < 90) {
+					SpatialLock3D::Read srlock(spatial_lock, box);
+				} else {
+					SpatialLock3D::Write swlock(spatial_lock, box);
+				}
+			}
+		}
+	};
+
+	SpatialLock3D spatial_lock;
+	FixedArray<Thread, 7> threads; // Excluding main thread
+	FixedArray<Context, 8> contexts;
+	const unsigned int main_thread_index = contexts.size() - 1;
+
+	for (unsigned int thread_index = 0; thread_index < contexts.size(); ++thread_index) {
+		contexts[thread_index] = Context{ &spatial_lock, thread_index };
+	}
+
+	const uint64_t time_before = Time::get_singleton()->get_ticks_usec();
+
+	for (unsigned int thread_index = 0; thread_index < threads.size(); ++thread_index) {
+		threads[thread_index].start(L::thread_func, &contexts[thread_index]);
+	}
+
+	L::thread_func(&contexts[main_thread_index]);
+
+	for (unsigned int thread_index = 0; thread_index < threads.size(); ++thread_index) {
+		threads[thread_index].wait_to_finish();
+	}
+
+	const uint64_t elapsed_us = math::max(Time::get_singleton()->get_ticks_usec() - time_before, uint64_t(1));
+	const uint64_t operation_count = uint64_t(OPERATIONS_PER_THREAD) * contexts.size();
+	const SpatialLock3D::Stats stats = spatial_lock.get_stats();
+
+	ZN_PRINT_VERBOSE(format(
+			"SpatialLock3D throughput: {} lock/unlock per second ({} threads), {} contended, {} wakeups",
+			operation_count * 1000000 / elapsed_us,
+			contexts.size(),
+			stats.contended_locks,
+			stats.wakeups
+	));
+
+	ZN_TEST_ASSERT(spatial_lock.get_locked_boxes_count() == 0);
+	ZN_TEST_ASSERT(stats.failed_try_locks == 0);
+}
+
 } // namespace zylann::tests
@@ -6,6 +6,7 @@ namespace zylann::tests {
 void test_spatial_lock_misc();
 void test_spatial_lock_spam();
 void test_spatial_lock_dependent_map_chunks();
+void test_spatial_lock_throughput();
 
 } // namespace zylann::tests
 
@@ -0,0 +1,131 @@
+#include "test_spot_noise.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/math/funcs.h"
+#include "../../util/noise/spot_noise.h"
+#include "../testing.h"
+#include <limits>
+
+namespace zylann::tests {
+
+void test_spot_noise_series() {
+	const float cell_size = 8.f;
+	const float jitter = 0.9f;
+	const int seed = 131183;
+
+	// A block of positions spanning a few cells, like the graph generator would query, with a count that isn't a
+	// multiple of SIMD lanes
+	const Vector3i size(13, 11, 9);
+	const Vector3f origin(-20.5f, 3.f, -7.25f);
+	StdVector<float> xs;
+	StdVector<float> ys;
+	StdVector<float> zs;
+	StdVector<float> spot_sizes;
+	for (int z = 0; z < size.z; ++z) {
+		for (int y = 0; y < size.y; ++y) {
+			for (int x = 0; x < size.x; ++x) {
+				xs.push_back(origin.x + x * 1.5f);
+				ys.push_back(origin.y + y * 1.5f);
+				zs.push_back(origin.z + z * 1.5f);
+				// Negative radii behave like positive ones
+				spot_sizes.push_back(math::sin(x + 0.3f * y) * 4.f);
+			}
+		}
+	}
+	// Invalid positions must not cause out-of-bounds accesses
+	xs[5] = std::numeric_limits<float>::quiet_NaN();
+	zs[10] = std::numeric_limits<float>::quiet_NaN();
+
+	StdVector<float> values;
+	values.resize(xs.size());
+
+	SpotNoise::spot_noise_2d_series(
+			to_span_const(xs), to_span_const(ys), to_span_const(spot_sizes), cell_size, jitter, seed, to_span(values)
+	);
+	unsigned int inside_count = 0;
+	for (unsigned int i = 0; i < values.size(); ++i) {
+		const float expected =
+				SpotNoise::spot_noise_2d(Vector2f(xs[i], ys[i]), cell_size, spot_sizes[i], jitter, seed);
+		ZN_TEST_ASSERT(values[i] == expected);
+		if (expected == 1.f) {
+			++inside_count;
+		}
+	}
+	// Make sure we actually tested something
+	ZN_TEST_ASSERT(inside_count > 0);
+	ZN_TEST_ASSERT(inside_count < values.size());
+
+	SpotNoise::spot_noise_3d_series(
+			to_span_const(xs),
+			to_span_const(ys),
+			to_span_const(zs),
+			to_span_const(spot_sizes),
+			cell_size,
+			jitter,
+			seed,
+			to_span(values)
+	);
+	for (unsigned int i = 0; i < values.size(); ++i) {
+		const float expected =
+				SpotNoise::spot_noise_3d(Vector3f(xs[i], ys[i], zs[i]), cell_size, spot_sizes[i], jitter, seed);
+		ZN_TEST_ASSERT(values[i] == expected);
+	}
+
+	// Positions spread too much to cache cells
+	for (unsigned int i = 0; i < xs.size(); ++i) {
+		xs[i] *= 1000.f;
+	}
+	SpotNoise::spot_noise_2d_series(
+			to_span_const(xs), to_span_const(ys), to_span_const(spot_sizes), cell_size, jitter, seed, to_span(values)
+	);
+	for (unsigned int i = 0; i < values.size(); ++i) {
+		const float expected =
+				SpotNoise::spot_noise_2d(Vector2f(xs[i], ys[i]), cell_size, spot_sizes[i], jitter, seed);
+		ZN_TEST_ASSERT(values[i] == expected);
+	}
+}
+
+void test_spot_noise_range() {
+	// Spots are centered in their cell
+	const float cell_size = 16.f;
+	const float jitter = 0.f;
+	const int seed = 42;
+	const math::Interval spot_size = math::Interval::from_single_value(4.f);
+
+	// Outside of spots, though the corner of the area is within the bounding box of the nearest spot
+	{
+		const math::Interval2 area{ math::Interval(0.f, 5.f), math::Interval(0.f, 5.f) };
+		const math::Interval r = SpotNoise::spot_noise_2d_range(area, cell_size, spot_size, jitter, seed);
+		ZN_TEST_ASSERT(r.is_single_value() && r.min == 0.f);
+	}
+	{
+		const math::Interval3 area{ math::Interval(0.f, 5.f), math::Interval(0.f, 5.f), math::Interval(0.f, 5.f) };
+		const math::Interval r = SpotNoise::spot_noise_3d_range(area, cell_size, spot_size, jitter, seed);
+		ZN_TEST_ASSERT(r.is_single_value() && r.min == 0.f);
+	}
+	// Entirely inside a spot
+	{
+		const math::Interval2 area{ math::Interval(7.f, 9.f), math::Interval(7.f, 9.f) };
+		const math::Interval r = SpotNoise::spot_noise_2d_range(area, cell_size, spot_size, jitter, seed);
+		ZN_TEST_ASSERT(r.is_single_value() && r.min == 1.f);
+	}
+	{
+		const math::Interval3 area{ math::Interval(7.f, 9.f), math::Interval(7.f, 9.f), math::Interval(7.f, 9.f) };
+		const math::Interval r = SpotNoise::spot_noise_3d_range(area, cell_size, spot_size, jitter, seed);
+		ZN_TEST_ASSERT(r.is_single_value() && r.min == 1.f);
+	}
+	// Partially inside a spot
+	{
+		const math::Interval2 area{ math::Interval(2.f, 9.f), math::Interval(7.f, 9.f) };
+		const math::Interval r = SpotNoise::spot_noise_2d_range(area, cell_size, spot_size, jitter, seed);
+		ZN_TEST_ASSERT(r.min == 0.f && r.max == 1.f);
+	}
+	// Spots with zero radius are empty
+	{
+		const math::Interval2 area{ math::Interval(-100.f, 100.f), math::Interval(-100.f, 100.f) };
+		const math::Interval r =
+				SpotNoise::spot_noise_2d_range(area, cell_size, math::Interval::from_single_value(0.f), jitter, seed);
+		ZN_TEST_ASSERT(r.is_single_value() && r.min == 0.f);
+	}
+}
+
+} // namespace zylann::tests
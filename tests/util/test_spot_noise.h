@@ -0,0 +1,11 @@
+#ifndef ZN_TESTS_SPOT_NOISE_H
+#define ZN_TESTS_SPOT_NOISE_H
+
+namespace zylann::tests {
+
+void test_spot_noise_series();
+void test_spot_noise_range();
+
+} // namespace zylann::tests
+
+#endif // ZN_TESTS_SPOT_NOISE_H
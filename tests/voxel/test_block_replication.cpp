@@ -0,0 +1,405 @@
+#include "test_block_replication.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../storage/voxel_data.h"
+#include "../../streams/voxel_block_serializer.h"
+#include "../../streams/voxel_stream_memory.h"
+#include "../../terrain/fixed_lod/block_replication.h"
+#include "../../util/godot/core/random_pcg.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+namespace {
+
+std::shared_ptr<VoxelBuffer> make_test_block(int block_size, uint64_t value) {
+	std::shared_ptr<VoxelBuffer> voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+	voxels->create(Vector3iUtil::create(block_size));
+	voxels->fill_area(value, Vector3i(1, 2, 3), Vector3i(5, 6, 7), VoxelBuffer::CHANNEL_TYPE);
+	return voxels;
+}
+
+void set_block(VoxelData &data, Vector3i bpos, std::shared_ptr<VoxelBuffer> voxels) {
+	VoxelDataBlock block(voxels, 0);
+	block.set_edited(true);
+	data.try_set_block(bpos, block, [](VoxelDataBlock &existing_block, const VoxelDataBlock &incoming_block) {
+		existing_block.set_voxels(incoming_block.get_voxels_shared());
+	});
+}
+
+// Applies a block received from the server, like `VoxelTerrain::try_set_block_data` does on clients
+void set_received_block(VoxelData &data, Vector3i bpos, std::shared_ptr<VoxelBuffer> voxels) {
+	VoxelDataBlock block(voxels, 0);
+	block.set_edited(true);
+	block.set_modified(true);
+	data.try_set_block(bpos, block, [](VoxelDataBlock &existing_block, const VoxelDataBlock &incoming_block) {
+		existing_block.set_voxels(incoming_block.get_voxels_shared());
+		existing_block.set_modified(true);
+	});
+}
+
+// Delivers messages of the server to a single client, the way `VoxelTerrainMultiplayerSynchronizer` would
+unsigned int deliver(
+		BlockReplicationServer &server,
+		VoxelData &server_data,
+		float delta_time,
+		BlockReplicationClient &client,
+		int peer_id,
+		VoxelData &client_data,
+		StdVector<Vector3i> *out_received_positions = nullptr
+) {
+	server.serialize_blocks(server_data, [peer_id](Vector3i bpos, StdVector<int> &out_peer_ids) {
+		out_peer_ids.push_back(peer_id);
+	});
+
+	StdVector<StdVector<uint8_t>> messages;
+	server.pop_messages(
+			delta_time,
+			[&messages, peer_id](int p_peer_id, Span<const uint8_t> message_data) {
+				ZN_TEST_ASSERT(p_peer_id == peer_id);
+				messages.push_back(StdVector<uint8_t>(message_data.data(), message_data.data() + message_data.size()));
+			}
+	);
+
+	unsigned int total_size = 0;
+	BlockReplicationClient::ReceiveResult result;
+
+	for (const StdVector<uint8_t> &message : messages) {
+		result.clear();
+		client.receive_blocks(to_span_const(message), client_data, result);
+		ZN_TEST_ASSERT(result.blocks_to_request.size() == 0);
+
+		for (BlockReplicationClient::ReceivedBlock &block : result.blocks) {
+			set_received_block(client_data, block.position, block.voxels);
+			if (out_received_positions != nullptr) {
+				out_received_positions->push_back(block.position);
+			}
+		}
+		total_size += message.size();
+	}
+
+	return total_size;
+}
+
+bool has_same_block(VoxelData &a, VoxelData &b, Vector3i bpos) {
+	std::shared_ptr<VoxelBuffer> va = a.try_get_block_voxels(bpos);
+	std::shared_ptr<VoxelBuffer> vb = b.try_get_block_voxels(bpos);
+	return va != nullptr && vb != nullptr && va->equals(*vb);
+}
+
+} // namespace
+
+void test_block_replication_cache() {
+	const int peer_id = 2;
+
+	VoxelData server_data;
+	const int bs = server_data.get_block_size();
+
+	const Vector3i up_to_date_bpos(0, 0, 0);
+	const Vector3i outdated_bpos(1, 0, 0);
+	const Vector3i uncached_bpos(2, 0, 0);
+
+	set_block(server_data, up_to_date_bpos, make_test_block(bs, 1));
+	set_block(server_data, outdated_bpos, make_test_block(bs, 2));
+	set_block(server_data, uncached_bpos, make_test_block(bs, 3));
+
+	// Stream of the client terrain, which starts empty
+	Ref<VoxelStreamMemory> cache;
+	cache.instantiate();
+
+	// First session: the client receives the first two blocks, then they get unloaded and saved to its stream
+	{
+		BlockReplicationServer server;
+		BlockReplicationClient client;
+		VoxelData client_data;
+
+		const Box3i blocks_box(Vector3i(), Vector3i(2, 1, 1));
+		client.on_area_entered_view(blocks_box);
+		// Nothing is found, but the first report is sent anyways so the server doesn't wait for it
+		StdVector<uint8_t> report;
+		ZN_TEST_ASSERT(client.look_up_cache(**cache, bs, report));
+		server.receive_cached_blocks_report(peer_id, to_span_const(report));
+
+		blocks_box.for_each_cell_zxy([&server, peer_id](Vector3i bpos) { server.send_block(peer_id, bpos); });
+		deliver(server, server_data, 0.f, client, peer_id, client_data);
+
+		StdVector<VoxelData::BlockToSave> to_save;
+		client_data.unload_blocks(blocks_box, 0, &to_save);
+		blocks_box.for_each_cell_zxy([&client](Vector3i bpos) { client.on_block_unloaded(bpos); });
+		// Received blocks must be saved, otherwise the cache stays empty
+		ZN_TEST_ASSERT(to_save.size() == 2);
+
+		StdVector<VoxelStream::VoxelQueryData> queries;
+		for (VoxelData::BlockToSave &block : to_save) {
+			ZN_TEST_ASSERT(block.voxels != nullptr);
+			queries.push_back(
+					VoxelStream::VoxelQueryData{ *block.voxels, block.position, 0, VoxelStream::RESULT_ERROR }
+			);
+		}
+		cache->save_voxel_blocks(to_span(queries));
+	}
+
+	// The server modifies one of them while the client is away
+	set_block(server_data, outdated_bpos, make_test_block(bs, 4));
+
+	BlockReplicationServer server;
+	BlockReplicationClient client;
+	VoxelData client_data;
+
+	// Second session: the client enters a bigger area. Blocks enter it on the server at the same time, but they are
+	// held until the client reports its cache.
+	const Box3i blocks_box(Vector3i(), Vector3i(3, 1, 1));
+	client.on_area_entered_view(blocks_box);
+	blocks_box.for_each_cell_zxy([&server, peer_id](Vector3i bpos) { server.send_block(peer_id, bpos); });
+	ZN_TEST_ASSERT(!server.has_serialization_jobs());
+	ZN_TEST_ASSERT(deliver(server, server_data, 0.f, client, peer_id, client_data) == 0);
+
+	// The client looks up its cache on a job, like the IO thread would
+	ZN_TEST_ASSERT(client.has_blocks_to_look_up());
+	BlockReplicationClient::CacheLookupJob job;
+	ZN_TEST_ASSERT(client.take_cache_lookup_job(bs, job));
+	ZN_TEST_ASSERT(!client.has_blocks_to_look_up());
+	BlockReplicationClient::CacheLookupResult lookup_result;
+	job.run(**cache, lookup_result);
+	ZN_TEST_ASSERT(lookup_result.blocks.size() == 2);
+	StdVector<uint8_t> report;
+	ZN_TEST_ASSERT(client.apply_cache_lookup_result(lookup_result, report));
+	server.receive_cached_blocks_report(peer_id, to_span_const(report));
+
+	// Held blocks are serialized the next time messages are popped, then sent
+	unsigned int size_with_cache = deliver(server, server_data, 0.f, client, peer_id, client_data);
+	ZN_TEST_ASSERT(server.has_serialization_jobs());
+	size_with_cache += deliver(server, server_data, 0.f, client, peer_id, client_data);
+	ZN_TEST_ASSERT(size_with_cache > 0);
+
+	blocks_box.for_each_cell_zxy([&server_data, &client_data](Vector3i bpos) {
+		ZN_TEST_ASSERT(has_same_block(server_data, client_data, bpos));
+	});
+
+	// The up-to-date block must not have been sent
+	{
+		BlockReplicationServer server2;
+		BlockReplicationClient client2;
+		VoxelData client_data2;
+		server2.set_cache_report_timeout(0.f);
+		blocks_box.for_each_cell_zxy([&server2, peer_id](Vector3i bpos) { server2.send_block(peer_id, bpos); });
+		const unsigned int size_without_cache = deliver(server2, server_data, 0.f, client2, peer_id, client_data2);
+
+		const BlockSerializer::SerializeResult result =
+				BlockSerializer::serialize_and_compress(*server_data.try_get_block_voxels(up_to_date_bpos));
+		ZN_TEST_ASSERT(result.success);
+		ZN_TEST_ASSERT(size_without_cache - size_with_cache == result.data.size());
+	}
+
+	// Edits still work with blocks that came from the cache
+	{
+		std::shared_ptr<VoxelBuffer> voxels = server_data.try_get_block_voxels(up_to_date_bpos);
+		voxels->set_voxel(42, Vector3i(4, 4, 4), VoxelBuffer::CHANNEL_TYPE);
+		server.mark_block_edited(up_to_date_bpos);
+		ZN_TEST_ASSERT(server.has_edited_blocks());
+		server.send_edited_blocks();
+		ZN_TEST_ASSERT(deliver(server, server_data, 0.f, client, peer_id, client_data) > 0);
+		ZN_TEST_ASSERT(has_same_block(server_data, client_data, up_to_date_bpos));
+	}
+
+	// Blocks are not held forever if a peer doesn't report its cache
+	{
+		BlockReplicationServer server3;
+		BlockReplicationClient client3;
+		VoxelData client_data3;
+		server3.set_cache_report_timeout(1.f);
+		server3.send_block(peer_id, uncached_bpos);
+		ZN_TEST_ASSERT(deliver(server3, server_data, 0.5f, client3, peer_id, client_data3) == 0);
+		ZN_TEST_ASSERT(!server3.has_serialization_jobs());
+		ZN_TEST_ASSERT(deliver(server3, server_data, 0.6f, client3, peer_id, client_data3) == 0);
+		ZN_TEST_ASSERT(server3.has_serialization_jobs());
+		ZN_TEST_ASSERT(deliver(server3, server_data, 0.f, client3, peer_id, client_data3) > 0);
+		ZN_TEST_ASSERT(has_same_block(server_data, client_data3, uncached_bpos));
+	}
+}
+
+void test_block_replication_scheduling() {
+	const int peer_id = 2;
+
+	VoxelData server_data;
+	const int bs = server_data.get_block_size();
+
+	// Noisy blocks, so they don't compress to almost nothing
+	const int block_count = 8;
+	RandomPCG random;
+	random.seed(131183);
+	for (int i = 0; i < block_count; ++i) {
+		std::shared_ptr<VoxelBuffer> voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+		voxels->create(Vector3iUtil::create(bs));
+		voxels->set_channel_depth(VoxelBuffer::CHANNEL_TYPE, VoxelBuffer::DEPTH_8_BIT);
+		Vector3i rpos;
+		for (rpos.z = 0; rpos.z < bs; ++rpos.z) {
+			for (rpos.x = 0; rpos.x < bs; ++rpos.x) {
+				for (rpos.y = 0; rpos.y < bs; ++rpos.y) {
+					voxels->set_voxel(random.rand() % 256, rpos, VoxelBuffer::CHANNEL_TYPE);
+				}
+			}
+		}
+		set_block(server_data, Vector3i(i, 0, 0), voxels);
+	}
+
+	size_t block_message_size = 0;
+	{
+		const BlockSerializer::SerializeResult result =
+				BlockSerializer::serialize_and_compress(*server_data.try_get_block_voxels(Vector3i()));
+		ZN_TEST_ASSERT(result.success);
+		block_message_size = result.data.size();
+	}
+
+	BlockReplicationServer server;
+	BlockReplicationClient client;
+	VoxelData client_data;
+
+	// The client has no cache, blocks don't need to wait for its report
+	server.set_cache_report_timeout(0.f);
+	// Allow about two blocks per second
+	server.set_bandwidth_limit(2 * block_message_size + 100);
+	server.set_max_queued_bytes(0);
+
+	for (int i = 0; i < block_count; ++i) {
+		server.send_block(peer_id, Vector3i(i, 0, 0));
+	}
+	server.set_peer_position(peer_id, Vector3f(block_count, 0.5f, 0.5f));
+
+	// Closest blocks must be sent first, within the bandwidth limit
+	StdVector<Vector3i> received;
+	unsigned int size = deliver(server, server_data, 1.f, client, peer_id, client_data, &received);
+	ZN_TEST_ASSERT(size > 0);
+	ZN_TEST_ASSERT(size <= 3 * (block_message_size + 100));
+	ZN_TEST_ASSERT(received.size() >= 1 && received.size() < static_cast<size_t>(block_count));
+	for (unsigned int i = 0; i < received.size(); ++i) {
+		ZN_TEST_ASSERT(received[i] == Vector3i(block_count - 1 - int(i), 0, 0));
+	}
+
+	// Edits are sent before blocks still in the queue
+	{
+		const Vector3i edited_bpos = received[0];
+		server_data.try_get_block_voxels(edited_bpos)->set_voxel(0, Vector3i(1, 1, 1), VoxelBuffer::CHANNEL_TYPE);
+		server.mark_block_edited(edited_bpos);
+		server.send_edited_blocks();
+
+		received.clear();
+		deliver(server, server_data, 1.f, client, peer_id, client_data, &received);
+		ZN_TEST_ASSERT(received.size() >= 1);
+		ZN_TEST_ASSERT(received[0] == edited_bpos);
+	}
+
+	// Eventually all blocks are received
+	for (int i = 0; i < block_count; ++i) {
+		deliver(server, server_data, 1.f, client, peer_id, client_data);
+	}
+	ZN_TEST_ASSERT(server.get_queued_bytes(peer_id) == 0);
+	for (int i = 0; i < block_count; ++i) {
+		ZN_TEST_ASSERT(has_same_block(server_data, client_data, Vector3i(i, 0, 0)));
+	}
+
+	// Back-pressure: blocks past the queue limit are not serialized until the queue has room
+	{
+		BlockReplicationServer server2;
+		BlockReplicationClient client2;
+		VoxelData client_data2;
+		server2.set_cache_report_timeout(0.f);
+		server2.set_max_queued_bytes(2 * block_message_size);
+
+		// Gives the server an estimate of how big blocks are
+		server2.send_block(peer_id, Vector3i());
+		server2.serialize_blocks(server_data, [](Vector3i bpos, StdVector<int> &out_peer_ids) {});
+		ZN_TEST_ASSERT(server2.get_queued_bytes(peer_id) == block_message_size);
+
+		for (int i = 1; i < block_count; ++i) {
+			server2.send_block(peer_id, Vector3i(i, 0, 0));
+		}
+		server2.serialize_blocks(server_data, [](Vector3i bpos, StdVector<int> &out_peer_ids) {});
+		ZN_TEST_ASSERT(server2.get_queued_bytes(peer_id) <= 3 * block_message_size);
+
+		for (int i = 0; i < block_count; ++i) {
+			deliver(server2, server_data, 1.f, client2, peer_id, client_data2);
+		}
+		ZN_TEST_ASSERT(server2.get_queued_bytes(peer_id) == 0);
+		for (int i = 0; i < block_count; ++i) {
+			ZN_TEST_ASSERT(has_same_block(server_data, client_data2, Vector3i(i, 0, 0)));
+		}
+	}
+
+	// Peers needing the same block share the same serialized data
+	{
+		BlockReplicationServer server3;
+		server3.set_cache_report_timeout(0.f);
+		const int other_peer_id = 3;
+		server3.send_block(peer_id, Vector3i());
+		server3.send_block(other_peer_id, Vector3i());
+
+		StdVector<BlockReplicationServer::SerializationJob> jobs;
+		server3.take_serialization_jobs(jobs);
+		ZN_TEST_ASSERT(jobs.size() == 1);
+		ZN_TEST_ASSERT(!server3.has_serialization_jobs());
+
+		BlockReplicationServer::SerializationResult result;
+		jobs[0].run(server_data, result);
+		ZN_TEST_ASSERT(result.success);
+		server3.apply_serialization_results(
+				Span<const BlockReplicationServer::SerializationResult>(&result, 1),
+				[](Vector3i bpos, StdVector<int> &out_peer_ids) {}
+		);
+		ZN_TEST_ASSERT(server3.get_queued_bytes(peer_id) == block_message_size);
+		ZN_TEST_ASSERT(server3.get_queued_bytes(other_peer_id) == block_message_size);
+	}
+}
+
+void test_block_replication_remove_peer() {
+	const int peer_id = 2;
+	const int removed_peer_id = 3;
+
+	VoxelData server_data;
+	const int bs = server_data.get_block_size();
+
+	const Vector3i bpos0(0, 0, 0);
+	const Vector3i bpos1(1, 0, 0);
+	set_block(server_data, bpos0, make_test_block(bs, 1));
+	set_block(server_data, bpos1, make_test_block(bs, 2));
+
+	BlockReplicationServer server;
+	server.set_cache_report_timeout(0.f);
+
+	// Both peers receive the first block
+	server.send_block(peer_id, bpos0);
+	server.send_block(removed_peer_id, bpos0);
+	server.serialize_blocks(server_data, [](Vector3i bpos, StdVector<int> &out_peer_ids) {});
+	server.pop_messages(0.f, [](int p_peer_id, Span<const uint8_t> message_data) {});
+
+	// One of them disconnects while the second block is queued for it
+	server.send_block(removed_peer_id, bpos1);
+	server.remove_peer(removed_peer_id);
+	ZN_TEST_ASSERT(server.get_queued_bytes(removed_peer_id) == 0);
+
+	// Edits of a block it had are not sent to it anymore
+	server_data.try_get_block_voxels(bpos0)->set_voxel(42, Vector3i(4, 4, 4), VoxelBuffer::CHANNEL_TYPE);
+	server.mark_block_edited(bpos0);
+	server.send_edited_blocks();
+	server.serialize_blocks(server_data, [peer_id, removed_peer_id](Vector3i bpos, StdVector<int> &out_peer_ids) {
+		// Its viewer may not be removed yet
+		out_peer_ids.push_back(peer_id);
+		out_peer_ids.push_back(removed_peer_id);
+	});
+
+	unsigned int message_count = 0;
+	server.pop_messages(1.f, [&message_count, removed_peer_id](int p_peer_id, Span<const uint8_t> message_data) {
+		ZN_TEST_ASSERT(p_peer_id != removed_peer_id);
+		++message_count;
+	});
+	// The remaining peer still gets the edit
+	ZN_TEST_ASSERT(message_count == 1);
+	ZN_TEST_ASSERT(server.get_queued_bytes(removed_peer_id) == 0);
+
+	// The scheduler doesn't get a queue back for it if its viewer still moves around
+	ZN_TEST_ASSERT(server.has_peer(peer_id));
+	ZN_TEST_ASSERT(!server.has_peer(removed_peer_id));
+	server.set_peer_position(removed_peer_id, Vector3f(1.f, 0.f, 0.f));
+	ZN_TEST_ASSERT(!server.has_peer(removed_peer_id));
+}
+
+} // namespace zylann::voxel::tests
@@ -0,0 +1,12 @@
+#ifndef VOXEL_TESTS_BLOCK_REPLICATION_H
+#define VOXEL_TESTS_BLOCK_REPLICATION_H
+
+namespace zylann::voxel::tests {
+
+void test_block_replication_cache();
+void test_block_replication_scheduling();
+void test_block_replication_remove_peer();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TESTS_BLOCK_REPLICATION_H
@@ -2,133 +2,63 @@
 #include "../../generators/graph/range_utility.h"
 #include "../../util/containers/std_vector.h"
 #include "../../util/godot/classes/curve.h"
+#include "../../util/godot/core/random_pcg.h"
 #include "../testing.h"
 
 namespace zylann::voxel::tests {
 
-void test_get_curve_monotonic_sections() {
-	// This one is a bit annoying to test because Curve has float precision issues stemming from the bake() function
-	struct L {
-		static bool is_equal_approx(float a, float b) {
-			return Math::is_equal_approx(a, b, 2.f * CURVE_RANGE_MARGIN);
-		}
-	};
-	{
-		// One segment going up
-		Ref<Curve> curve;
-		curve.instantiate();
-		curve->add_point(Vector2(0, 0));
-		curve->add_point(Vector2(1, 1));
-		StdVector<CurveMonotonicSection> sections;
-		get_curve_monotonic_sections(**curve, sections);
-		ZN_TEST_ASSERT(sections.size() == 1);
-		ZN_TEST_ASSERT(sections[0].x_min == 0.f);
-		ZN_TEST_ASSERT(sections[0].x_max == 1.f);
-		ZN_TEST_ASSERT(sections[0].y_min == 0.f);
-		ZN_TEST_ASSERT(sections[0].y_max == 1.f);
-		{
-			math::Interval yi = get_curve_range(**curve, sections, math::Interval(0.f, 1.f));
-			ZN_TEST_ASSERT(L::is_equal_approx(yi.min, 0.f));
-			ZN_TEST_ASSERT(L::is_equal_approx(yi.max, 1.f));
-		}
-		{
-			math::Interval yi = get_curve_range(**curve, sections, math::Interval(-2.f, 2.f));
-			ZN_TEST_ASSERT(L::is_equal_approx(yi.min, 0.f));
-			ZN_TEST_ASSERT(L::is_equal_approx(yi.max, 1.f));
-		}
-		{
-			math::Interval xi(0.2f, 0.8f);
-			math::Interval yi = get_curve_range(**curve, sections, xi);
-			math::Interval yi_expected(curve->sample_baked(xi.min), curve->sample_baked(xi.max));
-			ZN_TEST_ASSERT(L::is_equal_approx(yi.min, yi_expected.min));
-			ZN_TEST_ASSERT(L::is_equal_approx(yi.max, yi_expected.max));
-		}
-	}
-	{
-		// One flat segment
-		Ref<Curve> curve;
-		curve.instantiate();
-		curve->add_point(Vector2(0, 0));
-		curve->add_point(Vector2(1, 0));
-		StdVector<CurveMonotonicSection> sections;
-		get_curve_monotonic_sections(**curve, sections);
-		ZN_TEST_ASSERT(sections.size() == 1);
-		ZN_TEST_ASSERT(sections[0].x_min == 0.f);
-		ZN_TEST_ASSERT(sections[0].x_max == 1.f);
-		ZN_TEST_ASSERT(sections[0].y_min == 0.f);
-		ZN_TEST_ASSERT(sections[0].y_max == 0.f);
-	}
-	{
-		// Two segments: going up, then flat
-		Ref<Curve> curve;
-		curve.instantiate();
-		curve->add_point(Vector2(0, 0));
-		curve->add_point(Vector2(0.5, 1));
-		curve->add_point(Vector2(1, 1));
-		StdVector<CurveMonotonicSection> sections;
-		get_curve_monotonic_sections(**curve, sections);
-		ZN_TEST_ASSERT(sections.size() == 1);
-	}
-	{
-		// Two segments: flat, then up
-		Ref<Curve> curve;
-		curve.instantiate();
-		curve->add_point(Vector2(0, 0));
-		curve->add_point(Vector2(0.5, 0));
-		curve->add_point(Vector2(1, 1));
-		StdVector<CurveMonotonicSection> sections;
-		get_curve_monotonic_sections(**curve, sections);
-		ZN_TEST_ASSERT(sections.size() == 1);
-	}
-	{
-		// Three segments: flat, then up, then flat
-		Ref<Curve> curve;
-		curve.instantiate();
-		curve->add_point(Vector2(0, 0));
-		curve->add_point(Vector2(0.3, 0));
-		curve->add_point(Vector2(0.6, 1));
-		curve->add_point(Vector2(1, 1));
-		StdVector<CurveMonotonicSection> sections;
-		get_curve_monotonic_sections(**curve, sections);
-		ZN_TEST_ASSERT(sections.size() == 1);
-	}
-	{
-		// Three segments: up, down, up
-		Ref<Curve> curve;
-		curve.instantiate();
-		curve->add_point(Vector2(0, 0));
-		curve->add_point(Vector2(0.3, 1));
-		curve->add_point(Vector2(0.6, 0));
-		curve->add_point(Vector2(1, 1));
-		StdVector<CurveMonotonicSection> sections;
-		get_curve_monotonic_sections(**curve, sections);
-		ZN_TEST_ASSERT(sections.size() == 3);
-		ZN_TEST_ASSERT(sections[0].x_min == 0.f);
-		ZN_TEST_ASSERT(sections[2].x_max == 1.f);
+void test_curve_lut() {
+	Ref<Curve> curve;
+	curve.instantiate();
+	curve->add_point(Vector2(0, 0), 0.f, 1.f);
+	curve->add_point(Vector2(0.3, 1));
+	curve->add_point(Vector2(0.6, 0.2));
+	curve->add_point(Vector2(1, 0.7));
+
+	math::CurveLUT lut;
+	bake_curve_lut(**curve, lut);
+	ZN_TEST_ASSERT(static_cast<int>(lut.get_point_count()) == curve->get_bake_resolution());
+
+	RandomPCG rng;
+	rng.seed(131183);
+
+	// Also going outside of the curve
+	StdVector<float> xs;
+	for (unsigned int i = 0; i < 1000; ++i) {
+		xs.push_back(-0.2f + 1.4f * rng.randf());
 	}
-	{
-		// Two segments: going up, then down
-		Ref<Curve> curve;
-		curve.instantiate();
-		curve->add_point(Vector2(0, 0));
-		curve->add_point(Vector2(0.5, 1));
-		curve->add_point(Vector2(1, 0));
-		StdVector<CurveMonotonicSection> sections;
-		get_curve_monotonic_sections(**curve, sections);
-		ZN_TEST_ASSERT(sections.size() == 2);
+	xs.push_back(0.f);
+	xs.push_back(1.f);
+
+	StdVector<float> values;
+	values.resize(xs.size());
+	lut.sample(to_span_const(xs), to_span(values));
+
+	for (unsigned int i = 0; i < xs.size(); ++i) {
+		const float expected = curve->sample_baked(xs[i]);
+		ZN_TEST_ASSERT(Math::is_equal_approx(values[i], expected, 0.0001f));
+		// Batches give the same results as single samples
+		ZN_TEST_ASSERT(values[i] == lut.sample(xs[i]));
 	}
-	{
-		// One segment, curved as a parabola going up then down
-		Ref<Curve> curve;
-		curve.instantiate();
-		curve->add_point(Vector2(0, 0), 0.f, 1.f);
-		curve->add_point(Vector2(1, 0));
-		StdVector<CurveMonotonicSection> sections;
-		get_curve_monotonic_sections(**curve, sections);
-		ZN_TEST_ASSERT(sections.size() == 2);
-		ZN_TEST_ASSERT(sections[0].x_min == 0.f);
-		ZN_TEST_ASSERT(sections[0].y_max >= 0.1f);
-		ZN_TEST_ASSERT(sections[1].x_max == 1.f);
+
+	// Ranges are exact, so they contain all values and are reached by some of them
+	for (unsigned int i = 0; i < 100; ++i) {
+		const math::Interval x = math::Interval::from_unordered_values(
+				-0.2f + 1.4f * rng.randf(), //
+				-0.2f + 1.4f * rng.randf()
+		);
+		const math::Interval range = lut.get_range(x);
+
+		math::Interval sampled_range = math::Interval::from_single_value(lut.sample(x.min));
+		const unsigned int steps = 4 * lut.get_point_count();
+		for (unsigned int j = 0; j <= steps; ++j) {
+			const float v = lut.sample(math::min(math::lerp(x.min, x.max, static_cast<float>(j) / steps), x.max));
+			ZN_TEST_ASSERT(range.contains(v));
+			sampled_range.add_point(v);
+		}
+
+		ZN_TEST_ASSERT(Math::is_equal_approx(range.min, sampled_range.min, 0.01f));
+		ZN_TEST_ASSERT(Math::is_equal_approx(range.max, sampled_range.max, 0.01f));
 	}
 }
 
@@ -1,5 +1,6 @@
 #include "test_edition_funcs.h"
 #include "../../edition/funcs.h"
+#include "../../edition/interpolated_voxel_sampler.h"
 #include "../../edition/voxel_tool_terrain.h"
 #include "../../generators/graph/voxel_generator_graph.h"
 #include "../../meshers/blocky/voxel_blocky_library.h"
@@ -134,6 +135,55 @@ void test_run_blocky_random_tick() {
 	}
 }
 
+void test_run_blocky_random_tick_uniform_blocks() {
+	Ref<VoxelBlockyLibrary> library;
+	library.instantiate();
+
+	{
+		Ref<VoxelBlockyModelMesh> air;
+		air.instantiate();
+		library->add_model(air);
+	}
+
+	int tickable_id = -1;
+	{
+		Ref<VoxelBlockyModel> tickable;
+		tickable.instantiate();
+		tickable->set_random_tickable(true);
+		tickable_id = library->add_model(tickable);
+	}
+
+	library->bake();
+
+	// One block filled with tickable voxels, next to one filled with air
+	VoxelData data;
+	const int block_size = data.get_block_size();
+	for (int i = 0; i < 2; ++i) {
+		std::shared_ptr<VoxelBuffer> buffer = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer->create(Vector3iUtil::create(block_size));
+		buffer->fill(i == 0 ? tickable_id : 0, VoxelBuffer::CHANNEL_TYPE);
+		VoxelDataBlock block(buffer, 0);
+		block.set_edited(true);
+		ZN_TEST_ASSERT(data.try_set_block(Vector3i(i, 0, 0), block));
+	}
+
+	const Box3i voxel_box(Vector3i(), Vector3i(2 * block_size, block_size, block_size));
+	const Box3i tickable_box(Vector3i(), Vector3iUtil::create(block_size));
+
+	RandomPCG random;
+	random.seed(131183);
+	StdVector<Vector3i> positions;
+	StdVector<uint16_t> values;
+	pick_blocky_random_tick_voxels(data, voxel_box, **library, random, 256, 8, positions, values);
+
+	ZN_TEST_ASSERT(positions.size() > 0);
+	ZN_TEST_ASSERT(positions.size() == values.size());
+	for (unsigned int i = 0; i < positions.size(); ++i) {
+		ZN_TEST_ASSERT(tickable_box.contains(positions[i]));
+		ZN_TEST_ASSERT(values[i] == tickable_id);
+	}
+}
+
 void test_box_blur() {
 	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
 	voxels.create(64, 64, 64);
@@ -359,4 +409,95 @@ void test_sdf_hemisphere() {
 	ZN_TEST_ASSERT(shape(Vector3f(2, 0, 0)) > 0);
 }
 
-} // namespace zylann::voxel::tests
\ No newline at end of file
+void test_interpolated_voxel_sampler() {
+	VoxelData data;
+	const int bs = data.get_block_size();
+
+	// Sphere SDF spanning a few blocks, leaving some blocks of the area unloaded
+	const Box3i blocks_box(-2, -2, -2, 4, 4, 4);
+	blocks_box.for_each_cell_zxy([&data, bs](Vector3i block_pos) {
+		if (block_pos == Vector3i(1, 1, 1)) {
+			return;
+		}
+		std::shared_ptr<VoxelBuffer> buffer = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer->create(Vector3iUtil::create(bs));
+		const Vector3i origin = block_pos * bs;
+		Vector3i rpos;
+		for (rpos.z = 0; rpos.z < bs; ++rpos.z) {
+			for (rpos.x = 0; rpos.x < bs; ++rpos.x) {
+				for (rpos.y = 0; rpos.y < bs; ++rpos.y) {
+					const float sd = to_vec3f(origin + rpos).length() - 10.f;
+					buffer->set_voxel_f(sd, rpos, VoxelBuffer::CHANNEL_SDF);
+				}
+			}
+		}
+		VoxelDataBlock block(buffer, 0);
+		block.set_edited(true);
+		ZN_TEST_ASSERT(data.try_set_block(block_pos, block));
+	});
+
+	const float defval = constants::SDF_FAR_OUTSIDE;
+
+	auto expected_f = [&data, defval](Vector3 pos) {
+		return get_sdf_interpolated(
+				[&data, defval](Vector3i ipos) {
+					VoxelSingleValue v;
+					v.f = defval;
+					return data.get_voxel(ipos, VoxelBuffer::CHANNEL_SDF, v).f;
+				},
+				pos
+		);
+	};
+
+	// Positions crossing block boundaries, unloaded blocks and the outside of the loaded area
+	StdVector<Vector3> positions;
+	RandomPCG random;
+	random.seed(131183);
+	for (unsigned int i = 0; i < 500; ++i) {
+		positions.push_back(Vector3(
+				random.random(-2.5f * bs, 2.5f * bs),
+				random.random(-2.5f * bs, 2.5f * bs),
+				random.random(-2.5f * bs, 2.5f * bs)
+		));
+	}
+
+	{
+		InterpolatedVoxelSampler sampler(data, VoxelBuffer::CHANNEL_SDF, defval);
+		for (const Vector3 pos : positions) {
+			ZN_TEST_ASSERT(Math::is_equal_approx(sampler.sample(pos), expected_f(pos)));
+		}
+	}
+
+	{
+		StdVector<float> values;
+		values.resize(positions.size());
+		StdVector<Vector3> gradients;
+		gradients.resize(positions.size());
+
+		InterpolatedVoxelSampler sampler(data, VoxelBuffer::CHANNEL_SDF, defval);
+		sampler.sample_batch(to_span_const(positions), to_span(values), to_span(gradients));
+		sampler.release();
+
+		for (unsigned int i = 0; i < positions.size(); ++i) {
+			const Vector3 pos = positions[i];
+			ZN_TEST_ASSERT(Math::is_equal_approx(values[i], expected_f(pos)));
+
+			// Compare with finite differences, staying inside the same cell where interpolation is continuous
+			const Vector3 f = math::fract(pos);
+			const float e = 0.01f;
+			for (int axis = 0; axis < Vector3iUtil::AXIS_COUNT; ++axis) {
+				Vector3 p0 = pos;
+				Vector3 p1 = pos;
+				if (f[axis] < 0.5f) {
+					p1[axis] += e;
+				} else {
+					p0[axis] -= e;
+				}
+				const float d = (expected_f(p1) - expected_f(p0)) / e;
+				ZN_TEST_ASSERT(Math::abs(d - gradients[i][axis]) < 0.01f);
+			}
+		}
+	}
+}
+
+} // namespace zylann::voxel::tests
@@ -4,9 +4,11 @@
 namespace zylann::voxel::tests {
 
 void test_run_blocky_random_tick();
+void test_run_blocky_random_tick_uniform_blocks();
 void test_box_blur();
 void test_discord_soakil_copypaste();
 void test_sdf_hemisphere();
+void test_interpolated_voxel_sampler();
 
 } // namespace zylann::voxel::tests
 
@@ -0,0 +1,242 @@
+#include "test_simple_generators.h"
+#include "../../generators/simple/voxel_generator_flat.h"
+#include "../../generators/simple/voxel_generator_image.h"
+#include "../../generators/simple/voxel_generator_noise.h"
+#include "../../generators/simple/voxel_generator_noise_2d.h"
+#include "../../generators/simple/voxel_generator_waves.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/godot/classes/curve.h"
+#include "../../util/godot/classes/fast_noise_lite.h"
+#include "../../util/godot/classes/image.h"
+#include "../../util/io/log.h"
+#include "../../util/math/funcs.h"
+#include "../../util/string/format.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+namespace {
+
+enum SdfComparison {
+	// Single values must be the same as in blocks, up to quantization
+	SDF_COMPARE_VALUES,
+	// Blocks use placeholder values far from the surface, only the side of the surface must be the same
+	SDF_COMPARE_SIGNS
+};
+
+// Generates a block at LOD 0, and checks that single queries of all its voxels give the same values
+bool check_single_matches_block(
+		VoxelGenerator &generator,
+		unsigned int channel,
+		Vector3i origin,
+		SdfComparison sdf_comparison
+) {
+	const Vector3i block_size(16, 16, 16);
+
+	VoxelBuffer buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+	buffer.create(block_size);
+	VoxelGenerator::VoxelQueryData query{ buffer, origin, 0 };
+	generator.generate_block(query);
+
+	StdVector<Vector3i> positions;
+	positions.reserve(Vector3iUtil::get_volume(block_size));
+	Vector3i pos;
+	for (pos.z = 0; pos.z < block_size.z; ++pos.z) {
+		for (pos.x = 0; pos.x < block_size.x; ++pos.x) {
+			for (pos.y = 0; pos.y < block_size.y; ++pos.y) {
+				positions.push_back(origin + pos);
+			}
+		}
+	}
+
+	StdVector<VoxelSingleValue> batch_values;
+	batch_values.resize(positions.size());
+	generator.generate_single_batch(to_span_const(positions), channel, to_span(batch_values));
+
+	const float saturation_distance = 1.f / VoxelBuffer::get_sdf_quantization_scale(VoxelBuffer::DEPTH_16_BIT);
+	// Step between quantized values is about 0.015
+	const float tolerance = 0.02f;
+
+	for (unsigned int i = 0; i < positions.size(); ++i) {
+		const Vector3i world_pos = positions[i];
+		const Vector3i local_pos = world_pos - origin;
+		const VoxelSingleValue single_value = generator.generate_single(world_pos, channel);
+
+		if (channel == VoxelBuffer::CHANNEL_SDF) {
+			const float expected = buffer.get_voxel_f(local_pos, channel);
+			const float sd = single_value.f;
+
+			if (batch_values[i].f != sd) {
+				ZN_PRINT_ERROR(
+						format("Batch SDF {} differs from single SDF {} at {}", batch_values[i].f, sd, world_pos)
+				);
+				return false;
+			}
+
+			const bool matches = sdf_comparison == SDF_COMPARE_VALUES
+					? Math::abs(math::clamp(sd, -saturation_distance, saturation_distance) - expected) < tolerance
+					: (sd < 0.f) == (expected < 0.f);
+			if (!matches) {
+				ZN_PRINT_ERROR(format("Single SDF {} differs from block SDF {} at {}", sd, expected, world_pos));
+				return false;
+			}
+
+		} else {
+			const uint64_t expected = buffer.get_voxel(local_pos, channel);
+
+			if (batch_values[i].i != single_value.i) {
+				ZN_PRINT_ERROR(format(
+						"Batch value {} differs from single value {} at {}",
+						batch_values[i].i,
+						single_value.i,
+						world_pos
+				));
+				return false;
+			}
+			if (single_value.i != expected) {
+				ZN_PRINT_ERROR(format(
+						"Single value {} differs from block value {} at {}", single_value.i, expected, world_pos
+				));
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Checks a heightmap generator whose ground lies between -50 and 50, in a height range from -100 to 100
+void test_heightmap_single(VoxelGeneratorHeightmap &generator) {
+	generator.set_height_start(-100.f);
+	generator.set_height_range(200.f);
+
+	const Vector3i origins[] = {
+		// Near the surface
+		Vector3i(-8, -8, -8),
+		// Far above and below, still in the height range where blocks contain actual distances
+		Vector3i(-8, 80, -8),
+		Vector3i(-8, -96, -8),
+	};
+
+	generator.set_channel(VoxelBuffer::CHANNEL_SDF);
+	for (const Vector3i origin : origins) {
+		ZN_TEST_ASSERT(check_single_matches_block(generator, VoxelBuffer::CHANNEL_SDF, origin, SDF_COMPARE_VALUES));
+		// Channels the generator doesn't output have default values
+		ZN_TEST_ASSERT(check_single_matches_block(generator, VoxelBuffer::CHANNEL_TYPE, origin, SDF_COMPARE_VALUES));
+	}
+
+	generator.set_channel(VoxelBuffer::CHANNEL_TYPE);
+	for (const Vector3i origin : origins) {
+		ZN_TEST_ASSERT(check_single_matches_block(generator, VoxelBuffer::CHANNEL_TYPE, origin, SDF_COMPARE_VALUES));
+	}
+}
+
+Ref<FastNoiseLite> create_test_noise() {
+	Ref<FastNoiseLite> noise;
+	noise.instantiate();
+	noise->set_seed(131183);
+	noise->set_frequency(1.f / 32.f);
+	return noise;
+}
+
+} // namespace
+
+void test_voxel_generator_flat_single() {
+	Ref<VoxelGeneratorFlat> generator;
+	generator.instantiate();
+	// Not an integer, to check rounding of blocky voxels
+	generator->set_height(3.5f);
+
+	const Vector3i near_surface_origin(-8, -8, -8);
+	// Beyond the margin, where blocks are filled with placeholder values
+	const Vector3i far_above_origin(-8, 64, -8);
+	const Vector3i far_below_origin(-8, -80, -8);
+
+	VoxelGeneratorFlat &g = **generator;
+
+	g.set_channel(VoxelBuffer::CHANNEL_SDF);
+	ZN_TEST_ASSERT(check_single_matches_block(g, VoxelBuffer::CHANNEL_SDF, near_surface_origin, SDF_COMPARE_VALUES));
+	ZN_TEST_ASSERT(check_single_matches_block(g, VoxelBuffer::CHANNEL_SDF, far_above_origin, SDF_COMPARE_SIGNS));
+	ZN_TEST_ASSERT(check_single_matches_block(g, VoxelBuffer::CHANNEL_SDF, far_below_origin, SDF_COMPARE_SIGNS));
+	ZN_TEST_ASSERT(check_single_matches_block(g, VoxelBuffer::CHANNEL_TYPE, near_surface_origin, SDF_COMPARE_VALUES));
+
+	g.set_channel(VoxelBuffer::CHANNEL_TYPE);
+	ZN_TEST_ASSERT(check_single_matches_block(g, VoxelBuffer::CHANNEL_TYPE, near_surface_origin, SDF_COMPARE_VALUES));
+	ZN_TEST_ASSERT(check_single_matches_block(g, VoxelBuffer::CHANNEL_TYPE, far_above_origin, SDF_COMPARE_VALUES));
+	ZN_TEST_ASSERT(check_single_matches_block(g, VoxelBuffer::CHANNEL_TYPE, far_below_origin, SDF_COMPARE_VALUES));
+}
+
+void test_voxel_generator_noise_single() {
+	Ref<VoxelGeneratorNoise> generator;
+	generator.instantiate();
+	generator->set_noise(create_test_noise());
+	generator->set_height_start(-50.f);
+	generator->set_height_range(100.f);
+
+	const Vector3i near_surface_origin(-8, -8, -8);
+	// Crosses the top of the height range
+	const Vector3i top_origin(-8, 40, -8);
+	// Outside of the height range, where blocks are filled with far distances
+	const Vector3i far_above_origin(-8, 64, -8);
+	const Vector3i far_below_origin(-8, -80, -8);
+
+	VoxelGeneratorNoise &g = **generator;
+
+	g.set_channel(VoxelBuffer::CHANNEL_SDF);
+	ZN_TEST_ASSERT(check_single_matches_block(g, VoxelBuffer::CHANNEL_SDF, near_surface_origin, SDF_COMPARE_VALUES));
+	ZN_TEST_ASSERT(check_single_matches_block(g, VoxelBuffer::CHANNEL_SDF, top_origin, SDF_COMPARE_VALUES));
+	ZN_TEST_ASSERT(check_single_matches_block(g, VoxelBuffer::CHANNEL_SDF, far_above_origin, SDF_COMPARE_VALUES));
+	ZN_TEST_ASSERT(check_single_matches_block(g, VoxelBuffer::CHANNEL_SDF, far_below_origin, SDF_COMPARE_VALUES));
+
+	g.set_channel(VoxelBuffer::CHANNEL_TYPE);
+	ZN_TEST_ASSERT(check_single_matches_block(g, VoxelBuffer::CHANNEL_TYPE, near_surface_origin, SDF_COMPARE_VALUES));
+	ZN_TEST_ASSERT(check_single_matches_block(g, VoxelBuffer::CHANNEL_TYPE, top_origin, SDF_COMPARE_VALUES));
+	ZN_TEST_ASSERT(check_single_matches_block(g, VoxelBuffer::CHANNEL_TYPE, far_above_origin, SDF_COMPARE_VALUES));
+	ZN_TEST_ASSERT(check_single_matches_block(g, VoxelBuffer::CHANNEL_TYPE, far_below_origin, SDF_COMPARE_VALUES));
+}
+
+void test_voxel_generator_noise_2d_single() {
+	Ref<VoxelGeneratorNoise2D> generator;
+	generator.instantiate();
+	generator->set_noise(create_test_noise());
+	test_heightmap_single(**generator);
+
+	Ref<Curve> curve;
+	curve.instantiate();
+	curve->add_point(Vector2(0, 0.25));
+	curve->add_point(Vector2(0.5, 0.3));
+	curve->add_point(Vector2(1, 0.75));
+	generator->set_curve(curve);
+	test_heightmap_single(**generator);
+}
+
+void test_voxel_generator_image_single() {
+	const int size = 32;
+	Ref<Image> image = zylann::godot::create_empty_image(size, size, false, Image::FORMAT_RF);
+	for (int y = 0; y < size; ++y) {
+		for (int x = 0; x < size; ++x) {
+			// Smooth heights between 0.25 and 0.75
+			const float h = 0.5f + 0.125f * (Math::sin(x * 0.3f) + Math::cos(y * 0.2f));
+			image->set_pixel(x, y, Color(h, h, h));
+		}
+	}
+
+	Ref<VoxelGeneratorImage> generator;
+	generator.instantiate();
+	generator->set_image(image);
+	test_heightmap_single(**generator);
+
+	generator->set_blur_enabled(true);
+	test_heightmap_single(**generator);
+}
+
+void test_voxel_generator_waves_single() {
+	Ref<VoxelGeneratorWaves> generator;
+	generator.instantiate();
+	generator->set_pattern_size(Vector2(24, 40));
+	generator->set_pattern_offset(Vector2(3, 5));
+	test_heightmap_single(**generator);
+}
+
+} // namespace zylann::voxel::tests
@@ -0,0 +1,14 @@
+#ifndef VOXEL_TESTS_SIMPLE_GENERATORS_H
+#define VOXEL_TESTS_SIMPLE_GENERATORS_H
+
+namespace zylann::voxel::tests {
+
+void test_voxel_generator_flat_single();
+void test_voxel_generator_noise_single();
+void test_voxel_generator_noise_2d_single();
+void test_voxel_generator_image_single();
+void test_voxel_generator_waves_single();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TESTS_SIMPLE_GENERATORS_H
@@ -0,0 +1,136 @@
+#include "test_vox_data.h"
+#include "../../storage/funcs.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../streams/vox/vox_data.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/godot/classes/file_access.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+namespace {
+
+void append_u32(StdVector<uint8_t> &bytes, uint32_t v) {
+	bytes.push_back(v & 0xff);
+	bytes.push_back((v >> 8) & 0xff);
+	bytes.push_back((v >> 16) & 0xff);
+	bytes.push_back((v >> 24) & 0xff);
+}
+
+void append_chunk_header(StdVector<uint8_t> &bytes, const char *id, uint32_t content_size, uint32_t children_size) {
+	for (unsigned int i = 0; i < 4; ++i) {
+		bytes.push_back(id[i]);
+	}
+	append_u32(bytes, content_size);
+	append_u32(bytes, children_size);
+}
+
+} // namespace
+
+void test_vox_data_decode_rotated_model() {
+	// Writes a .vox file with a single non-cubic model, in which some voxels are empty
+	const Vector3i magica_size(3, 5, 7);
+	StdVector<uint8_t> xyzi;
+	uint32_t voxel_count = 0;
+	for (int z = 0; z < magica_size.z; ++z) {
+		for (int y = 0; y < magica_size.y; ++y) {
+			for (int x = 0; x < magica_size.x; ++x) {
+				if ((x + 2 * y + 3 * z) % 3 == 0) {
+					continue;
+				}
+				xyzi.push_back(x);
+				xyzi.push_back(y);
+				xyzi.push_back(z);
+				// Index 0 is never used for voxels
+				xyzi.push_back(1 + (x + 3 * y + 15 * z) % 255);
+				++voxel_count;
+			}
+		}
+	}
+
+	StdVector<uint8_t> file_bytes;
+	file_bytes.push_back('V');
+	file_bytes.push_back('O');
+	file_bytes.push_back('X');
+	file_bytes.push_back(' ');
+	append_u32(file_bytes, 150);
+	const uint32_t chunk_header_size = 12;
+	const uint32_t size_chunk_size = chunk_header_size + 12;
+	const uint32_t xyzi_chunk_size = chunk_header_size + 4 + xyzi.size();
+	append_chunk_header(file_bytes, "MAIN", 0, size_chunk_size + xyzi_chunk_size);
+	append_chunk_header(file_bytes, "SIZE", 12, 0);
+	append_u32(file_bytes, magica_size.x);
+	append_u32(file_bytes, magica_size.y);
+	append_u32(file_bytes, magica_size.z);
+	append_chunk_header(file_bytes, "XYZI", 4 + xyzi.size(), 0);
+	append_u32(file_bytes, voxel_count);
+	file_bytes.insert(file_bytes.end(), xyzi.begin(), xyzi.end());
+
+	zylann::testing::TestDirectory test_dir;
+	ZN_TEST_ASSERT(test_dir.is_valid());
+	const String file_path = test_dir.get_path().path_join("test_vox_data.vox");
+	{
+		Error open_err;
+		Ref<FileAccess> f = godot::open_file(file_path, FileAccess::WRITE, open_err);
+		ZN_TEST_ASSERT(f.is_valid());
+		godot::store_buffer(**f, to_span_const(file_bytes));
+	}
+
+	// Eager decoding gives the reference model
+	magica::Data data;
+	ZN_TEST_ASSERT(data.load_from_file(file_path, true) == OK);
+	ZN_TEST_ASSERT(data.get_model_count() == 1);
+	const magica::Model &model = data.get_model(0);
+	ZN_TEST_ASSERT(model.voxel_count == voxel_count);
+
+	Error open_err;
+	Ref<FileAccess> f = godot::open_file(file_path, FileAccess::READ, open_err);
+	ZN_TEST_ASSERT(f.is_valid());
+	StdVector<uint8_t> xyzi_bytes;
+	ZN_TEST_ASSERT(data.read_model_voxels(**f, 0, xyzi_bytes) == OK);
+
+	const VoxelBuffer::ChannelId channel = VoxelBuffer::CHANNEL_COLOR;
+	const uint8_t initial_value = 255;
+	const Vector3i dst_origin(1, 2, 3);
+
+	// Every axis permutation, with every combination of flipped axes
+	const int permutations[6][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 } };
+
+	for (unsigned int permutation_index = 0; permutation_index < 6; ++permutation_index) {
+		for (unsigned int signs = 0; signs < 8; ++signs) {
+			IntBasis basis;
+			basis.x[permutations[permutation_index][0]] = (signs & 1) != 0 ? -1 : 1;
+			basis.y[permutations[permutation_index][1]] = (signs & 2) != 0 ? -1 : 1;
+			basis.z[permutations[permutation_index][2]] = (signs & 4) != 0 ? -1 : 1;
+
+			StdVector<uint8_t> expected;
+			expected.resize(model.color_indexes.size());
+			const Vector3i expected_size =
+					transform_3d_array_zxy(to_span_const(model.color_indexes), to_span(expected), model.size, basis);
+			ZN_TEST_ASSERT(expected_size == magica::get_transformed_size(model.size, basis));
+
+			// Decode into a bigger buffer, which already has voxels
+			VoxelBuffer dst(VoxelBuffer::ALLOCATOR_DEFAULT);
+			dst.create(expected_size + dst_origin + Vector3i(2, 2, 2));
+			dst.set_channel_depth(channel, VoxelBuffer::DEPTH_8_BIT);
+			dst.fill(initial_value, channel);
+			dst.decompress_channel(channel);
+
+			ZN_TEST_ASSERT(data.decode_model(0, to_span_const(xyzi_bytes), basis, dst, dst_origin) == OK);
+
+			Vector3i pos;
+			for (pos.z = 0; pos.z < expected_size.z; ++pos.z) {
+				for (pos.x = 0; pos.x < expected_size.x; ++pos.x) {
+					for (pos.y = 0; pos.y < expected_size.y; ++pos.y) {
+						const uint8_t expected_value = expected[Vector3iUtil::get_zxy_index(pos, expected_size)];
+						const uint8_t value = dst.get_voxel(pos + dst_origin, channel);
+						// Voxels absent from the model are left untouched
+						ZN_TEST_ASSERT(value == (expected_value == 0 ? initial_value : expected_value));
+					}
+				}
+			}
+		}
+	}
+}
+
+} // namespace zylann::voxel::tests
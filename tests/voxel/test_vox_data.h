@@ -0,0 +1,10 @@
+#ifndef VOXEL_TEST_VOX_DATA_H
+#define VOXEL_TEST_VOX_DATA_H
+
+namespace zylann::voxel::tests {
+
+void test_vox_data_decode_rotated_model();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TEST_VOX_DATA_H
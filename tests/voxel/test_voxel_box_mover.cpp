@@ -0,0 +1,130 @@
+#include "test_voxel_box_mover.h"
+#include "../../generators/simple/voxel_generator_flat.h"
+#include "../../meshers/blocky/voxel_blocky_library.h"
+#include "../../meshers/blocky/voxel_blocky_model_cube.h"
+#include "../../meshers/blocky/voxel_blocky_model_empty.h"
+#include "../../meshers/blocky/voxel_mesher_blocky.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../storage/voxel_data.h"
+#include "../../terrain/fixed_lod/voxel_box_mover.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+void test_voxel_box_mover_get_motions() {
+	Ref<VoxelBlockyLibrary> library;
+	library.instantiate();
+	{
+		Ref<VoxelBlockyModelEmpty> air;
+		air.instantiate();
+		library->add_model(air);
+	}
+	Ref<VoxelBlockyModelCube> solid;
+	solid.instantiate();
+	const AABB solid_box(Vector3(), Vector3(1, 1, 1));
+	solid->set_collision_aabbs(Span<const AABB>(&solid_box, 1));
+	const int solid_id = library->add_model(solid);
+	library->bake();
+
+	Ref<VoxelMesherBlocky> mesher;
+	mesher.instantiate();
+	mesher->set_library(library);
+
+	// Only the block at the origin is loaded. It has a floor with its top at y=1, and a step one voxel high for x >= 8.
+	VoxelData data;
+	const int block_size = data.get_block_size();
+	{
+		std::shared_ptr<VoxelBuffer> voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+		voxels->create(Vector3iUtil::create(block_size));
+		voxels->fill_area(solid_id, Vector3i(), Vector3i(block_size, 1, block_size), VoxelBuffer::CHANNEL_TYPE);
+		voxels->fill_area(solid_id, Vector3i(8, 1, 0), Vector3i(block_size, 2, block_size), VoxelBuffer::CHANNEL_TYPE);
+		VoxelDataBlock block(voxels, 0);
+		data.try_set_block(Vector3i(), block);
+	}
+	// Everything would be solid if the generator was used, but areas that are not loaded must not collide
+	{
+		Ref<VoxelGeneratorFlat> generator;
+		generator.instantiate();
+		generator->set_channel(VoxelBuffer::CHANNEL_TYPE);
+		generator->set_voxel_type(solid_id);
+		generator->set_height(100.f);
+		data.set_generator(generator);
+	}
+
+	Ref<VoxelBoxMover> mover;
+	mover.instantiate();
+	mover->set_step_climbing_enabled(true);
+	mover->set_max_step_height(1.f);
+
+	const AABB body_aabb(Vector3(-0.4f, 0.f, -0.4f), Vector3(0.8f, 1.8f, 0.8f));
+	const unsigned int body_count = 3;
+	const Vector3 positions[body_count] = {
+		// Falling on the floor
+		Vector3(4.5f, 1.2f, 4.5f),
+		// Falling in an area that isn't loaded
+		Vector3(block_size + 4.5f, 1.2f, 4.5f),
+		// Walking diagonally into the step
+		Vector3(7.5f, 1.f, 4.5f),
+	};
+	const Vector3 motions[body_count] = {
+		Vector3(0.f, -0.5f, 0.f),
+		Vector3(0.f, -0.5f, 0.f),
+		Vector3(0.5f, 0.f, 0.5f),
+	};
+	Vector3 out_motions[body_count];
+
+	mover->get_motions(
+			Span<const Vector3>(positions, body_count),
+			Span<const Vector3>(motions, body_count),
+			body_aabb,
+			data,
+			mesher,
+			Transform3D(),
+			Span<Vector3>(out_motions, body_count)
+	);
+
+	ZN_TEST_ASSERT(Math::abs(out_motions[0].y - (-0.2f)) < 0.01f);
+	ZN_TEST_ASSERT(!mover->has_body_stepped_up(0));
+
+	ZN_TEST_ASSERT(out_motions[1] == motions[1]);
+	ZN_TEST_ASSERT(!mover->has_body_stepped_up(1));
+
+	ZN_TEST_ASSERT(mover->has_body_stepped_up(2));
+	ZN_TEST_ASSERT(Math::abs(out_motions[2].y - 1.f) < 0.01f);
+	ZN_TEST_ASSERT(Math::abs(out_motions[2].x - motions[2].x) < 0.01f);
+	ZN_TEST_ASSERT(Math::abs(out_motions[2].z - motions[2].z) < 0.01f);
+
+	// Each body gets the same result as when moved alone
+	for (unsigned int i = 0; i < body_count; ++i) {
+		Vector3 out_motion;
+		mover->get_motions(
+				Span<const Vector3>(&positions[i], 1),
+				Span<const Vector3>(&motions[i], 1),
+				body_aabb,
+				data,
+				mesher,
+				Transform3D(),
+				Span<Vector3>(&out_motion, 1)
+		);
+		ZN_TEST_ASSERT(out_motion == out_motions[i]);
+	}
+
+	// Collision boxes are cached, but changes to the library must be taken into account
+	solid->set_collision_mask(2);
+	library->bake();
+	mover->get_motions(
+			Span<const Vector3>(positions, body_count),
+			Span<const Vector3>(motions, body_count),
+			body_aabb,
+			data,
+			mesher,
+			Transform3D(),
+			Span<Vector3>(out_motions, body_count)
+	);
+	for (unsigned int i = 0; i < body_count; ++i) {
+		ZN_TEST_ASSERT(out_motions[i] == motions[i]);
+		ZN_TEST_ASSERT(!mover->has_body_stepped_up(i));
+	}
+}
+
+} // namespace zylann::voxel::tests
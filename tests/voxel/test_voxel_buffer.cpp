@@ -1,8 +1,11 @@
 #include "test_voxel_buffer.h"
+#include "../../storage/chunked_voxel_buffer.h"
 #include "../../storage/metadata/voxel_metadata_factory.h"
 #include "../../storage/metadata/voxel_metadata_variant.h"
 #include "../../storage/voxel_buffer_gd.h"
+#include "../../storage/voxel_schematic_gd.h"
 #include "../../streams/voxel_block_serializer.h"
+#include "../../util/godot/core/random_pcg.h"
 #include "../../util/string/std_stringstream.h"
 #include "../testing.h"
 #include <sstream>
@@ -378,4 +381,214 @@ void test_voxel_buffer_paste_masked() {
 	ZN_TEST_ASSERT(dst.equals(expected));
 }
 
+void test_chunked_voxel_buffer_paste_transformed() {
+	// Source data not aligned to the block size, with an empty area, a uniform area and random values
+	const Vector3i src_size(37, 21, 19);
+	const unsigned int channel = VoxelBuffer::CHANNEL_COLOR;
+
+	VoxelBuffer src(VoxelBuffer::ALLOCATOR_DEFAULT);
+	src.create(src_size);
+	RandomPCG rng;
+	rng.seed(131183);
+	src.fill_area(0, Vector3i(0, 0, 0), Vector3i(37, 21, 8), channel);
+	src.fill_area(7, Vector3i(0, 0, 8), Vector3i(37, 10, 16), channel);
+	Box3i(Vector3i(0, 10, 8), Vector3i(37, 11, 11)).for_each_cell_zxy([&src, &rng](Vector3i pos) {
+		src.set_voxel(rng.rand() % 256, pos, channel);
+	});
+
+	ChunkedVoxelBuffer chunked;
+	chunked.create(src_size, 3);
+	Box3i(Vector3i(), chunked.get_size_in_blocks()).for_each_cell_zxy([&src, &chunked](Vector3i bpos) {
+		const Box3i box = chunked.get_block_box(bpos);
+		std::shared_ptr<VoxelBuffer> block = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+		block->create(box.size);
+		block->copy_channel_from(src, box.position, box.position + box.size, Vector3i(), channel);
+		chunked.set_block(bpos, block);
+	});
+
+	ZN_TEST_ASSERT(chunked.get_allocated_block_count() > 0);
+	ZN_TEST_ASSERT(chunked.get_allocated_block_count() < Vector3iUtil::get_volume(chunked.get_size_in_blocks()));
+
+	Span<const uint8_t> src_data;
+	ZN_TEST_ASSERT(src.get_channel_as_bytes_read_only(channel, src_data));
+
+	const uint8_t channels[] = { channel };
+
+	const IntBasis bases[] = {
+		// Identity
+		{ Vector3i(1, 0, 0), Vector3i(0, 1, 0), Vector3i(0, 0, 1) },
+		// Rotation around Y
+		{ Vector3i(0, 0, -1), Vector3i(0, 1, 0), Vector3i(1, 0, 0) },
+		// Mirror X
+		{ Vector3i(-1, 0, 0), Vector3i(0, 1, 0), Vector3i(0, 0, 1) },
+		// Rotation around Z and mirror Z
+		{ Vector3i(0, 1, 0), Vector3i(-1, 0, 0), Vector3i(0, 0, -1) },
+	};
+
+	for (const IntBasis &basis : bases) {
+		const OrthoGridTransform transform = OrthoGridTransform::create(src_size, basis);
+
+		// Reference result
+		StdVector<uint8_t> expected;
+		expected.resize(src_data.size());
+		const Vector3i expected_size = transform_3d_array_zxy(src_data, to_span(expected), src_size, basis);
+		ZN_TEST_ASSERT(expected_size == transform.dst_size);
+
+		// Paste partially outside of the destination, which also has a different size
+		const Vector3i dst_size(30, 40, 25);
+		const Vector3i dst_base_pos(-3, 2, 5);
+		VoxelBuffer dst(VoxelBuffer::ALLOCATOR_DEFAULT);
+		dst.create(dst_size);
+		dst.fill(255, channel);
+
+		chunked.paste_to(Span<const uint8_t>(channels, 1), transform, dst, dst_base_pos);
+
+		Box3i(Vector3i(), dst_size).for_each_cell_zxy([&](Vector3i pos) {
+			const Vector3i tpos = pos - dst_base_pos;
+			const uint64_t v = dst.get_voxel(pos, channel);
+			if (Box3i(Vector3i(), transform.dst_size).contains(tpos)) {
+				const uint8_t expected_v = expected[Vector3iUtil::get_zxy_index(tpos, transform.dst_size)];
+				ZN_TEST_ASSERT(v == expected_v);
+				ZN_TEST_ASSERT(src.get_voxel(transform.dst_to_src(tpos), channel) == expected_v);
+			} else {
+				ZN_TEST_ASSERT(v == 255);
+			}
+		});
+	}
+}
+
+void test_voxel_schematic_copy_on_write() {
+	Ref<godot::VoxelSchematic> schematic;
+	schematic.instantiate();
+	schematic->create(Vector3i(20, 20, 20));
+
+	// Missing blocks read as default values
+	VoxelBuffer defaults(VoxelBuffer::ALLOCATOR_DEFAULT);
+	defaults.create(Vector3i(1, 1, 1));
+	for (unsigned int channel = 0; channel < VoxelBuffer::MAX_CHANNELS; ++channel) {
+		ZN_TEST_ASSERT(schematic->get_voxel_f(Vector3i(3, 4, 5), channel) == defaults.get_voxel_f(Vector3i(), channel));
+	}
+
+	// Like an async task still reading the schematic
+	std::shared_ptr<const ChunkedVoxelBuffer> reader = schematic->get_buffer_shared();
+
+	ChunkedVoxelBuffer &writer = schematic->get_buffer_for_write();
+	ZN_TEST_ASSERT(&writer != reader.get());
+	const Box3i box = writer.get_block_box(Vector3i());
+	std::shared_ptr<VoxelBuffer> block = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+	block->create(box.size);
+	block->fill(7, VoxelBuffer::CHANNEL_COLOR);
+	writer.set_block(Vector3i(), block);
+
+	ZN_TEST_ASSERT(schematic->get_voxel(Vector3i(1, 1, 1), VoxelBuffer::CHANNEL_COLOR) == 7);
+	ZN_TEST_ASSERT(reader->get_voxel(Vector3i(1, 1, 1), VoxelBuffer::CHANNEL_COLOR) == 0);
+	ZN_TEST_ASSERT(reader->get_allocated_block_count() == 0);
+
+	// Once the reader is gone, writing doesn't copy anymore
+	reader.reset();
+	ZN_TEST_ASSERT(&schematic->get_buffer_for_write() == &writer);
+}
+
+void test_voxel_buffer_xor_delta() {
+	const Vector3i size(16, 16, 16);
+
+	VoxelBuffer prev(VoxelBuffer::ALLOCATOR_DEFAULT);
+	prev.create(size);
+	prev.set_channel_depth(VoxelBuffer::CHANNEL_SDF, VoxelBuffer::DEPTH_16_BIT);
+	prev.fill(3, VoxelBuffer::CHANNEL_TYPE);
+	for (int z = 0; z < size.z; ++z) {
+		for (int x = 0; x < size.x; ++x) {
+			for (int y = 0; y < size.y; ++y) {
+				prev.set_voxel_f(y - 8.f, Vector3i(x, y, z), VoxelBuffer::CHANNEL_SDF);
+			}
+		}
+	}
+
+	// A few edits, with the TYPE channel uniform in the source and not in the result
+	VoxelBuffer current(VoxelBuffer::ALLOCATOR_DEFAULT);
+	current.create(size);
+	current.copy_format(prev);
+	current.copy_channels_from(prev);
+	current.set_voxel(5, Vector3i(1, 2, 3), VoxelBuffer::CHANNEL_TYPE);
+	current.fill_area_f(-1.f, Vector3i(4, 4, 4), Vector3i(8, 8, 8), VoxelBuffer::CHANNEL_SDF);
+	current.fill(7, VoxelBuffer::CHANNEL_COLOR);
+
+	VoxelBuffer delta(VoxelBuffer::ALLOCATOR_DEFAULT);
+	delta.create(size);
+	delta.copy_format(prev);
+	delta.copy_channels_from(prev);
+	delta.xor_channels_from(current);
+	delta.compress_uniform_channels();
+
+	// Unchanged voxels are zero
+	ZN_TEST_ASSERT(delta.get_voxel(Vector3i(0, 0, 0), VoxelBuffer::CHANNEL_TYPE) == 0);
+	ZN_TEST_ASSERT(delta.get_voxel(Vector3i(1, 2, 3), VoxelBuffer::CHANNEL_TYPE) == (3 ^ 5));
+	ZN_TEST_ASSERT(delta.get_voxel(Vector3i(0, 0, 0), VoxelBuffer::CHANNEL_SDF) == 0);
+	ZN_TEST_ASSERT(delta.get_channel_compression(VoxelBuffer::CHANNEL_COLOR) == VoxelBuffer::COMPRESSION_UNIFORM);
+
+	// Applying the delta to the previous version gives the current one
+	VoxelBuffer result(VoxelBuffer::ALLOCATOR_DEFAULT);
+	result.create(size);
+	result.copy_format(prev);
+	result.copy_channels_from(prev);
+	result.xor_channels_from(delta);
+	ZN_TEST_ASSERT(result.equals(current));
+
+	// Deltas compress better than full contents
+	const size_t full_size = BlockSerializer::serialize_and_compress(current).data.size();
+	const size_t delta_size = BlockSerializer::serialize_and_compress(delta).data.size();
+	ZN_TEST_ASSERT(delta_size < full_size);
+}
+
+void test_voxel_buffer_channel_bulk_copy() {
+	const Vector3i size(8, 9, 10);
+
+	VoxelBuffer src(VoxelBuffer::ALLOCATOR_DEFAULT);
+	src.create(size);
+	src.set_channel_depth(VoxelBuffer::CHANNEL_SDF, VoxelBuffer::DEPTH_16_BIT);
+	src.fill(3, VoxelBuffer::CHANNEL_TYPE);
+	for (int z = 0; z < size.z; ++z) {
+		for (int x = 0; x < size.x; ++x) {
+			for (int y = 0; y < size.y; ++y) {
+				src.set_voxel_f(y - 4.5f, Vector3i(x, y, z), VoxelBuffer::CHANNEL_SDF);
+			}
+		}
+	}
+	src.set_voxel(5, Vector3i(1, 2, 3), VoxelBuffer::CHANNEL_COLOR);
+
+	VoxelBuffer dst(VoxelBuffer::ALLOCATOR_DEFAULT);
+	dst.create(size);
+	dst.copy_format(src);
+
+	// Raw values, including a uniform channel which gets expanded
+	StdVector<uint8_t> bytes;
+	for (const unsigned int channel_index : { VoxelBuffer::CHANNEL_TYPE, VoxelBuffer::CHANNEL_COLOR }) {
+		bytes.resize(VoxelBuffer::get_size_in_bytes_for_volume(size, src.get_channel_depth(channel_index)));
+		src.copy_channel_to_bytes(channel_index, to_span(bytes));
+		dst.copy_channel_from_bytes(channel_index, to_span_const(bytes));
+	}
+	ZN_TEST_ASSERT(dst.get_voxel(Vector3i(7, 8, 9), VoxelBuffer::CHANNEL_TYPE) == 3);
+	ZN_TEST_ASSERT(dst.get_voxel(Vector3i(1, 2, 3), VoxelBuffer::CHANNEL_COLOR) == 5);
+	ZN_TEST_ASSERT(dst.get_voxel(Vector3i(0, 0, 0), VoxelBuffer::CHANNEL_COLOR) == 0);
+
+	// Decoded values go through the same conversion as single voxel accessors
+	StdVector<float> sdf;
+	sdf.resize(src.get_volume());
+	src.copy_channel_to_floats(VoxelBuffer::CHANNEL_SDF, to_span(sdf));
+	ZN_TEST_ASSERT(sdf[0] == src.get_voxel_f(Vector3i(0, 0, 0), VoxelBuffer::CHANNEL_SDF));
+	dst.copy_channel_from_floats(VoxelBuffer::CHANNEL_SDF, to_span_const(sdf));
+
+	for (int z = 0; z < size.z; ++z) {
+		for (int x = 0; x < size.x; ++x) {
+			for (int y = 0; y < size.y; ++y) {
+				const Vector3i pos(x, y, z);
+				const float expected = src.get_voxel_f(pos, VoxelBuffer::CHANNEL_SDF);
+				const float actual = dst.get_voxel_f(pos, VoxelBuffer::CHANNEL_SDF);
+				// Quantization may round differently after a decode/encode trip
+				ZN_TEST_ASSERT(Math::abs(actual - expected) < 0.01f);
+			}
+		}
+	}
+}
+
 } // namespace zylann::voxel::tests
@@ -7,6 +7,10 @@ void test_voxel_buffer_create();
 void test_voxel_buffer_metadata();
 void test_voxel_buffer_metadata_gd();
 void test_voxel_buffer_paste_masked();
+void test_chunked_voxel_buffer_paste_transformed();
+void test_voxel_schematic_copy_on_write();
+void test_voxel_buffer_xor_delta();
+void test_voxel_buffer_channel_bulk_copy();
 
 } // namespace zylann::voxel::tests
 
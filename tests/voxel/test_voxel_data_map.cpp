@@ -1,7 +1,9 @@
 #include "test_voxel_data_map.h"
 #include "../../storage/voxel_buffer.h"
 #include "../../storage/voxel_data_map.h"
+#include "../../util/thread/thread.h"
 #include "../testing.h"
+#include <atomic>
 
 namespace zylann::voxel::tests {
 
@@ -162,4 +164,73 @@ void test_voxel_data_map_copy() {
 	ZN_TEST_ASSERT(buffer.equals(buffer2));
 }
 
+void test_voxel_data_map_concurrent_lookups() {
+	// One thread keeps adding and removing blocks, while the main thread looks up blocks without locking. Blocks that
+	// are never removed must always be found.
+	// Blocks removed from the lookup table leave markers that are reused only if a block is added at the same position,
+	// so the changing area moves every time, to fill up the table and force it to be rebuilt many times.
+
+	static const int STABLE_AREA_SIZE = 8;
+	static const int CHANGING_AREA_SIZE = 16;
+	static const unsigned int MIN_ITERATIONS = 16;
+
+	struct Context {
+		VoxelDataMap map;
+		std::atomic_bool stop = { false };
+		std::atomic_uint iteration_count = { 0 };
+	};
+
+	Context context;
+	context.map.create(0);
+
+	const Box3i stable_area(Vector3i(), Vector3iUtil::create(STABLE_AREA_SIZE));
+	stable_area.for_each_cell_zxy([&context](Vector3i bpos) { //
+		context.map.set_empty_block(bpos, false);
+	});
+
+	const unsigned int rebuild_count_before = context.map.get_index_rebuild_count();
+
+	Thread thread;
+	thread.start(
+			[](void *userdata) {
+				Context &ctx = *static_cast<Context *>(userdata);
+				Box3i changing_area(Vector3i(STABLE_AREA_SIZE, 0, 0), Vector3iUtil::create(CHANGING_AREA_SIZE));
+				while (!ctx.stop) {
+					changing_area.for_each_cell_zxy([&ctx](Vector3i bpos) { //
+						ctx.map.set_empty_block(bpos, false);
+					});
+					changing_area.for_each_cell_zxy([&ctx](Vector3i bpos) { //
+						ctx.map.remove_block(bpos, VoxelDataMap::NoAction());
+					});
+					changing_area.position.x += CHANGING_AREA_SIZE;
+					++ctx.iteration_count;
+				}
+			},
+			&context
+	);
+
+	bool all_found = true;
+	bool none_found_outside = true;
+
+	for (int i = 0; i < 200 || context.iteration_count < MIN_ITERATIONS; ++i) {
+		stable_area.for_each_cell_zxy([&context, &all_found](Vector3i bpos) {
+			if (context.map.get_block(bpos) == nullptr) {
+				all_found = false;
+			}
+		});
+		if (context.map.has_block(Vector3i(-1, 0, 0))) {
+			none_found_outside = false;
+		}
+	}
+
+	context.stop = true;
+	thread.wait_to_finish();
+
+	ZN_TEST_ASSERT(all_found);
+	ZN_TEST_ASSERT(none_found_outside);
+	ZN_TEST_ASSERT(context.map.get_block_count() == Vector3iUtil::get_volume(stable_area.size));
+	// The table must have been rebuilt while lookups were running, not only when it was first filled
+	ZN_TEST_ASSERT(context.map.get_index_rebuild_count() > rebuild_count_before + 1);
+}
+
 } // namespace zylann::voxel::tests
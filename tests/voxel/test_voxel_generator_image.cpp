@@ -0,0 +1,233 @@
+#include "test_voxel_generator_image.h"
+#include "../../generators/simple/voxel_generator_image.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../util/godot/classes/image.h"
+#include "../../util/godot/image_sampler.h"
+#include "../../util/math/funcs.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+namespace {
+
+// Smooth heights between 0.25 and 0.75
+float get_test_height(int x, int y) {
+	return 0.5f + 0.125f * (Math::sin(x * 0.3f) + Math::cos(y * 0.2f));
+}
+
+Ref<Image> create_test_image(int width, int height, Image::Format format) {
+	Ref<Image> image = zylann::godot::create_empty_image(width, height, false, format);
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			const float h = get_test_height(x, y);
+			image->set_pixel(x, y, Color(h, h, h));
+		}
+	}
+	return image;
+}
+
+Ref<Image> create_test_image(int size, Image::Format format) {
+	return create_test_image(size, size, format);
+}
+
+} // namespace
+
+void test_image_sampler() {
+	using zylann::godot::ImageSampler;
+
+	const int size = 8;
+	// RGB565 is not read directly, it tests the fallback
+	const Image::Format formats[] = {
+		Image::FORMAT_L8, //
+		Image::FORMAT_R8, //
+		Image::FORMAT_RGBA8, //
+		Image::FORMAT_RH, //
+		Image::FORMAT_RGBAH, //
+		Image::FORMAT_RF, //
+		Image::FORMAT_RGBF, //
+		Image::FORMAT_RGB565 //
+	};
+
+	for (const Image::Format format : formats) {
+		Ref<Image> image = create_test_image(size, format);
+		ImageSampler sampler;
+		sampler.set_image(image);
+		ZN_TEST_ASSERT(sampler.is_valid());
+		ZN_TEST_ASSERT(sampler.get_mipmap_count() == 1);
+
+		for (int y = 0; y < size; ++y) {
+			for (int x = 0; x < size; ++x) {
+				const float expected = image->get_pixel(x, y).r;
+				ZN_TEST_ASSERT(Math::is_equal_approx(sampler.get_pixel_repeat(x, y, 0), expected));
+				// Repeats
+				ZN_TEST_ASSERT(Math::is_equal_approx(sampler.get_pixel_repeat(x - size, y + size, 0), expected));
+				// Pixel centers are at integer coordinates
+				ZN_TEST_ASSERT(Math::is_equal_approx(sampler.get_pixel_repeat_bilinear(x, y, 0), expected));
+			}
+		}
+
+		const float between = sampler.get_pixel_repeat_bilinear(2.5f, 3.f, 0);
+		const float expected_between = 0.5f * (image->get_pixel(2, 3).r + image->get_pixel(3, 3).r);
+		ZN_TEST_ASSERT(Math::is_equal_approx(between, expected_between));
+	}
+	{
+		// Mipmaps
+		Ref<Image> image = create_test_image(size, Image::FORMAT_RF);
+		image->generate_mipmaps();
+		ImageSampler sampler;
+		sampler.set_image(image);
+		ZN_TEST_ASSERT(static_cast<int>(sampler.get_mipmap_count()) == image->get_mipmap_count() + 1);
+		ZN_TEST_ASSERT(sampler.get_width(1) == size / 2);
+		ZN_TEST_ASSERT(sampler.get_height(1) == size / 2);
+		ZN_TEST_ASSERT(sampler.get_width(sampler.get_mipmap_count() - 1) == 1);
+
+		// Full-size image is unchanged
+		ZN_TEST_ASSERT(Math::is_equal_approx(sampler.get_pixel_repeat(5, 6, 0), image->get_pixel(5, 6).r));
+
+		// Pixels of smaller mipmaps are averages of bigger ones
+		const float average = 0.25f *
+				(image->get_pixel(2, 4).r + image->get_pixel(3, 4).r + image->get_pixel(2, 5).r +
+				 image->get_pixel(3, 5).r);
+		ZN_TEST_ASSERT(Math::is_equal_approx(sampler.get_pixel_repeat(1, 2, 1), average, 0.001f));
+	}
+	{
+		// Half floats
+		ZN_TEST_ASSERT(ImageSampler::half_to_float(0x0000) == 0.f);
+		ZN_TEST_ASSERT(ImageSampler::half_to_float(0x3c00) == 1.f);
+		ZN_TEST_ASSERT(ImageSampler::half_to_float(0xc000) == -2.f);
+		ZN_TEST_ASSERT(ImageSampler::half_to_float(0x3800) == 0.5f);
+		// Smallest denormal
+		ZN_TEST_ASSERT(ImageSampler::half_to_float(0x0001) == Math::pow(2.f, -24.f));
+	}
+}
+
+void test_voxel_generator_image() {
+	Ref<VoxelGeneratorImage> generator;
+	generator.instantiate();
+	generator->set_image(create_test_image(32, Image::FORMAT_RF));
+	// Ground goes from -5 to 5
+	generator->set_height_start(-10.f);
+	generator->set_height_range(20.f);
+
+	const Vector3i block_size(16, 16, 16);
+
+	{
+		// SDF, crossing the ground
+		generator->set_channel(VoxelBuffer::CHANNEL_SDF);
+		VoxelBuffer buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer.create(block_size);
+		const Vector3i origin(-8, -8, -8);
+		VoxelGenerator::VoxelQueryData query{ buffer, origin, 0 };
+		generator->generate_block(query);
+
+		// Step between quantized values is about 0.015
+		const float tolerance = 0.02f;
+		Vector3i pos;
+		for (pos.z = 0; pos.z < block_size.z; ++pos.z) {
+			for (pos.x = 0; pos.x < block_size.x; ++pos.x) {
+				for (pos.y = 0; pos.y < block_size.y; ++pos.y) {
+					const float sd = buffer.get_voxel_f(pos, VoxelBuffer::CHANNEL_SDF);
+					const float expected = generator->generate_single(origin + pos, VoxelBuffer::CHANNEL_SDF).f;
+					ZN_TEST_ASSERT(Math::abs(sd - expected) < tolerance);
+				}
+			}
+		}
+	}
+	{
+		// SDF, far enough above ground for values to saturate, but not above the maximum height.
+		// Ground goes from -750 to 750.
+		generator->set_channel(VoxelBuffer::CHANNEL_SDF);
+		generator->set_height_start(-1500.f);
+		generator->set_height_range(3000.f);
+		VoxelBuffer buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer.create(block_size);
+		VoxelGenerator::VoxelQueryData query{ buffer, Vector3i(0, 1400, 0), 0 };
+		generator->generate_block(query);
+		ZN_TEST_ASSERT(buffer.get_channel_compression(VoxelBuffer::CHANNEL_SDF) == VoxelBuffer::COMPRESSION_UNIFORM);
+		ZN_TEST_ASSERT(buffer.get_voxel_f(Vector3i(), VoxelBuffer::CHANNEL_SDF) > 0.f);
+		generator->set_height_start(-10.f);
+		generator->set_height_range(20.f);
+	}
+	{
+		// Blocky, entirely below ground
+		generator->set_channel(VoxelBuffer::CHANNEL_TYPE);
+		VoxelBuffer buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer.create(block_size);
+		const Vector3i origin(0, -22, 0);
+		VoxelGenerator::VoxelQueryData query{ buffer, origin, 0 };
+		generator->generate_block(query);
+		ZN_TEST_ASSERT(buffer.get_channel_compression(VoxelBuffer::CHANNEL_TYPE) == VoxelBuffer::COMPRESSION_UNIFORM);
+		ZN_TEST_ASSERT(buffer.get_voxel(Vector3i(), VoxelBuffer::CHANNEL_TYPE) == 1);
+		const Vector3i top_pos = origin + block_size - Vector3i(1, 1, 1);
+		ZN_TEST_ASSERT(generator->generate_single(top_pos, VoxelBuffer::CHANNEL_TYPE).i == 1);
+	}
+	{
+		// Blocky, crossing the ground
+		generator->set_channel(VoxelBuffer::CHANNEL_TYPE);
+		VoxelBuffer buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer.create(block_size);
+		const Vector3i origin(-8, -8, -8);
+		VoxelGenerator::VoxelQueryData query{ buffer, origin, 0 };
+		generator->generate_block(query);
+
+		Vector3i pos;
+		for (pos.z = 0; pos.z < block_size.z; ++pos.z) {
+			for (pos.x = 0; pos.x < block_size.x; ++pos.x) {
+				for (pos.y = 0; pos.y < block_size.y; ++pos.y) {
+					const int v = buffer.get_voxel(pos, VoxelBuffer::CHANNEL_TYPE);
+					const int expected = generator->generate_single(origin + pos, VoxelBuffer::CHANNEL_TYPE).i;
+					ZN_TEST_ASSERT(v == expected);
+				}
+			}
+		}
+	}
+	{
+		// Lower LODs sample mipmaps, which gives the same ground as averaging the full-size image
+		generator->set_channel(VoxelBuffer::CHANNEL_SDF);
+		VoxelBuffer buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer.create(block_size);
+		VoxelGenerator::VoxelQueryData query{ buffer, Vector3i(0, -16, 0), 1 };
+		generator->generate_block(query);
+
+		const float average_height = -10.f +
+				20.f * 0.25f *
+						(get_test_height(4, 6) + get_test_height(5, 6) + get_test_height(4, 7) +
+						 get_test_height(5, 7));
+		// Voxel (2, 0, 3) at LOD 1 is at (4, -16, 6) in world space
+		const float sd = buffer.get_voxel_f(Vector3i(2, 0, 3), VoxelBuffer::CHANNEL_SDF);
+		ZN_TEST_ASSERT(Math::abs(sd - (-16.f - average_height)) < 0.05f);
+	}
+}
+
+void test_voxel_generator_image_non_power_of_two() {
+	// Lower LODs must repeat the image with the same period as LOD 0, even if its size isn't a power of two
+	const int width = 20;
+	const int height = 10;
+	Ref<VoxelGeneratorImage> generator;
+	generator.instantiate();
+	generator->set_image(create_test_image(width, height, Image::FORMAT_RF));
+	generator->set_height_start(-10.f);
+	generator->set_height_range(20.f);
+	generator->set_channel(VoxelBuffer::CHANNEL_SDF);
+
+	const Vector3i block_size(16, 16, 16);
+	// Multiple of the image size, but not of the size of its smaller mipmaps
+	const Vector3i period_offset(51 * width, 0, 102 * height);
+
+	for (unsigned int lod = 0; lod < 4; ++lod) {
+		VoxelBuffer buffer0(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer0.create(block_size);
+		const Vector3i origin(0, -8 << lod, 0);
+		VoxelGenerator::VoxelQueryData query0{ buffer0, origin, lod };
+		generator->generate_block(query0);
+
+		VoxelBuffer buffer1(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer1.create(block_size);
+		VoxelGenerator::VoxelQueryData query1{ buffer1, origin + period_offset, lod };
+		generator->generate_block(query1);
+
+		ZN_TEST_ASSERT(buffer0.equals(buffer1));
+	}
+}
+
+} // namespace zylann::voxel::tests
@@ -0,0 +1,12 @@
+#ifndef VOXEL_TESTS_VOXEL_GENERATOR_IMAGE_H
+#define VOXEL_TESTS_VOXEL_GENERATOR_IMAGE_H
+
+namespace zylann::voxel::tests {
+
+void test_image_sampler();
+void test_voxel_generator_image();
+void test_voxel_generator_image_non_power_of_two();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TESTS_VOXEL_GENERATOR_IMAGE_H
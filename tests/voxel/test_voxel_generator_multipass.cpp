@@ -0,0 +1,423 @@
+#include "test_voxel_generator_multipass.h"
+#include "../../generators/multipass/generate_column_multipass_task.h"
+#include "../../generators/multipass/load_column_multipass_task.h"
+#include "../../generators/multipass/voxel_generator_multipass_cb.h"
+#include "../../storage/metadata/voxel_metadata.h"
+#include "../../streams/voxel_stream_memory.h"
+#include "../../util/godot/classes/time.h"
+#include "../../util/thread/thread.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+using namespace VoxelGeneratorMultipassCBStructs;
+
+namespace {
+
+static constexpr int BLOCK_SIZE = 16;
+
+class DummyTask : public IThreadedTask {
+public:
+	void run(ThreadedTaskContext &ctx) override {}
+};
+
+// Counts how many times tasks got scheduled, since the engine deletes them after they run
+class CountingTask : public IThreadedTask {
+public:
+	CountingTask(std::shared_ptr<std::atomic_int> p_counter) : _counter(p_counter) {}
+
+	void run(ThreadedTaskContext &ctx) override {
+		++(*_counter);
+	}
+
+private:
+	std::shared_ptr<std::atomic_int> _counter;
+};
+
+bool wait_for_count(const std::atomic_int &counter, int expected_count) {
+	const uint64_t time_before = Time::get_singleton()->get_ticks_msec();
+	while (counter < expected_count && Time::get_singleton()->get_ticks_msec() - time_before < 5000) {
+		Thread::sleep_usec(1000);
+	}
+	// Give a chance to tasks scheduled more than once to run
+	Thread::sleep_usec(10000);
+	return counter == expected_count;
+}
+
+inline Box3i get_column_box(int x) {
+	return Box3i(Vector3i(x, 0, 0), Vector3i(1, 1, 1));
+}
+
+// Moves a viewer requesting a single column, and marks the new column as partially generated so it gets cached when
+// unloaded
+void move_viewer_to_column(VoxelGeneratorMultipassCB &generator, ViewerID viewer_id, int x, int prev_x) {
+	generator.process_viewer_diff(viewer_id, get_column_box(x), get_column_box(prev_x));
+	Column *column = generator.get_internal()->map.find_column(Vector2i(x, 0));
+	ZN_ASSERT(column != nullptr);
+	column->subpass_index = 0;
+}
+
+void fill_column(StdVector<Block> &blocks, int height, int value) {
+	blocks.resize(height);
+	for (Block &block : blocks) {
+		block.voxels.create(Vector3iUtil::create(BLOCK_SIZE));
+		block.voxels.fill(value, VoxelBuffer::CHANNEL_TYPE);
+	}
+}
+
+// Runs the task looking up a fully generated column, like a column task would before generating it
+StdVector<VoxelBuffer> load_column(std::shared_ptr<Internal> internal, Vector2i cpos) {
+	StdVector<VoxelBuffer> blocks;
+	LoadColumnMultipassTask task;
+	task.column_position = cpos;
+	task.block_size = BLOCK_SIZE;
+	task.generator_internal = internal;
+	task.out_blocks = &blocks;
+	// Scheduled by the task when it finishes
+	task.caller_task = ZN_NEW(DummyTask);
+	ThreadedTaskContext ctx(0, TaskPriority());
+	task.run(ctx);
+	return blocks;
+}
+
+bool wait_for_pending_saves(PendingColumnSaves &pending_saves) {
+	const uint64_t time_before = Time::get_singleton()->get_ticks_msec();
+	while (Time::get_singleton()->get_ticks_msec() - time_before < 5000) {
+		{
+			MutexLock mlock(pending_saves.mutex);
+			if (pending_saves.columns.size() == 0) {
+				return true;
+			}
+		}
+		Thread::sleep_usec(1000);
+	}
+	return false;
+}
+
+bool has_block_in_stream(VoxelStream &stream, Vector3i bpos) {
+	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
+	voxels.create(Vector3iUtil::create(BLOCK_SIZE));
+	VoxelStream::VoxelQueryData query{ voxels, bpos, 0, VoxelStream::RESULT_ERROR };
+	stream.load_voxel_block(query);
+	return query.result == VoxelStream::RESULT_BLOCK_FOUND;
+}
+
+} // namespace
+
+void test_voxel_generator_multipass_column_persistence() {
+	static constexpr int COLUMN_HEIGHT = 2;
+	static constexpr int COLUMN_VALUE = 42;
+
+	Ref<VoxelStreamMemory> stream;
+	stream.instantiate();
+
+	Ref<VoxelGeneratorMultipassCB> generator;
+	generator.instantiate();
+	generator->set_pass_count(2);
+	generator->set_column_base_y_blocks(0);
+	generator->set_column_height_blocks(COLUMN_HEIGHT);
+	generator->set_column_cache_stream(stream);
+
+	const Vector2i finished_cpos(0, 0);
+	const Vector2i unfinished_cpos(1, 0);
+	const Vector2i unfinished_cached_cpos(2, 0);
+
+	std::shared_ptr<Internal> internal = generator->get_internal();
+	const int final_subpass_index =
+			VoxelGeneratorMultipassCB::get_subpass_count_from_pass_count(internal->passes.size()) - 1;
+
+	// Columns as they would be after generation ran for a while
+	{
+		Column &column = internal->map.get_shard(finished_cpos).columns[finished_cpos];
+		column.subpass_index = final_subpass_index;
+		fill_column(column.blocks, COLUMN_HEIGHT, COLUMN_VALUE);
+	}
+	{
+		Column &column = internal->map.get_shard(unfinished_cpos).columns[unfinished_cpos];
+		column.subpass_index = 0;
+		fill_column(column.blocks, COLUMN_HEIGHT, COLUMN_VALUE);
+	}
+	{
+		ColumnCache::Entry &entry = internal->column_cache.columns[unfinished_cached_cpos];
+		entry.subpass_index = final_subpass_index - 1;
+		fill_column(entry.blocks, COLUMN_HEIGHT, COLUMN_VALUE);
+	}
+
+	// Saves columns, as when the terrain stops using the generator
+	generator->clear_cache();
+	ZN_TEST_ASSERT(wait_for_pending_saves(*internal->pending_column_saves));
+
+	const uint64_t saved_params_hash = internal->column_params_hash;
+
+	// Only the fully generated column got saved
+	for (int y = 0; y < COLUMN_HEIGHT; ++y) {
+		ZN_TEST_ASSERT(has_block_in_stream(**stream, Vector3i(finished_cpos.x, y, finished_cpos.y)));
+		ZN_TEST_ASSERT(!has_block_in_stream(**stream, Vector3i(unfinished_cpos.x, y, unfinished_cpos.y)));
+		ZN_TEST_ASSERT(
+				!has_block_in_stream(**stream, Vector3i(unfinished_cached_cpos.x, y, unfinished_cached_cpos.y))
+		);
+	}
+
+	// Pairing a viewer updates the hash of the new internal instance, which should be the same since no params changed
+	generator->process_viewer_diff(ViewerID(), Box3i(), Box3i());
+	internal = generator->get_internal();
+	ZN_TEST_ASSERT(internal->column_params_hash == saved_params_hash);
+
+	{
+		StdVector<VoxelBuffer> blocks = load_column(internal, finished_cpos);
+		ZN_TEST_ASSERT(blocks.size() == COLUMN_HEIGHT);
+		for (const VoxelBuffer &voxels : blocks) {
+			ZN_TEST_ASSERT(voxels.get_size() == Vector3iUtil::create(BLOCK_SIZE));
+			ZN_TEST_ASSERT(voxels.get_voxel(Vector3i(1, 2, 3), VoxelBuffer::CHANNEL_TYPE) == COLUMN_VALUE);
+			// Metadata is only used to validate saved columns
+			ZN_TEST_ASSERT(voxels.get_block_metadata().get_type() == VoxelMetadata::TYPE_EMPTY);
+		}
+	}
+	{
+		StdVector<VoxelBuffer> blocks = load_column(internal, unfinished_cpos);
+		ZN_TEST_ASSERT(blocks.size() == 0);
+	}
+
+	// Changing params makes saved columns obsolete, so they must be generated again
+	generator->set_pass_extent_blocks(1, 2);
+	internal = generator->get_internal();
+	ZN_TEST_ASSERT(internal->column_params_hash != saved_params_hash);
+	{
+		StdVector<VoxelBuffer> blocks = load_column(internal, finished_cpos);
+		ZN_TEST_ASSERT(blocks.size() == 0);
+	}
+}
+
+void test_voxel_generator_multipass_column_cache_eviction() {
+	Ref<VoxelGeneratorMultipassCB> generator;
+	generator.instantiate();
+	generator->set_column_base_y_blocks(0);
+	generator->set_column_height_blocks(1);
+	generator->set_column_cache_max_columns(2);
+
+	ViewerID moving_viewer;
+	ViewerID static_viewer;
+	static_viewer.index = 1;
+
+	// Column kept loaded by another viewer, with a task waiting on it
+	const Vector2i static_cpos(9, 0);
+	std::shared_ptr<std::atomic_int> static_counter = make_shared_instance<std::atomic_int>(0);
+	generator->process_viewer_diff(static_viewer, get_column_box(static_cpos.x), Box3i());
+	{
+		Column *column = generator->get_internal()->map.find_column(static_cpos);
+		ZN_TEST_ASSERT(column != nullptr);
+		column->subpass_index = 0;
+		column->pending_subpass_tasks_mask = 1;
+		column->waiting_tasks.push_back(ZN_NEW(CountingTask(static_counter)));
+	}
+
+	generator->process_viewer_diff(moving_viewer, get_column_box(0), Box3i());
+	generator->get_internal()->map.find_column(Vector2i(0, 0))->subpass_index = 0;
+
+	std::shared_ptr<Internal> internal = generator->get_internal();
+	const ColumnCache &cache = internal->column_cache;
+
+	move_viewer_to_column(**generator, moving_viewer, 1, 0);
+	move_viewer_to_column(**generator, moving_viewer, 2, 1);
+	ZN_TEST_ASSERT(cache.columns.size() == 2);
+
+	// Column 0 comes back from the cache, leaving an outdated item in the eviction order
+	move_viewer_to_column(**generator, moving_viewer, 0, 2);
+	ZN_TEST_ASSERT(cache.columns.find(Vector2i(0, 0)) == cache.columns.end());
+	move_viewer_to_column(**generator, moving_viewer, 3, 0);
+
+	// Tasks still pending on a column when it gets unloaded are scheduled, they must not end up in the cache
+	std::shared_ptr<std::atomic_int> unloaded_counter = make_shared_instance<std::atomic_int>(0);
+	{
+		Column *column = internal->map.find_column(Vector2i(3, 0));
+		ZN_TEST_ASSERT(column != nullptr);
+		column->pending_subpass_tasks_mask = 1;
+		column->waiting_tasks.push_back(ZN_NEW(CountingTask(unloaded_counter)));
+		column->blocks[0].final_pending_task = ZN_NEW(CountingTask(unloaded_counter));
+	}
+
+	// Column 1 was unloaded before 0 got unloaded the second time, so it is the one evicted
+	move_viewer_to_column(**generator, moving_viewer, 4, 3);
+	ZN_TEST_ASSERT(cache.columns.size() == 2);
+	ZN_TEST_ASSERT(cache.columns.find(Vector2i(1, 0)) == cache.columns.end());
+	ZN_TEST_ASSERT(cache.columns.find(Vector2i(0, 0)) != cache.columns.end());
+	ZN_TEST_ASSERT(cache.columns.find(Vector2i(3, 0)) != cache.columns.end());
+	for (auto it = cache.columns.begin(); it != cache.columns.end(); ++it) {
+		for (const Block &block : it->second.blocks) {
+			ZN_TEST_ASSERT(block.final_pending_task == nullptr);
+		}
+	}
+	ZN_TEST_ASSERT(wait_for_count(*unloaded_counter, 2));
+
+	// The column still viewed is left alone
+	{
+		Column *column = internal->map.find_column(static_cpos);
+		ZN_TEST_ASSERT(column != nullptr);
+		ZN_TEST_ASSERT(column->waiting_tasks.size() == 1);
+		ZN_TEST_ASSERT(*static_counter == 0);
+	}
+
+	// Unloading it evicts the least recently unloaded column
+	generator->process_viewer_diff(static_viewer, Box3i(), get_column_box(static_cpos.x));
+	ZN_TEST_ASSERT(wait_for_count(*static_counter, 1));
+	ZN_TEST_ASSERT(cache.columns.size() == 2);
+	ZN_TEST_ASSERT(cache.columns.find(Vector2i(0, 0)) == cache.columns.end());
+	ZN_TEST_ASSERT(cache.columns.find(Vector2i(3, 0)) != cache.columns.end());
+	ZN_TEST_ASSERT(cache.columns.find(static_cpos) != cache.columns.end());
+
+	generator->process_viewer_diff(moving_viewer, Box3i(), get_column_box(4));
+}
+
+void test_voxel_generator_multipass_waiting_tasks() {
+	static constexpr int WAITING_TASK_COUNT = 3;
+
+	Ref<VoxelGeneratorMultipassCB> generator;
+	generator.instantiate();
+	generator->set_column_base_y_blocks(0);
+	generator->set_column_height_blocks(1);
+
+	const Vector2i cpos(0, 0);
+	generator->process_viewer_diff(ViewerID(), get_column_box(cpos.x), Box3i());
+
+	std::shared_ptr<Internal> internal = generator->get_internal();
+	Column *column = internal->map.find_column(cpos);
+	ZN_TEST_ASSERT(column != nullptr);
+
+	// Tasks waiting for the first subpass of the column, as if another task was already working on it
+	std::shared_ptr<std::atomic_int> counter = make_shared_instance<std::atomic_int>(0);
+	column->pending_subpass_tasks_mask |= 1;
+	for (int i = 0; i < WAITING_TASK_COUNT; ++i) {
+		column->waiting_tasks.push_back(ZN_NEW(CountingTask(counter)));
+	}
+
+	// Run the task working on it
+	{
+		GenerateColumnMultipassTask *task = ZN_NEW(GenerateColumnMultipassTask(
+				cpos,
+				BLOCK_SIZE,
+				0,
+				internal,
+				generator,
+				TaskPriority(),
+				ZN_NEW(CountingTask(counter)),
+				make_shared_instance<std::atomic_int>(1)
+		));
+		ThreadedTaskContext ctx(0, TaskPriority());
+		task->run(ctx);
+		ZN_TEST_ASSERT(ctx.status == ThreadedTaskContext::STATUS_COMPLETE);
+		ZN_DELETE(task);
+	}
+
+	ZN_TEST_ASSERT(column->subpass_index == 0);
+	ZN_TEST_ASSERT(column->pending_subpass_tasks_mask == 0);
+	ZN_TEST_ASSERT(column->waiting_tasks.size() == 0);
+	// Waiting tasks and the caller
+	ZN_TEST_ASSERT(wait_for_count(*counter, WAITING_TASK_COUNT + 1));
+
+	// Running the subpass again on the finished column only returns to its caller
+	{
+		GenerateColumnMultipassTask *task = ZN_NEW(GenerateColumnMultipassTask(
+				cpos,
+				BLOCK_SIZE,
+				0,
+				internal,
+				generator,
+				TaskPriority(),
+				ZN_NEW(CountingTask(counter)),
+				make_shared_instance<std::atomic_int>(1)
+		));
+		ThreadedTaskContext ctx(0, TaskPriority());
+		task->run(ctx);
+		ZN_DELETE(task);
+	}
+	ZN_TEST_ASSERT(wait_for_count(*counter, WAITING_TASK_COUNT + 2));
+
+	generator->process_viewer_diff(ViewerID(), Box3i(), get_column_box(cpos.x));
+}
+
+void test_voxel_generator_multipass_map_concurrent_lookups() {
+	// Threads insert columns in the sharded map while the main thread looks up columns. Each thread fills its own row
+	// and tags columns with its index.
+	static constexpr int WRITER_COUNT = 3;
+	static constexpr int COLUMNS_PER_ROW = 256;
+	static constexpr int8_t STABLE_TAG = MAX_SUBPASSES;
+
+	struct Context {
+		Map *map;
+		std::atomic_int *finished_count;
+		int thread_index;
+	};
+
+	struct L {
+		static void insert_column(Map &map, Vector2i cpos, int8_t tag) {
+			Map::Shard &shard = map.get_shard(cpos);
+			MutexLock mlock(shard.mutex);
+			Column &column = shard.columns[cpos];
+			column.subpass_index = tag;
+		}
+
+		static void thread_func(void *userdata) {
+			Context &ctx = *static_cast<Context *>(userdata);
+			for (int x = 0; x < COLUMNS_PER_ROW; ++x) {
+				insert_column(*ctx.map, Vector2i(x, 1 + ctx.thread_index), ctx.thread_index);
+			}
+			++(*ctx.finished_count);
+		}
+	};
+
+	Map map;
+	std::atomic_int finished_count = { 0 };
+
+	for (int x = 0; x < COLUMNS_PER_ROW; ++x) {
+		L::insert_column(map, Vector2i(x, 0), STABLE_TAG);
+	}
+
+	FixedArray<Thread, WRITER_COUNT> threads;
+	FixedArray<Context, WRITER_COUNT> contexts;
+
+	for (int thread_index = 0; thread_index < WRITER_COUNT; ++thread_index) {
+		contexts[thread_index] = Context{ &map, &finished_count, thread_index };
+		threads[thread_index].start(L::thread_func, &contexts[thread_index]);
+	}
+
+	bool all_found = true;
+	bool tags_match = true;
+	bool writing = true;
+
+	while (writing) {
+		// Checked before looking up, so lookups run at least once after all writers are done
+		writing = finished_count < WRITER_COUNT;
+
+		for (int y = 0; y <= WRITER_COUNT; ++y) {
+			for (int x = 0; x < COLUMNS_PER_ROW; ++x) {
+				const Column *column = map.find_column(Vector2i(x, y));
+				if (column == nullptr) {
+					if (y == 0 || !writing) {
+						all_found = false;
+					}
+				} else if (column->subpass_index != (y == 0 ? STABLE_TAG : y - 1)) {
+					tags_match = false;
+				}
+			}
+		}
+	}
+
+	for (Thread &thread : threads) {
+		thread.wait_to_finish();
+	}
+
+	ZN_TEST_ASSERT(all_found);
+	ZN_TEST_ASSERT(tags_match);
+	ZN_TEST_ASSERT(map.get_column_count() == COLUMNS_PER_ROW * (WRITER_COUNT + 1));
+
+	// Columns must be spread across shards for lookups not to contend on the same mutex
+	unsigned int used_shard_count = 0;
+	for (unsigned int shard_index = 0; shard_index < Map::SHARD_COUNT; ++shard_index) {
+		if (map.shards[shard_index].columns.size() > 0) {
+			++used_shard_count;
+		}
+	}
+	ZN_TEST_ASSERT(used_shard_count > 1);
+}
+
+} // namespace zylann::voxel::tests
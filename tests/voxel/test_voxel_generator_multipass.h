@@ -0,0 +1,13 @@
+#ifndef VOXEL_TESTS_VOXEL_GENERATOR_MULTIPASS_H
+#define VOXEL_TESTS_VOXEL_GENERATOR_MULTIPASS_H
+
+namespace zylann::voxel::tests {
+
+void test_voxel_generator_multipass_column_persistence();
+void test_voxel_generator_multipass_column_cache_eviction();
+void test_voxel_generator_multipass_waiting_tasks();
+void test_voxel_generator_multipass_map_concurrent_lookups();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TESTS_VOXEL_GENERATOR_MULTIPASS_H
@@ -2,6 +2,7 @@
 #include "../../generators/graph/image_range_grid.h"
 #include "../../generators/graph/node_type_db.h"
 #include "../../generators/graph/range_utility.h"
+#include "../../generators/graph/voxel_graph_compiler.h"
 #include "../../generators/graph/voxel_generator_graph.h"
 #include "../../storage/materials_4i4w.h"
 #include "../../storage/voxel_buffer.h"
@@ -9,7 +10,9 @@
 #include "../../util/containers/std_vector.h"
 #include "../../util/godot/classes/fast_noise_lite.h"
 #include "../../util/godot/classes/image.h"
+#include "../../util/godot/classes/time.h"
 #include "../../util/godot/core/random_pcg.h"
+#include "../../util/io/log.h"
 #include "../../util/math/conv.h"
 #include "../../util/math/sdf.h"
 #include "../../util/noise/fast_noise_lite/fast_noise_lite.h"
@@ -389,6 +392,277 @@ void test_voxel_graph_generator_expressions_2() {
 	ZN_TEST_ASSERT(zfnl->get_reference_count() == 1);
 }
 
+void test_voxel_graph_expression_kernel_benchmark() {
+	// Compares an expression node, which gets compiled into a kernel, against the same computation made of one node
+	// per operation.
+	static const float RADIUS = 10.f;
+	struct L {
+		static void load_expression_graph(VoxelGraphFunction &g) {
+			const uint32_t in_x = g.create_node(VoxelGraphFunction::NODE_INPUT_X, Vector2());
+			const uint32_t in_y = g.create_node(VoxelGraphFunction::NODE_INPUT_Y, Vector2());
+			const uint32_t in_z = g.create_node(VoxelGraphFunction::NODE_INPUT_Z, Vector2());
+			const uint32_t out_sdf = g.create_node(VoxelGraphFunction::NODE_OUTPUT_SDF, Vector2());
+			const uint32_t n_expr = g.create_node(VoxelGraphFunction::NODE_EXPRESSION, Vector2());
+
+			g.set_node_param(n_expr, 0, String("sqrt(x * x + y * y + z * z) - {0}").format(varray(RADIUS)));
+			PackedStringArray var_names;
+			var_names.push_back("x");
+			var_names.push_back("y");
+			var_names.push_back("z");
+			g.set_expression_node_inputs(n_expr, var_names);
+
+			g.add_connection(in_x, 0, n_expr, 0);
+			g.add_connection(in_y, 0, n_expr, 1);
+			g.add_connection(in_z, 0, n_expr, 2);
+			g.add_connection(n_expr, 0, out_sdf, 0);
+		}
+
+		static void load_hand_wired_graph(VoxelGraphFunction &g) {
+			const uint32_t in_x = g.create_node(VoxelGraphFunction::NODE_INPUT_X, Vector2());
+			const uint32_t in_y = g.create_node(VoxelGraphFunction::NODE_INPUT_Y, Vector2());
+			const uint32_t in_z = g.create_node(VoxelGraphFunction::NODE_INPUT_Z, Vector2());
+			const uint32_t out_sdf = g.create_node(VoxelGraphFunction::NODE_OUTPUT_SDF, Vector2());
+			const uint32_t n_xx = g.create_node(VoxelGraphFunction::NODE_MULTIPLY, Vector2());
+			const uint32_t n_yy = g.create_node(VoxelGraphFunction::NODE_MULTIPLY, Vector2());
+			const uint32_t n_zz = g.create_node(VoxelGraphFunction::NODE_MULTIPLY, Vector2());
+			const uint32_t n_add1 = g.create_node(VoxelGraphFunction::NODE_ADD, Vector2());
+			const uint32_t n_add2 = g.create_node(VoxelGraphFunction::NODE_ADD, Vector2());
+			const uint32_t n_sqrt = g.create_node(VoxelGraphFunction::NODE_SQRT, Vector2());
+			const uint32_t n_sub = g.create_node(VoxelGraphFunction::NODE_SUBTRACT, Vector2());
+
+			g.add_connection(in_x, 0, n_xx, 0);
+			g.add_connection(in_x, 0, n_xx, 1);
+			g.add_connection(in_y, 0, n_yy, 0);
+			g.add_connection(in_y, 0, n_yy, 1);
+			g.add_connection(in_z, 0, n_zz, 0);
+			g.add_connection(in_z, 0, n_zz, 1);
+			g.add_connection(n_xx, 0, n_add1, 0);
+			g.add_connection(n_yy, 0, n_add1, 1);
+			g.add_connection(n_add1, 0, n_add2, 0);
+			g.add_connection(n_zz, 0, n_add2, 1);
+			g.add_connection(n_add2, 0, n_sqrt, 0);
+			g.add_connection(n_sqrt, 0, n_sub, 0);
+			g.set_node_default_input(n_sub, 1, RADIUS);
+			g.add_connection(n_sub, 0, out_sdf, 0);
+		}
+
+		static Ref<VoxelGeneratorGraph> create_generator(bool use_expression) {
+			Ref<VoxelGeneratorGraph> generator;
+			generator.instantiate();
+			ZN_ASSERT(generator->get_main_function().is_valid());
+			if (use_expression) {
+				load_expression_graph(**generator->get_main_function());
+			} else {
+				load_hand_wired_graph(**generator->get_main_function());
+			}
+			pg::CompilationResult result = generator->compile(false);
+			ZN_TEST_ASSERT_MSG(
+					result.success,
+					String("Failed to compile graph: {0}: {1}").format(varray(result.node_id, result.message))
+			);
+			return generator;
+		}
+
+		static uint64_t measure_block_generation_us(VoxelGeneratorGraph &generator, unsigned int iterations) {
+			VoxelBuffer block(VoxelBuffer::ALLOCATOR_DEFAULT);
+			block.create(Vector3i(32, 32, 32));
+			// Surface of the sphere crosses this block, so range analysis can't skip it
+			const Vector3i origin(-16, -16, -16);
+
+			const uint64_t time_before = Time::get_singleton()->get_ticks_usec();
+			for (unsigned int i = 0; i < iterations; ++i) {
+				generator.generate_block(VoxelGenerator::VoxelQueryData{ block, origin, 0 });
+			}
+			return Time::get_singleton()->get_ticks_usec() - time_before;
+		}
+	};
+
+	Ref<VoxelGeneratorGraph> generator_expression = L::create_generator(true);
+	Ref<VoxelGeneratorGraph> generator_hand_wired = L::create_generator(false);
+
+	// Both graphs get the same bounds for `x * x`, since Multiply nodes also square when both of their inputs come
+	// from the same source. Only blocks crossing the surface are compared, because range analysis can't skip them, so
+	// every node gets evaluated
+	ZN_TEST_ASSERT(check_graph_results_are_equal(**generator_expression, **generator_hand_wired, Vector3i()));
+	ZN_TEST_ASSERT(
+			check_graph_results_are_equal(**generator_expression, **generator_hand_wired, Vector3i(-8, -8, -8))
+	);
+
+	const unsigned int iterations = 20;
+	const uint64_t expression_us = L::measure_block_generation_us(**generator_expression, iterations);
+	const uint64_t hand_wired_us = L::measure_block_generation_us(**generator_hand_wired, iterations);
+
+	ZN_PRINT_VERBOSE(format(
+			"Expression kernel: {} us, hand-wired graph: {} us ({} blocks of 32x32x32)",
+			expression_us,
+			hand_wired_us,
+			iterations
+	));
+}
+
+void test_voxel_graph_expression_kernel_equivalence() {
+	// Each expression uses variables x, y and z, connected to inputs. w is not connected, so it takes the default
+	// value of its port.
+	const char *expressions[] = {
+		"x + y * z - 2.5", //
+		"x / y + z / (x - 1)", // Divisions by zero
+		"min(x, y) + max(y, z)", //
+		"clamp(x, -1.5, 2) + clamp(y, z, 3)", // Values outside of the range
+		"lerp(x, y, z)", //
+		"wrap(x, 2.5) + wrap(y, z)", //
+		"stepify(x, 0.75) + stepify(y, z)", //
+		"abs(x) ^ z + y ^ 0.5", // Pow
+		"x ^ 3 + y ^ 2 - z ^ 4", // Powi
+		"sqrt(x) + abs(y) + floor(z) + fract(x) + sin(y * z)", //
+		"x * w + y - z * w" // Unconnected variable
+	};
+	const float w_default = 2.5f;
+
+	// Includes negatives, zeros and values outside of the clamp ranges. The count of combinations is not a multiple of
+	// the size of kernel chunks.
+	const float values[] = { -10.f, -3.5f, -1.f, -0.25f, 0.f, 0.25f, 1.f, 2.f, 3.5f, 10.f };
+
+	StdVector<float> x_buffer;
+	StdVector<float> y_buffer;
+	StdVector<float> z_buffer;
+	for (const float z : values) {
+		for (const float y : values) {
+			for (const float x : values) {
+				x_buffer.push_back(x);
+				y_buffer.push_back(y);
+				z_buffer.push_back(z);
+			}
+		}
+	}
+
+	struct L {
+		static Ref<VoxelGraphFunction> create_function(const char *expression, float w_default) {
+			Ref<VoxelGraphFunction> function;
+			function.instantiate();
+			VoxelGraphFunction &g = **function;
+
+			const uint32_t in_x = g.create_node(VoxelGraphFunction::NODE_INPUT_X, Vector2());
+			const uint32_t in_y = g.create_node(VoxelGraphFunction::NODE_INPUT_Y, Vector2());
+			const uint32_t in_z = g.create_node(VoxelGraphFunction::NODE_INPUT_Z, Vector2());
+			const uint32_t out_sdf = g.create_node(VoxelGraphFunction::NODE_OUTPUT_SDF, Vector2());
+			const uint32_t n_expr = g.create_node(VoxelGraphFunction::NODE_EXPRESSION, Vector2());
+
+			g.set_node_param(n_expr, 0, String(expression));
+			PackedStringArray var_names;
+			var_names.push_back("x");
+			var_names.push_back("y");
+			var_names.push_back("z");
+			var_names.push_back("w");
+			g.set_expression_node_inputs(n_expr, var_names);
+
+			g.add_connection(in_x, 0, n_expr, 0);
+			g.add_connection(in_y, 0, n_expr, 1);
+			g.add_connection(in_z, 0, n_expr, 2);
+			g.set_node_default_input(n_expr, 3, w_default);
+			g.add_connection(n_expr, 0, out_sdf, 0);
+
+			g.auto_pick_inputs_and_outputs();
+			return function;
+		}
+
+		static unsigned int count_kernel_nodes(const VoxelGraphFunction &function, bool use_expression_kernels) {
+			pg::ProgramGraph expanded_graph;
+			const pg::CompilationResult result = pg::expand_graph(
+					function.get_graph(),
+					expanded_graph,
+					function.get_input_definitions(),
+					nullptr,
+					pg::NodeTypeDB::get_singleton(),
+					nullptr,
+					use_expression_kernels
+			);
+			ZN_TEST_ASSERT(result.success);
+			unsigned int count = 0;
+			expanded_graph.for_each_node_const([&count](const pg::ProgramGraph::Node &node) {
+				if (node.type_id == VoxelGraphFunction::NODE_EXPRESSION_KERNEL) {
+					++count;
+				}
+			});
+			return count;
+		}
+
+		static bool is_same_result(float a, float b) {
+			if (Math::is_nan(a) || Math::is_nan(b)) {
+				return Math::is_nan(a) && Math::is_nan(b);
+			}
+			// Results can differ slightly, for example division by a constant is done with a multiplication by its
+			// inverse in graph nodes
+			return Math::is_equal_approx(a, b);
+		}
+	};
+
+	for (const char *expression : expressions) {
+		Ref<VoxelGraphFunction> function = L::create_function(expression, w_default);
+
+		// The expression must actually be compiled into a kernel, otherwise both would be the same
+		ZN_TEST_ASSERT(L::count_kernel_nodes(**function, true) == 1);
+		ZN_TEST_ASSERT(L::count_kernel_nodes(**function, false) == 0);
+
+		StdVector<float> kernel_results;
+		StdVector<float> expanded_results;
+
+		for (unsigned int pass = 0; pass < 2; ++pass) {
+			const bool use_expression_kernels = pass == 0;
+			StdVector<float> &results = use_expression_kernels ? kernel_results : expanded_results;
+
+			const pg::CompilationResult result = function->compile(false, use_expression_kernels);
+			ZN_TEST_ASSERT_MSG(
+					result.success,
+					String("Failed to compile graph: {0}: {1}").format(varray(result.node_id, result.message))
+			);
+
+			results.resize(x_buffer.size());
+			Span<float> inputs[3] = { to_span(x_buffer), to_span(y_buffer), to_span(z_buffer) };
+			Span<float> outputs = to_span(results);
+			function->execute(Span<Span<float>>(inputs, 3), Span<Span<float>>(&outputs, 1));
+		}
+
+		for (unsigned int i = 0; i < x_buffer.size(); ++i) {
+			if (!L::is_same_result(kernel_results[i], expanded_results[i])) {
+				ZN_PRINT_ERROR(format(
+						"{} with x={}, y={}, z={}: kernel gave {}, expanded expression gave {}",
+						expression,
+						x_buffer[i],
+						y_buffer[i],
+						z_buffer[i],
+						kernel_results[i],
+						expanded_results[i]
+				));
+			}
+			ZN_TEST_ASSERT(L::is_same_result(kernel_results[i], expanded_results[i]));
+		}
+	}
+}
+
+void test_voxel_graph_powi_non_constant() {
+	Ref<VoxelGeneratorGraph> generator;
+	generator.instantiate();
+	{
+		VoxelGraphFunction &g = **generator->get_main_function();
+		const uint32_t in_x = g.create_node(VoxelGraphFunction::NODE_INPUT_X, Vector2());
+		const uint32_t out_sdf = g.create_node(VoxelGraphFunction::NODE_OUTPUT_SDF, Vector2());
+		const uint32_t n_powi = g.create_node(VoxelGraphFunction::NODE_POWI, Vector2());
+		g.set_node_param(n_powi, 0, 3);
+		g.add_connection(in_x, 0, n_powi, 0);
+		g.add_connection(n_powi, 0, out_sdf, 0);
+	}
+	pg::CompilationResult result = generator->compile(false);
+	ZN_TEST_ASSERT_MSG(
+			result.success,
+			String("Failed to compile graph: {0}: {1}").format(varray(result.node_id, result.message))
+	);
+
+	// The input is not constant, so this goes through the buffer processing function of the node
+	ZN_TEST_ASSERT(generator->generate_single(Vector3i(2, 0, 0), VoxelBuffer::CHANNEL_SDF).f == 8.f);
+	ZN_TEST_ASSERT(generator->generate_single(Vector3i(-3, 0, 0), VoxelBuffer::CHANNEL_SDF).f == -27.f);
+	ZN_TEST_ASSERT(generator->generate_single(Vector3i(1, 5, 0), VoxelBuffer::CHANNEL_SDF).f == 1.f);
+}
+
 void test_voxel_graph_generator_texturing() {
 	Ref<VoxelGeneratorGraph> generator;
 	generator.instantiate();
@@ -1326,6 +1600,33 @@ void test_voxel_graph_sphere_on_plane() {
 	L::test_locations(**generator);
 }
 
+void test_voxel_graph_generate_single_batch() {
+	Ref<VoxelGeneratorGraph> generator;
+	generator.instantiate();
+	load_graph_with_sphere_on_plane(**generator->get_main_function(), 6.f);
+	pg::CompilationResult compilation_result = generator->compile(false);
+	ZN_TEST_ASSERT_MSG(
+			compilation_result.success,
+			String("Failed to compile graph: {0}: {1}")
+					.format(varray(compilation_result.node_id, compilation_result.message))
+	);
+
+	StdVector<Vector3i> positions;
+	for (int i = -10; i <= 10; ++i) {
+		positions.push_back(Vector3i(i * 3, i, -i * 2));
+	}
+
+	StdVector<VoxelSingleValue> values;
+	values.resize(positions.size());
+	generator->generate_single_batch(to_span_const(positions), VoxelBuffer::CHANNEL_SDF, to_span(values));
+
+	// Batches must give the same results as single queries
+	for (unsigned int i = 0; i < positions.size(); ++i) {
+		const float expected = generator->generate_single(positions[i], VoxelBuffer::CHANNEL_SDF).f;
+		ZN_TEST_ASSERT(Math::is_equal_approx(values[i].f, expected));
+	}
+}
+
 #ifdef VOXEL_ENABLE_FAST_NOISE_2
 
 // https://github.com/Zylann/godot_voxel/issues/427
@@ -6,9 +6,13 @@ namespace zylann::voxel::tests {
 void test_voxel_graph_invalid_connection();
 void test_voxel_graph_generator_default_graph_compilation();
 void test_voxel_graph_sphere_on_plane();
+void test_voxel_graph_generate_single_batch();
 void test_voxel_graph_clamp_simplification();
 void test_voxel_graph_generator_expressions();
 void test_voxel_graph_generator_expressions_2();
+void test_voxel_graph_expression_kernel_benchmark();
+void test_voxel_graph_expression_kernel_equivalence();
+void test_voxel_graph_powi_non_constant();
 void test_voxel_graph_generator_texturing();
 void test_voxel_graph_equivalence_merging();
 void test_voxel_graph_generate_block_with_input_sdf();
@@ -0,0 +1,183 @@
+#include "test_voxel_mesher_blocky.h"
+#include "../../constants/voxel_string_names.h"
+#include "../../meshers/blocky/types/voxel_blocky_type_library.h"
+#include "../../meshers/blocky/voxel_blocky_library.h"
+#include "../../meshers/blocky/voxel_blocky_model_cube.h"
+#include "../../meshers/blocky/voxel_blocky_model_empty.h"
+#include "../../meshers/blocky/voxel_mesher_blocky.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../util/containers/dynamic_bitset.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+void test_voxel_mesher_blocky_flat_models() {
+	Ref<VoxelBlockyLibrary> library;
+	library.instantiate();
+	library->set_bake_tangents(true);
+
+	{
+		Ref<VoxelBlockyModelEmpty> air;
+		air.instantiate();
+		library->add_model(air);
+	}
+	int solid_id = -1;
+	{
+		Ref<VoxelBlockyModelCube> solid;
+		solid.instantiate();
+		solid_id = library->add_model(solid);
+	}
+	int glass_id = -1;
+	{
+		Ref<VoxelBlockyModelCube> glass;
+		glass.instantiate();
+		glass->set_transparency_index(1);
+		glass_id = library->add_model(glass);
+	}
+
+	library->bake();
+
+	// Flat models must contain the same geometry as per-model baked data
+	{
+		const VoxelBlockyLibraryBase::BakedData &baked_data = library->get_baked_data();
+		const VoxelBlockyLibraryBase::FlatModels &flat = baked_data.flat_models;
+
+		ZN_TEST_ASSERT(flat.models.size() == baked_data.models.size());
+		ZN_TEST_ASSERT(flat.flags.size() == baked_data.models.size());
+		ZN_TEST_ASSERT(flat.tangents.size() == flat.positions.size() * 4);
+		ZN_TEST_ASSERT(flat.normals.size() == flat.positions.size());
+		ZN_TEST_ASSERT(flat.uvs.size() == flat.positions.size());
+
+		for (unsigned int model_index = 0; model_index < baked_data.models.size(); ++model_index) {
+			const VoxelBlockyModel::BakedData::Model &model = baked_data.models[model_index].model;
+			const VoxelBlockyLibraryBase::FlatModels::Model &flat_model = flat.models[model_index];
+			ZN_TEST_ASSERT(flat_model.surface_count == model.surface_count);
+			ZN_TEST_ASSERT(flat.transparency_indices[model_index] == baked_data.models[model_index].transparency_index);
+
+			for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
+				const VoxelBlockyModel::BakedData::Surface &surface = model.surfaces[surface_index];
+				const VoxelBlockyLibraryBase::FlatModels::Surface &flat_surface = flat_model.surfaces[surface_index];
+				ZN_TEST_ASSERT(flat_surface.material_id == surface.material_id);
+
+				for (unsigned int side = 0; side < Cube::SIDE_COUNT; ++side) {
+					const VoxelBlockyModel::BakedData::SideSurface &side_surface = surface.sides[side];
+					const VoxelBlockyLibraryBase::FlatModels::Part &part = flat_surface.parts[side];
+					ZN_TEST_ASSERT(part.vertex_count == side_surface.positions.size());
+					ZN_TEST_ASSERT(part.index_count == side_surface.indices.size());
+					ZN_TEST_ASSERT(flat.get_side_pattern_index(model_index, side) == model.side_pattern_indices[side]);
+
+					for (unsigned int i = 0; i < part.vertex_count; ++i) {
+						ZN_TEST_ASSERT(flat.positions[part.vertex_begin + i] == side_surface.positions[i]);
+						ZN_TEST_ASSERT(flat.uvs[part.vertex_begin + i] == side_surface.uvs[i]);
+					}
+					for (unsigned int i = 0; i < part.index_count; ++i) {
+						ZN_TEST_ASSERT(flat.indices[part.index_begin + i] == side_surface.indices[i]);
+					}
+				}
+			}
+		}
+	}
+
+	// Solid, solid, glass in a row
+	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
+	voxels.create(Vector3i(5, 3, 3) + Vector3iUtil::create(2 * VoxelMesherBlocky::PADDING));
+	const Vector3i origin = Vector3iUtil::create(VoxelMesherBlocky::PADDING) + Vector3i(1, 1, 1);
+	voxels.set_voxel(solid_id, origin, VoxelBuffer::CHANNEL_TYPE);
+	voxels.set_voxel(solid_id, origin + Vector3i(1, 0, 0), VoxelBuffer::CHANNEL_TYPE);
+	voxels.set_voxel(glass_id, origin + Vector3i(2, 0, 0), VoxelBuffer::CHANNEL_TYPE);
+
+	Ref<VoxelMesherBlocky> mesher;
+	mesher.instantiate();
+	mesher->set_library(library);
+
+	VoxelMesher::Input input{ voxels, nullptr, Vector3i(), 0, true };
+	VoxelMesher::Output output;
+	mesher->build(output, input);
+
+	ZN_TEST_ASSERT(output.surfaces.size() == 1);
+	const Array &arrays = output.surfaces[0].arrays;
+	const PackedVector3Array positions = arrays[Mesh::ARRAY_VERTEX];
+	const PackedVector3Array normals = arrays[Mesh::ARRAY_NORMAL];
+	const PackedVector2Array uvs = arrays[Mesh::ARRAY_TEX_UV];
+	const PackedColorArray colors = arrays[Mesh::ARRAY_COLOR];
+	const PackedFloat32Array tangents = arrays[Mesh::ARRAY_TANGENT];
+	const PackedInt32Array indices = arrays[Mesh::ARRAY_INDEX];
+
+	// The face between solid cubes is culled on both sides. The glass cube doesn't hide the face of the solid cube
+	// next to it, but the solid cube hides the face of the glass cube. 5 + 5 + 5 quads remain.
+	const unsigned int quad_count = 15;
+	ZN_TEST_ASSERT(positions.size() == quad_count * 4);
+	ZN_TEST_ASSERT(normals.size() == positions.size());
+	ZN_TEST_ASSERT(uvs.size() == positions.size());
+	ZN_TEST_ASSERT(colors.size() == positions.size());
+	ZN_TEST_ASSERT(tangents.size() == positions.size() * 4);
+	ZN_TEST_ASSERT(indices.size() == quad_count * 6);
+	for (int i = 0; i < indices.size(); ++i) {
+		ZN_TEST_ASSERT(indices[i] >= 0 && indices[i] < positions.size());
+	}
+
+	ZN_TEST_ASSERT(output.collision_surface.positions.size() == quad_count * 4);
+	ZN_TEST_ASSERT(output.collision_surface.indices.size() == quad_count * 6);
+}
+
+void test_voxel_blocky_type_library_bake_types() {
+	Ref<VoxelBlockyTypeLibrary> library;
+	library.instantiate();
+	// Contains an air type and a cube type
+	library->load_default();
+	library->bake();
+
+	const StringName cube_name = VoxelStringNames::get_singleton().cube;
+	const int air_id = library->get_model_index_default(VoxelStringNames::get_singleton().air);
+	const int cube_id = library->get_model_index_default(cube_name);
+	ZN_TEST_ASSERT(air_id >= 0);
+	ZN_TEST_ASSERT(cube_id >= 0);
+	ZN_TEST_ASSERT(air_id != cube_id);
+	ZN_TEST_ASSERT(library->get_baked_data().models[cube_id].transparency_index == 0);
+
+	{
+		Ref<VoxelBlockyModelCube> glass;
+		glass.instantiate();
+		glass->set_transparency_index(1);
+		Ref<VoxelBlockyType> cube_type = library->get_type_from_name(cube_name);
+		ZN_TEST_ASSERT(cube_type.is_valid());
+		cube_type->set_base_model(glass);
+	}
+
+	StdVector<uint16_t> model_ids;
+	library->bake_types(to_single_element_span(cube_name), model_ids);
+
+	// Only the changed type is re-baked, and IDs remain the same
+	ZN_TEST_ASSERT(model_ids.size() == 1);
+	ZN_TEST_ASSERT(model_ids[0] == cube_id);
+	ZN_TEST_ASSERT(library->get_model_index_default(cube_name) == cube_id);
+	const VoxelBlockyLibraryBase::BakedData &baked_data = library->get_baked_data();
+	ZN_TEST_ASSERT(baked_data.models[cube_id].transparency_index == 1);
+	ZN_TEST_ASSERT(baked_data.flat_models.transparency_indices[cube_id] == 1);
+	ZN_TEST_ASSERT(baked_data.models[air_id].empty);
+
+	// A type that doesn't exist has no models
+	model_ids.clear();
+	const StringName missing_name("missing");
+	library->bake_types(to_single_element_span(missing_name), model_ids);
+	ZN_TEST_ASSERT(model_ids.size() == 0);
+
+	// Finding which buffers contain the changed models
+	DynamicBitset model_ids_bitset;
+	model_ids_bitset.resize_no_init(VoxelBlockyLibraryBase::MAX_MODELS);
+	model_ids_bitset.fill(false);
+	model_ids_bitset.set(cube_id);
+
+	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
+	voxels.create(Vector3i(4, 4, 4));
+	voxels.fill(air_id, VoxelBuffer::CHANNEL_TYPE);
+	ZN_TEST_ASSERT(!has_any_value_in_bitarray(voxels, VoxelBuffer::CHANNEL_TYPE, model_ids_bitset));
+	voxels.set_voxel(cube_id, Vector3i(3, 2, 1), VoxelBuffer::CHANNEL_TYPE);
+	ZN_TEST_ASSERT(has_any_value_in_bitarray(voxels, VoxelBuffer::CHANNEL_TYPE, model_ids_bitset));
+	voxels.fill(cube_id, VoxelBuffer::CHANNEL_TYPE);
+	voxels.compress_uniform_channels();
+	ZN_TEST_ASSERT(voxels.get_channel_compression(VoxelBuffer::CHANNEL_TYPE) == VoxelBuffer::COMPRESSION_UNIFORM);
+	ZN_TEST_ASSERT(has_any_value_in_bitarray(voxels, VoxelBuffer::CHANNEL_TYPE, model_ids_bitset));
+}
+
+} // namespace zylann::voxel::tests
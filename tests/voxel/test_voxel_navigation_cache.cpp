@@ -0,0 +1,159 @@
+#include "test_voxel_navigation_cache.h"
+#include "../../generators/simple/voxel_generator_flat.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../storage/voxel_data.h"
+#include "../../terrain/voxel_a_star_grid_3d.h"
+#include "../../terrain/voxel_navigation_cache.h"
+#include "../../util/memory/memory.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+void test_voxel_navigation_cache_hierarchical_path() {
+	static const int channel = VoxelBuffer::CHANNEL_TYPE;
+
+	// Floor spanning several blocks, split by a wall with a single opening
+	const Box3i region(Vector3i(0, 0, 0), Vector3i(64, 8, 16));
+
+	std::shared_ptr<VoxelData> data = make_shared_instance<VoxelData>();
+	{
+		VoxelBuffer buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer.create(region.size);
+		buffer.fill_area(1, Vector3i(0, 0, 0), Vector3i(64, 1, 16), channel);
+		buffer.fill_area(1, Vector3i(36, 1, 0), Vector3i(37, 6, 16), channel);
+		buffer.fill_area(0, Vector3i(36, 1, 7), Vector3i(37, 4, 9), channel);
+		data->paste(region.position, buffer, 1 << channel, true);
+	}
+
+	std::shared_ptr<VoxelNavigationCache> cache = make_shared_instance<VoxelNavigationCache>(data);
+
+	VoxelAStarGrid3DInternal path_finder;
+	path_finder.set_region(region);
+	path_finder.cache = cache;
+	cache->set_rules(path_finder);
+
+	const Vector3i from_position(4, 1, 2);
+	const Vector3i to_position(60, 1, 2);
+
+	StdVector<Vector3i> path;
+	path_finder.init_cache();
+	ZN_TEST_ASSERT(path_finder.find_path_hierarchical(from_position, to_position, path));
+	ZN_TEST_ASSERT(path.size() > 0);
+	ZN_TEST_ASSERT(path[0] == from_position);
+	// Like the regular search, the path ends right before the destination
+	ZN_TEST_ASSERT(math::chebyshev_distance(path.back(), to_position) <= 1);
+
+	// Consecutive positions must be neighbors, and the path must go through the opening
+	bool went_through_opening = false;
+	for (unsigned int i = 1; i < path.size(); ++i) {
+		ZN_TEST_ASSERT(math::chebyshev_distance(path[i - 1], path[i]) <= 1);
+		if (path[i].x == 36) {
+			ZN_TEST_ASSERT(path[i].z >= 7 && path[i].z < 9);
+			went_through_opening = true;
+		}
+	}
+	ZN_TEST_ASSERT(went_through_opening);
+	ZN_TEST_ASSERT(cache->get_cluster_count() > 0);
+
+	// Close the opening. The cache must not keep using outdated data.
+	{
+		const Box3i opening(Vector3i(36, 1, 7), Vector3i(1, 3, 2));
+		VoxelBuffer buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer.create(opening.size);
+		buffer.fill(1, channel);
+		data->paste(opening.position, buffer, 1 << channel, false);
+		cache->on_area_edited(opening);
+	}
+
+	path_finder.init_cache();
+	ZN_TEST_ASSERT(path_finder.find_path_hierarchical(from_position, to_position, path) == false);
+	ZN_TEST_ASSERT(path.size() == 0);
+}
+
+void test_voxel_navigation_cache_block_changes() {
+	static const int channel = VoxelBuffer::CHANNEL_TYPE;
+
+	const Box3i region(Vector3i(0, 0, 0), Vector3i(64, 8, 16));
+
+	// Nothing is loaded at first, voxels come from the generator: a floor with its top at y=1
+	std::shared_ptr<VoxelData> data = make_shared_instance<VoxelData>();
+	{
+		Ref<VoxelGeneratorFlat> generator;
+		generator.instantiate();
+		generator->set_channel(VoxelBuffer::CHANNEL_TYPE);
+		generator->set_voxel_type(1);
+		generator->set_height(1.f);
+		data->set_generator(generator);
+	}
+	const int block_size = data->get_block_size();
+
+	std::shared_ptr<VoxelNavigationCache> cache = make_shared_instance<VoxelNavigationCache>(data);
+
+	VoxelAStarGrid3DInternal path_finder;
+	path_finder.set_region(region);
+	path_finder.cache = cache;
+	cache->set_rules(path_finder);
+
+	const Vector3i from_position(4, 1, 2);
+	const Vector3i to_position(60, 1, 2);
+	const Vector3i wall_block_position(2, 0, 0);
+	const Box3i wall_block_box(wall_block_position * block_size, Vector3iUtil::create(block_size));
+
+	StdVector<Vector3i> path;
+	path_finder.init_cache();
+	ZN_TEST_ASSERT(path_finder.find_path_hierarchical(from_position, to_position, path));
+
+	// A block is loaded, like when it was edited in a previous session. It is entirely solid, blocking the way.
+	// Terrains notify the cache with the box of the block, like an edit.
+	{
+		std::shared_ptr<VoxelBuffer> voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+		voxels->create(Vector3iUtil::create(block_size));
+		voxels->fill(1, channel);
+		VoxelDataBlock block(voxels, 0);
+		data->try_set_block(wall_block_position, block);
+		cache->on_area_edited(wall_block_box);
+	}
+	path_finder.init_cache();
+	ZN_TEST_ASSERT(path_finder.find_path_hierarchical(from_position, to_position, path) == false);
+
+	// The block is replaced, like when received from a server. It now has an opening.
+	{
+		std::shared_ptr<VoxelBuffer> voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+		voxels->create(Vector3iUtil::create(block_size));
+		voxels->fill(1, channel);
+		voxels->fill_area(0, Vector3i(0, 1, 7), Vector3i(block_size, 4, 9), channel);
+		VoxelDataBlock block(voxels, 0);
+		data->try_set_block(wall_block_position, block, [](VoxelDataBlock &existing, const VoxelDataBlock &incoming) {
+			existing.set_voxels(incoming.get_voxels_shared());
+		});
+		cache->on_area_edited(wall_block_box);
+	}
+	path_finder.init_cache();
+	ZN_TEST_ASSERT(path_finder.find_path_hierarchical(from_position, to_position, path));
+	for (const Vector3i pos : path) {
+		if (wall_block_box.contains(pos) && pos.y > 0) {
+			ZN_TEST_ASSERT(pos.z >= 7 && pos.z < 9);
+		}
+	}
+
+	// Block is solid again, then unloaded. Voxels are back to what the generator gives.
+	{
+		std::shared_ptr<VoxelBuffer> voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+		voxels->create(Vector3iUtil::create(block_size));
+		voxels->fill(1, channel);
+		VoxelDataBlock block(voxels, 0);
+		data->try_set_block(wall_block_position, block, [](VoxelDataBlock &existing, const VoxelDataBlock &incoming) {
+			existing.set_voxels(incoming.get_voxels_shared());
+		});
+		cache->on_area_edited(wall_block_box);
+	}
+	path_finder.init_cache();
+	ZN_TEST_ASSERT(path_finder.find_path_hierarchical(from_position, to_position, path) == false);
+
+	data->unload_blocks(Box3i(wall_block_position, Vector3i(1, 1, 1)), 0, nullptr);
+	cache->on_area_edited(wall_block_box);
+	path_finder.init_cache();
+	ZN_TEST_ASSERT(path_finder.find_path_hierarchical(from_position, to_position, path));
+}
+
+} // namespace zylann::voxel::tests
@@ -0,0 +1,11 @@
+#ifndef VOXEL_TEST_VOXEL_NAVIGATION_CACHE_H
+#define VOXEL_TEST_VOXEL_NAVIGATION_CACHE_H
+
+namespace zylann::voxel::tests {
+
+void test_voxel_navigation_cache_hierarchical_path();
+void test_voxel_navigation_cache_block_changes();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TEST_VOXEL_NAVIGATION_CACHE_H
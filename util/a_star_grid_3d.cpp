@@ -8,6 +8,7 @@ namespace zylann {
 
 AStarGrid3D::AStarGrid3D() {
 	_open_list.sorter.compare.pool = &_points_pool;
+	update_fitting_offset();
 }
 
 void AStarGrid3D::set_region(Box3i region) {
@@ -17,6 +18,15 @@ void AStarGrid3D::set_region(Box3i region) {
 void AStarGrid3D::set_agent_size(Vector3f size) {
 	ZN_ASSERT_RETURN(math::is_valid_size(size));
 	_agent_size = size;
+	update_fitting_offset();
+}
+
+void AStarGrid3D::update_fitting_offset() {
+	_fitting_offset = Vector3f( //
+			(int(_agent_size.x) & 1) == 1 ? 0.5f : 0.f, //
+			(int(_agent_size.y) & 1) == 1 ? 0.5f : 0.f, //
+			(int(_agent_size.z) & 1) == 1 ? 0.5f : 0.f
+	);
 }
 
 void AStarGrid3D::set_max_fall_height(int h) {
@@ -40,12 +50,6 @@ void AStarGrid3D::start(Vector3i from_position, Vector3i target_position) {
 
 	_target_position = target_position;
 
-	_fitting_offset = Vector3f( //
-			(int(_agent_size.x) & 1) == 1 ? 0.5f : 0.f, //
-			(int(_agent_size.y) & 1) == 1 ? 0.5f : 0.f, //
-			(int(_agent_size.z) & 1) == 1 ? 0.5f : 0.f
-	);
-
 	if (!_region.contains(from_position)) {
 		return;
 	}
@@ -128,8 +132,7 @@ void AStarGrid3D::step() {
 			_points_map.insert({ npos, neighbor_point_index });
 		}
 
-		const Vector3i neighbor_dir = npos - current_point.position;
-		const float edge_cost = math::length(to_vec3f(neighbor_dir)); // neighbor_dir.length();
+		const float edge_cost = get_step_cost(current_point.position, npos);
 		const float tentative_gscore = current_point.gscore + edge_cost;
 
 		Point &neighbor_point = _points_pool[neighbor_point_index];
@@ -175,6 +178,14 @@ bool AStarGrid3D::is_ground_close_enough(Vector3i pos) {
 	return false;
 }
 
+bool AStarGrid3D::is_walkable(Vector3i pos) {
+	return _region.contains(pos) && !is_solid(pos) && is_ground_close_enough(pos);
+}
+
+float AStarGrid3D::get_step_cost(Vector3i from_position, Vector3i to_position) {
+	return math::length(to_vec3f(to_position - from_position));
+}
+
 bool AStarGrid3D::fits(Vector3f pos, Vector3f agent_extents) {
 	const Box3i box = Box3i::from_min_max( //
 							  to_vec3i(math::floor(pos - agent_extents)),
@@ -40,18 +40,25 @@ public:
 	Span<const Vector3i> get_path() const;
 	void clear();
 
+	// Movement rules. Can be used to build other kinds of searches using the same rules.
+
+	// Gets positions an agent can move to from the given position, in a single step.
+	void get_neighbor_positions(Vector3i pos, StdVector<Vector3i> &out_positions);
+	// Tells if an agent can be at the given position without falling further than the maximum fall height.
+	bool is_walkable(Vector3i pos);
+	virtual bool is_solid(Vector3i pos);
+	// Cost of moving between two neighbor positions
+	static float get_step_cost(Vector3i from_position, Vector3i to_position);
+	float evaluate_heuristic(Vector3i pos, Vector3i target_pos) const;
+
 	// Debug
 
 	void debug_get_visited_points(StdVector<Vector3i> &out_positions) const;
 	bool debug_get_next_step_point(Vector3i &out_pos) const;
 
-protected:
-	virtual bool is_solid(Vector3i pos);
-
 private:
-	float evaluate_heuristic(Vector3i pos, Vector3i target_pos) const;
 	void reconstruct_path(uint32_t end_point_index);
-	void get_neighbor_positions(Vector3i pos, StdVector<Vector3i> &out_positions);
+	void update_fitting_offset();
 	bool is_ground_close_enough(Vector3i pos);
 	bool fits(Vector3f pos, Vector3f agent_extents);
 
@@ -0,0 +1,154 @@
+#include "image_sampler.h"
+#include "../errors.h"
+#include <cstring>
+
+namespace zylann::godot {
+
+bool ImageSampler::get_red_component_layout(
+		Image::Format format,
+		ComponentType &out_component_type,
+		unsigned int &out_pixel_size
+) {
+	switch (format) {
+		case Image::FORMAT_L8:
+		case Image::FORMAT_R8:
+			out_pixel_size = 1;
+			out_component_type = COMPONENT_U8;
+			return true;
+		case Image::FORMAT_LA8:
+		case Image::FORMAT_RG8:
+			out_pixel_size = 2;
+			out_component_type = COMPONENT_U8;
+			return true;
+		case Image::FORMAT_RGB8:
+			out_pixel_size = 3;
+			out_component_type = COMPONENT_U8;
+			return true;
+		case Image::FORMAT_RGBA8:
+			out_pixel_size = 4;
+			out_component_type = COMPONENT_U8;
+			return true;
+
+		case Image::FORMAT_RF:
+			out_pixel_size = 4;
+			out_component_type = COMPONENT_F32;
+			return true;
+		case Image::FORMAT_RGF:
+			out_pixel_size = 8;
+			out_component_type = COMPONENT_F32;
+			return true;
+		case Image::FORMAT_RGBF:
+			out_pixel_size = 12;
+			out_component_type = COMPONENT_F32;
+			return true;
+		case Image::FORMAT_RGBAF:
+			out_pixel_size = 16;
+			out_component_type = COMPONENT_F32;
+			return true;
+
+		case Image::FORMAT_RH:
+			out_pixel_size = 2;
+			out_component_type = COMPONENT_F16;
+			return true;
+		case Image::FORMAT_RGH:
+			out_pixel_size = 4;
+			out_component_type = COMPONENT_F16;
+			return true;
+		case Image::FORMAT_RGBH:
+			out_pixel_size = 6;
+			out_component_type = COMPONENT_F16;
+			return true;
+		case Image::FORMAT_RGBAH:
+			out_pixel_size = 8;
+			out_component_type = COMPONENT_F16;
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+void ImageSampler::set_image(Ref<Image> image) {
+	_image = Ref<Image>();
+	_data = PackedByteArray();
+	_data_ptr = nullptr;
+	_mipmaps.clear();
+	_pixel_size = 0;
+	_component_type = COMPONENT_OTHER;
+
+	if (image.is_null() || image->is_empty()) {
+		return;
+	}
+
+	const int mipmap_count = image->has_mipmaps() ? image->get_mipmap_count() + 1 : 1;
+
+	if (!image->is_compressed() && get_red_component_layout(image->get_format(), _component_type, _pixel_size)) {
+		_data = image->get_data();
+		_data_ptr = _data.ptr();
+
+		// Uncompressed mipmaps are stored one after the other, each half the size of the previous one
+		size_t offset = 0;
+		int w = image->get_width();
+		int h = image->get_height();
+		for (int i = 0; i < mipmap_count; ++i) {
+			_mipmaps.push_back(Mipmap{ offset, w, h });
+			offset += static_cast<size_t>(w) * static_cast<size_t>(h) * _pixel_size;
+			w = math::max(w / 2, 1);
+			h = math::max(h / 2, 1);
+		}
+
+		if (offset > static_cast<size_t>(_data.size())) {
+			ZN_PRINT_ERROR("Image data is smaller than expected, falling back to slower sampling");
+			_data = PackedByteArray();
+			_data_ptr = nullptr;
+			_mipmaps.clear();
+			_pixel_size = 0;
+			_component_type = COMPONENT_OTHER;
+		} else {
+			return;
+		}
+	}
+
+	// Mipmaps can't be accessed with `get_pixel`, so only the first one is used
+	_image = image;
+	_mipmaps.push_back(Mipmap{ 0, image->get_width(), image->get_height() });
+}
+
+float ImageSampler::get_pixel_fallback(int x, int y) const {
+	return _image->get_pixel(x, y).r;
+}
+
+float ImageSampler::half_to_float(uint16_t h) {
+	// Same conversion as Godot, which isn't exposed the same way in modules and extensions
+	const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+	uint32_t exponent = (h >> 10) & 0x1f;
+	uint32_t mantissa = h & 0x3ff;
+
+	uint32_t bits;
+	if (exponent == 0) {
+		if (mantissa == 0) {
+			// Zero
+			bits = sign;
+		} else {
+			// Denormalized, normalize it
+			while ((mantissa & 0x400) == 0) {
+				mantissa <<= 1;
+				--exponent;
+			}
+			++exponent;
+			mantissa &= ~0x400u;
+			bits = sign | ((exponent + (127 - 15)) << 23) | (mantissa << 13);
+		}
+	} else if (exponent == 31) {
+		// Infinity or NaN
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	} else {
+		bits = sign | ((exponent + (127 - 15)) << 23) | (mantissa << 13);
+	}
+
+	float f;
+	memcpy(&f, &bits, sizeof(float));
+	return f;
+}
+
+} // namespace zylann::godot
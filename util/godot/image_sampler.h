@@ -0,0 +1,106 @@
+#ifndef ZN_GODOT_IMAGE_SAMPLER_H
+#define ZN_GODOT_IMAGE_SAMPLER_H
+
+#include "../containers/std_vector.h"
+#include "../math/funcs.h"
+#include "classes/image.h"
+#include "core/packed_byte_array.h"
+
+namespace zylann::godot {
+
+// Reads the red channel of an image straight from its memory, which is a lot faster than `Image::get_pixel`.
+// Common uncompressed formats are read directly, others go through `get_pixel`.
+// The image must not be modified while it is sampled. Sampling itself is thread-safe.
+class ImageSampler {
+public:
+	// Mipmaps are taken from the image if it has some.
+	void set_image(Ref<Image> image);
+
+	inline bool is_valid() const {
+		return _mipmaps.size() > 0;
+	}
+
+	// Mipmap 0 is the full-size image
+	inline unsigned int get_mipmap_count() const {
+		return _mipmaps.size();
+	}
+
+	inline int get_width(unsigned int mipmap) const {
+		return _mipmaps[mipmap].width;
+	}
+
+	inline int get_height(unsigned int mipmap) const {
+		return _mipmaps[mipmap].height;
+	}
+
+	// Coordinates wrap around, so the image repeats infinitely.
+	inline float get_pixel_repeat(int x, int y, unsigned int mipmap) const {
+		const Mipmap &mm = _mipmaps[mipmap];
+		x = math::wrap(x, mm.width);
+		y = math::wrap(y, mm.height);
+		const size_t i = mm.offset + (static_cast<size_t>(x) + static_cast<size_t>(y) * mm.width) * _pixel_size;
+		switch (_component_type) {
+			case COMPONENT_U8:
+				return _data_ptr[i] * (1.f / 255.f);
+			case COMPONENT_F32:
+				return *reinterpret_cast<const float *>(_data_ptr + i);
+			case COMPONENT_F16:
+				return half_to_float(*reinterpret_cast<const uint16_t *>(_data_ptr + i));
+			default:
+				return get_pixel_fallback(x, y);
+		}
+	}
+
+	// Coordinates are in pixels, with pixel centers at integer coordinates. The image repeats infinitely.
+	inline float get_pixel_repeat_bilinear(float x, float y, unsigned int mipmap) const {
+		const float xf = Math::floor(x);
+		const float yf = Math::floor(y);
+		const int x0 = static_cast<int>(xf);
+		const int y0 = static_cast<int>(yf);
+		const float tx = x - xf;
+		const float ty = y - yf;
+		const float h00 = get_pixel_repeat(x0, y0, mipmap);
+		const float h10 = get_pixel_repeat(x0 + 1, y0, mipmap);
+		const float h01 = get_pixel_repeat(x0, y0 + 1, mipmap);
+		const float h11 = get_pixel_repeat(x0 + 1, y0 + 1, mipmap);
+		return math::lerp(math::lerp(h00, h10, tx), math::lerp(h01, h11, tx), ty);
+	}
+
+	static float half_to_float(uint16_t h);
+
+private:
+	enum ComponentType : uint8_t {
+		COMPONENT_U8,
+		COMPONENT_F32,
+		COMPONENT_F16,
+		// Read with `get_pixel`
+		COMPONENT_OTHER
+	};
+
+	static bool get_red_component_layout(
+			Image::Format format,
+			ComponentType &out_component_type,
+			unsigned int &out_pixel_size
+	);
+
+	float get_pixel_fallback(int x, int y) const;
+
+	struct Mipmap {
+		size_t offset;
+		int width;
+		int height;
+	};
+
+	// Only used by the fallback path
+	Ref<Image> _image;
+	// Keeps a reference to the pixels so they remain valid
+	PackedByteArray _data;
+	const uint8_t *_data_ptr = nullptr;
+	StdVector<Mipmap> _mipmaps;
+	unsigned int _pixel_size = 0;
+	ComponentType _component_type = COMPONENT_OTHER;
+};
+
+} // namespace zylann::godot
+
+#endif // ZN_GODOT_IMAGE_SAMPLER_H
@@ -1,6 +1,7 @@
 #ifndef ZN_HASH_FUNCS_H
 #define ZN_HASH_FUNCS_H
 
+#include "containers/span.h"
 #include "math/funcs.h"
 #include <cstdint>
 
@@ -43,6 +44,16 @@ inline uint32_t hash_fmix32(uint32_t h) {
 	return h;
 }
 
+// FNV-1a 64-bit hash of a sequence of bytes. Not suitable for cryptography.
+inline uint64_t hash_fnv1a_64(Span<const uint8_t> p_data, uint64_t p_prev = 0xcbf29ce484222325) {
+	uint64_t h = p_prev;
+	for (const uint8_t b : p_data) {
+		h ^= b;
+		h *= 0x100000001b3;
+	}
+	return h;
+}
+
 } // namespace zylann
 
 #endif // ZN_HASH_FUNCS_H
@@ -3,6 +3,8 @@
 
 #include "containers/fixed_array.h"
 #include "containers/span.h"
+#include "containers/std_vector.h"
+#include "errors.h"
 #include "math/box3i.h"
 
 namespace zylann {
@@ -212,6 +214,126 @@ private:
 	FixedArray<uint8_t, MAX_ISLANDS> _equivalences;
 };
 
+// Merges labels of a grid that was labelled in separate slabs along the Z axis, typically by running `IslandFinder`
+// on each slab independently (possibly on different threads). Labels in the grid are assumed to be local to each slab,
+// starting from 1. They get replaced with global labels, also starting from 1.
+//
+// Slabs are contiguous in memory because the grid is in ZXY order, so they can be labelled without copying anything.
+// Islands crossing slab boundaries are joined using a union-find over slab-local labels.
+//
+class IslandSlabMerger {
+public:
+	struct Slab {
+		// First Z coordinate of the slab in the grid
+		int begin_z;
+		// Amount of labels found in the slab
+		unsigned int label_count;
+	};
+
+	// Returns the total amount of islands. If there are more than `IslandFinder::MAX_ISLANDS - 1` islands, extra ones
+	// are discarded (set to 0) and `out_overflow` is set to true.
+	unsigned int merge(Span<uint8_t> grid, const Vector3i size, Span<const Slab> slabs, bool *out_overflow) {
+		ZN_ASSERT_RETURN_V(grid.size() == Vector3iUtil::get_volume(size), 0);
+
+		// Offset of each slab's labels in the union-find array
+		_offsets.resize(slabs.size());
+		unsigned int total_local_labels = 0;
+		for (unsigned int slab_index = 0; slab_index < slabs.size(); ++slab_index) {
+			_offsets[slab_index] = total_local_labels;
+			total_local_labels += slabs[slab_index].label_count;
+		}
+
+		_parents.resize(total_local_labels);
+		for (unsigned int i = 0; i < _parents.size(); ++i) {
+			_parents[i] = i;
+		}
+
+		// Join labels touching each other on both sides of slab boundaries
+		const unsigned int deck_area = size.x * size.y;
+		for (unsigned int slab_index = 1; slab_index < slabs.size(); ++slab_index) {
+			const unsigned int z = slabs[slab_index].begin_z;
+			ZN_ASSERT_CONTINUE(z > 0 && int(z) < size.z);
+
+			const unsigned int deck_index = z * deck_area;
+			const unsigned int prev_deck_index = deck_index - deck_area;
+			const uint32_t offset = _offsets[slab_index];
+			const uint32_t prev_offset = _offsets[slab_index - 1];
+
+			for (unsigned int i = 0; i < deck_area; ++i) {
+				const uint8_t label = grid[deck_index + i];
+				const uint8_t prev_label = grid[prev_deck_index + i];
+				if (label != 0 && prev_label != 0) {
+					unite(offset + label - 1, prev_offset + prev_label - 1);
+				}
+			}
+		}
+
+		// Give consecutive global labels to roots
+		_global_labels.resize(total_local_labels);
+		unsigned int next_label = 1;
+		bool overflow = false;
+		for (unsigned int i = 0; i < _parents.size(); ++i) {
+			if (find(i) == i) {
+				if (next_label < IslandFinder::MAX_ISLANDS) {
+					_global_labels[i] = next_label;
+					++next_label;
+				} else {
+					_global_labels[i] = 0;
+					overflow = true;
+				}
+			}
+		}
+		for (unsigned int i = 0; i < _parents.size(); ++i) {
+			_global_labels[i] = _global_labels[find(i)];
+		}
+
+		// Remap the grid
+		for (unsigned int slab_index = 0; slab_index < slabs.size(); ++slab_index) {
+			const unsigned int begin_z = slabs[slab_index].begin_z;
+			const unsigned int end_z = slab_index + 1 < slabs.size() ? slabs[slab_index + 1].begin_z : size.z;
+			const uint32_t offset = _offsets[slab_index];
+
+			Span<uint8_t> slab_cells = grid.sub(begin_z * deck_area, (end_z - begin_z) * deck_area);
+			for (uint8_t &c : slab_cells) {
+				if (c != 0) {
+					c = _global_labels[offset + c - 1];
+				}
+			}
+		}
+
+		if (out_overflow != nullptr) {
+			*out_overflow = overflow;
+		}
+
+		return next_label - 1;
+	}
+
+private:
+	uint32_t find(uint32_t i) {
+		while (_parents[i] != i) {
+			// Path halving
+			_parents[i] = _parents[_parents[i]];
+			i = _parents[i];
+		}
+		return i;
+	}
+
+	void unite(uint32_t a, uint32_t b) {
+		a = find(a);
+		b = find(b);
+		// Keep the lowest index as root, so labels stay ordered similarly to a single-pass scan
+		if (a < b) {
+			_parents[b] = a;
+		} else if (b < a) {
+			_parents[a] = b;
+		}
+	}
+
+	StdVector<uint32_t> _offsets;
+	StdVector<uint32_t> _parents;
+	StdVector<uint8_t> _global_labels;
+};
+
 } // namespace zylann
 
 #endif // ISLAND_FINDER_H
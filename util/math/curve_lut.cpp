@@ -0,0 +1,135 @@
+#include "curve_lut.h"
+#include "../errors.h"
+#include "funcs.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ZN_CURVE_LUT_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define ZN_CURVE_LUT_NEON
+#include <arm_neon.h>
+#endif
+
+namespace zylann::math {
+
+void CurveLUT::create(Span<const float> values) {
+	ZN_ASSERT_RETURN(values.size() > 0);
+
+	_point_count = values.size();
+	_x_scale = _point_count - 1;
+
+	_points.resize(_point_count + 1);
+	for (unsigned int i = 0; i + 1 < _point_count; ++i) {
+		_points[i] = Point{ values[i], values[i + 1] - values[i] };
+	}
+	const float last_value = values[_point_count - 1];
+	_points[_point_count - 1] = Point{ last_value, 0.f };
+	_points[_point_count] = Point{ last_value, 0.f };
+
+	_tree.resize(2 * _point_count);
+	for (unsigned int i = 0; i < _point_count; ++i) {
+		_tree[_point_count + i] = Interval::from_single_value(values[i]);
+	}
+	for (unsigned int i = _point_count - 1; i > 0; --i) {
+		_tree[i] = Interval::from_union(_tree[2 * i], _tree[2 * i + 1]);
+	}
+}
+
+void CurveLUT::sample(Span<const float> x, Span<float> out) const {
+	ZN_ASSERT_RETURN(x.size() == out.size());
+	ZN_ASSERT_RETURN(is_valid());
+
+	unsigned int i = 0;
+	const Point *points = _points.data();
+
+	// Lookups can't be vectorized, but computing indices and interpolating can. Both steps are done in the same order
+	// as the scalar version so results are the same.
+#if defined(ZN_CURVE_LUT_SSE2)
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 x_scale = _mm_set1_ps(_x_scale);
+	alignas(16) int32_t indices[4];
+
+	for (; i + 4 <= x.size(); i += 4) {
+		__m128 fi = _mm_mul_ps(_mm_loadu_ps(&x[i]), x_scale);
+		// Gives the second operand if the first is NaN
+		fi = _mm_max_ps(fi, zero);
+		fi = _mm_min_ps(fi, x_scale);
+		const __m128i ii = _mm_cvttps_epi32(fi);
+		const __m128 t = _mm_sub_ps(fi, _mm_cvtepi32_ps(ii));
+		_mm_store_si128(reinterpret_cast<__m128i *>(indices), ii);
+
+		const Point p0 = points[indices[0]];
+		const Point p1 = points[indices[1]];
+		const Point p2 = points[indices[2]];
+		const Point p3 = points[indices[3]];
+		const __m128 y = _mm_setr_ps(p0.y, p1.y, p2.y, p3.y);
+		const __m128 dy = _mm_setr_ps(p0.dy, p1.dy, p2.dy, p3.dy);
+
+		_mm_storeu_ps(&out[i], _mm_add_ps(y, _mm_mul_ps(dy, t)));
+	}
+
+#elif defined(ZN_CURVE_LUT_NEON)
+	const float32x4_t zero = vdupq_n_f32(0.f);
+	const float32x4_t x_scale = vdupq_n_f32(_x_scale);
+	alignas(16) uint32_t indices[4];
+
+	for (; i + 4 <= x.size(); i += 4) {
+		float32x4_t fi = vmulq_f32(vld1q_f32(&x[i]), x_scale);
+		// Also replaces NaN
+		fi = vbslq_f32(vcgtq_f32(fi, zero), fi, zero);
+		fi = vminq_f32(fi, x_scale);
+		const uint32x4_t ii = vcvtq_u32_f32(fi);
+		const float32x4_t t = vsubq_f32(fi, vcvtq_f32_u32(ii));
+		vst1q_u32(indices, ii);
+
+		const Point p0 = points[indices[0]];
+		const Point p1 = points[indices[1]];
+		const Point p2 = points[indices[2]];
+		const Point p3 = points[indices[3]];
+		const float y_array[4] = { p0.y, p1.y, p2.y, p3.y };
+		const float dy_array[4] = { p0.dy, p1.dy, p2.dy, p3.dy };
+
+		// Not using fused multiply-add, to get the same results as the scalar version
+		vst1q_f32(&out[i], vaddq_f32(vld1q_f32(y_array), vmulq_f32(vld1q_f32(dy_array), t)));
+	}
+#endif
+
+	for (; i < x.size(); ++i) {
+		out[i] = sample(x[i]);
+	}
+}
+
+Interval CurveLUT::get_points_range(unsigned int begin, unsigned int end) const {
+	Interval range = Interval::from_single_value(_tree[_point_count + begin].min);
+	for (begin += _point_count, end += _point_count; begin < end; begin >>= 1, end >>= 1) {
+		if ((begin & 1) != 0) {
+			range.add_interval(_tree[begin]);
+			++begin;
+		}
+		if ((end & 1) != 0) {
+			--end;
+			range.add_interval(_tree[end]);
+		}
+	}
+	return range;
+}
+
+Interval CurveLUT::get_range(Interval x) const {
+	ZN_ASSERT_RETURN_V(is_valid(), Interval());
+
+	// The curve is linear between points, so its extremes are either at the ends of the range, or at points inside it
+	Interval range = Interval::from_unordered_values(sample(x.min), sample(x.max));
+
+	const float fi_min = math::clamp(x.min * _x_scale, 0.f, _x_scale);
+	const float fi_max = math::clamp(x.max * _x_scale, 0.f, _x_scale);
+	const unsigned int begin = static_cast<unsigned int>(Math::floor(fi_min)) + 1;
+	const unsigned int end = static_cast<unsigned int>(Math::ceil(fi_max));
+
+	if (begin < end) {
+		range.add_interval(get_points_range(begin, end));
+	}
+
+	return range;
+}
+
+} // namespace zylann::math
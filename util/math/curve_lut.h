@@ -0,0 +1,66 @@
+#ifndef ZN_MATH_CURVE_LUT_H
+#define ZN_MATH_CURVE_LUT_H
+
+#include "../containers/span.h"
+#include "../containers/std_vector.h"
+#include "interval.h"
+
+namespace zylann::math {
+
+// Piecewise-linear function of X in [0..1], stored as uniformly spaced values. X is clamped to that range.
+// Sampling gives the same results as Godot's `Curve::sample_baked` when values are the baked points of a curve,
+// without touching the curve, which isn't thread-safe and is slower to sample.
+// Range queries are exact, using a tree of min/max values.
+class CurveLUT {
+public:
+	// At least one value is required.
+	void create(Span<const float> values);
+
+	inline bool is_valid() const {
+		return _point_count > 0;
+	}
+
+	inline unsigned int get_point_count() const {
+		return _point_count;
+	}
+
+	inline float sample(float x) const {
+		float fi = x * _x_scale;
+		// Also catches NaN
+		if (!(fi > 0.f)) {
+			fi = 0.f;
+		} else if (fi > _x_scale) {
+			fi = _x_scale;
+		}
+		const unsigned int i = static_cast<unsigned int>(fi);
+		const Point p = _points[i];
+		return p.y + p.dy * (fi - i);
+	}
+
+	// Samples several values at once, using SIMD when available.
+	void sample(Span<const float> x, Span<float> out) const;
+
+	// Gets the exact range of values taken by the curve between two X positions.
+	Interval get_range(Interval x) const;
+
+private:
+	struct Point {
+		float y;
+		// Difference with the next point, so interpolating only needs one load per sample
+		float dy;
+	};
+
+	Interval get_points_range(unsigned int begin, unsigned int end) const;
+
+	// Has one more point than the curve, repeating the last one, so X = 1 doesn't need special handling
+	StdVector<Point> _points;
+	// Segment tree of min/max values of points. Leaves are in the second half, and each parent `i` covers children
+	// `2 * i` and `2 * i + 1`.
+	StdVector<Interval> _tree;
+	unsigned int _point_count = 0;
+	float _x_scale = 0.f;
+};
+
+} // namespace zylann::math
+
+#endif // ZN_MATH_CURVE_LUT_H
@@ -1,6 +1,7 @@
 #include "fast_noise_lite.h"
 #include "../../godot/core/array.h"
 #include "../../math/funcs.h"
+#include "fast_noise_lite_simd.h"
 
 namespace zylann {
 
@@ -222,6 +223,171 @@ ZN_FastNoiseLite::RotationType3D ZN_FastNoiseLite::get_rotation_type_3d() const
 	return _rotation_type_3d;
 }
 
+namespace {
+// Points are processed in chunks of this size when coordinates have to be computed first, so they fit on the stack
+static const unsigned int SERIES_CHUNK_SIZE = 128;
+} // namespace
+
+void ZN_FastNoiseLite::get_noise_2d_series(
+		Span<const float> x_buffer,
+		Span<const float> y_buffer,
+		Span<float> out_values
+) const {
+	ZN_ASSERT_RETURN(x_buffer.size() == out_values.size());
+	ZN_ASSERT_RETURN(y_buffer.size() == out_values.size());
+
+	if (_warp_noise.is_null()) {
+		fast_noise_lite_simd::get_noise_2d_series(_fn, x_buffer, y_buffer, out_values);
+		return;
+	}
+
+	float warped_x[SERIES_CHUNK_SIZE];
+	float warped_y[SERIES_CHUNK_SIZE];
+
+	for (unsigned int begin = 0; begin < out_values.size(); begin += SERIES_CHUNK_SIZE) {
+		const unsigned int count = math::min<unsigned int>(SERIES_CHUNK_SIZE, out_values.size() - begin);
+
+		for (unsigned int i = 0; i < count; ++i) {
+			real_t x = x_buffer[begin + i];
+			real_t y = y_buffer[begin + i];
+			_warp_noise->warp_2d(x, y);
+			warped_x[i] = x;
+			warped_y[i] = y;
+		}
+
+		fast_noise_lite_simd::get_noise_2d_series(
+				_fn,
+				Span<const float>(warped_x, count),
+				Span<const float>(warped_y, count),
+				out_values.sub(begin, count)
+		);
+	}
+}
+
+void ZN_FastNoiseLite::get_noise_3d_series(
+		Span<const float> x_buffer,
+		Span<const float> y_buffer,
+		Span<const float> z_buffer,
+		Span<float> out_values
+) const {
+	ZN_ASSERT_RETURN(x_buffer.size() == out_values.size());
+	ZN_ASSERT_RETURN(y_buffer.size() == out_values.size());
+	ZN_ASSERT_RETURN(z_buffer.size() == out_values.size());
+
+	if (_warp_noise.is_null()) {
+		fast_noise_lite_simd::get_noise_3d_series(_fn, x_buffer, y_buffer, z_buffer, out_values);
+		return;
+	}
+
+	float warped_x[SERIES_CHUNK_SIZE];
+	float warped_y[SERIES_CHUNK_SIZE];
+	float warped_z[SERIES_CHUNK_SIZE];
+
+	for (unsigned int begin = 0; begin < out_values.size(); begin += SERIES_CHUNK_SIZE) {
+		const unsigned int count = math::min<unsigned int>(SERIES_CHUNK_SIZE, out_values.size() - begin);
+
+		for (unsigned int i = 0; i < count; ++i) {
+			real_t x = x_buffer[begin + i];
+			real_t y = y_buffer[begin + i];
+			real_t z = z_buffer[begin + i];
+			_warp_noise->warp_3d(x, y, z);
+			warped_x[i] = x;
+			warped_y[i] = y;
+			warped_z[i] = z;
+		}
+
+		fast_noise_lite_simd::get_noise_3d_series(
+				_fn,
+				Span<const float>(warped_x, count),
+				Span<const float>(warped_y, count),
+				Span<const float>(warped_z, count),
+				out_values.sub(begin, count)
+		);
+	}
+}
+
+void ZN_FastNoiseLite::fill_grid_2d(Vector2f origin, float step, Vector2i size, Span<float> out_values) const {
+	ZN_ASSERT_RETURN(size.x >= 0 && size.y >= 0);
+	ZN_ASSERT_RETURN(out_values.size() == static_cast<size_t>(Vector2iUtil::get_area(size)));
+
+	float xs[SERIES_CHUNK_SIZE];
+	float ys[SERIES_CHUNK_SIZE];
+	unsigned int chunk_begin = 0;
+	unsigned int count = 0;
+
+	// Points are generated in the same order as outputs, and flushed every time a chunk is full
+	for (int y = 0; y < size.y; ++y) {
+		const float py = origin.y + static_cast<float>(y) * step;
+
+		for (int x = 0; x < size.x; ++x) {
+			xs[count] = origin.x + static_cast<float>(x) * step;
+			ys[count] = py;
+			++count;
+
+			if (count == SERIES_CHUNK_SIZE) {
+				get_noise_2d_series(
+						Span<const float>(xs, count), Span<const float>(ys, count), out_values.sub(chunk_begin, count)
+				);
+				chunk_begin += count;
+				count = 0;
+			}
+		}
+	}
+
+	if (count > 0) {
+		get_noise_2d_series(
+				Span<const float>(xs, count), Span<const float>(ys, count), out_values.sub(chunk_begin, count)
+		);
+	}
+}
+
+void ZN_FastNoiseLite::fill_grid_3d(Vector3f origin, float step, Vector3i size, Span<float> out_values) const {
+	ZN_ASSERT_RETURN(size.x >= 0 && size.y >= 0 && size.z >= 0);
+	ZN_ASSERT_RETURN(out_values.size() == static_cast<size_t>(Vector3iUtil::get_volume(size)));
+
+	float xs[SERIES_CHUNK_SIZE];
+	float ys[SERIES_CHUNK_SIZE];
+	float zs[SERIES_CHUNK_SIZE];
+	unsigned int chunk_begin = 0;
+	unsigned int count = 0;
+
+	// Points are generated in the same order as outputs, and flushed every time a chunk is full
+	for (int z = 0; z < size.z; ++z) {
+		const float pz = origin.z + static_cast<float>(z) * step;
+
+		for (int x = 0; x < size.x; ++x) {
+			const float px = origin.x + static_cast<float>(x) * step;
+
+			for (int y = 0; y < size.y; ++y) {
+				xs[count] = px;
+				ys[count] = origin.y + static_cast<float>(y) * step;
+				zs[count] = pz;
+				++count;
+
+				if (count == SERIES_CHUNK_SIZE) {
+					get_noise_3d_series(
+							Span<const float>(xs, count),
+							Span<const float>(ys, count),
+							Span<const float>(zs, count),
+							out_values.sub(chunk_begin, count)
+					);
+					chunk_begin += count;
+					count = 0;
+				}
+			}
+		}
+	}
+
+	if (count > 0) {
+		get_noise_3d_series(
+				Span<const float>(xs, count),
+				Span<const float>(ys, count),
+				Span<const float>(zs, count),
+				out_values.sub(chunk_begin, count)
+		);
+	}
+}
+
 void ZN_FastNoiseLite::_on_warp_noise_changed() {
 	emit_changed();
 }
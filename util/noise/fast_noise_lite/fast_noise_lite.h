@@ -1,6 +1,11 @@
 #ifndef ZYLANN_FAST_NOISE_LITE_H
 #define ZYLANN_FAST_NOISE_LITE_H
 
+#include "../../containers/span.h"
+#include "../../math/vector2f.h"
+#include "../../math/vector2i.h"
+#include "../../math/vector3f.h"
+#include "../../math/vector3i.h"
 #include "fast_noise_lite_gradient.h"
 
 namespace zylann {
@@ -140,6 +145,23 @@ public:
 		return _fn.GetNoise(x, y, z);
 	}
 
+	// Batch queries. They are faster than calling `get_noise_*` in a loop, because points are processed several at a
+	// time with SIMD instructions when the noise type supports it. Coordinates are single-precision.
+
+	void get_noise_2d_series(Span<const float> x_buffer, Span<const float> y_buffer, Span<float> out_values) const;
+	void get_noise_3d_series(
+			Span<const float> x_buffer,
+			Span<const float> y_buffer,
+			Span<const float> z_buffer,
+			Span<float> out_values
+	) const;
+
+	// Samples noise on a regular grid of `size` points starting at `origin`, spaced by `step`.
+	// Values are ordered with X varying first, then Y.
+	void fill_grid_2d(Vector2f origin, float step, Vector2i size, Span<float> out_values) const;
+	// Values are in ZXY order (Y varying first), like voxel buffers.
+	void fill_grid_3d(Vector3f origin, float step, Vector3i size, Span<float> out_values) const;
+
 	// TODO Have a separate cell noise? It outputs multiple things, but we only get one.
 	// To get the others the API forces to calculate it a second time, and it's the most expensive noise...
 
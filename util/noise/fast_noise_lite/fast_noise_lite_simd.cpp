@@ -0,0 +1,886 @@
+#include "fast_noise_lite_simd.h"
+#include "../../../thirdparty/fast_noise/FastNoiseLite.h"
+#include "../../errors.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ZN_FNL_SIMD_SSE2
+#include <emmintrin.h>
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define ZN_FNL_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(ZN_FNL_SIMD_SSE2) || defined(ZN_FNL_SIMD_NEON)
+#define ZN_FNL_SIMD
+#endif
+
+namespace zylann::fast_noise_lite_simd {
+
+typedef ::fast_noise_lite::FastNoiseLite FNL;
+
+#ifdef ZN_FNL_SIMD
+
+namespace {
+
+// Thin wrappers over the intrinsics of the target, so kernels can be written once.
+// Kernels below replicate the operations of the scalar implementation in the same order, so results match as
+// closely as possible.
+
+static const unsigned int LANES = 4;
+
+#if defined(ZN_FNL_SIMD_SSE2)
+
+struct FloatV {
+	__m128 v;
+};
+struct IntV {
+	__m128i v;
+};
+// All bits set in lanes where the condition is true
+struct MaskV {
+	__m128 v;
+};
+
+inline FloatV fv(float f) {
+	return { _mm_set1_ps(f) };
+}
+inline IntV iv(int i) {
+	return { _mm_set1_epi32(i) };
+}
+inline FloatV load(const float *p) {
+	return { _mm_loadu_ps(p) };
+}
+inline void store(float *p, FloatV a) {
+	_mm_storeu_ps(p, a.v);
+}
+inline void store(int *p, IntV a) {
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(p), a.v);
+}
+
+inline FloatV operator+(FloatV a, FloatV b) {
+	return { _mm_add_ps(a.v, b.v) };
+}
+inline FloatV operator-(FloatV a, FloatV b) {
+	return { _mm_sub_ps(a.v, b.v) };
+}
+inline FloatV operator*(FloatV a, FloatV b) {
+	return { _mm_mul_ps(a.v, b.v) };
+}
+inline FloatV operator-(FloatV a) {
+	return { _mm_xor_ps(a.v, _mm_set1_ps(-0.f)) };
+}
+inline FloatV min(FloatV a, FloatV b) {
+	return { _mm_min_ps(a.v, b.v) };
+}
+inline FloatV abs(FloatV a) {
+	return { _mm_andnot_ps(_mm_set1_ps(-0.f), a.v) };
+}
+
+inline MaskV operator<(FloatV a, FloatV b) {
+	return { _mm_cmplt_ps(a.v, b.v) };
+}
+inline MaskV operator<=(FloatV a, FloatV b) {
+	return { _mm_cmple_ps(a.v, b.v) };
+}
+inline MaskV operator>(FloatV a, FloatV b) {
+	return { _mm_cmpgt_ps(a.v, b.v) };
+}
+inline MaskV operator>=(FloatV a, FloatV b) {
+	return { _mm_cmpge_ps(a.v, b.v) };
+}
+inline MaskV operator&(MaskV a, MaskV b) {
+	return { _mm_and_ps(a.v, b.v) };
+}
+inline MaskV operator~(MaskV a) {
+	return { _mm_xor_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(-1))) };
+}
+
+inline FloatV select(MaskV m, FloatV a, FloatV b) {
+	return { _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v)) };
+}
+inline IntV select(MaskV m, IntV a, IntV b) {
+	const __m128i mi = _mm_castps_si128(m.v);
+	return { _mm_or_si128(_mm_and_si128(mi, a.v), _mm_andnot_si128(mi, b.v)) };
+}
+// -1 where true, 0 where false
+inline IntV to_int(MaskV m) {
+	return { _mm_castps_si128(m.v) };
+}
+
+inline FloatV to_float(IntV a) {
+	return { _mm_cvtepi32_ps(a.v) };
+}
+// Same as a C cast
+inline IntV truncate(FloatV a) {
+	return { _mm_cvttps_epi32(a.v) };
+}
+
+inline IntV operator+(IntV a, IntV b) {
+	return { _mm_add_epi32(a.v, b.v) };
+}
+inline IntV operator-(IntV a, IntV b) {
+	return { _mm_sub_epi32(a.v, b.v) };
+}
+inline IntV operator-(IntV a) {
+	return { _mm_sub_epi32(_mm_setzero_si128(), a.v) };
+}
+inline IntV operator*(IntV a, IntV b) {
+#ifdef __SSE4_1__
+	return { _mm_mullo_epi32(a.v, b.v) };
+#else
+	// SSE2 only has 32x32->64 unsigned multiplication, which gives the same low bits
+	const __m128i even = _mm_mul_epu32(a.v, b.v);
+	const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a.v, 4), _mm_srli_si128(b.v, 4));
+	return { _mm_unpacklo_epi32(
+			_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))
+	) };
+#endif
+}
+inline IntV operator^(IntV a, IntV b) {
+	return { _mm_xor_si128(a.v, b.v) };
+}
+inline IntV operator&(IntV a, IntV b) {
+	return { _mm_and_si128(a.v, b.v) };
+}
+inline IntV operator|(IntV a, IntV b) {
+	return { _mm_or_si128(a.v, b.v) };
+}
+template <int N>
+inline IntV shift_right(IntV a) {
+	return { _mm_srai_epi32(a.v, N) };
+}
+template <int N>
+inline IntV shift_left(IntV a) {
+	return { _mm_slli_epi32(a.v, N) };
+}
+
+#elif defined(ZN_FNL_SIMD_NEON)
+
+struct FloatV {
+	float32x4_t v;
+};
+struct IntV {
+	int32x4_t v;
+};
+// All bits set in lanes where the condition is true
+struct MaskV {
+	uint32x4_t v;
+};
+
+inline FloatV fv(float f) {
+	return { vdupq_n_f32(f) };
+}
+inline IntV iv(int i) {
+	return { vdupq_n_s32(i) };
+}
+inline FloatV load(const float *p) {
+	return { vld1q_f32(p) };
+}
+inline void store(float *p, FloatV a) {
+	vst1q_f32(p, a.v);
+}
+inline void store(int *p, IntV a) {
+	vst1q_s32(p, a.v);
+}
+
+inline FloatV operator+(FloatV a, FloatV b) {
+	return { vaddq_f32(a.v, b.v) };
+}
+inline FloatV operator-(FloatV a, FloatV b) {
+	return { vsubq_f32(a.v, b.v) };
+}
+inline FloatV operator*(FloatV a, FloatV b) {
+	return { vmulq_f32(a.v, b.v) };
+}
+inline FloatV operator-(FloatV a) {
+	return { vnegq_f32(a.v) };
+}
+inline FloatV min(FloatV a, FloatV b) {
+	return { vminq_f32(a.v, b.v) };
+}
+inline FloatV abs(FloatV a) {
+	return { vabsq_f32(a.v) };
+}
+
+inline MaskV operator<(FloatV a, FloatV b) {
+	return { vcltq_f32(a.v, b.v) };
+}
+inline MaskV operator<=(FloatV a, FloatV b) {
+	return { vcleq_f32(a.v, b.v) };
+}
+inline MaskV operator>(FloatV a, FloatV b) {
+	return { vcgtq_f32(a.v, b.v) };
+}
+inline MaskV operator>=(FloatV a, FloatV b) {
+	return { vcgeq_f32(a.v, b.v) };
+}
+inline MaskV operator&(MaskV a, MaskV b) {
+	return { vandq_u32(a.v, b.v) };
+}
+inline MaskV operator~(MaskV a) {
+	return { vmvnq_u32(a.v) };
+}
+
+inline FloatV select(MaskV m, FloatV a, FloatV b) {
+	return { vbslq_f32(m.v, a.v, b.v) };
+}
+inline IntV select(MaskV m, IntV a, IntV b) {
+	return { vbslq_s32(m.v, a.v, b.v) };
+}
+// -1 where true, 0 where false
+inline IntV to_int(MaskV m) {
+	return { vreinterpretq_s32_u32(m.v) };
+}
+
+inline FloatV to_float(IntV a) {
+	return { vcvtq_f32_s32(a.v) };
+}
+// Same as a C cast
+inline IntV truncate(FloatV a) {
+	return { vcvtq_s32_f32(a.v) };
+}
+
+inline IntV operator+(IntV a, IntV b) {
+	return { vaddq_s32(a.v, b.v) };
+}
+inline IntV operator-(IntV a, IntV b) {
+	return { vsubq_s32(a.v, b.v) };
+}
+inline IntV operator-(IntV a) {
+	return { vnegq_s32(a.v) };
+}
+inline IntV operator*(IntV a, IntV b) {
+	return { vmulq_s32(a.v, b.v) };
+}
+inline IntV operator^(IntV a, IntV b) {
+	return { veorq_s32(a.v, b.v) };
+}
+inline IntV operator&(IntV a, IntV b) {
+	return { vandq_s32(a.v, b.v) };
+}
+inline IntV operator|(IntV a, IntV b) {
+	return { vorrq_s32(a.v, b.v) };
+}
+template <int N>
+inline IntV shift_right(IntV a) {
+	return { vshrq_n_s32(a.v, N) };
+}
+template <int N>
+inline IntV shift_left(IntV a) {
+	return { vshlq_n_s32(a.v, N) };
+}
+
+#endif
+
+// Common helpers
+
+inline IntV fast_floor(FloatV f) {
+	// `(int)f - 1` for negative values
+	return truncate(f) + to_int(f < fv(0.f));
+}
+
+inline IntV fast_round(FloatV f) {
+	return select(f >= fv(0.f), truncate(f + fv(0.5f)), truncate(f - fv(0.5f)));
+}
+
+inline FloatV lerp(FloatV a, FloatV b, FloatV t) {
+	return a + t * (b - a);
+}
+
+inline FloatV interp_hermite(FloatV t) {
+	return t * t * (fv(3.f) - fv(2.f) * t);
+}
+
+inline FloatV interp_quintic(FloatV t) {
+	return t * t * t * (t * (t * fv(6.f) - fv(15.f)) + fv(10.f));
+}
+
+inline FloatV ping_pong(FloatV t) {
+	const IntV i = truncate(t * fv(0.5f));
+	t = t - to_float(i + i);
+	return select(t < fv(1.f), t, fv(2.f) - t);
+}
+
+// Hashing
+
+inline IntV hash(int seed, IntV x_primed, IntV y_primed) {
+	return (iv(seed) ^ x_primed ^ y_primed) * iv(0x27d4eb2d);
+}
+
+inline IntV hash(int seed, IntV x_primed, IntV y_primed, IntV z_primed) {
+	return (iv(seed) ^ x_primed ^ y_primed ^ z_primed) * iv(0x27d4eb2d);
+}
+
+// Tables are not contiguous per lane, so they are read one lane at a time
+inline FloatV gather(const float *table, const int *indices) {
+	const float values[LANES] = { table[indices[0]], table[indices[1]], table[indices[2]], table[indices[3]] };
+	return load(values);
+}
+
+inline FloatV val_coord(int seed, IntV x_primed, IntV y_primed) {
+	IntV h = hash(seed, x_primed, y_primed);
+	h = h * h;
+	h = h ^ shift_left<19>(h);
+	return to_float(h) * fv(1 / 2147483648.0f);
+}
+
+inline FloatV val_coord(int seed, IntV x_primed, IntV y_primed, IntV z_primed) {
+	IntV h = hash(seed, x_primed, y_primed, z_primed);
+	h = h * h;
+	h = h ^ shift_left<19>(h);
+	return to_float(h) * fv(1 / 2147483648.0f);
+}
+
+inline FloatV grad_coord(int seed, IntV x_primed, IntV y_primed, FloatV xd, FloatV yd) {
+	IntV h = hash(seed, x_primed, y_primed);
+	h = h ^ shift_right<15>(h);
+	h = h & iv(127 << 1);
+
+	int indices[LANES];
+	store(indices, h);
+	// Indices are even, so `index | 1` is `index + 1`
+	const float *table = FNL::Lookup<float>::Gradients2D;
+	const FloatV xg = gather(table, indices);
+	const FloatV yg = gather(table + 1, indices);
+
+	return xd * xg + yd * yg;
+}
+
+inline FloatV grad_coord(int seed, IntV x_primed, IntV y_primed, IntV z_primed, FloatV xd, FloatV yd, FloatV zd) {
+	IntV h = hash(seed, x_primed, y_primed, z_primed);
+	h = h ^ shift_right<15>(h);
+	h = h & iv(63 << 2);
+
+	int indices[LANES];
+	store(indices, h);
+	// Indices are multiples of 4, so `index | n` is `index + n`
+	const float *table = FNL::Lookup<float>::Gradients3D;
+	const FloatV xg = gather(table, indices);
+	const FloatV yg = gather(table + 1, indices);
+	const FloatV zg = gather(table + 2, indices);
+
+	return xd * xg + yd * yg + zd * zg;
+}
+
+// Noise types
+
+FloatV single_simplex(int seed, FloatV x, FloatV y) {
+	const float SQRT3 = 1.7320508075688772935274463415059f;
+	const float G2 = (3 - SQRT3) / 6;
+
+	IntV i = fast_floor(x);
+	IntV j = fast_floor(y);
+	const FloatV xi = x - to_float(i);
+	const FloatV yi = y - to_float(j);
+
+	const FloatV t = (xi + yi) * fv(G2);
+	const FloatV x0 = xi - t;
+	const FloatV y0 = yi - t;
+
+	i = i * iv(FNL::PrimeX);
+	j = j * iv(FNL::PrimeY);
+
+	const FloatV a = fv(0.5f) - x0 * x0 - y0 * y0;
+	const FloatV n0 = select(a <= fv(0.f), fv(0.f), (a * a) * (a * a) * grad_coord(seed, i, j, x0, y0));
+
+	const FloatV c = fv((float)(2 * (1 - 2 * G2) * (1 / G2 - 2))) * t +
+			(fv((float)(-2 * (1 - 2 * G2) * (1 - 2 * G2))) + a);
+	const FloatV x2 = x0 + fv(2 * (float)G2 - 1);
+	const FloatV y2 = y0 + fv(2 * (float)G2 - 1);
+	const FloatV n2 = select(
+			c <= fv(0.f),
+			fv(0.f),
+			(c * c) * (c * c) * grad_coord(seed, i + iv(FNL::PrimeX), j + iv(FNL::PrimeY), x2, y2)
+	);
+
+	const MaskV y_greater = y0 > x0;
+	const FloatV x1 = x0 + select(y_greater, fv((float)G2), fv((float)G2 - 1));
+	const FloatV y1 = y0 + select(y_greater, fv((float)G2 - 1), fv((float)G2));
+	const IntV i1 = select(y_greater, i, i + iv(FNL::PrimeX));
+	const IntV j1 = select(y_greater, j + iv(FNL::PrimeY), j);
+	const FloatV b = fv(0.5f) - x1 * x1 - y1 * y1;
+	const FloatV n1 = select(b <= fv(0.f), fv(0.f), (b * b) * (b * b) * grad_coord(seed, i1, j1, x1, y1));
+
+	return (n0 + n1 + n2) * fv(99.83685446303647f);
+}
+
+FloatV single_open_simplex_2(int seed, FloatV x, FloatV y, FloatV z) {
+	IntV i = fast_round(x);
+	IntV j = fast_round(y);
+	IntV k = fast_round(z);
+	FloatV x0 = x - to_float(i);
+	FloatV y0 = y - to_float(j);
+	FloatV z0 = z - to_float(k);
+
+	IntV x_nsign = truncate(fv(-1.0f) - x0) | iv(1);
+	IntV y_nsign = truncate(fv(-1.0f) - y0) | iv(1);
+	IntV z_nsign = truncate(fv(-1.0f) - z0) | iv(1);
+
+	FloatV ax0 = to_float(x_nsign) * -x0;
+	FloatV ay0 = to_float(y_nsign) * -y0;
+	FloatV az0 = to_float(z_nsign) * -z0;
+
+	i = i * iv(FNL::PrimeX);
+	j = j * iv(FNL::PrimeY);
+	k = k * iv(FNL::PrimeZ);
+
+	FloatV value = fv(0.f);
+	FloatV a = (fv(0.6f) - x0 * x0) - (y0 * y0 + z0 * z0);
+
+	for (int l = 0;; l++) {
+		value = value + select(a > fv(0.f), (a * a) * (a * a) * grad_coord(seed, i, j, k, x0, y0, z0), fv(0.f));
+
+		// Only one of the three axes is moved along per lane
+		const MaskV along_x = (ax0 >= ay0) & (ax0 >= az0);
+		const MaskV along_y = (~along_x) & (ay0 > ax0) & (ay0 >= az0);
+		const MaskV along_z = ~along_x & ~along_y;
+
+		const FloatV x1 = select(along_x, x0 + to_float(x_nsign), x0);
+		const FloatV y1 = select(along_y, y0 + to_float(y_nsign), y0);
+		const FloatV z1 = select(along_z, z0 + to_float(z_nsign), z0);
+
+		const FloatV b_delta = select(
+				along_x,
+				to_float(x_nsign + x_nsign) * x1,
+				select(along_y, to_float(y_nsign + y_nsign) * y1, to_float(z_nsign + z_nsign) * z1)
+		);
+		const FloatV b = (a + fv(1.f)) - b_delta;
+
+		const IntV i1 = select(along_x, i - x_nsign * iv(FNL::PrimeX), i);
+		const IntV j1 = select(along_y, j - y_nsign * iv(FNL::PrimeY), j);
+		const IntV k1 = select(along_z, k - z_nsign * iv(FNL::PrimeZ), k);
+
+		value = value + select(b > fv(0.f), (b * b) * (b * b) * grad_coord(seed, i1, j1, k1, x1, y1, z1), fv(0.f));
+
+		if (l == 1) {
+			break;
+		}
+
+		ax0 = fv(0.5f) - ax0;
+		ay0 = fv(0.5f) - ay0;
+		az0 = fv(0.5f) - az0;
+
+		x0 = to_float(x_nsign) * ax0;
+		y0 = to_float(y_nsign) * ay0;
+		z0 = to_float(z_nsign) * az0;
+
+		a = a + ((fv(0.75f) - ax0) - (ay0 + az0));
+
+		i = i + (shift_right<1>(x_nsign) & iv(FNL::PrimeX));
+		j = j + (shift_right<1>(y_nsign) & iv(FNL::PrimeY));
+		k = k + (shift_right<1>(z_nsign) & iv(FNL::PrimeZ));
+
+		x_nsign = -x_nsign;
+		y_nsign = -y_nsign;
+		z_nsign = -z_nsign;
+
+		seed = ~seed;
+	}
+
+	return value * fv(32.69428253173828125f);
+}
+
+FloatV single_perlin(int seed, FloatV x, FloatV y) {
+	IntV x0 = fast_floor(x);
+	IntV y0 = fast_floor(y);
+
+	const FloatV xd0 = x - to_float(x0);
+	const FloatV yd0 = y - to_float(y0);
+	const FloatV xd1 = xd0 - fv(1.f);
+	const FloatV yd1 = yd0 - fv(1.f);
+
+	const FloatV xs = interp_quintic(xd0);
+	const FloatV ys = interp_quintic(yd0);
+
+	x0 = x0 * iv(FNL::PrimeX);
+	y0 = y0 * iv(FNL::PrimeY);
+	const IntV x1 = x0 + iv(FNL::PrimeX);
+	const IntV y1 = y0 + iv(FNL::PrimeY);
+
+	const FloatV xf0 = lerp(grad_coord(seed, x0, y0, xd0, yd0), grad_coord(seed, x1, y0, xd1, yd0), xs);
+	const FloatV xf1 = lerp(grad_coord(seed, x0, y1, xd0, yd1), grad_coord(seed, x1, y1, xd1, yd1), xs);
+
+	return lerp(xf0, xf1, ys) * fv(1.4247691104677813f);
+}
+
+FloatV single_perlin(int seed, FloatV x, FloatV y, FloatV z) {
+	IntV x0 = fast_floor(x);
+	IntV y0 = fast_floor(y);
+	IntV z0 = fast_floor(z);
+
+	const FloatV xd0 = x - to_float(x0);
+	const FloatV yd0 = y - to_float(y0);
+	const FloatV zd0 = z - to_float(z0);
+	const FloatV xd1 = xd0 - fv(1.f);
+	const FloatV yd1 = yd0 - fv(1.f);
+	const FloatV zd1 = zd0 - fv(1.f);
+
+	const FloatV xs = interp_quintic(xd0);
+	const FloatV ys = interp_quintic(yd0);
+	const FloatV zs = interp_quintic(zd0);
+
+	x0 = x0 * iv(FNL::PrimeX);
+	y0 = y0 * iv(FNL::PrimeY);
+	z0 = z0 * iv(FNL::PrimeZ);
+	const IntV x1 = x0 + iv(FNL::PrimeX);
+	const IntV y1 = y0 + iv(FNL::PrimeY);
+	const IntV z1 = z0 + iv(FNL::PrimeZ);
+
+	const FloatV xf00 =
+			lerp(grad_coord(seed, x0, y0, z0, xd0, yd0, zd0), grad_coord(seed, x1, y0, z0, xd1, yd0, zd0), xs);
+	const FloatV xf10 =
+			lerp(grad_coord(seed, x0, y1, z0, xd0, yd1, zd0), grad_coord(seed, x1, y1, z0, xd1, yd1, zd0), xs);
+	const FloatV xf01 =
+			lerp(grad_coord(seed, x0, y0, z1, xd0, yd0, zd1), grad_coord(seed, x1, y0, z1, xd1, yd0, zd1), xs);
+	const FloatV xf11 =
+			lerp(grad_coord(seed, x0, y1, z1, xd0, yd1, zd1), grad_coord(seed, x1, y1, z1, xd1, yd1, zd1), xs);
+
+	const FloatV yf0 = lerp(xf00, xf10, ys);
+	const FloatV yf1 = lerp(xf01, xf11, ys);
+
+	return lerp(yf0, yf1, zs) * fv(0.964921414852142333984375f);
+}
+
+FloatV single_value(int seed, FloatV x, FloatV y) {
+	IntV x0 = fast_floor(x);
+	IntV y0 = fast_floor(y);
+
+	const FloatV xs = interp_hermite(x - to_float(x0));
+	const FloatV ys = interp_hermite(y - to_float(y0));
+
+	x0 = x0 * iv(FNL::PrimeX);
+	y0 = y0 * iv(FNL::PrimeY);
+	const IntV x1 = x0 + iv(FNL::PrimeX);
+	const IntV y1 = y0 + iv(FNL::PrimeY);
+
+	const FloatV xf0 = lerp(val_coord(seed, x0, y0), val_coord(seed, x1, y0), xs);
+	const FloatV xf1 = lerp(val_coord(seed, x0, y1), val_coord(seed, x1, y1), xs);
+
+	return lerp(xf0, xf1, ys);
+}
+
+FloatV single_value(int seed, FloatV x, FloatV y, FloatV z) {
+	IntV x0 = fast_floor(x);
+	IntV y0 = fast_floor(y);
+	IntV z0 = fast_floor(z);
+
+	const FloatV xs = interp_hermite(x - to_float(x0));
+	const FloatV ys = interp_hermite(y - to_float(y0));
+	const FloatV zs = interp_hermite(z - to_float(z0));
+
+	x0 = x0 * iv(FNL::PrimeX);
+	y0 = y0 * iv(FNL::PrimeY);
+	z0 = z0 * iv(FNL::PrimeZ);
+	const IntV x1 = x0 + iv(FNL::PrimeX);
+	const IntV y1 = y0 + iv(FNL::PrimeY);
+	const IntV z1 = z0 + iv(FNL::PrimeZ);
+
+	const FloatV xf00 = lerp(val_coord(seed, x0, y0, z0), val_coord(seed, x1, y0, z0), xs);
+	const FloatV xf10 = lerp(val_coord(seed, x0, y1, z0), val_coord(seed, x1, y1, z0), xs);
+	const FloatV xf01 = lerp(val_coord(seed, x0, y0, z1), val_coord(seed, x1, y0, z1), xs);
+	const FloatV xf11 = lerp(val_coord(seed, x0, y1, z1), val_coord(seed, x1, y1, z1), xs);
+
+	const FloatV yf0 = lerp(xf00, xf10, ys);
+	const FloatV yf1 = lerp(xf01, xf11, ys);
+
+	return lerp(yf0, yf1, zs);
+}
+
+inline FloatV gen_noise_single(const FNL &fn, int seed, FloatV x, FloatV y) {
+	switch (fn.mNoiseType) {
+		case FNL::NoiseType_OpenSimplex2:
+			return single_simplex(seed, x, y);
+		case FNL::NoiseType_Perlin:
+			return single_perlin(seed, x, y);
+		case FNL::NoiseType_Value:
+			return single_value(seed, x, y);
+		default:
+			// Not vectorized, should have been checked earlier
+			return fv(0.f);
+	}
+}
+
+inline FloatV gen_noise_single(const FNL &fn, int seed, FloatV x, FloatV y, FloatV z) {
+	switch (fn.mNoiseType) {
+		case FNL::NoiseType_OpenSimplex2:
+			return single_open_simplex_2(seed, x, y, z);
+		case FNL::NoiseType_Perlin:
+			return single_perlin(seed, x, y, z);
+		case FNL::NoiseType_Value:
+			return single_value(seed, x, y, z);
+		default:
+			// Not vectorized, should have been checked earlier
+			return fv(0.f);
+	}
+}
+
+// Coordinate transforms
+
+void transform_noise_coordinate(const FNL &fn, FloatV &x, FloatV &y) {
+	x = x * fv(fn.mFrequency);
+	y = y * fv(fn.mFrequency);
+
+	if (fn.mNoiseType == FNL::NoiseType_OpenSimplex2) {
+		const float SQRT3 = (float)1.7320508075688772935274463415059;
+		const float F2 = 0.5f * (SQRT3 - 1);
+		const FloatV t = (x + y) * fv(F2);
+		x = x + t;
+		y = y + t;
+	}
+}
+
+void transform_noise_coordinate(const FNL &fn, FloatV &x, FloatV &y, FloatV &z) {
+	x = x * fv(fn.mFrequency);
+	y = y * fv(fn.mFrequency);
+	z = z * fv(fn.mFrequency);
+
+	switch (fn.mTransformType3D) {
+		case FNL::TransformType3D_ImproveXYPlanes: {
+			const FloatV xy = x + y;
+			const FloatV s2 = xy * fv(-(float)0.211324865405187);
+			z = z * fv((float)0.577350269189626);
+			x = x + (s2 - z);
+			y = y + s2 - z;
+			z = z + xy * fv((float)0.577350269189626);
+		} break;
+
+		case FNL::TransformType3D_ImproveXZPlanes: {
+			const FloatV xz = x + z;
+			const FloatV s2 = xz * fv(-(float)0.211324865405187);
+			y = y * fv((float)0.577350269189626);
+			x = x + (s2 - y);
+			z = z + (s2 - y);
+			y = y + xz * fv((float)0.577350269189626);
+		} break;
+
+		case FNL::TransformType3D_DefaultOpenSimplex2: {
+			const float R3 = (float)(2.0 / 3.0);
+			const FloatV r = (x + y + z) * fv(R3); // Rotation, not skew
+			x = r - x;
+			y = r - y;
+			z = r - z;
+		} break;
+
+		default:
+			break;
+	}
+}
+
+// Fractals
+
+FloatV get_noise(const FNL &fn, FloatV x, FloatV y) {
+	transform_noise_coordinate(fn, x, y);
+
+	switch (fn.mFractalType) {
+		case FNL::FractalType_FBm:
+		case FNL::FractalType_Ridged:
+		case FNL::FractalType_PingPong:
+			break;
+		default:
+			return gen_noise_single(fn, fn.mSeed, x, y);
+	}
+
+	int seed = fn.mSeed;
+	FloatV sum = fv(0.f);
+	// Amplitude may vary per lane when weighted strength is used
+	FloatV amp = fv(fn.mFractalBounding);
+	const FloatV weighted_strength = fv(fn.mWeightedStrength);
+
+	for (int i = 0; i < fn.mOctaves; i++) {
+		const FloatV single = gen_noise_single(fn, seed++, x, y);
+
+		switch (fn.mFractalType) {
+			case FNL::FractalType_FBm:
+				sum = sum + single * amp;
+				amp = amp * lerp(fv(1.f), min(single + fv(1.f), fv(2.f)) * fv(0.5f), weighted_strength);
+				break;
+
+			case FNL::FractalType_Ridged: {
+				const FloatV noise = abs(single);
+				sum = sum + (noise * fv(-2.f) + fv(1.f)) * amp;
+				amp = amp * lerp(fv(1.f), fv(1.f) - noise, weighted_strength);
+			} break;
+
+			case FNL::FractalType_PingPong: {
+				const FloatV noise = ping_pong((single + fv(1.f)) * fv(fn.mPingPongStength));
+				sum = sum + (noise - fv(0.5f)) * fv(2.f) * amp;
+				amp = amp * lerp(fv(1.f), noise, weighted_strength);
+			} break;
+
+			default:
+				break;
+		}
+
+		x = x * fv(fn.mLacunarity);
+		y = y * fv(fn.mLacunarity);
+		amp = amp * fv(fn.mGain);
+	}
+
+	return sum;
+}
+
+FloatV get_noise(const FNL &fn, FloatV x, FloatV y, FloatV z) {
+	transform_noise_coordinate(fn, x, y, z);
+
+	switch (fn.mFractalType) {
+		case FNL::FractalType_FBm:
+		case FNL::FractalType_Ridged:
+		case FNL::FractalType_PingPong:
+			break;
+		default:
+			return gen_noise_single(fn, fn.mSeed, x, y, z);
+	}
+
+	int seed = fn.mSeed;
+	FloatV sum = fv(0.f);
+	// Amplitude may vary per lane when weighted strength is used
+	FloatV amp = fv(fn.mFractalBounding);
+	const FloatV weighted_strength = fv(fn.mWeightedStrength);
+
+	for (int i = 0; i < fn.mOctaves; i++) {
+		const FloatV single = gen_noise_single(fn, seed++, x, y, z);
+
+		switch (fn.mFractalType) {
+			case FNL::FractalType_FBm:
+				sum = sum + single * amp;
+				amp = amp * lerp(fv(1.f), (single + fv(1.f)) * fv(0.5f), weighted_strength);
+				break;
+
+			case FNL::FractalType_Ridged: {
+				const FloatV noise = abs(single);
+				sum = sum + (noise * fv(-2.f) + fv(1.f)) * amp;
+				amp = amp * lerp(fv(1.f), fv(1.f) - noise, weighted_strength);
+			} break;
+
+			case FNL::FractalType_PingPong: {
+				const FloatV noise = ping_pong((single + fv(1.f)) * fv(fn.mPingPongStength));
+				sum = sum + (noise - fv(0.5f)) * fv(2.f) * amp;
+				amp = amp * lerp(fv(1.f), noise, weighted_strength);
+			} break;
+
+			default:
+				break;
+		}
+
+		x = x * fv(fn.mLacunarity);
+		y = y * fv(fn.mLacunarity);
+		z = z * fv(fn.mLacunarity);
+		amp = amp * fv(fn.mGain);
+	}
+
+	return sum;
+}
+
+} // namespace
+
+#endif // ZN_FNL_SIMD
+
+bool is_vectorized(const FNL &fn) {
+#ifdef ZN_FNL_SIMD
+	switch (fn.mNoiseType) {
+		case FNL::NoiseType_OpenSimplex2:
+		case FNL::NoiseType_Perlin:
+		case FNL::NoiseType_Value:
+			return true;
+		default:
+			return false;
+	}
+#else
+	return false;
+#endif
+}
+
+void get_noise_2d_series(
+		const FNL &fn,
+		Span<const float> x_buffer,
+		Span<const float> y_buffer,
+		Span<float> out_values
+) {
+	ZN_ASSERT_RETURN(x_buffer.size() == out_values.size());
+	ZN_ASSERT_RETURN(y_buffer.size() == out_values.size());
+
+#ifdef ZN_FNL_SIMD
+	if (is_vectorized(fn)) {
+		const unsigned int count = out_values.size();
+		unsigned int i = 0;
+
+		for (; i + LANES <= count; i += LANES) {
+			const FloatV v = get_noise(fn, load(&x_buffer[i]), load(&y_buffer[i]));
+			store(&out_values[i], v);
+		}
+
+		if (i < count) {
+			// Remaining points are padded
+			float xs[LANES] = { 0.f };
+			float ys[LANES] = { 0.f };
+			float vs[LANES];
+			const unsigned int remainder = count - i;
+			for (unsigned int j = 0; j < remainder; ++j) {
+				xs[j] = x_buffer[i + j];
+				ys[j] = y_buffer[i + j];
+			}
+			store(vs, get_noise(fn, load(xs), load(ys)));
+			for (unsigned int j = 0; j < remainder; ++j) {
+				out_values[i + j] = vs[j];
+			}
+		}
+		return;
+	}
+#endif
+
+	for (unsigned int i = 0; i < out_values.size(); ++i) {
+		out_values[i] = fn.GetNoise(x_buffer[i], y_buffer[i]);
+	}
+}
+
+void get_noise_3d_series(
+		const FNL &fn,
+		Span<const float> x_buffer,
+		Span<const float> y_buffer,
+		Span<const float> z_buffer,
+		Span<float> out_values
+) {
+	ZN_ASSERT_RETURN(x_buffer.size() == out_values.size());
+	ZN_ASSERT_RETURN(y_buffer.size() == out_values.size());
+	ZN_ASSERT_RETURN(z_buffer.size() == out_values.size());
+
+#ifdef ZN_FNL_SIMD
+	if (is_vectorized(fn)) {
+		const unsigned int count = out_values.size();
+		unsigned int i = 0;
+
+		for (; i + LANES <= count; i += LANES) {
+			const FloatV v = get_noise(fn, load(&x_buffer[i]), load(&y_buffer[i]), load(&z_buffer[i]));
+			store(&out_values[i], v);
+		}
+
+		if (i < count) {
+			// Remaining points are padded
+			float xs[LANES] = { 0.f };
+			float ys[LANES] = { 0.f };
+			float zs[LANES] = { 0.f };
+			float vs[LANES];
+			const unsigned int remainder = count - i;
+			for (unsigned int j = 0; j < remainder; ++j) {
+				xs[j] = x_buffer[i + j];
+				ys[j] = y_buffer[i + j];
+				zs[j] = z_buffer[i + j];
+			}
+			store(vs, get_noise(fn, load(xs), load(ys), load(zs)));
+			for (unsigned int j = 0; j < remainder; ++j) {
+				out_values[i + j] = vs[j];
+			}
+		}
+		return;
+	}
+#endif
+
+	for (unsigned int i = 0; i < out_values.size(); ++i) {
+		out_values[i] = fn.GetNoise(x_buffer[i], y_buffer[i], z_buffer[i]);
+	}
+}
+
+} // namespace zylann::fast_noise_lite_simd
@@ -0,0 +1,40 @@
+#ifndef ZN_FAST_NOISE_LITE_SIMD_H
+#define ZN_FAST_NOISE_LITE_SIMD_H
+
+#include "../../containers/span.h"
+
+namespace fast_noise_lite {
+class FastNoiseLite;
+}
+
+// Evaluates FastNoiseLite on many points at once. Points are processed in groups using SIMD instructions when the
+// target supports them (SSE2 or NEON), so gradient hashing, interpolation and fractal octaves run on several lanes
+// at the same time. Results are the same as `FastNoiseLite::GetNoise` with float coordinates, within float rounding
+// differences (the compiler may contract scalar code into fused multiply-adds on some targets).
+// Noise types that don't have a vectorized implementation fall back to calling `GetNoise` for each point.
+
+namespace zylann::fast_noise_lite_simd {
+
+// Returns true if the current settings of the noise can be evaluated with SIMD instructions on this target.
+// Only OpenSimplex2, Perlin and Value noise have a vectorized implementation. OpenSimplex2S, ValueCubic and Cellular
+// always use the scalar fallback.
+bool is_vectorized(const ::fast_noise_lite::FastNoiseLite &fn);
+
+void get_noise_2d_series(
+		const ::fast_noise_lite::FastNoiseLite &fn,
+		Span<const float> x_buffer,
+		Span<const float> y_buffer,
+		Span<float> out_values
+);
+
+void get_noise_3d_series(
+		const ::fast_noise_lite::FastNoiseLite &fn,
+		Span<const float> x_buffer,
+		Span<const float> y_buffer,
+		Span<const float> z_buffer,
+		Span<float> out_values
+);
+
+} // namespace zylann::fast_noise_lite_simd
+
+#endif // ZN_FAST_NOISE_LITE_SIMD_H
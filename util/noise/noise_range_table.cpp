@@ -0,0 +1,87 @@
+#include "noise_range_table.h"
+
+namespace zylann {
+
+namespace {
+// Measured deviations are multiplied by this, because the worst box is unlikely to be among those we sampled
+const float DEVIATION_MARGIN = 1.5f;
+// The measured range is extended by this fraction of its length on each side
+const float RANGE_MARGIN = 0.1f;
+// Boxes are spread within this distance from the origin
+const float SAMPLING_DOMAIN_RADIUS = 10000.f;
+} // namespace
+
+void NoiseRangeTable::begin_generate() {
+	fill(_max_deviations, 0.f);
+	_range = math::Interval::from_single_value(0.f);
+}
+
+void NoiseRangeTable::add_box_values(unsigned int size_index, Span<const float> values) {
+	ZN_ASSERT_RETURN(size_index < SIZE_COUNT);
+	ZN_ASSERT_RETURN(values.size() > 0);
+
+	const float center_value = values[0];
+	if (size_index == 0) {
+		// All boxes use the same centers
+		_range = math::Interval::from_single_value(center_value);
+	}
+
+	float max_deviation = _max_deviations[size_index];
+	math::Interval range = _range;
+
+	for (const float v : values) {
+		max_deviation = math::max(max_deviation, math::abs(v - center_value));
+		range.add_point(v);
+	}
+
+	_max_deviations[size_index] = max_deviation;
+	_range = range;
+}
+
+void NoiseRangeTable::end_generate() {
+	// Larger boxes can't vary less than smaller ones
+	for (unsigned int i = 1; i < SIZE_COUNT; ++i) {
+		_max_deviations[i] = math::max(_max_deviations[i], _max_deviations[i - 1]);
+	}
+	for (float &d : _max_deviations) {
+		d *= DEVIATION_MARGIN;
+	}
+	const float range_margin = RANGE_MARGIN * _range.length();
+	_range = math::Interval(_range.min - range_margin, _range.max + range_margin);
+}
+
+Vector3f NoiseRangeTable::get_box_center(unsigned int box_index) {
+	// Low-discrepancy sequence, so boxes are evenly spread without being aligned
+	// http://extremelearning.com.au/unreasonable-effectiveness-of-quasirandom-sequences/
+	const double g = 1.22074408460575947536;
+	const double a1 = 1.0 / g;
+	const double a2 = 1.0 / (g * g);
+	const double a3 = 1.0 / (g * g * g);
+	const double i = box_index;
+	const Vector3f t( //
+			math::fract(0.5 + a1 * i),
+			math::fract(0.5 + a2 * i),
+			math::fract(0.5 + a3 * i)
+	);
+	return (t * 2.f - Vector3f(1.f)) * SAMPLING_DOMAIN_RADIUS;
+}
+
+math::Interval NoiseRangeTable::get_range(float center_value, float box_size) const {
+	// The actual value is known to be in range, even if it wasn't observed when measuring
+	const math::Interval range = math::Interval::from_union(_range, math::Interval::from_single_value(center_value));
+
+	unsigned int size_index = 0;
+	float size = 1.f;
+	while (size < box_size) {
+		++size_index;
+		if (size_index == SIZE_COUNT) {
+			return range;
+		}
+		size *= 2.f;
+	}
+
+	const float d = _max_deviations[size_index];
+	return math::Interval(math::max(range.min, center_value - d), math::min(range.max, center_value + d));
+}
+
+} // namespace zylann
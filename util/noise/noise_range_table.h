@@ -0,0 +1,169 @@
+#ifndef ZN_NOISE_RANGE_TABLE_H
+#define ZN_NOISE_RANGE_TABLE_H
+
+#include "../containers/fixed_array.h"
+#include "../containers/span.h"
+#include "../math/funcs.h"
+#include "../math/interval.h"
+#include "../math/vector3f.h"
+
+namespace zylann {
+
+// Empirical bounds of a noise configuration, measured by sampling it within many boxes of various sizes.
+//
+// Interval analysis of noise algorithms has to assume every octave can reach its extremes, so with fractal noise it
+// quickly spans the whole -1..1 range. Measured bounds are much tighter, because octaves rarely add up that way, so
+// more areas can be detected as being fully above or below a threshold (like air or solid blocks).
+// Measures are statistical, so they are widened by a safety margin, but values outside of them can still occur. They
+// should only narrow down other estimations, and only where approximate bounds are acceptable.
+// Generating a table evaluates the noise `SIZE_COUNT * BOX_COUNT` times the number of samples per box.
+class NoiseRangeTable {
+public:
+	// Box sizes are powers of two, starting from 1 unit
+	static const unsigned int SIZE_COUNT = 14;
+	// Samples per axis within each measured box, including its corners
+	static const unsigned int SAMPLES_PER_AXIS_2D = 9;
+	static const unsigned int SAMPLES_PER_AXIS_3D = 5;
+	// Number of boxes measured for each size
+	static const unsigned int BOX_COUNT = 64;
+
+	// Measures a noise function. It is given series of positions and must fill `out_values` with the noise at each of
+	// them. `z` values are zero when measuring 2D noise.
+	// `func(Span<const float> x, Span<const float> y, Span<const float> z, Span<float> out_values)`
+	template <typename F>
+	void generate_2d(F func);
+	template <typename F>
+	void generate_3d(F func);
+
+	// Range of all values observed
+	inline math::Interval get_range() const {
+		return _range;
+	}
+
+	static float get_max_box_size() {
+		return static_cast<float>(1 << (SIZE_COUNT - 1));
+	}
+
+	// Gets bounds of the noise within a box of given size, knowing its value at the center of that box.
+	math::Interval get_range(float center_value, float box_size) const;
+
+	// `noise_func(x, y)` must return the noise at a given position.
+	template <typename F>
+	math::Interval get_range_2d(F noise_func, math::Interval x, math::Interval y) const {
+		const float box_size = math::max(x.length(), y.length());
+		// Also catches infinite intervals
+		if (!(box_size <= get_max_box_size())) {
+			return _range;
+		}
+		const float center_value = noise_func(0.5f * (x.min + x.max), 0.5f * (y.min + y.max));
+		return get_range(center_value, box_size);
+	}
+
+	// `noise_func(x, y, z)` must return the noise at a given position.
+	template <typename F>
+	math::Interval get_range_3d(F noise_func, math::Interval x, math::Interval y, math::Interval z) const {
+		const float box_size = math::max(math::max(x.length(), y.length()), z.length());
+		// Also catches infinite intervals
+		if (!(box_size <= get_max_box_size())) {
+			return _range;
+		}
+		const float center_value = noise_func(0.5f * (x.min + x.max), 0.5f * (y.min + y.max), 0.5f * (z.min + z.max));
+		return get_range(center_value, box_size);
+	}
+
+private:
+	void begin_generate();
+	// `values` contains the value at the center of the box, followed by values at other points of the box.
+	void add_box_values(unsigned int size_index, Span<const float> values);
+	void end_generate();
+
+	static Vector3f get_box_center(unsigned int box_index);
+
+	// Maximum difference found between the value at the center of a box and values in the rest of the box
+	FixedArray<float, SIZE_COUNT> _max_deviations;
+	math::Interval _range;
+};
+
+template <typename F>
+void NoiseRangeTable::generate_2d(F func) {
+	static const unsigned int SAMPLE_COUNT = 1 + SAMPLES_PER_AXIS_2D * SAMPLES_PER_AXIS_2D;
+	FixedArray<float, SAMPLE_COUNT> xs;
+	FixedArray<float, SAMPLE_COUNT> ys;
+	FixedArray<float, SAMPLE_COUNT> zs;
+	FixedArray<float, SAMPLE_COUNT> values;
+	fill(zs, 0.f);
+
+	begin_generate();
+
+	for (unsigned int size_index = 0; size_index < SIZE_COUNT; ++size_index) {
+		const float box_size = static_cast<float>(1 << size_index);
+		const float step = box_size / static_cast<float>(SAMPLES_PER_AXIS_2D - 1);
+
+		for (unsigned int box_index = 0; box_index < BOX_COUNT; ++box_index) {
+			const Vector3f center = get_box_center(box_index);
+			const float min_x = center.x - 0.5f * box_size;
+			const float min_y = center.y - 0.5f * box_size;
+
+			xs[0] = center.x;
+			ys[0] = center.y;
+			unsigned int i = 1;
+			for (unsigned int sy = 0; sy < SAMPLES_PER_AXIS_2D; ++sy) {
+				for (unsigned int sx = 0; sx < SAMPLES_PER_AXIS_2D; ++sx) {
+					xs[i] = min_x + static_cast<float>(sx) * step;
+					ys[i] = min_y + static_cast<float>(sy) * step;
+					++i;
+				}
+			}
+
+			func(to_span_const(xs), to_span_const(ys), to_span_const(zs), to_span(values));
+			add_box_values(size_index, to_span_const(values));
+		}
+	}
+
+	end_generate();
+}
+
+template <typename F>
+void NoiseRangeTable::generate_3d(F func) {
+	static const unsigned int SAMPLE_COUNT = 1 + SAMPLES_PER_AXIS_3D * SAMPLES_PER_AXIS_3D * SAMPLES_PER_AXIS_3D;
+	FixedArray<float, SAMPLE_COUNT> xs;
+	FixedArray<float, SAMPLE_COUNT> ys;
+	FixedArray<float, SAMPLE_COUNT> zs;
+	FixedArray<float, SAMPLE_COUNT> values;
+
+	begin_generate();
+
+	for (unsigned int size_index = 0; size_index < SIZE_COUNT; ++size_index) {
+		const float box_size = static_cast<float>(1 << size_index);
+		const float step = box_size / static_cast<float>(SAMPLES_PER_AXIS_3D - 1);
+
+		for (unsigned int box_index = 0; box_index < BOX_COUNT; ++box_index) {
+			const Vector3f center = get_box_center(box_index);
+			const Vector3f min_pos = center - Vector3f(0.5f * box_size);
+
+			xs[0] = center.x;
+			ys[0] = center.y;
+			zs[0] = center.z;
+			unsigned int i = 1;
+			for (unsigned int sz = 0; sz < SAMPLES_PER_AXIS_3D; ++sz) {
+				for (unsigned int sx = 0; sx < SAMPLES_PER_AXIS_3D; ++sx) {
+					for (unsigned int sy = 0; sy < SAMPLES_PER_AXIS_3D; ++sy) {
+						xs[i] = min_pos.x + static_cast<float>(sx) * step;
+						ys[i] = min_pos.y + static_cast<float>(sy) * step;
+						zs[i] = min_pos.z + static_cast<float>(sz) * step;
+						++i;
+					}
+				}
+			}
+
+			func(to_span_const(xs), to_span_const(ys), to_span_const(zs), to_span(values));
+			add_box_values(size_index, to_span_const(values));
+		}
+	}
+
+	end_generate();
+}
+
+} // namespace zylann
+
+#endif // ZN_NOISE_RANGE_TABLE_H
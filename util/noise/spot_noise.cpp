@@ -0,0 +1,392 @@
+#include "spot_noise.h"
+#include "../containers/std_vector.h"
+#include "../errors.h"
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ZN_SPOT_NOISE_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+// Only on AArch64, because division (`vdivq_f32`) is not available on 32-bit ARM. A reciprocal estimate would not
+// give the same cells as the scalar path at cell boundaries.
+#define ZN_SPOT_NOISE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace zylann::SpotNoise {
+
+namespace {
+
+// Cell coordinates must remain exact when converted to float, and their indices too
+const float MAX_CACHED_CELL_COORDINATE = 1 << 24;
+// Limits memory used by the cache, it is kept per thread
+const unsigned int MAX_CACHED_CELLS = 16384;
+
+struct CellRange {
+	int min;
+	unsigned int size;
+};
+
+// Gets the range of cells containing the given coordinates. NaNs are ignored.
+bool get_cell_range(Span<const float> v, float cell_size, CellRange &out_range) {
+	float min_v = std::numeric_limits<float>::infinity();
+	float max_v = -std::numeric_limits<float>::infinity();
+	for (unsigned int i = 0; i < v.size(); ++i) {
+		const float a = v[i];
+		if (a < min_v) {
+			min_v = a;
+		}
+		if (a > max_v) {
+			max_v = a;
+		}
+	}
+	// Division and rounding are monotonic, so the range can be computed from the extreme values only
+	const float min_cell = Math::floor(min_v / cell_size);
+	const float max_cell = Math::floor(max_v / cell_size);
+	// Also fails if there are only NaNs, or infinities
+	if (!(min_cell >= -MAX_CACHED_CELL_COORDINATE && max_cell <= MAX_CACHED_CELL_COORDINATE)) {
+		return false;
+	}
+	out_range.min = static_cast<int>(min_cell);
+	out_range.size = static_cast<unsigned int>(static_cast<int>(max_cell) - out_range.min + 1);
+	return true;
+}
+
+// Computing spots once per cell is worth it only if positions are more numerous than cells, which is the case when
+// they come from a block, unless cells are very small
+bool should_cache_cells(uint64_t cell_count, unsigned int position_count) {
+	return cell_count <= position_count && cell_count <= MAX_CACHED_CELLS;
+}
+
+#if defined(ZN_SPOT_NOISE_SSE2)
+
+inline __m128 floor_ps(__m128 v) {
+	const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+	return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, v), _mm_set1_ps(1.f)));
+}
+
+// Gets cell coordinates relative to the cached range, as floats. They are clamped to the range, which only matters
+// for NaNs, whose distance to any spot will be NaN anyways.
+inline __m128 get_relative_cell_ps(__m128 v, __m128 cell_size, __m128 min_cell, __m128 max_relative_cell) {
+	const __m128 c = _mm_sub_ps(floor_ps(_mm_div_ps(v, cell_size)), min_cell);
+	return _mm_min_ps(_mm_max_ps(c, _mm_setzero_ps()), max_relative_cell);
+}
+
+#elif defined(ZN_SPOT_NOISE_NEON)
+
+inline float32x4_t floor_f32(float32x4_t v) {
+	const float32x4_t t = vcvtq_f32_s32(vcvtq_s32_f32(v));
+	return vsubq_f32(t, vreinterpretq_f32_u32(vandq_u32(vcgtq_f32(t, v), vreinterpretq_u32_f32(vdupq_n_f32(1.f)))));
+}
+
+inline float32x4_t get_relative_cell_f32(
+		float32x4_t v,
+		float32x4_t cell_size,
+		float32x4_t min_cell,
+		float32x4_t max_relative_cell
+) {
+	const float32x4_t zero = vdupq_n_f32(0.f);
+	const float32x4_t c = vsubq_f32(floor_f32(vdivq_f32(v, cell_size)), min_cell);
+	// Also replaces NaN
+	return vminq_f32(vbslq_f32(vcgtq_f32(c, zero), c, zero), max_relative_cell);
+}
+
+#endif
+
+} // namespace
+
+void spot_noise_2d_series(
+		Span<const float> x,
+		Span<const float> y,
+		Span<const float> spot_size,
+		float cell_size,
+		float jitter,
+		int seed,
+		Span<float> out
+) {
+	ZN_ASSERT_RETURN(x.size() == out.size());
+	ZN_ASSERT_RETURN(y.size() == out.size());
+	ZN_ASSERT_RETURN(spot_size.size() == out.size());
+
+	CellRange rx;
+	CellRange ry;
+	if (!get_cell_range(x, cell_size, rx) || !get_cell_range(y, cell_size, ry) ||
+		!should_cache_cells(static_cast<uint64_t>(rx.size) * ry.size, out.size())) {
+		for (unsigned int i = 0; i < out.size(); ++i) {
+			out[i] = spot_noise_2d(Vector2f(x[i], y[i]), cell_size, spot_size[i], jitter, seed);
+		}
+		return;
+	}
+
+	// Compute spots of all cells the positions are in, the same way as `spot_noise_2d`
+	static thread_local StdVector<float> tls_spots_x;
+	static thread_local StdVector<float> tls_spots_y;
+	tls_spots_x.resize(rx.size * ry.size);
+	tls_spots_y.resize(rx.size * ry.size);
+	{
+		unsigned int cell_index = 0;
+		for (unsigned int cy = 0; cy < ry.size; ++cy) {
+			for (unsigned int cx = 0; cx < rx.size; ++cx) {
+				const ivec2 cell_pos(rx.min + cx, ry.min + cy);
+				const vec2 spot_pos_norm = get_spot_position_2d_norm(cell_pos, jitter, seed);
+				const vec2 spot_pos = (to_vec2f(cell_pos) + spot_pos_norm) * cell_size;
+				tls_spots_x[cell_index] = spot_pos.x;
+				tls_spots_y[cell_index] = spot_pos.y;
+				++cell_index;
+			}
+		}
+	}
+	const float *spots_x = tls_spots_x.data();
+	const float *spots_y = tls_spots_y.data();
+
+	unsigned int i = 0;
+
+	// Lookups can't be vectorized, but computing cell indices and distances can
+#if defined(ZN_SPOT_NOISE_SSE2)
+	const __m128 cell_size_v = _mm_set1_ps(cell_size);
+	const __m128 min_cell_x = _mm_set1_ps(rx.min);
+	const __m128 min_cell_y = _mm_set1_ps(ry.min);
+	const __m128 max_relative_cell_x = _mm_set1_ps(rx.size - 1);
+	const __m128 max_relative_cell_y = _mm_set1_ps(ry.size - 1);
+	const __m128 size_x = _mm_set1_ps(rx.size);
+	const __m128 one = _mm_set1_ps(1.f);
+	alignas(16) int32_t indices[4];
+
+	for (; i + 4 <= out.size(); i += 4) {
+		const __m128 px = _mm_loadu_ps(&x[i]);
+		const __m128 py = _mm_loadu_ps(&y[i]);
+
+		const __m128 cx = get_relative_cell_ps(px, cell_size_v, min_cell_x, max_relative_cell_x);
+		const __m128 cy = get_relative_cell_ps(py, cell_size_v, min_cell_y, max_relative_cell_y);
+		_mm_store_si128(
+				reinterpret_cast<__m128i *>(indices), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(cy, size_x), cx))
+		);
+
+		const __m128 sx = _mm_setr_ps(
+				spots_x[indices[0]], spots_x[indices[1]], spots_x[indices[2]], spots_x[indices[3]]
+		);
+		const __m128 sy = _mm_setr_ps(
+				spots_y[indices[0]], spots_y[indices[1]], spots_y[indices[2]], spots_y[indices[3]]
+		);
+
+		const __m128 dx = _mm_sub_ps(px, sx);
+		const __m128 dy = _mm_sub_ps(py, sy);
+		const __m128 ds = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+		const __m128 r = _mm_loadu_ps(&spot_size[i]);
+
+		_mm_storeu_ps(&out[i], _mm_and_ps(_mm_cmplt_ps(ds, _mm_mul_ps(r, r)), one));
+	}
+
+#elif defined(ZN_SPOT_NOISE_NEON)
+	const float32x4_t cell_size_v = vdupq_n_f32(cell_size);
+	const float32x4_t min_cell_x = vdupq_n_f32(rx.min);
+	const float32x4_t min_cell_y = vdupq_n_f32(ry.min);
+	const float32x4_t max_relative_cell_x = vdupq_n_f32(rx.size - 1);
+	const float32x4_t max_relative_cell_y = vdupq_n_f32(ry.size - 1);
+	const float32x4_t size_x = vdupq_n_f32(rx.size);
+	const uint32x4_t one = vreinterpretq_u32_f32(vdupq_n_f32(1.f));
+	alignas(16) uint32_t indices[4];
+
+	for (; i + 4 <= out.size(); i += 4) {
+		const float32x4_t px = vld1q_f32(&x[i]);
+		const float32x4_t py = vld1q_f32(&y[i]);
+
+		const float32x4_t cx = get_relative_cell_f32(px, cell_size_v, min_cell_x, max_relative_cell_x);
+		const float32x4_t cy = get_relative_cell_f32(py, cell_size_v, min_cell_y, max_relative_cell_y);
+		// Not using fused multiply-add, to get the same results as the scalar version
+		vst1q_u32(indices, vcvtq_u32_f32(vaddq_f32(vmulq_f32(cy, size_x), cx)));
+
+		const float sx_array[4] = {
+			spots_x[indices[0]], spots_x[indices[1]], spots_x[indices[2]], spots_x[indices[3]]
+		};
+		const float sy_array[4] = {
+			spots_y[indices[0]], spots_y[indices[1]], spots_y[indices[2]], spots_y[indices[3]]
+		};
+
+		const float32x4_t dx = vsubq_f32(px, vld1q_f32(sx_array));
+		const float32x4_t dy = vsubq_f32(py, vld1q_f32(sy_array));
+		const float32x4_t ds = vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy));
+		const float32x4_t r = vld1q_f32(&spot_size[i]);
+
+		vst1q_f32(&out[i], vreinterpretq_f32_u32(vandq_u32(vcltq_f32(ds, vmulq_f32(r, r)), one)));
+	}
+#endif
+
+	for (; i < out.size(); ++i) {
+		const float cx = Math::floor(x[i] / cell_size) - rx.min;
+		const float cy = Math::floor(y[i] / cell_size) - ry.min;
+		if (!(cx >= 0.f && cy >= 0.f)) {
+			// NaN
+			out[i] = spot_noise_2d(Vector2f(x[i], y[i]), cell_size, spot_size[i], jitter, seed);
+			continue;
+		}
+		const unsigned int cell_index = static_cast<unsigned int>(cx) + static_cast<unsigned int>(cy) * rx.size;
+		const float ds = math::distance_squared(vec2(spots_x[cell_index], spots_y[cell_index]), vec2(x[i], y[i]));
+		out[i] = float(ds < spot_size[i] * spot_size[i]);
+	}
+}
+
+void spot_noise_3d_series(
+		Span<const float> x,
+		Span<const float> y,
+		Span<const float> z,
+		Span<const float> spot_size,
+		float cell_size,
+		float jitter,
+		int seed,
+		Span<float> out
+) {
+	ZN_ASSERT_RETURN(x.size() == out.size());
+	ZN_ASSERT_RETURN(y.size() == out.size());
+	ZN_ASSERT_RETURN(z.size() == out.size());
+	ZN_ASSERT_RETURN(spot_size.size() == out.size());
+
+	CellRange rx;
+	CellRange ry;
+	CellRange rz;
+	if (!get_cell_range(x, cell_size, rx) || !get_cell_range(y, cell_size, ry) ||
+		!get_cell_range(z, cell_size, rz) ||
+		!should_cache_cells(static_cast<uint64_t>(rx.size) * ry.size * rz.size, out.size())) {
+		for (unsigned int i = 0; i < out.size(); ++i) {
+			out[i] = spot_noise_3d(Vector3f(x[i], y[i], z[i]), cell_size, spot_size[i], jitter, seed);
+		}
+		return;
+	}
+
+	// Compute spots of all cells the positions are in, the same way as `spot_noise_3d`
+	static thread_local StdVector<float> tls_spots_x;
+	static thread_local StdVector<float> tls_spots_y;
+	static thread_local StdVector<float> tls_spots_z;
+	const unsigned int cell_count = rx.size * ry.size * rz.size;
+	tls_spots_x.resize(cell_count);
+	tls_spots_y.resize(cell_count);
+	tls_spots_z.resize(cell_count);
+	{
+		unsigned int cell_index = 0;
+		for (unsigned int cz = 0; cz < rz.size; ++cz) {
+			for (unsigned int cy = 0; cy < ry.size; ++cy) {
+				for (unsigned int cx = 0; cx < rx.size; ++cx) {
+					const ivec3 cell_pos(rx.min + cx, ry.min + cy, rz.min + cz);
+					const vec3 spot_pos_norm = get_spot_position_3d_norm(cell_pos, jitter, seed);
+					const vec3 spot_pos = (to_vec3f(cell_pos) + spot_pos_norm) * cell_size;
+					tls_spots_x[cell_index] = spot_pos.x;
+					tls_spots_y[cell_index] = spot_pos.y;
+					tls_spots_z[cell_index] = spot_pos.z;
+					++cell_index;
+				}
+			}
+		}
+	}
+	const float *spots_x = tls_spots_x.data();
+	const float *spots_y = tls_spots_y.data();
+	const float *spots_z = tls_spots_z.data();
+
+	unsigned int i = 0;
+
+#if defined(ZN_SPOT_NOISE_SSE2)
+	const __m128 cell_size_v = _mm_set1_ps(cell_size);
+	const __m128 min_cell_x = _mm_set1_ps(rx.min);
+	const __m128 min_cell_y = _mm_set1_ps(ry.min);
+	const __m128 min_cell_z = _mm_set1_ps(rz.min);
+	const __m128 max_relative_cell_x = _mm_set1_ps(rx.size - 1);
+	const __m128 max_relative_cell_y = _mm_set1_ps(ry.size - 1);
+	const __m128 max_relative_cell_z = _mm_set1_ps(rz.size - 1);
+	const __m128 size_x = _mm_set1_ps(rx.size);
+	const __m128 size_y = _mm_set1_ps(ry.size);
+	const __m128 one = _mm_set1_ps(1.f);
+	alignas(16) int32_t indices[4];
+
+	for (; i + 4 <= out.size(); i += 4) {
+		const __m128 px = _mm_loadu_ps(&x[i]);
+		const __m128 py = _mm_loadu_ps(&y[i]);
+		const __m128 pz = _mm_loadu_ps(&z[i]);
+
+		const __m128 cx = get_relative_cell_ps(px, cell_size_v, min_cell_x, max_relative_cell_x);
+		const __m128 cy = get_relative_cell_ps(py, cell_size_v, min_cell_y, max_relative_cell_y);
+		const __m128 cz = get_relative_cell_ps(pz, cell_size_v, min_cell_z, max_relative_cell_z);
+		const __m128 fi = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(cz, size_y), cy), size_x), cx);
+		_mm_store_si128(reinterpret_cast<__m128i *>(indices), _mm_cvttps_epi32(fi));
+
+		const __m128 sx = _mm_setr_ps(
+				spots_x[indices[0]], spots_x[indices[1]], spots_x[indices[2]], spots_x[indices[3]]
+		);
+		const __m128 sy = _mm_setr_ps(
+				spots_y[indices[0]], spots_y[indices[1]], spots_y[indices[2]], spots_y[indices[3]]
+		);
+		const __m128 sz = _mm_setr_ps(
+				spots_z[indices[0]], spots_z[indices[1]], spots_z[indices[2]], spots_z[indices[3]]
+		);
+
+		const __m128 dx = _mm_sub_ps(px, sx);
+		const __m128 dy = _mm_sub_ps(py, sy);
+		const __m128 dz = _mm_sub_ps(pz, sz);
+		const __m128 ds = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		const __m128 r = _mm_loadu_ps(&spot_size[i]);
+
+		_mm_storeu_ps(&out[i], _mm_and_ps(_mm_cmplt_ps(ds, _mm_mul_ps(r, r)), one));
+	}
+
+#elif defined(ZN_SPOT_NOISE_NEON)
+	const float32x4_t cell_size_v = vdupq_n_f32(cell_size);
+	const float32x4_t min_cell_x = vdupq_n_f32(rx.min);
+	const float32x4_t min_cell_y = vdupq_n_f32(ry.min);
+	const float32x4_t min_cell_z = vdupq_n_f32(rz.min);
+	const float32x4_t max_relative_cell_x = vdupq_n_f32(rx.size - 1);
+	const float32x4_t max_relative_cell_y = vdupq_n_f32(ry.size - 1);
+	const float32x4_t max_relative_cell_z = vdupq_n_f32(rz.size - 1);
+	const float32x4_t size_x = vdupq_n_f32(rx.size);
+	const float32x4_t size_y = vdupq_n_f32(ry.size);
+	const uint32x4_t one = vreinterpretq_u32_f32(vdupq_n_f32(1.f));
+	alignas(16) uint32_t indices[4];
+
+	for (; i + 4 <= out.size(); i += 4) {
+		const float32x4_t px = vld1q_f32(&x[i]);
+		const float32x4_t py = vld1q_f32(&y[i]);
+		const float32x4_t pz = vld1q_f32(&z[i]);
+
+		const float32x4_t cx = get_relative_cell_f32(px, cell_size_v, min_cell_x, max_relative_cell_x);
+		const float32x4_t cy = get_relative_cell_f32(py, cell_size_v, min_cell_y, max_relative_cell_y);
+		const float32x4_t cz = get_relative_cell_f32(pz, cell_size_v, min_cell_z, max_relative_cell_z);
+		// Not using fused multiply-add, to get the same results as the scalar version
+		const float32x4_t fi = vaddq_f32(vmulq_f32(vaddq_f32(vmulq_f32(cz, size_y), cy), size_x), cx);
+		vst1q_u32(indices, vcvtq_u32_f32(fi));
+
+		const float sx_array[4] = {
+			spots_x[indices[0]], spots_x[indices[1]], spots_x[indices[2]], spots_x[indices[3]]
+		};
+		const float sy_array[4] = {
+			spots_y[indices[0]], spots_y[indices[1]], spots_y[indices[2]], spots_y[indices[3]]
+		};
+		const float sz_array[4] = {
+			spots_z[indices[0]], spots_z[indices[1]], spots_z[indices[2]], spots_z[indices[3]]
+		};
+
+		const float32x4_t dx = vsubq_f32(px, vld1q_f32(sx_array));
+		const float32x4_t dy = vsubq_f32(py, vld1q_f32(sy_array));
+		const float32x4_t dz = vsubq_f32(pz, vld1q_f32(sz_array));
+		const float32x4_t ds = vaddq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy)), vmulq_f32(dz, dz));
+		const float32x4_t r = vld1q_f32(&spot_size[i]);
+
+		vst1q_f32(&out[i], vreinterpretq_f32_u32(vandq_u32(vcltq_f32(ds, vmulq_f32(r, r)), one)));
+	}
+#endif
+
+	for (; i < out.size(); ++i) {
+		const float cx = Math::floor(x[i] / cell_size) - rx.min;
+		const float cy = Math::floor(y[i] / cell_size) - ry.min;
+		const float cz = Math::floor(z[i] / cell_size) - rz.min;
+		if (!(cx >= 0.f && cy >= 0.f && cz >= 0.f)) {
+			// NaN
+			out[i] = spot_noise_3d(Vector3f(x[i], y[i], z[i]), cell_size, spot_size[i], jitter, seed);
+			continue;
+		}
+		const unsigned int cell_index = static_cast<unsigned int>(cx) +
+				(static_cast<unsigned int>(cy) + static_cast<unsigned int>(cz) * ry.size) * rx.size;
+		const float ds = math::distance_squared(
+				vec3(spots_x[cell_index], spots_y[cell_index], spots_z[cell_index]), vec3(x[i], y[i], z[i])
+		);
+		out[i] = float(ds < spot_size[i] * spot_size[i]);
+	}
+}
+
+} // namespace zylann::SpotNoise
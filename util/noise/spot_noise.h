@@ -1,6 +1,7 @@
 #ifndef ZN_SPOT_NOISE_H
 #define ZN_SPOT_NOISE_H
 
+#include "../containers/span.h"
 #include "../math/conv.h"
 #include "../math/interval.h"
 
@@ -102,43 +103,35 @@ inline float spot_noise_3d(vec3 pos, float cell_size, float spot_size, float jit
 	return float(ds < spot_size * spot_size);
 }
 
-inline bool box_intersects(Vector2f a_min, Vector2f a_max, Vector2f b_min, Vector2f b_max) {
-	if (a_min.x >= b_max.x) {
-		return false;
-	}
-	if (a_min.y >= b_max.y) {
-		return false;
-	}
-	if (b_min.x >= a_max.x) {
-		return false;
-	}
-	if (b_min.y >= a_max.y) {
-		return false;
-	}
-	return true;
-}
+// Evaluates spot noise for a series of positions. Gives the same results as `spot_noise_2d`, but when positions are
+// grouped in a small area (such as a block), spots are computed once per cell instead of once per position, and
+// distances are computed with SIMD when available.
+void spot_noise_2d_series(
+		Span<const float> x,
+		Span<const float> y,
+		Span<const float> spot_size,
+		float cell_size,
+		float jitter,
+		int seed,
+		Span<float> out
+);
+
+// 3D version of `spot_noise_2d_series`, giving the same results as `spot_noise_3d`.
+void spot_noise_3d_series(
+		Span<const float> x,
+		Span<const float> y,
+		Span<const float> z,
+		Span<const float> spot_size,
+		float cell_size,
+		float jitter,
+		int seed,
+		Span<float> out
+);
 
-inline bool box_intersects(Vector3f a_min, Vector3f a_max, Vector3f b_min, Vector3f b_max) {
-	if (a_min.x >= b_max.x) {
-		return false;
-	}
-	if (a_min.y >= b_max.y) {
-		return false;
-	}
-	if (a_min.z >= b_max.z) {
-		return false;
-	}
-	if (b_min.x >= a_max.x) {
-		return false;
-	}
-	if (b_min.y >= a_max.y) {
-		return false;
-	}
-	if (b_min.z >= a_max.z) {
-		return false;
-	}
-	return true;
-}
+// Range analysis checks spots of every cell the area touches, as long as there aren't too many of them. It is exact
+// when the area is entirely outside spots, or entirely inside one spot.
+// Distances are computed the same way as when sampling, and rounding is monotonic, so the closest and farthest points
+// of the area can be compared to the spot radius without needing a margin.
 
 inline math::Interval spot_noise_2d_range(
 		math::Interval2 pos,
@@ -147,43 +140,68 @@ inline math::Interval spot_noise_2d_range(
 		float jitter,
 		int seed
 ) {
+	// Only the squared radius is used, so its sign doesn't matter
+	const math::Interval spot_size_sq = math::squared(spot_size);
+	if (spot_size_sq.max <= 0.f) {
+		// Spots are empty
+		return math::Interval::from_single_value(0);
+	}
+
 	vec2 min_cell_origin_norm = math::floor(vec2(pos.x.min, pos.y.min) / cell_size);
 	vec2 max_cell_origin_norm = math::floor(vec2(pos.x.max, pos.y.max) / cell_size);
 
 	ivec2 min_cell_origin_norm_i = to_vec2i(min_cell_origin_norm);
 	ivec2 max_cell_origin_norm_i = to_vec2i(max_cell_origin_norm);
 
-	if (Vector2iUtil::get_area(max_cell_origin_norm_i - min_cell_origin_norm_i + ivec2(1, 1)) > 10) {
+	if (Vector2iUtil::get_area(max_cell_origin_norm_i - min_cell_origin_norm_i + ivec2(1, 1)) > 64) {
 		// Don't bother checking too many cells, assume we'll intersect a spot.
 		return math::Interval(0, 1);
 	}
 
 	vec2 box_size(pos.x.max - pos.x.min, pos.y.max - pos.y.min);
 	if (math::min(box_size.x, box_size.y) >= 2.f * cell_size) {
-		// We will intersect a spot.
+		// We will intersect a spot, and positions outside of it.
 		return math::Interval(0, 1);
 	}
 
+	const vec2 box_min(pos.x.min, pos.y.min);
+	const vec2 box_max(pos.x.max, pos.y.max);
+
+	// When the area spans several cells, positions of each cell only test the spot of their cell, so finding whether
+	// the whole area is inside spots would require to clip the area for each cell. We don't do that.
+	const bool single_cell = min_cell_origin_norm_i == max_cell_origin_norm_i;
+	bool can_be_inside = false;
+	bool can_be_outside = !single_cell;
+
 	// Check all cells intersecting with the area, and find if any spot intersects with it
 	for (int yi = min_cell_origin_norm_i.y; yi <= max_cell_origin_norm_i.y; ++yi) {
 		for (int xi = min_cell_origin_norm_i.x; xi <= max_cell_origin_norm_i.x; ++xi) {
-			int h = hash2(ivec2(xi, yi), seed);
-			vec2 h2 = hash_to_vec2(h);
-			vec2 spot_pos_norm = math::lerp(vec2(0.5), h2, jitter);
-			vec2 spot_pos = cell_size * (vec2(xi, yi) + spot_pos_norm);
-
-			if (box_intersects(
-						spot_pos - vec2(spot_size.max),
-						spot_pos + vec2(spot_size.max),
-						vec2(pos.x.min, pos.y.min),
-						vec2(pos.x.max, pos.y.max)
-				)) {
-				return math::Interval(0, 1);
+			const vec2 spot_pos_norm = get_spot_position_2d_norm(ivec2(xi, yi), jitter, seed);
+			const vec2 spot_pos = (vec2(xi, yi) + spot_pos_norm) * cell_size;
+
+			const vec2 closest(
+					math::clamp(spot_pos.x, box_min.x, box_max.x), math::clamp(spot_pos.y, box_min.y, box_max.y)
+			);
+			if (math::distance_squared(spot_pos, closest) < spot_size_sq.max) {
+				can_be_inside = true;
+			}
+
+			if (single_cell) {
+				const vec2 farthest(
+						math::max(Math::abs(box_min.x - spot_pos.x), Math::abs(box_max.x - spot_pos.x)),
+						math::max(Math::abs(box_min.y - spot_pos.y), Math::abs(box_max.y - spot_pos.y))
+				);
+				if (!(math::length_squared(farthest) < spot_size_sq.min)) {
+					can_be_outside = true;
+				}
 			}
 		}
 	}
 
-	return math::Interval::from_single_value(0);
+	if (can_be_inside && can_be_outside) {
+		return math::Interval(0, 1);
+	}
+	return math::Interval::from_single_value(can_be_inside ? 1 : 0);
 }
 
 inline math::Interval spot_noise_3d_range(
@@ -193,45 +211,69 @@ inline math::Interval spot_noise_3d_range(
 		float jitter,
 		int seed
 ) {
+	const math::Interval spot_size_sq = math::squared(spot_size);
+	if (spot_size_sq.max <= 0.f) {
+		return math::Interval::from_single_value(0);
+	}
+
 	vec3 min_cell_origin_norm = math::floor(vec3(pos.x.min, pos.y.min, pos.z.min) / cell_size);
 	vec3 max_cell_origin_norm = math::floor(vec3(pos.x.max, pos.y.max, pos.z.max) / cell_size);
 
 	ivec3 min_cell_origin_norm_i = to_vec3i(min_cell_origin_norm);
 	ivec3 max_cell_origin_norm_i = to_vec3i(max_cell_origin_norm);
 
-	if (Vector3iUtil::get_volume(max_cell_origin_norm_i - min_cell_origin_norm_i + ivec3(1, 1, 1)) > 30) {
+	if (Vector3iUtil::get_volume(max_cell_origin_norm_i - min_cell_origin_norm_i + ivec3(1, 1, 1)) > 256) {
 		// Don't bother checking too many cells, assume we'll intersect a spot.
 		return math::Interval(0, 1);
 	}
 
 	vec3 box_size(pos.x.max - pos.x.min, pos.y.max - pos.y.min, pos.z.max - pos.z.min);
 	if (math::min(box_size.x, math::min(box_size.y, box_size.z)) >= 2.f * cell_size) {
-		// We will intersect a spot.
+		// We will intersect a spot, and positions outside of it.
 		return math::Interval(0, 1);
 	}
 
+	const vec3 box_min(pos.x.min, pos.y.min, pos.z.min);
+	const vec3 box_max(pos.x.max, pos.y.max, pos.z.max);
+
+	const bool single_cell = min_cell_origin_norm_i == max_cell_origin_norm_i;
+	bool can_be_inside = false;
+	bool can_be_outside = !single_cell;
+
 	// Check all cells intersecting with the area, and find if any spot intersects with it
 	for (int zi = min_cell_origin_norm_i.z; zi <= max_cell_origin_norm_i.z; ++zi) {
 		for (int yi = min_cell_origin_norm_i.y; yi <= max_cell_origin_norm_i.y; ++yi) {
 			for (int xi = min_cell_origin_norm_i.x; xi <= max_cell_origin_norm_i.x; ++xi) {
-				int h = hash3(ivec3(xi, yi, zi), seed);
-				vec3 h3 = hash_to_vec3(h);
-				vec3 spot_pos_norm = math::lerp(vec3(0.5), h3, jitter);
-				vec3 spot_pos = cell_size * (vec3(xi, yi, zi) + spot_pos_norm);
-
-				if (box_intersects(
-							spot_pos - vec3(spot_size.max),
-							spot_pos + vec3(spot_size.max),
-							vec3(pos.x.min, pos.y.min, pos.z.min),
-							vec3(pos.x.max, pos.y.max, pos.z.max)
-					)) {
-					return math::Interval(0, 1);
+				const vec3 spot_pos_norm = get_spot_position_3d_norm(ivec3(xi, yi, zi), jitter, seed);
+				const vec3 spot_pos = (vec3(xi, yi, zi) + spot_pos_norm) * cell_size;
+
+				const vec3 closest(
+						math::clamp(spot_pos.x, box_min.x, box_max.x),
+						math::clamp(spot_pos.y, box_min.y, box_max.y),
+						math::clamp(spot_pos.z, box_min.z, box_max.z)
+				);
+				if (math::distance_squared(spot_pos, closest) < spot_size_sq.max) {
+					can_be_inside = true;
+				}
+
+				if (single_cell) {
+					const vec3 farthest(
+							math::max(Math::abs(box_min.x - spot_pos.x), Math::abs(box_max.x - spot_pos.x)),
+							math::max(Math::abs(box_min.y - spot_pos.y), Math::abs(box_max.y - spot_pos.y)),
+							math::max(Math::abs(box_min.z - spot_pos.z), Math::abs(box_max.z - spot_pos.z))
+					);
+					if (!(math::length_squared(farthest) < spot_size_sq.min)) {
+						can_be_outside = true;
+					}
 				}
 			}
 		}
 	}
 
-	return math::Interval::from_single_value(0);
+	if (can_be_inside && can_be_outside) {
+		return math::Interval(0, 1);
+	}
+	return math::Interval::from_single_value(can_be_inside ? 1 : 0);
 }
 
 } // namespace zylann::SpotNoise
@@ -587,6 +587,77 @@ void find_variables(const Node &node, StdVector<std::string_view> &variables) {
 	}
 }
 
+inline bool is_number(const Node &node) {
+	return node.type == Node::NUMBER;
+}
+
+inline float get_number(const Node &node) {
+	return static_cast<const NumberNode &>(node).value;
+}
+
+// Simplifies an operator having exactly one constant operand, whose other operand was already simplified.
+// Operations with no effect are removed (like `x * 1` or `x + 0`), and constants of nested additions or
+// multiplications are merged (like `2 * x * 3`), which evaluating constant sub-trees alone doesn't catch.
+// Returns true if the node was changed into a constant.
+bool simplify_operator_with_constant(UniquePtr<Node> &node, float &out_number) {
+	OperatorNode &onode = static_cast<OperatorNode &>(*node);
+	const bool constant0 = is_number(*onode.n0);
+	UniquePtr<Node> &operand = constant0 ? onode.n1 : onode.n0;
+	const float c = get_number(constant0 ? *onode.n0 : *onode.n1);
+
+	switch (onode.op) {
+		case OperatorNode::ADD:
+		case OperatorNode::MULTIPLY: {
+			const float identity = onode.op == OperatorNode::ADD ? 0.f : 1.f;
+			if (c == identity) {
+				node = std::move(operand);
+				return false;
+			}
+			if (operand->type != Node::OPERATOR) {
+				return false;
+			}
+			OperatorNode &inner = static_cast<OperatorNode &>(*operand);
+			if (inner.op != onode.op || !(is_number(*inner.n0) || is_number(*inner.n1))) {
+				return false;
+			}
+			// Fold our constant into the one of the nested operation, and replace ourselves with it
+			NumberNode &inner_number = static_cast<NumberNode &>(is_number(*inner.n0) ? *inner.n0 : *inner.n1);
+			inner_number.value = onode.op == OperatorNode::ADD ? inner_number.value + c : inner_number.value * c;
+			node = std::move(operand);
+			// The merged constant could now have no effect
+			return simplify_operator_with_constant(node, out_number);
+		}
+
+		case OperatorNode::SUBTRACT:
+			if (!constant0 && c == 0.f) {
+				node = std::move(operand);
+			}
+			return false;
+
+		case OperatorNode::DIVIDE:
+			if (!constant0 && c == 1.f) {
+				node = std::move(operand);
+			}
+			return false;
+
+		case OperatorNode::POWER:
+			if (!constant0) {
+				if (c == 1.f) {
+					node = std::move(operand);
+				} else if (c == 0.f) {
+					out_number = 1.f;
+					node = make_unique_instance<NumberNode>(out_number);
+					return true;
+				}
+			}
+			return false;
+
+		default:
+			ZN_CRASH();
+			return false;
+	}
+}
+
 // Returns true if the passed node is constant (or gets changed into a constant).
 // `out_number` is the value of the node if it is constant.
 bool precompute_constants(UniquePtr<Node> &node, float &out_number, Span<const Function> functions) {
@@ -632,6 +703,9 @@ bool precompute_constants(UniquePtr<Node> &node, float &out_number, Span<const F
 					node = make_unique_instance<NumberNode>(out_number);
 					return true;
 				}
+				if (constant0 || constant1) {
+					return simplify_operator_with_constant(node, out_number);
+				}
 				// TODO Unary operators
 			}
 			return false;
@@ -0,0 +1,67 @@
+#include "epoch_reclaimer.h"
+#include "../containers/fixed_array.h"
+#include <atomic>
+
+namespace zylann::epoch_reclaimer {
+
+namespace {
+
+// Maximum amount of readers at the same time. If more threads try to read, they will spin until a slot frees up.
+static const unsigned int SLOT_COUNT = 64;
+
+struct alignas(64) Slot {
+	// Epoch at which the reader entered, or 0 if the slot is free
+	std::atomic_uint64_t epoch = { 0 };
+};
+
+FixedArray<Slot, SLOT_COUNT> g_slots;
+// Starts at 1 because 0 means a slot is free
+std::atomic_uint64_t g_epoch = { 1 };
+std::atomic_uint32_t g_next_slot_hint = { 0 };
+
+unsigned int get_slot_hint() {
+	// Each thread starts looking from a different slot, so it most likely finds it free and in its own cache
+	static thread_local unsigned int tls_slot_hint = g_next_slot_hint.fetch_add(1) % SLOT_COUNT;
+	return tls_slot_hint;
+}
+
+} // namespace
+
+ReadScope::ReadScope() {
+	const unsigned int hint = get_slot_hint();
+	// If the epoch advances between this load and the slot being set, the reader is considered older than it is,
+	// which only delays reclamation
+	const uint64_t epoch = g_epoch.load();
+
+	unsigned int i = hint;
+	while (true) {
+		uint64_t expected = 0;
+		// Sequentially-consistent, so published data loaded afterwards can't be older than the announced epoch
+		if (g_slots[i].epoch.compare_exchange_strong(expected, epoch)) {
+			_slot_index = i;
+			return;
+		}
+		i = (i + 1) % SLOT_COUNT;
+	}
+}
+
+ReadScope::~ReadScope() {
+	g_slots[_slot_index].epoch.store(0, std::memory_order_release);
+}
+
+uint64_t retire() {
+	// Readers entering from now on will have a greater epoch, and will only see data published before this call
+	return g_epoch.fetch_add(1);
+}
+
+bool can_reclaim(uint64_t retire_tag) {
+	for (const Slot &slot : g_slots) {
+		const uint64_t epoch = slot.epoch.load();
+		if (epoch != 0 && epoch <= retire_tag) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace zylann::epoch_reclaimer
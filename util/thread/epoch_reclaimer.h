@@ -0,0 +1,39 @@
+#ifndef ZN_EPOCH_RECLAIMER_H
+#define ZN_EPOCH_RECLAIMER_H
+
+#include <cstdint>
+
+namespace zylann {
+
+// Epoch-based reclamation, allowing readers to access shared data structures without locking, while writers replace
+// them (RCU-style). Writers publish a new version, then retire the old one with a tag obtained from `retire`. The old
+// version can be freed once `can_reclaim` returns true for that tag, which means no reader can still be using it.
+//
+// Readers announce themselves in slots spread over separate cache lines, so concurrent readers don't write to the same
+// memory like they would with a shared lock counter.
+namespace epoch_reclaimer {
+
+// Must be alive while the reader accesses published data. Should be held for short periods of time only, because it
+// prevents retired data from being freed.
+class ReadScope {
+public:
+	ReadScope();
+	~ReadScope();
+
+	ReadScope(const ReadScope &) = delete;
+	ReadScope &operator=(const ReadScope &) = delete;
+
+private:
+	unsigned int _slot_index;
+};
+
+// Must be called after the old version of some data has been unpublished. Returns the tag to pass to `can_reclaim`.
+uint64_t retire();
+
+// Tests if no reader can still be accessing data that was retired with the given tag.
+bool can_reclaim(uint64_t retire_tag);
+
+} // namespace epoch_reclaimer
+} // namespace zylann
+
+#endif // ZN_EPOCH_RECLAIMER_H
@@ -4,30 +4,277 @@
 
 namespace zylann {
 
+namespace {
+
+inline unsigned int get_cell_hash(Vector3i cell_position) {
+	return (static_cast<uint32_t>(cell_position.x) * 73856093u) ^
+			(static_cast<uint32_t>(cell_position.y) * 19349663u) ^
+			(static_cast<uint32_t>(cell_position.z) * 83492791u);
+}
+
+} // namespace
+
 SpatialLock3D::SpatialLock3D() {
-	_boxes.reserve(8);
+	for (Shard &shard : _shards) {
+		shard.boxes.reserve(4);
+	}
 }
 
-void SpatialLock3D::remove_box(const BoxBounds3i &box, Mode mode) {
+uint32_t SpatialLock3D::get_shard_mask(const BoxBounds3i &box) {
+	const uint32_t all_shards = SHARD_COUNT == 32 ? 0xffffffff : ((1u << SHARD_COUNT) - 1);
+
+	// `BoxBounds3i::intersects` considers touching boxes as intersecting, so the max position is included
+	const Vector3i min_cell = box.min_pos >> CELL_SIZE_PO2;
+	const Vector3i max_cell = box.max_pos >> CELL_SIZE_PO2;
+
+	const int64_t size_x = int64_t(max_cell.x) - min_cell.x + 1;
+	const int64_t size_y = int64_t(max_cell.y) - min_cell.y + 1;
+	const int64_t size_z = int64_t(max_cell.z) - min_cell.z + 1;
+
+	if (size_x > SHARD_COUNT || size_y > SHARD_COUNT || size_z > SHARD_COUNT ||
+		size_x * size_y * size_z > SHARD_COUNT) {
+		// Large box, it would cover most shards anyways
+		return all_shards;
+	}
+
+	uint32_t mask = 0;
+	Vector3i cell;
+	for (cell.z = min_cell.z; cell.z <= max_cell.z; ++cell.z) {
+		for (cell.x = min_cell.x; cell.x <= max_cell.x; ++cell.x) {
+			for (cell.y = min_cell.y; cell.y <= max_cell.y; ++cell.y) {
+				mask |= 1u << (get_cell_hash(cell) % SHARD_COUNT);
+			}
+		}
+	}
+	return mask;
+}
+
+void SpatialLock3D::lock_shards(uint32_t shard_mask) {
+	for (unsigned int i = 0; i < SHARD_COUNT; ++i) {
+		if ((shard_mask & (1u << i)) != 0) {
+			_shards[i].mutex.lock();
+		}
+	}
+}
+
+void SpatialLock3D::unlock_shards(uint32_t shard_mask) {
+	for (unsigned int i = 0; i < SHARD_COUNT; ++i) {
+		if ((shard_mask & (1u << i)) != 0) {
+			_shards[i].mutex.unlock();
+		}
+	}
+}
+
+bool SpatialLock3D::can_lock(const BoxBounds3i &box, Mode mode, uint32_t shard_mask) const {
 #ifdef ZN_SPATIAL_LOCK_3D_CHECKS
 	const Thread::ID thread_id = Thread::get_caller_id();
 #endif
 
-	for (unsigned int i = 0; i < _boxes.size(); ++i) {
-		const Box &existing_box = _boxes[i];
+	for (unsigned int shard_index = 0; shard_index < SHARD_COUNT; ++shard_index) {
+		if ((shard_mask & (1u << shard_index)) == 0) {
+			continue;
+		}
+		const Shard &shard = _shards[shard_index];
+
+		for (const Box &existing_box : shard.boxes) {
+#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
+			// Each thread can lock only one box at a time, otherwise there can be deadlocks depending on the order of
+			// locks. For example:
+			// - Thread 1 locks A
+			// - Thread 2 locks B
+			// - Thread 1 locks B, but blocks because it is already locked
+			// - Thread 2 locks A, but blocks because it is already locked:
+			//   This is a deadlock.
+			// Note: this is not true if threads only lock for reading, but if we didn't ever write we'd not use locks.
+			// Note: this is also not true if threads use `try_lock` instead!
+			// Note: only boxes in the same shards are checked.
+			ZN_ASSERT_RETURN_V_MSG(
+					existing_box.thread_id != thread_id, false, "Locking two areas from the same threads is not allowed"
+			);
+#endif
+			if (existing_box.bounds.intersects(box) && (mode == MODE_WRITE || existing_box.mode == MODE_WRITE)) {
+				return false;
+			}
+		}
+
+		if (mode == MODE_READ) {
+			// Let writers waiting for this area go first, otherwise they could wait forever if readers keep coming
+			for (const Waiter *waiter : shard.waiters) {
+				if (waiter->mode == MODE_WRITE && waiter->bounds.intersects(box)) {
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
 
-		if (existing_box.bounds == box && existing_box.mode == mode
+void SpatialLock3D::add_box(const BoxBounds3i &box, Mode mode, uint32_t shard_mask) {
+	const Box new_box{ box,
+					   mode,
 #ifdef ZN_SPATIAL_LOCK_3D_CHECKS
-				&& existing_box.thread_id == thread_id
+					   Thread::get_caller_id()
 #endif
-		) {
-			_boxes[i] = _boxes[_boxes.size() - 1];
-			_boxes.pop_back();
-			return;
+	};
+	for (unsigned int shard_index = 0; shard_index < SHARD_COUNT; ++shard_index) {
+		if ((shard_mask & (1u << shard_index)) != 0) {
+			_shards[shard_index].boxes.push_back(new_box);
 		}
 	}
-	// Could be a bug
-	ZN_PRINT_ERROR(format("Could not find box to remove {} with mode {}", box, mode));
+	++_box_count;
+}
+
+void SpatialLock3D::remove_box(const BoxBounds3i &box, Mode mode, uint32_t shard_mask) {
+#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
+	const Thread::ID thread_id = Thread::get_caller_id();
+#endif
+
+	bool found = false;
+
+	for (unsigned int shard_index = 0; shard_index < SHARD_COUNT; ++shard_index) {
+		if ((shard_mask & (1u << shard_index)) == 0) {
+			continue;
+		}
+		StdVector<Box> &boxes = _shards[shard_index].boxes;
+
+		for (unsigned int i = 0; i < boxes.size(); ++i) {
+			const Box &existing_box = boxes[i];
+
+			if (existing_box.bounds == box && existing_box.mode == mode
+#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
+					&& existing_box.thread_id == thread_id
+#endif
+			) {
+				boxes[i] = boxes[boxes.size() - 1];
+				boxes.pop_back();
+				found = true;
+				break;
+			}
+		}
+	}
+
+	if (found) {
+		--_box_count;
+	} else {
+		// Could be a bug
+		ZN_PRINT_ERROR(format("Could not find box to remove {} with mode {}", box, mode));
+	}
+}
+
+bool SpatialLock3D::try_lock_no_wait(const BoxBounds3i &box, Mode mode) {
+	if (try_lock(box, mode, get_shard_mask(box), nullptr)) {
+		return true;
+	}
+	++_failed_try_locks;
+	return false;
+}
+
+bool SpatialLock3D::try_lock(const BoxBounds3i &box, Mode mode, uint32_t shard_mask, Waiter *waiter) {
+	lock_shards(shard_mask);
+
+	const bool locked = can_lock(box, mode, shard_mask);
+	if (locked) {
+		add_box(box, mode, shard_mask);
+	}
+
+	if (waiter != nullptr && locked == waiter->registered) {
+		for (unsigned int shard_index = 0; shard_index < SHARD_COUNT; ++shard_index) {
+			if ((shard_mask & (1u << shard_index)) == 0) {
+				continue;
+			}
+			StdVector<Waiter *> &waiters = _shards[shard_index].waiters;
+			if (locked) {
+				for (unsigned int i = 0; i < waiters.size(); ++i) {
+					if (waiters[i] == waiter) {
+						waiters[i] = waiters.back();
+						waiters.pop_back();
+						break;
+					}
+				}
+			} else {
+				waiters.push_back(waiter);
+			}
+		}
+		waiter->registered = !locked;
+	}
+
+	unlock_shards(shard_mask);
+	return locked;
+}
+
+void SpatialLock3D::lock(const BoxBounds3i &box, Mode mode) {
+	const uint32_t shard_mask = get_shard_mask(box);
+
+	if (try_lock(box, mode, shard_mask, nullptr)) {
+		return;
+	}
+
+	++_contended_locks;
+
+	Waiter waiter;
+	waiter.bounds = box;
+	waiter.mode = mode;
+
+	// Registering the waiter and checking boxes happen under the same locks, so an unlock happening right after a
+	// failed attempt will still post the semaphore
+	while (try_lock(box, mode, shard_mask, &waiter) == false) {
+		waiter.semaphore.wait();
+		++_wakeups;
+	}
+}
+
+void SpatialLock3D::unlock(const BoxBounds3i &box, Mode mode) {
+	const uint32_t shard_mask = get_shard_mask(box);
+
+	lock_shards(shard_mask);
+
+	remove_box(box, mode, shard_mask);
+
+	// Wake up threads waiting for overlapping boxes. This is done before unlocking shards, because waiters can only
+	// unregister themselves under those locks, so they can't go out of scope in the meantime.
+	static thread_local StdVector<const Waiter *> tls_notified_waiters;
+	StdVector<const Waiter *> &notified_waiters = tls_notified_waiters;
+	notified_waiters.clear();
+
+	for (unsigned int shard_index = 0; shard_index < SHARD_COUNT; ++shard_index) {
+		if ((shard_mask & (1u << shard_index)) == 0) {
+			continue;
+		}
+		for (const Waiter *waiter : _shards[shard_index].waiters) {
+			if (!waiter->bounds.intersects(box)) {
+				continue;
+			}
+			// The same waiter can be registered in multiple shards
+			bool already_notified = false;
+			for (const Waiter *notified_waiter : notified_waiters) {
+				if (notified_waiter == waiter) {
+					already_notified = true;
+					break;
+				}
+			}
+			if (!already_notified) {
+				waiter->semaphore.post();
+				notified_waiters.push_back(waiter);
+			}
+		}
+	}
+
+	unlock_shards(shard_mask);
+}
+
+SpatialLock3D::Stats SpatialLock3D::get_stats() const {
+	Stats stats;
+	stats.contended_locks = _contended_locks;
+	stats.wakeups = _wakeups;
+	stats.failed_try_locks = _failed_try_locks;
+	return stats;
+}
+
+void SpatialLock3D::reset_stats() {
+	_contended_locks = 0;
+	_wakeups = 0;
+	_failed_try_locks = 0;
 }
 
 } // namespace zylann
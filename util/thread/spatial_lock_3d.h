@@ -1,12 +1,14 @@
 #ifndef ZN_SPATIAL_LOCK_3D_H
 #define ZN_SPATIAL_LOCK_3D_H
 
+#include "../containers/fixed_array.h"
 #include "../containers/std_vector.h"
 #include "../math/box_bounds_3i.h"
 #include "mutex.h"
 #include "semaphore.h"
 #include "short_lock.h"
 #include "thread.h"
+#include <atomic>
 
 #ifdef TOOLS_ENABLED
 #define ZN_SPATIAL_LOCK_3D_CHECKS
@@ -24,6 +26,11 @@ namespace zylann {
 //
 // Do not try to lock more than one box at the same time before doing your task. If another thread does so,
 // it could end up in a deadlock depending in the order it happens.
+//
+// Internally, space is divided in coarse cells hashed into a fixed number of shards, each having its own list of boxes
+// and its own short lock, so threads locking distant areas don't contend with each other. Threads waiting for a box
+// are only woken up when a box overlapping theirs gets unlocked. Readers don't lock areas a writer is waiting for, so
+// writers don't get starved by a continuous flow of readers.
 class SpatialLock3D {
 public:
 	enum Mode { //
@@ -39,58 +46,40 @@ public:
 #endif
 	};
 
+	struct Stats {
+		// Blocking locks that could not lock immediately and had to wait
+		uint32_t contended_locks;
+		// Times waiting threads were woken up to retry locking
+		uint32_t wakeups;
+		// `try_*` calls that failed
+		uint32_t failed_try_locks;
+	};
+
 	SpatialLock3D();
 
 	~SpatialLock3D() {
-		ZN_ASSERT_RETURN(_boxes.size() == 0);
+		ZN_ASSERT_RETURN(_box_count == 0);
 	}
 
-	bool try_lock_read(const BoxBounds3i &box) {
-		_boxes_mutex.lock();
-		if (can_lock_for_read(box)) {
-			_boxes.push_back(Box{ box, MODE_READ,
-#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
-					Thread::get_caller_id()
-#endif
-			});
-			_boxes_mutex.unlock();
-			return true;
-		} else {
-			_boxes_mutex.unlock();
-			return false;
-		}
+	// Note: for fairness, locking for read fails if a writer is waiting for an overlapping box.
+	inline bool try_lock_read(const BoxBounds3i &box) {
+		return try_lock_no_wait(box, MODE_READ);
 	}
 
-	void lock_read(const BoxBounds3i &box) {
-		while (try_lock_read(box) == false) {
-			_semaphore.wait();
-		}
+	inline void lock_read(const BoxBounds3i &box) {
+		lock(box, MODE_READ);
 	}
 
 	inline void unlock_read(const BoxBounds3i &box) {
 		unlock(box, MODE_READ);
 	}
 
-	bool try_lock_write(const BoxBounds3i &box) {
-		_boxes_mutex.lock();
-		if (can_lock_for_write(box)) {
-			_boxes.push_back(Box{ box, MODE_WRITE,
-#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
-					Thread::get_caller_id()
-#endif
-			});
-			_boxes_mutex.unlock();
-			return true;
-		} else {
-			_boxes_mutex.unlock();
-			return false;
-		}
+	inline bool try_lock_write(const BoxBounds3i &box) {
+		return try_lock_no_wait(box, MODE_WRITE);
 	}
 
-	void lock_write(const BoxBounds3i &box) {
-		while (try_lock_write(box) == false) {
-			_semaphore.wait();
-		}
+	inline void lock_write(const BoxBounds3i &box) {
+		lock(box, MODE_WRITE);
 	}
 
 	inline void unlock_write(const BoxBounds3i &box) {
@@ -98,10 +87,12 @@ public:
 	}
 
 	inline int get_locked_boxes_count() const {
-		ShortLockScope rlock(_boxes_mutex);
-		return _boxes.size();
+		return _box_count;
 	}
 
+	Stats get_stats() const;
+	void reset_stats();
+
 	// Scoped helpers
 
 	struct Read {
@@ -127,75 +118,54 @@ public:
 	};
 
 private:
-	bool can_lock_for_read(const BoxBounds3i &box) {
-#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
-		const Thread::ID thread_id = Thread::get_caller_id();
-#endif
+	// A thread blocked in `lock_*`. Lives on the stack of that thread while it waits.
+	struct Waiter {
+		BoxBounds3i bounds;
+		Mode mode;
+		// Posted when a box overlapping `bounds` gets unlocked
+		Semaphore semaphore;
+		bool registered = false;
+	};
 
-		for (unsigned int i = 0; i < _boxes.size(); ++i) {
-			const Box &existing_box = _boxes[i];
-#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
-			// Each thread can lock only one box at a time, otherwise there can be deadlocks depending on the order of
-			// locks. For example:
-			// - Thread 1 locks A
-			// - Thread 2 locks B
-			// - Thread 1 locks B, but blocks because it is already locked
-			// - Thread 2 locks A, but blocks because it is already locked:
-			//   This is a deadlock.
-			// Note: this is not true if threads only lock for reading, but if we didn't ever write we'd not use locks.
-			// Note: this is also not true if threads use `try_lock` instead!
-			ZN_ASSERT_RETURN_V_MSG(existing_box.thread_id != thread_id, false,
-					"Locking two areas from the same threads is not allowed");
-#endif
-			if (existing_box.bounds.intersects(box) && existing_box.mode == MODE_WRITE) {
-				return false;
-				break;
-			}
-		}
-		return true;
-	}
+	struct Shard {
+		// Boxes overlapping cells of this shard. A box spanning multiple shards is stored in each of them.
+		StdVector<Box> boxes;
+		StdVector<Waiter *> waiters;
+		// This lock is supposed to be held for very small periods of time, just to lookup, add or remove boxes.
+		// So we lock it even in `try_*` methods. The long-period locking states are the boxes themselves.
+		// Also it is not recursive for performance. Do not lock it again once you successfully locked it.
+		ShortLock mutex;
+	};
 
-	bool can_lock_for_write(const BoxBounds3i &box) {
-#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
-		const Thread::ID thread_id = Thread::get_caller_id();
-#endif
+	// Cells are in the same units as boxes. Locked boxes are usually a few blocks wide.
+	static const unsigned int CELL_SIZE_PO2 = 2;
+	static const unsigned int SHARD_COUNT = 16;
+	static_assert(SHARD_COUNT <= 32, "Shard masks are stored in 32-bit integers");
 
-		for (unsigned int i = 0; i < _boxes.size(); ++i) {
-			const Box &existing_box = _boxes[i];
+	bool try_lock_no_wait(const BoxBounds3i &box, Mode mode);
+	// If locking fails and a waiter is provided, it gets registered so it is notified when overlapping boxes get
+	// unlocked. It gets unregistered when locking succeeds.
+	bool try_lock(const BoxBounds3i &box, Mode mode, uint32_t shard_mask, Waiter *waiter);
+	void lock(const BoxBounds3i &box, Mode mode);
+	void unlock(const BoxBounds3i &box, Mode mode);
 
-#ifdef ZN_SPATIAL_LOCK_3D_CHECKS
-			ZN_ASSERT_RETURN_V_MSG(existing_box.thread_id != thread_id, false,
-					"Locking two areas from the same threads is not allowed");
-#endif
-			if (existing_box.bounds.intersects(box)) {
-				return false;
-				break;
-			}
-		}
-		return true;
-	}
+	// Shards are locked in ascending order, so threads locking the same shards can't deadlock
+	void lock_shards(uint32_t shard_mask);
+	void unlock_shards(uint32_t shard_mask);
 
-	void remove_box(const BoxBounds3i &box, Mode mode);
+	// Must be called with shards of the mask locked
+	bool can_lock(const BoxBounds3i &box, Mode mode, uint32_t shard_mask) const;
+	void add_box(const BoxBounds3i &box, Mode mode, uint32_t shard_mask);
+	void remove_box(const BoxBounds3i &box, Mode mode, uint32_t shard_mask);
 
-	void unlock(const BoxBounds3i &box, Mode mode) {
-		_boxes_mutex.lock();
-		remove_box(box, mode);
-		_boxes_mutex.unlock();
-		// Tell eventual waiting threads that they might be able to lock their box now.
-		_semaphore.post();
-	}
+	static uint32_t get_shard_mask(const BoxBounds3i &box);
+
+	FixedArray<Shard, SHARD_COUNT> _shards;
+	std::atomic_int _box_count = { 0 };
 
-	// List of boxes currently locked.
-	// In practice, each thread can lock up to 1 box at once (maybe a few more in rare cases that would allow it), so
-	// there won't be many boxes to store.
-	StdVector<Box> _boxes;
-	// This mutex is supposed to be locked for very small periods of time, just to lookup, add or remove boxes.
-	// So we lock it even in `try_*` methods. The long-period locking states are the boxes themselves.
-	// Also it is not a recursive mutex for performance. Do not lock it again once you successfully locked it.
-	mutable ShortLock _boxes_mutex;
-	// This semaphore is waited for when a lock fails. It is posted everytime a box is unlocked, so any thread
-	// waiting for it may retry locking their box.
-	Semaphore _semaphore;
+	std::atomic_uint32_t _contended_locks = { 0 };
+	std::atomic_uint32_t _wakeups = { 0 };
+	std::atomic_uint32_t _failed_try_locks = { 0 };
 };
 
 } // namespace zylann